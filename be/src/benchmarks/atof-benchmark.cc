@@ -14,6 +14,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <sstream>
@@ -64,13 +65,14 @@ void AddTestData(TestData* data, const string& input) {
   data->data.push_back(StringValue(const_cast<char*>(str.c_str()), str.length()));
 }
 
-void AddTestData(TestData* data, int n, double min = -10, double max = 10) {
+void AddTestData(TestData* data, int n, double min = -10, double max = 10,
+                 int precision = 6) {
   for (int i = 0; i < n; ++i) {
     double val = rand();
     val /= RAND_MAX;
     val = (val * (max - min)) + min;
     stringstream ss;
-    ss << val;
+    ss << setprecision(precision) << val;
     AddTestData(data, ss.str());
   }
 }
@@ -121,10 +123,18 @@ int main(int argc, char **argv) {
 
   data.result.resize(data.data.size());
 
+  // Values with many digits, e.g. written out at full double precision. These take the
+  // path that converts 8 digits at a time.
+  TestData data_long;
+  AddTestData(&data_long, 1000, -5, 100000, 17);
+  data_long.result.resize(data_long.data.size());
+
   Benchmark suite("atof");
   suite.AddBenchmark("Strtod", TestStrtod, &data);
   suite.AddBenchmark("Atof", TestAtof, &data);
   suite.AddBenchmark("Impala", TestImpala, &data);
+  suite.AddBenchmark("Strtod_long", TestStrtod, &data_long);
+  suite.AddBenchmark("Impala_long", TestImpala, &data_long);
   cout << suite.Measure();
 
   return 0;
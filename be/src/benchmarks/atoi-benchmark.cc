@@ -74,7 +74,7 @@ void AddTestData(TestData* data, int n, int32_t min = -10, int32_t max = 10,
     val = static_cast<int32_t>((val * (max - min)) + min);
     stringstream ss;
     if (leading_space) ss << "   ";
-    ss << val;
+    ss << static_cast<int32_t>(val);
     if (trailing_space) ss << "   ";
     AddTestData(data, ss.str());
   }
@@ -259,6 +259,12 @@ int main(int argc, char **argv) {
   AddTestData(&data_both_space, 1000, -5, 1000, true, true);
   data_both_space.result.resize(data_trailing_space.data.size());
 
+  // Large values, most with 9 digits. These take the path that converts 8 digits at a
+  // time.
+  TestData data_long;
+  AddTestData(&data_long, 1000, 0, 999999999);
+  data_long.result.resize(data_long.data.size());
+
   TestData data_garbage;
   for (int i = 0; i < 1000; ++i) {
     AddTestData(&data_garbage, "sdfsfdsfasd");
@@ -282,6 +288,8 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("impala_leading_space", TestImpala, &data_leading_space);
   suite.AddBenchmark("impala_trailing_space", TestImpala, &data_trailing_space);
   suite.AddBenchmark("impala_both_space", TestImpala, &data_both_space);
+  suite.AddBenchmark("strtol_long", TestStrtol, &data_long);
+  suite.AddBenchmark("impala_long", TestImpala, &data_long);
   suite.AddBenchmark("impala_garbage", TestImpala, &data_garbage);
   suite.AddBenchmark("impala_trailing_garbage", TestImpala, &data_trailing_garbage);
 
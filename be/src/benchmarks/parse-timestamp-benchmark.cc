@@ -18,6 +18,7 @@
 #include <vector>
 #include <sstream>
 #include "runtime/string-value.h"
+#include "runtime/timestamp-parse-util.h"
 #include "runtime/timestamp-value.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
@@ -94,6 +95,18 @@ void AddTestDataTimes(TestData* data, int n, const string& startstr) {
   }
 }
 
+void AddTestDataDateTimes(TestData* data, int n, const string& startstr) {
+  posix_time::ptime start(posix_time::time_from_string(startstr));
+  for (int i = 0; i < n; ++i) {
+    int val = rand();
+    start += seconds(val % 100000) + nanoseconds(val);
+    stringstream ss;
+    ss << to_iso_extended_string(start.date()) << " "
+       << to_simple_string(start.time_of_day());
+    AddTestData(data, ss.str());
+  }
+}
+
 void TestImpalaDate(int batch_size, void* d) {
   TestData* data = reinterpret_cast<TestData*>(d);
   for (int i = 0; i < batch_size; ++i) {
@@ -104,6 +117,20 @@ void TestImpalaDate(int batch_size, void* d) {
   }
 }
 
+// Parses with an explicit format, i.e. without the fast path for the default format.
+void TestImpalaDateTimeFormat(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  const char* fmt = "yyyy-MM-dd HH:mm:ss.SSSSSSSSS";
+  DateTimeFormatContext dt_ctx(fmt, strlen(fmt));
+  TimestampParser::ParseFormatTokens(&dt_ctx);
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      data->result[j] = TimestampValue(data->data[j].ptr, data->data[j].len, dt_ctx);
+    }
+  }
+}
+
 void TestBoostStringDate(int batch_size, void* d) {
   TestData* data = reinterpret_cast<TestData*>(d);
   for (int i = 0; i < batch_size; ++i) {
@@ -139,15 +166,18 @@ void TestBoostTime(int batch_size, void* d) {
 
 int main(int argc, char **argv) {
   CpuInfo::Init();
+  TimestampParser::Init();
   cout << Benchmark::GetMachineInfo() << endl;
 
-  TestData dates, times;
+  TestData dates, times, date_times;
 
   AddTestDataDates(&dates, 1000, "1953-04-22");
   AddTestDataTimes(&times, 1000, "01:02:03.45678");
+  AddTestDataDateTimes(&date_times, 1000, "1953-04-22 01:02:03.45678");
 
   dates.result.resize(dates.data.size());
   times.result.resize(times.data.size());
+  date_times.result.resize(date_times.data.size());
 
   Benchmark date_suite("ParseDate");
   date_suite.AddBenchmark("BoostStringDate", TestBoostStringDate, &dates);
@@ -158,9 +188,15 @@ int main(int argc, char **argv) {
   timestamp_suite.AddBenchmark("BoostTime", TestBoostTime, &times);
   timestamp_suite.AddBenchmark("Impala", TestImpalaDate, &times);
   
+  Benchmark date_time_suite("ParseDateTime");
+  date_time_suite.AddBenchmark("ImpalaFormat", TestImpalaDateTimeFormat, &date_times);
+  date_time_suite.AddBenchmark("Impala", TestImpalaDate, &date_times);
+
   cout << date_suite.Measure();
   cout << endl;
   cout << timestamp_suite.Measure();
+  cout << endl;
+  cout << date_time_suite.Measure();
 
   return 0;
 }
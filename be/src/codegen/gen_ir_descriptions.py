@@ -44,6 +44,8 @@ ir_functions = [
   ["READ_AVRO_DOUBLE", "ReadAvroDouble"],
   ["READ_AVRO_STRING", "ReadAvroString"],
   ["HDFS_SCANNER_WRITE_ALIGNED_TUPLES", "WriteAlignedTuples"],
+  ["HDFS_SCANNER_COPY_STRING_SLOT", "CopyStringSlot"],
+  ["HDFS_SCANNER_GET_CONJUNCTS_STATE_DATA", "GetConjunctsStateData"],
   ["STRING_VALUE_EQ", "StringValueEQ"],
   ["STRING_VALUE_NE", "StringValueNE"],
   ["STRING_VALUE_GE", "StringValueGE"],
@@ -57,6 +59,7 @@ ir_functions = [
   ["STRING_TO_INT64", "IrStringToInt64"],
   ["STRING_TO_FLOAT", "IrStringToFloat"],
   ["STRING_TO_DOUBLE", "IrStringToDouble"],  
+  ["STRING_TO_TIMESTAMP", "IrStringToTimestamp"],
   ["IS_NULL_STRING", "IrIsNullString"],
   ["GENERIC_IS_NULL_STRING", "IrGenericIsNullString"],
 ]
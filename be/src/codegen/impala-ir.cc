@@ -22,6 +22,7 @@
 #include "exec/hash-join-node-ir.cc"
 #include "exec/hdfs-avro-scanner-ir.cc"
 #include "exec/hdfs-scanner-ir.cc"
+#include "exprs/aggregate-functions.cc"
 #include "exprs/expr-ir.cc"
 #include "exprs/udf-builtins.cc"
 #include "runtime/string-value-ir.cc"
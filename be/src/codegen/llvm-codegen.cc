@@ -38,6 +38,7 @@
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 
+#include "common/atomic.h"
 #include "common/logging.h"
 #include "codegen/subexpr-elimination.h"
 #include "impala-ir/impala-ir-names.h"
@@ -86,6 +87,8 @@ LlvmCodeGen::LlvmCodeGen(ObjectPool* pool, const string& name) :
   optimizations_enabled_(false),
   is_corrupt_(false),
   is_compiled_(false),
+  is_optimized_(false),
+  has_required_jit_fns_(false),
   context_(new llvm::LLVMContext()),
   module_(NULL),
   execution_engine_(NULL),
@@ -551,7 +554,10 @@ Status LlvmCodeGen::OptimizeModule() {
   if (is_corrupt_) return Status("Module is corrupt.");
   SCOPED_TIMER(profile_.total_time_counter());
   SCOPED_TIMER(compile_timer_);
-  if (!optimizations_enabled_) return Status::OK;
+  if (!optimizations_enabled_) {
+    is_optimized_ = true;
+    return Status::OK;
+  }
 
   // This pass manager will construct optimizations passes that are "typical" for
   // c/c++ programs.  We're relying on llvm to pick the best passes for us.
@@ -592,11 +598,16 @@ Status LlvmCodeGen::OptimizeModule() {
     *fns_to_jit_compile_[i].second = JitFunction(fns_to_jit_compile_[i].first);
   }
 
+  // If the fragment is already executing, the nodes read the function pointers once
+  // is_optimized() returns true: publish them, and the jitted code, before the flag.
+  AtomicUtil::MemoryBarrier();
+  is_optimized_ = true;
   return Status::OK;
 }
 
-void LlvmCodeGen::AddFunctionToJit(Function* fn, void** result) {
+void LlvmCodeGen::AddFunctionToJit(Function* fn, void** result, bool has_fallback) {
   fns_to_jit_compile_.push_back(make_pair(fn, result));
+  if (!has_fallback) has_required_jit_fns_ = true;
 }
 
 void* LlvmCodeGen::JitFunction(Function* function, int* scratch_size) {
@@ -16,6 +16,7 @@
 #ifndef IMPALA_CODEGEN_LLVM_CODEGEN_H
 #define IMPALA_CODEGEN_LLVM_CODEGEN_H
 
+#include "common/atomic.h"
 #include "common/status.h"
 
 #include <map>
@@ -92,6 +93,10 @@ class SubExprElimination;
 // Subsequently, nodes can get at the jit compiled function pointer (typically during the
 // Open() call).  Getting the jit compiled function (JitFunction()) is the only thread
 // safe function.
+// If all the functions added with AddFunctionToJit() have an interpreted fallback,
+// OptimizeModule() may also run on a separate thread while the fragment is already
+// executing (see CanOptimizeAsync()).  Nodes then pick up the jit compiled functions
+// once they are ready.
 //
 // Currently, each query will create and initialize one of these
 // objects.  This requires loading and parsing the cross compiled modules.
@@ -233,6 +238,19 @@ class LlvmCodeGen {
   // functions.
   Status OptimizeModule();
 
+  // Returns true if OptimizeModule() may run concurrently with the execution of the
+  // fragment, i.e. if all functions added with AddFunctionToJit() have a fallback.
+  bool CanOptimizeAsync() const { return !has_required_jit_fns_; }
+
+  // Returns true once OptimizeModule() has finished and JitFunction() may be called.
+  // Thread safe. Once this returns true, the function pointers set by OptimizeModule()
+  // are visible to the calling thread.
+  bool is_optimized() const {
+    bool optimized = is_optimized_;
+    AtomicUtil::MemoryBarrier();
+    return optimized;
+  }
+
   // Replaces all instructions that call 'target_name' with a call instruction
   // to the new_fn.  Returns the modified function.
   // - target_name is the unmangled function name that should be replaced.
@@ -296,7 +314,11 @@ class LlvmCodeGen {
   // part of the query has finished adding their IR and it's convenient to
   // not have to rewalk the objects. This provides the same behavior as walking
   // each of those objects and calling JitFunction().
-  void AddFunctionToJit(llvm::Function* fn, void** result_fn_ptr);
+  // If 'has_fallback' is true, the caller checks is_optimized() before every use (e.g.
+  // once per row batch), uses an interpreted path until it returns true and only then
+  // reads *result_fn_ptr, which may be set after the fragment has started executing.
+  void AddFunctionToJit(llvm::Function* fn, void** result_fn_ptr,
+      bool has_fallback = false);
 
   // Verfies the function if the verfier is enabled.  Returns false if function
   // is invalid.
@@ -445,6 +467,12 @@ class LlvmCodeGen {
   // functions after this point.
   bool is_compiled_;
 
+  // Set once OptimizeModule() is done.  Read by other threads, see is_optimized().
+  volatile bool is_optimized_;
+
+  // True if a function without fallback was added with AddFunctionToJit().
+  bool has_required_jit_fns_;
+
   // Error string that llvm will write to
   std::string error_string_;
 
@@ -23,6 +23,7 @@
 
 #include "codegen/llvm-codegen.h"
 #include "exec/hash-table.inline.h"
+#include "exec/row-batch-prefetcher.h"
 #include "exprs/agg-fn-evaluator.h"
 #include "exprs/expr.h"
 #include "runtime/descriptors.h"
@@ -59,9 +60,11 @@ AggregationNode::AggregationNode(ObjectPool* pool, const TPlanNode& tnode,
     process_row_batch_fn_(NULL),
     is_merge_(tnode.agg_node.__isset.is_merge ? tnode.agg_node.is_merge : false),
     needs_finalize_(tnode.agg_node.need_finalize),
+    has_batch_update_(false),
     build_timer_(NULL),
     get_results_timer_(NULL),
-    hash_table_buckets_counter_(NULL) {
+    hash_table_buckets_counter_(NULL),
+    codegen_row_batches_counter_(NULL) {
 }
 
 Status AggregationNode::Init(const TPlanNode& tnode) {
@@ -87,6 +90,8 @@ Status AggregationNode::Prepare(RuntimeState* state) {
       ADD_COUNTER(runtime_profile(), "BuildBuckets", TCounterType::UNIT);
   hash_table_load_factor_counter_ =
       ADD_COUNTER(runtime_profile(), "LoadFactor", TCounterType::DOUBLE_VALUE);
+  codegen_row_batches_counter_ =
+      ADD_COUNTER(runtime_profile(), "CodegenRowBatches", TCounterType::UNIT);
 
   SCOPED_TIMER(runtime_profile_->total_time_counter());
 
@@ -114,7 +119,12 @@ Status AggregationNode::Prepare(RuntimeState* state) {
     SlotDescriptor* desc = agg_tuple_desc_->slots()[j];
     RETURN_IF_ERROR(aggregate_evaluators_[i]->Prepare(state, child(0)->row_desc(),
         tuple_pool_.get(), desc));
+    if (probe_exprs_.empty() && !is_merge_ &&
+        aggregate_evaluators_[i]->has_update_batch()) {
+      has_batch_update_ = true;
+    }
   }
+  if (has_batch_update_) AddRuntimeExecOption("Batch Update Enabled");
 
   // TODO: how many buckets?
   hash_tbl_.reset(new HashTable(state, build_exprs_, probe_exprs_, 1, true, true,
@@ -126,17 +136,20 @@ Status AggregationNode::Prepare(RuntimeState* state) {
     singleton_output_tuple_ = ConstructAggTuple();
   }
 
-  if (state->codegen_enabled()) {
+  // The codegen'd ProcessRowBatch() updates the aggregates one row at a time, so it
+  // would bypass the batch update functions.
+  if (state->codegen_enabled() && !has_batch_update_) {
     DCHECK(state->codegen() != NULL);
     Function* update_tuple_fn = CodegenUpdateAggTuple(state->codegen());
     if (update_tuple_fn != NULL) {
       codegen_process_row_batch_fn_ =
           CodegenProcessRowBatch(state->codegen(), update_tuple_fn);
       if (codegen_process_row_batch_fn_ != NULL) {
-        // Update to using codegen'd process row batch.
+        // Update to using codegen'd process row batch.  GetNext() keeps using the
+        // interpreted path until the function is jitted.
         state->codegen()->AddFunctionToJit(
             codegen_process_row_batch_fn_,
-            reinterpret_cast<void**>(&process_row_batch_fn_));
+            reinterpret_cast<void**>(&process_row_batch_fn_), true);
         AddRuntimeExecOption("Codegen Enabled");
       }
     }
@@ -151,13 +164,16 @@ Status AggregationNode::Open(RuntimeState* state) {
   RETURN_IF_ERROR(children_[0]->Open(state));
 
   RowBatch batch(children_[0]->row_desc(), state->batch_size(), mem_tracker());
+  // Stopped by its destructor if we return early.
+  RowBatchPrefetcher prefetcher(children_[0], children_[0]->row_desc(), mem_tracker());
+  if (prefetcher.Start(state)) AddRuntimeExecOption("Child Pipelined");
   int64_t num_input_rows = 0;
   int64_t num_agg_rows = 0;
   while (true) {
     bool eos;
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(state->CheckQueryState());
-    RETURN_IF_ERROR(children_[0]->GetNext(state, &batch, &eos));
+    RETURN_IF_ERROR(prefetcher.GetNext(state, &batch, &eos));
     SCOPED_TIMER(build_timer_);
 
     // Start
@@ -172,10 +188,28 @@ Status AggregationNode::Open(RuntimeState* state) {
       }
     }
     int64_t agg_rows_before = hash_tbl_->size();
-    if (process_row_batch_fn_ != NULL) {
-      process_row_batch_fn_(this, &batch);
+    // Lets grouping and aggregate input exprs that call out to Hive UDFs evaluate the
+    // whole batch at once.
+    Expr::EvaluateBatch(probe_exprs_, &batch, 0, batch.num_rows());
+    for (int i = 0; i < aggregate_evaluators_.size(); ++i) {
+      Expr::EvaluateBatch(aggregate_evaluators_[i]->input_exprs(), &batch, 0,
+          batch.num_rows());
+    }
+    // The function may still be jitted in the background: only read the pointer once
+    // the module is optimized, see LlvmCodeGen::AddFunctionToJit().
+    ProcessRowBatchFn process_row_batch_fn = NULL;
+    if (codegen_process_row_batch_fn_ != NULL && state->codegen()->is_optimized()) {
+      process_row_batch_fn = process_row_batch_fn_;
+    }
+    if (process_row_batch_fn != NULL) {
+      process_row_batch_fn(this, &batch);
+      COUNTER_UPDATE(codegen_row_batches_counter_, 1);
     } else if (singleton_output_tuple_ != NULL) {
-      ProcessRowBatchNoGrouping(&batch);
+      if (has_batch_update_) {
+        ProcessRowBatchNoGroupingBatched(&batch);
+      } else {
+        ProcessRowBatchNoGrouping(&batch);
+      }
     } else {
       ProcessRowBatchWithGrouping(&batch);
     }
@@ -184,6 +218,10 @@ Status AggregationNode::Open(RuntimeState* state) {
     num_agg_rows += (hash_tbl_->size() - agg_rows_before);
     num_input_rows += batch.num_rows();
 
+    Expr::ClearBatch(probe_exprs_);
+    for (int i = 0; i < aggregate_evaluators_.size(); ++i) {
+      Expr::ClearBatch(aggregate_evaluators_[i]->input_exprs());
+    }
     batch.Reset();
     RETURN_IF_ERROR(state->CheckQueryState());
     if (eos) break;
@@ -191,6 +229,7 @@ Status AggregationNode::Open(RuntimeState* state) {
 
   // We have consumed all of the input from the child and transfered ownership of the
   // resources we need, so the child can be closed safely to release its resources.
+  prefetcher.Close();
   child(0)->Close(state);
   if (singleton_output_tuple_ != NULL) {
     hash_tbl_->Insert(reinterpret_cast<TupleRow*>(&singleton_output_tuple_));
@@ -304,6 +343,21 @@ void AggregationNode::UpdateAggTuple(Tuple* tuple, TupleRow* row) {
   }
 }
 
+void AggregationNode::ProcessRowBatchNoGroupingBatched(RowBatch* batch) {
+  DCHECK(singleton_output_tuple_ != NULL);
+  DCHECK(!is_merge_);
+  for (int i = 0; i < aggregate_evaluators_.size(); ++i) {
+    AggFnEvaluator* evaluator = aggregate_evaluators_[i];
+    if (evaluator->has_update_batch()) {
+      evaluator->UpdateBatch(batch, 0, batch->num_rows(), singleton_output_tuple_);
+    } else {
+      for (int j = 0; j < batch->num_rows(); ++j) {
+        evaluator->Update(batch->GetRow(j), singleton_output_tuple_);
+      }
+    }
+  }
+}
+
 void AggregationNode::FinalizeAggTuple(Tuple* tuple) {
   DCHECK(tuple != NULL);
   for (vector<AggFnEvaluator*>::const_iterator evaluator = aggregate_evaluators_.begin();
@@ -326,6 +380,23 @@ void AggregationNode::DebugString(int indentation_level, stringstream* out) cons
   *out << ")";
 }
 
+bool AggregationNode::IsHandCodegenedAgg(
+    AggFnEvaluator* evaluator, SlotDescriptor* slot_desc) {
+  if (!evaluator->is_builtin()) return false;
+  if (slot_desc->type() == TYPE_STRING || slot_desc->type() == TYPE_TIMESTAMP) {
+    return false;
+  }
+  switch (evaluator->agg_op()) {
+    case TAggregationOp::COUNT:
+    case TAggregationOp::MIN:
+    case TAggregationOp::MAX:
+    case TAggregationOp::SUM:
+      return true;
+    default:
+      return false;
+  }
+}
+
 // IR Generation for updating a single aggregation slot. Signature is:
 // void UpdateSlot(AggTuple* agg_tuple, char** row)
 // The IR for sum(double_col) is:
@@ -355,6 +426,21 @@ llvm::Function* AggregationNode::CodegenUpdateSlot(
   LLVMContext& context = codegen->context();
 
   StructType* tuple_struct = agg_tuple_desc_->GenerateLlvmStruct(codegen);
+
+  if (!IsHandCodegenedAgg(evaluator, slot_desc)) {
+    // Let the evaluator generate the call to the aggregate function.
+    Function* update_slot_fn;
+    Status status = is_merge_ ?
+        evaluator->GetIrMergeFn(codegen, tuple_struct, &update_slot_fn) :
+        evaluator->GetIrUpdateFn(codegen, tuple_struct, &update_slot_fn);
+    if (!status.ok()) {
+      string error_msg;
+      status.GetErrorMsg(&error_msg);
+      VLOG_QUERY << "Could not codegen UpdateSlot: " << error_msg;
+      return NULL;
+    }
+    return update_slot_fn;
+  }
   PointerType* tuple_ptr = PointerType::get(tuple_struct, 0);
   PointerType* ptr_type = codegen->ptr_type();
 
@@ -478,29 +564,20 @@ Function* AggregationNode::CodegenUpdateAggTuple(LlvmCodeGen* codegen) {
     SlotDescriptor* slot_desc = agg_tuple_desc_->slots()[j];
     AggFnEvaluator* evaluator = aggregate_evaluators_[i];
 
-    // string and timestamp aggregation currently not supported
-    if (slot_desc->type() == TYPE_STRING || slot_desc->type() == TYPE_TIMESTAMP ||
-        slot_desc->type() == TYPE_CHAR) {
+    // char aggregation currently not supported
+    if (slot_desc->type() == TYPE_CHAR) {
       VLOG_QUERY << "Could not codegen UpdateAggTuple because "
-                 << "string, char and timestamp aggregation is not yet supported.";
+                 << "char aggregation is not yet supported.";
       return NULL;
     }
 
     // If the evaluator can't be generated, bail generating this function
-    if (!evaluator->is_count_star() &&
-        evaluator->input_exprs()[0]->codegen_fn() == NULL) {
-      VLOG_QUERY << "Could not codegen UpdateAggTuple because the "
-                 << "underlying exprs cannot be codegened.";
-      return NULL;
-    }
-
-    // Don't codegen things that aren't builtins (for now)
-    if (!evaluator->is_builtin()) return NULL;
-
-    // Don't code gen distinct estimate
-    if (evaluator->agg_op() == TAggregationOp::DISTINCT_PC
-        || evaluator->agg_op() == TAggregationOp::DISTINCT_PCSA) {
-      return NULL;
+    for (int k = 0; k < evaluator->input_exprs().size(); ++k) {
+      if (evaluator->input_exprs()[k]->codegen_fn() == NULL) {
+        VLOG_QUERY << "Could not codegen UpdateAggTuple because the "
+                   << "underlying exprs cannot be codegened.";
+        return NULL;
+      }
     }
   }
 
@@ -45,9 +45,9 @@ class SlotDescriptor;
 // contain slots for all grouping and aggregation exprs (the grouping
 // slots precede the aggregation expr slots in the output tuple descriptor).
 //
-// TODO: for codegen, instead of hand written agg expr implementations, this class
-// should simply get it from the agg-expr, which in turn just returns a cross compiled
-// implementation.
+// TODO: for codegen, the builtin count, min, max and sum are still hand written. This
+// class should simply get them from the AggFnEvaluator, which returns the cross
+// compiled implementation for the other aggregate functions.
 class AggregationNode : public ExecNode {
  public:
   AggregationNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
@@ -83,7 +83,8 @@ class AggregationNode : public ExecNode {
   llvm::Function* codegen_process_row_batch_fn_;
 
   typedef void (*ProcessRowBatchFn)(AggregationNode*, RowBatch*);
-  // Jitted ProcessRowBatch function pointer.  Null if codegen is disabled.
+  // Jitted ProcessRowBatch function pointer.  Null if codegen is disabled.  Set by the
+  // thread that optimizes the module, only valid once codegen()->is_optimized().
   ProcessRowBatchFn process_row_batch_fn_;
 
   // If true, this aggregation node should use the aggregate evaluator's Merge()
@@ -96,6 +97,11 @@ class AggregationNode : public ExecNode {
   // a finalize step.
   bool needs_finalize_;
 
+  // True if this node aggregates without grouping and without merging, and one of
+  // its UDAs has a batch update function. ProcessRowBatchNoGroupingBatched() is used
+  // instead of ProcessRowBatchNoGrouping() then.
+  bool has_batch_update_;
+
   // Time spent processing the child rows
   RuntimeProfile::Counter* build_timer_;
   // Time spent returning the aggregated rows
@@ -104,6 +110,8 @@ class AggregationNode : public ExecNode {
   RuntimeProfile::Counter* hash_table_buckets_counter_;
   // Load factor in hash table
   RuntimeProfile::Counter* hash_table_load_factor_counter_;
+  // Number of child row batches processed by the jitted ProcessRowBatch()
+  RuntimeProfile::Counter* codegen_row_batches_counter_;
 
   // Constructs a new aggregation output tuple (allocated from tuple_pool_),
   // initialized to grouping values computed over 'current_row_'.
@@ -122,6 +130,10 @@ class AggregationNode : public ExecNode {
   void ProcessRowBatchNoGrouping(RowBatch* batch);
   void ProcessRowBatchWithGrouping(RowBatch* batch);
 
+  // Same as ProcessRowBatchNoGrouping(), but updates each aggregate over the whole
+  // batch at once and passes the batch to UDAs with a batch update function.
+  void ProcessRowBatchNoGroupingBatched(RowBatch* batch);
+
   // Codegen the process row batch loop.  The loop has already been compiled to
   // IR and loaded into the codegen object.  UpdateAggTuple has also been
   // codegen'd to IR.  This function will modify the loop subsituting the
@@ -129,8 +141,14 @@ class AggregationNode : public ExecNode {
   llvm::Function* CodegenProcessRowBatch(
       LlvmCodeGen* codegen, llvm::Function* update_tuple_fn);
 
+  // Returns true if the IR for 'evaluator' is generated directly by
+  // CodegenUpdateSlot(), rather than by calling into the aggregate function.
+  bool IsHandCodegenedAgg(AggFnEvaluator* evaluator, SlotDescriptor* slot_desc);
+
   // Codegen for updating aggregate_exprs at slot_idx. Returns NULL if unsuccessful.
   // slot_idx is the idx into aggregate_exprs_ (does not include grouping exprs).
+  // Aggregate functions other than the builtin count, min, max and sum of numeric
+  // types are codegen'd by the AggFnEvaluator.
   llvm::Function* CodegenUpdateSlot(
       LlvmCodeGen* codegen, AggFnEvaluator* evaluator, SlotDescriptor* slot_desc);
 
@@ -87,7 +87,6 @@ void BaseSequenceScanner::Close() {
   if (!only_parsing_header_) {
     scan_node_->RangeComplete(file_format(), header_->compression_type);
   }
-  scan_node_->ReleaseCodegenFn(file_format(), codegen_fn_);
   codegen_fn_ = NULL;
   HdfsScanner::Close();
 }
@@ -101,7 +100,8 @@ Status BaseSequenceScanner::ProcessSplit() {
 
     // Release our conjuncts so threads responsible for actually processing a split can
     // use them.
-    scan_node_->ReleaseConjuncts(conjuncts_);
+    scan_node_->ReleaseConjuncts(conjuncts_ctx_);
+    conjuncts_ctx_ = NULL;
     conjuncts_ = NULL;
 
     header_ = state_->obj_pool()->Add(AllocateFileHeader());
@@ -140,21 +140,7 @@ Status BaseSequenceScanner::ProcessSplit() {
   while (!finished_) {
     status = ProcessRange();
     if (status.ok()) break;
-    if (status.IsCancelled() || status.IsMemLimitExceeded()) return status;
-
-    // Log error from file format parsing.
-    stringstream ss;
-    ss << "Problem parsing file " << stream_->filename() << " at ";
-    if (stream_->eof()) {
-      ss << "end of file";
-    } else {
-      ss << "offset " << stream_->file_offset();
-    }
-    ss << ": " << status.GetErrorMsg();
-    state_->LogError(ss.str());
-
-    // If abort on error then return, otherwise try to recover.
-    if (state_->abort_on_error()) return status;
+    RETURN_IF_ERROR(LogParseError(status));
 
     // Recover by skipping to the next sync.
     parse_status_ = Status::OK;
@@ -169,6 +155,26 @@ Status BaseSequenceScanner::ProcessSplit() {
   return Status::OK;
 }
 
+Status BaseSequenceScanner::LogParseError(const Status& status) {
+  DCHECK(!status.ok());
+  if (status.IsCancelled() || status.IsMemLimitExceeded()) return status;
+
+  // Log error from file format parsing.
+  stringstream ss;
+  ss << "Problem parsing file " << stream_->filename() << " at ";
+  if (stream_->eof()) {
+    ss << "end of file";
+  } else {
+    ss << "offset " << stream_->file_offset();
+  }
+  ss << ": " << status.GetErrorMsg();
+  state_->LogError(ss.str());
+
+  // If abort on error then return, otherwise try to recover.
+  if (state_->abort_on_error()) return status;
+  return Status::OK;
+}
+
 Status BaseSequenceScanner::ReadSync() {
   // We are finished when we read a sync marker occurring completely in the next
   // scan range
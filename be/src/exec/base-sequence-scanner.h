@@ -117,6 +117,11 @@ class BaseSequenceScanner : public HdfsScanner {
   // - sync_size: number of bytes for sync
   Status SkipToSync(const uint8_t* sync, int sync_size);
 
+  // Logs 'status', an error returned while processing the scan range. Returns 'status'
+  // if the scanner must not recover from it (cancellation, mem limit exceeded or
+  // abort_on_error), Status::OK otherwise.
+  Status LogParseError(const Status& status);
+
   bool finished() { return finished_; }
 
   // Estimate of header size in bytes.  This is initial number of bytes to issue
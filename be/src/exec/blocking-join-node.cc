@@ -67,12 +67,16 @@ Status BlockingJoinNode::Prepare(RuntimeState* state) {
   }
 
   left_batch_.reset(new RowBatch(row_descriptor_, state->batch_size(), mem_tracker()));
+  left_child_prefetcher_.reset(
+      new RowBatchPrefetcher(child(0), row_descriptor_, mem_tracker()));
   return Status::OK;
 }
 
 void BlockingJoinNode::Close(RuntimeState* state) {
   if (is_closed()) return;
   if (build_pool_.get() != NULL) build_pool_->FreeAll();
+  // Stop fetching from the left child before it is closed.
+  if (left_child_prefetcher_.get() != NULL) left_child_prefetcher_->Close();
   left_batch_.reset();
   ExecNode::Close(state);
 }
@@ -129,9 +133,13 @@ Status BlockingJoinNode::Open(RuntimeState* state) {
   child(1)->Close(state);
 
   RETURN_IF_ERROR(open_status);
+  if (left_child_prefetcher_->Start(state)) {
+    AddRuntimeExecOption("Left Child Pipelined");
+  }
   // Seed left child in preparation for GetNext().
   while (true) {
-    RETURN_IF_ERROR(child(0)->GetNext(state, left_batch_.get(), &left_side_eos_));
+    RETURN_IF_ERROR(
+        left_child_prefetcher_->GetNext(state, left_batch_.get(), &left_side_eos_));
     COUNTER_UPDATE(left_child_row_counter_, left_batch_->num_rows());
     left_batch_pos_ = 0;
     if (left_batch_->num_rows() == 0) {
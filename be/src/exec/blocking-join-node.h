@@ -21,6 +21,7 @@
 #include <string>
 
 #include "exec/exec-node.h"
+#include "exec/row-batch-prefetcher.h"
 #include "util/promise.h"
 
 #include "gen-cpp/PlanNodes_types.h"  // for TJoinOp
@@ -69,6 +70,10 @@ class BlockingJoinNode : public ExecNode {
   boost::scoped_ptr<RowBatch> left_batch_;
   int left_batch_pos_;  // current scan pos in left_batch_
   bool left_side_eos_;  // if true, left child has no more rows to process
+
+  // Fetches left child batches, possibly ahead of time in a separate thread. Must be
+  // used instead of child(0)->GetNext(). Created in Prepare().
+  boost::scoped_ptr<RowBatchPrefetcher> left_child_prefetcher_;
   TupleRow* current_left_child_row_;
 
   // build_tuple_idx_[i] is the tuple index of child(1)'s tuple[i] in the output row
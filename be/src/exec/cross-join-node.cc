@@ -110,7 +110,8 @@ Status CrossJoinNode::GetNext(RuntimeState* state, RowBatch* output_batch, bool*
         break;
       } else {
         timer.Stop();
-        RETURN_IF_ERROR(child(0)->GetNext(state, left_batch_.get(), &left_side_eos_));
+        RETURN_IF_ERROR(
+            left_child_prefetcher_->GetNext(state, left_batch_.get(), &left_side_eos_));
         timer.Start();
         COUNTER_UPDATE(left_child_row_counter_, left_batch_->num_rows());
       }
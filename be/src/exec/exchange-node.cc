@@ -66,6 +66,11 @@ void ExchangeNode::Close(RuntimeState* state) {
   ExecNode::Close(state);
 }
 
+void ExchangeNode::CancelStream() {
+  DCHECK(stream_recvr_ != NULL);
+  stream_recvr_->Cancel();
+}
+
 void ExchangeNode::TransferInputBatchOwnership(RowBatch* output_batch) {
   if (input_batch_.get() == NULL) return;
   input_batch_->TransferResourceOwnership(output_batch);
@@ -40,6 +40,10 @@ class ExchangeNode : public ExecNode {
   // recorded in TPlanNode, and before calling Prepare()
   void set_num_senders(int num_senders) { num_senders_ = num_senders; }
 
+  // Cancels the incoming data stream, so that a concurrent GetNext() that waits for
+  // data returns CANCELLED. Can be called from any thread after Prepare().
+  void CancelStream();
+
  protected:
   virtual void DebugString(int indentation_level, std::stringstream* out) const;
 
@@ -99,7 +99,6 @@ ExecNode::ExecNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl
   : id_(tnode.node_id),
     type_(tnode.node_type),
     pool_(pool),
-    codegend_conjuncts_thread_safe_(true),
     row_descriptor_(descs, tnode.row_tuples, tnode.nullable_tuples),
     debug_phase_(TExecNodePhase::INVALID),
     debug_action_(TDebugAction::WAIT),
@@ -313,13 +312,7 @@ void ExecNode::DebugString(int indentation_level, stringstream* out) const {
 }
 
 Status ExecNode::PrepareConjuncts(RuntimeState* state) {
-  codegend_conjuncts_thread_safe_ = true;
-  for (vector<Expr*>::iterator i = conjuncts_.begin(); i != conjuncts_.end(); ++i) {
-    bool is_thread_safe;
-    RETURN_IF_ERROR(Expr::Prepare(*i, state, row_desc(), false, &is_thread_safe));
-    codegend_conjuncts_thread_safe_ &= is_thread_safe;
-  }
-  return Status::OK;
+  return Expr::Prepare(conjuncts_, state, row_desc(), false);
 }
 
 bool ExecNode::EvalConjuncts(Expr* const* exprs, int num_exprs, TupleRow* row) {
@@ -337,11 +330,12 @@ bool ExecNode::EvalConjuncts(Expr* const* exprs, int num_exprs, TupleRow* row) {
 // entry:
 //   %null_ptr = alloca i1
 //   %0 = bitcast %"class.impala::TupleRow"* %row to i8**
-//   %eval = call i1 @BinaryPredicate(i8** %0, i8* null, i1* %null_ptr)
+//   %state_data = bitcast %"class.impala::Expr"** %exprs to i8*
+//   %eval = call i1 @BinaryPredicate(i8** %0, i8* %state_data, i1* %null_ptr)
 //   br i1 %eval, label %continue, label %false
 //
 // continue:                                         ; preds = %entry
-//   %eval2 = call i1 @BinaryPredicate3(i8** %0, i8* null, i1* %null_ptr)
+//   %eval2 = call i1 @BinaryPredicate3(i8** %0, i8* %state_data, i1* %null_ptr)
 //   br i1 %eval2, label %continue1, label %false
 //
 // continue1:                                        ; preds = %continue
@@ -382,7 +376,7 @@ Function* ExecNode::CodegenEvalConjuncts(LlvmCodeGen* codegen,
   LlvmCodeGen::LlvmBuilder builder(codegen->context());
   Value* args[3];
   Function* fn = prototype.GeneratePrototype(&builder, args);
-  // Other args are unused.
+  // num_exprs is unused.
   Value* tuple_row_arg = args[2];
 
   if (conjuncts.size() > 0) {
@@ -392,6 +386,8 @@ Function* ExecNode::CodegenEvalConjuncts(LlvmCodeGen* codegen,
     // TODO: think about doing that
     Type* tuple_row_llvm_type = PointerType::get(codegen->ptr_type(), 0);
     tuple_row_arg = builder.CreateBitCast(tuple_row_arg, tuple_row_llvm_type);
+    Value* state_data_arg =
+        builder.CreateBitCast(args[0], codegen->ptr_type(), "state_data");
     BasicBlock* false_block = BasicBlock::Create(context, "false", fn);
 
     LlvmCodeGen::NamedVariable null_var("null_ptr", codegen->boolean_type());
@@ -401,7 +397,7 @@ Function* ExecNode::CodegenEvalConjuncts(LlvmCodeGen* codegen,
       BasicBlock* true_block = BasicBlock::Create(context, "continue", fn, false_block);
       Function* conjunct_fn = conjuncts[i]->codegen_fn();
       DCHECK_EQ(conjuncts[i]->scratch_buffer_size(), 0);
-      Value* expr_args[] = { tuple_row_arg, codegen->null_ptr_value(), is_null_ptr };
+      Value* expr_args[] = { tuple_row_arg, state_data_arg, is_null_ptr };
 
       // Ignore null result.  If null, expr's will return false which
       // is exactly the semantics for conjuncts
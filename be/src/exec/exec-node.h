@@ -119,8 +119,9 @@ class ExecNode {
   // Codegen function to evaluate the conjuncts.  Returns NULL if codegen was
   // not supported for the conjunct exprs.
   // Codegen'd signature is bool EvalConjuncts(Expr** exprs, int num_exprs, TupleRow*);
-  // The first two arguments are ignored (the Expr's are baked into the codegen)
-  // but it is included so the signature can match EvalConjuncts.
+  // The Expr's are baked into the codegen and 'num_exprs' is ignored.  'exprs' is
+  // passed to the conjuncts as their 'state_data', so if the conjuncts are the roots of
+  // an ExprContext, 'exprs' must be the calling thread's ExprContext::expr_table().
   static llvm::Function* CodegenEvalConjuncts(LlvmCodeGen* codegen,
       const std::vector<Expr*>& conjuncts);
 
@@ -196,12 +197,6 @@ class ExecNode {
   ObjectPool* pool_;
   std::vector<Expr*> conjuncts_;
 
-  // True if the codegen'd function for 'conjuncts_' is thread safe.  If not, copies
-  // of the conjuncts_ need to be made if the conjuncts will be evaluated by multiple
-  // threads.
-  // TODO: we need to make Expr's always thread safe and this can be removed.
-  bool codegend_conjuncts_thread_safe_;
-
   std::vector<ExecNode*> children_;
   RowDescriptor row_descriptor_;
 
@@ -41,7 +41,8 @@ HashJoinNode::HashJoinNode(
     codegen_process_build_batch_fn_(NULL),
     process_build_batch_fn_(NULL),
     codegen_process_probe_batch_fn_(NULL),
-    process_probe_batch_fn_(NULL) {
+    process_probe_batch_fn_(NULL),
+    codegen_row_batches_counter_(NULL) {
   match_all_probe_ =
     (join_op_ == TJoinOp::LEFT_OUTER_JOIN || join_op_ == TJoinOp::FULL_OUTER_JOIN);
   match_one_build_ = (join_op_ == TJoinOp::LEFT_SEMI_JOIN);
@@ -74,6 +75,8 @@ Status HashJoinNode::Prepare(RuntimeState* state) {
       ADD_COUNTER(runtime_profile(), "BuildBuckets", TCounterType::UNIT);
   hash_tbl_load_factor_counter_ =
       ADD_COUNTER(runtime_profile(), "LoadFactor", TCounterType::DOUBLE_VALUE);
+  codegen_row_batches_counter_ =
+      ADD_COUNTER(runtime_profile(), "CodegenRowBatches", TCounterType::UNIT);
 
   // build and probe exprs are evaluated in the context of the rows produced by our
   // right and left children, respectively
@@ -99,7 +102,7 @@ Status HashJoinNode::Prepare(RuntimeState* state) {
         CodegenProcessBuildBatch(state->codegen(), hash_fn);
     if (codegen_process_build_batch_fn_ != NULL) {
       state->codegen()->AddFunctionToJit(codegen_process_build_batch_fn_,
-          reinterpret_cast<void**>(&process_build_batch_fn_));
+          reinterpret_cast<void**>(&process_build_batch_fn_), true);
       AddRuntimeExecOption("Build Side Codegen Enabled");
     }
 
@@ -109,7 +112,7 @@ Status HashJoinNode::Prepare(RuntimeState* state) {
           CodegenProcessProbeBatch(state->codegen(), hash_fn);
       if (codegen_process_probe_batch_fn_ != NULL) {
         state->codegen()->AddFunctionToJit(codegen_process_probe_batch_fn_,
-            reinterpret_cast<void**>(&process_probe_batch_fn_));
+            reinterpret_cast<void**>(&process_probe_batch_fn_), true);
         AddRuntimeExecOption("Probe Side Codegen Enabled");
       }
     }
@@ -141,11 +144,17 @@ Status HashJoinNode::ConstructBuildSide(RuntimeState* state) {
     build_pool_->AcquireData(build_batch.tuple_data_pool(), false);
     RETURN_IF_ERROR(state->CheckQueryState());
 
-    // Call codegen version if possible
-    if (process_build_batch_fn_ == NULL) {
+    // Call codegen version if possible. The function may still be jitted in the
+    // background: only read the pointer once the module is optimized.
+    ProcessBuildBatchFn process_build_batch_fn = NULL;
+    if (codegen_process_build_batch_fn_ != NULL && state->codegen()->is_optimized()) {
+      process_build_batch_fn = process_build_batch_fn_;
+    }
+    if (process_build_batch_fn == NULL) {
       ProcessBuildBatch(&build_batch);
     } else {
-      process_build_batch_fn_(this, &build_batch);
+      process_build_batch_fn(this, &build_batch);
+      COUNTER_UPDATE(codegen_row_batches_counter_, 1);
     }
     VLOG_ROW << hash_tbl_->DebugString(true, &child(1)->row_desc());
 
@@ -257,7 +266,8 @@ Status HashJoinNode::GetNext(RuntimeState* state, RowBatch* out_batch, bool* eos
       if (!left_side_eos_) {
         while (true) {
           probe_timer.Stop();
-          RETURN_IF_ERROR(child(0)->GetNext(state, left_batch_.get(), &left_side_eos_));
+          RETURN_IF_ERROR(
+              left_child_prefetcher_->GetNext(state, left_batch_.get(), &left_side_eos_));
           probe_timer.Start();
           if (left_batch_->num_rows() == 0) {
             // Empty batches can still contain IO buffers, which need to be passed up to
@@ -333,15 +343,20 @@ Status HashJoinNode::LeftJoinGetNext(RuntimeState* state,
     if (limit() != -1) max_added_rows = min(max_added_rows, limit() - rows_returned());
 
     // Continue processing this row batch
-    if (process_probe_batch_fn_ == NULL) {
+    ProcessProbeBatchFn process_probe_batch_fn = NULL;
+    if (codegen_process_probe_batch_fn_ != NULL && state->codegen()->is_optimized()) {
+      process_probe_batch_fn = process_probe_batch_fn_;
+    }
+    if (process_probe_batch_fn == NULL) {
       num_rows_returned_ +=
           ProcessProbeBatch(out_batch, left_batch_.get(), max_added_rows);
       COUNTER_SET(rows_returned_counter_, num_rows_returned_);
     } else {
       // Use codegen'd function
       num_rows_returned_ +=
-          process_probe_batch_fn_(this, out_batch, left_batch_.get(), max_added_rows);
+          process_probe_batch_fn(this, out_batch, left_batch_.get(), max_added_rows);
       COUNTER_SET(rows_returned_counter_, num_rows_returned_);
+      COUNTER_UPDATE(codegen_row_batches_counter_, 1);
     }
 
     if (ReachedLimit() || out_batch->IsFull()) {
@@ -359,7 +374,8 @@ Status HashJoinNode::LeftJoinGetNext(RuntimeState* state,
         break;
       } else {
         probe_timer.Stop();
-        RETURN_IF_ERROR(child(0)->GetNext(state, left_batch_.get(), &left_side_eos_));
+        RETURN_IF_ERROR(
+            left_child_prefetcher_->GetNext(state, left_batch_.get(), &left_side_eos_));
         probe_timer.Start();
         COUNTER_UPDATE(left_child_row_counter_, left_batch_->num_rows());
       }
@@ -89,7 +89,8 @@ class HashJoinNode : public BlockingJoinNode {
   llvm::Function* codegen_process_build_batch_fn_;
 
   // Function declaration for codegen'd function.  Signature must match
-  // HashJoinNode::ProcessBuildBatch
+  // HashJoinNode::ProcessBuildBatch.  Like process_probe_batch_fn_, only valid once
+  // codegen()->is_optimized().
   typedef void (*ProcessBuildBatchFn)(HashJoinNode*, RowBatch*);
   ProcessBuildBatchFn process_build_batch_fn_;
 
@@ -98,11 +99,14 @@ class HashJoinNode : public BlockingJoinNode {
 
   // HashJoinNode::ProcessProbeBatch() exactly
   typedef int (*ProcessProbeBatchFn)(HashJoinNode*, RowBatch*, RowBatch*, int);
-  // Jitted ProcessProbeBatch function pointer.  Null if codegen is disabled.
+  // Jitted ProcessProbeBatch function pointer.  Null if codegen is disabled.  Set by the
+  // thread that optimizes the module, only valid once codegen()->is_optimized().
   ProcessProbeBatchFn process_probe_batch_fn_;
 
   RuntimeProfile::Counter* build_buckets_counter_;   // num buckets in hash table
   RuntimeProfile::Counter* hash_tbl_load_factor_counter_;
+  // num build and probe row batches processed by the jitted functions
+  RuntimeProfile::Counter* codegen_row_batches_counter_;
 
   // GetNext helper function for the common join cases: Inner join, left semi and left
   // outer
@@ -30,8 +30,7 @@ using namespace impala;
 
 jclass HBaseTableScanner::scan_cl_ = NULL;
 jclass HBaseTableScanner::resultscanner_cl_ = NULL;
-jclass HBaseTableScanner::result_cl_ = NULL;
-jclass HBaseTableScanner::cell_cl_ = NULL;
+jclass HBaseTableScanner::result_serializer_cl_ = NULL;
 jclass HBaseTableScanner::hconstants_cl_ = NULL;
 jclass HBaseTableScanner::filter_list_cl_ = NULL;
 jclass HBaseTableScanner::filter_list_op_cl_ = NULL;
@@ -46,21 +45,8 @@ jmethodID HBaseTableScanner::scan_add_column_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_filter_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_start_row_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_stop_row_id_ = NULL;
-jmethodID HBaseTableScanner::resultscanner_next_id_ = NULL;
 jmethodID HBaseTableScanner::resultscanner_close_id_ = NULL;
-jmethodID HBaseTableScanner::result_raw_cells_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_row_array_ = NULL;
-jmethodID HBaseTableScanner::cell_get_family_array_ = NULL;
-jmethodID HBaseTableScanner::cell_get_qualifier_array_ = NULL;
-jmethodID HBaseTableScanner::cell_get_value_array_ = NULL;
-jmethodID HBaseTableScanner::cell_get_family_offset_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_family_length_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_qualifier_offset_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_qualifier_length_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_row_offset_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_row_length_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_value_offset_id_ = NULL;
-jmethodID HBaseTableScanner::cell_get_value_length_id_ = NULL;
+jmethodID HBaseTableScanner::result_serializer_next_batch_id_ = NULL;
 jmethodID HBaseTableScanner::filter_list_ctor_ = NULL;
 jmethodID HBaseTableScanner::filter_list_add_filter_id_ = NULL;
 jmethodID HBaseTableScanner::single_column_value_filter_ctor_ = NULL;
@@ -87,11 +73,13 @@ HBaseTableScanner::HBaseTableScanner(
     htable_(NULL),
     scan_(NULL),
     resultscanner_(NULL),
-    cells_(NULL),
+    row_key_(NULL),
+    row_key_length_(0),
     cell_index_(0),
+    batch_pos_(NULL),
+    num_batch_rows_left_(0),
     num_requested_cells_(0),
     num_addl_requested_cols_(0),
-    num_cells_(0),
     all_cells_present_(false),
     value_pool_(new MemPool(scan_node_->mem_tracker())),
     scan_setup_timer_(ADD_TIMER(scan_node_->runtime_profile(),
@@ -116,15 +104,15 @@ Status HBaseTableScanner::Init() {
   }
 
   // Global class references:
-  // HTable, Scan, ResultScanner, Result, ImmutableBytesWritable, HConstants.
+  // Scan, ResultScanner, HBaseResultSerializer, HConstants.
   RETURN_IF_ERROR(
       JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/client/Scan", &scan_cl_));
   RETURN_IF_ERROR(
       JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/client/ResultScanner",
           &resultscanner_cl_));
   RETURN_IF_ERROR(
-      JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/client/Result",
-          &result_cl_));
+      JniUtil::GetGlobalClassRef(env, "com/cloudera/impala/util/HBaseResultSerializer",
+          &result_serializer_cl_));
   RETURN_IF_ERROR(
       JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/HConstants",
           &hconstants_cl_));
@@ -147,22 +135,6 @@ Status HBaseTableScanner::Init() {
           "org/apache/hadoop/hbase/client/ScannerTimeoutException",
           &scanner_timeout_ex_cl_));
 
-  // Distinguish HBase versions by checking for the existence of the Cell class.
-  // HBase 0.95.2: Use Cell class and corresponding methods.
-  // HBase prior to 0.95.2: Use the KeyValue class and Cell-equivalent methods.
-  bool has_cell_class = JniUtil::ClassExists(env, "org/apache/hadoop/hbase/Cell");
-  if (has_cell_class) {
-    LOG(INFO) << "Detected HBase version >= 0.95.2";
-    RETURN_IF_ERROR(
-        JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/Cell", &cell_cl_));
-  } else {
-    // Assume a non-CDH5 HBase version because the Cell class wasn't found.
-    LOG(INFO) << "Detected HBase version < 0.95.2";
-    RETURN_IF_ERROR(
-        JniUtil::GetGlobalClassRef(env, "org/apache/hadoop/hbase/KeyValue",
-            &cell_cl_));
-  }
-
   // Scan method ids.
   scan_ctor_ = env->GetMethodID(scan_cl_, "<init>", "()V");
   RETURN_ERROR_IF_EXC(env);
@@ -187,59 +159,12 @@ Status HBaseTableScanner::Init() {
   RETURN_ERROR_IF_EXC(env);
 
   // ResultScanner method ids.
-  resultscanner_next_id_ = env->GetMethodID(resultscanner_cl_, "next",
-      "()Lorg/apache/hadoop/hbase/client/Result;");
-  RETURN_ERROR_IF_EXC(env);
   resultscanner_close_id_ = env->GetMethodID(resultscanner_cl_, "close", "()V");
   RETURN_ERROR_IF_EXC(env);
 
-  // Result method ids.
-  if (has_cell_class) {
-    result_raw_cells_id_ = env->GetMethodID(result_cl_, "rawCells",
-        "()[Lorg/apache/hadoop/hbase/Cell;");
-  } else {
-    result_raw_cells_id_ = env->GetMethodID(result_cl_, "raw",
-        "()[Lorg/apache/hadoop/hbase/KeyValue;");
-  }
-  RETURN_ERROR_IF_EXC(env);
-
-  // Cell or equivalent KeyValue method ids.
-  // Method ids to retrieve buffers backing different portions of row data.
-  if (has_cell_class) {
-    cell_get_row_array_ = env->GetMethodID(cell_cl_, "getRowArray", "()[B");
-    RETURN_ERROR_IF_EXC(env);
-    cell_get_family_array_ = env->GetMethodID(cell_cl_, "getFamilyArray", "()[B");
-    RETURN_ERROR_IF_EXC(env);
-    cell_get_qualifier_array_ = env->GetMethodID(cell_cl_, "getQualifierArray", "()[B");
-    RETURN_ERROR_IF_EXC(env);
-    cell_get_value_array_ = env->GetMethodID(cell_cl_, "getValueArray", "()[B");
-    RETURN_ERROR_IF_EXC(env);
-  } else {
-    // In HBase versions prior to 0.95.2 all data from a row is backed by the same buffer
-    cell_get_row_array_ = cell_get_family_array_ =
-        cell_get_qualifier_array_ = cell_get_value_array_ =
-        env->GetMethodID(cell_cl_, "getBuffer", "()[B");
-    RETURN_ERROR_IF_EXC(env);
-  }
-  // Method ids for retrieving lengths and offsets into buffers backing different
-  // portions of row data. Both the Cell and KeyValue classes support these methods.
-  cell_get_family_offset_id_ = env->GetMethodID(cell_cl_, "getFamilyOffset", "()I");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_family_length_id_ = env->GetMethodID(cell_cl_, "getFamilyLength", "()B");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_qualifier_offset_id_ =
-      env->GetMethodID(cell_cl_, "getQualifierOffset", "()I");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_qualifier_length_id_ =
-      env->GetMethodID(cell_cl_, "getQualifierLength", "()I");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_row_offset_id_ = env->GetMethodID(cell_cl_, "getRowOffset", "()I");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_row_length_id_ = env->GetMethodID(cell_cl_, "getRowLength", "()S");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_value_offset_id_ = env->GetMethodID(cell_cl_, "getValueOffset", "()I");
-  RETURN_ERROR_IF_EXC(env);
-  cell_get_value_length_id_ = env->GetMethodID(cell_cl_, "getValueLength", "()I");
+  // HBaseResultSerializer method ids.
+  result_serializer_next_batch_id_ = env->GetStaticMethodID(result_serializer_cl_,
+      "nextBatch", "(Lorg/apache/hadoop/hbase/client/ResultScanner;I)[B");
   RETURN_ERROR_IF_EXC(env);
 
   // HConstants fields.
@@ -410,20 +335,20 @@ Status HBaseTableScanner::HandleResultScannerTimeout(JNIEnv* env, bool* timeout)
 
   *timeout = true;
   const ScanRange& scan_range = (*scan_range_vector_)[current_scan_range_idx_];
-  // If cells_ is NULL, then the ResultScanner timed out before it was ever used
+  // If row_key_ is NULL, then the ResultScanner timed out before it returned any rows
   // so we can just re-create the ResultScanner with the same scan_range
-  if (cells_ == NULL) return InitScanRange(env, scan_range);
+  if (row_key_ == NULL) return InitScanRange(env, scan_range);
 
   JniLocalFrame jni_frame;
   RETURN_IF_ERROR(jni_frame.push(env));
-  DCHECK_LT(cell_index_, num_cells_);
-  jobject cell = env->GetObjectArrayElement(cells_, cell_index_);
-  // Specifically set the start_bytes to the next row since some of them were already
-  // read
-  jbyteArray start_bytes =
-    (jbyteArray) env->CallObjectMethod(cell, cell_get_row_array_);
+  // Rows up to the current one were already returned. Restart the scan at the smallest
+  // key after it, which is the current key with a 0 byte appended.
+  string start_key(reinterpret_cast<const char*>(row_key_), row_key_length_);
+  start_key.push_back('\0');
+  jbyteArray start_bytes;
+  RETURN_IF_ERROR(CreateByteArray(env, start_key, &start_bytes));
   jbyteArray end_bytes;
-  CreateByteArray(env, scan_range.stop_key(), &end_bytes);
+  RETURN_IF_ERROR(CreateByteArray(env, scan_range.stop_key(), &end_bytes));
   return InitScanRange(env, start_bytes, end_bytes);
 }
 
@@ -493,16 +418,18 @@ Status HBaseTableScanner::CreateByteArray(JNIEnv* env, const string& s,
   return Status::OK;
 }
 
-Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
+Status HBaseTableScanner::NextBatch(JNIEnv* env) {
   JniLocalFrame jni_frame;
   RETURN_IF_ERROR(jni_frame.push(env));
-  jobject result = NULL;
+  jbyteArray batch = NULL;
   {
     SCOPED_TIMER(scan_node_->read_timer());
     while (true) {
       DCHECK(resultscanner_ != NULL);
-      // result_ = resultscanner_.next();
-      result = env->CallObjectMethod(resultscanner_, resultscanner_next_id_);
+      // batch = HBaseResultSerializer.nextBatch(resultscanner_, rows_cached_);
+      batch = reinterpret_cast<jbyteArray>(env->CallStaticObjectMethod(
+          result_serializer_cl_, result_serializer_next_batch_id_, resultscanner_,
+          rows_cached_));
       // Normally we would check for a JNI exception via RETURN_ERROR_IF_EXC, but we
       // need to also check for scanner timeouts and handle them specially, which is
       // done by HandleResultScannerTimeout(). If a timeout occurred, then it will
@@ -510,15 +437,19 @@ Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
       bool timeout;
       RETURN_IF_ERROR(HandleResultScannerTimeout(env, &timeout));
       if (timeout) {
-        result = env->CallObjectMethod(resultscanner_, resultscanner_next_id_);
+        batch = reinterpret_cast<jbyteArray>(env->CallStaticObjectMethod(
+            result_serializer_cl_, result_serializer_next_batch_id_, resultscanner_,
+            rows_cached_));
         // There shouldn't be a timeout now, so we will just return any errors.
         RETURN_ERROR_IF_EXC(env);
       }
 
       // jump to the next region when finished with the current region.
-      if (result == NULL &&
+      if (batch == NULL &&
           current_scan_range_idx_ + 1 < scan_range_vector_->size()) {
         ++current_scan_range_idx_;
+        // A timeout in the new range must not restart it after a row of the old one.
+        row_key_ = NULL;
         RETURN_IF_ERROR(InitScanRange(env,
             (*scan_range_vector_)[current_scan_range_idx_]));
         continue;
@@ -526,148 +457,117 @@ Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
       break;
     }
   }
+  if (batch == NULL) return Status::OK;
 
-  if (result == NULL) {
-    *has_next = false;
-    return Status::OK;
+  // The previous batch is no longer referenced once the next row is read.
+  value_pool_->Clear();
+  int batch_length = env->GetArrayLength(batch);
+  uint8_t* buffer = value_pool_->Allocate(batch_length);
+  env->GetByteArrayRegion(batch, 0, batch_length, reinterpret_cast<jbyte*>(buffer));
+  RETURN_ERROR_IF_EXC(env);
+  COUNTER_UPDATE(scan_node_->bytes_read_counter(), batch_length);
+
+  batch_pos_ = buffer;
+  memcpy(&num_batch_rows_left_, batch_pos_, sizeof(int32_t));
+  batch_pos_ += sizeof(int32_t);
+  DCHECK_GT(num_batch_rows_left_, 0);
+  return Status::OK;
+}
+
+inline void HBaseTableScanner::ReadBytes(const uint8_t** data, int* length) {
+  int32_t len;
+  memcpy(&len, batch_pos_, sizeof(int32_t));
+  *length = len;
+  *data = batch_pos_ + sizeof(int32_t);
+  batch_pos_ = *data + len;
+}
+
+Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
+  if (num_batch_rows_left_ == 0) {
+    RETURN_IF_ERROR(NextBatch(env));
+    if (num_batch_rows_left_ == 0) {
+      *has_next = false;
+      return Status::OK;
+    }
   }
+  --num_batch_rows_left_;
 
-  if (cells_ != NULL) env->DeleteGlobalRef(cells_);
-  // cells_ = result.raw();
-  cells_ = reinterpret_cast<jobjectArray>(
-      env->CallObjectMethod(result, result_raw_cells_id_));
-  cells_ = reinterpret_cast<jobjectArray>(env->NewGlobalRef(cells_));
-  num_cells_ = env->GetArrayLength(cells_);
-  // Check that raw() didn't return more cells than expected.
+  ReadBytes(&row_key_, &row_key_length_);
+  int32_t num_cells;
+  memcpy(&num_cells, batch_pos_, sizeof(int32_t));
+  batch_pos_ += sizeof(int32_t);
+  // Check that HBase didn't return more cells than expected.
   // If num_requested_cells_ is 0 then only row key is asked for and this check
   // should pass.
-  if (num_cells_ > num_requested_cells_ + num_addl_requested_cols_
+  if (num_cells > num_requested_cells_ + num_addl_requested_cols_
       && num_requested_cells_ + num_addl_requested_cols_ != 0) {
     *has_next = false;
     return Status("Encountered more cells than expected.");
   }
+  cells_.resize(num_cells);
+  for (int i = 0; i < num_cells; ++i) {
+    Cell* cell = &cells_[i];
+    ReadBytes(&cell->family, &cell->family_length);
+    ReadBytes(&cell->qualifier, &cell->qualifier_length);
+    ReadBytes(&cell->value, &cell->value_length);
+  }
   // If all requested columns are present, and we didn't ask for any extra ones to work
-  // around an hbase bug, we avoid family-/qualifier comparisons in NextValue().
-  if (num_cells_ == num_requested_cells_ && num_addl_requested_cols_ == 0) {
+  // around an hbase bug, we avoid family-/qualifier comparisons in GetCurrentValue().
+  if (num_cells == num_requested_cells_ && num_addl_requested_cols_ == 0) {
     all_cells_present_ = true;
   } else {
     all_cells_present_ = false;
   }
   cell_index_ = 0;
 
-  value_pool_->Clear();
   *has_next = true;
   return Status::OK;
 }
 
 inline void HBaseTableScanner::WriteTupleSlot(const SlotDescriptor* slot_desc,
-    Tuple* tuple, void* data) {
+    Tuple* tuple, const void* data) {
   void* slot = tuple->GetSlot(slot_desc->tuple_offset());
-  BitUtil::ByteSwap(slot, data, GetByteSize(slot_desc->type()));
-}
-
-inline void HBaseTableScanner::GetRowKey(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_row_offset_id_);
-  *length = env->CallShortMethod(cell, cell_get_row_length_id_);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_row_array_);
-  *data = value_pool_->Allocate(*length);
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  COUNTER_UPDATE(scan_node_->bytes_read_counter(), *length);
-}
-
-inline void HBaseTableScanner::GetFamily(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_family_offset_id_);
-  *length = env->CallShortMethod(cell, cell_get_family_length_id_);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_family_array_);
-  *data = value_pool_->Allocate(*length);
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  COUNTER_UPDATE(scan_node_->bytes_read_counter(), *length);
-}
-
-inline void HBaseTableScanner::GetQualifier(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_qualifier_offset_id_);
-  *length = env->CallIntMethod(cell, cell_get_qualifier_length_id_);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_qualifier_array_);
-  *data = value_pool_->Allocate(*length);
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  COUNTER_UPDATE(scan_node_->bytes_read_counter(), *length);
-}
-
-inline void HBaseTableScanner::GetValue(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_value_offset_id_);
-  *length = env->CallIntMethod(cell, cell_get_value_length_id_);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_value_array_);
-  *data = value_pool_->Allocate(*length);
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  COUNTER_UPDATE(scan_node_->bytes_read_counter(), *length);
+  BitUtil::ByteSwap(slot, const_cast<void*>(data), GetByteSize(slot_desc->type()));
 }
 
 Status HBaseTableScanner::GetRowKey(JNIEnv* env, void** key, int* key_length) {
-  jobject cell = env->GetObjectArrayElement(cells_, 0);
-  GetRowKey(env, cell, key, key_length);
-  RETURN_ERROR_IF_EXC(env);
+  *key = const_cast<uint8_t*>(row_key_);
+  *key_length = row_key_length_;
   return Status::OK;
 }
 
 Status HBaseTableScanner::GetRowKey(JNIEnv* env, const SlotDescriptor* slot_desc,
     Tuple* tuple) {
-  void* key;
-  int key_length;
-  jobject cell = env->GetObjectArrayElement(cells_, 0);
-  GetRowKey(env, cell, &key, &key_length);
-  DCHECK_EQ(key_length, GetByteSize(slot_desc->type()));
-  WriteTupleSlot(slot_desc, tuple, reinterpret_cast<char*>(key));
-  RETURN_ERROR_IF_EXC(env);
+  DCHECK_EQ(row_key_length_, GetByteSize(slot_desc->type()));
+  WriteTupleSlot(slot_desc, tuple, row_key_);
   return Status::OK;
 }
 
-Status HBaseTableScanner::GetCurrentValue(JNIEnv* env, const string& family,
-    const string& qualifier, void** data, int* length, bool* is_null) {
+void HBaseTableScanner::GetCurrentValue(const string& family, const string& qualifier,
+    void** data, int* length, bool* is_null) {
   // Current row doesn't have any more cells. All remaining values are NULL.
-  if (cell_index_ >= num_cells_) {
+  if (cell_index_ >= cells_.size()) {
     *is_null = true;
-    return Status::OK;
+    return;
   }
-  JniLocalFrame jni_frame;
-  RETURN_IF_ERROR(jni_frame.push(env));
-  jobject cell = env->GetObjectArrayElement(cells_, cell_index_);
+  const Cell& cell = cells_[cell_index_];
   if (!all_cells_present_) {
-    // Check family. If it doesn't match, we have a NULL value.
-    void* family_data;
-    int family_length;
-    GetFamily(env, cell, &family_data, &family_length);
-    if (CompareStrings(family, family_data, family_length) != 0) {
+    // Check family and qualifier. If either doesn't match, we have a NULL value.
+    if (CompareStrings(family, cell.family, cell.family_length) != 0 ||
+        CompareStrings(qualifier, cell.qualifier, cell.qualifier_length) != 0) {
       *is_null = true;
-      return Status::OK;
-    }
-
-    // Check qualifier. If it doesn't match, we have a NULL value.
-    void* qualifier_data;
-    int qualifier_length;
-    GetQualifier(env, cell, &qualifier_data, &qualifier_length);
-    if (CompareStrings(qualifier, qualifier_data, qualifier_length) != 0) {
-      *is_null = true;
-      return Status::OK;
+      return;
     }
   }
-  GetValue(env, cell, data, length);
+  *data = const_cast<uint8_t*>(cell.value);
+  *length = cell.value_length;
   *is_null = false;
-  return Status::OK;
 }
 
 Status HBaseTableScanner::GetValue(JNIEnv* env, const string& family,
     const string& qualifier, void** value, int* value_length) {
   bool is_null;
-  GetCurrentValue(env, family, qualifier, value, value_length, &is_null);
-  RETURN_ERROR_IF_EXC(env);
+  GetCurrentValue(family, qualifier, value, value_length, &is_null);
   if (is_null) {
     *value = NULL;
     *value_length = 0;
@@ -682,24 +582,23 @@ Status HBaseTableScanner::GetValue(JNIEnv* env, const string& family,
   void* value;
   int value_length;
   bool is_null;
-  GetCurrentValue(env, family, qualifier, &value, &value_length, &is_null);
-  RETURN_ERROR_IF_EXC(env);
+  GetCurrentValue(family, qualifier, &value, &value_length, &is_null);
   if (is_null) {
     tuple->SetNull(slot_desc->null_indicator_offset());
     return Status::OK;
   }
   DCHECK_EQ(value_length, GetByteSize(slot_desc->type()));
-  WriteTupleSlot(slot_desc, tuple, reinterpret_cast<char*>(value));
+  WriteTupleSlot(slot_desc, tuple, value);
   ++cell_index_;
   return Status::OK;
 }
 
-int HBaseTableScanner::CompareStrings(const string& s, void* data, int length) {
+int HBaseTableScanner::CompareStrings(const string& s, const void* data, int length) {
   int slength = static_cast<int>(s.length());
   if (slength == 0 && length == 0) return 0;
   if (length == 0) return 1;
   if (slength == 0) return -1;
-  int result = memcmp(s.data(), reinterpret_cast<char*>(data), min(slength, length));
+  int result = memcmp(s.data(), data, min(slength, length));
   if (result == 0 && slength != length) {
     return (slength < length ? -1 : 1);
   } else {
@@ -729,7 +628,6 @@ void HBaseTableScanner::Close(JNIEnv* env) {
     resultscanner_ = NULL;
   }
   if (scan_ != NULL) env->DeleteGlobalRef(scan_);
-  if (cells_ != NULL) env->DeleteGlobalRef(cells_);
 
   // Close the HTable so that the connections are not kept around.
   if (htable_.get() != NULL) htable_->Close(state_);
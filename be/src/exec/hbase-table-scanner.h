@@ -52,11 +52,11 @@ class HBaseScanNode;
 // be overridden by the query option hbase_caching. FE will also suggest a max value such
 // that it won't put too much memory pressure on the region server.
 //
-// HBase version compatibility: Starting from HBase 0.95.2 result rows are represented by
-// Cells instead of KeyValues (prior HBase versions). To mitigate this API
-// incompatibility the Cell class and its methods are replaced with corresponding
-// KeyValue equivalents if the Cell is not found in the classpath. The HBase version
-// detection and KeyValue/Cell replacements are performed in Init().
+// Rows are fetched in batches of up to rows_cached_ rows with a single JNI call to
+// HBaseResultSerializer.nextBatch() (in the frontend jar), which serializes all cells of
+// the batch into one byte array. The array is copied into value_pool_ and decoded here,
+// so that reading a row, its row key and its values requires no further JNI calls.
+// The serializer only uses KeyValue methods that exist in all supported HBase versions.
 //
 // Note: When none of the requested family/qualifiers exist in a particular row,
 // HBase will not return the row at all, leading to "missing" NULL values.
@@ -112,7 +112,7 @@ class HBaseTableScanner {
   // Returns non-ok status if an error occurred.
   Status Next(JNIEnv* env, bool* has_next);
 
-  // Get the current HBase row key.
+  // Get the current HBase row key. The key is valid until the following Next().
   Status GetRowKey(JNIEnv* env, void** key, int* key_length);
 
   // Write the current HBase row key into the tuple slot.
@@ -122,6 +122,7 @@ class HBaseTableScanner {
   // Used to fetch HBase values in order of family/qualifier.
   // Fetch the next value matching family and qualifier into value/value_length.
   // If there is no match, value is set to NULL and value_length to 0.
+  // The value is valid until the following Next().
   Status GetValue(JNIEnv* env, const std::string& family, const std::string& qualifier,
       void** value, int* value_length);
 
@@ -149,9 +150,7 @@ class HBaseTableScanner {
   // Global class references created with JniUtil. Cleanup is done in JniUtil::Cleanup().
   static jclass scan_cl_;
   static jclass resultscanner_cl_;
-  static jclass result_cl_;
-  // Cell or KeyValue class depending on HBase version (see class comment).
-  static jclass cell_cl_;
+  static jclass result_serializer_cl_;
   static jclass hconstants_cl_;
   static jclass filter_list_cl_;
   static jclass filter_list_op_cl_;
@@ -168,21 +167,8 @@ class HBaseTableScanner {
   static jmethodID scan_set_filter_id_;
   static jmethodID scan_set_start_row_id_;
   static jmethodID scan_set_stop_row_id_;
-  static jmethodID resultscanner_next_id_;
   static jmethodID resultscanner_close_id_;
-  static jmethodID result_raw_cells_id_;
-  static jmethodID cell_get_row_array_;
-  static jmethodID cell_get_family_array_;
-  static jmethodID cell_get_qualifier_array_;
-  static jmethodID cell_get_value_array_;
-  static jmethodID cell_get_family_offset_id_;
-  static jmethodID cell_get_family_length_id_;
-  static jmethodID cell_get_qualifier_offset_id_;
-  static jmethodID cell_get_qualifier_length_id_;
-  static jmethodID cell_get_row_offset_id_;
-  static jmethodID cell_get_row_length_id_;
-  static jmethodID cell_get_value_offset_id_;
-  static jmethodID cell_get_value_length_id_;
+  static jmethodID result_serializer_next_batch_id_;
   static jmethodID filter_list_ctor_;
   static jmethodID filter_list_add_filter_id_;
   static jmethodID single_column_value_filter_ctor_;
@@ -206,14 +192,31 @@ class HBaseTableScanner {
   jobject scan_;           // Java type Scan
   jobject resultscanner_;  // Java type ResultScanner
 
+  // A cell of the current row, pointing into the current batch.
+  struct Cell {
+    const uint8_t* family;
+    int family_length;
+    const uint8_t* qualifier;
+    int qualifier_length;
+    const uint8_t* value;
+    int value_length;
+  };
+
   // Helper members for retrieving results from a scan. Updated in Next() and
-  // used by GetRowKey() and GetValue(). Result of resultscanner_.next().raw()
-  // Java type Cell[] or KeyValue[] depending on HBase version.
-  jobjectArray cells_;
+  // used by GetRowKey() and GetValue(). The row key and cells of the current row.
+  // row_key_ is NULL if no row of the current scan range was returned yet.
+  const uint8_t* row_key_;
+  int row_key_length_;
+  std::vector<Cell> cells_;
 
-  // Current position in cells_. Incremented in NextValue(). Reset in Next().
+  // Current position in cells_. Incremented in GetValue(). Reset in Next().
   int cell_index_;
 
+  // Position of the next row in the current batch, which is in value_pool_, and the
+  // number of rows left in it.
+  const uint8_t* batch_pos_;
+  int num_batch_rows_left_;
+
   // Number of requested cells (i.e., the number of added family/qualifier pairs).
   // Set in StartScan().
   int num_requested_cells_;
@@ -222,19 +225,17 @@ class HBaseTableScanner {
   // hbase bug
   int num_addl_requested_cols_;
 
-  // Number of cells returned from last result_.raw().
-  int num_cells_;
-
   // Indicates whether all requested cells are present in the current cells_.
   // If set to true, all family/qualifier comparisons are avoided in NextValue().
   bool all_cells_present_;
 
-  // Pool for allocating keys/values retrieved from HBase.
-  // Memory allocated from this pool is valid until the following Next().
+  // Pool holding the current batch, which the keys/values retrieved from HBase point
+  // into. Cleared when the next batch is fetched.
   boost::scoped_ptr<MemPool> value_pool_;
 
   // Number of rows for caching that will be passed to scanners.
-  // Set in the HBase call Scan.setCaching();
+  // Set in the HBase call Scan.setCaching(). Also the number of rows fetched from the
+  // ResultScanner with each JNI call.
   int rows_cached_;
 
   // True if the scanner should set Scan.setCacheBlocks to true.
@@ -254,7 +255,7 @@ class HBaseTableScanner {
   // Lexicographically compares s with the string in data having given length.
   // Returns a value > 0 if s is greater, a value < 0 if s is smaller,
   // and 0 if they are equal.
-  int CompareStrings(const std::string& s, void* data, int length);
+  int CompareStrings(const std::string& s, const void* data, int length);
 
   // Turn strings into Java byte array.
   Status CreateByteArray(JNIEnv* env, const std::string& s, jbyteArray* bytes);
@@ -269,31 +270,26 @@ class HBaseTableScanner {
   // arrays
   Status InitScanRange(JNIEnv* env, jbyteArray start_bytes, jbyteArray end_bytes);
 
-  // Copies the row key of cell into value_pool_ and returns it via *data and *length.
-  inline void GetRowKey(JNIEnv* env, jobject cell, void** data, int* length);
-
-  // Copies the column family of cell into value_pool_ and returns it
-  // via *data and *length.
-  inline void GetFamily(JNIEnv* env, jobject cell, void** data, int* length);
-
-  // Copies the column qualifier of cell into value_pool_ and returns it
-  // via *data and *length.
-  inline void GetQualifier(JNIEnv* env, jobject cell, void** data, int* length);
+  // Fetches the next batch of rows into value_pool_, moving on to the next scan range
+  // when the current one is done. Leaves num_batch_rows_left_ at 0 if there are no
+  // more rows.
+  Status NextBatch(JNIEnv* env);
 
-  // Copies the value of cell into value_pool_ and returns it via *data and *length.
-  inline void GetValue(JNIEnv* env, jobject cell, void** data, int* length);
+  // Reads a length followed by that many bytes at batch_pos_ and advances batch_pos_.
+  inline void ReadBytes(const uint8_t** data, int* length);
 
   // Returns the current value of cells_[cell_index_] in *data and *length
   // if its family/qualifier match the given family/qualifier.
   // Otherwise, sets *is_null to true indicating a mismatch in family or qualifier.
-  inline Status GetCurrentValue(JNIEnv* env, const std::string& family,
-      const std::string& qualifier, void** data, int* length, bool* is_null);
+  inline void GetCurrentValue(const std::string& family, const std::string& qualifier,
+      void** data, int* length, bool* is_null);
 
   // Write to a tuple slot with the given hbase binary formatted data, which is in
   // big endian.
   // Only boolean, tinyint, smallint, int, bigint, float and double should have binary
   // formatted data.
-  inline void WriteTupleSlot(const SlotDescriptor* slot_desc, Tuple* tuple, void* data);
+  inline void WriteTupleSlot(const SlotDescriptor* slot_desc, Tuple* tuple,
+      const void* data);
 };
 
 }  // namespace impala
@@ -70,6 +70,8 @@ Status HBaseTableSink::Send(RuntimeState* state, RowBatch* batch, bool eos) {
   // Since everything is set up just forward everything to the writer.
   RETURN_IF_ERROR(hbase_table_writer_->AppendRowBatch(batch));
   (*state->num_appended_rows())[""] += batch->num_rows();
+  // The insert only succeeded once the queued puts reached HBase.
+  if (eos) RETURN_IF_ERROR(hbase_table_writer_->Flush());
   return Status::OK;
 }
 
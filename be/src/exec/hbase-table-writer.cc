@@ -16,28 +16,29 @@
 
 #include <boost/foreach.hpp>
 #include <boost/scoped_array.hpp>
+#include <gflags/gflags.h>
 #include <sstream>
 
 #include "common/logging.h"
 #include "runtime/hbase-table-factory.h"
 #include "util/bit-util.h"
 #include "util/jni-util.h"
+#include "util/thread.h"
 #include "exprs/expr.h"
 #include "runtime/raw-value.h"
 
 using namespace boost;
 using namespace std;
 
-namespace impala {
+DEFINE_int32(hbase_max_pending_put_batches, 2, "(Advanced) The maximum number of row "
+    "batches an HBase table sink queues for writing while the fragment produces the next "
+    "one. If 0, each batch is written to HBase before the next one is produced.");
 
-jclass HBaseTableWriter::put_cl_ = NULL;
-jclass HBaseTableWriter::list_cl_ = NULL;
+namespace impala {
 
-jmethodID HBaseTableWriter::put_ctor_ = NULL;
-jmethodID HBaseTableWriter::list_ctor_ = NULL;
-jmethodID HBaseTableWriter::list_add_id_ = NULL;
+jclass HBaseTableWriter::put_builder_cl_ = NULL;
 
-jmethodID HBaseTableWriter::put_add_id_ = NULL;
+jmethodID HBaseTableWriter::put_builder_create_puts_id_ = NULL;
 
 HBaseTableWriter::HBaseTableWriter(HBaseTableDescriptor* table_desc,
                                    const vector<Expr*>& output_exprs,
@@ -45,10 +46,15 @@ HBaseTableWriter::HBaseTableWriter(HBaseTableDescriptor* table_desc,
     : table_desc_(table_desc),
       table_(NULL),
       output_exprs_(output_exprs),
-      put_list_(NULL),
+      cf_arrays_(NULL),
+      qual_arrays_(NULL),
       runtime_profile_(profile) {
 };
 
+HBaseTableWriter::~HBaseTableWriter() {
+  StopPutThread(true);
+}
+
 Status HBaseTableWriter::Init(RuntimeState* state) {
   RETURN_IF_ERROR(state->htable_factory()->GetTable(table_desc_->name(),
       &table_));
@@ -63,9 +69,15 @@ Status HBaseTableWriter::Init(RuntimeState* state) {
 
   JNIEnv* env = getJNIEnv();
   if (env == NULL) return Status("Error getting JNIEnv.");
+  JniLocalFrame jni_frame;
+  RETURN_IF_ERROR(jni_frame.push(env));
+  jclass byte_array_cl = env->FindClass("[B");
+  RETURN_ERROR_IF_EXC(env);
+  jobjectArray cf_arrays = env->NewObjectArray(num_col - 1, byte_array_cl, NULL);
+  RETURN_ERROR_IF_EXC(env);
+  jobjectArray qual_arrays = env->NewObjectArray(num_col - 1, byte_array_cl, NULL);
+  RETURN_ERROR_IF_EXC(env);
   output_exprs_byte_sizes_.resize(num_col);
-  cf_arrays_.reserve(num_col - 1);
-  qual_arrays_.reserve(num_col - 1);
   for (int i = 0; i < num_col; ++i) {
     output_exprs_byte_sizes_[i] = GetByteSize(output_exprs_[i]->type());
 
@@ -74,15 +86,23 @@ Status HBaseTableWriter::Init(RuntimeState* state) {
     // Setup column family and qualifier byte array for non-rowkey column
     const HBaseTableDescriptor::HBaseColumnDescriptor& col = table_desc_->cols()[i];
     jbyteArray byte_array;
-    jobject global_ref;
     RETURN_IF_ERROR(CreateByteArray(env, col.family, &byte_array));
-    RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, byte_array, &global_ref));
-    cf_arrays_.push_back(reinterpret_cast<jbyteArray>(global_ref));
+    env->SetObjectArrayElement(cf_arrays, i - 1, byte_array);
+    RETURN_ERROR_IF_EXC(env);
     RETURN_IF_ERROR(CreateByteArray(env, col.qualifier, &byte_array));
-    RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, byte_array, &global_ref));
-    qual_arrays_.push_back(reinterpret_cast<jbyteArray>(global_ref));
+    env->SetObjectArrayElement(qual_arrays, i - 1, byte_array);
+    RETURN_ERROR_IF_EXC(env);
   }
+  cf_arrays_ = reinterpret_cast<jobjectArray>(env->NewGlobalRef(cf_arrays));
+  RETURN_ERROR_IF_EXC(env);
+  qual_arrays_ = reinterpret_cast<jobjectArray>(env->NewGlobalRef(qual_arrays));
+  RETURN_ERROR_IF_EXC(env);
 
+  if (FLAGS_hbase_max_pending_put_batches > 0) {
+    put_queue_.reset(new BlockingQueue<jobject>(FLAGS_hbase_max_pending_put_batches));
+    put_thread_.reset(new Thread("hbase-table-writer", "put thread",
+        &HBaseTableWriter::PutThread, this));
+  }
   return Status::OK;
 }
 
@@ -92,154 +112,195 @@ Status HBaseTableWriter::InitJNI() {
 
   RETURN_IF_ERROR(
       JniUtil::GetGlobalClassRef(
-          env, "org/apache/hadoop/hbase/client/Put", &put_cl_));
-  RETURN_ERROR_IF_EXC(env);
-  put_ctor_ = env->GetMethodID(put_cl_, "<init>", "([B)V");
+          env, "com/cloudera/impala/util/HBasePutBuilder", &put_builder_cl_));
   RETURN_ERROR_IF_EXC(env);
-  put_add_id_ = env->GetMethodID(put_cl_, "add",
-    "([B[B[B)Lorg/apache/hadoop/hbase/client/Put;");
-  RETURN_ERROR_IF_EXC(env);
-  RETURN_IF_ERROR(
-      JniUtil::GetGlobalClassRef(env, "java/util/ArrayList", &list_cl_));
-  list_ctor_ = env->GetMethodID(list_cl_, "<init>", "(I)V");
-  RETURN_ERROR_IF_EXC(env);
-  list_add_id_ = env->GetMethodID(list_cl_, "add", "(Ljava/lang/Object;)Z");
+  put_builder_create_puts_id_ = env->GetStaticMethodID(put_builder_cl_, "createPuts",
+      "([B[[B[[B)Ljava/util/List;");
   RETURN_ERROR_IF_EXC(env);
 
   return Status::OK;
 }
 
-Status HBaseTableWriter::AppendRowBatch(RowBatch* batch) {
-  JNIEnv* env = getJNIEnv();
-  if (env == NULL) return Status("Error getting JNIEnv.");
+inline void HBaseTableWriter::AppendInt(int32_t value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  batch_buffer_.insert(batch_buffer_.end(), bytes, bytes + sizeof(int32_t));
+}
+
+inline void HBaseTableWriter::AppendBytes(const void* data, int data_len) {
+  AppendInt(data_len);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  batch_buffer_.insert(batch_buffer_.end(), bytes, bytes + data_len);
+}
 
+Status HBaseTableWriter::SerializeRowBatch(RowBatch* batch) {
   int limit = batch->num_rows();
-  if (limit == 0) return Status::OK;
   int num_cols = table_desc_->num_cols();
   DCHECK_GE(num_cols, 2);
 
-  // Create the array list.
-  RETURN_IF_ERROR(CreatePutList(env, limit));
-
-  // For every TupleRow in the row batch create a put, assign the row key,
-  // and add all of the values generated from the expressions.
+  batch_buffer_.clear();
+  AppendInt(limit);
+  // For every TupleRow in the row batch write the row key and all of the non-NULL
+  // values generated from the expressions.
   string string_value; // text encoded value
   char binary_value[8]; // binary encoded value; at most 8 bytes
   const void* data; // pointer to the column value in bytes
   int data_len; // length of the column value in bytes
-  {
-    SCOPED_TIMER(encoding_timer_);
-    for (int idx_batch = 0; idx_batch < limit; idx_batch++) {
-      TupleRow* current_row = batch->GetRow(idx_batch);
-      jobject put = NULL;
+  for (int idx_batch = 0; idx_batch < limit; idx_batch++) {
+    TupleRow* current_row = batch->GetRow(idx_batch);
 
-      if (output_exprs_[0]->GetValue(current_row) == NULL) {
-        // HBase row key must not be null.
-        return Status("Cannot insert into HBase with a null row key.");
-      }
+    if (output_exprs_[0]->GetValue(current_row) == NULL) {
+      // HBase row key must not be null.
+      return Status("Cannot insert into HBase with a null row key.");
+    }
 
-      for (int j = 0; j < num_cols; j++) {
-        const HBaseTableDescriptor::HBaseColumnDescriptor& col = table_desc_->cols()[j];
-        void* value = output_exprs_[j]->GetValue(current_row);
-
-        if (value != NULL) {
-          if (!col.binary_encoded) {
-            // Text encoded
-            string_value.clear();
-            output_exprs_[j]->PrintValue(value, &string_value);
-            data = string_value.data();
-            data_len = string_value.length();
-          } else {
-            // Binary encoded
-            // Only bool, tinyint, smallint, int, bigint, float and double can be binary
-            // encoded. Convert the value to big-endian.
-            data = binary_value;
-            data_len = output_exprs_byte_sizes_[j];
-            DCHECK(data_len == 1 || data_len == 2 || data_len == 4 || data_len == 8)
-              << data_len;
-            BitUtil::ByteSwap(binary_value, value, data_len);
-          }
-
-          if (j == 0) {
-            DCHECK(put == NULL);
-            RETURN_IF_ERROR(CreatePut(env, data, data_len, &put));
-          } else {
-            DCHECK(put != NULL) << "Put shouldn't be NULL for non-key cols.";
-            jbyteArray val_array;
-            RETURN_IF_ERROR(CreateByteArray(env, data, data_len, &val_array));
-            env->CallObjectMethod(put, put_add_id_, cf_arrays_[j-1], qual_arrays_[j-1],
-                val_array);
-            RETURN_ERROR_IF_EXC(env);
-
-            // Clean up the local references.
-            env->DeleteLocalRef(val_array);
-            RETURN_ERROR_IF_EXC(env);
-          }
-        }
+    // Position of the number of values of this row, which is known at the end.
+    int num_values_pos = 0;
+    int32_t num_values = 0;
+    for (int j = 0; j < num_cols; j++) {
+      const HBaseTableDescriptor::HBaseColumnDescriptor& col = table_desc_->cols()[j];
+      void* value = output_exprs_[j]->GetValue(current_row);
+      if (value == NULL) continue;
+
+      if (!col.binary_encoded) {
+        // Text encoded
+        string_value.clear();
+        output_exprs_[j]->PrintValue(value, &string_value);
+        data = string_value.data();
+        data_len = string_value.length();
+      } else {
+        // Binary encoded
+        // Only bool, tinyint, smallint, int, bigint, float and double can be binary
+        // encoded. Convert the value to big-endian.
+        data = binary_value;
+        data_len = output_exprs_byte_sizes_[j];
+        DCHECK(data_len == 1 || data_len == 2 || data_len == 4 || data_len == 8)
+          << data_len;
+        BitUtil::ByteSwap(binary_value, value, data_len);
       }
 
-      DCHECK(put != NULL);
-      env->DeleteLocalRef(put);
-      RETURN_ERROR_IF_EXC(env);
+      if (j == 0) {
+        AppendBytes(data, data_len);
+        num_values_pos = batch_buffer_.size();
+        AppendInt(0);
+      } else {
+        DCHECK_GT(num_values_pos, 0) << "Row key must precede non-key cols.";
+        AppendInt(j - 1);
+        AppendBytes(data, data_len);
+        ++num_values;
+      }
     }
+    memcpy(&batch_buffer_[num_values_pos], &num_values, sizeof(int32_t));
   }
-
-  // Send the array list to HTable.
-  {
-    SCOPED_TIMER(htable_put_timer_);
-    RETURN_IF_ERROR(table_->Put(put_list_));
-  }
-  // Now clean put_list_.
-  env->DeleteGlobalRef(put_list_);
-  RETURN_ERROR_IF_EXC(env);
-  put_list_ = NULL;
   return Status::OK;
 }
 
-Status HBaseTableWriter::CleanUpJni() {
+Status HBaseTableWriter::AppendRowBatch(RowBatch* batch) {
   JNIEnv* env = getJNIEnv();
   if (env == NULL) return Status("Error getting JNIEnv.");
 
-  if (put_list_ != NULL) {
-    env->DeleteGlobalRef(put_list_);
+  if (batch->num_rows() == 0) return Status::OK;
+
+  jobject put_list = NULL;
+  {
+    SCOPED_TIMER(encoding_timer_);
+    RETURN_IF_ERROR(SerializeRowBatch(batch));
+
+    // put_list = HBasePutBuilder.createPuts(batch_bytes, cf_arrays_, qual_arrays_);
+    JniLocalFrame jni_frame;
+    RETURN_IF_ERROR(jni_frame.push(env));
+    jbyteArray batch_bytes;
+    RETURN_IF_ERROR(CreateByteArray(env, &batch_buffer_[0], batch_buffer_.size(),
+        &batch_bytes));
+    jobject local_put_list = env->CallStaticObjectMethod(put_builder_cl_,
+        put_builder_create_puts_id_, batch_bytes, cf_arrays_, qual_arrays_);
+    RETURN_ERROR_IF_EXC(env);
+    put_list = env->NewGlobalRef(local_put_list);
     RETURN_ERROR_IF_EXC(env);
-    put_list_ = NULL;
   }
 
-  BOOST_FOREACH(jbyteArray ref, cf_arrays_) {
-    env->DeleteGlobalRef(reinterpret_cast<jobject>(ref));
-  }
-  BOOST_FOREACH(jbyteArray ref, qual_arrays_) {
-    env->DeleteGlobalRef(reinterpret_cast<jobject>(ref));
+  if (put_queue_.get() == NULL) {
+    // Send the array list to HTable.
+    Status status;
+    {
+      SCOPED_TIMER(htable_put_timer_);
+      status = table_->Put(put_list);
+    }
+    env->DeleteGlobalRef(put_list);
+    return status;
   }
 
-  return Status::OK;
+  // The queue is only shut down if sending puts failed, or by Flush().
+  if (!put_queue_->BlockingPut(put_list)) {
+    env->DeleteGlobalRef(put_list);
+    lock_guard<mutex> l(put_status_lock_);
+    DCHECK(!put_status_.ok()) << "Rows appended after Flush()";
+    return put_status_;
+  }
+  lock_guard<mutex> l(put_status_lock_);
+  return put_status_;
 }
 
-Status HBaseTableWriter::CreatePutList(JNIEnv* env, int num_puts) {
-  DCHECK(put_list_ == NULL);
-  jobject local_put_list = env->NewObject(list_cl_, list_ctor_, num_puts);
-  RETURN_ERROR_IF_EXC(env);
-
-  RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, local_put_list, &put_list_));
-
-  return Status::OK;
+void HBaseTableWriter::PutThread() {
+  JNIEnv* env = getJNIEnv();
+  jobject put_list;
+  while (put_queue_->BlockingGet(&put_list)) {
+    bool send;
+    {
+      lock_guard<mutex> l(put_status_lock_);
+      send = put_status_.ok();
+    }
+    if (send) {
+      Status status;
+      if (env == NULL) {
+        status = Status("Error getting JNIEnv.");
+      } else {
+        SCOPED_TIMER(htable_put_timer_);
+        status = table_->Put(put_list);
+      }
+      if (!status.ok()) {
+        {
+          lock_guard<mutex> l(put_status_lock_);
+          put_status_ = status;
+        }
+        // Fail the next AppendRowBatch() instead of letting it block. The remaining
+        // lists are still taken from the queue below, to free them.
+        put_queue_->Shutdown();
+      }
+    }
+    if (env != NULL) env->DeleteGlobalRef(put_list);
+  }
 }
 
-Status HBaseTableWriter::CreatePut(JNIEnv* env, const void* rk, int rk_len,
-                                   jobject* put) {
-  // Create the row key byte array.
-  jbyteArray rk_array;
-  RETURN_IF_ERROR(CreateByteArray(env, rk, rk_len, &rk_array));
+Status HBaseTableWriter::StopPutThread(bool discard) {
+  if (put_thread_.get() != NULL) {
+    if (discard) {
+      lock_guard<mutex> l(put_status_lock_);
+      if (put_status_.ok()) put_status_ = Status::CANCELLED;
+    }
+    put_queue_->Shutdown();
+    put_thread_->Join();
+    put_thread_.reset();
+  }
+  lock_guard<mutex> l(put_status_lock_);
+  return put_status_;
+}
 
-  (*put) = env->NewObject(put_cl_, put_ctor_, rk_array);
-  RETURN_ERROR_IF_EXC(env);
+Status HBaseTableWriter::Flush() {
+  return StopPutThread(false);
+}
 
-  // Add the put to the list.
-  env->CallObjectMethod(put_list_, list_add_id_, *put);
-  RETURN_ERROR_IF_EXC(env);
+Status HBaseTableWriter::CleanUpJni() {
+  JNIEnv* env = getJNIEnv();
+  if (env == NULL) return Status("Error getting JNIEnv.");
 
-  env->DeleteLocalRef(rk_array);
+  if (cf_arrays_ != NULL) {
+    env->DeleteGlobalRef(cf_arrays_);
+    cf_arrays_ = NULL;
+  }
+  if (qual_arrays_ != NULL) {
+    env->DeleteGlobalRef(qual_arrays_);
+    qual_arrays_ = NULL;
+  }
   RETURN_ERROR_IF_EXC(env);
 
   return Status::OK;
@@ -261,15 +322,17 @@ Status HBaseTableWriter::CreateByteArray(JNIEnv* env, const void* data, int data
 }
 
 void HBaseTableWriter::Close(RuntimeState* state) {
+  // The put thread uses the table, so stop it first. Flush() was already called
+  // unless the insert failed or was cancelled.
+  StopPutThread(true);
+
   // Guard against double closing.
   if (table_.get() != NULL) {
     table_->Close(state);
     table_.reset();
   }
 
-  // The jni should already have everything cleaned at this point
-  // but try again just in case there was an error that caused
-  // AppendRowBatch to exit out before calling CleanUpJni.
+  // Release the column family and qualifier arrays.
   Status status = CleanUpJni();
   if (!status.ok()) {
     stringstream ss;
@@ -23,6 +23,7 @@
 #include <utility>
 
 #include "common/status.h"
+#include "util/blocking-queue.h"
 #include "runtime/runtime-state.h"
 #include "runtime/descriptors.h"
 #include "runtime/row-batch.h"
@@ -30,6 +31,8 @@
 
 namespace impala {
 
+class Thread;
+
 // Class to write RowBatches to an HBase table using the java HTable client.
 // This class should only be called from a single sink and should not be
 // shared.
@@ -38,14 +41,30 @@ namespace impala {
 //    writer = new HBaseTableWriter(state, table_desc_, output_exprs_);
 //    writer.Init(state);
 //    writer.AppendRowBatch(batch);
+//    writer.Flush();
+//
+// Each row batch is serialized into a native buffer, which HBasePutBuilder.createPuts()
+// (in the frontend jar) turns into a list of Puts with a single JNI call. The lists are
+// sent to HBase by a separate put thread, through a queue of at most
+// --hbase_max_pending_put_batches lists, so that the fragment thread can produce the
+// next batch while the previous one is written. If that flag is 0, the puts are sent
+// from AppendRowBatch().
 class HBaseTableWriter {
  public:
   HBaseTableWriter(HBaseTableDescriptor* table_desc,
                    const std::vector<Expr*>& output_exprs,
                    RuntimeProfile* profile);
+  ~HBaseTableWriter();
+
+  // Queues the puts for all rows of batch. Returns an error if sending earlier puts
+  // failed.
   Status AppendRowBatch(RowBatch* batch);
 
-  // Calls to Close release the HBaseTable.
+  // Waits until all queued puts were sent and returns whether sending them succeeded.
+  // No rows may be appended afterwards.
+  Status Flush();
+
+  // Calls to Close release the HBaseTable. Puts that are still queued are discarded.
   void Close(RuntimeState* state);
 
   // Create all needed java side objects.
@@ -56,9 +75,24 @@ class HBaseTableWriter {
   static Status InitJNI();
 
  private:
-  // Methods used to create JNI objects.
-  // Create a Put using the supplied row key
-  Status CreatePut(JNIEnv* env, const void* rk, int rk_len, jobject* put);
+  // Appends an int to batch_buffer_.
+  void AppendInt(int32_t value);
+
+  // Appends the length followed by the data to batch_buffer_.
+  void AppendBytes(const void* data, int data_len);
+
+  // Serializes the rows of batch into batch_buffer_, in the layout
+  // HBasePutBuilder.createPuts() expects.
+  Status SerializeRowBatch(RowBatch* batch);
+
+  // Sends the lists of puts queued in put_queue_ to HBase until the queue is shut
+  // down. After an error, or if put_status_ is set to CANCELLED, the remaining lists
+  // are discarded.
+  void PutThread();
+
+  // Stops the put thread after it took all lists from the queue. If 'discard' is true,
+  // the lists it didn't send yet are dropped. Returns put_status_.
+  Status StopPutThread(bool discard);
 
   // Create a byte array containing the string's chars.
   Status CreateByteArray(JNIEnv* env, const std::string& s,
@@ -68,13 +102,7 @@ class HBaseTableWriter {
   Status CreateByteArray(JNIEnv* env, const void* data, int data_len,
                          jbyteArray* j_array);
 
-  // Create an ArrayList<Put> to be passed to put.put(list);
-  // Should be used like:
-  //    CreatePutList(env, limit);
-  Status CreatePutList(JNIEnv* env, int num_puts);
-
-  // Clean up the jni global ref in put_list_, allowing the jni to garbage
-  // collect all of the puts that are created by a writer.
+  // Clean up the jni global refs to the column families and qualifiers.
   Status CleanUpJni();
 
   // Owned by RuntimeState not by this object
@@ -91,32 +119,31 @@ class HBaseTableWriter {
   // output_exprs_byte_sizes_[i] is the byte size of output_exprs_[i]'s type.
   std::vector<int> output_exprs_byte_sizes_;
 
-  // jni ArrayList<Put>
-  jobject put_list_;
-
-  // org.apache.hadoop.hbase.client.Put
-  static jclass put_cl_;
+  // Serialized rows of the current batch.
+  std::vector<uint8_t> batch_buffer_;
 
-  // new Put(byte[])
-  static jmethodID put_ctor_;
+  // Global refs to java ArrayList<Put>s waiting to be sent by put_thread_. NULL if the
+  // puts are sent from AppendRowBatch().
+  boost::scoped_ptr<BlockingQueue<jobject> > put_queue_;
+  boost::scoped_ptr<Thread> put_thread_;
 
-  // Put#add(byte[], byte[], byte[])
-  static jmethodID put_add_id_;
+  // Protects put_status_.
+  boost::mutex put_status_lock_;
 
-  // java.util.ArrayList
-  static jclass list_cl_;
+  // Error sending puts, or CANCELLED if queued puts are to be discarded.
+  Status put_status_;
 
-  // new ArrayList<V>(starting_capacity)
-  static jmethodID list_ctor_;
+  // com.cloudera.impala.util.HBasePutBuilder
+  static jclass put_builder_cl_;
 
-  // ArrayList#add(V);
-  static jmethodID list_add_id_;
+  // HBasePutBuilder.createPuts(byte[], byte[][], byte[][])
+  static jmethodID put_builder_create_puts_id_;
 
-  // cf_arrays_[i-1] is the column family jbyteArray for column i.
-  std::vector<jbyteArray> cf_arrays_;
+  // byte[][] with the column family of column i at index i-1.
+  jobjectArray cf_arrays_;
 
-  // qual_arrays_[i-1] is the column family qualifier jbyteArray for column i.
-  std::vector<jbyteArray> qual_arrays_;
+  // byte[][] with the column family qualifier of column i at index i-1.
+  jobjectArray qual_arrays_;
 
   // Parent table sink's profile
   RuntimeProfile* runtime_profile_;
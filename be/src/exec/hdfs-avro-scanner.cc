@@ -174,12 +174,9 @@ Status HdfsAvroScanner::ParseMetadata() {
           return Status(ss.str());
         }
         RETURN_IF_ERROR(ResolveSchemas(table_schema.schema, file_schema.schema));
-
-        // We currently codegen a function only for the table schema. If this file's
-        // schema is different from the table schema, don't use the codegen'd function and
-        // use the interpreted path instead.
-        avro_header_->use_codegend_decode_avro_data =
-            avro_schema_equal(table_schema.schema, file_schema.schema);
+        VLOG_FILE << stream_->filename() << ": "
+                  << (avro_header_->use_codegend_decode_avro_data ?
+                      "schema matches table schema" : "schema differs from table schema");
 
       } else if (key == AVRO_CODEC_KEY) {
         string avro_codec(reinterpret_cast<char*>(value), value_len);
@@ -253,6 +250,12 @@ Status HdfsAvroScanner::ResolveSchemas(const avro_schema_t& table_schema,
 
   int num_file_fields = avro_schema_record_size(file_schema);
   DCHECK_GT(num_file_fields, 0);
+
+  // The codegen'd function decodes the fields of the table schema in order. It can be
+  // used for this file if every file field is the table field at the same position and
+  // has the same type. Differences that don't affect decoding (e.g. docs, defaults or
+  // namespaces) don't matter.
+  bool layout_matches_table = num_file_fields == num_table_fields;
   for (int i = 0; i < num_file_fields; ++i) {
     avro_datum_t file_field = avro_schema_record_field_get_by_index(file_schema, i);
     SchemaElement element = ConvertSchemaNode(file_field);
@@ -268,9 +271,17 @@ Status HdfsAvroScanner::ResolveSchemas(const avro_schema_t& table_schema,
       // File has extra field, ignore
       element.slot_desc = NULL;
       avro_header_->schema.push_back(element);
+      layout_matches_table = false;
       continue;
     }
     file_field_found[table_field_idx] = true;
+    if (layout_matches_table) {
+      SchemaElement table_element = ConvertSchemaNode(
+          avro_schema_record_field_get_by_index(table_schema, table_field_idx));
+      layout_matches_table = table_field_idx == i
+          && element.type == table_element.type
+          && element.null_union_position == table_element.null_union_position;
+    }
 
     // The table schema's fields define the table column ordering, and the table schema
     // can have more fields than the table has columns. Treat extra fields as
@@ -306,6 +317,7 @@ Status HdfsAvroScanner::ResolveSchemas(const avro_schema_t& table_schema,
     avro_header_->schema.push_back(element);
   }
   DCHECK_EQ(avro_header_->schema.size(), num_file_fields);
+  avro_header_->use_codegend_decode_avro_data = layout_matches_table;
 
   // Check that all materialized fields either appear in the file schema or have a default
   // value in the table schema
@@ -386,6 +398,7 @@ HdfsAvroScanner::SchemaElement HdfsAvroScanner::ConvertSchemaNode(
   SchemaElement element;
   element.type = node->type;
   element.null_union_position = -1;
+  element.slot_desc = NULL;
 
   // Look for special case of [<primitive type>, "null"] union
   if (element.type == AVRO_UNION) {
@@ -416,6 +429,30 @@ HdfsAvroScanner::SchemaElement HdfsAvroScanner::ConvertSchemaNode(
     }
   }
   // TODO: populate children of complex types
+
+  switch (element.type) {
+    case AVRO_BOOLEAN:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroBoolean;
+      break;
+    case AVRO_INT32:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroInt32;
+      break;
+    case AVRO_INT64:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroInt64;
+      break;
+    case AVRO_FLOAT:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroFloat;
+      break;
+    case AVRO_DOUBLE:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroDouble;
+      break;
+    case AVRO_STRING:
+    case AVRO_BYTES:
+      element.read_field_fn = &HdfsAvroScanner::ReadAvroString;
+      break;
+    default:
+      element.read_field_fn = NULL;
+  }
   return element;
 }
 
@@ -480,11 +517,12 @@ Status HdfsAvroScanner::InitNewRange() {
       codegend_decode_avro_data_ = reinterpret_cast<DecodeAvroDataFn>(
           state_->codegen()->JitFunction(codegen_fn_));
     }
+  }
+  if (codegend_decode_avro_data_ != NULL) {
     VLOG(2) << "HdfsAvroScanner (node_id=" << scan_node_->id()
             << ") using llvm codegend functions.";
     scan_node_->IncNumScannersCodegenEnabled();
-  }
-  if (codegend_decode_avro_data_ == NULL) {
+  } else {
     scan_node_->IncNumScannersCodegenDisabled();
   }
 
@@ -559,46 +597,20 @@ Status HdfsAvroScanner::ProcessRange() {
 void HdfsAvroScanner::MaterializeTuple(MemPool* pool, uint8_t** data, Tuple* tuple) {
   BOOST_FOREACH(const SchemaElement& element, avro_header_->schema) {
     const SlotDescriptor* slot_desc = element.slot_desc;
-    bool write_slot = false;
-    void* slot = NULL;
-    PrimitiveType slot_type = INVALID_TYPE;
-    if (slot_desc != NULL) {
-      write_slot = true;
-      slot = tuple->GetSlot(slot_desc->tuple_offset());
-      slot_type = slot_desc->type();
-    }
-
-    avro_type_t type = element.type;
-    if (element.null_union_position != -1
-        && !ReadUnionType(element.null_union_position, data)) {
-      type = AVRO_NULL;
+    if (element.read_field_fn == NULL
+        || (element.null_union_position != -1
+            && !ReadUnionType(element.null_union_position, data))) {
+      DCHECK(element.read_field_fn != NULL || element.type == AVRO_NULL)
+          << "Unsupported SchemaElement: " << element.type;
+      if (slot_desc != NULL) tuple->SetNull(slot_desc->null_indicator_offset());
+      continue;
     }
-
-    switch (type) {
-      case AVRO_NULL:
-        if (slot_desc != NULL) tuple->SetNull(slot_desc->null_indicator_offset());
-        break;
-      case AVRO_BOOLEAN:
-        ReadAvroBoolean(slot_type, data, write_slot, slot, pool);
-        break;
-      case AVRO_INT32:
-        ReadAvroInt32(slot_type, data, write_slot, slot, pool);
-        break;
-      case AVRO_INT64:
-        ReadAvroInt64(slot_type, data, write_slot, slot, pool);
-        break;
-      case AVRO_FLOAT:
-        ReadAvroFloat(slot_type, data, write_slot, slot, pool);
-        break;
-      case AVRO_DOUBLE:
-        ReadAvroDouble(slot_type, data, write_slot, slot, pool);
-        break;
-      case AVRO_STRING:
-      case AVRO_BYTES:
-        ReadAvroString(slot_type, data, write_slot, slot, pool);
-        break;
-      default:
-        DCHECK(false) << "Unsupported SchemaElement: " << type;
+    if (slot_desc == NULL) {
+      // Unmaterialized field, skip it
+      (this->*element.read_field_fn)(INVALID_TYPE, data, false, NULL, pool);
+    } else {
+      (this->*element.read_field_fn)(slot_desc->type(), data, true,
+          tuple->GetSlot(slot_desc->tuple_offset()), pool);
     }
   }
 }
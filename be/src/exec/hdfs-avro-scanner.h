@@ -43,7 +43,10 @@
 // header to decode the serialized objects. If possible, non-materialized columns are
 // skipped without being read. If codegen is enabled, we codegen a function based on the
 // table schema that parses records, materializes them to tuples, and evaluates the
-// conjuncts.
+// conjuncts. The codegen'd function is used for every file whose schema resolves to the
+// same fields as the table schema; other files are decoded by the interpreted
+// MaterializeTuple(), which dispatches on a read function chosen per field when the
+// file header is parsed.
 //
 // The Avro C library is used to parse the file's schema and the table's schema, which are
 // then resolved according to the Avro spec and transformed into our own schema
@@ -106,9 +109,17 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   // All types >= COMPLEX_TYPE are complex (nested) types
   static const avro_type_t COMPLEX_TYPE = AVRO_RECORD;
 
+  // Signature of the ReadAvro<Type>() functions below.
+  typedef void (HdfsAvroScanner::*ReadFieldFn)(
+      PrimitiveType, uint8_t**, bool, void*, MemPool*);
+
   struct SchemaElement {
     avro_type_t type;
 
+    // The ReadAvro<Type>() function that reads (or skips) a value of 'type'. NULL for
+    // AVRO_NULL and complex types.
+    ReadFieldFn read_field_fn;
+
     // Complex types, e.g. records, may have nested child types
     std::vector<SchemaElement> children;
 
@@ -135,7 +146,8 @@ class HdfsAvroScanner : public BaseSequenceScanner {
     Tuple* template_tuple;
 
     // True if this file can use the codegen'd version of DecodeAvroData() (i.e. its
-    // schema matches the table schema), false otherwise.
+    // schema resolves to the same fields, in the same order and with the same types, as
+    // the table schema), false otherwise.
     bool use_codegend_decode_avro_data;
   };
 
@@ -161,7 +173,8 @@ class HdfsAvroScanner : public BaseSequenceScanner {
 
   // Populates avro_header_->schema with the result of resolving the the table's schema
   // with the file's schema. Default values are written to avro_header_->template_tuple
-  // (which is initialized to template_tuple_ if necessary).
+  // (which is initialized to template_tuple_ if necessary). Also sets
+  // avro_header_->use_codegend_decode_avro_data.
   Status ResolveSchemas(const avro_schema_t& table_root,
                         const avro_schema_t& file_root);
 
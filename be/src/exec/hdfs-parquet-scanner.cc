@@ -681,7 +681,7 @@ Status HdfsParquetScanner::AssembleRows() {
       }
 
       row->SetTuple(scan_node_->tuple_idx(), tuple);
-      if (ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, row)) {
+      if (ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, row)) {
         row = next_row(row);
         tuple = next_tuple(tuple);
         ++num_to_commit;
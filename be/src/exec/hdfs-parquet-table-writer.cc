@@ -794,6 +794,9 @@ Status HdfsParquetTableWriter::Finalize() {
   RETURN_IF_ERROR(WriteFileFooter());
   stats_.__set_parquet_stats(parquet_stats_);
   COUNTER_UPDATE(parent_->rows_inserted_counter(), row_count_);
+  // The pages of this file are written. Free their memory rather than keeping it until
+  // the next file, which may come much later if the sink closed this file early.
+  per_file_mem_pool_->FreeAll();
   return Status::OK;
 }
 
@@ -407,14 +407,19 @@ inline Status HdfsRCFileScanner::NextRow() {
 }
 
 Status HdfsRCFileScanner::ReadColumnBuffers() {
+  // Number of bytes of unmaterialized columns preceding the current column. Runs of
+  // unmaterialized columns are skipped at once, which lets the stream avoid reading
+  // them from disk when they are large enough.
+  int skip_len = 0;
   for (int col_idx = 0; col_idx < columns_.size(); ++col_idx) {
     ColumnInfo& column = columns_[col_idx];
     if (!columns_[col_idx].materialize_column) {
       // Not materializing this column, just skip it.
-      RETURN_IF_FALSE(
-          stream_->SkipBytes(column.buffer_len, &parse_status_));
+      skip_len += column.buffer_len;
       continue;
     }
+    RETURN_IF_FALSE(stream_->SkipBytes(skip_len, &parse_status_));
+    skip_len = 0;
 
     // TODO: Stream through these column buffers instead of reading everything
     // in at once.
@@ -439,6 +444,7 @@ Status HdfsRCFileScanner::ReadColumnBuffers() {
           uncompressed_data, column.buffer_len);
     }
   }
+  RETURN_IF_FALSE(stream_->SkipBytes(skip_len, &parse_status_));
   return Status::OK;
 }
 
@@ -530,7 +536,7 @@ Status HdfsRCFileScanner::ProcessRange() {
 
         current_row->SetTuple(scan_node_->tuple_idx(), tuple);
         // Evaluate the conjuncts and add the row to the batch
-        if (ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, current_row)) {
+        if (ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, current_row)) {
           ++num_to_commit;
           current_row = next_row(current_row);
           tuple = next_tuple(tuple);
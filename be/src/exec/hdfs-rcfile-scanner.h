@@ -295,7 +295,8 @@ class HdfsRCFileScanner : public BaseSequenceScanner {
   //   col_bufs_off_
   void GetCurrentKeyBuffer(int col_idx, bool skip_col_data, uint8_t** key_buf_ptr);
 
-  // Read the rowgroup column buffers
+  // Read the rowgroup column buffers. Consecutive unmaterialized columns are skipped
+  // together, so large runs of them are not read from the file.
   // Sets:
   //   column_buffer_: Fills the buffer with either file data or decompressed data.
   Status ReadColumnBuffers();
@@ -32,6 +32,7 @@
 #include "common/logging.h"
 #include "common/object-pool.h"
 #include "exprs/expr.h"
+#include "exprs/expr-context.h"
 #include "runtime/descriptors.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/runtime-state.h"
@@ -71,6 +72,7 @@ HdfsScanNode::HdfsScanNode(ObjectPool* pool, const TPlanNode& tnode,
       reader_context_(NULL),
       tuple_desc_(NULL),
       unknown_disk_id_warned_(false),
+      conjuncts_ctx_(NULL),
       num_conjuncts_copies_(0),
       num_partition_keys_(0),
       disks_accessed_bitmap_(TCounterType::UNIT, 0),
@@ -141,19 +143,6 @@ Status HdfsScanNode::GetNextInternal(RuntimeState* state, RowBatch* row_batch, b
   return Status::OK;
 }
 
-Status HdfsScanNode::CreateConjuncts(vector<Expr*>* expr, bool disable_codegen) {
-  // This is only used when codegen is not possible for this node.  We don't want to
-  // codegen the copy of the expr.
-  // TODO: we really need to stop having to create copies of exprs
-  RETURN_IF_ERROR(Expr::CreateExprTrees(runtime_state_->obj_pool(),
-      thrift_plan_node_->conjuncts, expr));
-  for (int i = 0; i < expr->size(); ++i) {
-    RETURN_IF_ERROR(Expr::Prepare((*expr)[i], runtime_state_, row_desc(),
-        disable_codegen));
-  }
-  return Status::OK;
-}
-
 DiskIoMgr::ScanRange* HdfsScanNode::AllocateScanRange(const char* file, int64_t len,
     int64_t offset, int64_t partition_id, int disk_id) {
   DCHECK_GE(disk_id, -1);
@@ -197,40 +186,22 @@ void* HdfsScanNode::GetFileMetadata(const string& filename) {
 Function* HdfsScanNode::GetCodegenFn(THdfsFileFormat::type type) {
   CodegendFnMap::iterator it = codegend_fn_map_.find(type);
   if (it == codegend_fn_map_.end()) return NULL;
-  if (codegend_conjuncts_thread_safe_) {
-    DCHECK_EQ(it->second.size(), 1);
-    return it->second.front();
-  } else {
-    unique_lock<mutex> l(codgend_fn_map_lock_);
-    // If all the codegen'd fn's are used, return NULL.  This disables codegen for
-    // this scanner.
-    if (it->second.empty()) return NULL;
-    Function* fn = it->second.front();
-    it->second.pop_front();
-    DCHECK(fn != NULL);
-    return fn;
-  }
-}
-
-void HdfsScanNode::ReleaseCodegenFn(THdfsFileFormat::type type, Function* fn) {
-  if (fn == NULL) return;
-  if (codegend_conjuncts_thread_safe_) return;
-
-  CodegendFnMap::iterator it = codegend_fn_map_.find(type);
-  DCHECK(it != codegend_fn_map_.end());
-  unique_lock<mutex> l(codgend_fn_map_lock_);
-  it->second.push_back(fn);
+  // The module may still be optimized in the background (see
+  // PlanFragmentExecutor::OptimizeLlvmModule()). Until then, scan ranges are
+  // processed with the interpreted code.
+  if (!runtime_state_->codegen()->is_optimized()) return NULL;
+  return it->second;
 }
 
-vector<Expr*>* HdfsScanNode::GetConjuncts() {
+ExprContext* HdfsScanNode::GetConjuncts() {
   unique_lock<mutex> l(conjuncts_copies_lock_);
   DCHECK(!conjuncts_copies_.empty());
-  vector<Expr*>* conjuncts = conjuncts_copies_.back();
+  ExprContext* conjuncts = conjuncts_copies_.back();
   conjuncts_copies_.pop_back();
   return conjuncts;
 }
 
-void HdfsScanNode::ReleaseConjuncts(vector<Expr*>* conjuncts) {
+void HdfsScanNode::ReleaseConjuncts(ExprContext* conjuncts) {
   DCHECK(conjuncts != NULL);
   unique_lock<mutex> l(conjuncts_copies_lock_);
   conjuncts_copies_.push_back(conjuncts);
@@ -386,6 +357,9 @@ Status HdfsScanNode::Prepare(RuntimeState* state) {
       file_desc = runtime_state_->obj_pool()->Add(new HdfsFileDesc(path));
       file_descs_[path] = file_desc;
       file_desc->file_length = split.file_length;
+      if (split.__isset.file_compression) {
+        file_desc->file_compression = split.file_compression;
+      }
 
       HdfsPartitionDescriptor* partition_desc =
           hdfs_table_->GetPartition(split.partition_id);
@@ -436,6 +410,12 @@ Status HdfsScanNode::Prepare(RuntimeState* state) {
   PrintHdfsSplitStats(per_volume_stats, &str);
   runtime_profile()->AddInfoString(HDFS_SPLIT_STATS_DESC, str.str());
 
+  // Prepare and codegen the conjuncts once.  The codegen'd fns and the clones of the
+  // context made in CreateConjunctsCopies() are shared by all scanner threads.
+  RETURN_IF_ERROR(ExprContext::Create(runtime_state_->obj_pool(),
+      thrift_plan_node_->conjuncts, runtime_state_, row_desc(), false, &conjuncts_ctx_));
+  conjuncts_copies_.push_back(conjuncts_ctx_);
+
   RETURN_IF_ERROR(CreateConjunctsCopies(THdfsFileFormat::TEXT));
   RETURN_IF_ERROR(CreateConjunctsCopies(THdfsFileFormat::LZO_TEXT));
   RETURN_IF_ERROR(CreateConjunctsCopies(THdfsFileFormat::RC_FILE));
@@ -871,65 +851,44 @@ Status HdfsScanNode::CreateConjunctsCopies(THdfsFileFormat::type format) {
   // Nothing to do
   if (per_type_files_[format].empty()) return Status::OK;
 
-  // This query's current thread quota
-  int num_threads = runtime_state_->resource_pool()->num_available_threads();
   // The number of splits for this format
   int num_splits = 0;
   BOOST_FOREACH(HdfsFileDesc* desc, per_type_files_[format]) {
     num_splits += desc->splits.size();
   }
 
-  int num_codegen_copies;
-  if (!codegend_conjuncts_thread_safe_) {
-    // If the codegen'd conjuncts are not thread safe, we need to make copies of the exprs
-    // and codegen those as well.
-    num_codegen_copies = min(num_threads, num_splits);
-  } else {
-    // Codegen function is thread safe, we can just use a single copy of the conjuncts
-    num_codegen_copies = 1;
-  }
-
-  for (int i = 0; i < num_codegen_copies; ++i) {
-    vector<Expr*> conjuncts_copy;
-    RETURN_IF_ERROR(CreateConjuncts(&conjuncts_copy, false));
-    Function* fn;
-    switch (format) {
-      case THdfsFileFormat::TEXT:
-      case THdfsFileFormat::LZO_TEXT:
-        fn = HdfsTextScanner::Codegen(this, conjuncts_copy);
-        break;
-      case THdfsFileFormat::SEQUENCE_FILE:
-        fn = HdfsSequenceScanner::Codegen(this, conjuncts_copy);
-        break;
-      case THdfsFileFormat::AVRO:
-        fn = HdfsAvroScanner::Codegen(this, conjuncts_copy);
-        break;
-      default:
-        // No codegen for this format
-        fn = NULL;
-    }
-    if (fn != NULL) {
-      codegend_fn_map_[format].push_back(fn);
-    } else {
+  // The codegen'd function evaluates the conjuncts of whichever context the scanner
+  // passes it, so a single function is shared by all the scanners.
+  const vector<Expr*>& conjuncts = conjuncts_ctx_->roots();
+  Function* fn;
+  switch (format) {
+    case THdfsFileFormat::TEXT:
+    case THdfsFileFormat::LZO_TEXT:
+      fn = HdfsTextScanner::Codegen(this, conjuncts);
       break;
-    }
+    case THdfsFileFormat::SEQUENCE_FILE:
+      fn = HdfsSequenceScanner::Codegen(this, conjuncts);
+      break;
+    case THdfsFileFormat::AVRO:
+      fn = HdfsAvroScanner::Codegen(this, conjuncts);
+      break;
+    default:
+      // No codegen for this format
+      fn = NULL;
   }
+  if (fn != NULL) codegend_fn_map_[format] = fn;
 
-  // In addition to the codegen'd functions, create non-codegen'd copies of the conjuncts
-  // for use with EvalConjuncts(), or as a fallback if our thread quota increases or one
-  // of the Codegen() calls fails.
-
-  // Since this is the fallback, create the maximum number of copies we'll possibly
-  // need.
+  // Each scanner thread needs its own context.  Create the maximum number of
+  // contexts we'll possibly need for this format's splits.
   int max_threads = runtime_state_->exec_env()->thread_mgr()->system_threads_quota();
-  int num_noncodegen_copies = min(max_threads, num_splits);
+  int num_copies = min(max_threads, num_splits);
 
   // No point making more copies than the maximum possible number of threads
-  while (num_noncodegen_copies > 0 && conjuncts_copies_.size() < max_threads) {
-    vector<Expr*>* conjuncts = pool_->Add(new vector<Expr*>());
-    RETURN_IF_ERROR(CreateConjuncts(conjuncts, true));
-    conjuncts_copies_.push_back(conjuncts);
-    --num_noncodegen_copies;
+  while (num_copies > 0 && conjuncts_copies_.size() < max_threads) {
+    ExprContext* conjuncts_copy;
+    RETURN_IF_ERROR(conjuncts_ctx_->Clone(runtime_state_, &conjuncts_copy));
+    conjuncts_copies_.push_back(conjuncts_copy);
+    --num_copies;
   }
 
   return Status::OK;
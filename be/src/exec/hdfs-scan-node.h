@@ -39,6 +39,7 @@
 namespace impala {
 
 class DescriptorTbl;
+class ExprContext;
 class HdfsScanner;
 class RowBatch;
 class Status;
@@ -57,9 +58,13 @@ struct HdfsFileDesc {
   // assigned to this node.
   int64_t file_length;
 
+  // Compression of the file, determined by the frontend from the file's suffix.
+  THdfsCompression::type file_compression;
+
   // Splits (i.e. raw byte ranges) for this file, assigned to this scan node.
   std::vector<DiskIoMgr::ScanRange*> splits;
-  HdfsFileDesc(const std::string& filename) : filename(filename) {}
+  HdfsFileDesc(const std::string& filename)
+    : filename(filename), file_compression(THdfsCompression::NONE) {}
 };
 
 // Struct for additional metadata for scan ranges. This contains the partition id
@@ -140,19 +145,19 @@ class HdfsScanNode : public ScanNode {
   }
 
   // Returns the per format codegen'd function.  Scanners call this to get the
-  // codegen function to use.  Returns NULL if codegen should not be used.
+  // codegen function to use.  Returns NULL if codegen should not be used, or if the
+  // module has not been optimized yet, in which case later scanners pick it up.
+  // The function is shared by all scanners, which pass it the expr table of their
+  // conjuncts context (see GetConjuncts()).
   llvm::Function* GetCodegenFn(THdfsFileFormat::type);
 
-  // Each call to GetCodegenFn() must call ReleaseCodegenFn().
-  void ReleaseCodegenFn(THdfsFileFormat::type type, llvm::Function* fn);
-
-  // Returns a prepared copy of the query's conjunct exprs. Scanners use the conjunct
-  // exprs directly when they cannot use a codegen'd function.
-  std::vector<Expr*>* GetConjuncts();
+  // Returns a context with prepared conjunct exprs for the exclusive use of the calling
+  // scanner thread.  The contexts are clones of the one the codegen'd functions were
+  // generated from.
+  ExprContext* GetConjuncts();
 
   // Each call to GetConjuncts() must call ReleaseConjuncts().
-  // TODO: this won't be necessary when exprs are threadsafe.
-  void ReleaseConjuncts(std::vector<Expr*>* conjuncts);
+  void ReleaseConjuncts(ExprContext* conjuncts);
 
   inline void IncNumScannersCodegenEnabled() {
     ++num_scanners_codegen_enabled_;
@@ -248,9 +253,10 @@ class HdfsScanNode : public ScanNode {
 
  private:
   friend class ScannerContext;
+  friend class ScannerContextTest;
 
-  // Cache of the plan node.  This is needed to be able to create a copy of
-  // the conjuncts per scanner since our Exprs are not thread safe.
+  // Cache of the plan node.  This is needed to be able to create the conjuncts
+  // context for the scanners.
   boost::scoped_ptr<TPlanNode> thrift_plan_node_;
 
   RuntimeState* runtime_state_;
@@ -296,24 +302,21 @@ class HdfsScanNode : public ScanNode {
   typedef std::map<THdfsFileFormat::type, HdfsScanner*> ScannerMap;
   ScannerMap scanner_map_;
 
-  // Per scanner type codegen'd fn.  If the scan node only contains conjuncts that are
-  // thread safe, there is only one entry in the list and the function is shared by all
-  // scanners.  If the codegen'd fn is not thread safe, there is a number of these
-  // functions that are shared by the scanner threads.  The number of entries in the list
-  // is based on the maximum number of parallel scan ranges possible, which is in turn
-  // based on the number of cpu cores.
-  boost::mutex codgend_fn_map_lock_;
-  typedef std::map<THdfsFileFormat::type, std::list<llvm::Function*> > CodegendFnMap;
+  // Per scanner type codegen'd fn, shared by all scanners.  Only read after Prepare().
+  typedef std::map<THdfsFileFormat::type, llvm::Function*> CodegendFnMap;
   CodegendFnMap codegend_fn_map_;
 
-  // Copies of the conjuncts for use by the scanners when they cannot use codegen'd
-  // functions.
-  // TODO: We will only need one copy once exprs are threadsafe.
+  // Prepared and codegen'd conjuncts that the codegen'd fns are generated from.  The
+  // scanners evaluate clones of this context, see GetConjuncts().
+  ExprContext* conjuncts_ctx_;
+
+  // Contexts for the scanners that are not in use.  Contains conjuncts_ctx_ and its
+  // clones.
   boost::mutex conjuncts_copies_lock_;
-  std::list<std::vector<Expr*>*> conjuncts_copies_;
+  std::list<ExprContext*> conjuncts_copies_;
 
-  // The number of non-codegen'd conjuncts copies we made in CreateConjunctsCopies(). Used
-  // for debugging.
+  // The number of conjuncts contexts we made in CreateConjunctsCopies(). Used for
+  // debugging.
   int num_conjuncts_copies_;
 
   // Total number of partition slot descriptors, including non-materialized ones.
@@ -410,14 +413,12 @@ class HdfsScanNode : public ScanNode {
   // profile.
   bool counters_running_;
 
-  // Creates the necessary codegen functions and conjuncts copies for format. Codegen
-  // functions are stored in codegend_fn_map_[format] and non-codegen'd conjuncts are
+  // Creates the codegen function for format from conjuncts_ctx_ and clones
+  // conjuncts_ctx_ for the scanner threads that might scan the format's splits.
+  // Codegen functions are stored in codegend_fn_map_[format] and the clones are
   // stored in conjuncts_copies_.
   Status CreateConjunctsCopies(THdfsFileFormat::type format);
 
-  // Create a prepared copy of the conjuncts for this node.
-  Status CreateConjuncts(std::vector<Expr*>* exprs, bool disable_codegen);
-
   // Called when scanner threads are available for this scan node. This will
   // try to spin up as many scanner threads as the quota allows.
   // This is also called whenever a new range is added to the IoMgr to 'pull'
@@ -13,7 +13,10 @@
 // limitations under the License.
 
 #include "exec/hdfs-scanner.h"
+#include "exec/text-converter.h"
+#include "runtime/mem-pool.h"
 #include "runtime/row-batch.h"
+#include "runtime/timestamp-value.h"
 #include "util/string-parser.h"
 #include "runtime/string-value.inline.h"
 
@@ -75,6 +78,23 @@ int HdfsScanner::WriteAlignedTuples(MemPool* pool, TupleRow* tuple_row, int row_
   return tuples_returned;
 }
 
+// Called by the codegen'd WriteCompleteTuple for non-NULL string slots.  This does the
+// same copy as TextConverter::WriteSlot().
+void HdfsScanner::CopyStringSlot(MemPool* pool, StringValue* slot, bool need_escape) {
+  if (slot->len == 0 || (!need_escape && !stream_->compact_data())) return;
+  char* slot_data = reinterpret_cast<char*>(pool->Allocate(slot->len));
+  if (need_escape) {
+    text_converter_->UnescapeString(slot->ptr, slot_data, &slot->len);
+  } else {
+    memcpy(slot_data, slot->ptr, slot->len);
+  }
+  slot->ptr = slot_data;
+}
+
+char* HdfsScanner::GetConjunctsStateData() {
+  return reinterpret_cast<char*>(conjuncts_);
+}
+
 // Define the string parsing functions for llvm.  Stamp out the templated functions
 #ifdef IR_COMPILE
 extern "C"
@@ -111,6 +131,14 @@ double IrStringToDouble(const char* s, int len, StringParser::ParseResult* resul
   return StringParser::StringToFloat<double>(s, len, result);
 }
 
+// Parses directly into the slot.  TimestampValue's constructor is not cross compiled,
+// the call resolves to the native function.
+extern "C"
+bool IrStringToTimestamp(const char* s, int len, TimestampValue* result) {
+  *result = TimestampValue(s, len);
+  return !result->NotADateTime();
+}
+
 extern "C"
 bool IrIsNullString(const char* data, int len) {
   return data == NULL || (len == 2 && data[0] == '\\' && data[1] == 'N');
@@ -25,6 +25,7 @@
 #include "exec/read-write-util.h"
 #include "exec/text-converter.inline.h"
 #include "exprs/expr.h"
+#include "exprs/expr-context.h"
 #include "runtime/descriptors.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/runtime-state.h"
@@ -52,6 +53,7 @@ HdfsScanner::HdfsScanner(HdfsScanNode* scan_node, RuntimeState* state)
     : scan_node_(scan_node),
       state_(state),
       context_(NULL),
+      conjuncts_ctx_(NULL),
       conjuncts_(NULL),
       num_conjuncts_(0),
       codegen_fn_(NULL),
@@ -68,7 +70,7 @@ HdfsScanner::HdfsScanner(HdfsScanNode* scan_node, RuntimeState* state)
 HdfsScanner::~HdfsScanner() {
   DCHECK(codegen_fn_ == NULL);
   DCHECK(batch_ == NULL);
-  DCHECK(conjuncts_ == NULL);
+  DCHECK(conjuncts_ctx_ == NULL);
 }
 
 Status HdfsScanner::Prepare(ScannerContext* context) {
@@ -76,15 +78,17 @@ Status HdfsScanner::Prepare(ScannerContext* context) {
   stream_ = context->GetStream();
   template_tuple_ = scan_node_->InitTemplateTuple(
       state_, context_->partition_descriptor()->partition_key_values());
-  conjuncts_ = scan_node_->GetConjuncts();
-  num_conjuncts_ = conjuncts_->size();
+  conjuncts_ctx_ = scan_node_->GetConjuncts();
+  conjuncts_ = conjuncts_ctx_->expr_table();
+  num_conjuncts_ = conjuncts_ctx_->num_roots();
   StartNewRowBatch();
   return Status::OK;
 }
 
 void HdfsScanner::Close() {
-  if (conjuncts_ != NULL) {
-    scan_node_->ReleaseConjuncts(conjuncts_);
+  if (conjuncts_ctx_ != NULL) {
+    scan_node_->ReleaseConjuncts(conjuncts_ctx_);
+    conjuncts_ctx_ = NULL;
     conjuncts_ = NULL;
   }
 }
@@ -97,14 +101,6 @@ Status HdfsScanner::InitializeWriteTuplesFn(HdfsPartitionDescriptor* partition,
     scan_node_->IncNumScannersCodegenDisabled();
     return Status::OK;
   }
-  if (!scan_node_->tuple_desc()->string_slots().empty() &&
-        ((partition->escape_char() != '\0') || stream_->compact_data())) {
-    // Cannot use codegen if there are strings slots and we need to
-    // compact (i.e. copy) the data.
-    scan_node_->IncNumScannersCodegenDisabled();
-    return Status::OK;
-  }
-
   write_tuples_fn_ = reinterpret_cast<WriteTuplesFn>(
       state_->codegen()->JitFunction(codegen_fn_));
   VLOG(2) << scanner_name << "(node_id=" << scan_node_->id()
@@ -177,7 +173,7 @@ int HdfsScanner::WriteEmptyTuples(RowBatch* row_batch, int num_tuples) {
 
     TupleRow* current_row = row_batch->GetRow(row_idx);
     current_row->SetTuple(scan_node_->tuple_idx(), template_tuple_);
-    if (!ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, current_row)) {
+    if (!ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, current_row)) {
       return 0;
     }
     // Add first tuple
@@ -210,11 +206,11 @@ int HdfsScanner::WriteEmptyTuples(ScannerContext* context,
 
   if (template_tuple_ == NULL) {
     // Must be conjuncts on constant exprs.
-    if (!ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, row)) return 0;
+    if (!ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, row)) return 0;
     return num_tuples;
   } else {
     row->SetTuple(scan_node_->tuple_idx(), template_tuple_);
-    if (!ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, row)) return 0;
+    if (!ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, row)) return 0;
     row = next_row(row);
 
     for (int n = 1; n < num_tuples; ++n) {
@@ -248,7 +244,7 @@ bool HdfsScanner::WriteCompleteTuple(MemPool* pool, FieldLocation* fields,
   }
 
   tuple_row->SetTuple(scan_node_->tuple_idx(), tuple);
-  return ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, tuple_row);
+  return ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, tuple_row);
 }
 
 // Codegen for WriteTuple(above).  The signature matches WriteTuple (except for the
@@ -272,6 +268,7 @@ bool HdfsScanner::WriteCompleteTuple(MemPool* pool, FieldLocation* fields,
 //   %1 = getelementptr { i8, %"struct.impala::StringValue" }** %0, i32 0
 //   store { i8, %"struct.impala::StringValue" }* %tuple_ptr,
 //         { i8, %"struct.impala::StringValue" }** %1
+//   %state_data = call i8* @GetConjunctsStateData(%"class.impala::HdfsScanner"* %this)
 //   br label %parse
 //
 // parse:                                            ; preds = %entry
@@ -287,7 +284,7 @@ bool HdfsScanner::WriteCompleteTuple(MemPool* pool, FieldLocation* fields,
 //   %3 = zext i1 %slot_parse_error to i8
 //   store i8 %3, i8* %slot_error_ptr
 //   %conjunct_eval = call i1 @BinaryPredicate(i8** %tuple_row_ptr,
-//                                             i8* null, i1* %null_ptr)
+//                                             i8* %state_data, i1* %null_ptr)
 //   br i1 %conjunct_eval, label %parse2, label %eval_fail
 //
 // parse2:                                           ; preds = %parse
@@ -301,17 +298,6 @@ bool HdfsScanner::WriteCompleteTuple(MemPool* pool, FieldLocation* fields,
 Function* HdfsScanner::CodegenWriteCompleteTuple(
       HdfsScanNode* node, LlvmCodeGen* codegen, const vector<Expr*>& conjuncts) {
   SCOPED_TIMER(codegen->codegen_timer());
-  // TODO: Timestamp is not yet supported
-  for (int i = 0; i < node->materialized_slots().size(); ++i) {
-    SlotDescriptor* slot_desc = node->materialized_slots()[i];
-    if (slot_desc->type() == TYPE_TIMESTAMP) return NULL;
-  }
-
-  // TODO: can't codegen yet if strings need to be copied
-  if (node->compact_data() && !node->tuple_desc()->string_slots().empty()) {
-    return NULL;
-  }
-
   // Codegen for eval conjuncts
   for (int i = 0; i < conjuncts.size(); ++i) {
     if (conjuncts[i]->codegen_fn() == NULL) return NULL;
@@ -321,7 +307,27 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
 
   // Cast away const-ness.  The codegen only sets the cached typed llvm struct.
   TupleDescriptor* tuple_desc = const_cast<TupleDescriptor*>(node->tuple_desc());
+  StructType* tuple_type = tuple_desc->GenerateLlvmStruct(codegen);
+  if (tuple_type == NULL) return NULL;
+
+  // String slots are copied into the pool (or unescaped) if needed by CopyStringSlot,
+  // after checking that the slot is not NULL.
+  Function* copy_string_fn = NULL;
+  if (!tuple_desc->string_slots().empty()) {
+    copy_string_fn = codegen->GetFunction(IRFunction::HDFS_SCANNER_COPY_STRING_SLOT);
+    if (copy_string_fn == NULL) return NULL;
+  }
+
+  // The conjuncts are passed the expr table of the scanner's conjuncts context.
+  Function* get_state_data_fn = NULL;
+  if (!conjuncts.empty()) {
+    get_state_data_fn =
+        codegen->GetFunction(IRFunction::HDFS_SCANNER_GET_CONJUNCTS_STATE_DATA);
+    if (get_state_data_fn == NULL) return NULL;
+  }
+
   vector<Function*> slot_fns;
+  vector<Function*> is_null_fns;
   for (int i = 0; i < node->materialized_slots().size(); ++i) {
     SlotDescriptor* slot_desc = node->materialized_slots()[i];
     Function* fn = TextConverter::CodegenWriteSlot(codegen, tuple_desc, slot_desc,
@@ -329,6 +335,13 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
         node->hdfs_table()->null_column_value().size(), true);
     if (fn == NULL) return NULL;
     slot_fns.push_back(fn);
+
+    Function* is_null_fn = NULL;
+    if (slot_desc->type() == TYPE_STRING) {
+      is_null_fn = slot_desc->CodegenIsNull(codegen, tuple_type);
+      if (is_null_fn == NULL) return NULL;
+    }
+    is_null_fns.push_back(is_null_fn);
   }
 
   // Compute order to materialize slots.  BE assumes that conjuncts should
@@ -357,9 +370,6 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
   PointerType* mem_pool_ptr_type = PointerType::get(mem_pool_type, 0);
   PointerType* hdfs_scanner_ptr_type = PointerType::get(hdfs_scanner_type, 0);
 
-  // Generate the typed llvm struct for the output tuple
-  StructType* tuple_type = tuple_desc->GenerateLlvmStruct(codegen);
-  if (tuple_type == NULL) return NULL;
   PointerType* tuple_ptr_type = PointerType::get(tuple_type, 0);
 
   // Initialize the function prototype.  This needs to match
@@ -413,6 +423,10 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
   Value* tuple_row_idxs[] = { codegen->GetIntConstant(TYPE_INT, node->tuple_idx()) };
   Value* tuple_in_row_addr = builder.CreateGEP(tuple_row_typed, tuple_row_idxs);
   builder.CreateStore(tuple_arg, tuple_in_row_addr);
+  Value* state_data = NULL;
+  if (get_state_data_fn != NULL) {
+    state_data = builder.CreateCall(get_state_data_fn, args[0], "state_data");
+  }
   builder.CreateBr(parse_block);
 
   // Loop through all the conjuncts in order and materialize slots as necessary
@@ -455,6 +469,10 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
       Value* error_ptr = builder.CreateGEP(errors_arg, error_idxs, "slot_error_ptr");
       Value* data = builder.CreateLoad(data_ptr, "data");
       Value* len = builder.CreateLoad(len_ptr, "len");
+      // len < 0 indicates that the field needs to be unescaped.
+      Value* need_escape = builder.CreateICmpSLT(
+          len, codegen->GetIntConstant(TYPE_INT, 0), "need_escape");
+      len = builder.CreateSelect(need_escape, builder.CreateNeg(len), len, "abs_len");
 
       // Call slot parse function
       Function* slot_fn = slot_fns[slot_idx];
@@ -463,6 +481,25 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
       error_in_row = builder.CreateOr(error_in_row, slot_error, "error_in_row");
       slot_error = builder.CreateZExt(slot_error, codegen->GetType(TYPE_TINYINT));
       builder.CreateStore(slot_error, error_ptr);
+
+      if (is_null_fns[slot_idx] != NULL) {
+        // Copy or unescape the string if it was written.
+        BasicBlock* copy_string_block =
+            BasicBlock::Create(context, "copy_string", fn, eval_fail_block);
+        BasicBlock* string_done_block =
+            BasicBlock::Create(context, "string_done", fn, eval_fail_block);
+        Value* is_null = builder.CreateCall(is_null_fns[slot_idx], tuple_arg, "is_null");
+        builder.CreateCondBr(is_null, string_done_block, copy_string_block);
+
+        builder.SetInsertPoint(copy_string_block);
+        SlotDescriptor* slot_desc = node->materialized_slots()[slot_idx];
+        Value* slot = builder.CreateStructGEP(tuple_arg, slot_desc->field_idx(), "slot");
+        slot = builder.CreateBitCast(
+            slot, copy_string_fn->getFunctionType()->getParamType(2));
+        builder.CreateCall4(copy_string_fn, args[0], args[1], slot, need_escape);
+        builder.CreateBr(string_done_block);
+        builder.SetInsertPoint(string_done_block);
+      }
     }
 
     if (conjunct_idx == conjuncts.size()) {
@@ -478,11 +515,7 @@ Function* HdfsScanner::CodegenWriteCompleteTuple(
       parse_block = BasicBlock::Create(context, "parse", fn, eval_fail_block);
       Function* conjunct_fn = conjuncts[conjunct_idx]->codegen_fn();
 
-      Value* conjunct_args[] = {
-        tuple_row_arg,
-        ConstantPointerNull::get(codegen->ptr_type()),
-        is_null_ptr
-      };
+      Value* conjunct_args[] = { tuple_row_arg, state_data, is_null_ptr };
       Value* result = builder.CreateCall(conjunct_fn, conjunct_args, "conjunct_eval");
 
       builder.CreateCondBr(result, parse_block, eval_fail_block);
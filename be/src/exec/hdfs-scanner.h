@@ -33,10 +33,12 @@ namespace impala {
 class Compression;
 class DescriptorTbl;
 class Expr;
+class ExprContext;
 class HdfsPartitionDescriptor;
 class MemPool;
 class SlotDescriptor;
 class Status;
+struct StringValue;
 class TextConverter;
 class Tuple;
 class TupleDescriptor;
@@ -144,11 +146,15 @@ class HdfsScanner {
   // The first stream for context_
   ScannerContext::Stream* stream_;
 
-  // Conjuncts for this scanner.  Multiple scanners from multiple threads can
-  // be scanning and Exprs are currently not thread safe.
-  std::vector<Expr*>* conjuncts_;
+  // Conjuncts context for this scanner.  Multiple scanners from multiple threads can
+  // be scanning and each evaluates its own clone of the conjuncts.
+  ExprContext* conjuncts_ctx_;
 
-  // Cache of conjuncts_->size()
+  // Cache of conjuncts_ctx_->expr_table(). The first num_conjuncts_ entries are the
+  // conjuncts; the table is passed as 'state_data' to the codegen'd conjuncts.
+  Expr** conjuncts_;
+
+  // Cache of conjuncts_ctx_->num_roots()
   int num_conjuncts_;
 
   // Codegen fn to use.  NULL if codegen is not enabled for this scanner.
@@ -307,6 +313,15 @@ class HdfsScanner {
       TupleRow* tuple_row, Tuple* template_tuple, uint8_t* error_fields,
       uint8_t* error_in_row);
 
+  // Copies the string in 'slot' into 'pool' if the stream's data is compact, or
+  // unescapes it into 'pool' if 'need_escape' is set, as TextConverter::WriteSlot()
+  // does. Called by the codegen'd WriteCompleteTuple (cross compiled to IR).
+  void CopyStringSlot(MemPool* pool, StringValue* slot, bool need_escape);
+
+  // Returns conjuncts_ as the 'state_data' argument for the codegen'd conjuncts.
+  // Called by the codegen'd WriteCompleteTuple (cross compiled to IR).
+  char* GetConjunctsStateData();
+
   // Codegen function to replace WriteCompleteTuple. Should behave identically
   // to WriteCompleteTuple.
   static llvm::Function* CodegenWriteCompleteTuple(HdfsScanNode*, LlvmCodeGen*,
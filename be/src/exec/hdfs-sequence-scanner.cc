@@ -20,6 +20,7 @@
 #include "exec/scanner-context.inline.h"
 #include "exec/text-converter.inline.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
 #include "runtime/runtime-state.h"
 #include "runtime/tuple.h"
 #include "runtime/tuple-row.h"
@@ -41,11 +42,32 @@ HdfsSequenceScanner::HdfsSequenceScanner(HdfsScanNode* scan_node, RuntimeState*
     : BaseSequenceScanner(scan_node, state),
       unparsed_data_buffer_(NULL),
       num_buffered_records_in_compressed_block_(0) {
+  for (int i = 0; i < 2; ++i) {
+    prefetched_blocks_[i].num_records = 0;
+    prefetched_blocks_[i].in_flight = false;
+  }
 }
 
 HdfsSequenceScanner::~HdfsSequenceScanner() {
 }
 
+void HdfsSequenceScanner::Close() {
+  WaitForPrefetchedBlocks();
+  CloseBlockDecompressors();
+  BaseSequenceScanner::Close();
+}
+
+void HdfsSequenceScanner::CloseBlockDecompressors() {
+  for (int i = 0; i < 2; ++i) {
+    PrefetchedBlock* block = &prefetched_blocks_[i];
+    DCHECK(!block->in_flight);
+    if (block->decompressor.get() != NULL) block->decompressor->Close();
+    if (block->output_pool.get() != NULL) AttachPool(block->output_pool.get());
+    if (block->input_pool.get() != NULL) block->input_pool->FreeAll();
+    block->decompressor.reset();
+  }
+}
+
 // Codegen for materialized parsed data into tuples.
 Function* HdfsSequenceScanner::Codegen(HdfsScanNode* node,
     const vector<Expr*>& conjuncts) {
@@ -76,6 +98,17 @@ Status HdfsSequenceScanner::InitNewRange() {
     RETURN_IF_ERROR(Codec::CreateDecompressor(
         data_buffer_pool_.get(), stream_->compact_data(),
         header_->codec, &decompressor_));
+    if (!seq_header->is_row_compressed &&
+        state_->exec_env()->decompression_thread_pool() != NULL) {
+      CloseBlockDecompressors();
+      for (int i = 0; i < 2; ++i) {
+        PrefetchedBlock* block = &prefetched_blocks_[i];
+        block->input_pool.reset(new MemPool(scan_node_->mem_tracker()));
+        block->output_pool.reset(new MemPool(scan_node_->mem_tracker()));
+        RETURN_IF_ERROR(Codec::CreateDecompressor(block->output_pool.get(),
+            stream_->compact_data(), header_->codec, &block->decompressor));
+      }
+    }
   }
 
   // Initialize codegen fn
@@ -162,10 +195,19 @@ inline Status HdfsSequenceScanner::GetRecord(uint8_t** record_ptr,
 //   c. Materialize those field locations to row batches
 // 3. Read the sync indicator and check the sync block
 // This mimics the technique for text.
+// If there is a decompression thread pool, step 1 for the next block is done by the
+// pool during step 2 for the current one.
 // This function only returns on error or when the entire scan range is complete.
 Status HdfsSequenceScanner::ProcessBlockCompressedScanRange() {
   DCHECK(header_->is_compressed);
 
+  DecompressionThreadPool* pool = state_->exec_env()->decompression_thread_pool();
+  if (pool != NULL) {
+    Status status = ProcessBlockCompressedScanRangeAsync(pool);
+    WaitForPrefetchedBlocks();
+    return status;
+  }
+
   while (!finished()) {
     if (scan_node_->ReachedLimit()) return Status::OK;
 
@@ -182,24 +224,122 @@ Status HdfsSequenceScanner::ProcessBlockCompressedScanRange() {
     if (stream_->eof()) return Status::OK;
 
     // Step 3
-    int sync_indicator;
-    RETURN_IF_FALSE(stream_->ReadInt(&sync_indicator, &parse_status_));
-    if (sync_indicator != -1) {
-      if (state_->LogHasSpace()) {
-        stringstream ss;
-        ss << "Expecting sync indicator (-1) at file offset "
-           << (stream_->file_offset() - sizeof(int)) << ".  "
-           << "Sync indicator found " << sync_indicator << ".";
-        state_->LogError(ss.str());
+    RETURN_IF_ERROR(ReadBlockSync());
+  }
+
+  return Status::OK;
+}
+
+Status HdfsSequenceScanner::ProcessBlockCompressedScanRangeAsync(
+    DecompressionThreadPool* pool) {
+  if (finished() || scan_node_->ReachedLimit()) return Status::OK;
+  int current = 0;
+  RETURN_IF_ERROR(StartBlockDecompression(pool, &prefetched_blocks_[current]));
+
+  while (true) {
+    PrefetchedBlock* block = &prefetched_blocks_[current];
+    RETURN_IF_ERROR(WaitForBlock(block));
+
+    // Read ahead the next block, unless this is the last one of the scan range.
+    // SequenceFiles don't end with syncs. An error while reading ahead is only returned
+    // after this block is parsed, so that its rows are not lost when the caller skips
+    // to the next sync.
+    Status read_ahead_status;
+    bool next_block_started = false;
+    if (!stream_->eof()) {
+      read_ahead_status = ReadBlockSync();
+      if (read_ahead_status.ok() && !finished() && !scan_node_->ReachedLimit()) {
+        read_ahead_status =
+            StartBlockDecompression(pool, &prefetched_blocks_[1 - current]);
+        next_block_started = read_ahead_status.ok();
       }
-      return Status("Bad sync hash");
     }
-    RETURN_IF_ERROR(ReadSync());
+
+    while (num_buffered_records_in_compressed_block_ > 0) {
+      Status status = ProcessDecompressedBlock();
+      if (status.ok()) continue;
+      // After an error, the caller skips to the next sync in the stream, which would
+      // skip the block that was read ahead as well. The sync preceding that block was
+      // valid, so recover by continuing with it instead.
+      if (!next_block_started) return status;
+      RETURN_IF_ERROR(LogParseError(status));
+      parse_status_ = Status::OK;
+      num_buffered_records_in_compressed_block_ = 0;
+    }
+    // Pass the decompressed data to the batch if it is referenced by the tuples.
+    if (!stream_->compact_data()) AttachPool(block->output_pool.get());
+
+    if (!next_block_started) return read_ahead_status;
+    current = 1 - current;
   }
+}
 
+Status HdfsSequenceScanner::StartBlockDecompression(DecompressionThreadPool* pool,
+    PrefetchedBlock* block) {
+  DCHECK(!block->in_flight);
+  uint8_t* compressed_data;
+  int block_size;
+  RETURN_IF_ERROR(
+      ReadCompressedBlockData(&block->num_records, &compressed_data, &block_size));
+  if (block->num_records < 0) return parse_status_;
+
+  // The io buffer backing compressed_data may be recycled once the stream moves on.
+  // Blocks can be large, so use TryAllocate() to avoid going way over the mem limit.
+  block->input_pool->Clear();
+  uint8_t* input = block->input_pool->TryAllocate(block_size);
+  if (block_size > 0 && input == NULL) {
+    return state_->SetMemLimitExceeded(scan_node_->mem_tracker(), block_size);
+  }
+  memcpy(input, compressed_data, block_size);
+
+  block->task.reset(new DecompressionTask);
+  block->task->decompressor = block->decompressor.get();
+  block->task->timer = decompress_timer_;
+  block->task->input_length = block_size;
+  block->task->input = input;
+  block->task->output_length = 0;
+  block->task->output = NULL;
+  block->in_flight = true;
+  // Offer() only fails if the pool is shut down, decompress the block here then.
+  if (!pool->Offer(block->task.get())) DecompressBlock(block->task.get());
   return Status::OK;
 }
 
+Status HdfsSequenceScanner::WaitForBlock(PrefetchedBlock* block) {
+  DCHECK(block->in_flight);
+  Status status = block->task->done.Get();
+  block->in_flight = false;
+  RETURN_IF_ERROR(status);
+  unparsed_data_buffer_ = block->task->output;
+  next_record_in_compressed_block_ = unparsed_data_buffer_;
+  num_buffered_records_in_compressed_block_ = block->num_records;
+  return Status::OK;
+}
+
+void HdfsSequenceScanner::WaitForPrefetchedBlocks() {
+  for (int i = 0; i < 2; ++i) {
+    if (!prefetched_blocks_[i].in_flight) continue;
+    prefetched_blocks_[i].task->done.Get();
+    prefetched_blocks_[i].in_flight = false;
+  }
+}
+
+Status HdfsSequenceScanner::ReadBlockSync() {
+  int sync_indicator;
+  RETURN_IF_FALSE(stream_->ReadInt(&sync_indicator, &parse_status_));
+  if (sync_indicator != -1) {
+    if (state_->LogHasSpace()) {
+      stringstream ss;
+      ss << "Expecting sync indicator (-1) at file offset "
+         << (stream_->file_offset() - sizeof(int)) << ".  "
+         << "Sync indicator found " << sync_indicator << ".";
+      state_->LogError(ss.str());
+    }
+    return Status("Bad sync hash");
+  }
+  return ReadSync();
+}
+
 Status HdfsSequenceScanner::ProcessDecompressedBlock() {
   MemPool* pool;
   TupleRow* tuple_row;
@@ -452,13 +592,35 @@ Status HdfsSequenceScanner::ReadCompressedBlock() {
   if (!stream_->compact_data()) {
     AttachPool(data_buffer_pool_.get());
   }
-  RETURN_IF_FALSE(stream_->ReadVLong(
-      &num_buffered_records_in_compressed_block_, &parse_status_));
-  if (num_buffered_records_in_compressed_block_ < 0) {
+
+  uint8_t* compressed_data = NULL;
+  int block_size = 0;
+  RETURN_IF_ERROR(ReadCompressedBlockData(
+      &num_buffered_records_in_compressed_block_, &compressed_data, &block_size));
+  if (num_buffered_records_in_compressed_block_ < 0) return parse_status_;
+
+  {
+    int len;
+    SCOPED_TIMER(decompress_timer_);
+    RETURN_IF_ERROR(decompressor_->ProcessBlock(false, block_size, compressed_data,
+                                                &len, &unparsed_data_buffer_));
+    next_record_in_compressed_block_ = unparsed_data_buffer_;
+  }
+
+  return Status::OK;
+}
+
+Status HdfsSequenceScanner::ReadCompressedBlockData(int64_t* num_records,
+    uint8_t** data, int* size) {
+  // Only set once the whole block was read, so callers can tell a block cut short by
+  // the end of the stream.
+  *num_records = -1;
+  int64_t block_records;
+  RETURN_IF_FALSE(stream_->ReadVLong(&block_records, &parse_status_));
+  if (block_records < 0) {
     if (state_->LogHasSpace()) {
       stringstream ss;
-      ss << "Bad compressed block record count: "
-         << num_buffered_records_in_compressed_block_;
+      ss << "Bad compressed block record count: " << block_records;
       state_->LogError(ss.str());
     }
     return Status("bad record count");
@@ -483,17 +645,9 @@ Status HdfsSequenceScanner::ReadCompressedBlock() {
     return Status(ss.str());
   }
 
-  uint8_t* compressed_data = NULL;
-  RETURN_IF_FALSE(stream_->ReadBytes(block_size, &compressed_data, &parse_status_));
-
-  {
-    int len;
-    SCOPED_TIMER(decompress_timer_);
-    RETURN_IF_ERROR(decompressor_->ProcessBlock(false, block_size, compressed_data,
-                                                &len, &unparsed_data_buffer_));
-    next_record_in_compressed_block_ = unparsed_data_buffer_;
-  }
-
+  RETURN_IF_FALSE(stream_->ReadBytes(block_size, data, &parse_status_));
+  *size = block_size;
+  *num_records = block_records;
   return Status::OK;
 }
 
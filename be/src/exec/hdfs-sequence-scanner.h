@@ -148,10 +148,10 @@
 // Text ::= VInt, Chars (Length prefixed UTF-8 characters)
 
 #include "exec/base-sequence-scanner.h"
+#include "util/codec.h"
 
 namespace impala {
 
-class Codec;
 class DelimitedTextParser;
 
 class HdfsSequenceScanner : public BaseSequenceScanner {
@@ -166,6 +166,7 @@ class HdfsSequenceScanner : public BaseSequenceScanner {
   
   // Implementation of HdfsScanner interface.
   virtual Status Prepare(ScannerContext* context);
+  virtual void Close();
 
   // Codegen writing tuples and evaluating predicates
   static llvm::Function* Codegen(HdfsScanNode*, const std::vector<Expr*>& conjuncts);
@@ -199,10 +200,22 @@ class HdfsSequenceScanner : public BaseSequenceScanner {
   // more common and can be parsed more efficiently in larger pieces.
   Status ProcessBlockCompressedScanRange();
 
+  // Same as ProcessBlockCompressedScanRange(), but each block is decompressed by 'pool'
+  // while the previous block is parsed. Blocks may still be in flight on return.
+  Status ProcessBlockCompressedScanRangeAsync(DecompressionThreadPool* pool);
+
   // Read a compressed block. Does NOT read sync or -1 marker preceding sync.
   // Decompress to unparsed_data_buffer_ allocated from unparsed_data_buffer_pool_.
   Status ReadCompressedBlock();
 
+  // Reads the header and the compressed value buffer of the next block, up to (not
+  // including) the sync. 'data' points into the stream and is only valid until the
+  // stream is read again.
+  Status ReadCompressedBlockData(int64_t* num_records, uint8_t** data, int* size);
+
+  // Reads the -1 marker and the sync following a compressed block.
+  Status ReadBlockSync();
+
   // Utility function for parsing next_record_in_compressed_block_. Called by
   // ProcessBlockCompressedScanRange.
   Status ProcessDecompressedBlock();
@@ -253,6 +266,41 @@ class HdfsSequenceScanner : public BaseSequenceScanner {
 
   // Next record from block compressed data.
   uint8_t* next_record_in_compressed_block_;
+
+  // A compressed block that is decompressed by the decompression thread pool while the
+  // previous block is parsed. Only used for block compressed files and only if
+  // ExecEnv::decompression_thread_pool() is set.
+  struct PrefetchedBlock {
+    // Holds a copy of the compressed block, which the worker reads from after the
+    // stream moved on.
+    boost::scoped_ptr<MemPool> input_pool;
+    // Decompressor (and pool for its output) that is only used for this block.
+    boost::scoped_ptr<MemPool> output_pool;
+    boost::scoped_ptr<Codec> decompressor;
+    boost::scoped_ptr<DecompressionTask> task;
+    int64_t num_records;
+    // True if 'task' was handed to the pool and WaitForBlock() wasn't called yet.
+    bool in_flight;
+  };
+
+  // Blocks are decompressed into these two slots in turns.
+  PrefetchedBlock prefetched_blocks_[2];
+
+  // Reads the next compressed block from the stream into 'block' and starts
+  // decompressing it in 'pool'.
+  Status StartBlockDecompression(DecompressionThreadPool* pool, PrefetchedBlock* block);
+
+  // Waits for 'block' to be decompressed and makes it the block to be parsed by
+  // ProcessDecompressedBlock().
+  Status WaitForBlock(PrefetchedBlock* block);
+
+  // Waits for all in flight blocks, whose buffers must not be freed before the
+  // workers are done with them.
+  void WaitForPrefetchedBlocks();
+
+  // Closes the decompressors of prefetched_blocks_ and frees their buffers, or passes
+  // them to the row batch if tuples may reference them. No block may be in flight.
+  void CloseBlockDecompressors();
 };
 
 } // namespace impala
@@ -28,18 +28,30 @@
 #include "runtime/mem-tracker.h"
 #include "util/url-coding.h"
 
+#include <algorithm>
 #include <vector>
 #include <sstream>
 #include <hdfs.h>
+#include <boost/scoped_array.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <stdlib.h>
+#include <gflags/gflags.h>
 
 #include "gen-cpp/Data_types.h"
 
 using namespace std;
+using namespace boost;
 using namespace boost::posix_time;
 
+DEFINE_int32(max_open_insert_partition_files, 0, "(Advanced) The maximum number of "
+    "files a table sink keeps open while inserting into many partitions. If a batch has "
+    "rows for more partitions, the files of the least recently used partitions are "
+    "finalized, and new files are started for them if they get more rows later. 0 means "
+    "no limit.");
+
+DECLARE_int32(num_table_writer_threads);
+
 namespace impala {
 
 HdfsTableSink::HdfsTableSink(const RowDescriptor& row_desc,
@@ -49,7 +61,10 @@ HdfsTableSink::HdfsTableSink(const RowDescriptor& row_desc,
        table_id_(tsink.table_sink.target_table_id),
        select_list_texprs_(select_list_texprs),
        partition_key_texprs_(tsink.table_sink.hdfs_table_sink.partition_key_exprs),
-       overwrite_(tsink.table_sink.hdfs_table_sink.overwrite) {
+       overwrite_(tsink.table_sink.hdfs_table_sink.overwrite),
+       num_shards_(1),
+       next_shard_(0),
+       batch_seq_(0) {
   DCHECK(tsink.__isset.table_sink);
   stringstream unique_id_ss;
   unique_id_ss << unique_id.hi << "-" << unique_id.lo;
@@ -57,8 +72,8 @@ HdfsTableSink::HdfsTableSink(const RowDescriptor& row_desc,
 }
 
 OutputPartition::OutputPartition()
-    : hdfs_connection(NULL), tmp_hdfs_file(NULL), num_rows(0), num_files(0),
-      partition_descriptor(NULL) {
+    : hdfs_connection(NULL), tmp_hdfs_file(NULL), num_rows(0), num_files(0), shard(0),
+      last_batch_seq(-1), partition_descriptor(NULL) {
 }
 
 Status HdfsTableSink::PrepareExprs(RuntimeState* state) {
@@ -120,6 +135,18 @@ Status HdfsTableSink::Init(RuntimeState* state) {
 
   PrepareExprs(state);
 
+  // Only dynamic partition inserts have more than one partition to write in parallel.
+  if (!dynamic_partition_key_exprs_.empty() &&
+      state->exec_env()->table_writer_thread_pool() != NULL) {
+    num_shards_ = max(FLAGS_num_table_writer_threads, 1);
+  }
+  shard_output_exprs_.resize(num_shards_ - 1);
+  for (int i = 0; i < shard_output_exprs_.size(); ++i) {
+    RETURN_IF_ERROR(Expr::CreateExprTrees(state->obj_pool(), select_list_texprs_,
+        &shard_output_exprs_[i]));
+    RETURN_IF_ERROR(Expr::Prepare(shard_output_exprs_[i], state, row_desc_, true));
+  }
+
   // Get file format for default partition in table descriptor, and
   // build a map from partition key values to partition descriptor for
   // multiple output format support. The map is keyed on the
@@ -262,7 +289,8 @@ Status HdfsTableSink::CreateNewTmpFile(RuntimeState* state,
   SCOPED_TIMER(ADD_TIMER(profile(), "TmpFileCreateTimer"));
   stringstream filename;
   filename << output_partition->tmp_hdfs_file_name_template
-           << "." << output_partition->num_files;
+           << "." << output_partition->num_files
+           << output_partition->writer->file_extension();
   output_partition->current_file_name = filename.str();
   // Check if tmp_hdfs_file_name_template exists.
   const char* tmp_hdfs_file_name_template_cstr =
@@ -285,8 +313,12 @@ Status HdfsTableSink::CreateNewTmpFile(RuntimeState* state,
 
   // Save the ultimate destination for this file (it will be moved by the coordinator)
   stringstream dest;
-  dest << output_partition->hdfs_file_name_template << "." << output_partition->num_files;
-  (*state->hdfs_files_to_move())[output_partition->current_file_name] = dest.str();
+  dest << output_partition->hdfs_file_name_template << "." << output_partition->num_files
+       << output_partition->writer->file_extension();
+  {
+    lock_guard<mutex> l(state_lock_);
+    (*state->hdfs_files_to_move())[output_partition->current_file_name] = dest.str();
+  }
 
   ++output_partition->num_files;
   output_partition->num_rows = 0;
@@ -302,18 +334,20 @@ Status HdfsTableSink::InitOutputPartition(RuntimeState* state,
     const HdfsPartitionDescriptor& partition_descriptor,
     OutputPartition* output_partition) {
   output_partition->hdfs_connection = hdfs_connection_;
+  const vector<Expr*>& output_exprs = output_partition->shard == 0 ?
+      output_exprs_ : shard_output_exprs_[output_partition->shard - 1];
 
   switch (partition_descriptor.file_format()) {
     case THdfsFileFormat::TEXT: {
       output_partition->writer.reset(
           new HdfsTextTableWriter(this, state, output_partition,
-                                  &partition_descriptor, table_desc_, output_exprs_));
+                                  &partition_descriptor, table_desc_, output_exprs));
       break;
     }
     case THdfsFileFormat::PARQUET: {
       output_partition->writer.reset(
           new HdfsParquetTableWriter(this, state, output_partition,
-                                    &partition_descriptor, table_desc_, output_exprs_));
+                                    &partition_descriptor, table_desc_, output_exprs));
       break;
     }
     default:
@@ -329,7 +363,7 @@ Status HdfsTableSink::InitOutputPartition(RuntimeState* state,
   }
   RETURN_IF_ERROR(output_partition->writer->Init());
   output_partition->partition_descriptor = &partition_descriptor;
-  return CreateNewTmpFile(state, output_partition);
+  return Status::OK;
 }
 
 void HdfsTableSink::GetHashTblKey(const vector<Expr*>& exprs, string* key) {
@@ -357,6 +391,8 @@ inline Status HdfsTableSink::GetOutputPartition(
     }
 
     OutputPartition* partition = state->obj_pool()->Add(new OutputPartition());
+    partition->shard = next_shard_;
+    next_shard_ = (next_shard_ + 1) % num_shards_;
     BuildHdfsFileNames(partition);
     Status status = InitOutputPartition(state, *partition_descriptor, partition);
     if (!status.ok()) {
@@ -367,6 +403,7 @@ inline Status HdfsTableSink::GetOutputPartition(
       return status;
     }
 
+    lock_guard<mutex> l(state_lock_);
     // Save the partition name so that the coordinator can create partition
     // directory structure if needed
     if (overwrite_) {
@@ -389,26 +426,17 @@ inline Status HdfsTableSink::GetOutputPartition(
 
 Status HdfsTableSink::Send(RuntimeState* state, RowBatch* batch, bool eos) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
+  ++batch_seq_;
 
   // If there are no partition keys then just pass the whole batch to one partition.
   if (dynamic_partition_key_exprs_.empty()) {
     // If there are no dynamic keys just use an empty key.
     PartitionPair* partition_pair;
     RETURN_IF_ERROR(GetOutputPartition(state, "", &partition_pair));
-    // Pass the row batch to the writer. If new_file is returned true then the current
-    // file is finalized and a new file is opened.
-    // The writer tracks where it is in the batch when it returns with new_file set.
-    OutputPartition* output_partition = partition_pair->first;
-    bool new_file;
-    do {
-      RETURN_IF_ERROR(output_partition->writer->AppendRowBatch(
-              batch, partition_pair->second, &new_file));
-      if (new_file) {
-        RETURN_IF_ERROR(FinalizePartitionFile(state, output_partition));
-        RETURN_IF_ERROR(CreateNewTmpFile(state, output_partition));
-      }
-    } while (new_file);
+    RETURN_IF_ERROR(WritePartition(state, batch, partition_pair));
   } else {
+    // Partitions with rows in this batch, in the order of their first row.
+    vector<PartitionPair*> partitions;
     for (int i = 0; i < batch->num_rows(); ++i) {
       current_row_ = batch->GetRow(i);
 
@@ -416,24 +444,11 @@ Status HdfsTableSink::Send(RuntimeState* state, RowBatch* batch, bool eos) {
       GetHashTblKey(dynamic_partition_key_exprs_, &key);
       PartitionPair* partition_pair = NULL;
       RETURN_IF_ERROR(GetOutputPartition(state, key, &partition_pair));
+      if (partition_pair->second.empty()) partitions.push_back(partition_pair);
       partition_pair->second.push_back(i);
     }
-    for (PartitionMap::iterator partition = partition_keys_to_output_partitions_.begin();
-         partition != partition_keys_to_output_partitions_.end(); ++partition) {
-      OutputPartition* output_partition = partition->second.first;
-      if (partition->second.second.empty()) continue;
-
-      bool new_file;
-      do {
-        RETURN_IF_ERROR(output_partition->writer->AppendRowBatch(
-                batch, partition->second.second, &new_file));
-        if (new_file) {
-          RETURN_IF_ERROR(FinalizePartitionFile(state, output_partition));
-          RETURN_IF_ERROR(CreateNewTmpFile(state, output_partition));
-        }
-      } while (new_file);
-      partition->second.second.clear();
-    }
+    RETURN_IF_ERROR(CloseLeastRecentlyUsedFiles(state, partitions));
+    RETURN_IF_ERROR(WritePartitions(state, batch, partitions));
   }
 
   if (eos) {
@@ -448,18 +463,140 @@ Status HdfsTableSink::Send(RuntimeState* state, RowBatch* batch, bool eos) {
   return Status::OK;
 }
 
+Status HdfsTableSink::WritePartition(RuntimeState* state, RowBatch* batch,
+                                     PartitionPair* partition_pair) {
+  OutputPartition* output_partition = partition_pair->first;
+  if (output_partition->tmp_hdfs_file == NULL) {
+    RETURN_IF_ERROR(CreateNewTmpFile(state, output_partition));
+  }
+  // Pass the row batch to the writer. If new_file is returned true then the current
+  // file is finalized and a new file is opened.
+  // The writer tracks where it is in the batch when it returns with new_file set.
+  bool new_file;
+  do {
+    RETURN_IF_ERROR(output_partition->writer->AppendRowBatch(
+            batch, partition_pair->second, &new_file));
+    if (new_file) {
+      RETURN_IF_ERROR(FinalizePartitionFile(state, output_partition));
+      RETURN_IF_ERROR(CreateNewTmpFile(state, output_partition));
+    }
+  } while (new_file);
+  partition_pair->second.clear();
+  return Status::OK;
+}
+
+void RunPartitionWriteTask(PartitionWriteTask* task) {
+  Status status;
+  for (int i = 0; i < task->partitions.size() && status.ok(); ++i) {
+    status = task->sink->WritePartition(task->state, task->batch, task->partitions[i]);
+  }
+  task->done.Set(status);
+}
+
+// Utility method to convert from a thread-pool signature to RunPartitionWriteTask()
+static void TableWriterThreadPoolHelper(int thread_id, PartitionWriteTask* const& task) {
+  RunPartitionWriteTask(task);
+}
+
+TableWriterThreadPool* CreateTableWriterThreadPool(const string& name,
+    uint32_t num_threads, uint32_t max_queue_length) {
+  return new TableWriterThreadPool(name, "table-writer", num_threads, max_queue_length,
+      &TableWriterThreadPoolHelper);
+}
+
+Status HdfsTableSink::WritePartitions(RuntimeState* state, RowBatch* batch,
+                                      const vector<PartitionPair*>& partitions) {
+  TableWriterThreadPool* pool = state->exec_env()->table_writer_thread_pool();
+  if (num_shards_ == 1 || pool == NULL || partitions.size() <= 1) {
+    for (int i = 0; i < partitions.size(); ++i) {
+      RETURN_IF_ERROR(WritePartition(state, batch, partitions[i]));
+    }
+    return Status::OK;
+  }
+
+  scoped_array<PartitionWriteTask> tasks(new PartitionWriteTask[num_shards_]);
+  for (int i = 0; i < partitions.size(); ++i) {
+    tasks[partitions[i]->first->shard].partitions.push_back(partitions[i]);
+  }
+  // Hand all shards with rows but one to the pool, and write that one here.
+  PartitionWriteTask* local_task = NULL;
+  for (int i = 0; i < num_shards_; ++i) {
+    PartitionWriteTask* task = &tasks[i];
+    if (task->partitions.empty()) continue;
+    task->sink = this;
+    task->state = state;
+    task->batch = batch;
+    if (local_task == NULL) {
+      local_task = task;
+    } else if (!pool->Offer(task)) {
+      // Offer() only fails if the pool is shut down, write the shard here then.
+      RunPartitionWriteTask(task);
+    }
+  }
+  DCHECK(local_task != NULL);
+  RunPartitionWriteTask(local_task);
+
+  // Wait for all shards, even after an error, since they reference the batch.
+  Status status;
+  for (int i = 0; i < num_shards_; ++i) {
+    if (tasks[i].partitions.empty()) continue;
+    const Status& shard_status = tasks[i].done.Get();
+    if (status.ok()) status = shard_status;
+  }
+  return status;
+}
+
+Status HdfsTableSink::CloseLeastRecentlyUsedFiles(RuntimeState* state,
+    const vector<PartitionPair*>& partitions) {
+  int num_files_to_open = 0;
+  for (int i = 0; i < partitions.size(); ++i) {
+    OutputPartition* partition = partitions[i]->first;
+    if (partition->tmp_hdfs_file == NULL) ++num_files_to_open;
+    partition->last_batch_seq = batch_seq_;
+  }
+  if (FLAGS_max_open_insert_partition_files <= 0 || num_files_to_open == 0) {
+    return Status::OK;
+  }
+
+  // Open files of partitions that have no rows in this batch, by last use.
+  vector<pair<int64_t, OutputPartition*> > candidates;
+  int num_open_files = 0;
+  for (PartitionMap::iterator it = partition_keys_to_output_partitions_.begin();
+       it != partition_keys_to_output_partitions_.end(); ++it) {
+    OutputPartition* partition = it->second.first;
+    if (partition->tmp_hdfs_file == NULL) continue;
+    ++num_open_files;
+    if (partition->last_batch_seq != batch_seq_) {
+      candidates.push_back(make_pair(partition->last_batch_seq, partition));
+    }
+  }
+  int num_files_to_close = min<int>(candidates.size(),
+      num_open_files + num_files_to_open - FLAGS_max_open_insert_partition_files);
+  if (num_files_to_close <= 0) return Status::OK;
+
+  nth_element(candidates.begin(), candidates.begin() + num_files_to_close - 1,
+      candidates.end());
+  for (int i = 0; i < num_files_to_close; ++i) {
+    RETURN_IF_ERROR(FinalizePartitionFile(state, candidates[i].second));
+  }
+  return Status::OK;
+}
+
 Status HdfsTableSink::FinalizePartitionFile(RuntimeState* state,
                                             OutputPartition* partition) {
   if (partition->tmp_hdfs_file == NULL) return Status::OK;
   SCOPED_TIMER(ADD_TIMER(profile(), "FinalizePartitionFileTimer"));
   RETURN_IF_ERROR(partition->writer->Finalize());
-  // Track total number of appended rows per partition in runtime
-  // state. partition->num_rows counts number of rows appended is per-file.
-  (*state->num_appended_rows())[partition->partition_name] += partition->num_rows;
-
-  PartitionInsertStats stats;
-  stats[partition->partition_name] = partition->writer->stats();
-  DataSink::MergeInsertStats(stats, state->insert_stats());
+  {
+    lock_guard<mutex> l(state_lock_);
+    // Track total number of appended rows per partition in runtime
+    // state. partition->num_rows counts number of rows appended is per-file.
+    (*state->num_appended_rows())[partition->partition_name] += partition->num_rows;
+
+    PartitionInsertStats stats;
+    stats[partition->partition_name] = partition->writer->stats();
+    DataSink::MergeInsertStats(stats, state->insert_stats());
+  }
 
   ClosePartitionFile(state, partition);
   return Status::OK;
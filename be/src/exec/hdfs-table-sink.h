@@ -19,12 +19,15 @@
 #include <hdfs.h>
 #include <boost/unordered_map.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 // needed for scoped_ptr to work on ObjectPool
 #include "common/object-pool.h"
 #include "exec/data-sink.h"
 #include "runtime/descriptors.h"
+#include "util/promise.h"
 #include "util/runtime-profile.h"
+#include "util/thread-pool.h"
 
 namespace impala {
 
@@ -34,6 +37,7 @@ class TupleRow;
 class RuntimeState;
 class HdfsTableWriter;
 class MemTracker;
+class RowBatch;
 
 // Records the temporary and final Hdfs file name,
 // the opened temporary Hdfs file, and the number of appended rows
@@ -75,6 +79,14 @@ struct OutputPartition {
   // Number of files created in this partition.
   int32_t num_files;
 
+  // Index of the writer shard that writes this partition. All partitions of a shard are
+  // written by one thread at a time, using the shard's copy of the output exprs.
+  int shard;
+
+  // Sequence number of the last row batch that had rows for this partition. Used to
+  // close the least recently used files if --max_open_insert_partition_files is set.
+  int64_t last_batch_seq;
+
   // Table format specific writer functions.
   boost::scoped_ptr<HdfsTableWriter> writer;
 
@@ -84,6 +96,29 @@ struct OutputPartition {
   OutputPartition();
 };
 
+class HdfsTableSink;
+
+// The partitions of one shard that have rows in the current batch. 'done' is set to the
+// status of writing them, once the shard is done with the batch.
+struct PartitionWriteTask {
+  HdfsTableSink* sink;
+  RuntimeState* state;
+  RowBatch* batch;
+  std::vector<std::pair<OutputPartition*, std::vector<int32_t> >*> partitions;
+  Promise<Status> done;
+};
+
+// Writes task->partitions on the calling thread and sets task->done.
+void RunPartitionWriteTask(PartitionWriteTask* task);
+
+// Pool of threads that run RunPartitionWriteTask(). Also declared in runtime/exec-env.h.
+typedef ThreadPool<PartitionWriteTask*> TableWriterThreadPool;
+
+// Creates a new TableWriterThreadPool with the specified parameters. See ThreadPool's
+// constructor for the meaning of the arguments.
+TableWriterThreadPool* CreateTableWriterThreadPool(const std::string& name,
+    uint32_t num_threads, uint32_t max_queue_length);
+
 // The sink consumes all row batches of its child execution tree, and writes the evaluated
 // output_exprs into temporary Hdfs files. The query coordinator moves the temporary files
 // into their final locations after the sinks have finished executing.
@@ -102,6 +137,13 @@ struct OutputPartition {
 // partition_key_exprs from tsink.
 // A map of opened Hdfs files (corresponding to partitions) is maintained.
 // Each row may belong to different partition than the one before it.
+// The rows of each batch are grouped by partition first. The partitions are then split
+// into shards, which the table writer thread pool encodes and writes in parallel, each
+// shard evaluating its own copy of the output exprs. Send() waits for all shards, since
+// the batch is reused once it returns. Partition files are opened when the partition
+// first gets rows. If --max_open_insert_partition_files is set, the least recently used
+// files are finalized to stay under the limit, and a new file is started if the
+// partition gets more rows later.
 //
 // Failure behavior:
 // In Exec() all data is written to Hdfs files in a temporary directory.
@@ -146,7 +188,10 @@ class HdfsTableSink : public DataSink {
   std::string DebugString() const;
 
  private:
-  // Initialises the filenames of a given output partition, and opens the temporary file.
+  friend void RunPartitionWriteTask(PartitionWriteTask* task);
+
+  // Initialises the writer of a given output partition. The temporary file is opened
+  // by WritePartition().
   Status InitOutputPartition(RuntimeState* state,
                              const HdfsPartitionDescriptor& partition_descriptor,
                              OutputPartition* output_partition);
@@ -192,6 +237,25 @@ class HdfsTableSink : public DataSink {
   // Closes the hdfs file for this partition as well as the writer.
   void ClosePartitionFile(RuntimeState* state, OutputPartition* partition);
 
+  // Appends the rows of 'batch' in partition_pair->second to the partition, opening a
+  // file first if it has none and starting new files as the writer asks for them.
+  // May be called from a table writer thread.
+  Status WritePartition(RuntimeState* state, RowBatch* batch,
+                        PartitionPair* partition_pair);
+
+  // Writes 'partitions', which all have rows in 'batch'. If there is more than one
+  // shard, the shards are written by the table writer thread pool. Returns once all
+  // partitions are written.
+  Status WritePartitions(RuntimeState* state, RowBatch* batch,
+                         const std::vector<PartitionPair*>& partitions);
+
+  // If --max_open_insert_partition_files is set, finalizes the files of the least
+  // recently used partitions that are not in 'partitions' so that the files of
+  // 'partitions' can be open without exceeding the limit. The limit is exceeded if
+  // the batch alone has more partitions than that.
+  Status CloseLeastRecentlyUsedFiles(RuntimeState* state,
+                                     const std::vector<PartitionPair*>& partitions);
+
   // Descriptor of target table. Set in Init().
   const HdfsTableDescriptor* table_desc_;
 
@@ -201,6 +265,24 @@ class HdfsTableSink : public DataSink {
   // Exprs that materialize output values
   std::vector<Expr*> output_exprs_;
 
+  // Copies of output_exprs_ for each writer shard but the first one, which uses
+  // output_exprs_. Exprs keep their result in the Expr object, so shards that are
+  // written concurrently can't share them. Set in Init().
+  std::vector<std::vector<Expr*> > shard_output_exprs_;
+
+  // Number of writer shards, 1 if partitions are written from the fragment thread.
+  int num_shards_;
+
+  // Shard of the next new partition. Partitions are assigned round robin.
+  int next_shard_;
+
+  // Sequence number of the current row batch.
+  int64_t batch_seq_;
+
+  // Protects the maps in the runtime state that are updated when partition files are
+  // created and finalized, since that can happen on multiple writer threads.
+  boost::mutex state_lock_;
+
   // Current row from the current RowBatch to output
   TupleRow* current_row_;
 
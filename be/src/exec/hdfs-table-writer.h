@@ -89,6 +89,9 @@ class HdfsTableWriter {
   // care, it should return 0 and the hdfs config default will be used.
   virtual uint64_t default_block_size() = 0;
 
+  // Suffix of the files written by this writer, e.g. to mark them as compressed.
+  virtual std::string file_extension() const { return ""; }
+
  protected:
   // Size to buffer output before calling Write() (which calls hdfsWrite), in bytes
   // to minimize the overhead of Write()
@@ -23,6 +23,8 @@
 #include "exec/text-converter.inline.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
+#include "util/block-gzip.h"
+#include "util/codec.h"
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
 
@@ -42,7 +44,9 @@ HdfsTextScanner::HdfsTextScanner(HdfsScanNode* scan_node, RuntimeState* state)
       boundary_row_(boundary_mem_pool_.get()),
       boundary_column_(boundary_mem_pool_.get()),
       slot_idx_(0),
-      error_in_row_(false) {
+      error_in_row_(false),
+      file_compression_(THdfsCompression::NONE),
+      decompressed_data_pool_(new MemPool(scan_node->mem_tracker())) {
 }
 
 HdfsTextScanner::~HdfsTextScanner() {
@@ -59,7 +63,15 @@ Status HdfsTextScanner::IssueInitialRanges(HdfsScanNode* scan_node,
 
 Status HdfsTextScanner::ProcessSplit() {
   // Reset state for new scan range
-  InitNewRange();
+  RETURN_IF_ERROR(InitNewRange());
+
+  if (decompressor_.get() != NULL && stream_->scan_range()->offset() != 0) {
+    // Start at the first gzip member of this scan range. The members before it are
+    // processed by the previous scan range.
+    bool member_found;
+    RETURN_IF_ERROR(SkipToGzipMember(&member_found));
+    if (!member_found) return Status::OK;
+  }
 
   // Find the first tuple.  If tuple_found is false, it means we went through the entire
   // scan range without finding a single tuple.  The bytes will be picked up
@@ -81,19 +93,27 @@ Status HdfsTextScanner::ProcessSplit() {
 }
 
 void HdfsTextScanner::Close() {
+  if (decompressor_.get() != NULL) decompressor_->Close();
+  AttachPool(decompressed_data_pool_.get());
   AttachPool(boundary_mem_pool_.get());
   AddFinalRowBatch();
-  scan_node_->RangeComplete(THdfsFileFormat::TEXT, THdfsCompression::NONE);
+  scan_node_->RangeComplete(THdfsFileFormat::TEXT, file_compression_);
 
-  scan_node_->ReleaseCodegenFn(THdfsFileFormat::TEXT, codegen_fn_);
   codegen_fn_ = NULL;
 
   HdfsScanner::Close();
 }
 
-void HdfsTextScanner::InitNewRange() {
+Status HdfsTextScanner::InitNewRange() {
   HdfsPartitionDescriptor* hdfs_partition = context_->partition_descriptor();
 
+  file_compression_ = scan_node_->GetFileDesc(stream_->filename())->file_compression;
+  if (file_compression_ == THdfsCompression::GZIP) {
+    // Members are decompressed into buffers allocated by FillByteBufferGzip().
+    RETURN_IF_ERROR(Codec::CreateDecompressor(
+        NULL, false, THdfsCompression::GZIP, &decompressor_));
+  }
+
   char field_delim = hdfs_partition->field_delim();
   char collection_delim = hdfs_partition->collection_delim();
   if (scan_node_->materialized_slots().size() == 0) {
@@ -108,6 +128,7 @@ void HdfsTextScanner::InitNewRange() {
       scan_node_->hdfs_table()->null_column_value()));
 
   ResetScanner();
+  return Status::OK;
 }
 
 void HdfsTextScanner::ResetScanner() {
@@ -274,6 +295,10 @@ Status HdfsTextScanner::ProcessRange(int* num_tuples, bool past_scan_range) {
 }
 
 Status HdfsTextScanner::FillByteBuffer(bool* eosr, int num_bytes) {
+  // FinishScanRange() is the only caller that reads a given number of bytes, which it
+  // does past the end of the scan range.
+  if (decompressor_.get() != NULL) return FillByteBufferGzip(eosr, num_bytes > 0);
+
   *eosr = false;
   Status status;
   if (num_bytes > 0) {
@@ -289,6 +314,87 @@ Status HdfsTextScanner::FillByteBuffer(bool* eosr, int num_bytes) {
   return status;
 }
 
+Status HdfsTextScanner::FillByteBufferGzip(bool* eosr, bool past_scan_range) {
+  byte_buffer_read_size_ = 0;
+  // Empty members (e.g. the end of file marker of concatenated files) are skipped.
+  while (byte_buffer_read_size_ == 0 && !stream_->eof() &&
+      (past_scan_range || !stream_->eosr())) {
+    Status status;
+    uint8_t* header;
+    if (!stream_->ReadBytes(BlockGzip::HEADER_SIZE, &header, &status, true)) {
+      return status;
+    }
+    if (!BlockGzip::IsHeader(header)) {
+      stringstream ss;
+      ss << "Invalid gzip member header at offset " << stream_->file_offset()
+         << " of " << stream_->filename() << ": the file is not in the block gzip"
+         << " (BGZF) format. Gzip compressed text files must be written by bgzip or by"
+         << " inserts with TEXT_COMPRESSION_CODEC=gzip.";
+      return Status(ss.str());
+    }
+    int block_size = BlockGzip::BlockSize(header);
+    uint8_t* block;
+    if (!stream_->ReadBytes(block_size, &block, &status)) return status;
+    if (BlockGzip::IsEofBlock(block, block_size)) continue;
+
+    // We are decompressing a new member. Pass the previous member's data to the batch
+    // if tuples may reference it.
+    if (!stream_->compact_data()) {
+      AttachPool(decompressed_data_pool_.get());
+    } else {
+      decompressed_data_pool_->Clear();
+    }
+    int output_len;
+    RETURN_IF_ERROR(BlockGzip::UncompressedSize(block, block_size, &output_len));
+    uint8_t* output = decompressed_data_pool_->Allocate(output_len);
+    {
+      SCOPED_TIMER(decompress_timer_);
+      RETURN_IF_ERROR(decompressor_->ProcessBlock(true, block_size, block, &output_len,
+          &output));
+    }
+    byte_buffer_ptr_ = reinterpret_cast<char*>(output);
+    byte_buffer_read_size_ = output_len;
+  }
+  byte_buffer_end_ = byte_buffer_ptr_ + byte_buffer_read_size_;
+  // The next member starts past the end of the scan range.
+  *eosr = stream_->eosr();
+  return Status::OK;
+}
+
+Status HdfsTextScanner::SkipToGzipMember(bool* found) {
+  *found = false;
+  uint8_t* buffer;
+  int buffer_len;
+  Status status;
+  // Similar to BaseSequenceScanner::SkipToSync(): search each buffer of the scan range
+  // for a member header, including headers that start at the end of the buffer and
+  // continue in the next one.
+  while (!stream_->eosr()) {
+    RETURN_IF_ERROR(stream_->GetBuffer(true, &buffer, &buffer_len));
+    int offset = BlockGzip::FindHeader(buffer, buffer_len);
+    if (offset == -1) {
+      int to_skip = max(0, buffer_len - (BlockGzip::HEADER_SIZE - 1));
+      if (!stream_->SkipBytes(to_skip, &status)) return status;
+      // Only accept headers starting in the current buffer, the next one may be past
+      // the end of the scan range.
+      if (!stream_->GetBytes((BlockGzip::HEADER_SIZE - 1) * 2, &buffer, &buffer_len,
+          &status, true)) {
+        return status;
+      }
+      offset = BlockGzip::FindHeader(buffer, buffer_len);
+      if (offset >= BlockGzip::HEADER_SIZE - 1) offset = -1;
+    }
+    if (offset != -1) {
+      if (!stream_->SkipBytes(offset, &status)) return status;
+      *found = true;
+      return Status::OK;
+    }
+    // No member starting in this buffer, advance to the next one.
+    RETURN_IF_ERROR(stream_->GetBuffer(false, &buffer, &buffer_len));
+  }
+  return Status::OK;
+}
+
 Status HdfsTextScanner::FindFirstTuple(bool* tuple_found) {
   *tuple_found = true;
   if (stream_->scan_range()->offset() != 0) {
@@ -334,6 +440,7 @@ Status HdfsTextScanner::Prepare(ScannerContext* context) {
 
   parse_delimiter_timer_ = ADD_CHILD_TIMER(scan_node_->runtime_profile(),
       "DelimiterParseTime", ScanNode::SCANNER_THREAD_TOTAL_WALLCLOCK_TIME);
+  decompress_timer_ = ADD_TIMER(scan_node_->runtime_profile(), "DecompressionTime");
 
   // Allocate the scratch space for two pass parsing.  The most fields we can go
   // through in one parse pass is the batch size (tuples) * the number of fields per tuple
@@ -416,7 +523,7 @@ int HdfsTextScanner::WriteFields(MemPool* pool, TupleRow* tuple_row,
       ++num_tuples_processed;
       --num_tuples;
 
-      if (ExecNode::EvalConjuncts(&(*conjuncts_)[0], num_conjuncts_, tuple_row)) {
+      if (ExecNode::EvalConjuncts(conjuncts_, num_conjuncts_, tuple_row)) {
         ++num_tuples_materialized;
         tuple_ = next_tuple(tuple_);
         tuple_row = next_row(tuple_row);
@@ -21,12 +21,16 @@
 
 namespace impala {
 
+class Codec;
 class DelimitedTextParser;
 class ScannerContext;
 struct HdfsFileDesc;
 
 // HdfsScanner implementation that understands text-formatted
 // records. Uses SSE instructions, if available, for performance.
+// Gzip compressed files must be in the block gzip format (see util/block-gzip.h). They
+// are split like uncompressed files: a scan range processes the gzip members that start
+// in it, and finds the first tuple in the decompressed data as for uncompressed text.
 class HdfsTextScanner : public HdfsScanner {
  public:
   HdfsTextScanner(HdfsScanNode* scan_node, RuntimeState* state);
@@ -67,7 +71,7 @@ class HdfsTextScanner : public HdfsScanner {
 
   // Initializes this scanner for this context.  The context maps to a single
   // scan range.
-  void InitNewRange();
+  Status InitNewRange();
 
   // Finds the start of the first tuple in this scan range and initializes
   // byte_buffer_ptr to be the next character (the start of the first tuple).  If
@@ -93,6 +97,15 @@ class HdfsTextScanner : public HdfsScanner {
   // otherwise it will just read num_bytes.
   virtual Status FillByteBuffer(bool* eosr, int num_bytes = 0);
 
+  // FillByteBuffer() for block gzip files: decompresses the next gzip member into the
+  // byte buffer. Unless past_scan_range is true, only members starting in the scan
+  // range are read.
+  Status FillByteBufferGzip(bool* eosr, bool past_scan_range);
+
+  // Skips to the first block gzip member starting in the scan range. Sets *found to
+  // false if there is none.
+  Status SkipToGzipMember(bool* found);
+
   // Prepends field data that was from the previous file buffer (This field straddled two
   // file buffers).  'data' already contains the pointer/len from the current file buffer,
   // boundary_column_ contains the beginning of the data from the previous file
@@ -161,6 +174,18 @@ class HdfsTextScanner : public HdfsScanner {
 
   // Time parsing text files
   RuntimeProfile::Counter* parse_delimiter_timer_;
+
+  // Compression of the file being scanned.
+  THdfsCompression::type file_compression_;
+
+  // Decompressor for block gzip files, NULL for uncompressed files.
+  boost::scoped_ptr<Codec> decompressor_;
+
+  // Holds the decompressed data of the current gzip member.
+  boost::scoped_ptr<MemPool> decompressed_data_pool_;
+
+  // Time spent decompressing gzip members.
+  RuntimeProfile::Counter* decompress_timer_;
 };
 
 }
@@ -20,6 +20,8 @@
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "runtime/hdfs-fs-cache.h"
+#include "util/block-gzip.h"
+#include "util/codec.h"
 
 #include <vector>
 #include <hdfs.h>
@@ -41,12 +43,39 @@ HdfsTextTableWriter::HdfsTextTableWriter(HdfsTableSink* parent,
   field_delim_ = partition->field_delim();
   escape_char_ = partition->escape_char();
 
+  codec_ = THdfsCompression::NONE;
+  const TQueryOptions& query_options = state_->query_options();
+  if (query_options.__isset.text_compression_codec) {
+    codec_ = query_options.text_compression_codec;
+  }
+
   // The default stringstream output precision is not very high, making it impossible
   // to properly output doubles (they get rounded to ints).  Set a more reasonable
   // precision.
   rowbatch_stringstream_.precision(RawValue::ASCII_PRECISION);
 }
 
+Status HdfsTextTableWriter::Init() {
+  if (codec_ == THdfsCompression::GZIP) {
+    // The gzip header and trailer of each member are written by BlockGzip.
+    RETURN_IF_ERROR(Codec::CreateCompressor(
+        NULL, false, THdfsCompression::DEFLATE, &compressor_));
+  } else if (codec_ != THdfsCompression::NONE) {
+    stringstream ss;
+    ss << "Unsupported text compression codec: " << codec_;
+    return Status(ss.str());
+  }
+  return Status::OK;
+}
+
+void HdfsTextTableWriter::Close() {
+  if (compressor_.get() != NULL) compressor_->Close();
+}
+
+string HdfsTextTableWriter::file_extension() const {
+  return compressor_.get() != NULL ? ".gz" : "";
+}
+
 Status HdfsTableWriter::Init() {
   parent_->mem_tracker()->Consume(HDFS_FLUSH_WRITE_SIZE);
   return Status::OK;
@@ -107,10 +136,7 @@ Status HdfsTextTableWriter::AppendRowBatch(RowBatch* batch,
   }
 
   if (rowbatch_stringstream_.tellp() >= HDFS_FLUSH_WRITE_SIZE || true) {
-    string rowbatch_string = rowbatch_stringstream_.str();
-    SCOPED_TIMER(parent_->hdfs_write_timer());
-    RETURN_IF_ERROR(Write(rowbatch_string.data(), rowbatch_string.size()));
-    rowbatch_stringstream_.str(string());
+    RETURN_IF_ERROR(Flush(false));
   }
 
   *new_file = false;
@@ -119,11 +145,41 @@ Status HdfsTextTableWriter::AppendRowBatch(RowBatch* batch,
 
 Status HdfsTextTableWriter::Finalize() {
   // Write the remaining buffered bytes to hdfs.
+  return Flush(true);
+}
+
+Status HdfsTextTableWriter::Flush(bool finalize) {
   string rowbatch_string = rowbatch_stringstream_.str();
-  SCOPED_TIMER(parent_->hdfs_write_timer());
-  RETURN_IF_ERROR(Write(rowbatch_string.data(), rowbatch_string.size()));
   rowbatch_stringstream_.str(string());
-  return Status::OK;
+  if (compressor_.get() == NULL) {
+    SCOPED_TIMER(parent_->hdfs_write_timer());
+    return Write(rowbatch_string.data(), rowbatch_string.size());
+  }
+
+  // Only compress full members until the file is finalized, so that the member size
+  // doesn't depend on the row batch size.
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(rowbatch_string.data());
+  int size = rowbatch_string.size();
+  int offset = 0;
+  compressed_data_.clear();
+  {
+    SCOPED_TIMER(parent_->encode_timer());
+    while (size - offset >= BlockGzip::MAX_INPUT_SIZE || (finalize && offset < size)) {
+      int len = min(size - offset, BlockGzip::MAX_INPUT_SIZE);
+      RETURN_IF_ERROR(BlockGzip::CompressBlock(
+          compressor_.get(), data + offset, len, &compressed_data_));
+      offset += len;
+    }
+    if (finalize) {
+      compressed_data_.append(reinterpret_cast<const char*>(BlockGzip::EOF_BLOCK),
+          BlockGzip::EOF_BLOCK_SIZE);
+    }
+  }
+  rowbatch_stringstream_.write(rowbatch_string.data() + offset, size - offset);
+
+  if (compressed_data_.empty()) return Status::OK;
+  SCOPED_TIMER(parent_->hdfs_write_timer());
+  return Write(compressed_data_.data(), compressed_data_.size());
 }
 
 inline void HdfsTextTableWriter::PrintEscaped(const StringValue* str_val) {
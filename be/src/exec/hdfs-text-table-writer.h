@@ -19,6 +19,7 @@
 #include <hdfs.h>
 
 #include <sstream>
+#include <boost/scoped_ptr.hpp>
 
 #include "runtime/descriptors.h"
 #include "exec/hdfs-table-sink.h"
@@ -26,6 +27,7 @@
 
 namespace impala {
 
+class Codec;
 class Expr;
 class TupleDescriptor;
 class TupleRow;
@@ -35,6 +37,8 @@ struct OutputPartition;
 
 // The writer consumes all rows passed to it and writes the evaluated output_exprs_
 // as delimited text into Hdfs files.
+// If the TEXT_COMPRESSION_CODEC query option is gzip, the files are written in the block
+// gzip format (see util/block-gzip.h), which HdfsTextScanner can split.
 class HdfsTextTableWriter : public HdfsTableWriter {
  public:
   HdfsTextTableWriter(HdfsTableSink* parent,
@@ -45,12 +49,12 @@ class HdfsTextTableWriter : public HdfsTableWriter {
 
   ~HdfsTextTableWriter() { }
 
-  // There is nothing to do for text.
-  virtual Status Init() { return Status::OK; }
+  virtual Status Init();
   virtual Status Finalize();
   virtual Status InitNewFile() { return Status::OK; }
-  virtual void Close() { }
+  virtual void Close();
   virtual uint64_t default_block_size() { return 0; }
+  virtual std::string file_extension() const;
 
   // Appends delimited string representation of the rows in the batch to output partition.
   // The resulting output is buffered until HDFS_FLUSH_WRITE_SIZE before being written
@@ -64,6 +68,11 @@ class HdfsTextTableWriter : public HdfsTableWriter {
   // support escaping tuple_delim_.
   inline void PrintEscaped(const StringValue* str_val);
 
+  // Writes the contents of rowbatch_stringstream_ to hdfs. For block gzip files, only
+  // full gzip members are written unless 'finalize' is true, and the remaining bytes
+  // are left in rowbatch_stringstream_.
+  Status Flush(bool finalize);
+
   // Character delimiting tuples.
   char tuple_delim_;
 
@@ -76,6 +85,15 @@ class HdfsTextTableWriter : public HdfsTableWriter {
   // Stringstream to buffer output.  The stream is cleared between HDFS
   // Write calls to allow for the internal buffers to be reused.
   std::stringstream rowbatch_stringstream_;
+
+  // Compression codec from the TEXT_COMPRESSION_CODEC query option, NONE or GZIP.
+  THdfsCompression::type codec_;
+
+  // Raw deflate compressor for the gzip members. NULL for uncompressed files.
+  boost::scoped_ptr<Codec> compressor_;
+
+  // Buffer for the compressed gzip members, reused across Flush() calls.
+  std::string compressed_data_;
 };
 
 }
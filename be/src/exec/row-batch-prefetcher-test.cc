@@ -0,0 +1,239 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "exec/exchange-node.h"
+#include "exec/exec-node.h"
+#include "exec/row-batch-prefetcher.h"
+#include "runtime/descriptors.h"
+#include "runtime/disk-io-mgr.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/row-batch.h"
+#include "runtime/runtime-state.h"
+#include "runtime/tuple-row.h"
+#include "testutil/desc-tbl-builder.h"
+#include "util/time.h"
+#include "gen-cpp/PlanNodes_types.h"
+
+using namespace boost;
+using namespace impala;
+using namespace std;
+
+DECLARE_bool(enable_pipelined_execution);
+
+namespace impala {
+
+const char* TMP_FILE = "/tmp/row-batch-prefetcher-test.txt";
+const char* TMP_FILE_DATA = "abcdefghijklmnop";
+
+// Returns 'num_batches' row batches with a single row each, whose value is the index
+// of the batch. If 'io_mgr' is not NULL, every batch has an io buffer attached.
+class TestNode : public ExecNode {
+ public:
+  TestNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs,
+      int num_batches, DiskIoMgr* io_mgr, DiskIoMgr::ReaderContext* reader)
+    : ExecNode(pool, tnode, descs),
+      num_batches_(num_batches),
+      io_mgr_(io_mgr),
+      reader_(reader),
+      num_calls_with_io_buffers_(0) {
+  }
+
+  virtual Status Open(RuntimeState* state) { return Status::OK; }
+
+  virtual Status GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+    // Callers must not hold any io buffers.
+    if (io_mgr_ != NULL && io_mgr_->num_buffers_in_readers() > 0) {
+      ++num_calls_with_io_buffers_;
+    }
+    int32_t* value = reinterpret_cast<int32_t*>(
+        row_batch->tuple_data_pool()->Allocate(sizeof(int32_t)));
+    *value = num_rows_returned_;
+    int idx = row_batch->AddRow();
+    row_batch->GetRow(idx)->SetTuple(0, reinterpret_cast<Tuple*>(value));
+    row_batch->CommitLastRow();
+    ++num_rows_returned_;
+    if (io_mgr_ != NULL) {
+      DiskIoMgr::ScanRange* range = pool_->Add(new DiskIoMgr::ScanRange());
+      range->Reset(TMP_FILE, strlen(TMP_FILE_DATA), 0, 0);
+      DiskIoMgr::BufferDescriptor* buffer;
+      RETURN_IF_ERROR(io_mgr_->Read(reader_, range, &buffer));
+      row_batch->AddIoBuffer(buffer);
+    }
+    *eos = num_rows_returned_ == num_batches_;
+    return Status::OK;
+  }
+
+  int num_calls_with_io_buffers() const { return num_calls_with_io_buffers_; }
+
+ private:
+  int num_batches_;
+  DiskIoMgr* io_mgr_;
+  DiskIoMgr::ReaderContext* reader_;
+  int num_calls_with_io_buffers_;
+};
+
+class RowBatchPrefetcherTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FLAGS_enable_pipelined_execution = true;
+    TQueryContext query_ctxt;
+    query_ctxt.request.query_options.__set_disable_codegen(true);
+    state_.reset(new RuntimeState(TUniqueId(), TUniqueId(), query_ctxt, "", &exec_env_));
+    ASSERT_TRUE(state_->InitMemTrackers(TUniqueId(), -1).ok());
+
+    DescriptorTblBuilder builder(&pool_);
+    builder.DeclareTuple() << TYPE_INT;
+    desc_tbl_ = builder.Build();
+    state_->set_desc_tbl(desc_tbl_);
+    vector<bool> nullable_tuples(1, false);
+    vector<TTupleId> tuple_ids(1, (TTupleId) 0);
+    row_desc_ = pool_.Add(new RowDescriptor(*desc_tbl_, tuple_ids, nullable_tuples));
+
+    tnode_.node_id = 0;
+    tnode_.node_type = TPlanNodeType::EXCHANGE_NODE;
+    tnode_.limit = -1;
+    tnode_.row_tuples = tuple_ids;
+    tnode_.nullable_tuples = nullable_tuples;
+    tnode_.exchange_node.input_row_tuples = tuple_ids;
+
+    FILE* file = fopen(TMP_FILE, "w");
+    ASSERT_TRUE(file != NULL);
+    fwrite(TMP_FILE_DATA, 1, strlen(TMP_FILE_DATA), file);
+    fclose(file);
+    io_mgr_.reset(new DiskIoMgr(1, 1, 1024, 1024));
+    ASSERT_TRUE(io_mgr_->Init(&io_mgr_tracker_).ok());
+    ASSERT_TRUE(io_mgr_->RegisterReader(NULL, &reader_, &reader_tracker_).ok());
+  }
+
+  virtual void TearDown() {
+    io_mgr_->UnregisterReader(reader_);
+    io_mgr_.reset();
+    state_.reset();
+  }
+
+  TestNode* CreateTestNode(int num_batches, bool attach_io_buffers) {
+    TPlanNode tnode = tnode_;
+    tnode.node_type = TPlanNodeType::SELECT_NODE;
+    return pool_.Add(new TestNode(&pool_, tnode, *desc_tbl_, num_batches,
+        attach_io_buffers ? io_mgr_.get() : NULL, reader_));
+  }
+
+  // Fetches all batches from 'prefetcher' and checks that they contain the values
+  // 0 to 'num_batches' - 1, in order.
+  void ValidateBatches(RowBatchPrefetcher* prefetcher, int num_batches) {
+    RowBatch batch(*row_desc_, state_->batch_size(), &tracker_);
+    int expected_value = 0;
+    bool eos = false;
+    while (!eos) {
+      ASSERT_TRUE(prefetcher->GetNext(state_.get(), &batch, &eos).ok());
+      for (int i = 0; i < batch.num_rows(); ++i) {
+        Tuple* tuple = batch.GetRow(i)->GetTuple(0);
+        EXPECT_EQ(expected_value++, *reinterpret_cast<int32_t*>(tuple));
+      }
+      batch.Reset();
+    }
+    EXPECT_EQ(num_batches, expected_value);
+  }
+
+  ExecEnv exec_env_;
+  scoped_ptr<RuntimeState> state_;
+  ObjectPool pool_;
+  DescriptorTbl* desc_tbl_;
+  RowDescriptor* row_desc_;
+  TPlanNode tnode_;
+  MemTracker tracker_;
+  MemTracker io_mgr_tracker_;
+  MemTracker reader_tracker_;
+  scoped_ptr<DiskIoMgr> io_mgr_;
+  DiskIoMgr::ReaderContext* reader_;
+};
+
+TEST_F(RowBatchPrefetcherTest, Basic) {
+  TestNode* node = CreateTestNode(100, false);
+  RowBatchPrefetcher prefetcher(node, *row_desc_, &tracker_);
+  ASSERT_TRUE(prefetcher.Start(state_.get()));
+  ValidateBatches(&prefetcher, 100);
+  prefetcher.Close();
+  EXPECT_EQ(0, tracker_.consumption());
+}
+
+TEST_F(RowBatchPrefetcherTest, NotStarted) {
+  FLAGS_enable_pipelined_execution = false;
+  TestNode* node = CreateTestNode(10, false);
+  RowBatchPrefetcher prefetcher(node, *row_desc_, &tracker_);
+  EXPECT_FALSE(prefetcher.Start(state_.get()));
+  ValidateBatches(&prefetcher, 10);
+  prefetcher.Close();
+}
+
+// The node's GetNext() must not be called while batches with io buffers are queued or
+// held by the consumer.
+TEST_F(RowBatchPrefetcherTest, IoBuffers) {
+  TestNode* node = CreateTestNode(100, true);
+  RowBatchPrefetcher prefetcher(node, *row_desc_, &tracker_);
+  ASSERT_TRUE(prefetcher.Start(state_.get()));
+  ValidateBatches(&prefetcher, 100);
+  prefetcher.Close();
+  EXPECT_EQ(0, node->num_calls_with_io_buffers());
+  EXPECT_EQ(0, io_mgr_->num_buffers_in_readers());
+}
+
+// Closing the prefetcher before eos stops the thread and frees the queued batches,
+// including their io buffers.
+TEST_F(RowBatchPrefetcherTest, CloseBeforeEos) {
+  for (int attach_io_buffers = 0; attach_io_buffers < 2; ++attach_io_buffers) {
+    TestNode* node = CreateTestNode(1000, attach_io_buffers);
+    RowBatchPrefetcher prefetcher(node, *row_desc_, &tracker_);
+    ASSERT_TRUE(prefetcher.Start(state_.get()));
+    RowBatch batch(*row_desc_, state_->batch_size(), &tracker_);
+    bool eos;
+    ASSERT_TRUE(prefetcher.GetNext(state_.get(), &batch, &eos).ok());
+    EXPECT_FALSE(eos);
+    batch.Reset();
+    prefetcher.Close();
+    EXPECT_EQ(0, node->num_calls_with_io_buffers());
+    EXPECT_EQ(0, io_mgr_->num_buffers_in_readers());
+  }
+}
+
+// Close() cancels an exchange that blocks the prefetching thread because no data
+// arrives.
+TEST_F(RowBatchPrefetcherTest, CloseCancelsExchange) {
+  ExchangeNode* node = pool_.Add(new ExchangeNode(&pool_, tnode_, *desc_tbl_));
+  node->set_num_senders(1);
+  ASSERT_TRUE(node->Prepare(state_.get()).ok());
+  ASSERT_TRUE(node->Open(state_.get()).ok());
+  RowBatchPrefetcher prefetcher(node, *row_desc_, &tracker_);
+  ASSERT_TRUE(prefetcher.Start(state_.get()));
+  SleepForMs(100);
+  // Returns only if the thread was unblocked.
+  prefetcher.Close();
+  node->Close(state_.get());
+}
+
+}
+
+int main(int argc, char** argv) {
+  InitCommonRuntime(argc, argv, false);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,175 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "exec/row-batch-prefetcher.h"
+
+#include <boost/bind.hpp>
+#include <gflags/gflags.h>
+
+#include "exec/exchange-node.h"
+#include "exec/exec-node.h"
+#include "runtime/exec-env.h"
+#include "runtime/row-batch.h"
+#include "runtime/runtime-state.h"
+#include "util/cgroups-mgr.h"
+#include "util/thread.h"
+
+using namespace boost;
+using namespace impala;
+using namespace std;
+
+DEFINE_bool(enable_pipelined_execution, false, "(Experimental) If true, joins and "
+    "aggregations fetch row batches from their (probe side) child in a separate thread, "
+    "so that the child's subtree runs concurrently with them.");
+DEFINE_int32(pipelined_execution_max_batches, 2, "(Advanced) The maximum number of row "
+    "batches that are fetched ahead of the consuming node in pipelined execution.");
+
+RowBatchPrefetcher::RowBatchPrefetcher(ExecNode* node, const RowDescriptor& row_desc,
+    MemTracker* mem_tracker)
+  : node_(node),
+    row_desc_(row_desc),
+    mem_tracker_(mem_tracker),
+    eos_batch_(NULL),
+    done_(false),
+    finished_(false),
+    num_io_buffer_batches_(0),
+    returned_io_buffers_(false) {
+}
+
+RowBatchPrefetcher::~RowBatchPrefetcher() {
+  Close();
+}
+
+bool RowBatchPrefetcher::Start(RuntimeState* state) {
+  DCHECK(prefetch_thread_.get() == NULL);
+  if (!FLAGS_enable_pipelined_execution) return false;
+  if (!state->resource_pool()->TryAcquireThreadToken()) return false;
+  batch_queue_.reset(new BlockingQueue<RowBatch*>(
+      max(FLAGS_pipelined_execution_max_batches, 1)));
+  prefetch_thread_.reset(new Thread("exec-node", "prefetch thread",
+      &RowBatchPrefetcher::PrefetchThread, this, state));
+  if (!state->cgroup().empty()) {
+    Status status = state->exec_env()->cgroups_mgr()->AssignThreadToCgroup(
+        *prefetch_thread_, state->cgroup());
+    if (!status.ok()) LOG(WARNING) << status.GetErrorMsg();
+  }
+  return true;
+}
+
+void RowBatchPrefetcher::PrefetchThread(RuntimeState* state) {
+  {
+    SCOPED_TIMER(state->total_cpu_timer());
+    while (true) {
+      {
+        unique_lock<mutex> l(lock_);
+        // The batches with io buffers must be consumed before node_->GetNext() may be
+        // called again.
+        while (num_io_buffer_batches_ > 0 && !done_) io_buffers_released_cv_.wait(l);
+        if (done_) break;
+      }
+      if (state->is_cancelled()) {
+        lock_guard<mutex> l(lock_);
+        status_ = Status::CANCELLED;
+        break;
+      }
+      RowBatch* batch = new RowBatch(row_desc_, state->batch_size(), mem_tracker_);
+      bool eos = false;
+      Status status = node_->GetNext(state, batch, &eos);
+      if (!status.ok()) {
+        delete batch;
+        lock_guard<mutex> l(lock_);
+        status_ = status;
+        break;
+      }
+      {
+        lock_guard<mutex> l(lock_);
+        if (batch->num_io_buffers() > 0) ++num_io_buffer_batches_;
+        if (eos) eos_batch_ = batch;
+      }
+      // Only fails after Close() shut down the queue.
+      if (!batch_queue_->BlockingPut(batch)) {
+        delete batch;
+        break;
+      }
+      if (eos) break;
+    }
+  }
+  {
+    lock_guard<mutex> l(lock_);
+    finished_ = true;
+  }
+  // Lets the consumer drain the queue and then see the end of the stream.
+  batch_queue_->Shutdown();
+  // Release the thread token as soon as possible, as in BlockingJoinNode.
+  state->resource_pool()->ReleaseThreadToken(false);
+}
+
+Status RowBatchPrefetcher::GetNext(RuntimeState* state, RowBatch* row_batch,
+    bool* eos) {
+  if (prefetch_thread_.get() == NULL) return node_->GetNext(state, row_batch, eos);
+  DCHECK_EQ(row_batch->num_rows(), 0);
+  DCHECK_EQ(row_batch->num_io_buffers(), 0);
+
+  {
+    // The caller released the previously returned batch.
+    lock_guard<mutex> l(lock_);
+    if (returned_io_buffers_) {
+      returned_io_buffers_ = false;
+      if (--num_io_buffer_batches_ == 0) io_buffers_released_cv_.notify_one();
+    }
+  }
+  RowBatch* batch = NULL;
+  if (!batch_queue_->BlockingGet(&batch)) {
+    // The prefetching thread stopped without returning eos.
+    lock_guard<mutex> l(lock_);
+    DCHECK(!status_.ok() || done_);
+    return status_.ok() ? Status::CANCELLED : status_;
+  }
+  bool has_io_buffers = batch->num_io_buffers() > 0;
+  row_batch->AcquireState(batch);
+  {
+    lock_guard<mutex> l(lock_);
+    *eos = (batch == eos_batch_);
+    returned_io_buffers_ = has_io_buffers;
+  }
+  delete batch;
+  return Status::OK;
+}
+
+void RowBatchPrefetcher::Close() {
+  if (prefetch_thread_.get() == NULL) return;
+  bool finished;
+  {
+    lock_guard<mutex> l(lock_);
+    done_ = true;
+    finished = finished_;
+  }
+  io_buffers_released_cv_.notify_one();
+  if (!finished) {
+    // The consumer doesn't need the rest of the node's output. All nodes but exchanges
+    // return from GetNext() on their own, so cancelling the exchanges guarantees that
+    // the thread stops. Only the exchanges in the node's subtree are cancelled, since
+    // the rest of the fragment may still be running.
+    vector<ExecNode*> exchange_nodes;
+    node_->CollectNodes(TPlanNodeType::EXCHANGE_NODE, &exchange_nodes);
+    for (int i = 0; i < exchange_nodes.size(); ++i) {
+      static_cast<ExchangeNode*>(exchange_nodes[i])->CancelStream();
+    }
+  }
+  batch_queue_->Shutdown();
+  prefetch_thread_->Join();
+  prefetch_thread_.reset();
+  RowBatch* batch = NULL;
+  while (batch_queue_->BlockingGet(&batch)) delete batch;
+}
@@ -0,0 +1,110 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_EXEC_ROW_BATCH_PREFETCHER_H
+#define IMPALA_EXEC_ROW_BATCH_PREFETCHER_H
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/status.h"
+#include "util/blocking-queue.h"
+
+namespace impala {
+
+class ExecNode;
+class MemTracker;
+class RowBatch;
+class RowDescriptor;
+class RuntimeState;
+class Thread;
+
+// Calls GetNext() on an exec node from a separate thread and queues the row batches it
+// returns, so that the node's subtree (e.g. scan -> select) runs concurrently with the
+// node consuming its output (e.g. the probe side of a join, or an aggregation).
+// This relies on the GetNext() contract that the callee doesn't overwrite data returned
+// in a row batch until it is closed, which makes it safe to request the next batch
+// before the previous one has been consumed. GetNext() must not be called while the
+// caller holds io buffers though, so the prefetching thread waits for a batch with io
+// buffers to be consumed (i.e. for the next call to GetNext()) before it calls the
+// node's GetNext() again.
+// If --enable_pipelined_execution is false or no thread token is available, GetNext()
+// calls the node's GetNext() directly, on the caller's thread.
+// The node's Open() must have returned before Start() is called, and Close() (or the
+// destructor) must be called before the node is closed.
+class RowBatchPrefetcher {
+ public:
+  // 'row_desc' and 'mem_tracker' are used for the queued row batches. 'row_desc' must
+  // match the row batches passed to GetNext().
+  RowBatchPrefetcher(ExecNode* node, const RowDescriptor& row_desc,
+      MemTracker* mem_tracker);
+  ~RowBatchPrefetcher();
+
+  // Starts the prefetching thread. Returns true if a thread was started.
+  bool Start(RuntimeState* state);
+
+  // Same contract as ExecNode::GetNext(). 'row_batch' must be empty.
+  Status GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos);
+
+  // Stops the prefetching thread and frees all queued row batches. If the thread is
+  // still running, the exchanges in the node's subtree are cancelled first, since they
+  // could otherwise block it indefinitely. Idempotent.
+  void Close();
+
+ private:
+  ExecNode* node_;
+  const RowDescriptor& row_desc_;
+  MemTracker* mem_tracker_;
+
+  // Row batches returned by node_, in order. Shut down by the prefetching thread after
+  // it queued the last batch or hit an error, or by Close().
+  boost::scoped_ptr<BlockingQueue<RowBatch*> > batch_queue_;
+  boost::scoped_ptr<Thread> prefetch_thread_;
+
+  // Protects all members below.
+  boost::mutex lock_;
+
+  // Error returned by node_->GetNext() in the prefetching thread, if any.
+  Status status_;
+
+  // The batch for which node_ returned eos; NULL until then.
+  RowBatch* eos_batch_;
+
+  // Set by Close() to stop the prefetching thread.
+  bool done_;
+
+  // Set by the prefetching thread when it exits.
+  bool finished_;
+
+  // Number of batches with io buffers that are queued or were returned by the last
+  // call to GetNext(). The prefetching thread doesn't call node_->GetNext() while this
+  // is non-zero.
+  int num_io_buffer_batches_;
+
+  // True if the batch returned by the last call to GetNext() had io buffers, i.e. is
+  // counted in num_io_buffer_batches_.
+  bool returned_io_buffers_;
+
+  // Signalled when num_io_buffer_batches_ drops to zero or done_ is set.
+  boost::condition_variable io_buffers_released_cv_;
+
+  // Main loop of the prefetching thread.
+  void PrefetchThread(RuntimeState* state);
+};
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "exec/hdfs-scan-node.h"
+#include "exec/scanner-context.inline.h"
+#include "runtime/descriptors.h"
+#include "runtime/disk-io-mgr.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/row-batch.h"
+#include "runtime/runtime-state.h"
+#include "testutil/desc-tbl-builder.h"
+#include "gen-cpp/PlanNodes_types.h"
+
+using namespace boost;
+using namespace impala;
+using namespace std;
+
+DECLARE_int32(read_size);
+DECLARE_int32(min_buffer_size);
+DECLARE_int32(num_disks);
+
+namespace impala {
+
+const char* TMP_FILE = "/tmp/scanner-context-test.txt";
+
+// Size of the io buffers. Skips of more than this many bytes past the current buffer
+// don't read the skipped bytes.
+const int BUFFER_SIZE = 1024;
+const int FILE_SIZE = 8 * BUFFER_SIZE;
+
+// The byte at offset i of the test file is i % FILE_PATTERN, which is prime so that
+// the pattern doesn't line up with the buffers.
+const int FILE_PATTERN = 251;
+
+class ScannerContextTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FLAGS_read_size = BUFFER_SIZE;
+    FLAGS_min_buffer_size = BUFFER_SIZE;
+    FLAGS_num_disks = 1;
+    exec_env_.reset(new ExecEnv());
+    ASSERT_TRUE(exec_env_->disk_io_mgr()->Init(&io_mgr_tracker_).ok());
+    TQueryContext query_ctxt;
+    query_ctxt.request.query_options.__set_disable_codegen(true);
+    state_.reset(
+        new RuntimeState(TUniqueId(), TUniqueId(), query_ctxt, "", exec_env_.get()));
+    ASSERT_TRUE(state_->InitMemTrackers(TUniqueId(), -1).ok());
+
+    DescriptorTblBuilder builder(&pool_);
+    builder.DeclareTuple() << TYPE_INT;
+    DescriptorTbl* desc_tbl = builder.Build();
+    vector<bool> nullable_tuples(1, false);
+    vector<TTupleId> tuple_ids(1, (TTupleId) 0);
+    row_desc_ = pool_.Add(new RowDescriptor(*desc_tbl, tuple_ids, nullable_tuples));
+
+    FILE* file = fopen(TMP_FILE, "w");
+    ASSERT_TRUE(file != NULL);
+    for (int i = 0; i < FILE_SIZE; ++i) fputc(i % FILE_PATTERN, file);
+    fclose(file);
+
+    TPlanNode tnode;
+    tnode.node_id = 0;
+    tnode.node_type = TPlanNodeType::HDFS_SCAN_NODE;
+    tnode.limit = -1;
+    tnode.row_tuples = tuple_ids;
+    tnode.nullable_tuples = nullable_tuples;
+    tnode.compact_data = true;
+    tnode.hdfs_scan_node.tuple_id = 0;
+    scan_node_ = pool_.Add(new HdfsScanNode(&pool_, tnode, *desc_tbl));
+    scan_node_->runtime_state_ = state_.get();
+    scan_node_->mem_tracker_.reset(new MemTracker());
+    ASSERT_TRUE(io_mgr()->RegisterReader(
+        NULL, &scan_node_->reader_context_, &reader_tracker_).ok());
+    HdfsFileDesc* file_desc = pool_.Add(new HdfsFileDesc(TMP_FILE));
+    file_desc->file_length = FILE_SIZE;
+    scan_node_->file_descs_[TMP_FILE] = file_desc;
+  }
+
+  virtual void TearDown() {
+    ReleaseContext();
+    io_mgr()->UnregisterReader(scan_node_->reader_context_);
+    EXPECT_EQ(0, scan_node_->num_owned_io_buffers_);
+    state_.reset();
+    exec_env_.reset();
+  }
+
+  DiskIoMgr* io_mgr() { return exec_env_->disk_io_mgr(); }
+
+  // Returns all io buffers of the current context.
+  void ReleaseContext() {
+    if (context_.get() == NULL) return;
+    RowBatch batch(*row_desc_, 1, &batch_tracker_);
+    context_->AttachCompletedResources(&batch, true);
+    context_.reset();
+  }
+
+  // Returns a stream over the scan range [offset, offset + len) of the test file.
+  ScannerContext::Stream* CreateStream(int64_t offset, int64_t len) {
+    ReleaseContext();
+    DiskIoMgr::ScanRange* range =
+        scan_node_->AllocateScanRange(TMP_FILE, len, offset, -1, 0);
+    vector<DiskIoMgr::ScanRange*> ranges(1, range);
+    EXPECT_TRUE(io_mgr()->AddScanRanges(scan_node_->reader_context_, ranges, true).ok());
+    context_.reset(new ScannerContext(state_.get(), scan_node_, NULL, range));
+    return context_->GetStream();
+  }
+
+  // Skips 'length' bytes and checks that the stream is at the expected position.
+  static void Skip(ScannerContext::Stream* stream, int length) {
+    int64_t expected_offset = stream->file_offset() + length;
+    Status status;
+    ASSERT_TRUE(stream->SkipBytes(length, &status)) << status.GetErrorMsg();
+    EXPECT_EQ(expected_offset, stream->file_offset());
+  }
+
+  // Reads 'length' bytes and checks that they are the bytes at the stream's position.
+  static void ValidateRead(ScannerContext::Stream* stream, int length) {
+    int64_t offset = stream->file_offset();
+    uint8_t* bytes;
+    Status status;
+    ASSERT_TRUE(stream->ReadBytes(length, &bytes, &status)) << status.GetErrorMsg();
+    for (int i = 0; i < length; ++i) {
+      ASSERT_EQ((offset + i) % FILE_PATTERN, bytes[i]) << "offset " << offset + i;
+    }
+    EXPECT_EQ(offset + length, stream->file_offset());
+  }
+
+  ObjectPool pool_;
+  MemTracker io_mgr_tracker_;
+  MemTracker reader_tracker_;
+  MemTracker batch_tracker_;
+  scoped_ptr<ExecEnv> exec_env_;
+  scoped_ptr<RuntimeState> state_;
+  RowDescriptor* row_desc_;
+  HdfsScanNode* scan_node_;
+  scoped_ptr<ScannerContext> context_;
+};
+
+TEST_F(ScannerContextTest, SkipWithinBuffer) {
+  ScannerContext::Stream* stream = CreateStream(0, FILE_SIZE);
+  ValidateRead(stream, 1);
+  Skip(stream, 10);
+  ValidateRead(stream, 10);
+  Skip(stream, 0);
+  ValidateRead(stream, 1);
+}
+
+TEST_F(ScannerContextTest, SkipAcrossBufferBoundary) {
+  ScannerContext::Stream* stream = CreateStream(0, FILE_SIZE);
+  ValidateRead(stream, 1);
+  // Ends in the next buffer, which is read.
+  Skip(stream, BUFFER_SIZE + 10);
+  ValidateRead(stream, 10);
+  // Ends exactly at the end of a buffer.
+  Skip(stream, 2 * BUFFER_SIZE - stream->file_offset());
+  ValidateRead(stream, 10);
+  // Starts at the beginning of a buffer.
+  Skip(stream, 3 * BUFFER_SIZE - stream->file_offset());
+  Skip(stream, 100);
+  ValidateRead(stream, 1);
+}
+
+TEST_F(ScannerContextTest, SkipInBoundaryBuffer) {
+  ScannerContext::Stream* stream = CreateStream(0, FILE_SIZE);
+  Skip(stream, BUFFER_SIZE - 10);
+  // Straddles two io buffers, so the bytes are copied into the boundary buffer.
+  uint8_t* bytes;
+  int len;
+  Status status;
+  ASSERT_TRUE(stream->GetBytes(20, &bytes, &len, &status, true));
+  EXPECT_EQ(20, len);
+  // Within the boundary buffer.
+  Skip(stream, 5);
+  ValidateRead(stream, 5);
+  // From the boundary buffer into the io buffer after it.
+  Skip(stream, 100);
+  ValidateRead(stream, 10);
+  // From the boundary buffer across several io buffers.
+  ASSERT_TRUE(stream->GetBytes(BUFFER_SIZE, &bytes, &len, &status, true));
+  Skip(stream, 3 * BUFFER_SIZE);
+  ValidateRead(stream, 10);
+}
+
+TEST_F(ScannerContextTest, SkipMultipleBuffers) {
+  ScannerContext::Stream* stream = CreateStream(0, FILE_SIZE);
+  ValidateRead(stream, 1);
+  // The skipped buffers are not read.
+  Skip(stream, 3 * BUFFER_SIZE + 17);
+  ValidateRead(stream, 10);
+  Skip(stream, 2 * BUFFER_SIZE);
+  ValidateRead(stream, BUFFER_SIZE + 10);
+  EXPECT_FALSE(stream->eosr());
+  // A skip as the first operation on the stream.
+  stream = CreateStream(BUFFER_SIZE / 2, 4 * BUFFER_SIZE);
+  Skip(stream, 2 * BUFFER_SIZE);
+  ValidateRead(stream, 10);
+}
+
+TEST_F(ScannerContextTest, SkipToEndOfScanRange) {
+  ScannerContext::Stream* stream = CreateStream(100, 2 * BUFFER_SIZE);
+  ValidateRead(stream, 1);
+  Skip(stream, stream->bytes_left());
+  EXPECT_TRUE(stream->eosr());
+  EXPECT_EQ(0, stream->bytes_left());
+  // Bytes past the end of the scan range can still be read.
+  ValidateRead(stream, 10);
+
+  // Skipping past the end of the scan range without reading the skipped bytes.
+  stream = CreateStream(100, 2 * BUFFER_SIZE);
+  ValidateRead(stream, 1);
+  Skip(stream, 3 * BUFFER_SIZE);
+  EXPECT_TRUE(stream->eosr());
+  ValidateRead(stream, 10);
+
+  // Skipping to the end of the file.
+  stream = CreateStream(0, 2 * BUFFER_SIZE);
+  ValidateRead(stream, 1);
+  Skip(stream, FILE_SIZE - 1);
+  EXPECT_TRUE(stream->eof());
+}
+
+TEST_F(ScannerContextTest, SkipPastEndOfFile) {
+  int skip_lens[] = { FILE_SIZE - 2, FILE_SIZE - 1, FILE_SIZE, FILE_SIZE + 100 };
+  for (int i = 0; i < 4; ++i) {
+    int skip_len = skip_lens[i];
+    ScannerContext::Stream* stream = CreateStream(0, 2 * BUFFER_SIZE);
+    ValidateRead(stream, 1);
+    Status status;
+    // One byte was read already.
+    bool expect_ok = skip_len <= FILE_SIZE - 1;
+    EXPECT_EQ(expect_ok, stream->SkipBytes(skip_len, &status)) << skip_len;
+    EXPECT_EQ(expect_ok, status.ok());
+  }
+  ScannerContext::Stream* stream = CreateStream(0, 2 * BUFFER_SIZE);
+  Status status;
+  EXPECT_FALSE(stream->SkipBytes(-1, &status));
+}
+
+}
+
+int main(int argc, char** argv) {
+  InitCommonRuntime(argc, argv, false);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
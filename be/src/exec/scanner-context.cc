@@ -52,6 +52,7 @@ ScannerContext::Stream::Stream(ScannerContext* parent)
 ScannerContext::Stream* ScannerContext::AddStream(DiskIoMgr::ScanRange* range) {
   Stream* stream = state_->obj_pool()->Add(new Stream(this));
   stream->scan_range_ = range;
+  stream->io_range_ = range;
   stream->file_desc_ = scan_node_->GetFileDesc(stream->filename());
   stream->total_bytes_returned_ = 0;
   stream->io_buffer_pos_ = NULL;
@@ -76,6 +77,9 @@ void ScannerContext::Stream::AttachCompletedResources(RowBatch* batch, bool done
     io_buffer_bytes_left_ = 0;
     // Cancel the underlying scan range to clean up any queued buffers there
     scan_range_->Cancel(Status::CANCELLED);
+    if (io_range_ != NULL && io_range_ != scan_range_) {
+      io_range_->Cancel(Status::CANCELLED);
+    }
   }
 
   for (list<DiskIoMgr::BufferDescriptor*>::iterator it = completed_io_buffers_.begin();
@@ -103,13 +107,13 @@ void ScannerContext::Stream::AttachCompletedResources(RowBatch* batch, bool done
 Status ScannerContext::Stream::GetNextBuffer(int read_past_size) {
   if (parent_->cancelled()) return Status::CANCELLED;
 
-  // io_buffer_ should only be null the first time this is called
-  DCHECK(io_buffer_ != NULL ||
+  // io_buffer_ should only be null the first time this is called or after SkipAhead()
+  DCHECK(io_buffer_ != NULL || io_range_ != scan_range_ ||
          (total_bytes_returned_ == 0 && completed_io_buffers_.empty()));
 
   // We can't use the eosr() function because it reflects how many bytes have been
   // returned, not if we're fetched all the buffers in the scan range
-  bool eosr = false;
+  bool eosr = io_range_ == NULL;
   if (io_buffer_ != NULL) {
     eosr = io_buffer_->eosr();
     completed_io_buffers_.push_back(io_buffer_);
@@ -118,7 +122,7 @@ Status ScannerContext::Stream::GetNextBuffer(int read_past_size) {
 
   if (!eosr) {
     SCOPED_TIMER(parent_->state_->total_storage_wait_timer());
-    RETURN_IF_ERROR(scan_range_->GetNext(&io_buffer_));
+    RETURN_IF_ERROR(io_range_->GetNext(&io_buffer_));
   } else {
     SCOPED_TIMER(parent_->state_->total_storage_wait_timer());
     int64_t offset = file_offset() + boundary_buffer_bytes_left_;
@@ -249,6 +253,84 @@ Status ScannerContext::Stream::GetBytesInternal(
   return Status::OK;
 }
 
+Status ScannerContext::Stream::SkipBytesInternal(int length) {
+  DCHECK_GT(length, *output_buffer_bytes_left_);
+  int bytes_left = length;
+
+  // Skip the bytes in the boundary buffer first, they come before the io buffer.
+  int num_bytes = min(boundary_buffer_bytes_left_, bytes_left);
+  boundary_buffer_pos_ += num_bytes;
+  boundary_buffer_bytes_left_ -= num_bytes;
+  total_bytes_returned_ += num_bytes;
+  bytes_left -= num_bytes;
+  if (boundary_buffer_bytes_left_ > 0) {
+    DCHECK_EQ(bytes_left, 0);
+    output_buffer_pos_ = &boundary_buffer_pos_;
+    output_buffer_bytes_left_ = &boundary_buffer_bytes_left_;
+    return Status::OK;
+  }
+  output_buffer_pos_ = &io_buffer_pos_;
+  output_buffer_bytes_left_ = &io_buffer_bytes_left_;
+
+  int skip_ahead_size = parent_->state_->io_mgr()->max_read_buffer_size();
+  while (bytes_left > 0) {
+    num_bytes = min(io_buffer_bytes_left_, bytes_left);
+    io_buffer_pos_ += num_bytes;
+    io_buffer_bytes_left_ -= num_bytes;
+    total_bytes_returned_ += num_bytes;
+    bytes_left -= num_bytes;
+    if (bytes_left == 0) break;
+
+    if (bytes_left > skip_ahead_size) {
+      // Don't read (or wait for) the skipped bytes.
+      RETURN_IF_ERROR(SkipAhead(bytes_left));
+      return Status::OK;
+    }
+    RETURN_IF_ERROR(GetNextBuffer());
+    if (parent_->cancelled()) return Status::CANCELLED;
+    // No more bytes (i.e. EOF)
+    if (io_buffer_bytes_left_ == 0) break;
+  }
+  if (bytes_left > 0) return ReportIncompleteRead(length, length - bytes_left);
+  return Status::OK;
+}
+
+Status ScannerContext::Stream::SkipAhead(int64_t skip_len) {
+  DCHECK_EQ(io_buffer_bytes_left_, 0);
+  DCHECK_EQ(boundary_buffer_bytes_left_, 0);
+  int64_t offset = file_offset() + skip_len;
+  if (offset > file_desc_->file_length) {
+    int64_t bytes_skipped = file_desc_->file_length - file_offset();
+    total_bytes_returned_ += bytes_skipped;
+    return ReportIncompleteRead(skip_len, bytes_skipped);
+  }
+
+  // The bytes in io_buffer_ may still be referenced by the caller.
+  bool io_range_done = io_range_ == NULL;
+  if (io_buffer_ != NULL) {
+    io_range_done |= io_buffer_->eosr();
+    completed_io_buffers_.push_back(io_buffer_);
+    io_buffer_ = NULL;
+  }
+  // Stop reading the skipped bytes and release any buffers queued for them.
+  if (!io_range_done) io_range_->Cancel(Status::CANCELLED);
+  io_range_ = NULL;
+  total_bytes_returned_ += skip_len;
+
+  // If the stream is still inside the scan range, keep reading ahead asynchronously
+  // from the new offset. Otherwise the next GetNextBuffer() reads past the end of the
+  // scan range from file_offset().
+  int64_t range_end = scan_range_->offset() + scan_range_->len();
+  if (offset < range_end) {
+    io_range_ = parent_->scan_node_->AllocateScanRange(filename(), range_end - offset,
+        offset, -1, scan_range_->disk_id());
+    vector<DiskIoMgr::ScanRange*> ranges(1, io_range_);
+    RETURN_IF_ERROR(parent_->state_->io_mgr()->AddScanRanges(
+        parent_->scan_node_->reader_context(), ranges, true));
+  }
+  return Status::OK;
+}
+
 bool ScannerContext::cancelled() const {
   return scan_node_->done_;
 }
@@ -144,7 +144,10 @@ class ScannerContext {
     // Read a zigzag encoded long
     bool ReadZLong(int64_t* val, Status*);
 
-    // Skip over the next length bytes in the specified HDFS file.
+    // Skip over the next length bytes in the specified HDFS file. Skipped bytes are
+    // never copied into the boundary buffer. If the skip extends more than an io buffer
+    // past the bytes already read, the stream stops reading the skipped bytes and
+    // instead issues a new read starting at the first byte after them.
     bool SkipBytes(int length, Status*);
 
     // Read length bytes into the supplied buffer.  The returned buffer is owned
@@ -165,6 +168,12 @@ class ScannerContext {
     DiskIoMgr::ScanRange* scan_range_;
     const HdfsFileDesc* file_desc_;
 
+    // The range io buffers are currently read from. This is scan_range_ unless
+    // SkipBytes() skipped ahead, in which case it is a range from the end of the skipped
+    // bytes to the end of scan_range_, or NULL if the skip went past the end of
+    // scan_range_.
+    DiskIoMgr::ScanRange* io_range_;
+
     // If true, tuple data in the row batches is compact and the io buffers can be
     // recycled immediately.
     bool compact_data_;
@@ -212,6 +221,13 @@ class ScannerContext {
     // If peek is set then return the data but do not move the current offset.
     Status GetBytesInternal(int requested_len, uint8_t** buffer, bool peek, int* out_len);
 
+    // SkipBytes helper to handle the slow path.
+    Status SkipBytesInternal(int length);
+
+    // Stops reading io_range_ and continues reading the stream 'skip_len' bytes past the
+    // current position, which must be at the end of the current io buffer.
+    Status SkipAhead(int64_t skip_len);
+
     // Gets (and blocks) for the next io buffer. After fetching all buffers in the scan
     // range, performs synchronous reads past the scan range until EOF.
     //
@@ -222,7 +238,7 @@ class ScannerContext {
     // Updates io_buffer_, io_buffer_bytes_left_, and io_buffer_pos_.  If GetNextBuffer()
     // is called after all bytes in the file have been returned, io_buffer_bytes_left_
     // will be set to 0. In the non-error case, io_buffer_ is never set to NULL, even if
-    // it contains 0 bytes.
+    // it contains 0 bytes, except by SkipAhead().
     Status GetNextBuffer(int read_past_size = 0);
 
     // Attach all completed io buffers and the boundary mem pool to batch.
@@ -61,9 +61,16 @@ Status SelectNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
   while (true) {
     if (child_row_idx_ == child_row_batch_->num_rows()) {
       // fetch next batch
+      Expr::ClearBatch(conjuncts_);
       child_row_batch_->Reset();
       RETURN_IF_ERROR(child(0)->GetNext(state, child_row_batch_.get(), &child_eos_));
       child_row_idx_ = 0;
+      // Lets the first conjunct evaluate calls out to UDFs for the whole batch at once.
+      // The other conjuncts are only evaluated for the rows the first one accepts.
+      if (!conjuncts_.empty()) {
+        conjuncts_[0]->EvaluateBatch(child_row_batch_.get(), 0,
+            child_row_batch_->num_rows());
+      }
     }
 
     if (CopyRows(row_batch)) {
@@ -104,6 +111,7 @@ bool SelectNode::CopyRows(RowBatch* output_batch) {
 
 void SelectNode::Close(RuntimeState* state) {
   if (is_closed()) return;
+  Expr::ClearBatch(conjuncts_);
   child_row_batch_.reset();
   ExecNode::Close(state);
 }
@@ -157,8 +157,6 @@ Function* TextConverter::CodegenWriteSlot(LlvmCodeGen* codegen,
   if (slot_desc->type() != TYPE_STRING) {
     builder.SetInsertPoint(check_zero_block);
     // If len <= 0 and it is not a string col, set slot to NULL
-    // The len can be less than 0 if the field contained an escape character which
-    // is only valid for string cols.
     Value* null_len = builder.CreateICmpSLE(
         args[2], codegen->GetIntConstant(TYPE_INT, 0));
     builder.CreateCondBr(null_len, set_null_block, parse_slot_block);
@@ -199,6 +197,9 @@ Function* TextConverter::CodegenWriteSlot(LlvmCodeGen* codegen,
       case TYPE_DOUBLE:
         parse_fn_enum = IRFunction::STRING_TO_DOUBLE;
         break;
+      case TYPE_TIMESTAMP:
+        parse_fn_enum = IRFunction::STRING_TO_TIMESTAMP;
+        break;
       default:
         DCHECK(false);
         return NULL;
@@ -210,21 +211,33 @@ Function* TextConverter::CodegenWriteSlot(LlvmCodeGen* codegen,
     BasicBlock* parse_success_block, *parse_failed_block;
     codegen->CreateIfElseBlocks(fn, "parse_success", "parse_fail",
         &parse_success_block, &parse_failed_block);
-    LlvmCodeGen::NamedVariable parse_result("parse_result", codegen->GetType(TYPE_INT));
-    Value* parse_result_ptr = codegen->CreateEntryBlockAlloca(fn, parse_result);
-    Value* failed_value = codegen->GetIntConstant(TYPE_INT, StringParser::PARSE_FAILURE);
+    Value* result = NULL;
+    Value* parse_failed;
+    if (slot_desc->type() == TYPE_TIMESTAMP) {
+      // IrStringToTimestamp writes the slot itself and returns whether it succeeded.
+      Value* ts_slot = builder.CreateBitCast(
+          slot, parse_fn->getFunctionType()->getParamType(2), "ts_slot");
+      Value* parsed = builder.CreateCall3(parse_fn, args[1], args[2], ts_slot, "parsed");
+      parse_failed = builder.CreateNot(parsed, "failed");
+    } else {
+      LlvmCodeGen::NamedVariable parse_result("parse_result",
+          codegen->GetType(TYPE_INT));
+      Value* parse_result_ptr = codegen->CreateEntryBlockAlloca(fn, parse_result);
+      Value* failed_value =
+          codegen->GetIntConstant(TYPE_INT, StringParser::PARSE_FAILURE);
 
-    // Call Impala's StringTo* function
-    Value* result = builder.CreateCall3(parse_fn, args[1], args[2], parse_result_ptr);
-    Value* parse_result_val = builder.CreateLoad(parse_result_ptr, "parse_result");
+      // Call Impala's StringTo* function
+      result = builder.CreateCall3(parse_fn, args[1], args[2], parse_result_ptr);
+      Value* parse_result_val = builder.CreateLoad(parse_result_ptr, "parse_result");
 
-    // Check for parse error.  TODO: handle overflow
-    Value* parse_failed = builder.CreateICmpEQ(parse_result_val, failed_value, "failed");
+      // Check for parse error.  TODO: handle overflow
+      parse_failed = builder.CreateICmpEQ(parse_result_val, failed_value, "failed");
+    }
     builder.CreateCondBr(parse_failed, parse_failed_block, parse_success_block);
     
     // Parse succeeded
     builder.SetInsertPoint(parse_success_block);
-    builder.CreateStore(result, slot);
+    if (result != NULL) builder.CreateStore(result, slot);
     builder.CreateRet(codegen->true_value());
 
     // Parse failed, set slot to null and return false
@@ -75,8 +75,8 @@ class TextConverter {
   // otherwise.
   // If check_null is set, then the codegen'd function sets the target slot to NULL
   // if its input string matches null_vol_val.
-  // The codegenerated function does not support escape characters and should not
-  // be used for partitions that contain escapes.
+  // 'len' must not be negative. String slots are set to point to 'data'; copying or
+  // unescaping the string is left to the caller.
   static llvm::Function* CodegenWriteSlot(LlvmCodeGen* codegen,
       TupleDescriptor* tuple_desc, SlotDescriptor* slot_desc,
       const char* null_col_val, int len, bool check_null);
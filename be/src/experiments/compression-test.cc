@@ -1,9 +1,14 @@
 // Copyright (c) 2012 Cloudera, Inc. All rights reserved.
 
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <string>
 #include <gtest/gtest.h>
 
 #include "util/compress.h"
+#include "util/decompress.h"
+#include "util/stopwatch.h"
 
 using namespace boost;
 using namespace std;
@@ -79,13 +84,113 @@ void TestCompression(int num, int min_len, int max_len, THdfsCompression::type c
   free(sorted_compressed_buffer);
 }
 
+// Compresses and decompresses 'data' in blocks of 'block_size' bytes with every codec
+// that supports preallocated output, and prints the ratio and the throughput in GB/s
+// of uncompressed data.
+// Usage: compression-test [file...] benchmarks the given files (e.g. a Parquet column
+// dump or a text table file) instead of the generated strings.
+void TestCodecSpeed(const string& name, const string& data, int block_size) {
+  const THdfsCompression::type codecs[] = {
+    THdfsCompression::SNAPPY, THdfsCompression::LZ4, THdfsCompression::LZ4_HC,
+    THdfsCompression::GZIP, THdfsCompression::DEFLATE,
+  };
+  const char* codec_names[] = { "snappy", "lz4", "lz4_hc", "gzip", "deflate" };
+  const int num_codecs = sizeof(codecs) / sizeof(codecs[0]);
+  // Repeat small inputs so that the timings are meaningful.
+  const int iters = max<int>(1, (64 * 1024 * 1024) / max<int>(data.size(), 1));
+
+  cout << name << ": " << data.size() << " bytes, " << block_size << " byte blocks"
+       << endl;
+  cout << "  " << setw(10) << left << "Codec" << setw(10) << right << "Ratio"
+       << setw(16) << "Compress GB/s" << setw(18) << "Decompress GB/s" << endl;
+  for (int c = 0; c < num_codecs; ++c) {
+    scoped_ptr<Codec> compressor;
+    scoped_ptr<Codec> decompressor;
+    Codec::CreateCompressor(NULL, false, codecs[c], &compressor);
+    Codec::CreateDecompressor(NULL, false, codecs[c], &decompressor);
+
+    // Compressed blocks and their uncompressed lengths.
+    vector<string> blocks;
+    vector<int> block_lengths;
+    int64_t compressed_bytes = 0;
+    MonotonicStopWatch compress_timer;
+    for (int i = 0; i < iters; ++i) {
+      for (int offset = 0; offset < data.size(); offset += block_size) {
+        int len = min<int>(block_size, data.size() - offset);
+        uint8_t* input = (uint8_t*)data.data() + offset;
+        string block(compressor->MaxOutputLen(len, input), '\0');
+        uint8_t* output = (uint8_t*)block.data();
+        int output_len = block.size();
+        compress_timer.Start();
+        compressor->ProcessBlock(true, len, input, &output_len, &output);
+        compress_timer.Stop();
+        if (i > 0) continue;
+        block.resize(output_len);
+        compressed_bytes += output_len;
+        blocks.push_back(block);
+        block_lengths.push_back(len);
+      }
+    }
+
+    string output(block_size, '\0');
+    MonotonicStopWatch decompress_timer;
+    decompress_timer.Start();
+    for (int i = 0; i < iters; ++i) {
+      for (int b = 0; b < blocks.size(); ++b) {
+        uint8_t* output_ptr = (uint8_t*)output.data();
+        int output_len = block_lengths[b];
+        decompressor->ProcessBlock(true, blocks[b].size(), (uint8_t*)blocks[b].data(),
+            &output_len, &output_ptr);
+      }
+    }
+    decompress_timer.Stop();
+
+    double total_bytes = static_cast<double>(data.size()) * iters;
+    cout << "  " << setw(10) << left << codec_names[c] << right
+         << fixed << setprecision(2)
+         << setw(10) << static_cast<double>(data.size()) / max<int64_t>(compressed_bytes, 1)
+         << setw(16) << total_bytes / max<uint64_t>(compress_timer.ElapsedTime(), 1)
+         << setw(18) << total_bytes / max<uint64_t>(decompress_timer.ElapsedTime(), 1)
+         << endl;
+    compressor->Close();
+    decompressor->Close();
+  }
+}
+
+// Returns the same kind of random strings TestCompression() uses.
+string RandomStrings(int num, int min_len, int max_len) {
+  string result;
+  int len_delta = max(max_len - min_len, 1);
+  for (int i = 0; i < num; ++i) {
+    int len = rand() % len_delta + min_len;
+    for (int j = 0; j < len; ++j) result.push_back(rand() % 26 + 'a');
+  }
+  return result;
+}
+
 }
 
 int main(int argc, char **argv) {
+  // Parquet pages and serialized row batches are typically 64KB - 1MB.
+  const int BLOCK_SIZE = 256 * 1024;
+  if (argc > 1) {
+    for (int i = 1; i < argc; ++i) {
+      ifstream file(argv[i], ios::binary);
+      stringstream data;
+      data << file.rdbuf();
+      impala::TestCodecSpeed(argv[i], data.str(), BLOCK_SIZE);
+    }
+    return 0;
+  }
+
   impala::TestCompression(1000000, 10, 10, impala::THdfsCompression::SNAPPY);
   impala::TestCompression(1000000, 10, 10, impala::THdfsCompression::GZIP);
+  impala::TestCompression(1000000, 10, 10, impala::THdfsCompression::LZ4);
   impala::TestCompression(1000000, 5, 15, impala::THdfsCompression::SNAPPY);
   impala::TestCompression(1000000, 5, 15, impala::THdfsCompression::GZIP);
+  impala::TestCompression(1000000, 5, 15, impala::THdfsCompression::LZ4);
+  impala::TestCodecSpeed("Random strings", impala::RandomStrings(1000000, 5, 15),
+      BLOCK_SIZE);
   return 0;
 }
 
@@ -14,14 +14,18 @@
 
 #include "exprs/agg-fn-evaluator.h"
 
+#include <dlfcn.h>
 #include <sstream>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
 
 #include "codegen/llvm-codegen.h"
 #include "common/logging.h"
 #include "exec/aggregation-node.h"
 #include "exprs/aggregate-functions.h"
 #include "exprs/anyval-util.h"
+#include "runtime/descriptors.h"
 #include "runtime/lib-cache.h"
+#include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "udf/udf-internal.h"
 #include "util/debug-util.h"
@@ -68,12 +72,15 @@ AggFnEvaluator::AggFnEvaluator(const TAggregateFunctionCall& desc)
   : return_type_(desc.fn.ret_type),
     intermediate_type_(desc.fn.aggregate_fn.intermediate_type),
     function_type_(desc.fn.binary_type),
-    output_slot_desc_(NULL) {
+    output_slot_desc_(NULL),
+    update_batch_fn_(NULL),
+    batch_capacity_(0) {
   if (function_type_ == TFunctionBinaryType::BUILTIN) {
     agg_op_ = static_cast<TAggregationOp::type>(desc.fn.id);
     DCHECK_NE(agg_op_, TAggregationOp::INVALID);
   } else {
-    DCHECK_EQ(function_type_, TFunctionBinaryType::NATIVE);
+    DCHECK(function_type_ == TFunctionBinaryType::NATIVE ||
+           function_type_ == TFunctionBinaryType::IR);
     DCHECK(desc.fn.__isset.aggregate_fn);
 
     hdfs_location_ = desc.fn.hdfs_location;
@@ -82,6 +89,7 @@ AggFnEvaluator::AggFnEvaluator(const TAggregateFunctionCall& desc)
     merge_fn_symbol_ = desc.fn.aggregate_fn.merge_fn_symbol;
     serialize_fn_symbol_ = desc.fn.aggregate_fn.serialize_fn_symbol;
     finalize_fn_symbol_ = desc.fn.aggregate_fn.finalize_fn_symbol;
+    update_batch_fn_symbol_ = desc.fn.aggregate_fn.update_batch_fn_symbol;
 
     DCHECK(!hdfs_location_.empty());
     DCHECK(!init_fn_symbol_.empty());
@@ -120,6 +128,8 @@ Status AggFnEvaluator::Prepare(RuntimeState* state, const RowDescriptor& desc,
         OpcodeRegistry::Instance()->GetBuiltinAggFnDescriptor(key);
     DCHECK(fn_desc != NULL);
     fn_ptrs_ = *fn_desc;
+  } else if (function_type_ == TFunctionBinaryType::IR) {
+    RETURN_IF_ERROR(PrepareIrUda(state));
   } else {
     DCHECK_EQ(function_type_, TFunctionBinaryType::NATIVE);
     // Load the function pointers.
@@ -140,6 +150,52 @@ Status AggFnEvaluator::Prepare(RuntimeState* state, const RowDescriptor& desc,
       RETURN_IF_ERROR(state->lib_cache()->GetSoFunctionPtr(
           state->fs_cache(), hdfs_location_, finalize_fn_symbol_, &fn_ptrs_.finalize_fn));
     }
+
+    // So is the batch version of Update. UDAs without inputs (e.g. count(*)) have no
+    // columns to pass to it, so they always use Update.
+    if (!update_batch_fn_symbol_.empty() && !input_exprs().empty()) {
+      void* update_batch_fn;
+      RETURN_IF_ERROR(state->lib_cache()->GetSoFunctionPtr(
+          state->fs_cache(), hdfs_location_, update_batch_fn_symbol_, &update_batch_fn));
+      update_batch_fn_ = reinterpret_cast<UdaUpdateBatch>(update_batch_fn);
+      batch_capacity_ = state->batch_size();
+      for (int i = 0; i < input_exprs().size(); ++i) {
+        int values_size =
+            batch_capacity_ * AnyValUtil::ColumnValSize(input_exprs()[i]->type());
+        ColumnVal column(pool->Allocate(values_size),
+            reinterpret_cast<bool*>(pool->Allocate(batch_capacity_ * sizeof(bool))));
+        batch_inputs_.push_back(column);
+      }
+    }
+  }
+  return Status::OK;
+}
+
+Status AggFnEvaluator::PrepareIrUda(RuntimeState* state) {
+  // IR UDAs can only be run jitted, even if codegen is disabled for this query.
+  if (state->codegen() == NULL) RETURN_IF_ERROR(state->CreateCodegen());
+  LlvmCodeGen* codegen = state->codegen();
+
+  string local_path;
+  RETURN_IF_ERROR(state->lib_cache()->GetLocalLibPath(
+      state->fs_cache(), hdfs_location_, LibCache::TYPE_IR, &local_path));
+  RETURN_IF_ERROR(codegen->LinkModule(local_path));
+
+  const string* symbols[] = { &init_fn_symbol_, &update_fn_symbol_, &merge_fn_symbol_,
+      &serialize_fn_symbol_, &finalize_fn_symbol_ };
+  void** fn_ptrs[] = { &fn_ptrs_.init_fn, &fn_ptrs_.update_fn, &fn_ptrs_.merge_fn,
+      &fn_ptrs_.serialize_fn, &fn_ptrs_.finalize_fn };
+  for (int i = 0; i < 5; ++i) {
+    // Serialize and Finalize are optional
+    if (symbols[i]->empty()) continue;
+    Function* fn = codegen->module()->getFunction(*symbols[i]);
+    if (fn == NULL) {
+      stringstream ss;
+      ss << "Unable to locate function " << *symbols[i]
+         << " from LLVM module " << hdfs_location_;
+      return Status(ss.str());
+    }
+    codegen->AddFunctionToJit(fn, fn_ptrs[i]);
   }
   return Status::OK;
 }
@@ -316,6 +372,32 @@ void AggFnEvaluator::Update(TupleRow* row, Tuple* dst) {
   return UpdateOrMerge(row, dst, fn_ptrs_.update_fn);
 }
 
+void AggFnEvaluator::UpdateBatch(RowBatch* batch, int start_row, int num_rows,
+    Tuple* dst) {
+  DCHECK(update_batch_fn_ != NULL);
+  DCHECK(!batch_inputs_.empty());
+  while (num_rows > 0) {
+    int n = min(num_rows, batch_capacity_);
+    for (int i = 0; i < input_exprs().size(); ++i) {
+      Expr* input_expr = input_exprs()[i];
+      for (int row = 0; row < n; ++row) {
+        void* src_slot = input_expr->GetValue(batch->GetRow(start_row + row));
+        AnyValUtil::SetColumnVal(src_slot, input_expr->type(), row, &batch_inputs_[i]);
+      }
+    }
+
+    bool dst_null = dst->IsNull(output_slot_desc_->null_indicator_offset());
+    void* dst_slot = NULL;
+    if (!dst_null) dst_slot = dst->GetSlot(output_slot_desc_->tuple_offset());
+    SetAnyVal(dst_slot, output_slot_desc_->type(), staging_output_val_);
+    update_batch_fn_(ctx_.get(), n, &batch_inputs_[0], staging_output_val_);
+    SetOutputSlot(staging_output_val_, dst);
+
+    start_row += n;
+    num_rows -= n;
+  }
+}
+
 void AggFnEvaluator::Merge(TupleRow* row, Tuple* dst) {
   return UpdateOrMerge(row, dst, fn_ptrs_.merge_fn);
 }
@@ -391,6 +473,247 @@ void AggFnEvaluator::Finalize(Tuple* tuple) {
   SerializeOrFinalize(tuple, fn_ptrs_.finalize_fn);
 }
 
+Status AggFnEvaluator::GetIrUpdateFn(LlvmCodeGen* codegen, StructType* tuple_struct,
+    Function** fn) {
+  Function* uda_fn;
+  RETURN_IF_ERROR(GetUdaFn(codegen, fn_ptrs_.update_fn, update_fn_symbol_, &uda_fn));
+  return CodegenUpdateOrMerge(codegen, tuple_struct, uda_fn, fn);
+}
+
+Status AggFnEvaluator::GetIrMergeFn(LlvmCodeGen* codegen, StructType* tuple_struct,
+    Function** fn) {
+  Function* uda_fn;
+  RETURN_IF_ERROR(GetUdaFn(codegen, fn_ptrs_.merge_fn, merge_fn_symbol_, &uda_fn));
+  return CodegenUpdateOrMerge(codegen, tuple_struct, uda_fn, fn);
+}
+
+Status AggFnEvaluator::GetUdaFn(LlvmCodeGen* codegen, void* fn_ptr,
+    const string& symbol, Function** uda_fn) {
+  if (function_type_ == TFunctionBinaryType::IR) {
+    // The UDA's module was linked in PrepareIrUda().
+    *uda_fn = codegen->module()->getFunction(symbol);
+    if (*uda_fn == NULL) {
+      stringstream ss;
+      ss << "Unable to locate function " << symbol
+         << " from LLVM module " << hdfs_location_;
+      return Status(ss.str());
+    }
+    return Status::OK;
+  }
+
+  DCHECK(fn_ptr != NULL);
+  string fn_name = symbol;
+  if (function_type_ == TFunctionBinaryType::BUILTIN) {
+    // The builtins are cross compiled from aggregate-functions.cc but the opcode
+    // registry only has their function ptrs. impalad exports its symbols, so use the
+    // symbol of the function ptr to look up the IR. Binaries that don't export their
+    // symbols (e.g. tests) may only find a nearby exported symbol, so the symbol's
+    // address must match exactly.
+    Dl_info info;
+    if (dladdr(fn_ptr, &info) != 0 && info.dli_sname != NULL &&
+        info.dli_saddr == fn_ptr) {
+      fn_name = info.dli_sname;
+      *uda_fn = codegen->module()->getFunction(fn_name);
+      if (*uda_fn != NULL && !(*uda_fn)->isDeclaration()) return Status::OK;
+    }
+    if (fn_name.empty()) fn_name = "AggregateFunction";
+  }
+
+  // Call the statically compiled function. Generate the llvm::FunctionType* for
+  // void Update(FunctionContext*, const *Val& input1, ..., *Val* dst) and map the
+  // declaration to the function ptr, like NativeUdfExpr::GetUdf().
+  vector<Type*> arg_types;
+  arg_types.push_back(codegen->GetPtrType("class.impala_udf::FunctionContext"));
+  for (int i = 0; i < input_exprs_.size(); ++i) {
+    Type* input_type = CodegenAnyVal::GetType(codegen, input_exprs_[i]->type());
+    arg_types.push_back(PointerType::get(input_type, 0));
+  }
+  Type* dst_type = CodegenAnyVal::GetType(codegen, output_slot_desc_->type());
+  arg_types.push_back(PointerType::get(dst_type, 0));
+  FunctionType* fn_type = FunctionType::get(codegen->void_type(), arg_types, false);
+  *uda_fn = Function::Create(
+      fn_type, GlobalValue::ExternalLinkage, fn_name, codegen->module());
+  codegen->execution_engine()->addGlobalMapping(*uda_fn, fn_ptr);
+  return Status::OK;
+}
+
+// IR generated for a UDA with a single int input and a bigint intermediate:
+// define void @UpdateSlot({ i8, i64 }* %agg_tuple, i8** %row) {
+// entry:
+//   %dst = alloca { i8, i64 }
+//   %src_raw = alloca i32
+//   %src = alloca i64
+//   %src_null_ptr = alloca i1
+//   store i64 1, i64* %src
+//   %0 = call i32 @SlotRef(i8** %row, i8* null, i1* %src_null_ptr)
+//   %child_null = load i1* %src_null_ptr
+//   br i1 %child_null, label %src_done, label %src_not_null
+//
+// src_not_null:                                     ; preds = %entry
+//   store i32 %0, i32* %src_raw
+//   ... ; set the IntVal from %src_raw
+//   store i64 %src_val, i64* %src
+//   br label %src_done
+//
+// src_done:                                         ; preds = %src_not_null, %entry
+//   %1 = bitcast i64* %src to %"struct.impala_udf::IntVal"*
+//   %dst_slot_ptr = getelementptr inbounds { i8, i64 }* %agg_tuple, i32 0, i32 1
+//   %dst_is_null = call i1 @IsNull({ i8, i64 }* %agg_tuple)
+//   ... ; set the BigIntVal from %dst_slot_ptr and %dst_is_null
+//   store { i8, i64 } %dst_val, { i8, i64 }* %dst
+//   %2 = bitcast { i8, i64 }* %dst to %"struct.impala_udf::BigIntVal"*
+//   call void @Update(%"class.impala_udf::FunctionContext"* inttoptr
+//       (i64 62859504 to %"class.impala_udf::FunctionContext"*),
+//       %"struct.impala_udf::IntVal"* %1, %"struct.impala_udf::BigIntVal"* %2)
+//   %result = load { i8, i64 }* %dst
+//   %3 = extractvalue { i8, i64 } %result, 0
+//   %is_null = trunc i8 %3 to i1
+//   br i1 %is_null, label %result_null, label %result_not_null
+//
+// result_null:                                      ; preds = %src_done
+//   call void @SetNull({ i8, i64 }* %agg_tuple)
+//   br label %ret
+//
+// result_not_null:                                  ; preds = %src_done
+//   call void @SetNotNull({ i8, i64 }* %agg_tuple)
+//   %val = extractvalue { i8, i64 } %result, 1
+//   store i64 %val, i64* %dst_slot_ptr
+//   br label %ret
+//
+// ret:                                              ; preds = %result_not_null, ...
+//   ret void
+// }
+Status AggFnEvaluator::CodegenUpdateOrMerge(LlvmCodeGen* codegen,
+    StructType* tuple_struct, Function* uda_fn, Function** fn) {
+  PrimitiveType dst_type = output_slot_desc_->type();
+  if (dst_type == TYPE_NULL || dst_type == TYPE_CHAR) {
+    return Status("Codegen for aggregate functions with a NULL or CHAR intermediate "
+        "type is not yet supported.");
+  }
+  for (int i = 0; i < input_exprs_.size(); ++i) {
+    PrimitiveType type = input_exprs_[i]->type();
+    if (type == TYPE_NULL || type == TYPE_CHAR) {
+      return Status("Codegen for aggregate functions with NULL or CHAR inputs is "
+          "not yet supported.");
+    }
+    if (input_exprs_[i]->codegen_fn() == NULL) {
+      return Status("The input exprs of the aggregate function cannot be codegen'd.");
+    }
+  }
+  if (uda_fn->arg_size() != input_exprs_.size() + 2 ||
+      !uda_fn->getReturnType()->isVoidTy()) {
+    stringstream ss;
+    ss << "Function " << uda_fn->getName().str() << " does not have the signature "
+       << "of an update or merge function with " << input_exprs_.size() << " inputs.";
+    return Status(ss.str());
+  }
+
+  LLVMContext& context = codegen->context();
+  PointerType* tuple_ptr = PointerType::get(tuple_struct, 0);
+  PointerType* ptr_type = codegen->ptr_type();
+
+  LlvmCodeGen::FnPrototype prototype(codegen, "UpdateSlot", codegen->void_type());
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("agg_tuple", tuple_ptr));
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("row", PointerType::get(ptr_type, 0)));
+
+  LlvmCodeGen::LlvmBuilder builder(context);
+  Value* args[2];
+  *fn = prototype.GeneratePrototype(&builder, &args[0]);
+
+  // The UDA takes the FunctionContext followed by pointers to the input *Vals and to the
+  // intermediate *Val.
+  Function::arg_iterator uda_arg = uda_fn->arg_begin();
+  vector<Value*> uda_args;
+  uda_args.push_back(codegen->CastPtrToLlvmPtr(uda_arg->getType(), ctx_.get()));
+  ++uda_arg;
+
+  // Evaluate the input exprs into *Vals
+  LlvmCodeGen::NamedVariable null_var("src_null_ptr", codegen->boolean_type());
+  Value* src_is_null_ptr = codegen->CreateEntryBlockAlloca(*fn, null_var);
+  for (int i = 0; i < input_exprs_.size(); ++i, ++uda_arg) {
+    Expr* input_expr = input_exprs_[i];
+    PrimitiveType type = input_expr->type();
+    LlvmCodeGen::NamedVariable src_var("src", CodegenAnyVal::GetType(codegen, type));
+    Value* src_ptr = codegen->CreateEntryBlockAlloca(*fn, src_var);
+    builder.CreateStore(CodegenAnyVal::GetNullVal(codegen, type), src_ptr);
+
+    BasicBlock* src_not_null_block, *src_done_block;
+    codegen->CreateIfElseBlocks(*fn, "src_not_null", "src_done",
+        &src_not_null_block, &src_done_block);
+    Value* expr_args[] = { args[1], ConstantPointerNull::get(ptr_type), src_is_null_ptr };
+    Value* src_value = input_expr->CodegenGetValue(codegen, builder.GetInsertBlock(),
+        expr_args, src_done_block, src_not_null_block);
+
+    builder.SetInsertPoint(src_not_null_block);
+    // String exprs return a StringValue*, all other exprs return the native type.
+    Value* src_raw_ptr = src_value;
+    if (type != TYPE_STRING) {
+      LlvmCodeGen::NamedVariable raw_var("src_raw", codegen->GetType(type));
+      src_raw_ptr = codegen->CreateEntryBlockAlloca(*fn, raw_var);
+      builder.CreateStore(src_value, src_raw_ptr);
+    }
+    CodegenAnyVal src = CodegenAnyVal::GetNonNullVal(codegen, &builder, type, "src_val");
+    src.SetFromRawPtr(src_raw_ptr);
+    builder.CreateStore(src.value(), src_ptr);
+    builder.CreateBr(src_done_block);
+
+    builder.SetInsertPoint(src_done_block);
+    uda_args.push_back(builder.CreateBitCast(src_ptr, uda_arg->getType()));
+  }
+
+  // Load the dst slot into a *Val
+  Value* dst_slot_ptr =
+      builder.CreateStructGEP(args[0], output_slot_desc_->field_idx(), "dst_slot_ptr");
+  Value* dst_is_null = codegen->false_value();
+  if (output_slot_desc_->is_nullable()) {
+    Function* is_null_fn = output_slot_desc_->CodegenIsNull(codegen, tuple_struct);
+    dst_is_null = builder.CreateCall(is_null_fn, args[0], "dst_is_null");
+  }
+  CodegenAnyVal dst =
+      CodegenAnyVal::GetNonNullVal(codegen, &builder, dst_type, "dst_val");
+  dst.SetFromRawPtr(dst_slot_ptr);
+  dst.SetIsNull(dst_is_null);
+  LlvmCodeGen::NamedVariable dst_var("dst", CodegenAnyVal::GetType(codegen, dst_type));
+  Value* dst_ptr = codegen->CreateEntryBlockAlloca(*fn, dst_var);
+  builder.CreateStore(dst.value(), dst_ptr);
+  uda_args.push_back(builder.CreateBitCast(dst_ptr, uda_arg->getType()));
+
+  builder.CreateCall(uda_fn, uda_args);
+
+  // Write the result back to the dst slot
+  CodegenAnyVal result(codegen, &builder, dst_type,
+      builder.CreateLoad(dst_ptr, "result"), "result");
+  if (output_slot_desc_->is_nullable()) {
+    BasicBlock* result_null_block, *result_not_null_block;
+    codegen->CreateIfElseBlocks(*fn, "result_null", "result_not_null",
+        &result_null_block, &result_not_null_block);
+    BasicBlock* ret_block = BasicBlock::Create(context, "ret", *fn);
+    builder.CreateCondBr(result.GetIsNull(), result_null_block, result_not_null_block);
+
+    builder.SetInsertPoint(result_null_block);
+    Function* set_null_fn =
+        output_slot_desc_->CodegenUpdateNull(codegen, tuple_struct, true);
+    builder.CreateCall(set_null_fn, args[0]);
+    builder.CreateBr(ret_block);
+
+    builder.SetInsertPoint(result_not_null_block);
+    Function* clear_null_fn =
+        output_slot_desc_->CodegenUpdateNull(codegen, tuple_struct, false);
+    builder.CreateCall(clear_null_fn, args[0]);
+    result.ToRawPtr(dst_slot_ptr);
+    builder.CreateBr(ret_block);
+
+    builder.SetInsertPoint(ret_block);
+  } else {
+    result.ToRawPtr(dst_slot_ptr);
+  }
+  builder.CreateRetVoid();
+
+  *fn = codegen->FinalizeFunction(*fn);
+  if (*fn == NULL) return Status("Codegen'd aggregate function failed verification.");
+  return Status::OK;
+}
+
 string AggFnEvaluator::DebugString(const vector<AggFnEvaluator*>& exprs) {
   stringstream out;
   out << "[";
@@ -23,9 +23,16 @@
 
 #include "gen-cpp/Exprs_types.h"
 
+namespace llvm {
+  class Function;
+  class StructType;
+}
+
 namespace impala {
 
 class AggregationNode;
+class LlvmCodeGen;
+class RowBatch;
 class TExprNode;
 
 // This class evaluates aggregate functions. Aggregate funtions can either be
@@ -71,13 +78,30 @@ class AggFnEvaluator {
   void Serialize(Tuple* dst);
   void Finalize(Tuple* dst);
 
-  // TODO: implement codegen path. These functions would return IR functions with
-  // the same signature as the interpreted ones above.
-  // Function* GetIrInitFn();
-  // Function* GetIrUpdateFn();
-  // Function* GetIrMergeFn();
-  // Function* GetIrSerializeFn();
-  // Function* GetIrFinalizeFn();
+  // Returns true if the UDA has inputs and provides a batch version of its update
+  // function (see UdaUpdateBatch in udf.h), which UpdateBatch() calls.
+  bool has_update_batch() const { return update_batch_fn_ != NULL; }
+
+  // Same as calling Update() with each of the 'num_rows' rows of 'batch' starting at
+  // 'start_row', but hands the input values to the UDA a column at a time.
+  void UpdateBatch(RowBatch* batch, int start_row, int num_rows, Tuple* dst);
+
+  // Returns in *fn an IR function that does the same as Update(), with the signature
+  //   void UpdateSlot(AggTuple* agg_tuple, char** row)
+  // where 'tuple_struct' is the llvm type of AggTuple. The input exprs are evaluated
+  // with their codegen'd functions and the update function is called directly: the
+  // cross compiled IR of builtins and the linked IR of IR UDAs can be inlined, native
+  // UDAs are called through their function pointer.
+  // Returns an error status if this aggregate function cannot be codegen'd.
+  Status GetIrUpdateFn(LlvmCodeGen* codegen, llvm::StructType* tuple_struct,
+      llvm::Function** fn);
+
+  // Same as GetIrUpdateFn() for Merge().
+  Status GetIrMergeFn(LlvmCodeGen* codegen, llvm::StructType* tuple_struct,
+      llvm::Function** fn);
+
+  // TODO: Init(), Serialize() and Finalize() are called once per group so they are
+  // always interpreted. For IR UDAs, the functions they call are jitted in Prepare().
 
  private:
   const ColumnType return_type_;
@@ -97,6 +121,7 @@ class AggFnEvaluator {
   std::string merge_fn_symbol_;
   std::string serialize_fn_symbol_;
   std::string finalize_fn_symbol_;
+  std::string update_batch_fn_symbol_;
 
   // Unowned
   const SlotDescriptor* output_slot_desc_;
@@ -114,9 +139,17 @@ class AggFnEvaluator {
   impala_udf::AnyVal* staging_output_val_;
 
   // Function ptrs to the aggregate function. This is either populated from the
-  // opcode registry for builtins or from the external binary for native UDAs.
+  // opcode registry for builtins, from the external binary for native UDAs or from
+  // the jitted functions for IR UDAs.
   OpcodeRegistry::AggFnDescriptor fn_ptrs_;
 
+  // Batch version of the update function, or NULL if the UDA doesn't have one.
+  impala_udf::UdaUpdateBatch update_batch_fn_;
+
+  // Input columns passed to update_batch_fn_, with room for batch_capacity_ rows each.
+  int batch_capacity_;
+  std::vector<impala_udf::ColumnVal> batch_inputs_;
+
   // Use Create() instead.
   AggFnEvaluator(const TAggregateFunctionCall& desc);
 
@@ -132,6 +165,20 @@ class AggFnEvaluator {
   // taking TupleRow to the UDA signature taking AnvVals.
   void SerializeOrFinalize(Tuple* tuple, void* fn);
 
+  // Links the IR UDA's module into the codegen module and sets up fn_ptrs_ to be
+  // populated with the jitted functions.
+  Status PrepareIrUda(RuntimeState* state);
+
+  // Returns in *uda_fn the llvm::Function for the update or merge function 'fn_ptr'
+  // with symbol 'symbol' (only set for UDAs).
+  Status GetUdaFn(LlvmCodeGen* codegen, void* fn_ptr, const std::string& symbol,
+      llvm::Function** uda_fn);
+
+  // Generates the UpdateSlot function for GetIrUpdateFn() and GetIrMergeFn(), calling
+  // 'uda_fn'.
+  Status CodegenUpdateOrMerge(LlvmCodeGen* codegen, llvm::StructType* tuple_struct,
+      llvm::Function* uda_fn, llvm::Function** fn);
+
   // Writes the result in src into dst pointed to by output_slot_desc_
   void SetOutputSlot(const impala_udf::AnyVal* src, Tuple* dst);
   // Sets 'dst' to the value from 'slot'.
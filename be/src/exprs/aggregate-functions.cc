@@ -24,9 +24,10 @@
 
 using namespace std;
 
-// TODO: this file should be cross compiled and then all of the builtin
-// aggregate functions will have a codegen enabled path. Then we can remove
-// the custom code in aggregation node.
+// This file is cross compiled so that the aggregation node's codegen'd loop can inline
+// the builtin aggregate functions (see AggFnEvaluator::GetIrUpdateFn()).
+// TODO: remove the hand written codegen for count, min, max and sum in the
+// aggregation node.
 namespace impala {
 
 // Delimiter to use if the separator is NULL.
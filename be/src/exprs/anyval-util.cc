@@ -14,6 +14,9 @@
 
 #include "exprs/anyval-util.h"
 
+#include "runtime/string-value.h"
+#include "runtime/timestamp-value.h"
+
 using namespace llvm;
 using namespace impala_udf;
 
@@ -169,6 +172,96 @@ void CodegenAnyVal::SetFromRawPtr(Value* raw_ptr) {
   }
 }
 
+Value* CodegenAnyVal::GetIsNull(const char* name) {
+  Value* v = value_;
+  if (type_ == TYPE_BIGINT || type_ == TYPE_DOUBLE || type_ == TYPE_STRING ||
+      type_ == TYPE_TIMESTAMP) {
+    // Lowered type is a struct. 'is_null' is the first byte of the first value.
+    v = builder_->CreateExtractValue(value_, 0);
+  }
+  // 'is_null' is the first byte of the integer.
+  return builder_->CreateTrunc(v, codegen_->boolean_type(), name);
+}
+
+Value* CodegenAnyVal::GetVal(const char* name) {
+  DCHECK(type_ != TYPE_STRING) << "Use GetPtr and GetLen for StringVals";
+  DCHECK(type_ != TYPE_TIMESTAMP) << "Use GetDate and GetTimeOfDay for TimestampVals";
+  switch(type_) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT: {
+      // Lowered type is an integer. Get the high bytes.
+      int num_bits = GetByteSize(type_) * 8;
+      return GetHighBits(num_bits, value_, codegen_->GetType(type_), name);
+    }
+    case TYPE_FLOAT: {
+      // Same as above, but we must cast the value to a float.
+      Value* v = GetHighBits(32, value_, codegen_->int_type());
+      return builder_->CreateBitCast(v, codegen_->GetType(TYPE_FLOAT), name);
+    }
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+      // Lowered type is of form { i8, * }. Get the second value.
+      return builder_->CreateExtractValue(value_, 1, name);
+    default:
+      DCHECK(false) << "Unsupported type: " << type_;
+      return NULL;
+  }
+}
+
+Value* CodegenAnyVal::GetPtr() {
+  // Get the second pointer value.
+  DCHECK_EQ(type_, TYPE_STRING);
+  return builder_->CreateExtractValue(value_, 1, "ptr");
+}
+
+Value* CodegenAnyVal::GetLen() {
+  // Get the high bytes of the first value.
+  DCHECK_EQ(type_, TYPE_STRING);
+  Value* v = builder_->CreateExtractValue(value_, 0);
+  return GetHighBits(32, v, codegen_->int_type(), "len");
+}
+
+Value* CodegenAnyVal::GetTimeOfDay() {
+  // Get the second i64 value.
+  DCHECK_EQ(type_, TYPE_TIMESTAMP);
+  return builder_->CreateExtractValue(value_, 1, "time_of_day");
+}
+
+Value* CodegenAnyVal::GetDate() {
+  // Get the high bytes of the first value.
+  DCHECK_EQ(type_, TYPE_TIMESTAMP);
+  Value* v = builder_->CreateExtractValue(value_, 0);
+  return GetHighBits(32, v, codegen_->int_type(), "date");
+}
+
+void CodegenAnyVal::ToRawPtr(Value* raw_ptr) {
+  Value* val_ptr =
+      builder_->CreateBitCast(raw_ptr, codegen_->GetPtrType(type_), "val_ptr");
+  if (type_ == TYPE_STRING) {
+    // Convert StringVal to StringValue
+    Value* ptr_ptr = builder_->CreateStructGEP(val_ptr, 0, "ptr_ptr");
+    builder_->CreateStore(GetPtr(), ptr_ptr);
+    Value* len_ptr = builder_->CreateStructGEP(val_ptr, 1, "len_ptr");
+    builder_->CreateStore(GetLen(), len_ptr);
+  } else if (type_ == TYPE_TIMESTAMP) {
+    // Convert TimestampVal to TimestampValue
+    Value* time_of_day_ptr = builder_->CreateStructGEP(val_ptr, 0, "time_of_day_ptr");
+    // Cast boost::posix_time::time_duration to i64
+    Value* time_of_day_cast =
+        builder_->CreateBitCast(time_of_day_ptr, codegen_->GetPtrType(TYPE_BIGINT));
+    builder_->CreateStore(GetTimeOfDay(), time_of_day_cast);
+    Value* date_ptr = builder_->CreateStructGEP(val_ptr, 1, "date_ptr");
+    // Cast boost::gregorian::date to i32
+    Value* date_cast = builder_->CreateBitCast(date_ptr, codegen_->GetPtrType(TYPE_INT));
+    builder_->CreateStore(GetDate(), date_cast);
+  } else {
+    // val_ptr is a native type
+    builder_->CreateStore(GetVal(), val_ptr);
+  }
+}
+
 // Example output: (num_bits = 8)
 // %1 = zext i1 %src to i16
 // %2 = shl i16 %1, 8
@@ -183,6 +276,15 @@ Value* CodegenAnyVal::SetHighBits(int num_bits, Value* src, Value* dst,
   return builder_->CreateOr(masked_dst, shifted_src, name);
 }
 
+// Example output: (num_bits = 8, type = i8)
+// %1 = lshr i16 %v, 8
+// %2 = trunc i16 %1 to i8
+Value* CodegenAnyVal::GetHighBits(int num_bits, Value* v, Type* type,
+                                  const char* name) {
+  Value* shifted = builder_->CreateLShr(v, num_bits);
+  return builder_->CreateTrunc(shifted, type, name);
+}
+
 Value* CodegenAnyVal::GetNullVal(LlvmCodeGen* codegen, PrimitiveType type) {
   Type* val_type = GetType(codegen, type);
   if (val_type->isStructTy()) {
@@ -208,6 +310,50 @@ CodegenAnyVal CodegenAnyVal::GetNonNullVal(LlvmCodeGen* codegen,
   return CodegenAnyVal(codegen, builder, type, value, name);
 }
 
+void AnyValUtil::SetColumnVal(const void* slot, PrimitiveType type, int i,
+    ColumnVal* column) {
+  column->is_null[i] = (slot == NULL);
+  if (slot == NULL) return;
+  switch (type) {
+    case TYPE_BOOLEAN:
+      reinterpret_cast<bool*>(column->values)[i] = *reinterpret_cast<const bool*>(slot);
+      return;
+    case TYPE_TINYINT:
+      reinterpret_cast<int8_t*>(column->values)[i] =
+          *reinterpret_cast<const int8_t*>(slot);
+      return;
+    case TYPE_SMALLINT:
+      reinterpret_cast<int16_t*>(column->values)[i] =
+          *reinterpret_cast<const int16_t*>(slot);
+      return;
+    case TYPE_INT:
+      reinterpret_cast<int32_t*>(column->values)[i] =
+          *reinterpret_cast<const int32_t*>(slot);
+      return;
+    case TYPE_BIGINT:
+      reinterpret_cast<int64_t*>(column->values)[i] =
+          *reinterpret_cast<const int64_t*>(slot);
+      return;
+    case TYPE_FLOAT:
+      reinterpret_cast<float*>(column->values)[i] = *reinterpret_cast<const float*>(slot);
+      return;
+    case TYPE_DOUBLE:
+      reinterpret_cast<double*>(column->values)[i] =
+          *reinterpret_cast<const double*>(slot);
+      return;
+    case TYPE_STRING:
+      reinterpret_cast<const StringValue*>(slot)->ToStringVal(
+          &reinterpret_cast<StringVal*>(column->values)[i]);
+      return;
+    case TYPE_TIMESTAMP:
+      reinterpret_cast<const TimestampValue*>(slot)->ToTimestampVal(
+          &reinterpret_cast<TimestampVal*>(column->values)[i]);
+      return;
+    default:
+      DCHECK(false) << "Unsupported type: " << type;
+  }
+}
+
 AnyVal* CreateAnyVal(ObjectPool* pool, PrimitiveType type) {
   switch(type) {
     case TYPE_NULL: return pool->Add(new AnyVal);
@@ -119,6 +119,30 @@ class AnyValUtil {
         return 0;
     }
   }
+
+  // Returns the byte size of a value of type t in a ColumnVal.
+  static int ColumnValSize(PrimitiveType t) {
+    switch (t) {
+      case TYPE_BOOLEAN: return sizeof(bool);
+      case TYPE_TINYINT: return sizeof(int8_t);
+      case TYPE_SMALLINT: return sizeof(int16_t);
+      case TYPE_INT: return sizeof(int32_t);
+      case TYPE_BIGINT: return sizeof(int64_t);
+      case TYPE_FLOAT: return sizeof(float);
+      case TYPE_DOUBLE: return sizeof(double);
+      case TYPE_STRING: return sizeof(StringVal);
+      case TYPE_TIMESTAMP: return sizeof(TimestampVal);
+      default:
+        DCHECK(false) << t;
+        return 0;
+    }
+  }
+
+  // Sets the ith value of 'column' of type 'type' from 'slot'. 'slot' is NULL or points
+  // to a native type, StringValue or TimestampValue (i.e. the value returned by an
+  // interpreted compute fn).
+  static void SetColumnVal(const void* slot, PrimitiveType type, int i,
+      ColumnVal* column);
 };
 
 // Class for handling AnyVal subclasses during codegen. Codegen functions should use this
@@ -200,6 +224,26 @@ class CodegenAnyVal {
   // interpreted compute fn).
   void SetFromRawPtr(llvm::Value* raw_ptr);
 
+  // Returns the 'is_null' field of the *Val as an i1.
+  llvm::Value* GetIsNull(const char* name = "is_null");
+
+  // Returns the 'val' field of the *Val. Do not call if this represents a StringVal or
+  // TimestampVal.
+  llvm::Value* GetVal(const char* name = "val");
+
+  // Getters for StringVals.
+  llvm::Value* GetPtr();
+  llvm::Value* GetLen();
+
+  // Getters for TimestampVals.
+  llvm::Value* GetDate();
+  llvm::Value* GetTimeOfDay();
+
+  // Stores this *Val's value to 'raw_ptr', which should be a pointer to a native type,
+  // StringValue, or TimestampValue. This is the inverse of SetFromRawPtr() and ignores
+  // 'is_null'.
+  void ToRawPtr(llvm::Value* raw_ptr);
+
  private:
   PrimitiveType type_;
   llvm::Value* value_;
@@ -213,6 +257,11 @@ class CodegenAnyVal {
   // 'src' must have width <= 'num_bits' and 'dst' must have width = 'num_bits' * 2.
   llvm::Value* SetHighBits(int num_bits, llvm::Value* src, llvm::Value* dst,
                            const char* name = "");
+
+  // Helper function for getting the top (most significant) half of 'v', which must
+  // have width = 'num_bits' * 2. The result is truncated to 'type'.
+  llvm::Value* GetHighBits(int num_bits, llvm::Value* v, llvm::Type* type,
+                           const char* name = "");
 };
 
 // Creates the corresponding AnyVal subclass for type. The object is added to the pool.
@@ -26,6 +26,9 @@ class TExprNode;
 
 class ArithmeticExpr: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new ArithmeticExpr(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
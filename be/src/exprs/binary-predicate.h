@@ -25,6 +25,9 @@ namespace impala {
 
 class BinaryPredicate : public Predicate {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new BinaryPredicate(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
  
  protected:
@@ -25,6 +25,7 @@ class TExprNode;
 
 class BoolLiteral: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new BoolLiteral(*this)); }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
@@ -24,6 +24,10 @@ namespace impala {
 class TExprNode;
 
 class CaseExpr: public Expr {
+ public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new CaseExpr(*this)); }
+  virtual bool IsConditional() const { return true; }
+
  protected:
   friend class Expr;
   friend class ComputeFunctions;
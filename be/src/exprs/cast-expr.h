@@ -25,6 +25,7 @@ class TExprNode;
 
 class CastExpr: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new CastExpr(*this)); }
   virtual llvm::Function* Codegen(LlvmCodeGen* codegen);
 
   virtual Status Prepare(RuntimeState* state, const RowDescriptor& desc);
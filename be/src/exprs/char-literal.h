@@ -24,6 +24,9 @@ class TExprNode;
 
 // Literal class for CHAR(N) type.
 class CharLiteral: public Expr {
+ public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new CharLiteral(*this)); }
+
  protected:
   friend class Expr;
 
@@ -24,7 +24,11 @@ namespace impala {
 
 class CompoundPredicate: public Predicate {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new CompoundPredicate(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* codegen);
+  virtual bool IsConditional() const { return true; }
 
  protected:
   friend class Expr;
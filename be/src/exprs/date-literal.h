@@ -24,6 +24,9 @@ namespace impala {
 class TExprNode;
 
 class DateLiteral: public Expr {
+ public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new DateLiteral(*this)); }
+
  protected:
   friend class Expr;
 
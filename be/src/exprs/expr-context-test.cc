@@ -0,0 +1,309 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "codegen/llvm-codegen.h"
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "exprs/expr.h"
+#include "exprs/expr-context.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
+#include "runtime/runtime-state.h"
+#include "runtime/string-value.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple-row.h"
+#include "testutil/desc-tbl-builder.h"
+#include "gen-cpp/Exprs_types.h"
+
+using namespace boost;
+using namespace impala;
+using namespace std;
+
+namespace impala {
+
+// Signature of the codegen'd function of a boolean expr.
+typedef bool (*BoolExprFn)(TupleRow* row, Expr** state_data, bool* is_null);
+
+// Patterns that exercise all the compute functions of LikePredicate.
+const char* LIKE_PATTERNS[] = { "ab%", "%bc%", "%bc", "abc", "a_c", "%b%c" };
+
+// Inputs for the patterns above and whether they match, by pattern.
+const char* LIKE_INPUTS[] = { "abc", "xbc", "ab", "" };
+const bool LIKE_RESULTS[][4] = {
+  { true, false, true, false },
+  { true, true, false, false },
+  { true, true, false, false },
+  { true, false, false, false },
+  { true, false, false, false },
+  { true, true, false, false },
+};
+
+class ExprContextTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    // Codegen is enabled by default, so the RuntimeState creates the LlvmCodeGen.
+    TQueryContext query_ctxt;
+    state_.reset(new RuntimeState(TUniqueId(), TUniqueId(), query_ctxt, "", &exec_env_));
+    ASSERT_TRUE(state_->InitMemTrackers(TUniqueId(), -1).ok());
+    ASSERT_TRUE(state_->codegen() != NULL);
+
+    DescriptorTblBuilder builder(&pool_);
+    builder.DeclareTuple() << TYPE_STRING;
+    desc_tbl_ = builder.Build();
+    state_->set_desc_tbl(desc_tbl_);
+    vector<bool> nullable_tuples(1, false);
+    vector<TTupleId> tuple_ids(1, (TTupleId) 0);
+    row_desc_ = pool_.Add(new RowDescriptor(*desc_tbl_, tuple_ids, nullable_tuples));
+    slot_desc_ = desc_tbl_->GetTupleDescriptor(0)->slots()[0];
+
+    tuple_buffer_.resize(desc_tbl_->GetTupleDescriptor(0)->byte_size());
+    row_ = reinterpret_cast<TupleRow*>(&tuple_ptr_);
+    row_->SetTuple(0, reinterpret_cast<Tuple*>(&tuple_buffer_[0]));
+  }
+
+  virtual void TearDown() {
+    state_.reset();
+  }
+
+  static TExprNode CreateNode(TExprNodeType::type node_type, PrimitiveType type,
+      int num_children) {
+    TExprNode node;
+    node.node_type = node_type;
+    node.type = ColumnType(type).ToThrift();
+    node.num_children = num_children;
+    return node;
+  }
+
+  // Adds a ref to the string slot to 'texpr'.
+  void AddSlotRef(TExpr* texpr) {
+    TExprNode node = CreateNode(TExprNodeType::SLOT_REF, TYPE_STRING, 0);
+    TSlotRef slot_ref;
+    slot_ref.slot_id = slot_desc_->id();
+    node.__set_slot_ref(slot_ref);
+    texpr->nodes.push_back(node);
+  }
+
+  // Adds a call to the builtin udf_lower(), which is implemented against the UDF
+  // interface, to 'texpr'. Its argument must be added next.
+  static void AddUdfLower(TExpr* texpr) {
+    TExprNode node = CreateNode(TExprNodeType::FUNCTION_CALL, TYPE_STRING, 1);
+    node.__set_opcode(TExprOpcode::UDF_STRING_LOWER_STRINGVALUE);
+    TFunctionCallExpr fn_call;
+    fn_call.fn.name.function_name = "udf_lower";
+    fn_call.fn.binary_type = TFunctionBinaryType::BUILTIN;
+    fn_call.fn.arg_types.push_back(ColumnType(TYPE_STRING).ToThrift());
+    fn_call.fn.ret_type = ColumnType(TYPE_STRING).ToThrift();
+    fn_call.fn.has_var_args = false;
+    node.__set_fn_call_expr(fn_call);
+    texpr->nodes.push_back(node);
+  }
+
+  // Returns the expr "<string slot> LIKE 'pattern'", or "udf_lower(<string slot>) LIKE
+  // 'pattern'" if 'lower' is true.
+  TExpr CreateLike(const string& pattern, bool lower = false) {
+    TExpr texpr;
+    TExprNode like = CreateNode(TExprNodeType::LIKE_PRED, TYPE_BOOLEAN, 2);
+    like.__set_opcode(TExprOpcode::LIKE);
+    TLikePredicate like_pred;
+    like_pred.escape_char = "\\";
+    like.__set_like_pred(like_pred);
+    texpr.nodes.push_back(like);
+    if (lower) AddUdfLower(&texpr);
+    AddSlotRef(&texpr);
+    TExprNode literal = CreateNode(TExprNodeType::STRING_LITERAL, TYPE_STRING, 0);
+    TStringLiteral string_literal;
+    string_literal.value = pattern;
+    literal.__set_string_literal(string_literal);
+    texpr.nodes.push_back(literal);
+    return texpr;
+  }
+
+  // Sets the string slot of row_ to 'value', or to NULL if 'value' is NULL.
+  void SetSlot(const char* value) {
+    Tuple* tuple = row_->GetTuple(0);
+    if (value == NULL) {
+      tuple->SetNull(slot_desc_->null_indicator_offset());
+      return;
+    }
+    tuple->SetNotNull(slot_desc_->null_indicator_offset());
+    StringValue* slot =
+        reinterpret_cast<StringValue*>(tuple->GetSlot(slot_desc_->tuple_offset()));
+    *slot = StringValue(const_cast<char*>(value), strlen(value));
+  }
+
+  // Returns the result of the boolean 'expr' for row_: 0 or 1, or -1 if it is NULL.
+  int Evaluate(Expr* expr) {
+    void* value = expr->GetValue(row_);
+    if (value == NULL) return -1;
+    return *reinterpret_cast<bool*>(value);
+  }
+
+  // Checks that 'clone' has the same shape as 'ctx', consists of different exprs and
+  // numbers them the same way.
+  void ValidateClone(ExprContext* ctx, ExprContext* clone) {
+    ASSERT_EQ(ctx->num_roots(), clone->num_roots());
+    Expr** exprs = ctx->expr_table();
+    Expr** clone_exprs = clone->expr_table();
+    for (int i = 0; i < clone->num_roots(); ++i) {
+      EXPECT_EQ(clone->roots()[i], clone_exprs[i]);
+    }
+    int num_exprs = 0;
+    for (int i = 0; i < ctx->num_roots(); ++i) num_exprs += CountExprs(ctx->roots()[i]);
+    for (int i = 0; i < num_exprs; ++i) {
+      EXPECT_NE(exprs[i], clone_exprs[i]);
+      EXPECT_EQ(i, exprs[i]->context_index());
+      EXPECT_EQ(i, clone_exprs[i]->context_index());
+      EXPECT_EQ(exprs[i]->type(), clone_exprs[i]->type());
+      EXPECT_EQ(exprs[i]->GetNumChildren(), clone_exprs[i]->GetNumChildren());
+    }
+  }
+
+  static int CountExprs(Expr* root) {
+    int count = 1;
+    for (int i = 0; i < root->GetNumChildren(); ++i) {
+      count += CountExprs(root->GetChild(i));
+    }
+    return count;
+  }
+
+  ExecEnv exec_env_;
+  scoped_ptr<RuntimeState> state_;
+  ObjectPool pool_;
+  DescriptorTbl* desc_tbl_;
+  RowDescriptor* row_desc_;
+  SlotDescriptor* slot_desc_;
+  vector<uint8_t> tuple_buffer_;
+  Tuple* tuple_ptr_;
+  TupleRow* row_;
+};
+
+// Clones evaluate like the original, with their own copies of the exprs and results.
+// The LIKE patterns cover every compute fn of LikePredicate, so this also tests
+// LikePredicate::Copy().
+TEST_F(ExprContextTest, Clone) {
+  vector<TExpr> texprs;
+  int num_patterns = sizeof(LIKE_PATTERNS) / sizeof(LIKE_PATTERNS[0]);
+  for (int i = 0; i < num_patterns; ++i) {
+    texprs.push_back(CreateLike(LIKE_PATTERNS[i]));
+  }
+  ExprContext* ctx;
+  ASSERT_TRUE(
+      ExprContext::Create(&pool_, texprs, state_.get(), *row_desc_, false, &ctx).ok());
+  ExprContext* clone;
+  ASSERT_TRUE(ctx->Clone(state_.get(), &clone).ok());
+  ValidateClone(ctx, clone);
+  ASSERT_TRUE(state_->codegen()->OptimizeModule().ok());
+
+  int num_inputs = sizeof(LIKE_INPUTS) / sizeof(LIKE_INPUTS[0]);
+  for (int i = 0; i < num_patterns; ++i) {
+    Expr* expr = ctx->roots()[i];
+    Expr* clone_expr = clone->roots()[i];
+    for (int j = 0; j < num_inputs; ++j) {
+      SetSlot(LIKE_INPUTS[j]);
+      EXPECT_EQ(LIKE_RESULTS[i][j], Evaluate(clone_expr))
+          << LIKE_INPUTS[j] << " LIKE " << LIKE_PATTERNS[i];
+      // The clone's result is not overwritten by evaluating the original on
+      // another row.
+      void* clone_result = clone_expr->GetValue(row_);
+      SetSlot("no match");
+      EXPECT_EQ(0, Evaluate(expr));
+      EXPECT_EQ(LIKE_RESULTS[i][j], *reinterpret_cast<bool*>(clone_result))
+          << LIKE_INPUTS[j] << " LIKE " << LIKE_PATTERNS[i];
+    }
+    SetSlot(NULL);
+    EXPECT_EQ(-1, Evaluate(clone_expr));
+  }
+}
+
+// The codegen'd adapter for exprs without an IR implementation evaluates the expr of
+// the context whose expr table is passed as 'state_data'.
+TEST_F(ExprContextTest, IrExprGetValueRouting) {
+  vector<TExpr> texprs_a(1, CreateLike("a%"));
+  vector<TExpr> texprs_b(1, CreateLike("b%"));
+  ExprContext* ctx_a;
+  ASSERT_TRUE(ExprContext::Create(
+      &pool_, texprs_a, state_.get(), *row_desc_, false, &ctx_a).ok());
+  ExprContext* ctx_b;
+  ASSERT_TRUE(ExprContext::Create(
+      &pool_, texprs_b, state_.get(), *row_desc_, true, &ctx_b).ok());
+  ExprContext* clone_a;
+  ASSERT_TRUE(ctx_a->Clone(state_.get(), &clone_a).ok());
+  ASSERT_TRUE(ctx_a->roots()[0]->codegen_fn() != NULL);
+
+  void* jitted_fn = NULL;
+  state_->codegen()->AddFunctionToJit(ctx_a->roots()[0]->codegen_fn(), &jitted_fn);
+  ASSERT_TRUE(state_->codegen()->OptimizeModule().ok());
+  ASSERT_TRUE(jitted_fn != NULL);
+  BoolExprFn fn = reinterpret_cast<BoolExprFn>(jitted_fn);
+
+  SetSlot("abc");
+  bool is_null = true;
+  // Without an expr table, the expr the function was generated for is evaluated.
+  EXPECT_TRUE(fn(row_, NULL, &is_null));
+  EXPECT_FALSE(is_null);
+  EXPECT_TRUE(fn(row_, ctx_a->expr_table(), &is_null));
+  EXPECT_TRUE(fn(row_, clone_a->expr_table(), &is_null));
+  // ctx_b's expr has the same index, so it is evaluated instead.
+  EXPECT_FALSE(fn(row_, ctx_b->expr_table(), &is_null));
+  EXPECT_FALSE(is_null);
+
+  SetSlot("bcd");
+  EXPECT_FALSE(fn(row_, clone_a->expr_table(), &is_null));
+  EXPECT_TRUE(fn(row_, ctx_b->expr_table(), &is_null));
+  SetSlot(NULL);
+  fn(row_, clone_a->expr_table(), &is_null);
+  EXPECT_TRUE(is_null);
+}
+
+// Trees with exprs that cannot be copied, like UDF calls, are created again from
+// thrift. They are numbered like the originals and evaluate the same way.
+TEST_F(ExprContextTest, CloneWithUdf) {
+  vector<TExpr> texprs;
+  texprs.push_back(CreateLike("ab%", true));
+  texprs.push_back(CreateLike("%bc"));
+  ExprContext* ctx;
+  ASSERT_TRUE(
+      ExprContext::Create(&pool_, texprs, state_.get(), *row_desc_, false, &ctx).ok());
+  ExprContext* clone;
+  ASSERT_TRUE(ctx->Clone(state_.get(), &clone).ok());
+  ValidateClone(ctx, clone);
+  // The UDF of the recreated tree is jitted with the rest of the module.
+  ASSERT_TRUE(state_->codegen()->OptimizeModule().ok());
+
+  const char* inputs[] = { "ABC", "abc", "xbc" };
+  const bool udf_results[] = { true, true, false };
+  for (int i = 0; i < 3; ++i) {
+    SetSlot(inputs[i]);
+    EXPECT_EQ(udf_results[i], Evaluate(ctx->roots()[0])) << inputs[i];
+    EXPECT_EQ(udf_results[i], Evaluate(clone->roots()[0])) << inputs[i];
+    EXPECT_EQ(Evaluate(ctx->roots()[1]), Evaluate(clone->roots()[1])) << inputs[i];
+  }
+  SetSlot(NULL);
+  EXPECT_EQ(-1, Evaluate(clone->roots()[0]));
+}
+
+}
+
+int main(int argc, char** argv) {
+  InitCommonRuntime(argc, argv, false);
+  LlvmCodeGen::InitializeLlvm();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
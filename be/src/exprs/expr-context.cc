@@ -0,0 +1,86 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "exprs/expr-context.h"
+
+#include "common/logging.h"
+#include "common/object-pool.h"
+#include "exprs/expr.h"
+
+using namespace impala;
+using namespace std;
+
+ExprContext::ExprContext(ObjectPool* pool, const vector<TExpr>& texprs,
+    const RowDescriptor& row_desc)
+  : pool_(pool),
+    texprs_(texprs),
+    row_desc_(row_desc) {
+}
+
+Status ExprContext::Create(ObjectPool* pool, const vector<TExpr>& texprs,
+    RuntimeState* state, const RowDescriptor& row_desc, bool disable_codegen,
+    ExprContext** ctx) {
+  ExprContext* new_ctx = pool->Add(new ExprContext(pool, texprs, row_desc));
+  RETURN_IF_ERROR(Expr::CreateExprTrees(pool, texprs, &new_ctx->roots_));
+  // The exprs are numbered before they are codegen'd: the adapter fns bake in the
+  // indices.
+  new_ctx->InitExprTable();
+  RETURN_IF_ERROR(Expr::Prepare(new_ctx->roots_, state, row_desc, disable_codegen));
+  *ctx = new_ctx;
+  return Status::OK;
+}
+
+Status ExprContext::Clone(RuntimeState* state, ExprContext** ctx) const {
+  ExprContext* clone = pool_->Add(new ExprContext(pool_, texprs_, row_desc_));
+  for (int i = 0; i < roots_.size(); ++i) {
+    Expr* root = CopyTree(pool_, roots_[i]);
+    if (root == NULL) {
+      // The tree has the same shape as the original, so its exprs get the same indices.
+      RETURN_IF_ERROR(Expr::CreateExprTree(pool_, texprs_[i], &root));
+      RETURN_IF_ERROR(Expr::Prepare(root, state, row_desc_));
+    }
+    clone->roots_.push_back(root);
+  }
+  clone->InitExprTable();
+  DCHECK_EQ(clone->exprs_.size(), exprs_.size());
+  *ctx = clone;
+  return Status::OK;
+}
+
+void ExprContext::InitExprTable() {
+  exprs_ = roots_;
+  for (int i = 0; i < roots_.size(); ++i) {
+    AddChildren(roots_[i]);
+  }
+  for (int i = 0; i < exprs_.size(); ++i) {
+    exprs_[i]->context_index_ = i;
+  }
+}
+
+void ExprContext::AddChildren(Expr* expr) {
+  for (int i = 0; i < expr->GetNumChildren(); ++i) {
+    exprs_.push_back(expr->GetChild(i));
+    AddChildren(expr->GetChild(i));
+  }
+}
+
+Expr* ExprContext::CopyTree(ObjectPool* pool, const Expr* root) {
+  Expr* copy = root->Copy(pool);
+  if (copy == NULL) return NULL;
+  for (int i = 0; i < copy->children_.size(); ++i) {
+    copy->children_[i] = CopyTree(pool, root->children_[i]);
+    if (copy->children_[i] == NULL) return NULL;
+  }
+  return copy;
+}
@@ -0,0 +1,92 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_EXPRS_EXPR_CONTEXT_H
+#define IMPALA_EXPRS_EXPR_CONTEXT_H
+
+#include <vector>
+
+#include "common/status.h"
+#include "gen-cpp/Exprs_types.h"
+
+namespace impala {
+
+class Expr;
+class ObjectPool;
+class RowDescriptor;
+class RuntimeState;
+
+// A set of prepared expr trees (e.g. the conjuncts of a scan node) for evaluation by a
+// single thread.
+// Exprs cache their results in the Expr objects, so an expr tree cannot be evaluated by
+// multiple threads at once. Instead of creating, preparing and codegening the trees
+// again for every thread, the trees are prepared and codegen'd once with Create() and
+// every other thread evaluates its own Clone() of the context. Clones copy the exprs,
+// sharing the compute functions, codegen'd functions and other state that does not
+// change after Prepare().
+//
+// All the exprs of a context are numbered (see Expr::context_index()), the same way in
+// every clone. The codegen'd functions of the trees are shared by all clones: callers
+// pass the calling thread's expr_table() as the 'state_data' argument, which the
+// adapter functions of exprs without an IR implementation use to evaluate the calling
+// thread's copy of the expr.
+class ExprContext {
+ public:
+  // Creates the expr trees for 'texprs' in 'pool' and prepares them. Codegens the trees
+  // unless 'disable_codegen' is true. The new context is added to 'pool' as well.
+  static Status Create(ObjectPool* pool, const std::vector<TExpr>& texprs,
+      RuntimeState* state, const RowDescriptor& row_desc, bool disable_codegen,
+      ExprContext** ctx);
+
+  // Creates a copy of this context for use by another thread. Trees that contain exprs
+  // that cannot be copied (see Expr::Copy()) are created from the thrift exprs and
+  // prepared again, without codegen.
+  Status Clone(RuntimeState* state, ExprContext** ctx) const;
+
+  // The roots of the expr trees, in the order of the thrift exprs.
+  const std::vector<Expr*>& roots() const { return roots_; }
+  int num_roots() const { return roots_.size(); }
+
+  // The table of all exprs in this context, indexed by Expr::context_index(). The roots
+  // come first, so expr_table()[i] == roots()[i]. NULL if there are no exprs.
+  Expr** expr_table() { return exprs_.empty() ? NULL : &exprs_[0]; }
+
+ private:
+  ExprContext(ObjectPool* pool, const std::vector<TExpr>& texprs,
+      const RowDescriptor& row_desc);
+
+  // Fills in exprs_ from roots_ and sets the context_index_ of the exprs.
+  void InitExprTable();
+
+  // Adds the descendants of 'expr' to exprs_ in preorder.
+  void AddChildren(Expr* expr);
+
+  // Returns a copy of the tree rooted at 'root' in 'pool', or NULL if some expr of the
+  // tree cannot be copied.
+  static Expr* CopyTree(ObjectPool* pool, const Expr* root);
+
+  ObjectPool* pool_;
+  const std::vector<TExpr> texprs_;
+  const RowDescriptor& row_desc_;
+
+  std::vector<Expr*> roots_;
+
+  // roots_ followed by all the other exprs in preorder, tree by tree.
+  std::vector<Expr*> exprs_;
+};
+
+}
+
+#endif
@@ -19,8 +19,13 @@
 
 // Generate a llvm loadable function for calling GetValue on an Expr.  This is
 // used as an adapter for Expr's that do not have an IR implementation.
+// If 'state_data' is the expr table of an ExprContext, the copy of 'expr' in that
+// context is evaluated instead of 'expr' itself (see ExprContext).
 extern "C"
-void* IrExprGetValue(Expr* expr, TupleRow* row) {
+void* IrExprGetValue(Expr* expr, TupleRow* row, char* state_data) {
+  if (state_data != NULL && expr->context_index() >= 0) {
+    expr = reinterpret_cast<Expr**>(state_data)[expr->context_index()];
+  }
   return expr->GetValue(row);
 }
 
@@ -106,8 +106,8 @@ Expr::Expr(const ColumnType& type, bool is_slotref)
       type_(type),
       output_scale_(-1),
       codegen_fn_(NULL),
-      adapter_fn_used_(false),
       scratch_buffer_size_(0),
+      context_index_(-1),
       jitted_compute_fn_(NULL) {
 }
 
@@ -118,8 +118,8 @@ Expr::Expr(const TExprNode& node, bool is_slotref)
       type_(ColumnType(node.type)),
       output_scale_(-1),
       codegen_fn_(NULL),
-      adapter_fn_used_(false),
       scratch_buffer_size_(0),
+      context_index_(-1),
       jitted_compute_fn_(NULL) {
 }
 
@@ -497,7 +497,7 @@ Status Expr::PrepareChildren(RuntimeState* state, const RowDescriptor& row_desc)
 }
 
 Status Expr::Prepare(Expr* root, RuntimeState* state, const RowDescriptor& row_desc,
-    bool disable_codegen, bool* thread_safe) {
+    bool disable_codegen) {
   RETURN_IF_ERROR(root->Prepare(state, row_desc));
   LlvmCodeGen* codegen = NULL;
   // state might be NULL when called from tests
@@ -508,19 +508,10 @@ Status Expr::Prepare(Expr* root, RuntimeState* state, const RowDescriptor& row_d
 
   if (codegen != NULL && root->IsJittable(codegen)) {
     root->CodegenExprTree(codegen);
-    if (thread_safe != NULL) *thread_safe = root->codegend_fn_thread_safe();
   }
   return Status::OK;
 }
 
-bool Expr::codegend_fn_thread_safe() const {
-  if (adapter_fn_used_) return false;
-  for (int i = 0; i < children_.size(); ++i) {
-    if (!children_[i]->codegend_fn_thread_safe()) return false;
-  }
-  return true;
-}
-
 Status Expr::Prepare(RuntimeState* state, const RowDescriptor& row_desc) {
   PrepareChildren(state, row_desc);
   // Not all exprs have opcodes (i.e. literals)
@@ -537,14 +528,39 @@ Status Expr::Prepare(RuntimeState* state, const RowDescriptor& row_desc) {
 }
 
 Status Expr::Prepare(const vector<Expr*>& exprs, RuntimeState* state,
-                     const RowDescriptor& row_desc, bool disable_codegen,
-                     bool* thread_safe) {
+                     const RowDescriptor& row_desc, bool disable_codegen) {
   for (int i = 0; i < exprs.size(); ++i) {
-    RETURN_IF_ERROR(Prepare(exprs[i], state, row_desc, disable_codegen, thread_safe));
+    RETURN_IF_ERROR(Prepare(exprs[i], state, row_desc, disable_codegen));
   }
   return Status::OK;
 }
 
+void Expr::EvaluateBatch(RowBatch* batch, int start_row, int num_rows) {
+  int num_children = IsConditional() ? min<int>(children_.size(), 1) : children_.size();
+  for (int i = 0; i < num_children; ++i) {
+    children_[i]->EvaluateBatch(batch, start_row, num_rows);
+  }
+}
+
+void Expr::ClearBatch() {
+  for (int i = 0; i < children_.size(); ++i) {
+    children_[i]->ClearBatch();
+  }
+}
+
+void Expr::EvaluateBatch(const vector<Expr*>& exprs, RowBatch* batch, int start_row,
+                         int num_rows) {
+  for (int i = 0; i < exprs.size(); ++i) {
+    exprs[i]->EvaluateBatch(batch, start_row, num_rows);
+  }
+}
+
+void Expr::ClearBatch(const vector<Expr*>& exprs) {
+  for (int i = 0; i < exprs.size(); ++i) {
+    exprs[i]->ClearBatch();
+  }
+}
+
 bool Expr::IsCodegenAvailable(const vector<Expr*>& exprs) {
   for (int i = 0; i < exprs.size(); ++i) {
     if (exprs[i]->codegen_fn() == NULL) return false;
@@ -770,12 +786,15 @@ Function* Expr::CodegenExprTree(LlvmCodeGen* codegen) {
   return this->Codegen(codegen);
 }
 
-// Codegen an adapter IR function that just calls the underlying GetValue
+// Codegen an adapter IR function that just calls the underlying GetValue. If this expr
+// is part of an ExprContext and 'state_data' is non-NULL, IrExprGetValue() calls
+// GetValue() on the calling thread's copy of this expr instead.
 // define double @ExprFn(i8** %row, i8* %state_data, i1* %is_null) {
 // entry:
 //   %0 = bitcast i8** %row to %"class.impala::TupleRow"*
 //   %1 = call i8* @IrExprGetValue(%"class.impala::Expr"*
-//      inttoptr (i64 194529872 to %"class.impala::Expr"*), %"class.impala::TupleRow"* %0)
+//      inttoptr (i64 194529872 to %"class.impala::Expr"*), %"class.impala::TupleRow"* %0,
+//      i8* %state_data)
 //   %2 = icmp eq i8* %1, null
 //   store i1 %2, i1* %is_null
 //   br i1 %2, label %null, label %not_null
@@ -789,9 +808,6 @@ Function* Expr::CodegenExprTree(LlvmCodeGen* codegen) {
 //   ret double %4
 // }
 Function* Expr::Codegen(LlvmCodeGen* codegen) {
-  // This results in expr trees that are not thread safe and therefore not
-  // usable by the scanner threads (causes them to crash).
-  // Disable this for now.
   LLVMContext& context = codegen->context();
   LlvmCodeGen::LlvmBuilder builder(context);
 
@@ -821,7 +837,7 @@ Function* Expr::Codegen(LlvmCodeGen* codegen) {
   Value* this_llvm = codegen->CastPtrToLlvmPtr(expr_ptr_type, this);
 
   // Call the underlying function
-  Value* result = builder.CreateCall2(interpreted_fn, this_llvm, row);
+  Value* result = builder.CreateCall3(interpreted_fn, this_llvm, row, args[1]);
   Value* is_null = builder.CreateIsNull(result);
   builder.CreateStore(is_null, args[2]);
 
@@ -863,7 +879,6 @@ Function* Expr::Codegen(LlvmCodeGen* codegen) {
       DCHECK(false);
   }
 
-  adapter_fn_used_ = true;
   return codegen->FinalizeFunction(function);
 }
 
@@ -881,7 +896,7 @@ Status Expr::GetIrComputeFn(RuntimeState* state, Function** fn) {
 // entry:
 //   %raw = call i8* @IrExprGetValue(
 //      %"class.impala::Expr"* inttoptr (i64 82763584 to %"class.impala::Expr"*),
-//      %"class.impala::TupleRow"* %row)
+//      %"class.impala::TupleRow"* %row, i8* %context)
 //   %0 = alloca i32
 //   %result = load i32* %0
 //   %is_null = icmp eq i8* %raw, null
@@ -914,7 +929,8 @@ Status Expr::GetWrapperIrComputeFunction(LlvmCodeGen* codegen, Function** fn) {
   Value* this_arg = codegen->CastPtrToLlvmPtr(
       codegen->GetPtrType(Expr::LLVM_CLASS_NAME), this);
   Value* row_arg = args[1];
-  Value* raw_result = builder.CreateCall2(interpreted_fn, this_arg, row_arg, "raw");
+  Value* raw_result =
+      builder.CreateCall3(interpreted_fn, this_arg, row_arg, args[0], "raw");
 
   // Convert void* 'raw_result' to *Val 'result'
   CodegenAnyVal result(codegen, &builder, type(), NULL, "result");
@@ -944,7 +960,7 @@ Function* Expr::CreateIrFunctionPrototype(LlvmCodeGen* codegen, const string& na
                                           Value* (*args)[2]) {
   Type* return_type = CodegenAnyVal::GetType(codegen, type());
   LlvmCodeGen::FnPrototype prototype(codegen, name, return_type);
-  // TODO: Placeholder for ExprContext argument
+  // NULL or the expr table of the calling thread's ExprContext
   prototype.AddArgument(LlvmCodeGen::NamedVariable("context", codegen->ptr_type()));
   prototype.AddArgument(
       LlvmCodeGen::NamedVariable("row", codegen->GetPtrType(TupleRow::LLVM_CLASS_NAME)));
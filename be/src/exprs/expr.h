@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "common/object-pool.h"
 #include "common/status.h"
 #include "gen-cpp/Opcodes_types.h"
 #include "runtime/descriptors.h"
@@ -40,6 +41,7 @@ namespace impala {
 class Expr;
 class LlvmCodeGen;
 class ObjectPool;
+class RowBatch;
 class RowDescriptor;
 class RuntimeState;
 class TColumnValue;
@@ -297,10 +299,26 @@ class Expr {
   // the children are constant.
   virtual bool IsConstant() const;
 
+  // Returns true if whether a child is evaluated depends on the values of the others,
+  // e.g. for CASE, IF, AND and OR. Only the first child is always evaluated.
+  virtual bool IsConditional() const { return false; }
+
   // Returns the slots that are referenced by this expr tree in 'slot_ids'.
   // Returns the number of slots added to the vector
   virtual int GetSlotIds(std::vector<SlotId>* slot_ids) const;
 
+  // Returns a copy of this prepared expr in 'pool' for evaluation by another thread, or
+  // NULL if this expr cannot be copied.  The copy shares the compute and codegen'd
+  // functions and has its own result_; its children still need to be set to copies of
+  // this expr's children (see ExprContext::Clone()).
+  // Exprs that keep state that cannot be shared between threads (e.g. UDF contexts)
+  // do not override this.
+  virtual Expr* Copy(ObjectPool* pool) const { return NULL; }
+
+  // Index of this expr in the expr table of the ExprContext it belongs to, or -1 if
+  // it is not part of an ExprContext.
+  int context_index() const { return context_index_; }
+
   // Create expression tree from the list of nodes contained in texpr
   // within 'pool'. Returns root of expression tree in 'root_expr'.
   // Returns OK if successful, otherwise an error.
@@ -317,15 +335,31 @@ class Expr {
   // in the expr tree.
   // disable_codegen can be set for a particular Prepare() call to disable codegen for
   // a specific expr tree.
-  // if thread_safe != NULL, it will on return, contain whether the resulting codegen
-  // function is thread safe.
   static Status Prepare(Expr* root, RuntimeState* state, const RowDescriptor& row_desc,
-      bool disable_codegen = true, bool* thread_safe = NULL);
+      bool disable_codegen = true);
 
   // Prepare all exprs.
   static Status Prepare(const std::vector<Expr*>& exprs, RuntimeState* state,
-                        const RowDescriptor& row_desc, bool disable_codegen = true,
-                        bool* thread_safe = NULL);
+                        const RowDescriptor& row_desc, bool disable_codegen = true);
+
+  // Lets exprs that are much cheaper to evaluate over many rows at once (i.e. Hive
+  // UDFs, which otherwise cross JNI for every row, and native UDFs that provide a batch
+  // version) evaluate the 'num_rows' rows of
+  // 'batch' starting at 'start_row' up front. Until ClearBatch() is called, GetValue()
+  // returns the precomputed values for these rows, so the rows must not be modified
+  // and GetValue() must not be called on rows of other batches in the meantime.
+  // The default implementation only recurses into the children, or only into the
+  // first child if IsConditional(), so that no expr is evaluated for rows it would
+  // not be evaluated for one row at a time.
+  virtual void EvaluateBatch(RowBatch* batch, int start_row, int num_rows);
+
+  // Drops the values precomputed by EvaluateBatch().
+  virtual void ClearBatch();
+
+  // Calls EvaluateBatch()/ClearBatch() on all exprs.
+  static void EvaluateBatch(const std::vector<Expr*>& exprs, RowBatch* batch,
+                            int start_row, int num_rows);
+  static void ClearBatch(const std::vector<Expr*>& exprs);
 
   // Create a new literal expr of 'type' with initial 'data'.
   // data should match the PrimitiveType (i.e. type == TYPE_INT, data is a int*)
@@ -358,7 +392,9 @@ class Expr {
   // one will also in turn be interpreted but codegen using this expr will be able
   // to continue.
   // All expr codegen'd functions have this signature:
-  // <expr ret type> ComputeFn(int8_t** tuple_row, int8_t* scratch_buffer, bool* is_null)
+  // <expr ret type> ComputeFn(int8_t** tuple_row, int8_t* state_data, bool* is_null)
+  // 'state_data' is either NULL or, for exprs that are part of an ExprContext, the
+  // calling thread's ExprContext::expr_table().
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
   // Returns whether the subtree at this node is jittable.  This is temporary
@@ -411,6 +447,7 @@ class Expr {
   friend class InPredicate;
   friend class FunctionCall;
   friend class NativeUdfExpr;
+  friend class ExprContext;
 
   Expr(const ColumnType& type, bool is_slotref = false);
   Expr(const TExprNode& node, bool is_slotref = false);
@@ -441,23 +478,22 @@ class Expr {
   // Codegened IR function.  Will be NULL if this expr was not codegen'd.
   llvm::Function* codegen_fn_;
 
-  // For functions that don't currently have an explicit codegen'd version,
-  // we instead use an adapter, generic codegen fn, around the interpreted
-  // ComputeFn.
-  // Set to true if this expr or any of its children used the adapter fn.
-  bool adapter_fn_used_;
-
   // Size of scratch buffer necessary to call codegen'd compute function.
   // TODO: not implemented, always 0
   int scratch_buffer_size_;
 
+  // Set by ExprContext, see context_index().  The adapter fn codegen'd for this expr
+  // evaluates the expr at this index in the expr table passed as 'state_data', which
+  // makes the codegen'd fn usable by all the ExprContexts cloned from this expr's.
+  int context_index_;
+
   // Returns an llvm::Function* with signature:
   // <subclass of AnyVal> ComputeFn(int8_t* context, TupleRow* row)
   //
   // The function should evaluate this expr over 'row' and return the result as the
   // appropriate type of AnyVal.
-  // For now, 'context' is a placeholder and is always NULL. This will eventually be
-  // replaced by an ExprContext* argument.
+  // 'context' is NULL or the calling thread's ExprContext::expr_table(), as for the
+  // 'state_data' argument of codegen_fn().
   //
   // The default implementation produces a wrapper around GetValue().
   virtual Status GetIrComputeFn(RuntimeState* state, llvm::Function** fn);
@@ -491,9 +527,6 @@ class Expr {
       llvm::Function* child, llvm::BasicBlock* null_block,
       llvm::BasicBlock* not_null_block);
 
-  // Returns if the codegen function rooted at this node is thread safe.
-  bool codegend_fn_thread_safe() const;
-
   // This is the default implementation of GetIrComputeFn and *always* returns
   // the wrapper around GetValue(), regardless of whether or not the Expr can
   // return a more optimal IR function. This forces as much of the execution as
@@ -561,6 +594,7 @@ class SlotRef : public Expr {
   virtual std::string DebugString() const;
   virtual bool IsConstant() const { return false; }
   virtual int GetSlotIds(std::vector<SlotId>* slot_ids) const;
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new SlotRef(*this)); }
 
   virtual llvm::Function* Codegen(LlvmCodeGen* codegen);
 
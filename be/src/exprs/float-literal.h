@@ -25,6 +25,9 @@ class TExprNode;
 
 class FloatLiteral: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new FloatLiteral(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
@@ -14,6 +14,7 @@
 
 #include <sstream>
 #include <string>
+#include <boost/algorithm/string.hpp>
 
 #include "codegen/llvm-codegen.h"
 #include "exprs/function-call.h"
@@ -28,6 +29,9 @@ namespace impala {
 
 FunctionCall::FunctionCall(const TExprNode& node)
   : Expr(node), regex_(NULL) {
+  map<int, const char*>::const_iterator it = _TExprOpcode_VALUES_TO_NAMES.find(opcode_);
+  is_conditional_ = it != _TExprOpcode_VALUES_TO_NAMES.end() &&
+      algorithm::starts_with(it->second, "CONDITIONAL_");
 }
 
 Status FunctionCall::Prepare(RuntimeState* state, const RowDescriptor& row_desc) {
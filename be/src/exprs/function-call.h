@@ -29,6 +29,10 @@ class TExprNode;
 class RuntimeState;
 
 class FunctionCall: public Expr {
+ public:
+  // True for the conditional functions, e.g. if(), coalesce() and isnull().
+  virtual bool IsConditional() const { return is_conditional_; }
+
  protected:
   friend class Expr;
   friend class StringFunctions;
@@ -63,6 +67,9 @@ class FunctionCall: public Expr {
   // Used in timestamp date/time parsing with custom formats to avoid
   // parsing for every function invocation.
   boost::scoped_ptr<DateTimeFormatContext> date_time_format_ctx_;
+
+  // True if opcode_ is one of the CONDITIONAL_* opcodes.
+  bool is_conditional_;
 };
 
 }
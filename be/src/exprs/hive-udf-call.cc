@@ -21,6 +21,7 @@
 #include "codegen/llvm-codegen.h"
 #include "rpc/thrift-util.h"
 #include "runtime/lib-cache.h"
+#include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "util/bit-util.h"
 #include "util/jni-util.h"
@@ -33,6 +34,8 @@ using namespace boost;
 const char* EXECUTOR_CLASS = "com/cloudera/impala/hive/executor/UdfExecutor";
 const char* EXECUTOR_CTOR_SIGNATURE ="([B)V";
 const char* EXECUTOR_EVALUATE_SIGNATURE = "()V";
+const char* EXECUTOR_EVALUATE_BATCH_SIGNATURE = "(I)V";
+const char* EXECUTOR_CAN_EVALUATE_BATCH_SIGNATURE = "()Z";
 const char* EXECUTOR_CLOSE_SIGNATURE = "()V";
 
 namespace impala {
@@ -43,6 +46,7 @@ struct HiveUdfCall::JniContext {
   jclass class_;
   jobject executor_;
   jmethodID evaluate_id_;
+  jmethodID evaluate_batch_id_;
   jmethodID close_id_;
 
   uint8_t* input_values_buffer_;
@@ -50,14 +54,66 @@ struct HiveUdfCall::JniContext {
   uint8_t* output_value_buffer_;
   uint8_t output_null_value_;
 
+  // Buffers for EvaluateBatch(), for up to batch_capacity_ rows. batch_capacity_ is 0
+  // if the UDF must not be evaluated ahead of time, i.e. if it is not deterministic
+  // or stateful.
+  // input_batch_buffers_[i] holds the values of the ith argument, one slot per row.
+  // input_batch_nulls_[i * batch_capacity_ + row] is 1 if the ith argument is NULL.
+  int batch_capacity_;
+  std::vector<uint8_t*> input_batch_buffers_;
+  uint8_t* input_batch_nulls_;
+  uint8_t* output_batch_buffer_;
+  uint8_t* output_batch_nulls_;
+
+  // The rows whose results are in the output batch buffers; batch_num_rows_ is 0 if
+  // there are none. The ith row is at batch_first_row_ + i * batch_row_size_ bytes.
+  uint8_t* batch_first_row_;
+  int batch_num_rows_;
+  int batch_row_size_;
+
   JniContext() {
     executor_ = NULL;
     input_values_buffer_ = NULL;
     input_nulls_buffer_ = NULL;
     output_value_buffer_ = NULL;
+    batch_capacity_ = 0;
+    input_batch_nulls_ = NULL;
+    output_batch_buffer_ = NULL;
+    output_batch_nulls_ = NULL;
+    batch_first_row_ = NULL;
+    batch_num_rows_ = 0;
+    batch_row_size_ = 0;
   }
 };
 
+// Copies the slot 'v' of type 'type' to 'dst'.
+static inline void CopySlot(PrimitiveType type, void* v, uint8_t* dst) {
+  switch (type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+      // Using explicit sizes helps the compiler unroll memcpy
+      memcpy(dst, v, 1);
+      break;
+    case TYPE_SMALLINT:
+      memcpy(dst, v, 2);
+      break;
+    case TYPE_INT:
+    case TYPE_FLOAT:
+      memcpy(dst, v, 4);
+      break;
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+      memcpy(dst, v, 8);
+      break;
+    case TYPE_TIMESTAMP:
+    case TYPE_STRING:
+      memcpy(dst, v, 16);
+      break;
+    default:
+      DCHECK(false) << "NYI";
+  }
+}
+
 HiveUdfCall::HiveUdfCall(const TExprNode& node)
   : Expr(node), udf_(node.fn_call_expr.fn),
     jni_context_(new JniContext) {
@@ -79,11 +135,83 @@ HiveUdfCall::~HiveUdfCall() {
   delete[] jni_context_->input_values_buffer_;
   delete[] jni_context_->input_nulls_buffer_;
   delete[] jni_context_->output_value_buffer_;
+  for (int i = 0; i < jni_context_->input_batch_buffers_.size(); ++i) {
+    delete[] jni_context_->input_batch_buffers_[i];
+  }
+  delete[] jni_context_->input_batch_nulls_;
+  delete[] jni_context_->output_batch_buffer_;
+  delete[] jni_context_->output_batch_nulls_;
+}
+
+bool HiveUdfCall::CheckUdfException() {
+  Status status = JniUtil::GetJniExceptionMsg(getJNIEnv());
+  if (status.ok()) return true;
+  stringstream ss;
+  ss << "Hive UDF path=" << udf_.hdfs_location << " class=" << udf_.scalar_fn.symbol
+     << " failed due to: " << status.GetErrorMsg();
+  state_->LogError(ss.str());
+  return false;
+}
+
+void HiveUdfCall::EvaluateBatch(RowBatch* batch, int start_row, int num_rows) {
+  Expr::EvaluateBatch(batch, start_row, num_rows);
+  JniContext* ctx = jni_context_.get();
+  ctx->batch_num_rows_ = 0;
+  // Rows without tuples all have the same address, so their results couldn't be told
+  // apart. Those are constant anyway.
+  if (ctx->batch_capacity_ == 0 || batch->row_byte_size() == 0) return;
+  num_rows = min(num_rows, ctx->batch_capacity_);
+  if (num_rows <= 0) return;
+  JNIEnv* env = getJNIEnv();
+  if (env == NULL) return;
+
+  for (int i = 0; i < GetNumChildren(); ++i) {
+    Expr* child = GetChild(i);
+    int slot_size = GetSlotSize(child->type());
+    uint8_t* values = ctx->input_batch_buffers_[i];
+    uint8_t* nulls = ctx->input_batch_nulls_ + i * ctx->batch_capacity_;
+    for (int row = 0; row < num_rows; ++row) {
+      void* v = child->GetValue(batch->GetRow(start_row + row));
+      nulls[row] = (v == NULL);
+      if (v != NULL) CopySlot(child->type(), v, values + row * slot_size);
+    }
+  }
+
+  env->CallNonvirtualVoidMethod(ctx->executor_, ctx->class_, ctx->evaluate_batch_id_,
+      static_cast<jint>(num_rows));
+  // On errors, Evaluate() retries the rows one at a time. Only the rows that fail on
+  // their own are reported, so the batch error is not.
+  Status status = JniUtil::GetJniExceptionMsg(env, false);
+  if (!status.ok()) {
+    VLOG_QUERY << "Hive UDF " << udf_.scalar_fn.symbol << " failed on a batch, "
+               << "evaluating the rows one at a time: " << status.GetErrorMsg();
+    return;
+  }
+  ctx->batch_first_row_ = reinterpret_cast<uint8_t*>(batch->GetRow(start_row));
+  ctx->batch_num_rows_ = num_rows;
+  ctx->batch_row_size_ = batch->row_byte_size();
+}
+
+void HiveUdfCall::ClearBatch() {
+  Expr::ClearBatch();
+  jni_context_->batch_num_rows_ = 0;
 }
 
 void* HiveUdfCall::Evaluate(Expr* e, TupleRow* row) {
   HiveUdfCall* udf = reinterpret_cast<HiveUdfCall*>(e);
   JniContext* ctx = udf->jni_context_.get();
+
+  if (ctx->batch_num_rows_ > 0) {
+    // Return the result computed by EvaluateBatch() if row is one of its rows.
+    int64_t offset = reinterpret_cast<uint8_t*>(row) - ctx->batch_first_row_;
+    if (offset >= 0 && offset < ctx->batch_num_rows_ * ctx->batch_row_size_ &&
+        offset % ctx->batch_row_size_ == 0) {
+      int idx = offset / ctx->batch_row_size_;
+      if (ctx->output_batch_nulls_[idx]) return NULL;
+      return ctx->output_batch_buffer_ + idx * GetSlotSize(e->type());
+    }
+  }
+
   JNIEnv* env = getJNIEnv();
   if (env == NULL) {
     // TODO: with new exprs structure, this should report the error to the user.
@@ -100,45 +228,14 @@ void* HiveUdfCall::Evaluate(Expr* e, TupleRow* row) {
     } else {
       uint8_t* input_ptr = ctx->input_values_buffer_ + udf->input_byte_offsets_[i];
       ctx->input_nulls_buffer_[i] = 0;
-      switch (e->GetChild(i)->type()) {
-        case TYPE_BOOLEAN:
-        case TYPE_TINYINT:
-          // Using explicit sizes helps the compiler unroll memcpy
-          memcpy(input_ptr, v, 1);
-          break;
-        case TYPE_SMALLINT:
-          memcpy(input_ptr, v, 2);
-          break;
-        case TYPE_INT:
-        case TYPE_FLOAT:
-          memcpy(input_ptr, v, 4);
-          break;
-        case TYPE_BIGINT:
-        case TYPE_DOUBLE:
-          memcpy(input_ptr, v, 8);
-          break;
-        case TYPE_TIMESTAMP:
-        case TYPE_STRING:
-          memcpy(input_ptr, v, 16);
-          break;
-        default:
-          DCHECK(false) << "NYI";
-      }
+      CopySlot(e->GetChild(i)->type(), v, input_ptr);
     }
   }
 
   // Using this version of Call has the lowest overhead. This eliminates the
   // vtable lookup and setting up return stacks.
   env->CallNonvirtualVoidMethodA(ctx->executor_, ctx->class_, ctx->evaluate_id_, NULL);
-  Status status = JniUtil::GetJniExceptionMsg(env);
-  if (!status.ok()) {
-    stringstream ss;
-    ss << "Hive UDF path=" << udf->udf_.hdfs_location << " class="
-       << udf->udf_.scalar_fn.symbol
-       << " failed due to: " << status.GetErrorMsg();
-    udf->state_->LogError(ss.str());
-    return NULL;
-  }
+  if (!udf->CheckUdfException()) return NULL;
   if (ctx->output_null_value_) return NULL;
   return ctx->output_value_buffer_;
 }
@@ -162,9 +259,15 @@ Status HiveUdfCall::Prepare(RuntimeState* state, const RowDescriptor& row_desc)
   jni_context_->evaluate_id_ = env->GetMethodID(
       jni_context_->class_, "evaluate", EXECUTOR_EVALUATE_SIGNATURE);
   RETURN_ERROR_IF_EXC(env);
+  jni_context_->evaluate_batch_id_ = env->GetMethodID(
+      jni_context_->class_, "evaluateBatch", EXECUTOR_EVALUATE_BATCH_SIGNATURE);
+  RETURN_ERROR_IF_EXC(env);
   jni_context_->close_id_ = env->GetMethodID(
       jni_context_->class_, "close", EXECUTOR_CLOSE_SIGNATURE);
   RETURN_ERROR_IF_EXC(env);
+  jmethodID can_evaluate_batch_id = env->GetMethodID(
+      jni_context_->class_, "canEvaluateBatch", EXECUTOR_CAN_EVALUATE_BATCH_SIGNATURE);
+  RETURN_ERROR_IF_EXC(env);
 
   int input_buffer_size = 0;
 
@@ -188,6 +291,22 @@ Status HiveUdfCall::Prepare(RuntimeState* state, const RowDescriptor& row_desc)
   ctor_params.output_buffer_ptr = (int64_t)jni_context_->output_value_buffer_;
   ctor_params.output_null_ptr = (int64_t)&jni_context_->output_null_value_;
 
+  JniContext* ctx = jni_context_.get();
+  ctx->batch_capacity_ = state->batch_size();
+  for (int i = 0; i < GetNumChildren(); ++i) {
+    ctx->input_batch_buffers_.push_back(
+        new uint8_t[ctx->batch_capacity_ * GetSlotSize(GetChild(i)->type())]);
+    ctor_params.input_batch_ptrs.push_back((int64_t)ctx->input_batch_buffers_.back());
+  }
+  ctx->input_batch_nulls_ = new uint8_t[ctx->batch_capacity_ * GetNumChildren()];
+  ctx->output_batch_buffer_ = new uint8_t[ctx->batch_capacity_ * GetSlotSize(type())];
+  ctx->output_batch_nulls_ = new uint8_t[ctx->batch_capacity_];
+  ctor_params.__set_batch_capacity(ctx->batch_capacity_);
+  ctor_params.__isset.input_batch_ptrs = true;
+  ctor_params.__set_input_batch_nulls_ptr((int64_t)ctx->input_batch_nulls_);
+  ctor_params.__set_output_batch_ptr((int64_t)ctx->output_batch_buffer_);
+  ctor_params.__set_output_batch_nulls_ptr((int64_t)ctx->output_batch_nulls_);
+
   jbyteArray ctor_params_bytes;
 
   // Add a scoped cleanup jni reference object. This cleans up local refs made
@@ -202,6 +321,13 @@ Status HiveUdfCall::Prepare(RuntimeState* state, const RowDescriptor& row_desc)
   RETURN_ERROR_IF_EXC(env);
   jni_context_->executor_ = env->NewGlobalRef(jni_context_->executor_);
 
+  // Evaluating a batch calls the UDF for rows that may never be needed, and before
+  // the rows that are, so only do it if the UDF's results don't depend on that.
+  jboolean can_evaluate_batch = env->CallNonvirtualBooleanMethod(
+      jni_context_->executor_, jni_context_->class_, can_evaluate_batch_id);
+  RETURN_ERROR_IF_EXC(env);
+  if (!can_evaluate_batch) ctx->batch_capacity_ = 0;
+
   compute_fn_ = Evaluate;
   return Status::OK;
 }
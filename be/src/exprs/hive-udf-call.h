@@ -52,10 +52,24 @@ class RuntimeState;
 // The BE reads the StringValue as normal.
 //
 // If the UDF ran into an error, the FE throws an exception.
+//
+// Crossing JNI for every row dominates the cost of cheap UDFs, so EvaluateBatch()
+// evaluates up to batch_size() rows with a single JNI call to
+// UdfExecutor.evaluateBatch(). It writes the inputs into column-oriented buffers
+// (one per argument, plus a null indicator byte per argument and row), and the
+// UdfExecutor loops over the rows and writes the results into an output array of
+// slots and null indicators. String results are StringValues that point into a string
+// arena, which the UdfExecutor allocates from its native heap. Evaluate() returns
+// the result from the output array for rows of the evaluated batch. Only UDFs that
+// Hive's UDFType marks as deterministic and not stateful are evaluated in batches.
+// If a batch fails, the rows are evaluated one at a time and only the rows that fail
+// are reported.
 class HiveUdfCall : public Expr {
  public:
   virtual ~HiveUdfCall();
   virtual Status Prepare(RuntimeState* state, const RowDescriptor& row_desc);
+  virtual void EvaluateBatch(RowBatch* batch, int start_row, int num_rows);
+  virtual void ClearBatch();
 
  protected:
   friend class Expr;
@@ -76,6 +90,10 @@ class HiveUdfCall : public Expr {
   // input_byte_offsets_[i] is the byte offset child ith's input argument should
   // be written to.
   std::vector<int> input_byte_offsets_;
+
+  // Logs the exception thrown by the last UdfExecutor call, if any. Returns false if
+  // there was one.
+  bool CheckUdfException();
 };
 
 }
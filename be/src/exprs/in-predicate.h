@@ -23,7 +23,11 @@ namespace impala {
 
 class InPredicate : public Predicate {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new InPredicate(*this)); }
   virtual llvm::Function* Codegen(LlvmCodeGen* codegen);
+  // The values are only evaluated if the tested expr is not NULL, and until one
+  // matches.
+  virtual bool IsConditional() const { return true; }
 
  protected:
   friend class Expr;
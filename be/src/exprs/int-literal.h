@@ -25,6 +25,7 @@ class TExprNode;
 
 class IntLiteral: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new IntLiteral(*this)); }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
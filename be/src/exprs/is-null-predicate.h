@@ -25,6 +25,9 @@ class TExprNode;
 
 class IsNullPredicate: public Predicate {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new IsNullPredicate(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
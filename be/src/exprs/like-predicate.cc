@@ -36,6 +36,16 @@ LikePredicate::LikePredicate(const TExprNode& node)
 LikePredicate::~LikePredicate() {
 }
 
+Expr* LikePredicate::Copy(ObjectPool* pool) const {
+  LikePredicate* copy = pool->Add(new LikePredicate(*this));
+  // Point the copy's search state at its own copy of the search string.
+  copy->search_string_sv_ = StringValue(copy->search_string_);
+  if (compute_fn_ == ConstantSubstringFn) {
+    copy->substring_pattern_ = StringSearch(&copy->search_string_sv_);
+  }
+  return copy;
+}
+
 void* LikePredicate::ConstantSubstringFn(Expr* e, TupleRow* row) {
   LikePredicate* p = static_cast<LikePredicate*>(e);
   DCHECK_EQ(p->GetNumChildren(), 2);
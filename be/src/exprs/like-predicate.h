@@ -17,7 +17,7 @@
 #define IMPALA_EXPRS_LIKE_PREDICATE_H_
 
 #include <string>
-#include <boost/scoped_ptr.hpp> 
+#include <boost/shared_ptr.hpp>
 
 #include "exprs/predicate.h"
 #include "gen-cpp/Exprs_types.h"
@@ -33,6 +33,8 @@ class LikePredicate: public Predicate {
  public:
   ~LikePredicate();
 
+  virtual Expr* Copy(ObjectPool* pool) const;
+
  protected:
   friend class Expr;
   virtual Status Prepare(RuntimeState* state, const RowDescriptor& row_desc);
@@ -45,7 +47,9 @@ class LikePredicate: public Predicate {
   std::string search_string_;
   StringValue search_string_sv_;
   StringSearch substring_pattern_;
-  boost::scoped_ptr<re2::RE2> regex_;
+
+  // Compiled constant pattern.  Matching is thread safe, so copies share it.
+  boost::shared_ptr<re2::RE2> regex_;
 
   // Convert a LIKE pattern (with embedded % and _) into the corresponding
   // regular expression pattern. Escaped chars are copied verbatim.
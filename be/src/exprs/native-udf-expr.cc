@@ -22,8 +22,10 @@
 #include "exprs/opcode-registry.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/lib-cache.h"
+#include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "udf/udf-internal.h"
+#include "util/bit-util.h"
 #include "util/debug-util.h"
 #include "util/dynamic-util.h"
 
@@ -36,16 +38,24 @@ NativeUdfExpr::NativeUdfExpr(const TExprNode& node)
     udf_type_(node.fn_call_expr.fn.binary_type),
     hdfs_location_(node.fn_call_expr.fn.hdfs_location),
     symbol_name_(node.fn_call_expr.fn.scalar_fn.symbol),
+    batch_symbol_name_(node.fn_call_expr.fn.scalar_fn.batch_symbol),
     vararg_start_idx_(node.fn_call_expr.__isset.vararg_start_idx ?
         node.fn_call_expr.vararg_start_idx : -1),
     udf_wrapper_(NULL),
-    varargs_input_(NULL) {
+    varargs_input_(NULL),
+    batch_fn_(NULL),
+    batch_capacity_(0),
+    batch_buffer_(NULL),
+    batch_first_row_(NULL),
+    batch_num_rows_(0),
+    batch_row_size_(0) {
   DCHECK_EQ(node.node_type, TExprNodeType::FUNCTION_CALL);
   DCHECK_NE(udf_type_, TFunctionBinaryType::HIVE);
 }
 
 NativeUdfExpr::~NativeUdfExpr() {
   delete[] varargs_input_;
+  delete[] batch_buffer_;
 }
 
 typedef BooleanVal (*BooleanUdfWrapper)(int8_t*, TupleRow*);
@@ -60,6 +70,14 @@ typedef TimestampVal (*TimestampUdfWrapper)(int8_t*, TupleRow*);
 
 void* NativeUdfExpr::ComputeFn(Expr* e, TupleRow* row) {
   NativeUdfExpr* udf_expr = reinterpret_cast<NativeUdfExpr*>(e);
+  if (udf_expr->batch_num_rows_ > 0) {
+    // Return the result computed by EvaluateBatch() if row is one of its rows.
+    int64_t offset = reinterpret_cast<uint8_t*>(row) - udf_expr->batch_first_row_;
+    if (offset >= 0 && offset < udf_expr->batch_num_rows_ * udf_expr->batch_row_size_ &&
+        offset % udf_expr->batch_row_size_ == 0) {
+      return udf_expr->GetBatchResult(offset / udf_expr->batch_row_size_);
+    }
+  }
   switch (e->type()) {
     case TYPE_BOOLEAN: {
       BooleanUdfWrapper fn = reinterpret_cast<BooleanUdfWrapper>(udf_expr->udf_wrapper_);
@@ -149,14 +167,102 @@ Status NativeUdfExpr::Prepare(RuntimeState* state, const RowDescriptor& desc) {
     varargs_input_ = new uint8_t[var_args_buffer_size];
   }
 
+  RETURN_IF_ERROR(GetBatchUdf(state));
+
   llvm::Function* ir_udf_wrapper;
-  RETURN_IF_ERROR(GetIrComputeFn(state, &ir_udf_wrapper));
+  RETURN_IF_ERROR(CodegenUdfWrapper(state, &ir_udf_wrapper));
   DCHECK(state->codegen() != NULL);
   state->codegen()->AddFunctionToJit(ir_udf_wrapper, &udf_wrapper_);
   compute_fn_ = ComputeFn;
   return Status::OK;
 }
 
+Status NativeUdfExpr::GetBatchUdf(RuntimeState* state) {
+  // The batch version is optional.
+  if (udf_type_ != TFunctionBinaryType::NATIVE || batch_symbol_name_.empty()) {
+    return Status::OK;
+  }
+  void* batch_fn;
+  RETURN_IF_ERROR(state->lib_cache()->GetSoFunctionPtr(
+      state->fs_cache(), hdfs_location_, batch_symbol_name_, &batch_fn));
+  batch_fn_ = reinterpret_cast<UdfBatchEvaluate>(batch_fn);
+
+  // Lay out the values and null indicators of the argument columns, followed by the
+  // result column, in one buffer. Each array is 8-byte aligned.
+  batch_capacity_ = state->batch_size();
+  int null_size = BitUtil::RoundUp(batch_capacity_ * sizeof(bool), 8);
+  int buffer_size = BitUtil::RoundUp(
+      batch_capacity_ * AnyValUtil::ColumnValSize(type()), 8) + null_size;
+  for (int i = 0; i < GetNumChildren(); ++i) {
+    buffer_size += BitUtil::RoundUp(
+        batch_capacity_ * AnyValUtil::ColumnValSize(children_[i]->type()), 8);
+    buffer_size += null_size;
+  }
+  batch_buffer_ = new uint8_t[buffer_size];
+  uint8_t* ptr = batch_buffer_;
+  for (int i = 0; i <= GetNumChildren(); ++i) {
+    PrimitiveType col_type = i < GetNumChildren() ? children_[i]->type() : type();
+    ColumnVal column(ptr, reinterpret_cast<bool*>(
+        ptr + BitUtil::RoundUp(batch_capacity_ * AnyValUtil::ColumnValSize(col_type), 8)));
+    ptr = reinterpret_cast<uint8_t*>(column.is_null) + null_size;
+    if (i < GetNumChildren()) {
+      batch_args_.push_back(column);
+    } else {
+      batch_result_ = column;
+    }
+  }
+  DCHECK_EQ(ptr, batch_buffer_ + buffer_size);
+  return Status::OK;
+}
+
+void NativeUdfExpr::EvaluateBatch(RowBatch* batch, int start_row, int num_rows) {
+  Expr::EvaluateBatch(batch, start_row, num_rows);
+  batch_num_rows_ = 0;
+  // Rows without tuples all have the same address, so their results couldn't be told
+  // apart. Those are constant anyway.
+  if (batch_fn_ == NULL || batch->row_byte_size() == 0) return;
+  num_rows = min(num_rows, batch_capacity_);
+  if (num_rows <= 0) return;
+
+  for (int i = 0; i < GetNumChildren(); ++i) {
+    Expr* child = children_[i];
+    for (int row = 0; row < num_rows; ++row) {
+      void* v = child->GetValue(batch->GetRow(start_row + row));
+      AnyValUtil::SetColumnVal(v, child->type(), row, &batch_args_[i]);
+    }
+  }
+  batch_fn_(udf_context_.get(), num_rows, batch_args_.empty() ? NULL : &batch_args_[0],
+      &batch_result_);
+  batch_first_row_ = reinterpret_cast<uint8_t*>(batch->GetRow(start_row));
+  batch_num_rows_ = num_rows;
+  batch_row_size_ = batch->row_byte_size();
+}
+
+void NativeUdfExpr::ClearBatch() {
+  Expr::ClearBatch();
+  batch_num_rows_ = 0;
+}
+
+void* NativeUdfExpr::GetBatchResult(int idx) {
+  DCHECK_LT(idx, batch_num_rows_);
+  if (batch_result_.is_null[idx]) return NULL;
+  switch (type()) {
+    case TYPE_STRING: {
+      const StringVal& v = reinterpret_cast<StringVal*>(batch_result_.values)[idx];
+      result_.string_val.ptr = reinterpret_cast<char*>(v.ptr);
+      result_.string_val.len = v.len;
+      return &result_.string_val;
+    }
+    case TYPE_TIMESTAMP:
+      result_.timestamp_val = TimestampValue::FromTimestampVal(
+          reinterpret_cast<TimestampVal*>(batch_result_.values)[idx]);
+      return &result_.timestamp_val;
+    default:
+      return reinterpret_cast<uint8_t*>(batch_result_.values) +
+          idx * AnyValUtil::ColumnValSize(type());
+  }
+}
+
 // Dynamically loads the pre-compiled UDF and codegens a function that calls each child's
 // codegen'd function, then passes those values to the UDF and returns the result.
 // Example generated IR for a UDF with signature
@@ -184,7 +290,7 @@ Status NativeUdfExpr::Prepare(RuntimeState* state, const RowDescriptor& desc) {
 //        i32 4,
 //        i64* inttoptr (i64 89111072 to i64*))
 //   ret { i8, double } %result
-Status NativeUdfExpr::GetIrComputeFn(RuntimeState* state, llvm::Function** fn) {
+Status NativeUdfExpr::CodegenUdfWrapper(RuntimeState* state, llvm::Function** fn) {
   // Udfs always require some amount of codegen.
   if (state->codegen() == NULL) state->CreateCodegen();
   LlvmCodeGen* codegen = state->codegen();
@@ -268,6 +374,15 @@ Status NativeUdfExpr::GetIrComputeFn(RuntimeState* state, llvm::Function** fn) {
   return Status::OK;
 }
 
+Status NativeUdfExpr::GetIrComputeFn(RuntimeState* state, llvm::Function** fn) {
+  if (batch_fn_ != NULL) {
+    // Go through ComputeFn() so that the results of EvaluateBatch() are used.
+    if (state->codegen() == NULL) state->CreateCodegen();
+    return GetWrapperIrComputeFunction(state->codegen(), fn);
+  }
+  return CodegenUdfWrapper(state, fn);
+}
+
 Status NativeUdfExpr::GetUdf(RuntimeState* state, llvm::Function** udf) {
   LlvmCodeGen* codegen = state->codegen();
   DCHECK(codegen != NULL);
@@ -17,6 +17,7 @@
 #define IMPALA_EXPRS_UDF_EXPR_H_
 
 #include <string>
+#include <vector>
 #include "exprs/expr.h"
 #include "udf/udf.h"
 
@@ -34,7 +35,7 @@ class TExprNode;
 // calls any child exprs and passes the results as arguments to the specified UDF. This
 // codegen'd function is the kernel of the NativeUdfExpr's compute function; ComputeFn()
 // is a wrapper around it that conforms to the interpreted compute function API (e.g. it
-// stores the UDF's output in result_). GetIrComputeFn() is called in Prepare().
+// stores the UDF's output in result_). The kernel is codegen'd in Prepare().
 //
 // Note that this class does not override Codegen(), even though it produces a mostly
 // codegen'd compute function. This means that ComputeFn() is in turn wrapped in a
@@ -47,11 +48,18 @@ class TExprNode;
 // - convert other Exprs to UDFs or override GetIrComputeFn()
 // - ExprContext
 // - remove current Codegen/ComputeFn API
+//
+// UDFs in shared libraries that provide a batch version (see UdfBatchEvaluate in udf.h)
+// are called through it in EvaluateBatch(). GetIrComputeFn() then returns the wrapper
+// around GetValue(), so that exprs using this one also pick up the batch results.
 class NativeUdfExpr: public Expr {
  public:
   ~NativeUdfExpr();
   virtual std::string DebugString() const;
 
+  virtual void EvaluateBatch(RowBatch* batch, int start_row, int num_rows);
+  virtual void ClearBatch();
+
  protected:
   friend class Expr;
 
@@ -75,6 +83,9 @@ class NativeUdfExpr: public Expr {
   std::string hdfs_location_;
   std::string symbol_name_;
 
+  // Symbol of the batch version of the UDF. Empty if it has none.
+  std::string batch_symbol_name_;
+
   // If this function has var args, children()[vararg_start_idx_] is the
   // first vararg argument.
   // If this function does not have varargs, it is set to -1.
@@ -87,8 +98,34 @@ class NativeUdfExpr: public Expr {
   // TODO: Move to to ExprContext
   uint8_t* varargs_input_;
 
+  // Batch version of the UDF, or NULL if there is none.
+  impala_udf::UdfBatchEvaluate batch_fn_;
+
+  // Argument and result columns passed to batch_fn_, with room for batch_capacity_
+  // rows. Their values and null indicators are allocated in batch_buffer_.
+  int batch_capacity_;
+  uint8_t* batch_buffer_;
+  std::vector<impala_udf::ColumnVal> batch_args_;
+  impala_udf::ColumnVal batch_result_;
+
+  // The rows whose results are in batch_result_; batch_num_rows_ is 0 if there are none.
+  // The ith row is at batch_first_row_ + i * batch_row_size_ bytes.
+  uint8_t* batch_first_row_;
+  int batch_num_rows_;
+  int batch_row_size_;
+
   // Loads the native or IR function from HDFS and puts the result in *udf.
   Status GetUdf(RuntimeState* state, llvm::Function** udf);
+
+  // Looks up batch_fn_ and allocates the batch columns if the UDF has a batch version.
+  Status GetBatchUdf(RuntimeState* state);
+
+  // Codegens the function that evaluates the children and calls the UDF.
+  Status CodegenUdfWrapper(RuntimeState* state, llvm::Function** fn);
+
+  // Returns the result computed by EvaluateBatch() for the idx-th row, in the same form
+  // as ComputeFn().
+  void* GetBatchResult(int idx);
 };
 
 }
@@ -24,6 +24,7 @@ class TExprNode;
 
 class NullLiteral: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const { return pool->Add(new NullLiteral(*this)); }
   NullLiteral(PrimitiveType type);
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
@@ -26,6 +26,9 @@ class TExprNode;
 
 class StringLiteral: public Expr {
  public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new StringLiteral(*this));
+  }
   virtual llvm::Function* Codegen(LlvmCodeGen* code_gen);
 
  protected:
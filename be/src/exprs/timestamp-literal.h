@@ -24,6 +24,11 @@ namespace impala {
 class TExprNode;
 
 class TimestampLiteral: public Expr {
+ public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new TimestampLiteral(*this));
+  }
+
  protected:
   friend class Expr;
 
@@ -23,6 +23,11 @@ namespace impala {
 class TExprNode;
 
 class TupleIsNullPredicate: public Predicate {
+ public:
+  virtual Expr* Copy(ObjectPool* pool) const {
+    return pool->Add(new TupleIsNullPredicate(*this));
+  }
+
  protected:
   friend class Expr;
 
@@ -14,6 +14,7 @@
 
 #include "runtime/coordinator.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
 #include <thrift/protocol/TDebugProtocol.h>
@@ -29,6 +30,7 @@
 #include <boost/foreach.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string.hpp>
@@ -347,6 +349,7 @@ Status Coordinator::Exec(QuerySchedule& schedule, vector<Expr*>* output_exprs) {
   // register coordinator's fragment profile now, before those of the backends,
   // so it shows up at the top
   finalization_timer_ = ADD_TIMER(query_profile_, "FinalizationTimer");
+  fragment_start_timer_ = ADD_TIMER(query_profile_, "FragmentStartTimer");
 
   if (executor_.get() != NULL) {
     query_profile_->AddChild(executor_->profile());
@@ -398,6 +401,10 @@ Status Coordinator::Exec(QuerySchedule& schedule, vector<Expr*>* output_exprs) {
   VLOG_QUERY << "starting " << schedule.num_backends()
              << " backends for query " << query_id_;
 
+  // Instances of the same fragment are started with one rpc per backend, but fragments
+  // are still started one at a time: a sender's data is dropped if it arrives before
+  // the receiving fragment has Prepare()'d.
+  SCOPED_TIMER(fragment_start_timer_);
   int backend_num = 0;
   for (int fragment_idx = (has_coordinator_fragment ? 1 : 0);
        fragment_idx < request.fragments.size(); ++fragment_idx) {
@@ -406,6 +413,9 @@ Status Coordinator::Exec(QuerySchedule& schedule, vector<Expr*>* output_exprs) {
     // set up exec states
     int num_hosts = params.hosts.size();
     DCHECK_GT(num_hosts, 0);
+    vector<BackendRpcBatch*> batches;
+    typedef unordered_map<TNetworkAddress, BackendRpcBatch*> BatchMap;
+    BatchMap batch_map;
     for (int instance_idx = 0; instance_idx < num_hosts; ++instance_idx) {
       DebugOptions* backend_debug_options =
           (debug_options.phase != TExecNodePhase::INVALID
@@ -420,25 +430,39 @@ Status Coordinator::Exec(QuerySchedule& schedule, vector<Expr*>* output_exprs) {
               params, instance_idx, backend_debug_options, obj_pool()));
       backend_exec_states_[backend_num] = exec_state;
       ++backend_num;
+      BatchMap::iterator batch = batch_map.find(exec_state->backend_address);
+      if (batch == batch_map.end()) {
+        BackendRpcBatch* new_batch =
+            obj_pool()->Add(new BackendRpcBatch(exec_state->backend_address));
+        batches.push_back(new_batch);
+        batch = batch_map.insert(make_pair(exec_state->backend_address, new_batch)).first;
+      }
+      batch->second->exec_states.push_back(exec_state);
       VLOG(2) << "Exec(): starting instance: fragment_idx=" << fragment_idx
               << " instance_id=" << params.instance_ids[instance_idx];
     }
     fragment_profiles_[fragment_idx].num_instances = num_hosts;
 
-    // Issue all rpcs in parallel
+    // Issue one rpc per backend, all in parallel
     Status fragments_exec_status = ParallelExecutor::Exec(
-        bind<Status>(mem_fn(&Coordinator::ExecRemoteFragment), this, _1),
-        reinterpret_cast<void**>(&backend_exec_states_[backend_num - num_hosts]),
-        num_hosts);
+        exec_env_->fragment_exec_rpc_pool(),
+        bind<Status>(mem_fn(&Coordinator::ExecRemoteFragments), this, _1),
+        reinterpret_cast<void**>(&batches[0]), batches.size());
+    for (int i = 0; i < batches.size(); ++i) {
+      backend_start_latencies_.push_back(batches[i]->latency);
+    }
 
     if (!fragments_exec_status.ok()) {
       DCHECK(query_status_.ok());  // nobody should have been able to cancel
       query_status_ = fragments_exec_status;
+      // Start latencies help diagnose why fragments failed to start.
+      ReportBackendStartLatencies();
       // tear down running fragments and return
       CancelInternal();
       return fragments_exec_status;
     }
   }
+  ReportBackendStartLatencies();
 
   // If we have a coordinator fragment and remote fragments (the common case),
   // release the thread token on the coordinator fragment.  This fragment
@@ -864,51 +888,121 @@ int64_t Coordinator::ComputeTotalScanRangesComplete(int node_id) {
   return value;
 }
 
-Status Coordinator::ExecRemoteFragment(void* exec_state_arg) {
-  BackendExecState* exec_state = reinterpret_cast<BackendExecState*>(exec_state_arg);
-  VLOG_FILE << "making rpc: ExecPlanFragment query_id=" << query_id_
-            << " instance_id=" << exec_state->fragment_instance_id
-            << " host=" << exec_state->backend_address;
-  lock_guard<mutex> l(exec_state->lock);
+Status Coordinator::ExecRemoteFragments(void* batch_arg) {
+  BackendRpcBatch* batch = reinterpret_cast<BackendRpcBatch*>(batch_arg);
+  DCHECK(!batch->exec_states.empty());
+  VLOG_FILE << "making rpc: ExecPlanFragments query_id=" << query_id_
+            << " num_instances=" << batch->exec_states.size()
+            << " host=" << batch->address;
+  // Lock all exec states for the duration of the rpc. They are always locked in the
+  // same order, and no other thread holds more than one of them at a time.
+  vector<boost::shared_ptr<lock_guard<mutex> > > locks;
+  TExecPlanFragmentsParams rpc_params;
+  rpc_params.protocol_version = ImpalaInternalServiceVersion::V1;
+  rpc_params.__isset.fragment_params = true;
+  BOOST_FOREACH(BackendExecState* exec_state, batch->exec_states) {
+    locks.push_back(boost::shared_ptr<lock_guard<mutex> >(
+        new lock_guard<mutex>(exec_state->lock)));
+    rpc_params.fragment_params.push_back(exec_state->rpc_params);
+  }
 
+  MonotonicStopWatch rpc_timer;
+  rpc_timer.Start();
   Status status;
   ImpalaInternalServiceConnection backend_client(
-      exec_env_->impalad_client_cache(), exec_state->backend_address, &status);
-  RETURN_IF_ERROR(status);
+      exec_env_->impalad_client_cache(), batch->address, &status);
+  if (!status.ok()) {
+    batch->latency = rpc_timer.ElapsedTime();
+    BOOST_FOREACH(BackendExecState* exec_state, batch->exec_states) {
+      exec_state->status = status;
+    }
+    return status;
+  }
 
-  TExecPlanFragmentResult thrift_result;
+  TExecPlanFragmentsResult thrift_result;
   try {
     try {
-      backend_client->ExecPlanFragment(thrift_result, exec_state->rpc_params);
+      backend_client->ExecPlanFragments(thrift_result, rpc_params);
     } catch (TTransportException& e) {
       // If a backend has stopped and restarted (without the failure detector
       // picking it up) an existing backend client may still think it is
       // connected. To avoid failing the first query after every failure, catch
       // the first failure and force a reopen of the transport.
       // TODO: Improve client-cache so that we don't need to do this.
-      VLOG_RPC << "Retrying ExecPlanFragment: " << e.what();
-      Status status = backend_client.Reopen();
+      VLOG_RPC << "Retrying ExecPlanFragments: " << e.what();
+      status = backend_client.Reopen();
       if (!status.ok()) {
-        exec_state->status = status;
+        batch->latency = rpc_timer.ElapsedTime();
+        BOOST_FOREACH(BackendExecState* exec_state, batch->exec_states) {
+          exec_state->status = status;
+        }
         return status;
       }
-      backend_client->ExecPlanFragment(thrift_result, exec_state->rpc_params);
+      backend_client->ExecPlanFragments(thrift_result, rpc_params);
     }
   } catch (TTransportException& e) {
     stringstream msg;
-    msg << "ExecPlanRequest rpc query_id=" << query_id_
-        << " instance_id=" << exec_state->fragment_instance_id
-        << " failed: " << e.what();
+    msg << "ExecPlanFragments rpc query_id=" << query_id_
+        << " host=" << batch->address << " failed: " << e.what();
     VLOG_QUERY << msg.str();
-    exec_state->status = Status(msg.str());
-    return exec_state->status;
+    status = Status(msg.str());
+    batch->latency = rpc_timer.ElapsedTime();
+    BOOST_FOREACH(BackendExecState* exec_state, batch->exec_states) {
+      exec_state->status = status;
+    }
+    return status;
   }
-  exec_state->status = thrift_result.status;
-  if (exec_state->status.ok()) {
-    exec_state->initiated = true;
-    exec_state->stopwatch.Start();
+  batch->latency = rpc_timer.ElapsedTime();
+
+  // The backend stops at the first instance that fails to start, so there may be fewer
+  // statuses than instances.
+  Status first_error;
+  for (int i = 0; i < batch->exec_states.size(); ++i) {
+    BackendExecState* exec_state = batch->exec_states[i];
+    if (i < thrift_result.statuses.size()) {
+      exec_state->status = Status(thrift_result.statuses[i]);
+    } else {
+      stringstream msg;
+      msg << "Fragment instance " << exec_state->fragment_instance_id
+          << " was not started on " << batch->address;
+      exec_state->status = Status(msg.str());
+    }
+    if (exec_state->status.ok()) {
+      exec_state->initiated = true;
+      exec_state->stopwatch.Start();
+    } else if (first_error.ok()) {
+      first_error = exec_state->status;
+    }
   }
-  return exec_state->status;
+  return first_error;
+}
+
+void Coordinator::ReportBackendStartLatencies() {
+  if (backend_start_latencies_.empty()) return;
+  SummaryStats latencies;
+  BOOST_FOREACH(int64_t latency, backend_start_latencies_) {
+    latencies(latency);
+  }
+  sort(backend_start_latencies_.begin(), backend_start_latencies_.end());
+  int num_latencies = backend_start_latencies_.size();
+
+  stringstream ss;
+  ss << "min:" << PrettyPrinter::Print(
+          accumulators::min(latencies), TCounterType::TIME_NS)
+     << "  max:" << PrettyPrinter::Print(
+          accumulators::max(latencies), TCounterType::TIME_NS)
+     << "  mean: " << PrettyPrinter::Print(
+          accumulators::mean(latencies), TCounterType::TIME_NS)
+     << "  stddev:" << PrettyPrinter::Print(
+          sqrt(accumulators::variance(latencies)), TCounterType::TIME_NS)
+     << "  p50:" << PrettyPrinter::Print(
+          backend_start_latencies_[num_latencies / 2], TCounterType::TIME_NS)
+     << "  p90:" << PrettyPrinter::Print(
+          backend_start_latencies_[num_latencies * 9 / 10], TCounterType::TIME_NS)
+     << "  p99:" << PrettyPrinter::Print(
+          backend_start_latencies_[num_latencies * 99 / 100], TCounterType::TIME_NS)
+     << "  num rpcs:" << num_latencies;
+  query_profile_->AddInfoString("Backend start latencies", ss.str());
 }
 
 void Coordinator::Cancel(const Status* cause) {
@@ -1014,7 +1108,9 @@ Status Coordinator::UpdateFragmentExecStatus(const TReportExecStatusParams& para
   }
   BackendExecState* exec_state = backend_exec_states_[params.backend_num];
 
-  const TRuntimeProfileTree& cumulative_profile = params.profile;
+  // Intermediate reports only contain the changes since the previous report; applying
+  // them with Update() leaves the rest of the profile untouched.
+  const TRuntimeProfileTree& profile_delta = params.profile;
   Status status(params.status);
   {
     lock_guard<mutex> l(exec_state->lock);
@@ -1037,7 +1133,7 @@ Status Coordinator::UpdateFragmentExecStatus(const TReportExecStatusParams& para
       // statuses to cancelled.
       // TODO: We're losing this profile information. Call ReportQuerySummary only after
       // all backends have completed.
-      exec_state->profile->Update(cumulative_profile);
+      exec_state->profile->Update(profile_delta);
     }
     if (!exec_state->profile_created) {
       CollectScanNodeCounters(exec_state->profile, &exec_state->aggregate_counters);
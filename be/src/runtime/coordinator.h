@@ -83,9 +83,6 @@ class RuntimeProfile;
 //
 // The implementation ensures that setting an overall error status and initiating
 // cancellation of local and all remote fragments is atomic.
-//
-// TODO:
-// - add profile counters for coordinator (how much time do we spend in startup?)
 class Coordinator {
  public:
   Coordinator(ExecEnv* exec_env);
@@ -317,20 +314,42 @@ class Coordinator {
   // Total time spent in finalization (typically 0 except for INSERT into hdfs tables)
   RuntimeProfile::Counter* finalization_timer_;
 
+  // Time spent in Exec() starting remote fragment instances; covers all remaining
+  // work in Exec() after the coordinator fragment has been prepared
+  RuntimeProfile::Counter* fragment_start_timer_;
+
+  // Latencies of all ExecPlanFragments() rpcs issued by Exec(). Only accessed by
+  // Exec(), so does not need locks.
+  std::vector<int64_t> backend_start_latencies_;
+
+  // The fragment instances of a single fragment that are started on the same backend
+  // with one ExecPlanFragments() rpc. Stored in obj_pool().
+  struct BackendRpcBatch {
+    TNetworkAddress address;
+    std::vector<BackendExecState*> exec_states;
+    // Wall-clock time of the rpc, including failed attempts, in ns
+    int64_t latency;
+
+    BackendRpcBatch(const TNetworkAddress& address) : address(address), latency(0) { }
+  };
+
   // Fill in rpc_params based on parameters.
   void SetExecPlanFragmentParams(QuerySchedule& schedule,
       int backend_num, const TPlanFragment& fragment,
       int fragment_idx, FragmentExecParams& params, int instance_idx,
       const TNetworkAddress& coord, TExecPlanFragmentParams* rpc_params);
 
-  // Wrapper for ExecPlanFragment() rpc.  This function will be called in parallel
-  // from multiple threads.
-  // Obtains exec_state->lock prior to making rpc, so that it serializes
+  // Wrapper for ExecPlanFragments() rpc, which starts all fragment instances of
+  // 'batch' on its backend. This function will be called in parallel from multiple
+  // threads.
+  // Obtains the lock of each exec state prior to making the rpc, so that it serializes
   // correctly with UpdateFragmentExecStatus().
-  // exec_state contains all information needed to issue the rpc.
-  // 'coordinator' will always be an instance to this class and 'exec_state' will
-  // always be an instance of BackendExecState.
-  Status ExecRemoteFragment(void* exec_state);
+  // 'batch' will always be an instance of BackendRpcBatch. Sets the status of each of
+  // its exec states and returns the first error, if any.
+  Status ExecRemoteFragments(void* batch);
+
+  // Adds a summary of backend_start_latencies_ to the query profile.
+  void ReportBackendStartLatencies();
 
   // Determine fragment number, given fragment id.
   int GetFragmentNum(const TUniqueId& fragment_id);
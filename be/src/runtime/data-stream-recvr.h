@@ -40,6 +40,10 @@ class DataStreamRecvr {
     return cb_->GetBatch(is_cancelled);
   }
 
+  // Cancels the stream, which unblocks GetBatch() and makes it (and all subsequent
+  // calls) return with 'is_cancelled' set. Senders are unblocked as well. Thread-safe.
+  void Cancel() { cb_->CancelStream(); }
+
   // deregister from mgr_
   void Close() {
     // TODO: log error msg
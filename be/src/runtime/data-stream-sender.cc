@@ -45,7 +45,9 @@ using namespace apache::thrift::transport;
 namespace impala {
 
 // A channel sends data asynchronously via calls to TransmitData
-// to a single destination ipaddress/node.
+// to a single destination ipaddress/node. Unless the caller requires an asynchronous
+// send, the rpc thread counts as an optional thread of the fragment's resource pool;
+// if no token is available, data is sent synchronously instead.
 // It has a fixed-capacity buffer and allows the caller either to add rows to
 // that buffer individually (AddRow()), or circumvent the buffer altogether and send
 // TRowBatches directly (SendBatch()). Either way, there can only be one in-flight RPC
@@ -71,7 +73,8 @@ class DataStreamSender::Channel {
       num_data_bytes_sent_(0),
       rpc_thread_("DataStreamSender", "SenderThread", 1, 1,
           bind<void>(mem_fn(&Channel::TransmitData), this, _1, _2)),
-      rpc_in_flight_(false) {
+      rpc_in_flight_(false),
+      rpc_holds_thread_token_(false) {
   }
 
   // Initialize channel.
@@ -83,10 +86,12 @@ class DataStreamSender::Channel {
   // Returns error status if any of the preceding rpcs failed, OK otherwise.
   Status AddRow(TupleRow* row);
 
-  // Asynchronously sends a row batch.
+  // Sends a row batch. If 'allow_sync' is true and no thread token is available,
+  // the batch is sent synchronously from the calling thread; otherwise it is sent
+  // asynchronously via rpc_thread_.
   // Returns the status of the most recently finished TransmitData
   // rpc (or OK if there wasn't one that hasn't been reported yet).
-  Status SendBatch(TRowBatch* batch);
+  Status SendBatch(TRowBatch* batch, bool allow_sync);
 
   // Return status of last TransmitData rpc (initiated by the most recent call
   // to either SendBatch() or SendCurrentBatch()).
@@ -126,6 +131,8 @@ class DataStreamSender::Channel {
   condition_variable rpc_done_cv_;   // signaled when rpc_in_flight_ is set to true.
   mutex rpc_thread_lock_; // Lock with rpc_done_cv_ protecting rpc_in_flight_
   bool rpc_in_flight_;  // true if the rpc_thread_ is busy sending.
+  // true if the in-flight rpc holds a thread token that TransmitData() must release
+  bool rpc_holds_thread_token_;
 
   Status rpc_status_;  // status of most recently finished TransmitData rpc
 
@@ -154,18 +161,37 @@ Status DataStreamSender::Channel::Init(RuntimeState* state) {
   return Status::OK;
 }
 
-Status DataStreamSender::Channel::SendBatch(TRowBatch* batch) {
+Status DataStreamSender::Channel::SendBatch(TRowBatch* batch, bool allow_sync) {
   VLOG_ROW << "Channel::SendBatch() instance_id=" << fragment_instance_id_
            << " dest_node=" << dest_node_id_ << " #rows=" << batch->num_rows;
   // return if the previous batch saw an error
   RETURN_IF_ERROR(GetSendStatus());
+
+  // The rpc thread is an optional thread: only send asynchronously if the fragment
+  // can get a thread token, otherwise the system is busy and sending from this
+  // thread costs less than adding another runnable thread.
+  ThreadResourceMgr::ResourcePool* pool = parent_->state_->resource_pool();
+  bool holds_token = false;
+  if (allow_sync && pool != NULL) {
+    if (!pool->TryAcquireThreadToken()) {
+      COUNTER_UPDATE(parent_->sync_sends_counter_, 1);
+      SCOPED_TIMER(parent_->state_->total_network_wait_timer());
+      TransmitDataHelper(batch);
+      return rpc_status_;
+    }
+    holds_token = true;
+  }
+  COUNTER_UPDATE(parent_->async_sends_counter_, 1);
   {
     unique_lock<mutex> l(rpc_thread_lock_);
     rpc_in_flight_ = true;
+    rpc_holds_thread_token_ = holds_token;
   }
   if (!rpc_thread_.Offer(batch)) {
+    if (holds_token) pool->ReleaseThreadToken(false);
     unique_lock<mutex> l(rpc_thread_lock_);
     rpc_in_flight_ = false;
+    rpc_holds_thread_token_ = false;
   }
   return Status::OK;
 }
@@ -176,6 +202,11 @@ void DataStreamSender::Channel::TransmitData(int thread_id, const TRowBatch* bat
 
   {
     unique_lock<mutex> l(rpc_thread_lock_);
+    // Give back the token acquired in SendBatch(), if any.
+    if (rpc_holds_thread_token_) {
+      parent_->state_->resource_pool()->ReleaseThreadToken(false);
+      rpc_holds_thread_token_ = false;
+    }
     rpc_in_flight_ = false;
   }
   rpc_done_cv_.notify_one();
@@ -271,7 +302,7 @@ Status DataStreamSender::Channel::SendCurrentBatch() {
     COUNTER_UPDATE(parent_->uncompressed_bytes_counter_, uncompressed_bytes);
   }
   batch_->Reset();
-  RETURN_IF_ERROR(SendBatch(&thrift_batch_));
+  RETURN_IF_ERROR(SendBatch(&thrift_batch_, true));
   return Status::OK;
 }
 
@@ -344,6 +375,8 @@ DataStreamSender::DataStreamSender(ObjectPool* pool,
     serialize_batch_timer_(NULL),
     thrift_transmit_timer_(NULL),
     bytes_sent_counter_(NULL),
+    sync_sends_counter_(NULL),
+    async_sends_counter_(NULL),
     dest_node_id_(sink.dest_node_id) {
   DCHECK_GT(destinations.size(), 0);
   DCHECK(sink.output_partition.type == TPartitionType::UNPARTITIONED
@@ -399,6 +432,8 @@ Status DataStreamSender::Init(RuntimeState* state) {
   serialize_batch_timer_ =
       ADD_TIMER(profile(), "SerializeBatchTime");
   thrift_transmit_timer_ = ADD_TIMER(profile(), "ThriftTransmitTime(*)");
+  sync_sends_counter_ = ADD_COUNTER(profile(), "SyncSends", TCounterType::UNIT);
+  async_sends_counter_ = ADD_COUNTER(profile(), "AsyncSends", TCounterType::UNIT);
   network_throughput_ =
       profile()->AddDerivedCounter("NetworkThroughput(*)", TCounterType::BYTES_PER_SECOND,
           bind<int64_t>(&RuntimeProfile::UnitsPerSecond, bytes_sent_counter_,
@@ -429,9 +464,12 @@ Status DataStreamSender::Send(RuntimeState* state, RowBatch* batch, bool eos) {
     }
 
     // SendBatch() will block if there are still in-flight rpcs (and those will
-    // reference the previously written thrift batch)
+    // reference the previously written thrift batch). With more than one receiver,
+    // always send asynchronously so the rpcs to all receivers overlap; falling back
+    // to synchronous sends would serialize them.
+    bool allow_sync = channels_.size() == 1;
     for (int i = 0; i < channels_.size(); ++i) {
-      RETURN_IF_ERROR(channels_[i]->SendBatch(current_thrift_batch_));
+      RETURN_IF_ERROR(channels_[i]->SendBatch(current_thrift_batch_, allow_sync));
     }
     current_thrift_batch_ =
         (current_thrift_batch_ == &thrift_batch1_ ? &thrift_batch2_ : &thrift_batch1_);
@@ -101,6 +101,10 @@ class DataStreamSender : public DataSink {
   RuntimeProfile::Counter* thrift_transmit_timer_;
   RuntimeProfile::Counter* bytes_sent_counter_;
   RuntimeProfile::Counter* uncompressed_bytes_counter_;
+  // Number of batches sent synchronously from the fragment thread because no thread
+  // token was available, and number of batches sent via a channel's rpc thread.
+  RuntimeProfile::Counter* sync_sends_counter_;
+  RuntimeProfile::Counter* async_sends_counter_;
   boost::scoped_ptr<MemTracker> mem_tracker_;
 
   // Throughput per time spent in TransmitData
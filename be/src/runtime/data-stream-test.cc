@@ -63,6 +63,9 @@ class ImpalaTestBackend : public ImpalaInternalServiceIf {
   virtual void ExecPlanFragment(
       TExecPlanFragmentResult& return_val, const TExecPlanFragmentParams& params) {}
 
+  virtual void ExecPlanFragments(
+      TExecPlanFragmentsResult& return_val, const TExecPlanFragmentsParams& params) {}
+
   virtual void ReportExecStatus(
       TReportExecStatusResult& return_val, const TReportExecStatusParams& params) {}
 
@@ -21,6 +21,7 @@
 #include <gutil/strings/substitute.h>
 
 #include "common/logging.h"
+#include "exec/hdfs-table-sink.h"
 #include "resourcebroker/resource-broker.h"
 #include "runtime/client-cache.h"
 #include "runtime/data-stream-mgr.h"
@@ -61,6 +62,15 @@ DEFINE_int32(state_store_subscriber_port, 23000,
     "port where StatestoreSubscriberService should be exported");
 DEFINE_int32(num_hdfs_worker_threads, 16,
     "(Advanced) The number of threads in the global HDFS operation pool");
+DEFINE_int32(num_fragment_exec_rpc_threads, 32, "(Advanced) The number of threads "
+    "coordinators use to start plan fragments on remote backends in parallel");
+DEFINE_int32(num_decompression_threads, 0, "(Experimental) The number of threads in "
+    "the global pool that decompresses blocks of sequence files ahead of the scanners "
+    "parsing them. These threads are not accounted for by the per-query thread quota. "
+    "If 0, scanners decompress blocks themselves.");
+DEFINE_int32(num_table_writer_threads, 0, "(Experimental) The number of threads in "
+    "the global pool that encodes and writes the partitions of INSERTs in parallel. If "
+    "0, table sinks write all partitions from the fragment thread.");
 
 DECLARE_int32(state_store_port);
 DECLARE_int32(num_threads_per_core);
@@ -111,6 +121,14 @@ ExecEnv::ExecEnv()
     cgroups_mgr_(NULL),
     hdfs_op_thread_pool_(
         CreateHdfsOpThreadPool("hdfs-worker-pool", FLAGS_num_hdfs_worker_threads, 1024)),
+    fragment_exec_rpc_pool_(ParallelExecutor::CreatePool("fragment-exec-rpc-worker",
+        FLAGS_num_fragment_exec_rpc_threads, 1024)),
+    decompression_thread_pool_(FLAGS_num_decompression_threads > 0 ?
+        CreateDecompressionThreadPool("decompression-worker-pool",
+            FLAGS_num_decompression_threads, 1024) : NULL),
+    table_writer_thread_pool_(FLAGS_num_table_writer_threads > 0 ?
+        CreateTableWriterThreadPool("table-writer-pool",
+            FLAGS_num_table_writer_threads, 1024) : NULL),
     enable_webserver_(FLAGS_enable_webserver),
     tz_database_(TimezoneDatabase()),
     is_fe_tests_(false) {
@@ -164,6 +182,14 @@ ExecEnv::ExecEnv(const string& hostname, int backend_port, int subscriber_port,
     thread_mgr_(new ThreadResourceMgr),
     hdfs_op_thread_pool_(
         CreateHdfsOpThreadPool("hdfs-worker-pool", FLAGS_num_hdfs_worker_threads, 1024)),
+    fragment_exec_rpc_pool_(ParallelExecutor::CreatePool("fragment-exec-rpc-worker",
+        FLAGS_num_fragment_exec_rpc_threads, 1024)),
+    decompression_thread_pool_(FLAGS_num_decompression_threads > 0 ?
+        CreateDecompressionThreadPool("decompression-worker-pool",
+            FLAGS_num_decompression_threads, 1024) : NULL),
+    table_writer_thread_pool_(FLAGS_num_table_writer_threads > 0 ?
+        CreateTableWriterThreadPool("table-writer-pool",
+            FLAGS_num_table_writer_threads, 1024) : NULL),
     enable_webserver_(FLAGS_enable_webserver && webserver_port > 0),
     tz_database_(TimezoneDatabase()),
     is_fe_tests_(false) {
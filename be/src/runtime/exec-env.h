@@ -23,8 +23,11 @@
 #include "common/status.h"
 #include "exprs/timestamp-functions.h"
 #include "runtime/client-cache.h"
+#include "runtime/parallel-executor.h"
 #include "util/cgroups-mgr.h"
+#include "util/codec.h" // For declaration of DecompressionThreadPool
 #include "util/hdfs-bulk-ops.h" // For declaration of HdfsOpThreadPool
+#include "util/thread-pool.h"
 #include "resourcebroker/resource-broker.h"
 
 namespace impala {
@@ -43,6 +46,10 @@ class MemTracker;
 class ThreadResourceMgr;
 class CgroupsManager;
 
+// Defined in exec/hdfs-table-sink.h, which depends on this header.
+struct PartitionWriteTask;
+typedef ThreadPool<PartitionWriteTask*> TableWriterThreadPool;
+
 // Execution environment for queries/plan fragments.
 // Contains all required global structures, and handles to
 // singleton services. Clients must call StartServices exactly
@@ -84,6 +91,20 @@ class ExecEnv {
   ThreadResourceMgr* thread_mgr() { return thread_mgr_.get(); }
   CgroupsMgr* cgroups_mgr() { return cgroups_mgr_.get(); }
   HdfsOpThreadPool* hdfs_op_thread_pool() { return hdfs_op_thread_pool_.get(); }
+  // Pool shared by all coordinators to issue ExecPlanFragments() rpcs.
+  ParallelExecutor::Pool* fragment_exec_rpc_pool() {
+    return fragment_exec_rpc_pool_.get();
+  }
+  // Pool used by scanners to decompress blocks ahead. NULL if
+  // --num_decompression_threads is 0.
+  DecompressionThreadPool* decompression_thread_pool() {
+    return decompression_thread_pool_.get();
+  }
+  // Pool used by table sinks to write partitions in parallel. NULL if
+  // --num_table_writer_threads is 0.
+  TableWriterThreadPool* table_writer_thread_pool() {
+    return table_writer_thread_pool_.get();
+  }
 
   void set_enable_webserver(bool enable) { enable_webserver_ = enable; }
 
@@ -118,6 +139,9 @@ class ExecEnv {
   boost::scoped_ptr<ThreadResourceMgr> thread_mgr_;
   boost::scoped_ptr<CgroupsMgr> cgroups_mgr_;
   boost::scoped_ptr<HdfsOpThreadPool> hdfs_op_thread_pool_;
+  boost::scoped_ptr<ParallelExecutor::Pool> fragment_exec_rpc_pool_;
+  boost::scoped_ptr<DecompressionThreadPool> decompression_thread_pool_;
+  boost::scoped_ptr<TableWriterThreadPool> table_writer_thread_pool_;
 
   bool enable_webserver_;
 
@@ -16,6 +16,7 @@
 #include <string>
 #include <gtest/gtest.h>
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "runtime/parallel-executor.h"
 #include "util/thread.h"
@@ -75,6 +76,24 @@ TEST(ParallelExecutorTest, Basic) {
   test_caller.Validate();
 }
 
+TEST(ParallelExecutorTest, SharedPool) {
+  int num_work_items = 100;
+  ParallelExecutorTest test_caller(num_work_items);
+  scoped_ptr<ParallelExecutor::Pool> pool(ParallelExecutor::CreatePool("test", 4, 10));
+
+  vector<long> args;
+  for (int i = 0; i < num_work_items; ++i) {
+    args.push_back(i);
+  }
+
+  Status status = ParallelExecutor::Exec(pool.get(),
+      bind<Status>(mem_fn(&ParallelExecutorTest::UpdateFunction), &test_caller, _1),
+      reinterpret_cast<void**>(&args[0]), args.size());
+  EXPECT_TRUE(status.ok());
+
+  test_caller.Validate();
+}
+
 }
 
 int main(int argc, char **argv) {
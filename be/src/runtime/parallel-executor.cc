@@ -14,6 +14,7 @@
 
 #include "runtime/parallel-executor.h"
 
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/thread.hpp>
 
 #include "util/thread.h"
@@ -22,6 +23,58 @@ using namespace boost;
 using namespace impala;
 using namespace std;
 
+// State shared by all work items of one call to Exec(pool, ...).
+struct PoolExecState {
+  mutex lock;
+  // Signalled when num_remaining reaches 0.
+  condition_variable done_cv;
+  int num_remaining;
+  // Status of the first work item that failed.
+  Status status;
+};
+
+struct ParallelExecutor::WorkItem {
+  Function function;
+  void* arg;
+  PoolExecState* exec_state;
+
+  // Runs the function and records its result in exec_state.
+  void Run() {
+    Status local_status = function(arg);
+    lock_guard<mutex> l(exec_state->lock);
+    if (!local_status.ok() && exec_state->status.ok()) exec_state->status = local_status;
+    if (--exec_state->num_remaining == 0) exec_state->done_cv.notify_all();
+  }
+};
+
+ParallelExecutor::Pool* ParallelExecutor::CreatePool(const string& name,
+    uint32_t num_threads, uint32_t max_queue_length) {
+  return new Pool("parallel-executor", name, num_threads, max_queue_length,
+      &ParallelExecutor::PoolWorker);
+}
+
+void ParallelExecutor::PoolWorker(int thread_id, WorkItem* const& item) {
+  item->Run();
+}
+
+Status ParallelExecutor::Exec(Pool* pool, Function function, void** args,
+    int num_args) {
+  DCHECK(pool != NULL);
+  PoolExecState exec_state;
+  exec_state.num_remaining = num_args;
+  vector<WorkItem> items(num_args);
+  for (int i = 0; i < num_args; ++i) {
+    items[i].function = function;
+    items[i].arg = args[i];
+    items[i].exec_state = &exec_state;
+    // If the pool has been shut down, run the work item on this thread instead.
+    if (!pool->Offer(&items[i])) items[i].Run();
+  }
+  unique_lock<mutex> l(exec_state.lock);
+  while (exec_state.num_remaining > 0) exec_state.done_cv.wait(l);
+  return exec_state.status;
+}
+
 Status ParallelExecutor::Exec(Function function, void** args, int num_args) {
   Status status;
   ThreadGroup worker_threads;
@@ -19,15 +19,14 @@
 #include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
 #include "common/status.h"
+#include "util/thread-pool.h"
 
 namespace impala {
 
 // This is a class that executes multiple functions in parallel with different arguments
-// using a thread pool.
+// using a thread pool. The work can either run on threads created for each call, or
+// on a long-lived, shared Pool.
 // TODO: look into an API for this.  Boost has one that is in review but not yet official.
-// TODO: use a shared pool?  Thread creation is pretty cheap so this might not be
-// worth it
-// TODO: Consider rewriting in terms of ThreadPool
 class ParallelExecutor {
  public:
   // Typedef for the underlying function for the work.
@@ -44,10 +43,29 @@ class ParallelExecutor {
   // Otherwise, returns Status::OK when all work items have been executed.
   static Status Exec(Function function, void** args, int num_args);
 
+  // A single call of a function, run by a Pool. Used only internally by Exec(), but
+  // visible because it parameterises Pool.
+  struct WorkItem;
+  typedef ThreadPool<WorkItem*> Pool;
+
+  // Creates a new pool of num_threads threads to run work items on. At most
+  // max_queue_length work items may be waiting to be run at any time; Exec() blocks
+  // while the queue is full.
+  static Pool* CreatePool(const std::string& name, uint32_t num_threads,
+      uint32_t max_queue_length);
+
+  // Same as Exec() above, but runs the work items on the threads of 'pool', so at most
+  // as many work items as there are threads in the pool run in parallel. The pool may
+  // be shared between concurrent callers.
+  static Status Exec(Pool* pool, Function function, void** args, int num_args);
+
  private:
   // Worker thread function which calls function(arg).  This function updates
   // *status taking *lock to synchronize results from different threads.
   static void Worker(Function function, void* arg, boost::mutex* lock, Status* status);
+
+  // Pool worker function which runs 'item' and signals its caller.
+  static void PoolWorker(int thread_id, WorkItem* const& item);
 };
 
 }
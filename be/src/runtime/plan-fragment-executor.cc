@@ -44,6 +44,11 @@
 
 DEFINE_bool(serialize_batch, false, "serialize and deserialize each returned row batch");
 DEFINE_int32(status_report_interval, 5, "interval between profile reports; in seconds");
+DEFINE_bool(async_codegen, false, "if true, fragments start executing with the "
+    "interpreted code while the codegen'd functions are optimized and compiled in the "
+    "background, and switch to the compiled functions once they are ready");
+DEFINE_int64(codegen_min_scan_bytes, 0, "fragments that only scan hdfs data and read "
+    "fewer than this many bytes are executed without codegen. 0 disables the check.");
 DECLARE_bool(enable_rm);
 
 using namespace std;
@@ -90,8 +95,18 @@ Status PlanFragmentExecutor::Prepare(const TExecPlanFragmentParams& request) {
     cgroup = exec_env_->cgroups_mgr()->ResourceIdToCgroup(resource_id);
   }
 
+  // For tiny inputs, compiling the codegen'd functions takes longer than the
+  // execution time they save.
+  TQueryContext query_ctxt = request.query_ctxt;
+  bool skip_codegen = !query_ctxt.request.query_options.disable_codegen &&
+      IsSmallScanFragment(request);
+  if (skip_codegen) query_ctxt.request.query_options.disable_codegen = true;
+
   runtime_state_.reset(new RuntimeState(query_id_, params.fragment_instance_id,
-      request.query_ctxt, cgroup, exec_env_));
+      query_ctxt, cgroup, exec_env_));
+  if (skip_codegen) {
+    profile()->AddInfoString("Codegen", "Disabled for small input");
+  }
 
   // Register after setting runtime_state_ to ensure proper cleanup.
   if (FLAGS_enable_rm && !cgroup.empty()) {
@@ -218,8 +233,36 @@ Status PlanFragmentExecutor::Prepare(const TExecPlanFragmentParams& request) {
   return Status::OK;
 }
 
+bool PlanFragmentExecutor::IsSmallScanFragment(
+    const TExecPlanFragmentParams& request) {
+  if (FLAGS_codegen_min_scan_bytes <= 0) return false;
+  // The size of the input from exchanges is not known up front.
+  BOOST_FOREACH(const TPlanNode& node, request.fragment.plan.nodes) {
+    if (node.node_type == TPlanNodeType::EXCHANGE_NODE) return false;
+  }
+  int64_t scan_bytes = 0;
+  BOOST_FOREACH(const PerNodeScanRanges::value_type& entry,
+      request.params.per_node_scan_ranges) {
+    BOOST_FOREACH(const TScanRangeParams& scan_range, entry.second) {
+      if (!scan_range.scan_range.__isset.hdfs_file_split) return false;
+      scan_bytes += scan_range.scan_range.hdfs_file_split.length;
+    }
+  }
+  return scan_bytes < FLAGS_codegen_min_scan_bytes;
+}
+
 void PlanFragmentExecutor::OptimizeLlvmModule() {
-  if (runtime_state_->codegen() == NULL) return;
+  LlvmCodeGen* codegen = runtime_state_->codegen();
+  if (codegen == NULL) return;
+  if (FLAGS_async_codegen && codegen->CanOptimizeAsync()) {
+    codegen_thread_.reset(new Thread("plan-fragment-executor", "codegen",
+        &PlanFragmentExecutor::OptimizeLlvmModuleInternal, this));
+    return;
+  }
+  OptimizeLlvmModuleInternal();
+}
+
+void PlanFragmentExecutor::OptimizeLlvmModuleInternal() {
   Status status = runtime_state_->codegen()->OptimizeModule();
   if (!status.ok()) {
     stringstream ss;
@@ -495,6 +538,11 @@ void PlanFragmentExecutor::Close() {
   if (closed_)
     return;
   row_batch_.reset();
+  // The exec nodes may not be closed while their functions are being compiled.
+  if (codegen_thread_.get() != NULL) {
+    codegen_thread_->Join();
+    codegen_thread_.reset();
+  }
   // Prepare may not have been called, which sets runtime_state_
   if (runtime_state_.get() != NULL) {
     if (FLAGS_enable_rm) {
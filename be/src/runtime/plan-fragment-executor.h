@@ -125,6 +125,9 @@ class PlanFragmentExecutor {
 
   // Optimizes the code-generated functions in runtime_state_->llvm_codegen().
   // Can be called exactly once. Logs the error status if optimization failed.
+  // With --async_codegen, the module is optimized in codegen_thread_ if every jitted
+  // function has an interpreted fallback, and the exec nodes switch to the jitted
+  // functions as they become available.
   void OptimizeLlvmModule();
 
   // call these only after Prepare()
@@ -142,6 +145,9 @@ class PlanFragmentExecutor {
   // profile reporting-related
   ReportStatusCallback report_status_cb_;
   boost::scoped_ptr<Thread> report_thread_;
+
+  // Optimizes the llvm module when --async_codegen is set. Joined in Close().
+  boost::scoped_ptr<Thread> codegen_thread_;
   boost::mutex report_thread_lock_;
 
   // Indicates that profile reporting thread should stop.
@@ -247,6 +253,13 @@ class PlanFragmentExecutor {
   void PrintVolumeIds(const TPlanExecParams& params);
   void PrintVolumeIds(const PerNodeScanRanges& per_node_scan_ranges);
 
+  // Body of OptimizeLlvmModule(); runs in codegen_thread_ in async mode.
+  void OptimizeLlvmModuleInternal();
+
+  // Returns true if the fragment only scans hdfs data and reads fewer than
+  // --codegen_min_scan_bytes bytes, in which case it is executed without codegen.
+  static bool IsSmallScanFragment(const TExecPlanFragmentParams& request);
+
   const DescriptorTbl& desc_tbl() { return runtime_state_->desc_tbl(); }
 };
 
@@ -15,7 +15,9 @@
 #include "runtime/row-batch.h"
 
 #include <stdint.h>  // for intptr_t
+#include <boost/algorithm/string.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <gflags/gflags.h>
 
 #include "runtime/string-value.h"
 #include "runtime/tuple-row.h"
@@ -25,10 +27,46 @@
 #include "gen-cpp/Data_types.h"
 
 using namespace boost;
+using namespace boost::algorithm;
 using namespace std;
 
+DEFINE_string(row_batch_compression_codec, "snappy", "(Advanced) Codec used to "
+    "compress the row batches sent between fragments: snappy, lz4 or none. lz4 "
+    "(de)compresses faster than snappy, for a similar ratio.");
+
 namespace impala {
 
+// Parses the value of --row_batch_compression_codec into 'type'.
+static Status ParseRowBatchCodec(const string& codec, THdfsCompression::type* type) {
+  if (iequals(codec, "snappy")) {
+    *type = THdfsCompression::SNAPPY;
+  } else if (iequals(codec, "lz4")) {
+    *type = THdfsCompression::LZ4;
+  } else if (iequals(codec, "none")) {
+    *type = THdfsCompression::NONE;
+  } else {
+    stringstream ss;
+    ss << "Invalid row batch compression codec: " << codec
+       << ". Valid values are snappy, lz4 and none.";
+    return Status(ss.str());
+  }
+  return Status::OK;
+}
+
+// Returns the codec selected by --row_batch_compression_codec.
+static THdfsCompression::type RowBatchCodec() {
+  THdfsCompression::type codec = THdfsCompression::SNAPPY;
+  Status status = ParseRowBatchCodec(FLAGS_row_batch_compression_codec, &codec);
+  // The flag is validated at startup, see ValidateCompressionCodecFlag().
+  DCHECK(status.ok()) << status.GetErrorMsg();
+  return codec;
+}
+
+Status RowBatch::ValidateCompressionCodecFlag() {
+  THdfsCompression::type codec;
+  return ParseRowBatchCodec(FLAGS_row_batch_compression_codec, &codec);
+}
+
 RowBatch::RowBatch(const RowDescriptor& row_desc, int capacity,
     MemTracker* mem_tracker)
   : mem_tracker_(mem_tracker),
@@ -69,12 +107,16 @@ RowBatch::RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch,
     uint8_t* compressed_data = (uint8_t*)input_batch.tuple_data.c_str();
     size_t compressed_size = input_batch.tuple_data.size();
 
+    // Batches from older senders don't set the codec, and are always snappy.
+    THdfsCompression::type codec = input_batch.__isset.compression_type ?
+        input_batch.compression_type : THdfsCompression::SNAPPY;
     scoped_ptr<Codec> decompressor;
-    Status status =
-        Codec::CreateDecompressor(NULL, false, THdfsCompression::SNAPPY, &decompressor);
+    Status status = Codec::CreateDecompressor(NULL, false, codec, &decompressor);
     DCHECK(status.ok()) << status.GetErrorMsg();
 
-    int uncompressed_size = decompressor->MaxOutputLen(compressed_size, compressed_data);
+    int uncompressed_size = input_batch.__isset.uncompressed_size ?
+        input_batch.uncompressed_size :
+        decompressor->MaxOutputLen(compressed_size, compressed_data);
     DCHECK_NE(uncompressed_size, -1) << "RowBatch decompression failed";
     uint8_t* data = tuple_data_pool_->Allocate(uncompressed_size);
     status = decompressor->ProcessBlock(true, compressed_size, compressed_data,
@@ -145,6 +187,8 @@ int RowBatch::Serialize(TRowBatch* output_batch) {
   output_batch->row_tuples.clear();
   output_batch->tuple_offsets.clear();
   output_batch->is_compressed = false;
+  output_batch->__isset.compression_type = false;
+  output_batch->__isset.uncompressed_size = false;
 
   output_batch->num_rows = num_rows_;
   row_desc_.ToThrift(&output_batch->row_tuples);
@@ -175,12 +219,12 @@ int RowBatch::Serialize(TRowBatch* output_batch) {
   }
   DCHECK_EQ(offset, size);
 
-  if (size > 0) {
+  THdfsCompression::type codec = RowBatchCodec();
+  if (size > 0 && codec != THdfsCompression::NONE) {
     // Try compressing tuple_data to compression_scratch_, swap if compressed data is
     // smaller
     scoped_ptr<Codec> compressor;
-    Status status =
-        Codec::CreateCompressor(NULL, false, THdfsCompression::SNAPPY, &compressor);
+    Status status = Codec::CreateCompressor(NULL, false, codec, &compressor);
     DCHECK(status.ok()) << status.GetErrorMsg();
 
     int compressed_size = compressor->MaxOutputLen(size);
@@ -194,6 +238,8 @@ int RowBatch::Serialize(TRowBatch* output_batch) {
       compression_scratch_.resize(compressed_size);
       output_batch->tuple_data.swap(compression_scratch_);
       output_batch->is_compressed = true;
+      output_batch->__set_compression_type(codec);
+      output_batch->__set_uncompressed_size(size);
     }
     VLOG_ROW << "uncompressed size: " << size << ", compressed size: " << compressed_size;
   }
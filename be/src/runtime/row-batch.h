@@ -182,6 +182,10 @@ class RowBatch {
   // Utility function: returns total size of batch.
   static int GetBatchSize(const TRowBatch& batch);
 
+  // Returns an error if --row_batch_compression_codec is not a valid codec. Called at
+  // startup, so that an invalid value is not silently replaced.
+  static Status ValidateCompressionCodecFlag();
+
   int num_rows() const { return num_rows_; }
   int capacity() const { return capacity_; }
 
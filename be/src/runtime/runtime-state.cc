@@ -101,9 +101,14 @@ Status RuntimeState::Init(const TUniqueId& fragment_instance_id, ExecEnv* exec_e
     query_options.__set_batch_size(DEFAULT_BATCH_SIZE);
   }
 
-  // Register with the thread mgr
+  // Register with the thread mgr. All fragments of a query on this backend share the
+  // query's part of the thread quota, weighted by the query's requested cores.
   if (exec_env != NULL) {
-    resource_pool_ = exec_env->thread_mgr()->RegisterPool();
+    int weight = 1;
+    if (query_options.__isset.v_cpu_cores && query_options.v_cpu_cores > 0) {
+      weight = query_options.v_cpu_cores;
+    }
+    resource_pool_ = exec_env->thread_mgr()->RegisterPool(PrintId(query_id_), weight);
     DCHECK(resource_pool_ != NULL);
   }
 
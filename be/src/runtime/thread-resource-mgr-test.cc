@@ -31,7 +31,7 @@ class NotifiedCounter {
   
   void Notify(ThreadResourceMgr::ResourcePool* consumer) {
     DCHECK(consumer != NULL);
-    DCHECK_LT(consumer->num_threads(), consumer->quota());
+    DCHECK_GT(consumer->num_available_threads(), 0);
     ++counter_;
   }
 
@@ -70,20 +70,93 @@ TEST(ThreadResourceMgr, BasicTest) {
   c1->ReleaseThreadToken(false);
   EXPECT_EQ(counter1.counter(), 3);
   
-  // Register a new consumer, quota is cut in half
+  // Register a new consumer, quota is cut in half. c1 is notified since it can
+  // still borrow the tokens c2 is not using.
   ThreadResourceMgr::ResourcePool* c2 = mgr.RegisterPool();
   c2->SetThreadAvailableCb(bind<void>(mem_fn(&NotifiedCounter::Notify), &counter2, _1));
+  EXPECT_EQ(c1->quota(), 3);
+  EXPECT_EQ(c2->quota(), 3);
+  EXPECT_EQ(counter1.counter(), 4);
+  EXPECT_TRUE(c1->TryAcquireThreadToken());
+  EXPECT_EQ(c1->num_threads(), 4);
+  EXPECT_EQ(c1->num_required_threads(), 1);
+  EXPECT_EQ(c1->num_optional_threads(), 3);
+  EXPECT_FALSE(c1->optional_exceeded());
+
+  // c2 starts using its share, the system is oversubscribed and c1 has to give
+  // up its borrowed threads.
+  c2->AcquireThreadToken();
+  c2->AcquireThreadToken();
+  EXPECT_TRUE(c1->optional_exceeded());
   EXPECT_FALSE(c1->TryAcquireThreadToken());
+  c1->ReleaseThreadToken(false);
   EXPECT_EQ(c1->num_threads(), 3);
-  c1->AcquireThreadToken();
-  EXPECT_EQ(c1->num_threads(), 4);
-  EXPECT_EQ(c1->num_required_threads(), 2);
-  EXPECT_EQ(c1->num_optional_threads(), 2);
+  EXPECT_EQ(counter1.counter(), 4);
+  EXPECT_EQ(counter2.counter(), 0);
+
+  // Releasing c2's token makes it available to c1.
+  c2->ReleaseThreadToken(true);
+  EXPECT_EQ(counter1.counter(), 5);
+  EXPECT_EQ(counter2.counter(), 1);
+  EXPECT_TRUE(c1->TryAcquireThreadToken());
+  EXPECT_FALSE(c1->TryAcquireThreadToken());
+
+  // Other pools are only notified when a release leaves a token idle that was not
+  // idle before.
+  c1->ReleaseThreadToken(false);
+  EXPECT_EQ(counter1.counter(), 6);
+  EXPECT_EQ(counter2.counter(), 2);
+  c1->ReleaseThreadToken(false);
+  EXPECT_EQ(counter1.counter(), 7);
+  EXPECT_EQ(counter2.counter(), 2);
 
   mgr.UnregisterPool(c1);
+  EXPECT_EQ(counter2.counter(), 3);
   mgr.UnregisterPool(c2);
-  EXPECT_EQ(counter1.counter(), 3);
-  EXPECT_EQ(counter2.counter(), 1);
+  EXPECT_EQ(counter1.counter(), 7);
+}
+
+TEST(ThreadResourceMgr, GroupTest) {
+  ThreadResourceMgr mgr(12);
+
+  // Two fragments of a query with weight 1 and one fragment of a query with weight 2.
+  ThreadResourceMgr::ResourcePool* q1_f1 = mgr.RegisterPool("q1", 1);
+  ThreadResourceMgr::ResourcePool* q1_f2 = mgr.RegisterPool("q1", 1);
+  ThreadResourceMgr::ResourcePool* q2_f1 = mgr.RegisterPool("q2", 2);
+  EXPECT_EQ(q1_f1->quota(), 2);
+  EXPECT_EQ(q1_f2->quota(), 2);
+  EXPECT_EQ(q2_f1->quota(), 8);
+
+  // Pools without a group are groups of their own.
+  ThreadResourceMgr::ResourcePool* p = mgr.RegisterPool();
+  EXPECT_EQ(q1_f1->quota(), 2);
+  EXPECT_EQ(q2_f1->quota(), 6);
+  EXPECT_EQ(p->quota(), 3);
+
+  // Idle tokens can be borrowed beyond the quota, up to the system quota.
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_TRUE(q1_f1->TryAcquireThreadToken());
+  }
+  EXPECT_FALSE(q1_f1->TryAcquireThreadToken());
+  EXPECT_FALSE(q1_f1->optional_exceeded());
+
+  // A pool within its quota always gets tokens; the borrowing pool is then asked to
+  // give up its optional threads.
+  EXPECT_TRUE(p->TryAcquireThreadToken());
+  EXPECT_TRUE(q1_f1->optional_exceeded());
+  q1_f1->ReleaseThreadToken(false);
+  EXPECT_FALSE(q1_f1->optional_exceeded());
+  EXPECT_EQ(p->num_threads(), 1);
+
+  // The max quota is never exceeded, even if tokens are idle.
+  mgr.UnregisterPool(q1_f1);
+  q2_f1->set_max_quota(1);
+  EXPECT_TRUE(q2_f1->TryAcquireThreadToken());
+  EXPECT_FALSE(q2_f1->TryAcquireThreadToken());
+
+  mgr.UnregisterPool(q1_f2);
+  mgr.UnregisterPool(q2_f1);
+  mgr.UnregisterPool(p);
 }
 
 }
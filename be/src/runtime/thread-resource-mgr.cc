@@ -17,6 +17,7 @@
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/unordered_map.hpp>
 #include <gflags/gflags.h>
 
 #include "common/logging.h"
@@ -38,7 +39,7 @@ ThreadResourceMgr::ThreadResourceMgr(int threads_quota) {
   } else {
     system_threads_quota_ = threads_quota;
   }
-  per_pool_quota_ = 0;
+  num_used_threads_ = 0;
 }
 
 ThreadResourceMgr::ResourcePool::ResourcePool(ThreadResourceMgr* parent) 
@@ -46,6 +47,9 @@ ThreadResourceMgr::ResourcePool::ResourcePool(ThreadResourceMgr* parent)
 }
 
 void ThreadResourceMgr::ResourcePool::Reset() {
+  group_.clear();
+  weight_ = 1;
+  quota_ = 0;
   num_threads_ = 0;
   num_reserved_optional_threads_ = 0;
   thread_available_fn_ = NULL;
@@ -57,7 +61,9 @@ void ThreadResourceMgr::ResourcePool::ReserveOptionalTokens(int num) {
   num_reserved_optional_threads_ = num;
 }
 
-ThreadResourceMgr::ResourcePool* ThreadResourceMgr::RegisterPool() {
+ThreadResourceMgr::ResourcePool* ThreadResourceMgr::RegisterPool(
+    const string& group, int weight) {
+  DCHECK_GT(weight, 0);
   unique_lock<mutex> l(lock_);
   ResourcePool* pool = NULL;
   if (free_pool_objs_.empty()) {
@@ -71,6 +77,8 @@ ThreadResourceMgr::ResourcePool* ThreadResourceMgr::RegisterPool() {
   DCHECK(pools_.find(pool) == pools_.end());
   pools_.insert(pool);
   pool->Reset();
+  pool->group_ = group;
+  pool->weight_ = weight;
 
   // Added a new pool, update the quotas for each pool.
   UpdatePoolQuotas(pool);
@@ -81,6 +89,8 @@ void ThreadResourceMgr::UnregisterPool(ResourcePool* pool) {
   DCHECK(pool != NULL);
   unique_lock<mutex> l(lock_);
   DCHECK(pools_.find(pool) != pools_.end());
+  // Tokens that were not released are given back to the system.
+  __sync_fetch_and_add(&num_used_threads_, -pool->num_threads());
   pools_.erase(pool);
   free_pool_objs_.push_back(pool);
   UpdatePoolQuotas();
@@ -94,8 +104,37 @@ void ThreadResourceMgr::ResourcePool::SetThreadAvailableCb(ThreadAvailableCb fn)
 
 void ThreadResourceMgr::UpdatePoolQuotas(ResourcePool* new_pool) {
   if (pools_.empty()) return;
-  per_pool_quota_ = 
-      ceil(static_cast<double>(system_threads_quota_) / pools_.size());
+
+  // Compute the weight and number of pools of each group.  Pools without a group
+  // are each treated as a group of their own.
+  typedef unordered_map<string, pair<int, int> > GroupMap;
+  GroupMap groups;
+  int total_weight = 0;
+  for (Pools::iterator it = pools_.begin(); it != pools_.end(); ++it) {
+    ResourcePool* pool = *it;
+    if (pool->group_.empty()) {
+      total_weight += pool->weight_;
+      continue;
+    }
+    GroupMap::iterator group = groups.find(pool->group_);
+    if (group == groups.end()) {
+      groups[pool->group_] = make_pair(pool->weight_, 1);
+      total_weight += pool->weight_;
+    } else {
+      DCHECK_EQ(group->second.first, pool->weight_) << pool->group_;
+      ++group->second.second;
+    }
+  }
+
+  for (Pools::iterator it = pools_.begin(); it != pools_.end(); ++it) {
+    ResourcePool* pool = *it;
+    int num_pools_in_group = 1;
+    if (!pool->group_.empty()) num_pools_in_group = groups[pool->group_].second;
+    double group_quota =
+        static_cast<double>(system_threads_quota_) * pool->weight_ / total_weight;
+    pool->quota_ = max(1, static_cast<int>(ceil(group_quota / num_pools_in_group)));
+  }
+
   for (Pools::iterator it = pools_.begin(); it != pools_.end(); ++it) {
     ResourcePool* pool = *it;
     if (pool == new_pool) continue;
@@ -106,3 +145,22 @@ void ThreadResourceMgr::UpdatePoolQuotas(ResourcePool* new_pool) {
   }
 }
 
+void ThreadResourceMgr::NotifyIdlePools(ResourcePool* released_pool) {
+  vector<ResourcePool*> pools;
+  {
+    unique_lock<mutex> l(lock_);
+    for (Pools::iterator it = pools_.begin(); it != pools_.end(); ++it) {
+      if (*it != released_pool) pools.push_back(*it);
+    }
+  }
+  // Pool objects are recycled rather than freed, and a pool's callback is removed under
+  // its lock before it is unregistered, so the pools can be notified without lock_.
+  for (int i = 0; i < pools.size(); ++i) {
+    ResourcePool* pool = pools[i];
+    if (num_idle_threads() == 0) break;
+    unique_lock<mutex> pool_lock(pool->lock_);
+    if (pool->num_available_threads() > 0 && pool->thread_available_fn_ != NULL) {
+      pool->thread_available_fn_(pool);
+    }
+  }
+}
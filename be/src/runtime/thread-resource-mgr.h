@@ -24,6 +24,8 @@
 #include <boost/thread/thread.hpp>
 
 #include <list>
+#include <set>
+#include <string>
 
 #include "common/status.h"
 
@@ -34,8 +36,22 @@ namespace impala {
 // query fragments.  If there is only one fragment running, it can use the
 // entire pool, spinning up the maximum number of threads to saturate the
 // hardware.  If there are multiple fragments, the CPU pool must be shared
-// between them.  Currently, the total system pool is split evenly between
-// all consumers.  Each consumer gets ceil(total_system_threads / num_consumers).
+// between them.
+//
+// The system pool is split hierarchically.  Pools are registered as part of a
+// group (typically all fragment instances of one query on this backend), and each
+// group has a weight.  The system quota is first split between the groups
+// proportionally to their weights and each group's share is then split evenly
+// between the pools of the group.  This keeps a query with many fragments from
+// crowding out queries with few fragments.
+//
+// The quota is work conserving: the quota only limits a pool while the system as a
+// whole is busy.  If the total number of threads in use across all pools is below
+// the system quota, a pool that is at its quota may still acquire optional threads
+// (i.e. it borrows the tokens other pools are not using) and all pools waiting for
+// threads are notified as soon as a released token becomes idle.  Once the system is
+// oversubscribed, pools over their quota are asked (via optional_exceeded()) to
+// give up their optional threads.
 //
 // Each fragment must register with the ThreadResourceMgr to request threads
 // (in the form of tokens).  The fragment has required threads (it can't run
@@ -49,15 +65,11 @@ namespace impala {
 // much by design.  For example, if a pool is running on its own with
 // 4 required threads and 28 optional and another pool is added to the
 // system, the first pool's quota is then cut by half (16 total) and will
-// over time drop the optional threads.
+// over time drop the optional threads as the second pool starts using its share.
 // This class is thread safe.
-// TODO: this is an initial simple version to improve the behavior with
-// concurrency.  This will need to be expanded post GA.  These include:
-//  - More places where threads are optional (e.g. hash table build side,
-//    data stream threads, etc).
-//  - Admission control
+// TODO: this is still a fairly simple version.  Remaining items include:
 //  - Integration with other nodes/statestore
-//  - Priorities for different pools
+//  - Priorities for different request pools (currently only per-group weights)
 // If both the mgr and pool locks need to be taken, the mgr lock must
 // be taken first.
 class ThreadResourceMgr {
@@ -77,11 +89,8 @@ class ThreadResourceMgr {
   typedef boost::function<void (ResourcePool*)> ThreadAvailableCb;
 
   // Pool abstraction for a single resource pool.
-  // TODO: this is not quite sufficient going forward.  We need a hierarchy of pools,
-  // one for the entire query, and a sub pool for each component that needs threads,
-  // all of which share a quota.  Currently, the way state is tracked here, it would
-  // be impossible to have two components both want optional threads (e.g. two things
-  // that have 1+ thread usage).
+  // TODO: components within a pool (e.g. two scan nodes in the same fragment) still
+  // share a single pool and thread available callback.
   class ResourcePool {
    public:
     // Acquire a thread for the pool.  This will always succeed; the
@@ -137,26 +146,33 @@ class ThreadResourceMgr {
 
     int num_reserved_optional_threads() { return num_reserved_optional_threads_; }
 
-    // Returns true if the number of optional threads has now exceeded the quota.
+    // Returns true if the number of optional threads has now exceeded the quota
+    // and the system is oversubscribed, i.e. this pool should give up optional
+    // threads so that other pools can use their share.
     bool optional_exceeded() {
       // Cache this so optional/required are computed based on the same value.
       volatile int64_t num_threads = num_threads_;
       int64_t optional_threads = num_threads >> 32;
       int64_t required_threads = num_threads & 0xFFFFFFFF;
-      return optional_threads > num_reserved_optional_threads_ &&
-             optional_threads + required_threads > quota();
+      if (optional_threads <= num_reserved_optional_threads_) return false;
+      if (optional_threads + required_threads > max_quota_) return true;
+      return optional_threads + required_threads > quota() &&
+             parent_->system_oversubscribed();
     }
 
-    // Returns the number of optional threads that can still be used.
+    // Returns the number of optional threads that can still be used, including
+    // threads that can be borrowed from idle pools.
     int num_available_threads() const {
       int value = std::max(quota() - static_cast<int>(num_threads()),
           num_reserved_optional_threads_ - num_optional_threads());
-      return std::max(0, value);
+      int idle = std::min(parent_->num_idle_threads(),
+          max_quota_ - static_cast<int>(num_threads()));
+      return std::max(0, std::max(value, idle));
     }
 
-    // Returns the quota for this pool.  Note this changes dynamically
+    // Returns the quota (fair share) for this pool.  Note this changes dynamically
     // based on system load.
-    int quota() const { return std::min(max_quota_, parent_->per_pool_quota_); }
+    int quota() const { return std::min(max_quota_, quota_); }
 
     // Sets the max thread quota for this pool.
     // The actual quota is the min of this value and the dynamic value.
@@ -172,6 +188,13 @@ class ThreadResourceMgr {
 
     ThreadResourceMgr* parent_;
 
+    // The group this pool was registered with and the weight of that group.
+    std::string group_;
+    int weight_;
+
+    // This pool's share of the system quota, computed by UpdatePoolQuotas().
+    int quota_;
+
     int max_quota_;
     int num_reserved_optional_threads_;
 
@@ -198,7 +221,11 @@ class ThreadResourceMgr {
 
   // Register a new pool with the thread mgr.  Registering a pool
   // will update the quotas for all existing pools.
-  ResourcePool* RegisterPool();
+  // Pools registered with the same non-empty 'group' share the group's part of the
+  // system quota; an empty group puts the pool in a group of its own.  'weight'
+  // is the relative share of the group and must be the same for all pools in
+  // a group.
+  ResourcePool* RegisterPool(const std::string& group = "", int weight = 1);
 
   // Unregisters the pool.  'pool' is no longer valid after this.
   // This updates the quotas for the remaining pools.
@@ -215,21 +242,37 @@ class ThreadResourceMgr {
   typedef std::set<ResourcePool*> Pools;
   Pools pools_;
 
-  // Each pool currently gets the same share.  This is the ceil of the
-  // system quota divided by the number of pools.
-  int per_pool_quota_;
+  // Total number of tokens (required and optional) held by all pools.  Updated
+  // atomically without taking lock_.
+  int64_t num_used_threads_;
 
   // Recycled list of pool objects
   std::list<ResourcePool*> free_pool_objs_;
 
-  // Updates the per pool quota and notifies any pools that now have
-  // more threads they can use.  Must be called with lock_ taken.
+  // Returns the number of system tokens that are not held by any pool.
+  int num_idle_threads() const {
+    return std::max<int64_t>(0, system_threads_quota_ - num_used_threads_);
+  }
+
+  // Returns true if pools hold more tokens than the system quota.
+  bool system_oversubscribed() const {
+    return num_used_threads_ > system_threads_quota_;
+  }
+
+  // Recomputes the quota of every pool from the group weights and notifies any
+  // pools that now have more threads they can use.  Must be called with lock_ taken.
   // If new_pool is non-null, new_pool will *not* be notified.
   void UpdatePoolQuotas(ResourcePool* new_pool = NULL);
+
+  // Notifies all pools other than 'pool' that have available threads.  Called when
+  // 'pool' released a token that other pools may borrow.  Must be called without
+  // lock_ taken; the callbacks are called after lock_ is released.
+  void NotifyIdlePools(ResourcePool* pool);
 };
 
 inline void ThreadResourceMgr::ResourcePool::AcquireThreadToken() {
   __sync_fetch_and_add(&num_threads_, 1);
+  __sync_fetch_and_add(&parent_->num_used_threads_, 1);
 }
 
 inline bool ThreadResourceMgr::ResourcePool::TryAcquireThreadToken() {
@@ -239,12 +282,19 @@ inline bool ThreadResourceMgr::ResourcePool::TryAcquireThreadToken() {
     int64_t new_required_threads = previous_num_threads & 0xFFFFFFFF;
     if (new_optional_threads > num_reserved_optional_threads_ &&
         new_optional_threads + new_required_threads > quota()) {
-      return false;
+      // Over our fair share; only borrow a token if some are idle system-wide.
+      // Concurrent borrowers can slightly oversubscribe the system, which is
+      // corrected by optional_exceeded().
+      if (new_optional_threads + new_required_threads > max_quota_ ||
+          parent_->num_idle_threads() == 0) {
+        return false;
+      }
     }
     int64_t new_value = new_optional_threads << 32 | new_required_threads;
     // Atomically swap the new value if no one updated num_threads_.  We do not
     // not care about the ABA problem here.
     if (__sync_bool_compare_and_swap(&num_threads_, previous_num_threads, new_value)) {
+      __sync_fetch_and_add(&parent_->num_used_threads_, 1);
       return true;
     }
   }
@@ -266,6 +316,7 @@ inline void ThreadResourceMgr::ResourcePool::ReleaseThreadToken(bool required) {
       }
     }
   }
+  int64_t num_used_threads = __sync_fetch_and_add(&parent_->num_used_threads_, -1);
 
   // We need to grab a lock before issuing the callback to prevent the
   // callback from being removed while it is happening.
@@ -279,6 +330,12 @@ inline void ThreadResourceMgr::ResourcePool::ReleaseThreadToken(bool required) {
       thread_available_fn_(this);
     }
   }
+
+  // If the released token is the only idle one, other pools may have been refused a
+  // token they can now borrow. Otherwise they could already borrow an idle token.
+  if (num_used_threads == parent_->system_threads_quota_) {
+    parent_->NotifyIdlePools(this);
+  }
 }
 
 } // namespace impala
@@ -218,6 +218,7 @@ class TimestampParser {
     while (len > 0 && isspace(str[len - 1])) --len;
     // Only process what we have to.
     if (len > DEFAULT_DATE_TIME_FMT_LEN) len = DEFAULT_DATE_TIME_FMT_LEN;
+    if (LIKELY(ParseDefaultDateTime(str, len, d, t))) return true;
     // Determine the default formatting context that's required for parsing.
     DateTimeFormatContext* dt_ctx = NULL;
     if (LIKELY(len >= DEFAULT_TIME_FMT_LEN)) {
@@ -387,6 +388,86 @@ class TimestampParser {
   }
 
  private:
+  // Fast path for the yyyy-MM-dd and yyyy-MM-dd( |T)HH:mm:ss[.SSSSSSSSS] formats. The
+  // digits and separators of the date and of the time are each validated at once as a
+  // 64-bit word, and the fields are converted without going through the format tokens.
+  // Returns false if the string is in some other format or a field is out of range, in
+  // which case the caller falls back to the token based parser.
+  static inline bool ParseDefaultDateTime(const char* str, int len,
+      boost::gregorian::date* d, boost::posix_time::time_duration* t) {
+    if (len != DEFAULT_DATE_FMT_LEN && len < DEFAULT_SHORT_DATE_TIME_FMT_LEN) {
+      return false;
+    }
+    uint64_t date_digits;
+    if (!MatchDigitLayout(str, DATE_LAYOUT, DATE_LAYOUT_SEPARATORS, &date_digits)) {
+      return false;
+    }
+    uint32_t day_tens = static_cast<uint8_t>(str[8]) - '0';
+    uint32_t day_ones = static_cast<uint8_t>(str[9]) - '0';
+    if (day_tens > 9 || day_ones > 9) return false;
+    int year = DigitAt(date_digits, 0) * 1000 + DigitAt(date_digits, 1) * 100 +
+        DigitAt(date_digits, 2) * 10 + DigitAt(date_digits, 3);
+    int month = DigitAt(date_digits, 5) * 10 + DigitAt(date_digits, 6);
+    int day = day_tens * 10 + day_ones;
+    // Boost dates start at 1400. Let the token based parser handle any errors.
+    if (year < 1400 || month < 1 || month > 12 || day < 1 ||
+        day > boost::gregorian::gregorian_calendar::end_of_month_day(year, month)) {
+      return false;
+    }
+
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int fraction = 0;
+    if (len > DEFAULT_DATE_FMT_LEN) {
+      if (str[10] != ' ' && str[10] != 'T') return false;
+      uint64_t time_digits;
+      if (!MatchDigitLayout(str + 11, TIME_LAYOUT, TIME_LAYOUT_SEPARATORS,
+          &time_digits)) {
+        return false;
+      }
+      hour = DigitAt(time_digits, 0) * 10 + DigitAt(time_digits, 1);
+      minute = DigitAt(time_digits, 3) * 10 + DigitAt(time_digits, 4);
+      second = DigitAt(time_digits, 6) * 10 + DigitAt(time_digits, 7);
+      if (hour > 23 || minute > 59 || second > 59) return false;
+      if (len > DEFAULT_SHORT_DATE_TIME_FMT_LEN) {
+        // A period followed by 1 to 9 digits.
+        if (str[19] != '.' || len == DEFAULT_SHORT_DATE_TIME_FMT_LEN + 1) return false;
+        for (int i = DEFAULT_SHORT_DATE_TIME_FMT_LEN + 1; i < len; ++i) {
+          uint32_t digit = static_cast<uint8_t>(str[i]) - '0';
+          if (digit > 9) return false;
+          fraction = fraction * 10 + digit;
+        }
+        for (int i = len - DEFAULT_SHORT_DATE_TIME_FMT_LEN - 1; i < 9; ++i) {
+          fraction *= 10;
+        }
+      }
+    }
+    *d = boost::gregorian::date(year, month, day);
+    *t = boost::posix_time::time_duration(hour, minute, second, fraction);
+    return true;
+  }
+
+  // Returns true if the 8 chars at str have digits where 'layout' has '0' and the same
+  // chars where 'separators' has 0xFF. 'layout' and 'separators' have the first char in
+  // the least significant byte. On success, the value of the digit at position i is
+  // in byte i of 'digits' (see DigitAt()).
+  static inline bool MatchDigitLayout(const char* str, uint64_t layout,
+      uint64_t separators, uint64_t* digits) {
+    uint64_t chunk;
+    memcpy(&chunk, str, sizeof(chunk));
+    // Digits become their value and matching separators become 0. Any byte that is now
+    // above 9 was not a digit.
+    *digits = chunk ^ layout;
+    return ((*digits & 0xF0F0F0F0F0F0F0F0ULL) |
+        ((*digits + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) |
+        (*digits & separators)) == 0;
+  }
+
+  static inline int DigitAt(uint64_t digits, int i) {
+    return (digits >> (8 * i)) & 0xFF;
+  }
+
   static inline bool ParseDateTime(const char* str, int str_len,
       const DateTimeFormatContext& dt_ctx, DateTimeParseResult* dt_result) {
     DCHECK(dt_ctx.fmt_len > 0);
@@ -472,6 +553,12 @@ class TimestampParser {
   static const int DEFAULT_SHORT_DATE_TIME_FMT_LEN = 19;
   static const int DEFAULT_DATE_TIME_FMT_LEN = 29;
 
+  // Layouts of "yyyy-MM-" and "HH:mm:ss" for MatchDigitLayout().
+  static const uint64_t DATE_LAYOUT = 0x2D30302D30303030ULL;
+  static const uint64_t DATE_LAYOUT_SEPARATORS = 0xFF0000FF00000000ULL;
+  static const uint64_t TIME_LAYOUT = 0x30303A30303A3030ULL;
+  static const uint64_t TIME_LAYOUT_SEPARATORS = 0x0000FF0000FF0000ULL;
+
   // Used to indicate if the parsing state has been initialized.
   static bool initialized_;
 
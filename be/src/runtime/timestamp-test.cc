@@ -377,6 +377,25 @@ TEST(TimestampTest, Basic) {
   EXPECT_EQ(bv7.date(), not_a_date);
   EXPECT_EQ(bv7.time_of_day(), not_a_date_time);
 
+  // Not a leap year.
+  char b8[] = "2013-02-29 01:10:00";
+  TimestampValue bv8(b8, strlen(b8));
+
+  EXPECT_EQ(bv8.date(), not_a_date);
+  EXPECT_EQ(bv8.time_of_day(), not_a_date_time);
+
+  char b9[] = "2013-1a-20 01:10:00";
+  TimestampValue bv9(b9, strlen(b9));
+
+  EXPECT_EQ(bv9.date(), not_a_date);
+  EXPECT_EQ(bv9.time_of_day(), not_a_date_time);
+
+  char b10[] = "2013-01-20 01:1::00";
+  TimestampValue bv10(b10, strlen(b10));
+
+  EXPECT_EQ(bv10.date(), not_a_date);
+  EXPECT_EQ(bv10.time_of_day(), not_a_date_time);
+
   // Test custom formats by generating all permutations of tokens to check parsing and
   // formatting is behaving correctly (position of tokens should be irrelevant). Note
   // that separators are also combined with EACH token permutation to get the widest
@@ -76,7 +76,14 @@ void ImpalaServer::FragmentExecState::ReportStatusCb(
   params.__set_fragment_instance_id(fragment_instance_id_);
   exec_status.SetTStatus(&params);
   params.__set_done(done);
-  profile->ToThrift(&params.profile);
+  // Intermediate reports only carry what changed since the previous report. The final
+  // report is complete, so the coordinator ends up with the full profile even if it
+  // dropped an earlier report.
+  if (done) {
+    profile->ToThrift(&params.profile);
+  } else {
+    profile->ToThriftDelta(&params.profile);
+  }
   params.__isset.profile = true;
 
   RuntimeState* runtime_state = executor_.runtime_state();
@@ -28,6 +28,13 @@ using namespace impala;
 DECLARE_int32(non_impala_java_vlog);
 
 DEFINE_bool(load_catalog_at_startup, false, "if true, load all catalog data at startup");
+DEFINE_int32(catalog_cache_max_loaded_tables, 1000, "The maximum number of tables whose "
+    "metadata the impalad keeps loaded. The least recently used tables beyond this "
+    "limit have their metadata dropped, and fetched again from the catalog service on "
+    "next use. If <= 0, there is no limit.");
+DEFINE_bool(catalog_cache_refresh_hot_tables, true, "If true, tables whose metadata is "
+    "loaded are refreshed in the background when the catalog service publishes a new "
+    "version of them, rather than on their next use.");
 
 // Authorization related flags. Must be set to valid values to properly configure
 // authorization.
@@ -61,7 +68,8 @@ struct Frontend::MethodDescriptor {
 
 Frontend::Frontend() {
   MethodDescriptor methods[] = {
-    {"<init>", "(ZLjava/lang/String;Ljava/lang/String;Ljava/lang/String;II)V", &fe_ctor_},
+    {"<init>", "(ZLjava/lang/String;Ljava/lang/String;Ljava/lang/String;IIIZ)V",
+        &fe_ctor_},
     {"createExecRequest", "([B)[B", &create_exec_request_id_},
     {"getExplainPlan", "([B)Ljava/lang/String;", &get_explain_plan_id_},
     {"getHadoopConfig", "(Z)Ljava/lang/String;", &get_hadoop_config_id_},
@@ -96,7 +104,8 @@ Frontend::Frontend() {
 
   jobject fe = jni_env->NewObject(fe_class_, fe_ctor_, lazy, server_name,
       policy_file_path, policy_provider_class_name, FlagToTLogLevel(FLAGS_v),
-      FlagToTLogLevel(FLAGS_non_impala_java_vlog));
+      FlagToTLogLevel(FLAGS_non_impala_java_vlog),
+      FLAGS_catalog_cache_max_loaded_tables, FLAGS_catalog_cache_refresh_hot_tables);
   EXIT_IF_EXC(jni_env);
   EXIT_IF_ERROR(JniUtil::LocalToGlobalRef(jni_env, fe, &fe_));
 }
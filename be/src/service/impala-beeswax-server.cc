@@ -93,6 +93,12 @@ class ImpalaServer::AsciiQueryResultSet : public ImpalaServer::QueryResultSet {
     : metadata_(metadata), result_set_(rowset) {
   }
 
+  // Rows are added into a rowset owned by this result set.
+  AsciiQueryResultSet(const TResultSetMetadata& metadata)
+    : metadata_(metadata), owned_result_set_(new vector<string>()) {
+    result_set_ = owned_result_set_.get();
+  }
+
   virtual ~AsciiQueryResultSet() {}
 
   // Convert expr values (col_values) to ASCII using "\t" as column delimiter and store
@@ -128,14 +134,40 @@ class ImpalaServer::AsciiQueryResultSet : public ImpalaServer::QueryResultSet {
     return Status::OK;
   }
 
+  virtual void AddRows(const QueryResultSet* other, int start_idx, int num_rows) {
+    const AsciiQueryResultSet* o = static_cast<const AsciiQueryResultSet*>(other);
+    DCHECK_LE(start_idx + num_rows, o->size());
+    vector<string>::const_iterator start = o->result_set_->begin() + start_idx;
+    result_set_->insert(result_set_->end(), start, start + num_rows);
+  }
+
+  virtual int size() const { return result_set_->size(); }
+
+  virtual int64_t ByteSize() const {
+    int64_t bytes = 0;
+    BOOST_FOREACH(const string& row, *result_set_) {
+      bytes += sizeof(string) + row.size();
+    }
+    return bytes;
+  }
+
  private:
   // Metadata of the result set
   const TResultSetMetadata& metadata_;
 
-  // Points to the result set to be filled. Not owned here.
+  // Points to the result set to be filled. Not owned here, unless it is
+  // owned_result_set_.
   vector<string>* result_set_;
+
+  // Set if the result set owns its rows.
+  scoped_ptr<vector<string> > owned_result_set_;
 };
 
+ImpalaServer::QueryResultSet* ImpalaServer::CreateAsciiResultSet(
+    const TResultSetMetadata& metadata) {
+  return new AsciiQueryResultSet(metadata);
+}
+
 void ImpalaServer::query(QueryHandle& query_handle, const Query& query) {
   VLOG_QUERY << "query(): query=" << query.query;
   ScopedSessionState session_handle(this);
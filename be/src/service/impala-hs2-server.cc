@@ -71,6 +71,12 @@ class ImpalaServer::TRowQueryResultSet : public ImpalaServer::QueryResultSet {
   TRowQueryResultSet(const TResultSetMetadata& metadata, TRowSet* rowset)
     : metadata_(metadata), result_set_(rowset) { }
 
+  // Rows are added into a rowset owned by this result set.
+  TRowQueryResultSet(const TResultSetMetadata& metadata)
+    : metadata_(metadata), owned_result_set_(new TRowSet()) {
+    result_set_ = owned_result_set_.get();
+  }
+
   virtual ~TRowQueryResultSet() {}
 
   // Convert expr value to HS2 TRow and store it in TRowSet.
@@ -101,14 +107,45 @@ class ImpalaServer::TRowQueryResultSet : public ImpalaServer::QueryResultSet {
     return Status::OK;
   }
 
+  virtual void AddRows(const QueryResultSet* other, int start_idx, int num_rows) {
+    const TRowQueryResultSet* o = static_cast<const TRowQueryResultSet*>(other);
+    DCHECK_LE(start_idx + num_rows, o->size());
+    vector<TRow>::const_iterator start = o->result_set_->rows.begin() + start_idx;
+    result_set_->rows.insert(result_set_->rows.end(), start, start + num_rows);
+  }
+
+  virtual int size() const { return result_set_->rows.size(); }
+
+  virtual int64_t ByteSize() const {
+    int64_t bytes = 0;
+    BOOST_FOREACH(const TRow& row, result_set_->rows) {
+      bytes += sizeof(TRow) +
+          row.colVals.size() * sizeof(apache::hive::service::cli::thrift::TColumnValue);
+      BOOST_FOREACH(const apache::hive::service::cli::thrift::TColumnValue& col_val,
+          row.colVals) {
+        if (col_val.__isset.stringVal) bytes += col_val.stringVal.value.size();
+      }
+    }
+    return bytes;
+  }
+
  private:
   // Metadata of the result set
   const TResultSetMetadata& metadata_;
 
-  // Points to the TRowSet to be filled. Not owned here.
+  // Points to the TRowSet to be filled. Not owned here, unless it is
+  // owned_result_set_.
   TRowSet* result_set_;
+
+  // Set if the result set owns its rows.
+  scoped_ptr<TRowSet> owned_result_set_;
 };
 
+ImpalaServer::QueryResultSet* ImpalaServer::CreateTRowResultSet(
+    const TResultSetMetadata& metadata) {
+  return new TRowQueryResultSet(metadata);
+}
+
 void ImpalaServer::ExecuteMetadataOp(const THandleIdentifier& session_handle,
     TMetadataOpRequest* request, TOperationHandle* handle,
     apache::hive::service::cli::thrift::TStatus* status) {
@@ -44,6 +44,7 @@
 #include "runtime/timestamp-value.h"
 #include "service/fragment-exec-state.h"
 #include "service/query-exec-state.h"
+#include "service/query-result-cache.h"
 #include "statestore/simple-scheduler.h"
 #include "util/bit-util.h"
 #include "util/cgroups-mgr.h"
@@ -80,6 +81,7 @@ DECLARE_string(nn);
 DECLARE_int32(nn_port);
 DECLARE_string(authorized_proxy_user_config);
 DECLARE_bool(abort_on_config_error);
+DECLARE_bool(enable_result_cache);
 
 DEFINE_int32(beeswax_port, 21000, "port on which Beeswax client requests are served");
 DEFINE_int32(hs2_port, 21050, "port on which HiveServer2 client requests are served");
@@ -245,6 +247,8 @@ ImpalaServer::ImpalaServer(ExecEnv* exec_env)
   ImpaladMetrics::IMPALA_SERVER_START_TIME->Update(
       TimestampValue::local_time().DebugString());
 
+  if (FLAGS_enable_result_cache) result_cache_.reset(new QueryResultCache(exec_env));
+
   // Register the membership callback if required
   if (exec_env->subscriber() != NULL) {
     StatestoreSubscriber::UpdateCallback cb =
@@ -896,6 +900,19 @@ Status ImpalaServer::SetQueryOptions(const string& key, const string& value,
         }
         break;
       }
+      case TImpalaQueryOptions::TEXT_COMPRESSION_CODEC: {
+        if (value.empty()) break;
+        if (iequals(value, "none")) {
+          query_options->__set_text_compression_codec(THdfsCompression::NONE);
+        } else if (iequals(value, "gzip")) {
+          query_options->__set_text_compression_codec(THdfsCompression::GZIP);
+        } else {
+          stringstream ss;
+          ss << "Invalid text compression codec: " << value;
+          return Status(ss.str());
+        }
+        break;
+      }
       case TImpalaQueryOptions::ABORT_ON_DEFAULT_LIMIT_EXCEEDED:
         query_options->__set_abort_on_default_limit_exceeded(
             iequals(value, "true") || iequals(value, "1"));
@@ -966,6 +983,21 @@ void ImpalaServer::ExecPlanFragment(
   StartPlanFragmentExecution(params).SetTStatus(&return_val);
 }
 
+void ImpalaServer::ExecPlanFragments(
+    TExecPlanFragmentsResult& return_val, const TExecPlanFragmentsParams& params) {
+  return_val.__isset.statuses = true;
+  BOOST_FOREACH(const TExecPlanFragmentParams& fragment_params, params.fragment_params) {
+    VLOG_QUERY << "ExecPlanFragments() instance_id="
+               << fragment_params.params.fragment_instance_id
+               << " coord=" << fragment_params.coord
+               << " backend#=" << fragment_params.backend_num;
+    return_val.statuses.push_back(TStatus());
+    Status status = StartPlanFragmentExecution(fragment_params);
+    status.ToThrift(&return_val.statuses.back());
+    if (!status.ok()) break;
+  }
+}
+
 void ImpalaServer::ReportExecStatus(
     TReportExecStatusResult& return_val, const TReportExecStatusParams& params) {
   VLOG_FILE << "ReportExecStatus() query_id=" << params.query_id
@@ -1063,7 +1095,9 @@ Status ImpalaServer::StartPlanFragmentExecution(
 
 void ImpalaServer::RunExecPlanFragment(FragmentExecState* exec_state) {
   ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS->Increment(1L);
+  ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT->Increment(1L);
   exec_state->Exec();
+  ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT->Increment(-1L);
 
   // we're done with this plan fragment
   {
@@ -1201,6 +1235,9 @@ void ImpalaServer::TQueryOptionsToMap(const TQueryOptions& query_option,
       case TImpalaQueryOptions::RESERVATION_REQUEST_TIMEOUT:
         val << query_option.reservation_request_timeout;
         break;
+      case TImpalaQueryOptions::TEXT_COMPRESSION_CODEC:
+        val << query_option.text_compression_codec;
+        break;
       default:
         // We hit this DCHECK(false) if we forgot to add the corresponding entry here
         // when we add a new query option.
@@ -1357,6 +1394,7 @@ void ImpalaServer::CatalogUpdateCallback(
       }
       ImpaladMetrics::CATALOG_READY->Update(new_catalog_version > 0);
       UpdateCatalogMetrics();
+      if (result_cache_ != NULL) result_cache_->UpdateCatalog(update_req);
       // Remove all dropped functions from the library cache.
       // TODO: is this expensive? We'd like to process heartbeats promptly.
       for (int i = 0; i < dropped_functions.size(); ++i) {
@@ -1396,6 +1434,7 @@ Status ImpalaServer::ProcessCatalogUpdateResult(
     TUpdateCatalogCacheResponse resp;
     Status status = frontend_->UpdateCatalogCache(update_req, &resp);
     if (!status.ok()) LOG(ERROR) << status.GetErrorMsg();
+    if (status.ok() && result_cache_ != NULL) result_cache_->UpdateCatalog(update_req);
     return status;
   } else {
     unique_lock<mutex> unique_lock(catalog_version_lock_);
@@ -47,6 +47,7 @@ namespace impala {
 class ExecEnv;
 class DataSink;
 class CancellationWork;
+class QueryResultCache;
 class Coordinator;
 class RowDescriptor;
 class TCatalogUpdate;
@@ -54,6 +55,8 @@ class TPlanExecRequest;
 class TPlanExecParams;
 class TExecPlanFragmentParams;
 class TExecPlanFragmentResult;
+class TExecPlanFragmentsParams;
+class TExecPlanFragmentsResult;
 class TInsertResult;
 class TReportExecStatusArgs;
 class TReportExecStatusResult;
@@ -193,6 +196,8 @@ class ImpalaServer : public ImpalaServiceIf, public ImpalaHiveServer2ServiceIf,
   // ImpalaInternalService rpcs
   virtual void ExecPlanFragment(
       TExecPlanFragmentResult& return_val, const TExecPlanFragmentParams& params);
+  virtual void ExecPlanFragments(
+      TExecPlanFragmentsResult& return_val, const TExecPlanFragmentsParams& params);
   virtual void ReportExecStatus(
       TReportExecStatusResult& return_val, const TReportExecStatusParams& params);
   virtual void CancelPlanFragment(
@@ -264,11 +269,27 @@ class ImpalaServer : public ImpalaServiceIf, public ImpalaHiveServer2ServiceIf,
     // Add the TResultRow to this result set. When a row comes from a DDL/metadata
     // operation, the row in the form of TResultRow.
     virtual Status AddOneRow(const TResultRow& row) = 0;
+
+    // Copies 'num_rows' already converted rows, starting at row 'start_idx', from
+    // 'other' into this result set. 'other' must be of the same type as this result set.
+    virtual void AddRows(const QueryResultSet* other, int start_idx, int num_rows) = 0;
+
+    // Returns the number of rows in this result set.
+    virtual int size() const = 0;
+
+    // Returns an estimate of the number of bytes used by the rows in this result set.
+    virtual int64_t ByteSize() const = 0;
   };
 
   class AsciiQueryResultSet; // extends QueryResultSet
   class TRowQueryResultSet; // extends QueryResultSet
 
+  // Return new, empty result sets that own their rows, in the format that is returned to
+  // Beeswax and HiveServer2 clients respectively. Used to convert query results before
+  // they are fetched. The caller owns the returned result set.
+  static QueryResultSet* CreateAsciiResultSet(const TResultSetMetadata& metadata);
+  static QueryResultSet* CreateTRowResultSet(const TResultSetMetadata& metadata);
+
   struct SessionState;
 
   // Execution state of a query.
@@ -653,6 +674,9 @@ class ImpalaServer : public ImpalaServiceIf, public ImpalaHiveServer2ServiceIf,
   // global, per-server state
   ExecEnv* exec_env_;  // not owned
 
+  // Cache of query results. NULL if --enable_result_cache is false.
+  boost::scoped_ptr<QueryResultCache> result_cache_;
+
   // Thread pool to process cancellation requests that come from failed Impala demons to
   // avoid blocking the statestore callback.
   boost::scoped_ptr<ThreadPool<CancellationWork> > cancellation_thread_pool_;
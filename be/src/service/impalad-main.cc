@@ -30,6 +30,7 @@
 #include "common/status.h"
 #include "runtime/coordinator.h"
 #include "runtime/exec-env.h"
+#include "runtime/row-batch.h"
 #include "util/jni-util.h"
 #include "util/network-util.h"
 #include "rpc/thrift-util.h"
@@ -58,6 +59,7 @@ DECLARE_string(principal);
 
 int main(int argc, char** argv) {
   InitCommonRuntime(argc, argv, true);
+  EXIT_IF_ERROR(RowBatch::ValidateCompressionCodecFlag());
 
   LlvmCodeGen::InitializeLlvm();
   JniUtil::InitLibhdfs();
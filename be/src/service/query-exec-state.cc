@@ -14,6 +14,7 @@
 
 #include "service/query-exec-state.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "exprs/expr.h"
@@ -36,6 +37,15 @@ DECLARE_int32(catalog_service_port);
 DECLARE_string(catalog_service_host);
 DECLARE_bool(enable_rm);
 
+DEFINE_bool(spool_query_results, false, "If true, the results of SELECT statements are "
+    "read from the coordinator fragment and converted in the background as fast as "
+    "possible, rather than only when the client fetches them. This allows queries to "
+    "complete and release their resources even if the client fetches slowly.");
+DEFINE_int64(max_spooled_result_bytes, 100L * 1024L * 1024L, "The maximum (estimated) "
+    "number of bytes of converted results that are spooled per query if "
+    "--spool_query_results is true. Once the limit is reached, no more results are read "
+    "until the client fetched some of them.");
+
 namespace impala {
 
 ImpalaServer::QueryExecState::QueryExecState(
@@ -56,11 +66,17 @@ ImpalaServer::QueryExecState::QueryExecState(
     current_batch_(NULL),
     current_batch_row_(0),
     num_rows_fetched_(0),
+    resources_released_(false),
+    spooled_batch_row_(0),
+    spooled_bytes_(0),
+    spool_done_(false),
+    spool_cancelled_(false),
     frontend_(frontend),
     parent_server_(server),
     start_time_(TimestampValue::local_time_micros()) {
   row_materialization_timer_ = ADD_TIMER(&server_profile_, "RowMaterializationTimer");
   client_wait_timer_ = ADD_TIMER(&server_profile_, "ClientFetchWaitTimer");
+  spool_full_timer_ = ADD_TIMER(&server_profile_, "ResultSpoolFullTimer");
   query_events_ = summary_profile_.AddEventSequence("Query Timeline");
   query_events_->Start();
   profile_.AddChild(&summary_profile_);
@@ -248,15 +264,39 @@ Status ImpalaServer::QueryExecState::ExecQueryOrDmlRequest(
     return Status::OK;
   }
 
+  // Queries whose results are in the result cache don't execute any fragments.
+  QueryResultCache* result_cache = parent_server_->result_cache_.get();
+  if (result_cache != NULL && result_cache->GetCacheKey(
+      query_exec_request, &result_cache_key_, &result_cache_tables_)) {
+    cached_result_ = result_cache->Lookup(result_cache_key_);
+    summary_profile_.AddInfoString("Result Cache",
+        cached_result_ == NULL ? "Miss" : "Hit");
+    if (cached_result_ != NULL) {
+      query_events_->MarkEvent("Results found in result cache");
+      return Status::OK;
+    }
+  }
+
   bool is_mini_llama = false;
   if (FLAGS_enable_rm) {
     DCHECK(exec_env_->resource_broker() != NULL);
     is_mini_llama = exec_env_->resource_broker()->is_mini_llama();
   }
-  schedule_.reset(new QuerySchedule(query_id_, query_exec_request,
-      exec_request_.query_options, is_mini_llama));
+  {
+    // Cancel() may access schedule_ while the query waits for admission.
+    lock_guard<mutex> l(lock_);
+    schedule_.reset(new QuerySchedule(query_id_, query_exec_request,
+        exec_request_.query_options, is_mini_llama));
+  }
   coord_.reset(new Coordinator(exec_env_));
   Status status = exec_env_->scheduler()->Schedule(coord_.get(), schedule_.get());
+  if (!schedule_->request_pool().empty()) {
+    // Add the admission control outcome to the query profile.
+    summary_profile_.AddInfoString("Request Pool", schedule_->request_pool());
+    summary_profile_.AddInfoString("Admission result",
+        schedule_->is_admitted() ? "Admitted" : status.GetErrorMsg());
+    if (schedule_->is_admitted()) query_events_->MarkEvent("Admitted to request pool");
+  }
   if (FLAGS_enable_rm) {
     // Add the Yarn pool and the reservation request to the query profile.
     summary_profile_.AddInfoString("Yarn Pool", schedule_->yarn_pool());
@@ -288,6 +328,20 @@ Status ImpalaServer::QueryExecState::ExecQueryOrDmlRequest(
   }
 
   profile_.AddChild(coord_->query_profile());
+
+  if (!result_cache_key_.empty()) {
+    vector<PrimitiveType> col_types;
+    BOOST_FOREACH(Expr* expr, output_exprs_) {
+      col_types.push_back(expr->type());
+    }
+    pending_cache_entry_.reset(result_cache->CreateEntry(
+        result_cache_key_, result_cache_tables_, col_types));
+  }
+
+  if (FLAGS_spool_query_results && query_exec_request.stmt_type == TStmtType::QUERY) {
+    spool_thread_.reset(new Thread("query-exec-state", "result spooler",
+        bind(&ImpalaServer::QueryExecState::SpoolResults, this)));
+  }
   return Status::OK;
 }
 
@@ -350,20 +404,26 @@ Status ImpalaServer::QueryExecState::ExecDdlRequest() {
 }
 
 void ImpalaServer::QueryExecState::Done() {
+  // The query has been cancelled at this point (if it had not finished), so the spool
+  // thread exits promptly. It may need lock_, so join it before taking lock_.
+  if (spool_thread_.get() != NULL) spool_thread_->Join();
+
   unique_lock<mutex> l(lock_);
   MarkActive();
   end_time_ = TimestampValue::local_time_micros();
   summary_profile_.AddInfoString("End Time", end_time().DebugString());
   summary_profile_.AddInfoString("Query State", PrintQueryState(query_state_));
   query_events_->MarkEvent("Unregister query");
+  ReleaseResources();
+}
 
-  if (coord_.get() != NULL) {
-    // Release any reserved resources.
-    Status status = exec_env_->scheduler()->Release(schedule_.get());
-    if (!status.ok()) {
-      LOG(WARNING) << "Failed to release resources of query " << schedule_->query_id()
-            << " because of error: " << status.GetErrorMsg();
-    }
+void ImpalaServer::QueryExecState::ReleaseResources() {
+  if (coord_.get() == NULL || resources_released_) return;
+  resources_released_ = true;
+  Status status = exec_env_->scheduler()->Release(schedule_.get());
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to release resources of query " << schedule_->query_id()
+          << " because of error: " << status.GetErrorMsg();
   }
 }
 
@@ -455,6 +515,8 @@ Status ImpalaServer::QueryExecState::FetchRowsInternal(const int32_t max_rows,
     return Status::OK;
   }
 
+  if (cached_result_ != NULL) return FetchCachedRows(max_rows, fetched_rows);
+
   // List of expr values to hold evaluated rows from the query
   vector<void*> result_row;
   result_row.resize(output_exprs_.size());
@@ -471,6 +533,8 @@ Status ImpalaServer::QueryExecState::FetchRowsInternal(const int32_t max_rows,
     return fetched_rows->AddOneRow(result_row, scales);
   }
 
+  if (spool_thread_.get() != NULL) return FetchSpooledRows(max_rows, fetched_rows);
+
   // query with a FROM clause
   lock_.unlock();
   Status status = coord_->Wait();
@@ -485,7 +549,10 @@ Status ImpalaServer::QueryExecState::FetchRowsInternal(const int32_t max_rows,
   if (current_batch_ == NULL || current_batch_row_ >= current_batch_->num_rows()) {
     RETURN_IF_ERROR(FetchNextBatch());
   }
-  if (current_batch_ == NULL) return Status::OK;
+  if (current_batch_ == NULL) {
+    if (eos_) AddResultsToCache();
+    return Status::OK;
+  }
 
   {
     SCOPED_TIMER(row_materialization_timer_);
@@ -494,17 +561,168 @@ Status ImpalaServer::QueryExecState::FetchRowsInternal(const int32_t max_rows,
     int fetched_count = available;
     // max_rows <= 0 means no limit
     if (max_rows > 0 && max_rows < available) fetched_count = max_rows;
+    Expr::EvaluateBatch(output_exprs_, current_batch_, current_batch_row_,
+        fetched_count);
+    Status status;
     for (int i = 0; i < fetched_count; ++i) {
       TupleRow* row = current_batch_->GetRow(current_batch_row_);
-      RETURN_IF_ERROR(GetRowValue(row, &result_row, &scales));
-      RETURN_IF_ERROR(fetched_rows->AddOneRow(result_row, scales));
+      status = GetRowValue(row, &result_row, &scales);
+      if (!status.ok()) break;
+      status = fetched_rows->AddOneRow(result_row, scales);
+      if (!status.ok()) break;
+      if (pending_cache_entry_ != NULL &&
+          !pending_cache_entry_->AddRow(result_row, scales)) {
+        // Too big to be cached.
+        pending_cache_entry_.reset();
+      }
       ++num_rows_fetched_;
       ++current_batch_row_;
     }
+    Expr::ClearBatch(output_exprs_);
+    RETURN_IF_ERROR(status);
+  }
+  return Status::OK;
+}
+
+Status ImpalaServer::QueryExecState::FetchCachedRows(const int32_t max_rows,
+    QueryResultSet* fetched_rows) {
+  query_state_ = QueryState::FINISHED;
+  int64_t num_rows = cached_result_->num_rows() - num_rows_fetched_;
+  // max_rows <= 0 means no limit
+  if (max_rows > 0 && max_rows < num_rows) num_rows = max_rows;
+  {
+    SCOPED_TIMER(row_materialization_timer_);
+    RETURN_IF_ERROR(cached_result_->GetRows(num_rows_fetched_, num_rows, fetched_rows));
   }
+  num_rows_fetched_ += num_rows;
+  eos_ = (num_rows_fetched_ == cached_result_->num_rows());
   return Status::OK;
 }
 
+Status ImpalaServer::QueryExecState::FetchSpooledRows(const int32_t max_rows,
+    QueryResultSet* fetched_rows) {
+  // Temporarily release lock so calls to Cancel() are not blocked while waiting for
+  // results. fetch_rows_lock_ ensures there is only one fetch at a time.
+  lock_.unlock();
+  int num_rows = 0;
+  bool eos = false;
+  Status status;
+  {
+    unique_lock<mutex> l(spool_lock_);
+    while (spooled_results_.empty() && !spool_done_) spool_results_cv_.wait(l);
+    // Report errors right away, even if there are spooled rows left.
+    if (spool_done_ && !spool_status_.ok()) {
+      status = spool_status_;
+    } else {
+      // max_rows <= 0 means no limit
+      while (!spooled_results_.empty() && (max_rows <= 0 || num_rows < max_rows)) {
+        const SpooledBatch& batch = spooled_results_.front();
+        int batch_rows = batch.first->size() - spooled_batch_row_;
+        if (max_rows > 0) batch_rows = min(batch_rows, max_rows - num_rows);
+        fetched_rows->AddRows(batch.first.get(), spooled_batch_row_, batch_rows);
+        num_rows += batch_rows;
+        spooled_batch_row_ += batch_rows;
+        if (spooled_batch_row_ == batch.first->size()) {
+          spooled_bytes_ -= batch.second;
+          spooled_results_.pop_front();
+          spooled_batch_row_ = 0;
+          spool_space_cv_.notify_one();
+        }
+      }
+      eos = spooled_results_.empty() && spool_done_;
+    }
+  }
+  lock_.lock();
+  if (!status.ok()) return status;
+
+  // Check if query_state_ changed while waiting for results
+  if (query_state_ == QueryState::EXCEPTION) return query_status_;
+
+  query_state_ = QueryState::FINISHED;
+  num_rows_fetched_ += num_rows;
+  eos_ = eos;
+  return Status::OK;
+}
+
+void ImpalaServer::QueryExecState::SpoolResults() {
+  Status status = coord_->Wait();
+  while (status.ok()) {
+    RowBatch* batch;
+    status = coord_->GetNext(&batch, coord_->runtime_state());
+    if (!status.ok() || batch == NULL) break;
+    shared_ptr<QueryResultSet> result_set(
+        session_type() == TSessionType::HIVESERVER2 ?
+        CreateTRowResultSet(result_metadata_) : CreateAsciiResultSet(result_metadata_));
+    status = ConvertRowBatch(batch, result_set.get());
+    if (!status.ok() || result_set->size() == 0) continue;
+
+    int64_t bytes = result_set->ByteSize();
+    unique_lock<mutex> l(spool_lock_);
+    // Always accept a batch if the spool is empty, so batches larger than the limit
+    // don't block forever.
+    while (!spooled_results_.empty() && !spool_cancelled_ &&
+        spooled_bytes_ + bytes > FLAGS_max_spooled_result_bytes) {
+      SCOPED_TIMER(spool_full_timer_);
+      spool_space_cv_.wait(l);
+    }
+    if (spool_cancelled_) {
+      status = Status::CANCELLED;
+      break;
+    }
+    spooled_results_.push_back(make_pair(result_set, bytes));
+    spooled_bytes_ += bytes;
+    spool_results_cv_.notify_one();
+  }
+
+  {
+    lock_guard<mutex> l(spool_lock_);
+    spool_done_ = true;
+    spool_status_ = status;
+    spool_results_cv_.notify_all();
+  }
+
+  if (!status.ok()) return;
+  // All results have been read and the coordinator is done; the query does not need to
+  // hold on to its resources until the client has fetched all rows.
+  lock_guard<mutex> l(lock_);
+  query_events_->MarkEvent("All results spooled");
+  AddResultsToCache();
+  ReleaseResources();
+}
+
+Status ImpalaServer::QueryExecState::ConvertRowBatch(RowBatch* batch,
+    QueryResultSet* result_set) {
+  SCOPED_TIMER(row_materialization_timer_);
+  vector<void*> result_row(output_exprs_.size());
+  vector<int> scales(output_exprs_.size());
+  Expr::EvaluateBatch(output_exprs_, batch, 0, batch->num_rows());
+  Status status;
+  for (int i = 0; i < batch->num_rows(); ++i) {
+    status = GetRowValue(batch->GetRow(i), &result_row, &scales);
+    if (!status.ok()) break;
+    status = result_set->AddOneRow(result_row, scales);
+    if (!status.ok()) break;
+    if (pending_cache_entry_ != NULL &&
+        !pending_cache_entry_->AddRow(result_row, scales)) {
+      pending_cache_entry_.reset();
+    }
+  }
+  Expr::ClearBatch(output_exprs_);
+  return status;
+}
+
+void ImpalaServer::QueryExecState::AddResultsToCache() {
+  if (pending_cache_entry_ == NULL) return;
+  // Don't cache results that came with errors or warnings; they would not be
+  // reported to later clients.
+  if (!query_status_.ok() || !coord_->GetErrorLog().empty()) {
+    pending_cache_entry_.reset();
+    return;
+  }
+  parent_server_->result_cache_->Insert(pending_cache_entry_.release());
+  query_events_->MarkEvent("Results added to result cache");
+}
+
 Status ImpalaServer::QueryExecState::GetRowValue(TupleRow* row, vector<void*>* result,
                                                  vector<int>* scales) {
   DCHECK(result->size() >= output_exprs_.size());
@@ -521,6 +739,15 @@ void ImpalaServer::QueryExecState::Cancel(const Status* cause) {
     child_query.Cancel();
   }
 
+  if (spool_thread_.get() != NULL) {
+    lock_guard<mutex> l(spool_lock_);
+    spool_cancelled_ = true;
+    spool_space_cv_.notify_all();
+  }
+
+  // Remove the query from its request pool queue if it has not been admitted yet.
+  if (schedule_.get() != NULL) exec_env_->scheduler()->Cancel(schedule_.get());
+
   // If the query is completed, no need to cancel.
   if (eos_) return;
   // we don't want multiple concurrent cancel calls to end up executing
@@ -20,6 +20,7 @@
 #include "util/runtime-profile.h"
 #include "runtime/timestamp-value.h"
 #include "service/child-query.h"
+#include "service/query-result-cache.h"
 #include "statestore/query-schedule.h"
 #include "gen-cpp/Frontend_types.h"
 #include "service/impala-server.h"
@@ -27,6 +28,7 @@
 
 #include <boost/thread.hpp>
 #include <boost/unordered_set.hpp>
+#include <list>
 #include <vector>
 
 namespace impala {
@@ -229,6 +231,61 @@ class ImpalaServer::QueryExecState {
   int current_batch_row_; // number of rows fetched within the current batch
   int num_rows_fetched_; // number of rows fetched by client for the entire query
 
+  // Result cache key and the tables read by this query. The key is empty if the
+  // result cache is disabled or the query's results cannot be cached.
+  std::string result_cache_key_;
+  std::vector<std::string> result_cache_tables_;
+
+  // Set if the results of this query are returned from the result cache, in which
+  // case no fragments are executed.
+  boost::shared_ptr<const QueryResultCache::Entry> cached_result_;
+
+  // Collects the rows returned to the client so they can be added to the result cache
+  // once all rows were fetched. NULL if the results are not cached.
+  boost::scoped_ptr<QueryResultCache::Entry> pending_cache_entry_;
+
+  // True once the query's resources have been released with the scheduler.
+  bool resources_released_;
+
+  // If --spool_query_results is set, the results of SELECT statements are read from the
+  // coordinator and converted into the client's result format by spool_thread_ as fast
+  // as possible, independently of the client's fetch rate. Fetches are served from
+  // spooled_results_, which holds at most --max_spooled_result_bytes (plus one batch).
+  // NULL if results are not spooled, in which case fetches read directly from coord_.
+  boost::scoped_ptr<Thread> spool_thread_;
+
+  // Protects the following spooling state. Must not be acquired before lock_, i.e. lock_
+  // may not be taken while holding spool_lock_.
+  boost::mutex spool_lock_;
+
+  // Signalled when a converted batch is added to spooled_results_ or spooling is done.
+  boost::condition_variable spool_results_cv_;
+
+  // Signalled when spooled_results_ shrinks or spooling is cancelled.
+  boost::condition_variable spool_space_cv_;
+
+  // Converted batches not yet (completely) returned to the client. Each batch is stored
+  // with its estimated size in bytes.
+  typedef std::pair<boost::shared_ptr<QueryResultSet>, int64_t> SpooledBatch;
+  std::list<SpooledBatch> spooled_results_;
+
+  // Index of the first row of spooled_results_.front() not yet returned.
+  int spooled_batch_row_;
+
+  // Total estimated size of spooled_results_.
+  int64_t spooled_bytes_;
+
+  // Set by spool_thread_ once it read all results or hit an error, and the status
+  // it finished with.
+  bool spool_done_;
+  Status spool_status_;
+
+  // Set by Cancel() to stop spool_thread_.
+  bool spool_cancelled_;
+
+  // Time spool_thread_ waited for the client to fetch results.
+  RuntimeProfile::Counter* spool_full_timer_;
+
   // To get access to UpdateCatalog, LOAD, and DDL methods. Not owned.
   Frontend* frontend_;
 
@@ -291,6 +348,28 @@ class ImpalaServer::QueryExecState {
   // result and scales must have been resized to the number of columns before call.
   Status GetRowValue(TupleRow* row, std::vector<void*>* result, std::vector<int>* scales);
 
+  // Returns rows from cached_result_ in the same way as FetchRowsInternal().
+  Status FetchCachedRows(const int32_t max_rows, QueryResultSet* fetched_rows);
+
+  // Returns rows from spooled_results_ in the same way as FetchRowsInternal(). Blocks
+  // until some rows are spooled, during which time lock_ is released.
+  Status FetchSpooledRows(const int32_t max_rows, QueryResultSet* fetched_rows);
+
+  // Body of spool_thread_: reads all batches from coord_, converts them and adds them to
+  // spooled_results_. Releases the query's resources once all results have been read.
+  void SpoolResults();
+
+  // Converts all rows of 'batch' and adds them to 'result_set'.
+  Status ConvertRowBatch(RowBatch* batch, QueryResultSet* result_set);
+
+  // Releases the resources reserved for this query with the scheduler, unless that
+  // was already done. Caller needs to hold lock_.
+  void ReleaseResources();
+
+  // Adds pending_cache_entry_ to the result cache if the query completed without
+  // errors. Called when all rows have been fetched.
+  void AddResultsToCache();
+
   // Gather and publish all required updates to the metastore
   Status UpdateCatalog();
 
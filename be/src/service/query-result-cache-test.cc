@@ -0,0 +1,272 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "common/init.h"
+#include "runtime/string-value.h"
+#include "service/query-result-cache.h"
+
+using namespace boost;
+using namespace impala;
+using namespace std;
+
+DECLARE_int64(result_cache_size);
+DECLARE_int64(result_cache_max_entry_bytes);
+DECLARE_int64(result_cache_max_entry_rows);
+
+namespace impala {
+
+// Collects the rows returned by QueryResultCache::Entry::GetRows().
+class TestResultSet {
+ public:
+  Status AddOneRow(const vector<void*>& row, const vector<int>& scales) {
+    int_values.push_back(*reinterpret_cast<int32_t*>(row[0]));
+    const StringValue* sv = reinterpret_cast<const StringValue*>(row[1]);
+    string_values.push_back(sv == NULL ? "NULL" : sv->DebugString());
+    return Status::OK;
+  }
+
+  vector<int32_t> int_values;
+  vector<string> string_values;
+};
+
+class QueryResultCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FLAGS_result_cache_size = 256L * 1024L * 1024L;
+    FLAGS_result_cache_max_entry_bytes = 16L * 1024L * 1024L;
+    FLAGS_result_cache_max_entry_rows = 100000;
+    cache_.reset(new QueryResultCache(NULL));
+    col_types_.push_back(TYPE_INT);
+    col_types_.push_back(TYPE_STRING);
+  }
+
+  // Returns a query that scans db.tbl with the given limit.
+  TQueryExecRequest MakeRequest(const string& db, const string& tbl, int64_t limit) {
+    TQueryExecRequest request;
+    request.__set_stmt_type(TStmtType::QUERY);
+    TPlanNode node;
+    node.node_id = 0;
+    node.node_type = TPlanNodeType::HDFS_SCAN_NODE;
+    node.limit = limit;
+    TPlanFragment fragment;
+    fragment.__isset.plan = true;
+    fragment.plan.nodes.push_back(node);
+    request.fragments.push_back(fragment);
+    TTableDescriptor table;
+    table.id = 0;
+    table.tableType = TTableType::HDFS_TABLE;
+    table.tableName = tbl;
+    table.dbName = db;
+    request.__isset.desc_tbl = true;
+    request.desc_tbl.tableDescriptors.push_back(table);
+    return request;
+  }
+
+  // Returns a catalog update that sets the version of db.tbl, or removes the table if
+  // 'removed' is true.
+  TUpdateCatalogCacheRequest MakeUpdate(const string& db, const string& tbl,
+      int64_t version, bool removed = false) {
+    TCatalogObject object;
+    object.type = TCatalogObjectType::TABLE;
+    object.catalog_version = version;
+    object.__isset.table = true;
+    object.table.db_name = db;
+    object.table.tbl_name = tbl;
+    TUpdateCatalogCacheRequest update;
+    update.is_delta = true;
+    if (removed) {
+      update.removed_objects.push_back(object);
+    } else {
+      update.updated_objects.push_back(object);
+    }
+    return update;
+  }
+
+  // Creates an entry for 'request' with 'num_rows' rows. Returns NULL if the request
+  // cannot be cached or the rows do not fit into an entry.
+  QueryResultCache::Entry* MakeEntry(const TQueryExecRequest& request, int num_rows,
+      string* key) {
+    vector<string> tables;
+    if (!cache_->GetCacheKey(request, key, &tables)) return NULL;
+    QueryResultCache::Entry* entry = cache_->CreateEntry(*key, tables, col_types_);
+    string str = "a string value";
+    StringValue sv(const_cast<char*>(str.data()), str.size());
+    vector<int> scales(2, 0);
+    for (int32_t i = 0; i < num_rows; ++i) {
+      vector<void*> row;
+      row.push_back(&i);
+      row.push_back(i % 2 == 0 ? &sv : NULL);
+      if (!entry->AddRow(row, scales)) {
+        delete entry;
+        return NULL;
+      }
+    }
+    return entry;
+  }
+
+  scoped_ptr<QueryResultCache> cache_;
+  vector<PrimitiveType> col_types_;
+};
+
+TEST_F(QueryResultCacheTest, CacheKey) {
+  string key1, key2;
+  vector<string> tables;
+  EXPECT_TRUE(cache_->GetCacheKey(MakeRequest("db", "t", 10), &key1, &tables));
+  ASSERT_EQ(1, tables.size());
+  EXPECT_EQ("db.t", tables[0]);
+  // Two zero-padded 16 digit hashes, followed by the version of the table.
+  EXPECT_EQ(32 + 3, key1.size());
+  EXPECT_EQ(":-1", key1.substr(32));
+  EXPECT_TRUE(cache_->GetCacheKey(MakeRequest("db", "t", 10), &key2, &tables));
+  EXPECT_EQ(key1, key2);
+  EXPECT_TRUE(cache_->GetCacheKey(MakeRequest("db", "t", 20), &key2, &tables));
+  EXPECT_NE(key1, key2);
+
+  // The key changes with the version of the table.
+  cache_->UpdateCatalog(MakeUpdate("db", "t", 5));
+  EXPECT_TRUE(cache_->GetCacheKey(MakeRequest("db", "t", 10), &key2, &tables));
+  EXPECT_EQ(key1.substr(0, 32) + ":5", key2);
+
+  // DML statements and HBase scans are not cached.
+  TQueryExecRequest request = MakeRequest("db", "t", 10);
+  request.stmt_type = TStmtType::DML;
+  EXPECT_FALSE(cache_->GetCacheKey(request, &key1, &tables));
+  request = MakeRequest("db", "t", 10);
+  request.fragments[0].plan.nodes[0].node_type = TPlanNodeType::HBASE_SCAN_NODE;
+  EXPECT_FALSE(cache_->GetCacheKey(request, &key1, &tables));
+}
+
+TEST_F(QueryResultCacheTest, HitAndMiss) {
+  string key;
+  QueryResultCache::Entry* entry = MakeEntry(MakeRequest("db", "t", 10), 10, &key);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_TRUE(cache_->Lookup(key) == NULL);
+  cache_->Insert(entry);
+
+  shared_ptr<const QueryResultCache::Entry> result = cache_->Lookup(key);
+  ASSERT_TRUE(result != NULL);
+  EXPECT_EQ(10, result->num_rows());
+  TestResultSet result_set;
+  EXPECT_TRUE(result->GetRows(2, 3, &result_set).ok());
+  ASSERT_EQ(3, result_set.int_values.size());
+  EXPECT_EQ(2, result_set.int_values[0]);
+  EXPECT_EQ(4, result_set.int_values[2]);
+  EXPECT_EQ("a string value", result_set.string_values[0]);
+  EXPECT_EQ("NULL", result_set.string_values[1]);
+
+  // A different query misses.
+  string other_key;
+  vector<string> tables;
+  EXPECT_TRUE(cache_->GetCacheKey(MakeRequest("db", "t", 20), &other_key, &tables));
+  EXPECT_TRUE(cache_->Lookup(other_key) == NULL);
+}
+
+TEST_F(QueryResultCacheTest, Invalidation) {
+  string key1, key2;
+  cache_->Insert(MakeEntry(MakeRequest("db", "t1", 10), 10, &key1));
+  cache_->Insert(MakeEntry(MakeRequest("db", "t2", 10), 10, &key2));
+  EXPECT_TRUE(cache_->Lookup(key1) != NULL);
+  EXPECT_TRUE(cache_->Lookup(key2) != NULL);
+
+  // A new version of t1 only invalidates the entry of t1.
+  cache_->UpdateCatalog(MakeUpdate("db", "t1", 2));
+  EXPECT_TRUE(cache_->Lookup(key1) == NULL);
+  EXPECT_TRUE(cache_->Lookup(key2) != NULL);
+
+  // Dropping t2 invalidates its entry.
+  cache_->UpdateCatalog(MakeUpdate("db", "t2", 3, true));
+  EXPECT_TRUE(cache_->Lookup(key2) == NULL);
+
+  // An entry whose table changed while the query ran is not inserted.
+  QueryResultCache::Entry* entry = MakeEntry(MakeRequest("db", "t1", 10), 10, &key1);
+  ASSERT_TRUE(entry != NULL);
+  cache_->UpdateCatalog(MakeUpdate("db", "t1", 4));
+  cache_->Insert(entry);
+  EXPECT_TRUE(cache_->Lookup(key1) == NULL);
+
+  // A full catalog update clears the cache.
+  cache_->Insert(MakeEntry(MakeRequest("db", "t1", 10), 10, &key1));
+  EXPECT_TRUE(cache_->Lookup(key1) != NULL);
+  TUpdateCatalogCacheRequest update;
+  update.is_delta = false;
+  cache_->UpdateCatalog(update);
+  EXPECT_TRUE(cache_->Lookup(key1) == NULL);
+}
+
+TEST_F(QueryResultCacheTest, Eviction) {
+  string key1, key2, key3;
+  QueryResultCache::Entry* entry1 = MakeEntry(MakeRequest("db", "t", 1), 10, &key1);
+  ASSERT_TRUE(entry1 != NULL);
+  // Room for two entries of the same size.
+  FLAGS_result_cache_size = 2 * entry1->num_bytes();
+  cache_->Insert(entry1);
+  cache_->Insert(MakeEntry(MakeRequest("db", "t", 2), 10, &key2));
+  EXPECT_TRUE(cache_->Lookup(key2) != NULL);
+  // Entry 1 is now the most recently used one, so entry 2 is evicted.
+  EXPECT_TRUE(cache_->Lookup(key1) != NULL);
+  cache_->Insert(MakeEntry(MakeRequest("db", "t", 3), 10, &key3));
+  EXPECT_TRUE(cache_->Lookup(key1) != NULL);
+  EXPECT_TRUE(cache_->Lookup(key2) == NULL);
+  EXPECT_TRUE(cache_->Lookup(key3) != NULL);
+
+  // An entry larger than the whole cache is not inserted and evicts nothing.
+  QueryResultCache::Entry* large_entry =
+      MakeEntry(MakeRequest("db", "t", 4), 10000, &key2);
+  ASSERT_TRUE(large_entry != NULL);
+  ASSERT_GT(large_entry->num_bytes(), FLAGS_result_cache_size);
+  cache_->Insert(large_entry);
+  EXPECT_TRUE(cache_->Lookup(key2) == NULL);
+  EXPECT_TRUE(cache_->Lookup(key1) != NULL);
+  EXPECT_TRUE(cache_->Lookup(key3) != NULL);
+}
+
+TEST_F(QueryResultCacheTest, MemoryLimits) {
+  string key;
+  // Entries over the row or byte limit are rejected while they are populated.
+  FLAGS_result_cache_max_entry_rows = 5;
+  EXPECT_TRUE(MakeEntry(MakeRequest("db", "t", 1), 6, &key) == NULL);
+  QueryResultCache::Entry* entry = MakeEntry(MakeRequest("db", "t", 1), 5, &key);
+  EXPECT_TRUE(entry != NULL);
+  delete entry;
+  FLAGS_result_cache_max_entry_rows = 100000;
+  FLAGS_result_cache_max_entry_bytes = 64 * 1024;
+  EXPECT_TRUE(MakeEntry(MakeRequest("db", "t", 1), 10000, &key) == NULL);
+
+  // All memory is tracked, and released when the entries are freed.
+  EXPECT_EQ(0, cache_->mem_tracker()->consumption());
+  entry = MakeEntry(MakeRequest("db", "t", 1), 100, &key);
+  ASSERT_TRUE(entry != NULL);
+  EXPECT_EQ(entry->num_bytes(), cache_->mem_tracker()->consumption());
+  cache_->Insert(entry);
+  {
+    // Entries that are being returned to a client stay alive after they are removed.
+    shared_ptr<const QueryResultCache::Entry> result = cache_->Lookup(key);
+    cache_->Clear();
+    EXPECT_GT(cache_->mem_tracker()->consumption(), 0);
+    EXPECT_EQ(100, result->num_rows());
+  }
+  EXPECT_EQ(0, cache_->mem_tracker()->consumption());
+}
+
+}
+
+int main(int argc, char** argv) {
+  InitCommonRuntime(argc, argv, false);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,454 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "service/query-result-cache.h"
+
+#include <iomanip>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/foreach.hpp>
+#include <gflags/gflags.h>
+
+#include "common/logging.h"
+#include "rpc/thrift-util.h"
+#include "runtime/exec-env.h"
+#include "runtime/raw-value.h"
+#include "util/hash-util.h"
+#include "util/impalad-metrics.h"
+
+#include "gen-cpp/Exprs_types.h"
+#include "gen-cpp/Opcodes_types.h"
+
+using namespace boost;
+using namespace boost::algorithm;
+using namespace std;
+
+DEFINE_bool(enable_result_cache, false, "If true, the results of SELECT statements are "
+    "cached and repeated executions of the same query over unchanged tables are answered "
+    "from the cache.");
+DEFINE_int64(result_cache_size, 256L * 1024L * 1024L, "Maximum number of bytes used by "
+    "the query result cache.");
+DEFINE_int64(result_cache_max_entry_bytes, 16L * 1024L * 1024L, "Results larger than "
+    "this many bytes are not added to the query result cache.");
+DEFINE_int64(result_cache_max_entry_rows, 100000, "Results with more than this many rows "
+    "are not added to the query result cache.");
+
+namespace impala {
+
+// Seeds of the two hashes that make up the plan fingerprint.
+static const uint64_t FINGERPRINT_SEED1 = HashUtil::FNV64_SEED;
+static const uint64_t FINGERPRINT_SEED2 = 0x9E3779B97F4A7C15UL;
+
+// Builtins whose result is not a function of their arguments.
+static bool IsNonDeterministicOpcode(TExprOpcode::type opcode) {
+  switch (opcode) {
+    case TExprOpcode::MATH_RAND:
+    case TExprOpcode::MATH_RAND_INT:
+    case TExprOpcode::TIMESTAMP_NOW:
+    case TExprOpcode::UNIX_TIMESTAMP:
+    case TExprOpcode::UTILITY_USER:
+    case TExprOpcode::UTILITY_PID:
+    case TExprOpcode::UTILITY_CURRENT_DATABASE:
+    case TExprOpcode::UTILITY_SLEEP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool IsCacheable(const TExpr& expr) {
+  BOOST_FOREACH(const TExprNode& node, expr.nodes) {
+    if (node.__isset.opcode && IsNonDeterministicOpcode(node.opcode)) return false;
+    // We don't know whether UDFs are deterministic.
+    if (node.__isset.fn_call_expr &&
+        node.fn_call_expr.fn.binary_type != TFunctionBinaryType::BUILTIN) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool IsCacheable(const vector<TExpr>& exprs) {
+  BOOST_FOREACH(const TExpr& expr, exprs) {
+    if (!IsCacheable(expr)) return false;
+  }
+  return true;
+}
+
+static bool IsCacheable(const TPlanNode& node) {
+  switch (node.node_type) {
+    case TPlanNodeType::HDFS_SCAN_NODE:
+    case TPlanNodeType::HASH_JOIN_NODE:
+    case TPlanNodeType::CROSS_JOIN_NODE:
+    case TPlanNodeType::AGGREGATION_NODE:
+    case TPlanNodeType::SORT_NODE:
+    case TPlanNodeType::EXCHANGE_NODE:
+    case TPlanNodeType::MERGE_NODE:
+    case TPlanNodeType::SELECT_NODE:
+      break;
+    default:
+      // HBase tables can change without a catalog update.
+      return false;
+  }
+  if (!IsCacheable(node.conjuncts)) return false;
+  if (node.__isset.hash_join_node) {
+    BOOST_FOREACH(const TEqJoinCondition& cond, node.hash_join_node.eq_join_conjuncts) {
+      if (!IsCacheable(cond.left) || !IsCacheable(cond.right)) return false;
+    }
+    if (!IsCacheable(node.hash_join_node.other_join_conjuncts)) return false;
+  }
+  if (node.__isset.agg_node) {
+    if (!IsCacheable(node.agg_node.grouping_exprs)) return false;
+    BOOST_FOREACH(const TAggregateFunctionCall& fn, node.agg_node.aggregate_functions) {
+      if (fn.fn.binary_type != TFunctionBinaryType::BUILTIN) return false;
+      if (!IsCacheable(fn.input_exprs)) return false;
+    }
+  }
+  if (node.__isset.sort_node && !IsCacheable(node.sort_node.ordering_exprs)) {
+    return false;
+  }
+  if (node.__isset.merge_node) {
+    BOOST_FOREACH(const vector<TExpr>& exprs, node.merge_node.result_expr_lists) {
+      if (!IsCacheable(exprs)) return false;
+    }
+    BOOST_FOREACH(const vector<TExpr>& exprs, node.merge_node.const_expr_lists) {
+      if (!IsCacheable(exprs)) return false;
+    }
+  }
+  return true;
+}
+
+static bool IsCacheable(const TPlanFragment& fragment) {
+  if (!IsCacheable(fragment.output_exprs)) return false;
+  if (!IsCacheable(fragment.partition.partition_exprs)) return false;
+  if (fragment.__isset.output_sink) {
+    if (fragment.output_sink.type != TDataSinkType::DATA_STREAM_SINK) return false;
+    if (!IsCacheable(
+        fragment.output_sink.stream_sink.output_partition.partition_exprs)) {
+      return false;
+    }
+  }
+  if (fragment.__isset.plan) {
+    BOOST_FOREACH(const TPlanNode& node, fragment.plan.nodes) {
+      if (!IsCacheable(node)) return false;
+    }
+  }
+  return true;
+}
+
+// Returns the query options that can change the result of a query.
+static TQueryOptions GetResultQueryOptions(const TQueryOptions& options) {
+  TQueryOptions result;
+  result.__set_abort_on_error(options.abort_on_error);
+  result.__set_max_errors(options.max_errors);
+  result.__set_num_nodes(options.num_nodes);
+  result.__set_allow_unsupported_formats(options.allow_unsupported_formats);
+  result.__set_default_order_by_limit(options.default_order_by_limit);
+  result.__set_debug_action(options.debug_action);
+  result.__set_abort_on_default_limit_exceeded(options.abort_on_default_limit_exceeded);
+  return result;
+}
+
+// Adds the serialized 'obj' to the two fingerprint hashes.
+template <class T>
+static Status UpdateFingerprint(ThriftSerializer* serializer, const T& obj,
+    uint64_t* hash1, uint64_t* hash2) {
+  uint32_t len = 0;
+  uint8_t* buffer = NULL;
+  RETURN_IF_ERROR(serializer->Serialize(const_cast<T*>(&obj), &len, &buffer));
+  *hash1 = HashUtil::FnvHash64(buffer, len, *hash1);
+  *hash2 = HashUtil::FnvHash64(buffer, len, *hash2);
+  *hash1 = HashUtil::FnvHash64(&len, sizeof(len), *hash1);
+  return Status::OK;
+}
+
+QueryResultCache::Entry::Entry(const string& key, const vector<string>& tables,
+    const vector<PrimitiveType>& col_types, MemTracker* mem_tracker)
+  : key_(key),
+    tables_(tables),
+    col_types_(col_types),
+    pool_(mem_tracker) {
+}
+
+QueryResultCache::Entry::~Entry() {
+  pool_.FreeAll();
+}
+
+bool QueryResultCache::Entry::AddRow(const vector<void*>& row,
+    const vector<int>& scales) {
+  DCHECK_EQ(row.size(), col_types_.size());
+  if (num_rows() >= FLAGS_result_cache_max_entry_rows) return false;
+  if (scales_.empty()) scales_ = scales;
+
+  void** values = reinterpret_cast<void**>(
+      pool_.TryAllocate(sizeof(void*) * col_types_.size()));
+  if (values == NULL) return false;
+  for (int i = 0; i < col_types_.size(); ++i) {
+    if (row[i] == NULL) {
+      values[i] = NULL;
+      continue;
+    }
+    ColumnType type(col_types_[i]);
+    values[i] = pool_.TryAllocate(GetSlotSize(type.type));
+    if (values[i] == NULL) return false;
+    if (type.type == TYPE_STRING) {
+      // Copy the string data with TryAllocate() to respect the memory limits.
+      const StringValue* src = reinterpret_cast<const StringValue*>(row[i]);
+      StringValue* dst = reinterpret_cast<StringValue*>(values[i]);
+      dst->len = src->len;
+      dst->ptr = NULL;
+      if (src->len > 0) {
+        dst->ptr = reinterpret_cast<char*>(pool_.TryAllocate(src->len));
+        if (dst->ptr == NULL) return false;
+        memcpy(dst->ptr, src->ptr, src->len);
+      }
+    } else {
+      RawValue::Write(row[i], values[i], type, NULL);
+    }
+  }
+  rows_.push_back(values);
+  return num_bytes() <= FLAGS_result_cache_max_entry_bytes;
+}
+
+QueryResultCache::QueryResultCache(ExecEnv* exec_env)
+  : exec_env_(exec_env),
+    num_bytes_(0) {
+}
+
+QueryResultCache::~QueryResultCache() {
+  Clear();
+  if (mem_tracker_.get() != NULL && mem_tracker_->parent() != NULL) {
+    mem_tracker_->UnregisterFromParent();
+  }
+}
+
+MemTracker* QueryResultCache::mem_tracker() {
+  lock_guard<mutex> l(mem_tracker_lock_);
+  if (mem_tracker_.get() == NULL) {
+    MemTracker* process_tracker = NULL;
+    if (exec_env_ != NULL) {
+      process_tracker = exec_env_->process_mem_tracker();
+      DCHECK(process_tracker != NULL);
+    }
+    mem_tracker_.reset(new MemTracker(-1, "Query Result Cache", process_tracker));
+  }
+  return mem_tracker_.get();
+}
+
+bool QueryResultCache::GetCacheKey(const TQueryExecRequest& request, string* key,
+    vector<string>* tables) {
+  if (request.stmt_type != TStmtType::QUERY) return false;
+  BOOST_FOREACH(const TPlanFragment& fragment, request.fragments) {
+    if (!IsCacheable(fragment)) return false;
+  }
+
+  tables->clear();
+  if (request.__isset.desc_tbl) {
+    BOOST_FOREACH(const TTableDescriptor& table, request.desc_tbl.tableDescriptors) {
+      if (table.tableType != TTableType::HDFS_TABLE) return false;
+      tables->push_back(to_lower_copy(table.dbName + "." + table.tableName));
+    }
+  }
+
+  // The fingerprint covers everything that determines the result: the plan, the
+  // scan ranges (and therefore the files read), the descriptors and the query options
+  // that change the result. The statement text, session and query start time are left
+  // out so that e.g. differently formatted statements share an entry.
+  ThriftSerializer serializer(false);
+  uint64_t hash1 = FINGERPRINT_SEED1;
+  uint64_t hash2 = FINGERPRINT_SEED2;
+  Status status;
+  BOOST_FOREACH(const TPlanFragment& fragment, request.fragments) {
+    if (status.ok()) status = UpdateFingerprint(&serializer, fragment, &hash1, &hash2);
+  }
+  if (status.ok() && request.__isset.desc_tbl) {
+    status = UpdateFingerprint(&serializer, request.desc_tbl, &hash1, &hash2);
+  }
+  if (status.ok() && request.__isset.result_set_metadata) {
+    status = UpdateFingerprint(&serializer, request.result_set_metadata, &hash1, &hash2);
+  }
+  if (status.ok()) {
+    TQueryOptions options =
+        GetResultQueryOptions(request.query_ctxt.request.query_options);
+    status = UpdateFingerprint(&serializer, options, &hash1, &hash2);
+  }
+  typedef map<TPlanNodeId, vector<TScanRangeLocations> > ScanRangeMap;
+  BOOST_FOREACH(const ScanRangeMap::value_type& ranges, request.per_node_scan_ranges) {
+    BOOST_FOREACH(const TScanRangeLocations& range, ranges.second) {
+      if (status.ok()) status = UpdateFingerprint(&serializer, range, &hash1, &hash2);
+    }
+  }
+  BOOST_FOREACH(int32_t idx, request.dest_fragment_idx) {
+    hash1 = HashUtil::FnvHash64(&idx, sizeof(idx), hash1);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not compute result cache key: " << status.GetErrorMsg();
+    return false;
+  }
+
+  // Both hashes are printed with a fixed width, so different pairs give different keys.
+  stringstream ss;
+  ss << hex << setfill('0') << setw(16) << hash1 << setw(16) << hash2 << dec;
+  {
+    lock_guard<mutex> l(lock_);
+    ss << GetTableVersionsKey(*tables);
+  }
+  *key = ss.str();
+  return true;
+}
+
+string QueryResultCache::GetTableVersionsKey(const vector<string>& tables) {
+  stringstream ss;
+  BOOST_FOREACH(const string& table, tables) {
+    TableVersionMap::const_iterator it = table_versions_.find(table);
+    ss << ":" << (it == table_versions_.end() ? -1L : it->second);
+  }
+  return ss.str();
+}
+
+shared_ptr<const QueryResultCache::Entry> QueryResultCache::Lookup(const string& key) {
+  lock_guard<mutex> l(lock_);
+  EntryMap::iterator it = entries_.find(key);
+  if (it == entries_.end()) {
+    if (ImpaladMetrics::RESULT_CACHE_MISSES != NULL) {
+      ImpaladMetrics::RESULT_CACHE_MISSES->Increment(1L);
+    }
+    UpdateMetrics();
+    return shared_ptr<const Entry>();
+  }
+  // Move to the front of the LRU list.
+  lru_list_.splice(lru_list_.begin(), lru_list_, it->second->lru_it_);
+  if (ImpaladMetrics::RESULT_CACHE_HITS != NULL) {
+    ImpaladMetrics::RESULT_CACHE_HITS->Increment(1L);
+  }
+  UpdateMetrics();
+  return it->second;
+}
+
+QueryResultCache::Entry* QueryResultCache::CreateEntry(const string& key,
+    const vector<string>& tables, const vector<PrimitiveType>& col_types) {
+  return new Entry(key, tables, col_types, mem_tracker());
+}
+
+void QueryResultCache::Insert(Entry* entry) {
+  shared_ptr<Entry> new_entry(entry);
+  lock_guard<mutex> l(lock_);
+  // The key ends with the table versions at the time the query was planned.
+  const string& versions = GetTableVersionsKey(entry->tables_);
+  if (!ends_with(entry->key_, versions)) {
+    VLOG_QUERY << "Not caching result, tables changed during execution";
+    return;
+  }
+  if (entries_.find(entry->key_) != entries_.end()) return;
+  // Don't evict anything for an entry that can never fit.
+  if (entry->num_bytes() > FLAGS_result_cache_size) return;
+
+  // Evict entries until the new entry fits.
+  while (!lru_list_.empty() &&
+      num_bytes_ + entry->num_bytes() > FLAGS_result_cache_size) {
+    RemoveEntry(entries_.find(lru_list_.back()));
+    if (ImpaladMetrics::RESULT_CACHE_EVICTIONS != NULL) {
+      ImpaladMetrics::RESULT_CACHE_EVICTIONS->Increment(1L);
+    }
+  }
+  if (num_bytes_ + entry->num_bytes() > FLAGS_result_cache_size) return;
+
+  lru_list_.push_front(entry->key_);
+  entry->lru_it_ = lru_list_.begin();
+  entries_[entry->key_] = new_entry;
+  num_bytes_ += entry->num_bytes();
+  UpdateMetrics();
+}
+
+void QueryResultCache::UpdateCatalog(const TUpdateCatalogCacheRequest& update) {
+  lock_guard<mutex> l(lock_);
+  if (!update.is_delta) {
+    // Catalog versions are only comparable within one catalog service instance.
+    table_versions_.clear();
+    while (!entries_.empty()) RemoveEntry(entries_.begin());
+  }
+  BOOST_FOREACH(const TCatalogObject& object, update.updated_objects) {
+    if (object.type != TCatalogObjectType::TABLE &&
+        object.type != TCatalogObjectType::VIEW) {
+      continue;
+    }
+    const string& table =
+        to_lower_copy(object.table.db_name + "." + object.table.tbl_name);
+    table_versions_[table] = object.catalog_version;
+    InvalidateTable(to_lower_copy(object.table.db_name), table);
+  }
+  BOOST_FOREACH(const TCatalogObject& object, update.removed_objects) {
+    if (object.type == TCatalogObjectType::DATABASE) {
+      InvalidateTable(to_lower_copy(object.db.db_name), "");
+    } else if (object.type == TCatalogObjectType::TABLE ||
+        object.type == TCatalogObjectType::VIEW) {
+      const string& table =
+          to_lower_copy(object.table.db_name + "." + object.table.tbl_name);
+      table_versions_.erase(table);
+      InvalidateTable(to_lower_copy(object.table.db_name), table);
+    }
+  }
+  UpdateMetrics();
+}
+
+void QueryResultCache::InvalidateTable(const string& db, const string& table) {
+  const string& db_prefix = db + ".";
+  EntryMap::iterator it = entries_.begin();
+  while (it != entries_.end()) {
+    bool invalidate = false;
+    BOOST_FOREACH(const string& entry_table, it->second->tables_) {
+      if (table.empty() ? starts_with(entry_table, db_prefix) : entry_table == table) {
+        invalidate = true;
+        break;
+      }
+    }
+    if (!invalidate) {
+      ++it;
+      continue;
+    }
+    EntryMap::iterator next = it;
+    ++next;
+    RemoveEntry(it);
+    it = next;
+    if (ImpaladMetrics::RESULT_CACHE_INVALIDATIONS != NULL) {
+      ImpaladMetrics::RESULT_CACHE_INVALIDATIONS->Increment(1L);
+    }
+  }
+}
+
+void QueryResultCache::Clear() {
+  lock_guard<mutex> l(lock_);
+  while (!entries_.empty()) RemoveEntry(entries_.begin());
+  UpdateMetrics();
+}
+
+void QueryResultCache::RemoveEntry(EntryMap::iterator it) {
+  DCHECK(it != entries_.end());
+  num_bytes_ -= it->second->num_bytes();
+  lru_list_.erase(it->second->lru_it_);
+  // Queries that are still returning rows from this entry hold a reference to it.
+  entries_.erase(it);
+}
+
+void QueryResultCache::UpdateMetrics() {
+  if (ImpaladMetrics::RESULT_CACHE_NUM_ENTRIES == NULL) return;
+  ImpaladMetrics::RESULT_CACHE_NUM_ENTRIES->Update(entries_.size());
+  ImpaladMetrics::RESULT_CACHE_TOTAL_BYTES->Update(num_bytes_);
+  int64_t hits = ImpaladMetrics::RESULT_CACHE_HITS->value();
+  int64_t lookups = hits + ImpaladMetrics::RESULT_CACHE_MISSES->value();
+  ImpaladMetrics::RESULT_CACHE_HIT_RATIO->Update(
+      lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups);
+}
+
+}
@@ -0,0 +1,195 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_SERVICE_QUERY_RESULT_CACHE_H
+#define IMPALA_SERVICE_QUERY_RESULT_CACHE_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "common/status.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/primitive-type.h"
+#include "gen-cpp/Frontend_types.h"
+
+namespace impala {
+
+class ExecEnv;
+
+// Caches the result rows of SELECT statements so that repeated executions of the same
+// query (e.g. from dashboards) can be answered without scheduling any fragments.
+//
+// Entries are keyed by a fingerprint of the normalized TQueryExecRequest (the plan,
+// scan ranges and the query options that can change the result, but not the statement
+// text, session or query start time) plus the catalog versions of all tables the query
+// reads. The table versions are maintained from the catalog topic updates processed by
+// the ImpalaServer, which also invalidates all entries that reference a changed or
+// dropped table. Queries that read HBase tables (which can change without a catalog
+// update) or that call non-deterministic or user-defined functions are never cached.
+//
+// The cached rows are the materialized output expr values, so they are returned to
+// the client exactly as if the query had been executed. All memory is allocated from
+// MemPools that are tracked by the cache's MemTracker, a child of the process
+// MemTracker. The cache size is bounded by
+// --result_cache_size; entries are evicted in LRU order. Results with more than
+// --result_cache_max_entry_rows rows or --result_cache_max_entry_bytes bytes are not
+// cached.
+//
+// This class is thread safe.
+class QueryResultCache {
+ public:
+  // A cached result set. Entries are immutable once inserted into the cache and may
+  // be shared by any number of queries.
+  class Entry {
+   public:
+    ~Entry();
+
+    // Copies a row of output expr values into this entry. Returns false if the entry
+    // would exceed the per-entry limits, in which case the entry must be discarded.
+    bool AddRow(const std::vector<void*>& row, const std::vector<int>& scales);
+
+    // Adds 'count' rows starting at row 'start_row' to 'result_set', which must be
+    // an ImpalaServer::QueryResultSet.
+    template <typename ResultSet>
+    Status GetRows(int64_t start_row, int64_t count, ResultSet* result_set) const {
+      DCHECK_LE(start_row + count, num_rows());
+      std::vector<void*> row(col_types_.size());
+      for (int64_t i = start_row; i < start_row + count; ++i) {
+        for (int j = 0; j < col_types_.size(); ++j) {
+          row[j] = rows_[i][j];
+        }
+        RETURN_IF_ERROR(result_set->AddOneRow(row, scales_));
+      }
+      return Status::OK;
+    }
+
+    int64_t num_rows() const { return rows_.size(); }
+    int64_t num_bytes() const { return pool_.total_reserved_bytes(); }
+    const std::string& key() const { return key_; }
+
+   private:
+    friend class QueryResultCache;
+
+    Entry(const std::string& key, const std::vector<std::string>& tables,
+        const std::vector<PrimitiveType>& col_types, MemTracker* mem_tracker);
+
+    const std::string key_;
+
+    // Fully qualified names of the tables the result depends on.
+    const std::vector<std::string> tables_;
+
+    // Output column types and scales. Scales are only known once the first row is
+    // added.
+    const std::vector<PrimitiveType> col_types_;
+    std::vector<int> scales_;
+
+    // Holds the values of all rows, including the var-len data.
+    MemPool pool_;
+
+    // One array of num_cols() value pointers per row, allocated from pool_. NULL
+    // values are NULL pointers.
+    std::vector<void**> rows_;
+
+    // Position in QueryResultCache::lru_list_; only valid while in the cache.
+    std::list<std::string>::iterator lru_it_;
+  };
+
+  // The cache's MemTracker is a child of the process MemTracker of 'exec_env', which
+  // is only created when the ExecEnv services are started. 'exec_env' may be NULL, in
+  // which case the cache's MemTracker has no parent.
+  QueryResultCache(ExecEnv* exec_env);
+
+  ~QueryResultCache();
+
+  // Returns true if the results of 'request' may be cached and sets 'key' to the cache
+  // key for the request and 'tables' to the tables it reads.
+  bool GetCacheKey(const TQueryExecRequest& request, std::string* key,
+      std::vector<std::string>* tables);
+
+  // Returns the cached results for 'key' or an empty pointer if there are none.
+  boost::shared_ptr<const Entry> Lookup(const std::string& key);
+
+  // Creates a new, empty entry for 'key' (as returned by GetCacheKey()). The caller
+  // owns the entry until it is passed to Insert().
+  Entry* CreateEntry(const std::string& key, const std::vector<std::string>& tables,
+      const std::vector<PrimitiveType>& col_types);
+
+  // Adds a completely populated entry to the cache and takes ownership of it. The entry
+  // is dropped if any of its tables changed after its key was computed.
+  void Insert(Entry* entry);
+
+  // Updates the table versions and invalidates the entries of all tables that were
+  // changed or removed by 'update'. A full (non-delta) update clears the cache.
+  void UpdateCatalog(const TUpdateCatalogCacheRequest& update);
+
+  // Removes all entries.
+  void Clear();
+
+  // Returns the cache's MemTracker, creating it on first use. Must not be called before
+  // the ExecEnv services are started.
+  MemTracker* mem_tracker();
+
+ private:
+  ExecEnv* exec_env_;
+
+  // Protects mem_tracker_.
+  boost::mutex mem_tracker_lock_;
+
+  // Tracks the memory used by all entries, including entries that are still being
+  // populated. Created by mem_tracker().
+  boost::scoped_ptr<MemTracker> mem_tracker_;
+
+  // Protects all fields below.
+  boost::mutex lock_;
+
+  // Map from cache key to entry.
+  typedef boost::unordered_map<std::string, boost::shared_ptr<Entry> > EntryMap;
+  EntryMap entries_;
+
+  // Keys of all entries, the most recently used entry first.
+  std::list<std::string> lru_list_;
+
+  // Total bytes used by the entries in entries_.
+  int64_t num_bytes_;
+
+  // Map from fully qualified table name to the catalog version of the table, as of the
+  // most recent catalog update.
+  typedef boost::unordered_map<std::string, int64_t> TableVersionMap;
+  TableVersionMap table_versions_;
+
+  // Returns the part of the cache key that encodes the current versions of 'tables'.
+  // Must be called with lock_ taken.
+  std::string GetTableVersionsKey(const std::vector<std::string>& tables);
+
+  // Removes all entries that reference 'table', or all tables of database 'db' if
+  // 'table' is empty. Must be called with lock_ taken.
+  void InvalidateTable(const std::string& db, const std::string& table);
+
+  // Removes 'it' from the cache. Must be called with lock_ taken.
+  void RemoveEntry(EntryMap::iterator it);
+
+  // Updates the cache metrics. Must be called with lock_ taken.
+  void UpdateMetrics();
+};
+
+}
+
+#endif
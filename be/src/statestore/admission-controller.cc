@@ -0,0 +1,345 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "statestore/admission-controller.h"
+
+#include <boost/bind.hpp>
+#include <boost/mem_fn.hpp>
+#include <boost/foreach.hpp>
+#include <gutil/strings/substitute.h>
+
+#include "common/logging.h"
+#include "statestore/query-schedule.h"
+#include "util/debug-util.h"
+#include "util/time.h"
+
+using namespace std;
+using namespace boost;
+using namespace strings;
+
+DEFINE_int64(queue_wait_timeout_ms, 60 * 1000, "Maximum amount of time (in "
+    "milliseconds) that a request will wait to be admitted before timing out.");
+
+namespace impala {
+
+const string AdmissionController::IMPALA_REQUEST_QUEUE_TOPIC("impala-request-queue");
+
+// Separates the pool name from the backend id in topic keys. Backend ids never
+// contain this character, so the last occurrence always marks the separator.
+static const char TOPIC_KEY_DELIMITER = '!';
+
+// Prefix of all admission controller metric keys; followed by the pool name.
+static const string METRIC_KEY_PREFIX("admission-controller.");
+
+AdmissionController::AdmissionController(StatestoreSubscriber* subscriber,
+    const string& backend_id, Metrics* metrics)
+  : subscriber_(subscriber),
+    backend_id_(backend_id),
+    metrics_(metrics),
+    thrift_serializer_(false) {
+}
+
+Status AdmissionController::Init() {
+  if (subscriber_ == NULL) return Status::OK;
+  StatestoreSubscriber::UpdateCallback cb =
+      bind<void>(mem_fn(&AdmissionController::UpdatePoolStats), this, _1, _2);
+  Status status = subscriber_->AddTopic(IMPALA_REQUEST_QUEUE_TOPIC, true, cb);
+  if (!status.ok()) {
+    status.AddErrorMsg("AdmissionController failed to register request queue topic");
+  }
+  return status;
+}
+
+string AdmissionController::MakePoolTopicKey(const string& pool) {
+  return pool + TOPIC_KEY_DELIMITER + backend_id_;
+}
+
+AdmissionController::PoolStats* AdmissionController::GetPoolStats(const string& pool) {
+  PoolStatsMap::iterator it = pool_stats_.find(pool);
+  if (it != pool_stats_.end()) return it->second;
+
+  PoolStats* stats = obj_pool_.Add(new PoolStats());
+  stats->local_stats.num_running = 0;
+  stats->local_stats.num_queued = 0;
+  stats->local_stats.mem_reserved = 0;
+  stats->remote_stats = stats->local_stats;
+  stats->cluster_num_running_metric = NULL;
+  stats->cluster_num_queued_metric = NULL;
+  stats->cluster_mem_reserved_metric = NULL;
+  stats->local_num_running_metric = NULL;
+  stats->local_num_queued_metric = NULL;
+  stats->total_admitted_metric = NULL;
+  stats->total_queued_metric = NULL;
+  stats->total_rejected_metric = NULL;
+  stats->total_timed_out_metric = NULL;
+  stats->total_queue_wait_ms_metric = NULL;
+
+  if (metrics_ != NULL) {
+    const string prefix = METRIC_KEY_PREFIX + pool + ".";
+    stats->cluster_num_running_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "cluster-num-running", 0L);
+    stats->cluster_num_queued_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "cluster-num-queued", 0L);
+    stats->cluster_mem_reserved_metric = metrics_->RegisterMetric(
+        new Metrics::BytesMetric(prefix + "cluster-mem-estimate", 0L));
+    stats->local_num_running_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "local-num-running", 0L);
+    stats->local_num_queued_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "local-num-queued", 0L);
+    stats->total_admitted_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "total-admitted", 0L);
+    stats->total_queued_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "total-queued", 0L);
+    stats->total_rejected_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "total-rejected", 0L);
+    stats->total_timed_out_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "total-timed-out", 0L);
+    stats->total_queue_wait_ms_metric =
+        metrics_->CreateAndRegisterPrimitiveMetric(prefix + "total-queue-wait-ms", 0L);
+  }
+  pool_stats_[pool] = stats;
+  return stats;
+}
+
+void AdmissionController::UpdatePoolMetrics(PoolStats* stats) {
+  if (metrics_ == NULL) return;
+  stats->cluster_num_running_metric->Update(
+      stats->local_stats.num_running + stats->remote_stats.num_running);
+  stats->cluster_num_queued_metric->Update(
+      stats->local_stats.num_queued + stats->remote_stats.num_queued);
+  stats->cluster_mem_reserved_metric->Update(
+      stats->local_stats.mem_reserved + stats->remote_stats.mem_reserved);
+  stats->local_num_running_metric->Update(stats->local_stats.num_running);
+  stats->local_num_queued_metric->Update(stats->local_stats.num_queued);
+}
+
+bool AdmissionController::CanAdmit(const PoolConfig& pool_config,
+    const PoolStats& stats, int64_t mem_estimate, string* reason) {
+  int64_t cluster_num_running =
+      stats.local_stats.num_running + stats.remote_stats.num_running;
+  if (pool_config.max_requests > 0 && cluster_num_running >= pool_config.max_requests) {
+    *reason = Substitute("number of running queries $0 is at or over limit $1",
+        cluster_num_running, pool_config.max_requests);
+    return false;
+  }
+  int64_t cluster_mem_reserved =
+      stats.local_stats.mem_reserved + stats.remote_stats.mem_reserved;
+  if (pool_config.mem_limit > 0 &&
+      cluster_mem_reserved + mem_estimate > pool_config.mem_limit) {
+    *reason = Substitute("estimated memory $0 plus reserved memory $1 exceeds pool "
+        "limit $2", PrettyPrinter::Print(mem_estimate, TCounterType::BYTES),
+        PrettyPrinter::Print(cluster_mem_reserved, TCounterType::BYTES),
+        PrettyPrinter::Print(pool_config.mem_limit, TCounterType::BYTES));
+    return false;
+  }
+  return true;
+}
+
+void AdmissionController::Admit(const string& pool, PoolStats* stats,
+    QuerySchedule* schedule, int64_t mem_estimate) {
+  ++stats->local_stats.num_running;
+  stats->local_stats.mem_reserved += mem_estimate;
+  schedule->set_is_admitted(true);
+  dirty_pools_.insert(pool);
+  if (metrics_ != NULL) stats->total_admitted_metric->Increment(1L);
+  UpdatePoolMetrics(stats);
+  VLOG_QUERY << "Admitted query " << schedule->query_id() << " to pool " << pool
+             << " with estimated memory "
+             << PrettyPrinter::Print(mem_estimate, TCounterType::BYTES);
+}
+
+Status AdmissionController::AdmitQuery(const string& pool,
+    const PoolConfig& pool_config, QuerySchedule* schedule) {
+  DCHECK(!schedule->is_admitted());
+  int64_t mem_estimate = schedule->GetClusterMemoryEstimate();
+
+  unique_lock<mutex> l(lock_);
+  schedule->set_request_pool(pool);
+  if (schedule->is_admission_cancelled()) {
+    return Status("Query was cancelled while waiting for admission");
+  }
+  PoolStats* stats = GetPoolStats(pool);
+  string reason;
+  // Only admit immediately if no other local query is waiting, to keep the queue FIFO.
+  if (stats->queue.empty() && CanAdmit(pool_config, *stats, mem_estimate, &reason)) {
+    Admit(pool, stats, schedule, mem_estimate);
+    return Status::OK;
+  }
+
+  if (pool_config.mem_limit > 0 && mem_estimate > pool_config.mem_limit) {
+    // This query could never be admitted, don't bother queuing it.
+    if (metrics_ != NULL) stats->total_rejected_metric->Increment(1L);
+    return Status(Substitute("Rejected query from pool $0: estimated memory $1 is "
+        "greater than the pool memory limit $2", pool,
+        PrettyPrinter::Print(mem_estimate, TCounterType::BYTES),
+        PrettyPrinter::Print(pool_config.mem_limit, TCounterType::BYTES)));
+  }
+  int64_t cluster_num_queued =
+      stats->local_stats.num_queued + stats->remote_stats.num_queued;
+  if (pool_config.max_queued != PoolConfig::UNLIMITED_QUEUED &&
+      cluster_num_queued >= pool_config.max_queued) {
+    if (metrics_ != NULL) stats->total_rejected_metric->Increment(1L);
+    return Status(Substitute("Rejected query from pool $0: queue full, limit=$1, "
+        "num_queued=$2", pool, pool_config.max_queued, cluster_num_queued));
+  }
+
+  VLOG_QUERY << "Queuing query " << schedule->query_id() << " in pool " << pool
+             << ": " << reason;
+  QueueNode node;
+  node.schedule = schedule;
+  node.mem_estimate = mem_estimate;
+  stats->queue.push_back(&node);
+  ++stats->local_stats.num_queued;
+  dirty_pools_.insert(pool);
+  if (metrics_ != NULL) stats->total_queued_metric->Increment(1L);
+  UpdatePoolMetrics(stats);
+
+  int64_t start_ms = ms_since_epoch();
+  int64_t deadline_ms = start_ms + FLAGS_queue_wait_timeout_ms;
+  bool admitted = false;
+  while (!schedule->is_admission_cancelled()) {
+    // Only the query at the head of the queue may be admitted.
+    if (stats->queue.front() == &node &&
+        CanAdmit(pool_config, *stats, mem_estimate, &reason)) {
+      admitted = true;
+      break;
+    }
+    int64_t now_ms = ms_since_epoch();
+    if (now_ms >= deadline_ms) break;
+    stats->queue_cv.timed_wait(l, posix_time::milliseconds(deadline_ms - now_ms));
+  }
+
+  stats->queue.remove(&node);
+  --stats->local_stats.num_queued;
+  dirty_pools_.insert(pool);
+  int64_t wait_ms = ms_since_epoch() - start_ms;
+  if (metrics_ != NULL) stats->total_queue_wait_ms_metric->Increment(wait_ms);
+  // Our position in the queue changed, the next query may now be admissible.
+  stats->queue_cv.notify_all();
+
+  if (schedule->is_admission_cancelled()) {
+    UpdatePoolMetrics(stats);
+    return Status("Query was cancelled while waiting for admission");
+  }
+  if (!admitted) {
+    if (metrics_ != NULL) stats->total_timed_out_metric->Increment(1L);
+    UpdatePoolMetrics(stats);
+    return Status(Substitute("Admission for query exceeded timeout $0ms in pool $1. "
+        "Queued reason: $2", FLAGS_queue_wait_timeout_ms, pool, reason));
+  }
+  Admit(pool, stats, schedule, mem_estimate);
+  VLOG_QUERY << "Query " << schedule->query_id() << " admitted after waiting "
+             << wait_ms << "ms in the queue";
+  return Status::OK;
+}
+
+void AdmissionController::ReleaseQuery(QuerySchedule* schedule) {
+  if (!schedule->is_admitted()) return;
+  const string& pool = schedule->request_pool();
+  int64_t mem_estimate = schedule->GetClusterMemoryEstimate();
+  lock_guard<mutex> l(lock_);
+  PoolStats* stats = GetPoolStats(pool);
+  DCHECK_GT(stats->local_stats.num_running, 0);
+  --stats->local_stats.num_running;
+  stats->local_stats.mem_reserved -= mem_estimate;
+  DCHECK_GE(stats->local_stats.mem_reserved, 0);
+  schedule->set_is_admitted(false);
+  dirty_pools_.insert(pool);
+  UpdatePoolMetrics(stats);
+  stats->queue_cv.notify_all();
+}
+
+void AdmissionController::CancelQuery(QuerySchedule* schedule) {
+  lock_guard<mutex> l(lock_);
+  if (schedule->is_admitted()) return;
+  schedule->set_is_admission_cancelled(true);
+  // The pool is set before the query is queued; if it is empty the query was not
+  // submitted yet.
+  if (schedule->request_pool().empty()) return;
+  PoolStatsMap::iterator it = pool_stats_.find(schedule->request_pool());
+  if (it != pool_stats_.end()) it->second->queue_cv.notify_all();
+}
+
+void AdmissionController::UpdatePoolStats(
+    const StatestoreSubscriber::TopicDeltaMap& incoming_topic_deltas,
+    vector<TTopicDelta>* subscriber_topic_updates) {
+  lock_guard<mutex> l(lock_);
+  StatestoreSubscriber::TopicDeltaMap::const_iterator topic =
+      incoming_topic_deltas.find(IMPALA_REQUEST_QUEUE_TOPIC);
+  if (topic != incoming_topic_deltas.end()) {
+    const TTopicDelta& delta = topic->second;
+    if (!delta.is_delta) remote_topic_entries_.clear();
+    BOOST_FOREACH(const TTopicItem& item, delta.topic_entries) {
+      size_t delim = item.key.rfind(TOPIC_KEY_DELIMITER);
+      if (delim == string::npos) {
+        VLOG(2) << "Ignoring malformed request queue topic key: " << item.key;
+        continue;
+      }
+      // Our own entries are tracked in local_stats.
+      if (item.key.substr(delim + 1) == backend_id_) continue;
+      TPoolStats pool_stats;
+      uint32_t len = item.value.size();
+      Status status = DeserializeThriftMsg(reinterpret_cast<const uint8_t*>(
+          item.value.data()), &len, false, &pool_stats);
+      if (!status.ok()) {
+        VLOG(2) << "Error deserializing topic item with key: " << item.key;
+        continue;
+      }
+      remote_topic_entries_[item.key] = pool_stats;
+    }
+    BOOST_FOREACH(const string& key, delta.topic_deletions) {
+      remote_topic_entries_.erase(key);
+    }
+
+    // Recompute the remote aggregates from scratch; the number of entries is bounded by
+    // the number of pools times the number of impalads.
+    BOOST_FOREACH(PoolStatsMap::value_type& entry, pool_stats_) {
+      entry.second->remote_stats.num_running = 0;
+      entry.second->remote_stats.num_queued = 0;
+      entry.second->remote_stats.mem_reserved = 0;
+    }
+    BOOST_FOREACH(const PoolTopicMap::value_type& entry, remote_topic_entries_) {
+      string pool = entry.first.substr(0, entry.first.rfind(TOPIC_KEY_DELIMITER));
+      PoolStats* stats = GetPoolStats(pool);
+      stats->remote_stats.num_running += entry.second.num_running;
+      stats->remote_stats.num_queued += entry.second.num_queued;
+      stats->remote_stats.mem_reserved += entry.second.mem_reserved;
+    }
+    BOOST_FOREACH(PoolStatsMap::value_type& entry, pool_stats_) {
+      UpdatePoolMetrics(entry.second);
+      // Remote queries may have finished; let queued queries re-check.
+      if (!entry.second->queue.empty()) entry.second->queue_cv.notify_all();
+    }
+  }
+
+  if (dirty_pools_.empty()) return;
+  subscriber_topic_updates->push_back(TTopicDelta());
+  TTopicDelta& update = subscriber_topic_updates->back();
+  update.topic_name = IMPALA_REQUEST_QUEUE_TOPIC;
+  BOOST_FOREACH(const string& pool, dirty_pools_) {
+    PoolStats* stats = GetPoolStats(pool);
+    update.topic_entries.push_back(TTopicItem());
+    TTopicItem& item = update.topic_entries.back();
+    item.key = MakePoolTopicKey(pool);
+    Status status = thrift_serializer_.Serialize(&stats->local_stats, &item.value);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to serialize pool stats for request queue topic: "
+                   << status.GetErrorMsg();
+      update.topic_entries.pop_back();
+    }
+  }
+  dirty_pools_.clear();
+}
+
+}
@@ -0,0 +1,194 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef STATESTORE_ADMISSION_CONTROLLER_H
+#define STATESTORE_ADMISSION_CONTROLLER_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/object-pool.h"
+#include "common/status.h"
+#include "rpc/thrift-util.h"
+#include "statestore/statestore-subscriber.h"
+#include "util/metrics.h"
+#include "gen-cpp/ImpalaInternalService_types.h"
+
+namespace impala {
+
+class QuerySchedule;
+
+// Admission limits for a single request pool.
+struct PoolConfig {
+  // Max number of queries that may run concurrently in the pool across the cluster.
+  // A value <= 0 means unlimited.
+  int64_t max_requests;
+
+  // Max number of queries that may be queued in the pool across the cluster. 0 means
+  // queries that cannot be admitted immediately are rejected, UNLIMITED_QUEUED means
+  // unlimited.
+  int64_t max_queued;
+
+  // Max sum of the estimated memory of all running queries in the pool across the
+  // cluster, in bytes. A value <= 0 means unlimited.
+  int64_t mem_limit;
+
+  static const int64_t UNLIMITED_QUEUED = -1;
+
+  PoolConfig() : max_requests(-1), max_queued(UNLIMITED_QUEUED), mem_limit(-1) { }
+};
+
+// Decides whether a query can be executed immediately, must be queued or must be
+// rejected, based on the per-pool concurrency and memory limits in a PoolConfig.
+// Queries that cannot be admitted are queued (FIFO per pool) until either enough
+// resources become available or the queue wait timeout expires.
+//
+// Each impalad only knows about the queries it coordinates itself, so every impalad
+// publishes its per-pool TPoolStats to the IMPALA_REQUEST_QUEUE_TOPIC and aggregates
+// the stats of all other impalads when it receives topic updates. Because the remote
+// stats are only as fresh as the last statestore heartbeat, the cluster-wide limits are
+// soft: concurrent coordinators may briefly overadmit.
+//
+// This class is thread safe.
+class AdmissionController {
+ public:
+  static const std::string IMPALA_REQUEST_QUEUE_TOPIC;
+
+  // subscriber may be NULL, in which case admission decisions are made based only on
+  // local state. metrics may be NULL.
+  AdmissionController(StatestoreSubscriber* subscriber, const std::string& backend_id,
+      Metrics* metrics);
+
+  // Registers with the statestore subscriber for the request queue topic. Must be
+  // called before the subscriber is started.
+  Status Init();
+
+  // Submits the query in 'schedule' for admission to 'pool' with the given limits.
+  // Blocks until the query is admitted, rejected or times out waiting in the queue.
+  // Returns OK if the query was admitted; in that case ReleaseQuery() must be called
+  // once the query finishes.
+  Status AdmitQuery(const std::string& pool, const PoolConfig& pool_config,
+      QuerySchedule* schedule);
+
+  // Releases the pool resources held by an admitted query and wakes up queued queries.
+  // Does nothing if the query was not admitted.
+  void ReleaseQuery(QuerySchedule* schedule);
+
+  // Cancels the admission of the query in 'schedule'. If the query is waiting in a
+  // queue, it is removed from the queue and AdmitQuery() returns an error. If it has
+  // not been submitted yet, AdmitQuery() will return an error without queuing it.
+  // Does nothing if the query was already admitted.
+  void CancelQuery(QuerySchedule* schedule);
+
+ private:
+  // A query waiting in a pool queue. Owned by the thread blocked in AdmitQuery().
+  struct QueueNode {
+    QuerySchedule* schedule;
+    int64_t mem_estimate;
+  };
+
+  // Admission state for a single pool.
+  struct PoolStats {
+    // Stats of the queries coordinated by this impalad. Published to the topic.
+    TPoolStats local_stats;
+
+    // Sum of the most recent stats published by all other impalads.
+    TPoolStats remote_stats;
+
+    // Queries coordinated by this impalad that are waiting for admission, in
+    // arrival order.
+    std::list<QueueNode*> queue;
+
+    // Signalled whenever resources in this pool may have been freed up.
+    boost::condition_variable queue_cv;
+
+    // Metrics for this pool; NULL if metrics_ is NULL.
+    Metrics::IntMetric* cluster_num_running_metric;
+    Metrics::IntMetric* cluster_num_queued_metric;
+    Metrics::IntMetric* cluster_mem_reserved_metric;
+    Metrics::IntMetric* local_num_running_metric;
+    Metrics::IntMetric* local_num_queued_metric;
+    Metrics::IntMetric* total_admitted_metric;
+    Metrics::IntMetric* total_queued_metric;
+    Metrics::IntMetric* total_rejected_metric;
+    Metrics::IntMetric* total_timed_out_metric;
+    Metrics::IntMetric* total_queue_wait_ms_metric;
+  };
+
+  // Statestore subscriber used to publish and receive pool stats. Not owned.
+  StatestoreSubscriber* subscriber_;
+
+  // Unique id of this impalad, used as part of the topic keys it publishes.
+  const std::string backend_id_;
+
+  // Not owned, may be NULL.
+  Metrics* metrics_;
+
+  ThriftSerializer thrift_serializer_;
+
+  // Protects all fields below.
+  boost::mutex lock_;
+
+  // Owns the PoolStats objects.
+  ObjectPool obj_pool_;
+
+  // Map from pool name to its admission state. Entries are never removed.
+  typedef boost::unordered_map<std::string, PoolStats*> PoolStatsMap;
+  PoolStatsMap pool_stats_;
+
+  // Most recent stats received from other impalads, keyed by topic key
+  // (see MakePoolTopicKey()).
+  typedef boost::unordered_map<std::string, TPoolStats> PoolTopicMap;
+  PoolTopicMap remote_topic_entries_;
+
+  // Pools whose local_stats changed since they were last published.
+  boost::unordered_set<std::string> dirty_pools_;
+
+  // Returns the PoolStats for 'pool', creating it (and its metrics) if necessary.
+  // Must be called with lock_ taken.
+  PoolStats* GetPoolStats(const std::string& pool);
+
+  // Returns true if a query with the given memory estimate can be admitted to 'pool'
+  // right now. Otherwise returns false and sets 'reason'.
+  // Must be called with lock_ taken.
+  bool CanAdmit(const PoolConfig& pool_config, const PoolStats& stats,
+      int64_t mem_estimate, std::string* reason);
+
+  // Updates the stats of 'pool' for a newly admitted query.
+  // Must be called with lock_ taken.
+  void Admit(const std::string& pool, PoolStats* stats, QuerySchedule* schedule,
+      int64_t mem_estimate);
+
+  // Updates the metrics of 'stats' to reflect its current state.
+  // Must be called with lock_ taken.
+  void UpdatePoolMetrics(PoolStats* stats);
+
+  // Called asynchronously when an update is received from the statestore. Applies the
+  // remote pool stats and publishes the stats of pools that changed locally.
+  void UpdatePoolStats(const StatestoreSubscriber::TopicDeltaMap& incoming_topic_deltas,
+      std::vector<TTopicDelta>* subscriber_topic_updates);
+
+  // Returns the topic key for 'pool' published by this impalad.
+  std::string MakePoolTopicKey(const std::string& pool);
+};
+
+}
+
+#endif
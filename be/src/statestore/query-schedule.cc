@@ -50,7 +50,9 @@ QuerySchedule::QuerySchedule(const TUniqueId& query_id,
     query_options_(query_options),
     is_mini_llama_(is_mini_llama),
     num_backends_(0),
-    num_scan_ranges_(0) {
+    num_scan_ranges_(0),
+    is_admitted_(false),
+    is_admission_cancelled_(false) {
   fragment_exec_params_.resize(request.fragments.size());
   // map from plan node id to fragment index in exec_request.fragments
   vector<PlanNodeId> per_node_fragment_idx;
@@ -74,6 +76,20 @@ void QuerySchedule::GetResourceHostport(const TNetworkAddress& src,
   }
 }
 
+int64_t QuerySchedule::GetPerHostMemoryEstimate() const {
+  if (query_options_.__isset.mem_limit && query_options_.mem_limit > 0) {
+    return query_options_.mem_limit;
+  } else if (request_.__isset.per_host_mem_req) {
+    return request_.per_host_mem_req;
+  }
+  return 0;
+}
+
+int64_t QuerySchedule::GetClusterMemoryEstimate() const {
+  // unique_hosts_ excludes the coordinator, which also executes a fragment.
+  return GetPerHostMemoryEstimate() * (unique_hosts_.size() + 1);
+}
+
 void QuerySchedule::CreateMiniLlamaMapping(const vector<string>& llama_nodes) {
   DCHECK(is_mini_llama_);
   DCHECK(!llama_nodes.empty());
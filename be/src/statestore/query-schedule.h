@@ -80,10 +80,26 @@ class QuerySchedule {
   // of resource locations.
   void GetResourceHostport(const TNetworkAddress& src, TNetworkAddress* dest);
 
+  // Returns the estimated memory requirement of a single backend executing fragments
+  // of this query. Prefers the mem_limit query option over the planner estimate.
+  // Returns 0 if neither is set.
+  int64_t GetPerHostMemoryEstimate() const;
+
+  // Returns the estimated memory requirement of this query across all hosts it is
+  // scheduled on (including the coordinator). Only valid after the scheduler has
+  // populated unique_hosts_.
+  int64_t GetClusterMemoryEstimate() const;
+
   const TUniqueId& query_id() const { return query_id_; }
   const TQueryExecRequest& request() const { return request_; }
   const TQueryOptions& query_options() const { return query_options_; }
   const std::string& yarn_pool() { return yarn_pool_; }
+  const std::string& request_pool() const { return request_pool_; }
+  void set_request_pool(const std::string& pool) { request_pool_ = pool; }
+  bool is_admitted() const { return is_admitted_; }
+  void set_is_admitted(bool is_admitted) { is_admitted_ = is_admitted; }
+  bool is_admission_cancelled() const { return is_admission_cancelled_; }
+  void set_is_admission_cancelled(bool cancelled) { is_admission_cancelled_ = cancelled; }
   bool HasReservation() const { return !reservation_.allocated_resources.empty(); }
 
   // Granted or timed out reservations need to be released. In both such cases,
@@ -144,6 +160,17 @@ class QuerySchedule {
   // Set in CreateReservationRequest().
   std::string yarn_pool_;
 
+  // Request pool used for admission control. Set by the scheduler.
+  std::string request_pool_;
+
+  // True if the admission controller admitted this query and its pool resources need
+  // to be released when the query finishes.
+  bool is_admitted_;
+
+  // True if the query was cancelled before it was admitted. Protected by the lock of
+  // the admission controller.
+  bool is_admission_cancelled_;
+
   // Reservation request to be submitted to Llama. Set in CreateReservationRequest().
   boost::scoped_ptr<TResourceBrokerReservationRequest> reservation_request_;
 
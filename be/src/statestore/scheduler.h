@@ -71,6 +71,10 @@ class Scheduler {
   // Releases the reserved resources (if any) from the given schedule.
   virtual Status Release(QuerySchedule* schedule) = 0;
 
+  // Cancels the given schedule if it is waiting for admission, in which case
+  // Schedule() returns an error. May be called concurrently with Schedule().
+  virtual void Cancel(QuerySchedule* schedule) = 0;
+
   // Notifies this scheduler that a resource reservation has been preempted by the
   // central scheduler (Yarn via Llama). All affected queries are cancelled
   // via their coordinator.
@@ -12,18 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <map>
+#include <set>
 #include <gtest/gtest.h>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "common/logging.h"
+#include "rpc/thrift-util.h"
 #include "simple-scheduler.h"
+#include "util/time.h"
 
 using namespace std;
 using namespace boost;
 using namespace impala;
 
 DECLARE_string(pool_conf_file);
+DECLARE_int64(queue_wait_timeout_ms);
+DECLARE_bool(enable_rm);
+DECLARE_bool(enable_admission_control);
+DECLARE_int64(default_pool_max_queued);
 
 namespace impala {
 
@@ -62,6 +71,87 @@ class SimpleSchedulerTest : public testing::Test {
     local_remote_scheduler_.reset(new SimpleScheduler(backends, NULL, NULL, NULL));
   }
 
+  // Returns a scan range of 'length' bytes without any replicas.
+  TScanRangeLocations MakeScanRange(int64_t length) {
+    TScanRangeLocations locations;
+    THdfsFileSplit split;
+    split.length = length;
+    locations.scan_range.__set_hdfs_file_split(split);
+    return locations;
+  }
+
+  // Adds a replica of 'locations' on datanode 'host'.
+  void AddReplica(const string& host, int volume_id, bool is_cached,
+      TScanRangeLocations* locations) {
+    TScanRangeLocation location;
+    location.server = MakeNetworkAddress(host, 50010);
+    location.__set_volume_id(volume_id);
+    location.__set_is_cached(is_cached);
+    locations->locations.push_back(location);
+  }
+
+  // Returns a scan range of 'length' bytes with an uncached replica on each of
+  // 127.0.0.0 and 127.0.0.1.
+  TScanRangeLocations MakeReplicatedScanRange(int64_t length) {
+    TScanRangeLocations locations = MakeScanRange(length);
+    AddReplica("127.0.0.0", 0, false, &locations);
+    AddReplica("127.0.0.1", 0, false, &locations);
+    return locations;
+  }
+
+  // Assigns 'locations' of plan node 0 with 'scheduler'. Tests can't call the private
+  // SimpleScheduler::ComputeScanRangeAssignment() themselves.
+  void ComputeAssignment(SimpleScheduler* scheduler,
+      const vector<TScanRangeLocations>& locations,
+      FragmentScanRangeAssignment* assignment) {
+    EXPECT_TRUE(
+        scheduler->ComputeScanRangeAssignment(0, locations, false, assignment).ok());
+  }
+
+  // Assigns 'locations' with 'scheduler' and returns the number of bytes assigned to
+  // each backend host.
+  map<string, int64_t> AssignScanRanges(SimpleScheduler* scheduler,
+      const vector<TScanRangeLocations>& locations) {
+    FragmentScanRangeAssignment assignment;
+    ComputeAssignment(scheduler, locations, &assignment);
+    map<string, int64_t> bytes_per_host;
+    FragmentScanRangeAssignment::const_iterator backend;
+    for (backend = assignment.begin(); backend != assignment.end(); ++backend) {
+      PerNodeScanRanges::const_iterator node = backend->second.find(0);
+      EXPECT_TRUE(node != backend->second.end());
+      for (int i = 0; i < node->second.size(); ++i) {
+        bytes_per_host[backend->first.hostname] +=
+            node->second[i].scan_range.hdfs_file_split.length;
+      }
+    }
+    return bytes_per_host;
+  }
+
+  // Replaces the membership of 'scheduler' with one backend on each of 127.0.0.0 and
+  // 127.0.0.1, which are executing the given numbers of fragments.
+  void SetBackendLoads(SimpleScheduler* scheduler, int fragments0, int fragments1) {
+    TTopicDelta delta;
+    delta.topic_name = SimpleScheduler::IMPALA_MEMBERSHIP_TOPIC;
+    delta.is_delta = false;
+    ThriftSerializer serializer(false);
+    for (int i = 0; i < 2; ++i) {
+      TBackendDescriptor backend;
+      stringstream ss;
+      ss << "127.0.0." << i;
+      backend.address = MakeNetworkAddress(ss.str(), base_port_);
+      backend.ip_address = ss.str();
+      backend.__set_num_fragments_in_flight(i == 0 ? fragments0 : fragments1);
+      TTopicItem item;
+      item.key = ss.str();
+      EXPECT_TRUE(serializer.Serialize(&backend, &item.value).ok());
+      delta.topic_entries.push_back(item);
+    }
+    StatestoreSubscriber::TopicDeltaMap deltas;
+    deltas[delta.topic_name] = delta;
+    vector<TTopicDelta> subscriber_topic_updates;
+    scheduler->UpdateMembership(deltas, &subscriber_topic_updates);
+  }
+
   int base_port_;
   int num_backends_;
 
@@ -190,10 +280,228 @@ TEST_F(SimpleSchedulerTest, InitPoolWhiteList) {
   options.__set_yarn_pool("Default");
   EXPECT_TRUE(sched->GetYarnPool("user", options, &pool).ok());
   EXPECT_TRUE(sched->GetYarnPool("admin", options, &pool).ok());
+
+  // Without resource management the whitelist does not restrict admission control.
+  options.__set_yarn_pool("prod");
+  EXPECT_TRUE(sched->GetRequestPool("user", options, &pool).ok());
+  EXPECT_EQ("prod", pool);
+  FLAGS_enable_rm = true;
+  EXPECT_FALSE(sched->GetRequestPool("user", options, &pool).ok());
+  FLAGS_enable_rm = false;
+
+  // Check the pool limits, including a malformed limit which falls back to the default.
+  const SimpleScheduler::PoolConfigMap& config_map = sched->pool_config_map();
+  EXPECT_EQ(3, config_map.size());
+  PoolConfig config;
+  sched->GetPoolConfig("prod", &config);
+  EXPECT_EQ(10, config.max_requests);
+  EXPECT_EQ(20, config.max_queued);
+  EXPECT_EQ(100L * 1024L * 1024L * 1024L, config.mem_limit);
+  sched->GetPoolConfig("Staging", &config);
+  EXPECT_EQ(2, config.max_requests);
+  EXPECT_EQ(-1, config.mem_limit);
+  sched->GetPoolConfig("dev", &config);
+  EXPECT_EQ(-1, config.max_requests);
+  sched->GetPoolConfig("not-configured", &config);
+  EXPECT_EQ(-1, config.max_requests);
+  EXPECT_EQ(-1, config.mem_limit);
+}
+
+TEST_F(SimpleSchedulerTest, InvalidDefaultPoolLimits) {
+  FLAGS_pool_conf_file = "";
+  FLAGS_enable_admission_control = true;
+  vector<TNetworkAddress> backends;
+  backends.push_back(TNetworkAddress());
+  // Only -1 is allowed as a negative number of queued queries.
+  FLAGS_default_pool_max_queued = -5;
+  scoped_ptr<SimpleScheduler> sched(new SimpleScheduler(backends, NULL, NULL, NULL));
+  EXPECT_FALSE(sched->Init().ok());
+  FLAGS_default_pool_max_queued = -1;
+  sched.reset(new SimpleScheduler(backends, NULL, NULL, NULL));
+  EXPECT_TRUE(sched->Init().ok());
+  FLAGS_default_pool_max_queued = 50;
+  FLAGS_enable_admission_control = false;
+}
+
+TEST_F(SimpleSchedulerTest, AdmissionControl) {
+  FLAGS_queue_wait_timeout_ms = 10;
+  AdmissionController controller(NULL, "test-backend", NULL);
+  EXPECT_TRUE(controller.Init().ok());
+  PoolConfig config;
+  config.max_requests = 2;
+  config.mem_limit = 1024;
+
+  TUniqueId query_id;
+  TQueryExecRequest request;
+  TQueryOptions options;
+  options.__set_mem_limit(400);
+  QuerySchedule schedule1(query_id, request, options, false);
+  QuerySchedule schedule2(query_id, request, options, false);
+  QuerySchedule schedule3(query_id, request, options, false);
+  EXPECT_TRUE(controller.AdmitQuery("pool", config, &schedule1).ok());
+  EXPECT_TRUE(schedule1.is_admitted());
+  EXPECT_TRUE(controller.AdmitQuery("pool", config, &schedule2).ok());
+  // Over the request limit, times out in the queue.
+  EXPECT_FALSE(controller.AdmitQuery("pool", config, &schedule3).ok());
+  EXPECT_FALSE(schedule3.is_admitted());
+
+  // Releasing one query makes room for another; other pools are unaffected.
+  controller.ReleaseQuery(&schedule1);
+  EXPECT_FALSE(schedule1.is_admitted());
+  EXPECT_TRUE(controller.AdmitQuery("pool", config, &schedule3).ok());
+  EXPECT_TRUE(controller.AdmitQuery("other-pool", config, &schedule1).ok());
+
+  // Memory limit: 2 * 400 bytes fit, a third query would exceed 1024 bytes.
+  config.max_requests = -1;
+  controller.ReleaseQuery(&schedule1);
+  EXPECT_TRUE(controller.AdmitQuery("other-pool", config, &schedule1).ok());
+  QuerySchedule schedule4(query_id, request, options, false);
+  EXPECT_TRUE(controller.AdmitQuery("other-pool", config, &schedule4).ok());
+  QuerySchedule schedule5(query_id, request, options, false);
+  EXPECT_FALSE(controller.AdmitQuery("other-pool", config, &schedule5).ok());
+
+  // A query that can never fit in the pool is rejected.
+  TQueryOptions large_options;
+  large_options.__set_mem_limit(2048);
+  QuerySchedule schedule6(query_id, request, large_options, false);
+  EXPECT_FALSE(controller.AdmitQuery("other-pool", config, &schedule6).ok());
+
+  // With max_queued = 0 a query that cannot be admitted is rejected right away.
+  config.max_queued = 0;
+  FLAGS_queue_wait_timeout_ms = 60 * 1000;
+  int64_t start_ms = ms_since_epoch();
+  EXPECT_FALSE(controller.AdmitQuery("other-pool", config, &schedule5).ok());
+  EXPECT_LT(ms_since_epoch() - start_ms, FLAGS_queue_wait_timeout_ms);
 }
 
+static void AdmitQueryThread(AdmissionController* controller, PoolConfig config,
+    QuerySchedule* schedule, Status* status) {
+  *status = controller->AdmitQuery("pool", config, schedule);
 }
 
+TEST_F(SimpleSchedulerTest, CancelQueuedQuery) {
+  FLAGS_queue_wait_timeout_ms = 60 * 1000;
+  AdmissionController controller(NULL, "test-backend", NULL);
+  EXPECT_TRUE(controller.Init().ok());
+  PoolConfig config;
+  config.max_requests = 1;
+
+  TUniqueId query_id;
+  TQueryExecRequest request;
+  TQueryOptions options;
+  QuerySchedule schedule1(query_id, request, options, false);
+  QuerySchedule schedule2(query_id, request, options, false);
+  EXPECT_TRUE(controller.AdmitQuery("pool", config, &schedule1).ok());
+
+  // schedule2 waits in the queue until it is cancelled, well before the timeout.
+  int64_t start_ms = ms_since_epoch();
+  Status status;
+  thread queued_thread(AdmitQueryThread, &controller, config, &schedule2, &status);
+  SleepForMs(100);
+  controller.CancelQuery(&schedule2);
+  queued_thread.join();
+  EXPECT_FALSE(status.ok());
+  EXPECT_FALSE(schedule2.is_admitted());
+  EXPECT_LT(ms_since_epoch() - start_ms, FLAGS_queue_wait_timeout_ms);
+
+  // The cancelled query left the queue: releasing schedule1 makes room for a new query,
+  // and cancelling an admitted query does nothing.
+  controller.ReleaseQuery(&schedule1);
+  QuerySchedule schedule3(query_id, request, options, false);
+  EXPECT_TRUE(controller.AdmitQuery("pool", config, &schedule3).ok());
+  controller.CancelQuery(&schedule3);
+  EXPECT_TRUE(schedule3.is_admitted());
+
+  // A query cancelled before it is submitted is never queued.
+  QuerySchedule schedule4(query_id, request, options, false);
+  controller.CancelQuery(&schedule4);
+  EXPECT_FALSE(controller.AdmitQuery("pool", config, &schedule4).ok());
+}
+
+TEST_F(SimpleSchedulerTest, CachedReplicaPreferred) {
+  // Without caching, the tie is broken in favour of the first replica.
+  vector<TScanRangeLocations> locations;
+  locations.push_back(MakeReplicatedScanRange(100));
+  map<string, int64_t> bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(100, bytes["127.0.0.0"]);
+
+  // The cached replica is read instead.
+  locations[0].locations[1].is_cached = true;
+  bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(0, bytes["127.0.0.0"]);
+  EXPECT_EQ(100, bytes["127.0.0.1"]);
+
+  // ...unless its host already has more than a range's worth of extra bytes assigned.
+  locations.clear();
+  TScanRangeLocations large_range = MakeScanRange(300);
+  AddReplica("127.0.0.1", 0, false, &large_range);
+  locations.push_back(large_range);
+  locations.push_back(MakeReplicatedScanRange(100));
+  locations[1].locations[1].is_cached = true;
+  bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(100, bytes["127.0.0.0"]);
+  EXPECT_EQ(300, bytes["127.0.0.1"]);
+}
+
+TEST_F(SimpleSchedulerTest, LargestRangesFirst) {
+  // In plan order, the ranges would be assigned 10 -> .0, 10 -> .1 and 20 -> .0.
+  vector<TScanRangeLocations> locations;
+  locations.push_back(MakeReplicatedScanRange(10));
+  locations.push_back(MakeReplicatedScanRange(10));
+  locations.push_back(MakeReplicatedScanRange(20));
+  map<string, int64_t> bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(20, bytes["127.0.0.0"]);
+  EXPECT_EQ(20, bytes["127.0.0.1"]);
+}
+
+TEST_F(SimpleSchedulerTest, DiskBalancing) {
+  // Both ranges only have replicas on 127.0.0.0, on disks 0 and 1. The second range
+  // goes to the less loaded disk.
+  vector<TScanRangeLocations> locations;
+  for (int i = 0; i < 2; ++i) {
+    locations.push_back(MakeScanRange(100));
+    AddReplica("127.0.0.0", 0, false, &locations.back());
+    AddReplica("127.0.0.0", 1, false, &locations.back());
+  }
+  FragmentScanRangeAssignment assignment;
+  ComputeAssignment(local_remote_scheduler_.get(), locations, &assignment);
+  set<int> volumes;
+  FragmentScanRangeAssignment::const_iterator backend;
+  for (backend = assignment.begin(); backend != assignment.end(); ++backend) {
+    const vector<TScanRangeParams>& params = backend->second.find(0)->second;
+    for (int i = 0; i < params.size(); ++i) volumes.insert(params[i].volume_id);
+  }
+  EXPECT_EQ(2, volumes.size());
+}
+
+TEST_F(SimpleSchedulerTest, LoadAwareAssignment) {
+  // 127.0.0.0 is executing 5 fragments, each of which counts as a range of the average
+  // length, so both ranges go to the idle backend.
+  SetBackendLoads(local_remote_scheduler_.get(), 5, 0);
+  vector<TScanRangeLocations> locations;
+  locations.push_back(MakeReplicatedScanRange(100));
+  locations.push_back(MakeReplicatedScanRange(100));
+  map<string, int64_t> bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(0, bytes["127.0.0.0"]);
+  EXPECT_EQ(200, bytes["127.0.0.1"]);
+
+  // With equal loads, the ranges are spread again.
+  SetBackendLoads(local_remote_scheduler_.get(), 1, 1);
+  bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(100, bytes["127.0.0.0"]);
+  EXPECT_EQ(100, bytes["127.0.0.1"]);
+
+  // Ranges without a local backend are read by the least loaded backend.
+  SetBackendLoads(local_remote_scheduler_.get(), 0, 5);
+  locations.clear();
+  locations.push_back(MakeScanRange(100));
+  AddReplica("10.0.0.1", 0, false, &locations.back());
+  bytes = AssignScanRanges(local_remote_scheduler_.get(), locations);
+  EXPECT_EQ(100, bytes["127.0.0.0"]);
+}
+
+}  // namespace impala
+
 int main(int argc, char **argv) {
   google::InitGoogleLogging(argv[0]);
   ::testing::InitGoogleTest(&argc, argv);
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
@@ -34,7 +35,11 @@
 #include "util/uid-util.h"
 #include "util/container-util.h"
 #include "util/debug-util.h"
+#include "util/impalad-metrics.h"
 #include "util/llama-util.h"
+#include "util/parse-util.h"
+#include "util/string-parser.h"
+#include "util/time.h"
 #include "gen-cpp/ResourceBrokerService_types.h"
 
 using namespace std;
@@ -47,14 +52,31 @@ DECLARE_string(hostname);
 DECLARE_bool(enable_rm);
 DEFINE_string(pool_conf_file, "", "The full path to the YARN user-to-pool "
     "configuration file");
+DEFINE_bool(enable_admission_control, false, "If true, queries are admitted, queued "
+    "or rejected based on the limits of their request pool.");
+DEFINE_int64(default_pool_max_requests, -1, "Maximum number of concurrently running "
+    "queries in a pool without configured limits. A value <= 0 means unlimited.");
+DEFINE_int64(default_pool_max_queued, 50, "Maximum number of queued queries in a "
+    "pool without configured limits. 0 means queries are never queued, -1 means "
+    "unlimited.");
+DEFINE_string(default_pool_mem_limit, "", "Maximum sum of the estimated memory of the "
+    "running queries in a pool without configured limits, across the cluster. "
+    "Specified as number of bytes ('<int>[bB]?'), megabytes ('<float>[mM]') or "
+    "gigabytes ('<float>[gG]'). Empty means unlimited.");
+DEFINE_int32(backend_load_update_interval_ms, 5000, "Minimum interval between two "
+    "updates of this backend's membership entry that only publish a change in the "
+    "number of fragments executing on it.");
 
 namespace impala {
 
 static const string LOCAL_ASSIGNMENTS_KEY("simple-scheduler.local-assignments.total");
 static const string ASSIGNMENTS_KEY("simple-scheduler.assignments.total");
+static const string CACHED_ASSIGNMENTS_KEY("simple-scheduler.cached-assignments.total");
+static const string ASSIGNMENT_SKEW_KEY("simple-scheduler.assignment-skew");
 static const string SCHEDULER_INIT_KEY("simple-scheduler.initialized");
 static const string NUM_BACKENDS_KEY("simple-scheduler.num-backends");
 static const string DEFAULT_USER("*");
+static const string DEFAULT_POOL("default-pool");
 
 const string SimpleScheduler::IMPALA_MEMBERSHIP_TOPIC("impala-membership");
 
@@ -69,8 +91,11 @@ SimpleScheduler::SimpleScheduler(StatestoreSubscriber* subscriber,
     thrift_serializer_(false),
     total_assignments_(NULL),
     total_local_assignments_(NULL),
+    total_cached_assignments_(NULL),
+    assignment_skew_(NULL),
     initialised_(NULL),
     update_count_(0),
+    last_load_update_ms_(0),
     resource_broker_(resource_broker) {
   backend_descriptor_.address = backend_address;
   next_nonlocal_backend_entry_ = backend_map_.begin();
@@ -84,8 +109,11 @@ SimpleScheduler::SimpleScheduler(const vector<TNetworkAddress>& backends,
     thrift_serializer_(false),
     total_assignments_(NULL),
     total_local_assignments_(NULL),
+    total_cached_assignments_(NULL),
+    assignment_skew_(NULL),
     initialised_(NULL),
     update_count_(0),
+    last_load_update_ms_(0),
     resource_broker_(resource_broker) {
   DCHECK(backends.size() > 0);
 
@@ -143,6 +171,10 @@ Status SimpleScheduler::Init() {
         metrics_->CreateAndRegisterPrimitiveMetric(ASSIGNMENTS_KEY, 0L);
     total_local_assignments_ =
         metrics_->CreateAndRegisterPrimitiveMetric(LOCAL_ASSIGNMENTS_KEY, 0L);
+    total_cached_assignments_ =
+        metrics_->CreateAndRegisterPrimitiveMetric(CACHED_ASSIGNMENTS_KEY, 0L);
+    assignment_skew_ =
+        metrics_->CreateAndRegisterPrimitiveMetric(ASSIGNMENT_SKEW_KEY, 0.0);
     initialised_ =
         metrics_->CreateAndRegisterPrimitiveMetric(SCHEDULER_INIT_KEY, true);
     num_backends_metric_ = metrics_->CreateAndRegisterPrimitiveMetric<int64_t>(
@@ -185,6 +217,26 @@ Status SimpleScheduler::Init() {
   if (!FLAGS_pool_conf_file.empty()) {
     RETURN_IF_ERROR(InitPoolWhitelist(FLAGS_pool_conf_file));
   }
+
+  if (FLAGS_enable_admission_control) {
+    bool is_percent;
+    if (ParseUtil::ParseMemSpec(FLAGS_default_pool_mem_limit, &is_percent) < 0 ||
+        is_percent) {
+      return Status("Failed to parse default pool mem limit from '" +
+          FLAGS_default_pool_mem_limit + "'.");
+    }
+    // Like the limits in the pool configuration file, -1 is the only negative value
+    // allowed for max_queued. Any value <= 0 for max_requests means unlimited.
+    if (FLAGS_default_pool_max_queued < PoolConfig::UNLIMITED_QUEUED) {
+      stringstream ss;
+      ss << "Invalid default pool max queued: " << FLAGS_default_pool_max_queued
+         << ". Must be >= 0, or -1 for unlimited.";
+      return Status(ss.str());
+    }
+    admission_controller_.reset(
+        new AdmissionController(statestore_subscriber_, backend_id_, metrics_));
+    RETURN_IF_ERROR(admission_controller_->Init());
+  }
   return Status::OK;
 }
 
@@ -277,12 +329,23 @@ void SimpleScheduler::UpdateMembership(
                                    << be_desc.address;
         }
 
+        // Backends republish their descriptor when their load changes; replace the
+        // previous version.
+        BackendIdMap::iterator existing = current_membership_.find(item.key);
+        if (existing != current_membership_.end()) {
+          list<TBackendDescriptor>* be_descs =
+              &backend_map_[existing->second.ip_address];
+          be_descs->erase(remove(be_descs->begin(), be_descs->end(), existing->second),
+              be_descs->end());
+          if (be_descs->empty()) backend_map_.erase(existing->second.ip_address);
+        }
+
         list<TBackendDescriptor>* be_descs = &backend_map_[be_desc.ip_address];
         if (find(be_descs->begin(), be_descs->end(), be_desc) == be_descs->end()) {
           backend_map_[be_desc.ip_address].push_back(be_desc);
         }
         backend_ip_map_[be_desc.address.hostname] = be_desc.ip_address;
-        current_membership_.insert(make_pair(item.key, be_desc));
+        current_membership_[item.key] = be_desc;
       }
       // Process deletions from the topic
       BOOST_FOREACH(const string& backend_id, delta.topic_deletions) {
@@ -300,9 +363,22 @@ void SimpleScheduler::UpdateMembership(
     }
 
     // If this impalad is not in our view of the membership list, we should add it and
-    // tell the statestore.
-    if (current_membership_.find(backend_id_) == current_membership_.end()) {
-      VLOG(1) << "Registering local backend with statestore";
+    // tell the statestore. Also republish our descriptor if the number of fragments
+    // executing here changed, so that other schedulers can take it into account. Load
+    // changes are published at most every --backend_load_update_interval_ms, so that
+    // short queries don't cause a topic update on every heartbeat.
+    int32_t num_fragments = 0;
+    if (ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT != NULL) {
+      num_fragments = ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT->value();
+    }
+    bool registered = current_membership_.find(backend_id_) != current_membership_.end();
+    int64_t now = ms_since_epoch();
+    bool publish_load = backend_descriptor_.num_fragments_in_flight != num_fragments &&
+        now - last_load_update_ms_ >= FLAGS_backend_load_update_interval_ms;
+    if (!registered || publish_load) {
+      if (!registered) VLOG(1) << "Registering local backend with statestore";
+      backend_descriptor_.__set_num_fragments_in_flight(num_fragments);
+      last_load_update_ms_ = now;
       subscriber_topic_updates->push_back(TTopicDelta());
       TTopicDelta& update = subscriber_topic_updates->back();
       update.topic_name = IMPALA_MEMBERSHIP_TOPIC;
@@ -340,18 +416,7 @@ Status SimpleScheduler::GetBackend(const TNetworkAddress& data_location,
     return Status("No backends configured");
   }
   bool local_assignment = false;
-  BackendMap::iterator entry = backend_map_.find(data_location.hostname);
-
-  if (entry == backend_map_.end()) {
-    // backend_map_ maps ip address to backend but
-    // data_location.hostname might be a hostname.
-    // Find the ip address of the data_location from backend_ip_map_.
-    BackendIpAddressMap::const_iterator itr =
-        backend_ip_map_.find(data_location.hostname);
-    if (itr != backend_ip_map_.end()) {
-      entry = backend_map_.find(itr->second);
-    }
-  }
+  BackendMap::iterator entry = FindBackends(data_location);
 
   if (entry == backend_map_.end()) {
     // round robin the ipaddress
@@ -386,6 +451,33 @@ Status SimpleScheduler::GetBackend(const TNetworkAddress& data_location,
   return Status::OK;
 }
 
+SimpleScheduler::BackendMap::iterator SimpleScheduler::FindBackends(
+    const TNetworkAddress& data_location) {
+  BackendMap::iterator entry = backend_map_.find(data_location.hostname);
+  if (entry == backend_map_.end()) {
+    // backend_map_ maps ip address to backend but
+    // data_location.hostname might be a hostname.
+    // Find the ip address of the data_location from backend_ip_map_.
+    BackendIpAddressMap::const_iterator itr =
+        backend_ip_map_.find(data_location.hostname);
+    if (itr != backend_ip_map_.end()) {
+      entry = backend_map_.find(itr->second);
+    }
+  }
+  return entry;
+}
+
+int SimpleScheduler::GetHostLoad(const TNetworkAddress& data_location) {
+  lock_guard<mutex> lock(backend_map_lock_);
+  BackendMap::iterator entry = FindBackends(data_location);
+  if (entry == backend_map_.end() || entry->second.empty()) return -1;
+  int load = 0;
+  BOOST_FOREACH(const TBackendDescriptor& backend, entry->second) {
+    load += backend.num_fragments_in_flight;
+  }
+  return load;
+}
+
 void SimpleScheduler::GetAllKnownBackends(BackendList* backends) {
   lock_guard<mutex> lock(backend_map_lock_);
   backends->clear();
@@ -413,58 +505,132 @@ Status SimpleScheduler::ComputeScanRangeAssignment(const TQueryExecRequest& exec
   return Status::OK;
 }
 
+// Returns the length in bytes of 'scan_range', or 0 if it is not an HDFS split.
+static int64_t GetScanRangeLength(const TScanRange& scan_range) {
+  if (!scan_range.__isset.hdfs_file_split) return 0;
+  return scan_range.hdfs_file_split.length;
+}
+
 Status SimpleScheduler::ComputeScanRangeAssignment(
     PlanNodeId node_id, const vector<TScanRangeLocations>& locations, bool exec_at_coord,
     FragmentScanRangeAssignment* assignment) {
-  // map from datanode host to total assigned bytes;
-  // If the data node does not have a collocated impalad, the actual assigned bytes is
-  // "total assigned - numeric_limits<int64_t>::max()".
-  unordered_map<TNetworkAddress, uint64_t> assigned_bytes_per_host;
+  if (locations.empty()) return Status::OK;
+
+  // Assign the scan ranges in decreasing order of length: placing the large ranges
+  // first and filling in with the small ones balances bytes much better than
+  // assigning them in plan order. Pairs of (-length, index) sort in that order.
+  vector<pair<int64_t, int> > ranges_by_length;
+  ranges_by_length.reserve(locations.size());
+  int64_t total_bytes = 0;
+  for (int i = 0; i < locations.size(); ++i) {
+    int64_t length = GetScanRangeLength(locations[i].scan_range);
+    total_bytes += length;
+    ranges_by_length.push_back(make_pair(-length, i));
+  }
+  sort(ranges_by_length.begin(), ranges_by_length.end());
+
+  // Every fragment that is already executing on a host is accounted for as one
+  // additional scan range of average length.
+  int64_t load_bytes_per_fragment = total_bytes / locations.size();
+
+  // Map from datanode host to total assigned bytes, including its load. Only contains
+  // hosts with a collocated impalad; all others are in remote_hosts.
+  unordered_map<TNetworkAddress, int64_t> assigned_bytes_per_host;
   unordered_set<TNetworkAddress> remote_hosts;
+  // Map from (datanode host, volume id) to the bytes assigned to that disk.
+  unordered_map<pair<TNetworkAddress, int>, int64_t> assigned_bytes_per_disk;
+  // Map from backend to total assigned bytes, including its load. Used to place the
+  // scan ranges that have to be read remotely.
+  unordered_map<TNetworkAddress, int64_t> assigned_bytes_per_backend;
+  // Bytes of this scan node assigned to each backend, used for the skew metric.
+  unordered_map<TNetworkAddress, int64_t> scan_bytes_per_backend;
+  if (!exec_at_coord) {
+    BackendList backends;
+    GetAllKnownBackends(&backends);
+    BOOST_FOREACH(const TBackendDescriptor& backend, backends) {
+      assigned_bytes_per_backend[backend.address] =
+          backend.num_fragments_in_flight * load_bytes_per_fragment;
+    }
+  }
+
   int64_t remote_bytes = 0L;
   int64_t local_bytes = 0L;
-  BOOST_FOREACH(const TScanRangeLocations& scan_range_locations, locations) {
-    // assign this scan range to the host w/ the fewest assigned bytes
-    uint64_t min_assigned_bytes = numeric_limits<uint64_t>::max();
-    const TNetworkAddress* data_host = NULL;  // data server; not necessarily backend
-    int volume_id = -1;
-    BOOST_FOREACH(const TScanRangeLocation& location, scan_range_locations.locations) {
-      // Deprioritize non-collocated datanodes by assigning a very high initial bytes
-      uint64_t initial_bytes =
-          (!HasLocalBackend(location.server)) ? numeric_limits<int64_t>::max() : 0L;
-      uint64_t* assigned_bytes =
-          FindOrInsert(&assigned_bytes_per_host, location.server, initial_bytes);
-      if (*assigned_bytes < min_assigned_bytes) {
-        min_assigned_bytes = *assigned_bytes;
-        data_host = &location.server;
-        volume_id = location.volume_id;
+  for (int i = 0; i < ranges_by_length.size(); ++i) {
+    const TScanRangeLocations& scan_range_locations =
+        locations[ranges_by_length[i].second];
+    int64_t scan_range_length = -ranges_by_length[i].first;
+
+    // Pick the replica on a host with a collocated impalad with the lowest cost.
+    const TScanRangeLocation* location = NULL;
+    int64_t min_cost = numeric_limits<int64_t>::max();
+    int64_t min_disk_bytes = numeric_limits<int64_t>::max();
+    BOOST_FOREACH(const TScanRangeLocation& replica, scan_range_locations.locations) {
+      unordered_map<TNetworkAddress, int64_t>::iterator host_bytes =
+          assigned_bytes_per_host.find(replica.server);
+      if (host_bytes == assigned_bytes_per_host.end()) {
+        if (remote_hosts.find(replica.server) != remote_hosts.end()) continue;
+        int load = GetHostLoad(replica.server);
+        if (load < 0) {
+          remote_hosts.insert(replica.server);
+          continue;
+        }
+        host_bytes = assigned_bytes_per_host.insert(
+            make_pair(replica.server, load * load_bytes_per_fragment)).first;
+      }
+      // Reading a cached replica is much cheaper than reading from disk, so a cached
+      // replica is chosen unless its host already has this range's worth of bytes more
+      // assigned than the alternative.
+      int64_t cost = host_bytes->second;
+      if (replica.is_cached) cost -= scan_range_length;
+      int64_t disk_bytes =
+          assigned_bytes_per_disk[make_pair(replica.server, replica.volume_id)];
+      if (cost < min_cost || (cost == min_cost && disk_bytes < min_disk_bytes)) {
+        location = &replica;
+        min_cost = cost;
+        min_disk_bytes = disk_bytes;
       }
     }
 
-    int64_t scan_range_length = 0;
-    if (scan_range_locations.scan_range.__isset.hdfs_file_split) {
-      scan_range_length = scan_range_locations.scan_range.hdfs_file_split.length;
-    }
-    bool remote_read = min_assigned_bytes >= numeric_limits<int64_t>::max();
-    if (remote_read) {
-      remote_bytes += scan_range_length;
-      remote_hosts.insert(*data_host);
-    } else {
+    bool remote_read = location == NULL;
+    int volume_id = -1;
+    if (!remote_read) {
       local_bytes += scan_range_length;
+      assigned_bytes_per_host[location->server] += scan_range_length;
+      assigned_bytes_per_disk[make_pair(location->server, location->volume_id)] +=
+          scan_range_length;
+      volume_id = location->volume_id;
+      if (location->is_cached && total_cached_assignments_ != NULL) {
+        total_cached_assignments_->Increment(1L);
+      }
+    } else {
+      remote_bytes += scan_range_length;
+      DCHECK(!scan_range_locations.locations.empty());
+      volume_id = scan_range_locations.locations[0].volume_id;
     }
-    assigned_bytes_per_host[*data_host] += scan_range_length;
-
-    // translate data host to backend host
-    DCHECK(data_host != NULL);
 
     TNetworkAddress exec_hostport;
-    if (!exec_at_coord) {
+    if (exec_at_coord) {
+      exec_hostport = MakeNetworkAddress(FLAGS_hostname, FLAGS_be_port);
+    } else if (!remote_read) {
+      // translate data host to backend host
       TBackendDescriptor backend;
-      RETURN_IF_ERROR(GetBackend(*data_host, &backend));
+      RETURN_IF_ERROR(GetBackend(location->server, &backend));
       exec_hostport = backend.address;
     } else {
-      exec_hostport = MakeNetworkAddress(FLAGS_hostname, FLAGS_be_port);
+      // Read remotely from the backend with the fewest assigned bytes.
+      if (assigned_bytes_per_backend.empty()) return Status("No backends configured");
+      unordered_map<TNetworkAddress, int64_t>::const_iterator min_backend =
+          assigned_bytes_per_backend.begin();
+      unordered_map<TNetworkAddress, int64_t>::const_iterator it;
+      for (it = assigned_bytes_per_backend.begin();
+          it != assigned_bytes_per_backend.end(); ++it) {
+        if (it->second < min_backend->second) min_backend = it;
+      }
+      exec_hostport = min_backend->first;
+      if (metrics_ != NULL) total_assignments_->Increment(1L);
     }
+    if (!exec_at_coord) assigned_bytes_per_backend[exec_hostport] += scan_range_length;
+    scan_bytes_per_backend[exec_hostport] += scan_range_length;
 
     PerNodeScanRanges* scan_ranges =
         FindOrInsert(assignment, exec_hostport, PerNodeScanRanges());
@@ -478,11 +644,25 @@ Status SimpleScheduler::ComputeScanRangeAssignment(
     scan_range_params_list->push_back(scan_range_params);
   }
 
+  // Skew is the ratio of the largest to the average number of bytes per backend that
+  // was assigned any scan ranges; 1.0 means perfectly balanced.
+  double skew = 1.0;
+  if (total_bytes > 0) {
+    int64_t max_bytes = 0;
+    unordered_map<TNetworkAddress, int64_t>::const_iterator it;
+    for (it = scan_bytes_per_backend.begin(); it != scan_bytes_per_backend.end(); ++it) {
+      max_bytes = max(max_bytes, it->second);
+    }
+    skew = max_bytes * scan_bytes_per_backend.size() / static_cast<double>(total_bytes);
+  }
+  if (assignment_skew_ != NULL && !exec_at_coord) assignment_skew_->Update(skew);
+
   if (VLOG_FILE_IS_ON) {
     VLOG_FILE << "Total remote scan volume = " <<
         PrettyPrinter::Print(remote_bytes, TCounterType::BYTES);
     VLOG_FILE << "Total local scan volume = " <<
         PrettyPrinter::Print(local_bytes, TCounterType::BYTES);
+    VLOG_FILE << "Scan range assignment skew = " << skew;
     if (remote_hosts.size() > 0) {
       stringstream remote_node_log;
       remote_node_log << "Remote data node list: ";
@@ -703,19 +883,25 @@ Status SimpleScheduler::InitPoolWhitelist(const string& conf_path) {
     return Status(err_msg.str());
   }
 
-  // Each line is user: pool1, pool2
+  // Lines in the [users] section are 'user: pool1, pool2', lines in the [limits] section
+  // are 'pool: max_requests=N, max_queued=N, mem_limit=<mem spec>'.
   string line;
   bool in_user_section = false;
+  bool in_limits_section = false;
   while (getline(whitelist, line)) {
     trim(line);
     if (line.empty()) continue;
-    if (line == "[users]") {
-      in_user_section = true;
-    } else if (line.size() > 2 && line[0] == '[' && line[line.size() - 1] == ']') {
+    if (line.size() > 2 && line[0] == '[' && line[line.size() - 1] == ']') {
       // Headers are '[header name]'
-      in_user_section = false;
+      in_user_section = (line == "[users]");
+      in_limits_section = (line == "[limits]");
+      continue;
     }
 
+    if (in_limits_section) {
+      ParsePoolLimits(line, conf_path);
+      continue;
+    }
     if (!in_user_section) continue;
 
     size_t colon_pos = line.find_first_of(":");
@@ -765,10 +951,104 @@ Status SimpleScheduler::InitPoolWhitelist(const string& conf_path) {
   return Status::OK;
 }
 
+void SimpleScheduler::ParsePoolLimits(const string& line, const string& conf_path) {
+  size_t colon_pos = line.find_first_of(":");
+  string pool = line.substr(0, colon_pos);
+  trim(pool);
+  if (colon_pos == string::npos || pool.empty()) {
+    LOG(WARNING) << "Could not read line: " << line << " in pool configuration "
+                 << conf_path << ", ignoring.";
+    return;
+  }
+
+  PoolConfig pool_config;
+  GetPoolConfig(DEFAULT_POOL, &pool_config);
+  string limits_str = line.substr(colon_pos + 1);
+  vector<string> limits;
+  split(limits, limits_str, is_any_of(","));
+  BOOST_FOREACH(string& limit, limits) {
+    trim(limit);
+    if (limit.empty()) continue;
+    size_t eq_pos = limit.find_first_of("=");
+    if (eq_pos == string::npos) {
+      LOG(WARNING) << "Could not read limit: " << limit << " for pool: " << pool
+                   << " in pool configuration " << conf_path << ", ignoring.";
+      continue;
+    }
+    string name = limit.substr(0, eq_pos);
+    string value = limit.substr(eq_pos + 1);
+    trim(name);
+    trim(value);
+    bool is_percent;
+    int64_t parsed_value = -1;
+    bool valid = false;
+    if (name == "mem_limit") {
+      parsed_value = ParseUtil::ParseMemSpec(value, &is_percent);
+      valid = parsed_value >= 0 && !is_percent;
+    } else if (name == "max_requests" || name == "max_queued") {
+      StringParser::ParseResult result;
+      parsed_value =
+          StringParser::StringToInt<int64_t>(value.c_str(), value.size(), &result);
+      valid = result == StringParser::PARSE_SUCCESS && (parsed_value >= 0 ||
+          (name == "max_queued" && parsed_value == PoolConfig::UNLIMITED_QUEUED));
+    }
+    if (!valid) {
+      LOG(WARNING) << "Invalid limit: " << limit << " for pool: " << pool
+                   << " in pool configuration " << conf_path << ", ignoring.";
+      continue;
+    }
+    if (name == "max_requests") {
+      pool_config.max_requests = parsed_value;
+    } else if (name == "max_queued") {
+      pool_config.max_queued = parsed_value;
+    } else {
+      pool_config.mem_limit = parsed_value;
+    }
+  }
+  pool_configs_[pool] = pool_config;
+}
+
+Status SimpleScheduler::GetRequestPool(const string& user,
+    const TQueryOptions& query_options, string* pool) const {
+  // The whitelist only restricts the pools of users if resource management is enabled.
+  if (FLAGS_enable_rm && !user_pool_whitelist_.empty()) {
+    return GetYarnPool(user, query_options, pool);
+  }
+  if (query_options.__isset.yarn_pool && !query_options.yarn_pool.empty()) {
+    *pool = query_options.yarn_pool;
+  } else {
+    *pool = DEFAULT_POOL;
+  }
+  return Status::OK;
+}
+
+void SimpleScheduler::GetPoolConfig(const string& pool, PoolConfig* pool_config) const {
+  PoolConfigMap::const_iterator it = pool_configs_.find(pool);
+  if (it != pool_configs_.end()) {
+    *pool_config = it->second;
+    return;
+  }
+  bool is_percent;
+  pool_config->max_requests = FLAGS_default_pool_max_requests;
+  pool_config->max_queued = FLAGS_default_pool_max_queued;
+  pool_config->mem_limit = ParseUtil::ParseMemSpec(FLAGS_default_pool_mem_limit,
+      &is_percent);
+  // ParseMemSpec() returns 0 for an empty spec, which means unlimited.
+  if (pool_config->mem_limit == 0) pool_config->mem_limit = -1;
+}
+
 Status SimpleScheduler::Schedule(Coordinator* coord, QuerySchedule* schedule) {
   RETURN_IF_ERROR(ComputeScanRangeAssignment(schedule->request(), schedule));
   ComputeFragmentHosts(schedule->request(), schedule);
   ComputeFragmentExecParams(schedule->request(), schedule);
+  if (admission_controller_ != NULL) {
+    const string& user = schedule->request().query_ctxt.session.connected_user;
+    string pool;
+    RETURN_IF_ERROR(GetRequestPool(user, schedule->query_options(), &pool));
+    PoolConfig pool_config;
+    GetPoolConfig(pool, &pool_config);
+    RETURN_IF_ERROR(admission_controller_->AdmitQuery(pool, pool_config, schedule));
+  }
   if (!FLAGS_enable_rm) return Status::OK;
   // TODO: Should this take impersonation into account?
   const string& user = schedule->request().query_ctxt.session.connected_user;
@@ -794,7 +1074,12 @@ Status SimpleScheduler::Schedule(Coordinator* coord, QuerySchedule* schedule) {
   return Status::OK;
 }
 
+void SimpleScheduler::Cancel(QuerySchedule* schedule) {
+  if (admission_controller_ != NULL) admission_controller_->CancelQuery(schedule);
+}
+
 Status SimpleScheduler::Release(QuerySchedule* schedule) {
+  if (admission_controller_ != NULL) admission_controller_->ReleaseQuery(schedule);
   if (FLAGS_enable_rm && schedule->NeedsRelease()) {
     DCHECK(resource_broker_ != NULL);
     TResourceBrokerReleaseRequest request;
@@ -20,9 +20,11 @@
 #include <string>
 #include <list>
 #include <boost/unordered_map.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "common/status.h"
+#include "statestore/admission-controller.h"
 #include "statestore/scheduler.h"
 #include "statestore/statestore-subscriber.h"
 #include "statestore/statestore.h"
@@ -40,7 +42,6 @@ class Coordinator;
 // of target data locations.
 //
 // TODO: Notice when there are duplicate statestore registrations (IMPALA-23)
-// TODO: Handle deltas from the statestore
 class SimpleScheduler : public Scheduler {
  public:
   static const std::string IMPALA_MEMBERSHIP_TOPIC;
@@ -86,6 +87,7 @@ class SimpleScheduler : public Scheduler {
 
   virtual Status Schedule(Coordinator* coord, QuerySchedule* schedule);
   virtual Status Release(QuerySchedule* schedule);
+  virtual void Cancel(QuerySchedule* schedule);
   virtual void HandlePreemptedReservation(const TUniqueId& reservation_id);
   virtual void HandlePreemptedResource(const TUniqueId& client_resource_id);
   virtual void HandleLostResource(const TUniqueId& client_resource_id);
@@ -93,8 +95,12 @@ class SimpleScheduler : public Scheduler {
   // Map form a user ID to a list of pools they are allowed to submit work to
   typedef boost::unordered_map<std::string, std::vector<std::string> > UserPoolMap;
 
+  // Map from a pool name to its admission control limits
+  typedef boost::unordered_map<std::string, PoolConfig> PoolConfigMap;
+
   // Used for testing, to confirm correct parsing of the configuration file
   const UserPoolMap& user_pool_map() const { return user_pool_whitelist_; }
+  const PoolConfigMap& pool_config_map() const { return pool_configs_; }
 
   // Determines the pool for a user, given a set of query options and any configuration
   // loaded from a file. Returns the first pool from all pools configured for a user. Does
@@ -103,7 +109,22 @@ class SimpleScheduler : public Scheduler {
   Status GetYarnPool(const std::string& user,
       const TQueryOptions& query_options, std::string* pool) const;
 
+  // Determines the pool used for admission control of a request. If resource
+  // management is enabled and a pool configuration file was loaded this is the same as
+  // GetYarnPool(), otherwise it is query_options.yarn_pool if set and the default pool
+  // if not.
+  // Public only for testing.
+  Status GetRequestPool(const std::string& user,
+      const TQueryOptions& query_options, std::string* pool) const;
+
+  // Returns the admission limits of 'pool', as configured in the [limits] section of
+  // the pool configuration file, falling back to the --default_pool_* flags.
+  // Public only for testing.
+  void GetPoolConfig(const std::string& pool, PoolConfig* pool_config) const;
+
  private:
+  friend class SimpleSchedulerTest;
+
   // Protects access to backend_map_ and backend_ip_map_, which might otherwise be updated
   // asynchronously with respect to reads. Also protects the locality
   // counters, which are updated in GetBackends.
@@ -151,6 +172,11 @@ class SimpleScheduler : public Scheduler {
   // Locality metrics
   Metrics::IntMetric* total_assignments_;
   Metrics::IntMetric* total_local_assignments_;
+  Metrics::IntMetric* total_cached_assignments_;
+
+  // Ratio of the maximum to the average number of bytes assigned to a backend, for
+  // the most recently scheduled scan node.
+  Metrics::DoubleMetric* assignment_skew_;
 
   // Initialisation metric
   Metrics::BooleanMetric* initialised_;
@@ -159,6 +185,10 @@ class SimpleScheduler : public Scheduler {
   // Counts the number of UpdateMembership invocations, to help throttle the logging.
   uint32_t update_count_;
 
+  // Time, in ms since the epoch, at which backend_descriptor_ was last published to the
+  // membership topic. Only accessed from UpdateMembership().
+  int64_t last_load_update_ms_;
+
   // Protects active_reservations_ and active_client_resources_.
   boost::mutex active_resources_lock_;
 
@@ -186,6 +216,13 @@ class SimpleScheduler : public Scheduler {
   // Default pools read from the whitelist, accessible to all users.
   std::set<std::string> default_pools_;
 
+  // Per-pool admission limits read from the [limits] section of the configuration file.
+  PoolConfigMap pool_configs_;
+
+  // Admits, queues or rejects queries based on the limits of their pool. Set in Init()
+  // unless admission control is disabled.
+  boost::scoped_ptr<AdmissionController> admission_controller_;
+
   // Adds the granted reservation and resources to the active_reservations_ and
   // active_client_resources_ maps, respectively.
   void AddToActiveResourceMaps(
@@ -200,13 +237,28 @@ class SimpleScheduler : public Scheduler {
   void UpdateMembership(const StatestoreSubscriber::TopicDeltaMap& incoming_topic_deltas,
       std::vector<TTopicDelta>* subscriber_topic_updates);
 
+  // Returns the entry in backend_map_ of the backends running on the host of
+  // 'data_location', or backend_map_.end() if there are none.
+  // Caller must hold backend_map_lock_.
+  BackendMap::iterator FindBackends(const TNetworkAddress& data_location);
+
+  // Returns the number of fragments executing on the backends running on the host of
+  // 'data_location', or -1 if there is no backend on that host.
+  int GetHostLoad(const TNetworkAddress& data_location);
+
   // Webserver callback that prints a list of known backends
   void BackendsPathHandler(const Webserver::ArgumentMap& args, std::stringstream* output);
 
   // Loads the list of permissible pools from the provided configuration file, failing if
-  // there is an error or the file can't be found.
+  // there is an error or the file can't be found. Also loads the admission limits of
+  // each pool from the [limits] section, if present.
   Status InitPoolWhitelist(const std::string& conf_path);
 
+  // Parses a single line of the [limits] section, of the form
+  // 'pool: max_requests=N, max_queued=N, mem_limit=<mem spec>', into pool_configs_.
+  // Malformed lines are logged and ignored.
+  void ParsePoolLimits(const std::string& line, const std::string& conf_path);
+
   // Computes the assignment of scan ranges to hosts for each scan node in schedule.
   // Unpartitioned fragments are assigned to the coord. Populates the schedule's
   // fragment_exec_params_ with the resulting scan range assignment.
@@ -215,6 +267,12 @@ class SimpleScheduler : public Scheduler {
 
   // Does a scan range assignment (returned in 'assignment') based on a list of scan
   // range locations for a particular scan node.
+  // Scan ranges are assigned greedily in decreasing order of length to the replica
+  // whose host has the fewest assigned bytes, where the fragments already executing on
+  // a host (as published in the membership topic) count as bytes, cached replicas are
+  // preferred and ties are broken by the bytes assigned to the replica's disk. Ranges
+  // without a replica on a host with an impalad are assigned to the backend with the
+  // fewest assigned bytes.
   // If exec_at_coord is true, all scan ranges will be assigned to the coord node.
   Status ComputeScanRangeAssignment(PlanNodeId node_id,
       const std::vector<TScanRangeLocations>& locations, bool exec_at_coord,
@@ -21,6 +21,7 @@
 #include <boost/foreach.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <snappy.h>
 
 #include "common/logging.h"
 #include "common/status.h"
@@ -54,6 +55,38 @@ const int32_t SLEEP_INTERVAL_MS = 5000;
 
 typedef ClientConnection<StatestoreServiceClient> StatestoreConnection;
 
+// Returns true if any topic entry in 'topic_deltas' has a compressed value.
+static bool HasCompressedEntries(
+    const StatestoreSubscriber::TopicDeltaMap& topic_deltas) {
+  BOOST_FOREACH(const StatestoreSubscriber::TopicDeltaMap::value_type& delta,
+      topic_deltas) {
+    BOOST_FOREACH(const TTopicItem& item, delta.second.topic_entries) {
+      if (item.__isset.is_compressed && item.is_compressed) return true;
+    }
+  }
+  return false;
+}
+
+// Replaces the value of each compressed topic entry in 'topic_deltas' with its
+// uncompressed value.
+static Status DecompressTopicDeltas(StatestoreSubscriber::TopicDeltaMap* topic_deltas) {
+  BOOST_FOREACH(StatestoreSubscriber::TopicDeltaMap::value_type& delta, *topic_deltas) {
+    BOOST_FOREACH(TTopicItem& item, delta.second.topic_entries) {
+      if (!item.__isset.is_compressed || !item.is_compressed) continue;
+      string uncompressed;
+      if (!snappy::Uncompress(item.value.data(), item.value.size(), &uncompressed)) {
+        stringstream ss;
+        ss << "Could not decompress value of topic entry '" << item.key << "' in topic '"
+           << delta.first << "'";
+        return Status(ss.str());
+      }
+      item.value.swap(uncompressed);
+      item.__set_is_compressed(false);
+    }
+  }
+  return Status::OK;
+}
+
 // Proxy class for the subscriber heartbeat thrift API, which
 // translates RPCs into method calls on the local subscriber object.
 class StatestoreSubscriberThriftIf : public StatestoreSubscriberIf {
@@ -67,10 +100,36 @@ class StatestoreSubscriberThriftIf : public StatestoreSubscriberIf {
       registration_id = params.registration_id;
     }
 
-    subscriber_->UpdateState(params.topic_deltas, registration_id,
+    // Most updates carry no compressed values, so the deltas are only copied when some
+    // need to be decompressed.
+    const StatestoreSubscriber::TopicDeltaMap* topic_deltas = &params.topic_deltas;
+    StatestoreSubscriber::TopicDeltaMap decompressed_deltas;
+    if (HasCompressedEntries(params.topic_deltas)) {
+      decompressed_deltas = params.topic_deltas;
+      Status status = DecompressTopicDeltas(&decompressed_deltas);
+      if (!status.ok()) {
+        status.ToThrift(&response.status);
+        return;
+      }
+      topic_deltas = &decompressed_deltas;
+    }
+    subscriber_->UpdateState(*topic_deltas, registration_id,
         &response.topic_updates).ToThrift(&response.status);
   }
 
+  virtual void Heartbeat(THeartbeatResponse& response,
+                         const THeartbeatRequest& params) {
+    TUniqueId registration_id;
+    if (params.__isset.registration_id) {
+      registration_id = params.registration_id;
+    }
+    Status status = subscriber_->Heartbeat(registration_id);
+    if (!status.ok()) {
+      status.ToThrift(&response.status);
+      response.__isset.status = true;
+    }
+  }
+
  private:
   StatestoreSubscriber* subscriber_;
 };
@@ -247,23 +306,8 @@ Status StatestoreSubscriber::UpdateState(const TopicDeltaMap& incoming_topic_del
   // if we're in recovery mode we don't want to process the update.
   try_mutex::scoped_try_lock l(lock_);
   if (l) {
-    {
-      lock_guard<mutex> r(registration_id_lock_);
-      // If this subscriber has just started, the registration_id_ may not have been set
-      // despite the statestore starting to send updates. The 'unset' TUniqueId is 0:0,
-      // so we can differentiate between a) an early UpdateState() from an eager
-      // statestore, and b) an UpdateState() that's targeted to a previous registration.
-      if (registration_id_ != TUniqueId() && registration_id != registration_id_) {
-        stringstream ss;
-        ss << "Unexpected registration ID: " << PrintId(registration_id)
-           << ", was expecting: " << registration_id_;
-        return Status(ss.str());
-      }
-    }
+    RETURN_IF_ERROR(CheckRegistrationId(registration_id));
 
-    // Only record heartbeats received when not in recovery mode
-    heartbeat_interval_metric_->Update(
-        heartbeat_interval_timer_.Reset() / (1000.0 * 1000.0 * 1000.0));
     MonotonicStopWatch sw;
     sw.Start();
 
@@ -313,5 +357,32 @@ Status StatestoreSubscriber::UpdateState(const TopicDeltaMap& incoming_topic_del
   }
 }
 
+Status StatestoreSubscriber::Heartbeat(const TUniqueId& registration_id) {
+  RETURN_IF_ERROR(CheckRegistrationId(registration_id));
+  failure_detector_->UpdateHeartbeat(STATESTORE_ID, true);
+  // Only record heartbeats received when not in recovery mode
+  try_mutex::scoped_try_lock l(lock_);
+  if (l) {
+    heartbeat_interval_metric_->Update(
+        heartbeat_interval_timer_.Reset() / (1000.0 * 1000.0 * 1000.0));
+  }
+  return Status::OK;
+}
+
+Status StatestoreSubscriber::CheckRegistrationId(const TUniqueId& registration_id) {
+  lock_guard<mutex> r(registration_id_lock_);
+  // If this subscriber has just started, the registration_id_ may not have been set
+  // despite the statestore starting to send messages. The 'unset' TUniqueId is 0:0,
+  // so we can differentiate between a) an early message from an eager statestore, and
+  // b) a message that's targeted to a previous registration.
+  if (registration_id_ != TUniqueId() && registration_id != registration_id_) {
+    stringstream ss;
+    ss << "Unexpected registration ID: " << PrintId(registration_id)
+       << ", was expecting: " << registration_id_;
+    return Status(ss.str());
+  }
+  return Status::OK;
+}
+
 
 }
@@ -42,10 +42,12 @@ class ThriftServer;
 typedef ClientCache<StatestoreServiceClient> StatestoreClientCache;
 
 // A StatestoreSubscriber communicates with a statestore periodically
-// through the exchange of heartbeat messages. These messages contain
+// through the exchange of topic update messages. These messages contain
 // updates from the statestore to a list of 'topics' that the
 // subscriber is interested in; in response the subscriber sends a
-// list of changes that it wishes to make to a topic.
+// list of changes that it wishes to make to a topic. The statestore
+// also sends separate, more frequent heartbeat messages which carry no
+// topic data and are only used for failure detection.
 //
 // Clients of the subscriber register topics of interest, and a
 // function to call once an update has been received. Each callback
@@ -201,17 +203,18 @@ class StatestoreSubscriber {
   // Tracks the time between heartbeats
   MonotonicStopWatch heartbeat_interval_timer_;
 
-  // Accumulated statistics on the time taken to process each heartbeat from the
+  // Accumulated statistics on the time taken to process each topic update from the
   // statestore (that is, to call all callbacks)
   StatsMetric<double>* heartbeat_duration_metric_;
 
   // Current registration ID, in string form.
   Metrics::StringMetric* registration_id_metric_;
 
-  // Subscriber thrift implementation, needs to access UpdateState
+  // Subscriber thrift implementation, needs to access UpdateState and Heartbeat
   friend class StatestoreSubscriberThriftIf;
+  friend class StatestoreTest;
 
-  // Called when the statestore sends a heartbeat. Each registered callback is called
+  // Called when the statestore sends a topic update. Each registered callback is called
   // in turn with the given map of incoming_topic_deltas from the statestore. Each
   // TTopicDelta sent from the statestore to the subscriber will contain the topic name,
   // a list of additions to the topic, a list of deletions from the topic, and the
@@ -230,6 +233,15 @@ class StatestoreSubscriber {
       const TUniqueId& registration_id,
       std::vector<TTopicDelta>* subscriber_topic_updates);
 
+  // Called when the statestore sends a heartbeat. Marks the statestore as live in the
+  // failure detector, unless the heartbeat is for a previous registration of this
+  // subscriber, in which case an error is returned.
+  Status Heartbeat(const TUniqueId& registration_id);
+
+  // Returns an error if 'registration_id' is set and is not the current registration
+  // of this subscriber. Takes registration_id_lock_.
+  Status CheckRegistrationId(const TUniqueId& registration_id);
+
   // Run in a separate thread. In a loop, check failure_detector_ to see if the
   // statestore is still sending heartbeats. If not, enter 'recovery mode'
   // where a reconnection is repeatedly attempted. Once reconnected, all
@@ -15,7 +15,14 @@
 #include "testutil/in-process-servers.h"
 
 #include <gtest/gtest.h>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "common/init.h"
+#include "statestore/statestore-subscriber.h"
+#include "util/metrics.h"
+#include "util/network-util.h"
+#include "util/time.h"
 
 using namespace boost;
 using namespace std;
@@ -23,6 +30,7 @@ using namespace impala;
 
 DECLARE_int32(webserver_port);
 DECLARE_int32(state_store_port);
+DECLARE_int32(statestore_compression_threshold_bytes);
 
 namespace impala {
 
@@ -36,6 +44,133 @@ TEST(StatestoreTest, SmokeTest) {
   ASSERT_FALSE(statestore_wont_start->Start().ok());
 }
 
+static const string TEST_TOPIC("test-topic");
+
+class StatestoreTest : public testing::Test {
+ protected:
+  // Starts a subscriber to TEST_TOPIC of the statestore on 'statestore_port', whose
+  // heartbeat service listens on 'port'. Returns NULL on failure.
+  StatestoreSubscriber* StartSubscriber(const string& id, int port, int statestore_port,
+      const StatestoreSubscriber::UpdateCallback& callback) {
+    metrics_.push_back(new Metrics());
+    StatestoreSubscriber* subscriber = new StatestoreSubscriber(id,
+        MakeNetworkAddress("localhost", port),
+        MakeNetworkAddress("localhost", statestore_port), metrics_.back());
+    if (!subscriber->AddTopic(TEST_TOPIC, true, callback).ok()) return NULL;
+    if (!subscriber->Start().ok()) return NULL;
+    return subscriber;
+  }
+
+  Status Heartbeat(StatestoreSubscriber* subscriber, const TUniqueId& registration_id) {
+    return subscriber->Heartbeat(registration_id);
+  }
+
+  TUniqueId RegistrationId(StatestoreSubscriber* subscriber) {
+    lock_guard<mutex> l(subscriber->registration_id_lock_);
+    return subscriber->registration_id_;
+  }
+
+  // Never freed: subscribers can't be stopped, so they and their metrics outlive the
+  // tests.
+  vector<Metrics*> metrics_;
+};
+
+// Topic callback that publishes 'value' under 'key'.
+static void PublishEntry(const string& key, const string& value,
+    const StatestoreSubscriber::TopicDeltaMap& deltas, vector<TTopicDelta>* updates) {
+  updates->push_back(TTopicDelta());
+  updates->back().topic_name = TEST_TOPIC;
+  updates->back().topic_entries.push_back(TTopicItem());
+  updates->back().topic_entries.back().key = key;
+  updates->back().topic_entries.back().value = value;
+}
+
+// Records the entries received for TEST_TOPIC.
+struct ReceivedEntries {
+  mutex lock;
+  map<string, TTopicItem> entries;
+
+  void Update(const StatestoreSubscriber::TopicDeltaMap& deltas,
+      vector<TTopicDelta>* updates) {
+    StatestoreSubscriber::TopicDeltaMap::const_iterator delta = deltas.find(TEST_TOPIC);
+    if (delta == deltas.end()) return;
+    lock_guard<mutex> l(lock);
+    for (int i = 0; i < delta->second.topic_entries.size(); ++i) {
+      const TTopicItem& item = delta->second.topic_entries[i];
+      entries[item.key] = item;
+    }
+  }
+
+  // Waits up to 10s for 'key' to be received; returns false if it wasn't.
+  bool WaitFor(const string& key, TTopicItem* item) {
+    for (int i = 0; i < 100; ++i) {
+      {
+        lock_guard<mutex> l(lock);
+        if (entries.find(key) != entries.end()) {
+          *item = entries[key];
+          return true;
+        }
+      }
+      SleepForMs(100);
+    }
+    return false;
+  }
+};
+
+TEST_F(StatestoreTest, CompressedTopicEntries) {
+  int statestore_port = FLAGS_state_store_port + 1;
+  InProcessStatestore* statestore =
+      new InProcessStatestore(statestore_port, FLAGS_webserver_port + 1);
+  ASSERT_TRUE(statestore->Start().ok());
+
+  // Values above the threshold are compressed by the statestore, and decompressed by
+  // the subscriber before they are passed to the callbacks.
+  string large_value(FLAGS_statestore_compression_threshold_bytes * 4, 'a');
+  string small_value("small");
+  StatestoreSubscriber* publisher = StartSubscriber("publisher", 24101,
+      statestore_port, bind(&PublishEntry, "large", large_value, _1, _2));
+  ASSERT_TRUE(publisher != NULL);
+  StatestoreSubscriber* small_publisher = StartSubscriber("small-publisher", 24102,
+      statestore_port, bind(&PublishEntry, "small", small_value, _1, _2));
+  ASSERT_TRUE(small_publisher != NULL);
+  ReceivedEntries received;
+  StatestoreSubscriber* receiver = StartSubscriber("receiver", 24103, statestore_port,
+      bind(&ReceivedEntries::Update, &received, _1, _2));
+  ASSERT_TRUE(receiver != NULL);
+
+  TTopicItem item;
+  ASSERT_TRUE(received.WaitFor("large", &item));
+  EXPECT_EQ(large_value, item.value);
+  EXPECT_FALSE(item.__isset.is_compressed && item.is_compressed);
+  ASSERT_TRUE(received.WaitFor("small", &item));
+  EXPECT_EQ(small_value, item.value);
+}
+
+TEST_F(StatestoreTest, StaleRegistrationHeartbeat) {
+  int statestore_port = FLAGS_state_store_port + 2;
+  InProcessStatestore* statestore =
+      new InProcessStatestore(statestore_port, FLAGS_webserver_port + 2);
+  ASSERT_TRUE(statestore->Start().ok());
+  ReceivedEntries received;
+  StatestoreSubscriber* subscriber = StartSubscriber("subscriber", 24104,
+      statestore_port, bind(&ReceivedEntries::Update, &received, _1, _2));
+  ASSERT_TRUE(subscriber != NULL);
+
+  TUniqueId registration_id = RegistrationId(subscriber);
+  ASSERT_NE(TUniqueId(), registration_id);
+  EXPECT_TRUE(Heartbeat(subscriber, registration_id).ok());
+  // A heartbeat for a previous registration is rejected.
+  TUniqueId stale_id = registration_id;
+  ++stale_id.lo;
+  EXPECT_FALSE(Heartbeat(subscriber, stale_id).ok());
+  // Before the first registration, any heartbeat is accepted.
+  metrics_.push_back(new Metrics());
+  StatestoreSubscriber unregistered("unregistered",
+      MakeNetworkAddress("localhost", 24105),
+      MakeNetworkAddress("localhost", statestore_port), metrics_.back());
+  EXPECT_TRUE(Heartbeat(&unregistered, stale_id).ok());
+}
+
 }
 
 int main(int argc, char **argv) {
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <boost/foreach.hpp>
+#include <snappy.h>
 
 #include "common/status.h"
 #include "statestore/statestore.h"
@@ -40,6 +41,13 @@ DEFINE_int32(statestore_num_heartbeat_threads, 10, "(Advanced) Number of threads
     " send heartbeats in parallel to all registered subscribers.");
 DEFINE_int32(statestore_heartbeat_frequency_ms, 500, "(Advanced) Frequency (in ms) with"
     " which the statestore sends heartbeats to subscribers.");
+DEFINE_int32(statestore_num_update_threads, 10, "(Advanced) Number of threads used to "
+    " send topic updates in parallel to all registered subscribers.");
+DEFINE_int32(statestore_update_frequency_ms, 500, "(Advanced) Frequency (in ms) with"
+    " which the statestore sends topic updates to subscribers.");
+DEFINE_int32(statestore_compression_threshold_bytes, 4096, "(Advanced) Topic entry "
+    "values of at least this many bytes are sent to subscribers Snappy-compressed. "
+    "A value <= 0 disables compression.");
 
 DEFINE_int32(state_store_port, 24000, "port where StatestoreService is running");
 
@@ -66,7 +74,7 @@ const Statestore::TopicEntry::Version Statestore::Subscriber::TOPIC_INITIAL_VERS
 // most one entry per subscriber.
 const int32_t STATESTORE_MAX_SUBSCRIBERS = 10000;
 
-// Heartbeats that miss their deadline by this much are logged.
+// Heartbeats and topic updates that miss their deadline by this much are logged.
 const uint32_t HEARTBEAT_WARN_THRESHOLD_MS = 2000;
 
 typedef ClientConnection<StatestoreSubscriberClient> StatestoreSubscriberConnection;
@@ -91,10 +99,12 @@ class StatestoreThriftIf : public StatestoreServiceIf {
 };
 
 void Statestore::TopicEntry::SetValue(const Statestore::TopicEntry::Value& bytes,
-    TopicEntry::Version version) {
+    TopicEntry::Version version, bool is_compressed) {
   DCHECK(bytes == Statestore::TopicEntry::NULL_VALUE || bytes.size() > 0);
+  DCHECK(!is_compressed || bytes != Statestore::TopicEntry::NULL_VALUE);
   value_ = bytes;
   version_ = version;
+  is_compressed_ = is_compressed;
 }
 
 Statestore::TopicEntry::Version Statestore::Topic::Put(const string& key,
@@ -112,9 +122,18 @@ Statestore::TopicEntry::Version Statestore::Topic::Put(const string& key,
     topic_update_log_.erase(entry_it->second.version());
     value_size_delta -= entry_it->second.value().size();
   }
-  value_size_delta += bytes.size();
 
-  entry_it->second.SetValue(bytes, ++last_version_);
+  // Compress large values once here, rather than once per subscriber they are sent to.
+  int64_t threshold = FLAGS_statestore_compression_threshold_bytes;
+  if (threshold > 0 && static_cast<int64_t>(bytes.size()) >= threshold) {
+    TopicEntry::Value compressed;
+    snappy::Compress(bytes.data(), bytes.size(), &compressed);
+    value_size_delta += compressed.size();
+    entry_it->second.SetValue(compressed, ++last_version_, true);
+  } else {
+    value_size_delta += bytes.size();
+    entry_it->second.SetValue(bytes, ++last_version_);
+  }
   topic_update_log_.insert(make_pair(entry_it->second.version(), key));
 
   total_key_size_bytes_ += key_size_delta;
@@ -187,8 +206,14 @@ Statestore::Statestore(Metrics* metrics)
         "subscriber-heartbeat-worker",
         FLAGS_statestore_num_heartbeat_threads,
         STATESTORE_MAX_SUBSCRIBERS,
-        bind<void>(mem_fn(&Statestore::UpdateSubscriber), this, _1, _2)),
+        bind<void>(mem_fn(&Statestore::DoSubscriberUpdate), this, true, _1, _2)),
+    subscriber_topic_update_threadpool_("statestore",
+        "subscriber-update-worker",
+        FLAGS_statestore_num_update_threads,
+        STATESTORE_MAX_SUBSCRIBERS,
+        bind<void>(mem_fn(&Statestore::DoSubscriberUpdate), this, false, _1, _2)),
     client_cache_(new ClientCache<StatestoreSubscriberClient>()),
+    heartbeat_client_cache_(new ClientCache<StatestoreSubscriberClient>()),
     thrift_iface_(new StatestoreThriftIf(this)),
     failure_detector_(
         new MissedHeartbeatFailureDetector(FLAGS_statestore_max_missed_heartbeats,
@@ -207,6 +232,7 @@ Statestore::Statestore(Metrics* metrics)
   topic_size_metric_ =
       metrics->CreateAndRegisterPrimitiveMetric(STATESTORE_TOTAL_TOPIC_SIZE_BYTES, 0L);
   client_cache_->InitMetrics(metrics, "subscriber");
+  heartbeat_client_cache_->InitMetrics(metrics, "subscriber-heartbeat");
 }
 
 void Statestore::RegisterWebpages(Webserver* webserver) {
@@ -308,9 +334,11 @@ Status Statestore::RegisterSubscriber(const SubscriberId& subscriber_id,
     subscriber_set_metric_->Add(subscriber_id);
   }
 
-  // Add the subscriber to the update queue, with an immediate schedule.
+  // Add the subscriber to the heartbeat and update queues, with an immediate schedule.
   if (subscriber_heartbeat_threadpool_.GetQueueSize() >= STATESTORE_MAX_SUBSCRIBERS
-      || !subscriber_heartbeat_threadpool_.Offer(make_pair(0L, subscriber_id))) {
+      || subscriber_topic_update_threadpool_.GetQueueSize() >= STATESTORE_MAX_SUBSCRIBERS
+      || !subscriber_heartbeat_threadpool_.Offer(make_pair(0L, subscriber_id))
+      || !subscriber_topic_update_threadpool_.Offer(make_pair(0L, subscriber_id))) {
     stringstream ss;
     ss << "Maximum subscriber limit reached: " << STATESTORE_MAX_SUBSCRIBERS;
     lock_guard<mutex> l(subscribers_lock_);
@@ -326,7 +354,33 @@ Status Statestore::RegisterSubscriber(const SubscriberId& subscriber_id,
   return Status::OK;
 }
 
-Status Statestore::ProcessOneSubscriber(Subscriber* subscriber) {
+Status Statestore::SendHeartbeat(Subscriber* subscriber) {
+  Status status;
+  StatestoreSubscriberConnection client(heartbeat_client_cache_.get(),
+      subscriber->network_address(), &status);
+  RETURN_IF_ERROR(status);
+
+  THeartbeatRequest request;
+  THeartbeatResponse response;
+  request.__set_registration_id(subscriber->registration_id());
+  try {
+    client->Heartbeat(response, request);
+  } catch (apache::thrift::transport::TTransportException& e) {
+    // Client may have been closed due to a failure
+    RETURN_IF_ERROR(client.Reopen());
+    try {
+      client->Heartbeat(response, request);
+    } catch (apache::thrift::transport::TTransportException& e) {
+      return Status(e.what());
+    }
+  }
+  // The subscriber rejects heartbeats for a previous registration, which then fail like
+  // any other missed heartbeat.
+  if (response.__isset.status) RETURN_IF_ERROR(Status(response.status));
+  return Status::OK;
+}
+
+Status Statestore::SendTopicUpdate(Subscriber* subscriber) {
   // First thing: make a list of updates to send
   TUpdateStateRequest update_state_request;
   GatherTopicUpdates(*subscriber, &update_state_request);
@@ -439,6 +493,7 @@ void Statestore::GatherTopicUpdates(const Subscriber& subscriber,
           topic_item.key = itr->first;
           // TODO: Does this do a needless copy?
           topic_item.value = topic_entry.value();
+          if (topic_entry.is_compressed()) topic_item.__set_is_compressed(true);
         }
       }
 
@@ -493,10 +548,12 @@ void Statestore::SetExitFlag() {
   lock_guard<mutex> l(exit_flag_lock_);
   exit_flag_ = true;
   subscriber_heartbeat_threadpool_.Shutdown();
+  subscriber_topic_update_threadpool_.Shutdown();
 }
 
-void Statestore::UpdateSubscriber(int thread_id,
+void Statestore::DoSubscriberUpdate(bool is_heartbeat, int thread_id,
     const ScheduledSubscriberUpdate& update) {
+  const char* update_kind = is_heartbeat ? "heartbeat" : "topic update";
   int64_t update_deadline = update.first;
   if (update_deadline != 0L) {
     // Wait until deadline.
@@ -505,19 +562,19 @@ void Statestore::UpdateSubscriber(int thread_id,
       SleepForMs(diff_ms);
       diff_ms = update_deadline - ms_since_epoch();
     }
-    VLOG(3) << "Sending update to: " << update.second << " (deadline accuracy: "
-            << abs(diff_ms) << "ms)";
+    VLOG(3) << "Sending " << update_kind << " to: " << update.second
+            << " (deadline accuracy: " << abs(diff_ms) << "ms)";
 
     if (diff_ms > HEARTBEAT_WARN_THRESHOLD_MS) {
       // TODO: This should be a healthcheck in a monitored metric in CM, which would
       // require a 'rate' metric type.
-      LOG(WARNING) << "Missed subscriber (" << update.second << ") deadline by "
-                   << diff_ms << "ms";
+      LOG(WARNING) << "Missed subscriber (" << update.second << ") " << update_kind
+                   << " deadline by " << diff_ms << "ms";
     }
   } else {
     // The first update is scheduled immediately and has a deadline of 0. There's no need
     // to wait.
-    VLOG(3) << "Initial update to: " << update.second;
+    VLOG(3) << "Initial " << update_kind << " to: " << update.second;
   }
   shared_ptr<Subscriber> subscriber;
   {
@@ -527,20 +584,30 @@ void Statestore::UpdateSubscriber(int thread_id,
     subscriber = it->second;
   }
   // Give up the lock here so that others can get to the queue
-  Status status = ProcessOneSubscriber(subscriber.get());
+  Status status = is_heartbeat ?
+      SendHeartbeat(subscriber.get()) : SendTopicUpdate(subscriber.get());
   {
     lock_guard<mutex> l(subscribers_lock_);
     // Check again if this registration has been removed while we were processing the
-    // heartbeat.
+    // heartbeat or update.
     SubscriberMap::iterator it = subscribers_.find(update.second);
     if (it == subscribers_.end()) return;
 
     if (!status.ok()) {
-      LOG(INFO) << "Unable to update subscriber at " << subscriber->network_address()
-                << ", received error " << status.GetErrorMsg();
+      LOG(INFO) << "Unable to send " << update_kind << " to subscriber at "
+                << subscriber->network_address() << ", received error "
+                << status.GetErrorMsg();
     }
 
-    if (failure_detector_->UpdateHeartbeat(PrintId(
+    if (!is_heartbeat) {
+      // Only heartbeats decide liveness. A failed update is retried at the next update
+      // interval, from the last version the subscriber successfully processed.
+      int64_t deadline_ms = ms_since_epoch() + FLAGS_statestore_update_frequency_ms;
+      VLOG(3) << "Next update deadline for: " << subscriber->id() << " is in "
+              << FLAGS_statestore_update_frequency_ms << "ms";
+      subscriber_topic_update_threadpool_.Offer(
+          make_pair(deadline_ms, subscriber->id()));
+    } else if (failure_detector_->UpdateHeartbeat(PrintId(
         subscriber->registration_id()), status.ok()) == FailureDetector::FAILED) {
       // TODO: Consider if a metric to track the number of failures would be useful.
       LOG(INFO) << "Subscriber '" << subscriber->id() << "' has failed, disconnected "
@@ -567,6 +634,7 @@ void Statestore::UnregisterSubscriber(Subscriber* subscriber) {
 
   // Close all active clients so that the next attempt to use them causes a Reopen()
   client_cache_->CloseConnections(subscriber->network_address());
+  heartbeat_client_cache_->CloseConnections(subscriber->network_address());
 
   // Prevent the failure detector from growing without bound
   failure_detector_->EvictPeer(PrintId(subscriber->registration_id()));
@@ -587,5 +655,6 @@ void Statestore::UnregisterSubscriber(Subscriber* subscriber) {
 
 Status Statestore::MainLoop() {
   subscriber_heartbeat_threadpool_.Join();
+  subscriber_topic_update_threadpool_.Join();
   return Status::OK;
 }
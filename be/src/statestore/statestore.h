@@ -47,11 +47,14 @@ class Status;
 //
 // Topics are subscribed to by subscribers, which are remote clients of the statestore
 // which express an interest in some set of Topics. The statestore sends topic updates to
-// subscribers via periodic heartbeat messages, which are also used to detect the liveness
-// of a subscriber.
+// subscribers periodically (every --statestore_update_frequency_ms). Separately, it sends
+// small heartbeat messages (every --statestore_heartbeat_frequency_ms), which are used to
+// detect the liveness of a subscriber. Keeping the two apart means a large or slow topic
+// update cannot cause a subscriber to be considered failed, and that all changes made
+// to a topic between two updates are coalesced into a single delta.
 //
 // Subscribers, in return, send topic updates to the statestore to merge with the current
-// topic. These updates are then sent to all other subscribers in the next heartbeat.
+// topic. These updates are then sent to all other subscribers in the next topic update.
 //
 // Topic entries usually have human-readable keys, and values which are some serialised
 // representation of a data structure, e.g. a Thrift struct. The contents of a value's bye
@@ -72,6 +75,9 @@ class Status;
 // processed. The statestore can use this information to send a delta of updates to a
 // subscriber, rather than all items in the topic.  For non-delta updates, the statestore
 // will send an update that includes all values in the topic.
+//
+// Values of at least --statestore_compression_threshold_bytes are Snappy-compressed once
+// when they are added to a topic, and are sent to subscribers in compressed form.
 class Statestore {
  public:
   // A SubscriberId uniquely identifies a single subscriber, and is
@@ -139,14 +145,18 @@ class Statestore {
     // Sets the value of this entry to the byte / length pair. NULL_VALUE implies this
     // entry has been deleted.  The caller is responsible for ensuring, if required, that
     // the version parameter is larger than the current version() TODO: Consider enforcing
-    // version monotonicity here.
-    void SetValue(const Value& bytes, Version version);
+    // version monotonicity here. 'is_compressed' is true if 'bytes' is the
+    // Snappy-compressed value.
+    void SetValue(const Value& bytes, Version version, bool is_compressed = false);
 
-    TopicEntry() : value_(NULL_VALUE), version_(TOPIC_ENTRY_INITIAL_VERSION) { }
+    TopicEntry()
+      : value_(NULL_VALUE), version_(TOPIC_ENTRY_INITIAL_VERSION),
+        is_compressed_(false) { }
 
     const Value& value() const { return value_; }
     uint64_t version() const { return version_; }
     uint32_t length() const { return value_.size(); }
+    bool is_compressed() const { return is_compressed_; }
 
    private:
     // Byte string value, owned by this TopicEntry. The value is opaque to the statestore,
@@ -157,6 +167,9 @@ class Statestore {
     // version number so that only the minimal set of changes can be sent from the
     // statestore to a subscriber.
     Version version_;
+
+    // True if value_ is Snappy-compressed.
+    bool is_compressed_;
   };
 
   // Map from TopicEntryKey to TopicEntry, maintained by a Topic object.
@@ -181,7 +194,8 @@ class Statestore {
 
     // Adds an entry with the given key. If bytes == NULL_VALUE, the entry is considered
     // deleted, and may be garbage collected in the future. The entry is assigned a new
-    // version number by the Topic, and that version number is returned.
+    // version number by the Topic, and that version number is returned. Values of at
+    // least --statestore_compression_threshold_bytes are stored compressed.
     //
     // Must be called holding the topic lock
     TopicEntry::Version Put(const TopicEntryKey& key, const TopicEntry::Value& bytes);
@@ -344,7 +358,7 @@ class Statestore {
   // prior to re-entry into this map.
   //
   // Subscribers are held in shared_ptrs so that RegisterSubscriber() may overwrite their
-  // entry in this map while UpdateSubscriber() tries to update an existing registration
+  // entry in this map while DoSubscriberUpdate() tries to update an existing registration
   // without risk of use-after-free.
   typedef boost::unordered_map<SubscriberId, boost::shared_ptr<Subscriber> >
     SubscriberMap;
@@ -353,9 +367,9 @@ class Statestore {
   // Used to generated unique IDs for each new registration.
   boost::uuids::random_generator subscriber_uuid_generator_;
 
-  // Work item passed to subscriber heartbeat threads. First entry is the *earliest* time
-  // (in microseconds since epoch) that the next heartbeat should be sent, the second
-  // entry is the subscriber to send it to.
+  // Work item passed to subscriber heartbeat and topic update threads. First entry is
+  // the *earliest* time (in microseconds since epoch) that the next heartbeat or update
+  // should be sent, the second entry is the subscriber to send it to.
   typedef std::pair<int64_t, SubscriberId> ScheduledSubscriberUpdate;
 
   // Pool of threads that send heartbeats to subscribers one-by-one. Each subscriber has a
@@ -379,9 +393,17 @@ class Statestore {
   // subscriber runs slow for any reason).
   ThreadPool<ScheduledSubscriberUpdate> subscriber_heartbeat_threadpool_;
 
-  // Cache of subscriber clients. Only one client per subscriber should be used, but the
-  // cache helps with the client lifecycle on failure.
+  // Pool of threads that send topic updates to subscribers, scheduled in the same way as
+  // heartbeats. Sized by --statestore_num_update_threads, which bounds the number of
+  // topic updates in flight at any time.
+  ThreadPool<ScheduledSubscriberUpdate> subscriber_topic_update_threadpool_;
+
+  // Caches of subscriber clients for topic updates and heartbeats respectively. Only
+  // one client per subscriber should be used from each cache, but the caches help with
+  // the client lifecycle on failure. Separate connections are used so that heartbeats
+  // don't queue behind a large topic update.
   boost::scoped_ptr<ClientCache<StatestoreSubscriberClient> > client_cache_;
+  boost::scoped_ptr<ClientCache<StatestoreSubscriberClient> > heartbeat_client_cache_;
 
   // Thrift API implementation which proxies requests onto this Statestore
   boost::shared_ptr<StatestoreServiceIf> thrift_iface_;
@@ -400,17 +422,21 @@ class Statestore {
   Metrics::IntMetric* value_size_metric_;
   Metrics::IntMetric* topic_size_metric_;
 
-  // Called by the subscriber heartbeat threadpool to process a single subscriber. Sends a
-  // heartbeat to one subscriber (by calling ProcessOneSubscriber) and updates the failure
-  // detector state with the result. Once complete, the subscriber is re-added to the
-  // heartbeat queue with a new scheduled time for its next heartbeat.
-  void UpdateSubscriber(int thread_id, const ScheduledSubscriberUpdate& update);
-
-  // Does the work of updating a single subscriber. Tries to call UpdateState on the
-  // client. If that fails, informs the failure detector, and if the client is failed,
-  // adds it to the list of failed subscribers. Otherwise, it sends the deltas to the
-  // subscriber, and receives and processes a list of updates.
-  Status ProcessOneSubscriber(Subscriber* subscriber);
+  // Called by the subscriber heartbeat and topic update threadpools to process a single
+  // subscriber. If 'is_heartbeat' is true, sends a heartbeat to one subscriber (by
+  // calling SendHeartbeat) and updates the failure detector state with the result.
+  // Otherwise, sends the subscriber its topic updates (by calling SendTopicUpdate).
+  // Once complete, the subscriber is re-added to the respective queue with a new
+  // scheduled time for its next heartbeat or update.
+  void DoSubscriberUpdate(bool is_heartbeat, int thread_id,
+      const ScheduledSubscriberUpdate& update);
+
+  // Sends the deltas of all subscribed topics to the subscriber, and receives and
+  // processes a list of updates.
+  Status SendTopicUpdate(Subscriber* subscriber);
+
+  // Sends a heartbeat to the subscriber.
+  Status SendHeartbeat(Subscriber* subscriber);
 
   // Unregister a subscriber, removing all of its transient entries and evicting it from
   // the subscriber map. Callers must hold subscribers_lock_ prior to calling this method.
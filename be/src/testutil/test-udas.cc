@@ -27,6 +27,7 @@ void VarArgMerge(FunctionContext*, const IntVal&, IntVal*) {}
 // Defines Agg(<some args>) returns int
 void AggUpdate(FunctionContext*, const IntVal&, IntVal*) {}
 void AggUpdate(FunctionContext*, const IntVal&, const IntVal&, IntVal*) {}
+extern "C" void AggUpdateBatch(FunctionContext*, int, const ColumnVal*, IntVal*) {}
 // Update function intentionally not called *Update for FE testing.
 void AggFn(FunctionContext*, const IntVal&, IntVal*) {}
 void AggInit(FunctionContext*, IntVal*) {}
@@ -110,6 +110,23 @@ DoubleVal VarSumMultiply(FunctionContext* context,
   return DoubleVal(result * d.val);
 }
 
+// AddInts() also has a batch version (see UdfBatchEvaluate in udf.h).
+IntVal AddInts(FunctionContext* context, const IntVal& a, const IntVal& b) {
+  if (a.is_null || b.is_null) return IntVal::null();
+  return IntVal(a.val + b.val);
+}
+
+extern "C" void AddIntsBatch(FunctionContext* context, int num_rows,
+    const ColumnVal* args, ColumnVal* result) {
+  const int32_t* a = reinterpret_cast<const int32_t*>(args[0].values);
+  const int32_t* b = reinterpret_cast<const int32_t*>(args[1].values);
+  int32_t* sum = reinterpret_cast<int32_t*>(result->values);
+  for (int i = 0; i < num_rows; ++i) {
+    sum[i] = a[i] + b[i];
+    result->is_null[i] = args[0].is_null[i] | args[1].is_null[i];
+  }
+}
+
 BooleanVal TestError(FunctionContext* context) {
   context->SetError("test UDF error");
   context->SetError("this shouldn't show up");
@@ -16,6 +16,7 @@
 #ifndef IMPALA_UDA_TEST_HARNESS_IMPL_H
 #define IMPALA_UDA_TEST_HARNESS_IMPL_H
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -49,6 +50,55 @@ class UdaTestHarnessUtil {
   static T CopyIntermediate(FunctionContext* context, int byte_size, const T& src) {
     return src;
   }
+
+  // Returns a column (see ColumnVal) with the values *values[0] to *values[num - 1].
+  // The column's memory is allocated in 'buffer'.
+  template<typename T>
+  static ColumnVal CreateColumn(const T* const* values, int num,
+      std::vector<uint8_t>* buffer) {
+    // Every *Val is at least as large as its column value.
+    buffer->resize(num * (sizeof(T) + sizeof(bool)));
+    ColumnVal column(&(*buffer)[0], reinterpret_cast<bool*>(&(*buffer)[num * sizeof(T)]));
+    for (int i = 0; i < num; ++i) {
+      SetColumnVal(*values[i], i, &column);
+    }
+    return column;
+  }
+
+ private:
+  template<typename V>
+  static void SetColumnValue(const V& value, bool is_null, int i, ColumnVal* column) {
+    column->is_null[i] = is_null;
+    if (!is_null) reinterpret_cast<V*>(column->values)[i] = value;
+  }
+
+  static void SetColumnVal(const BooleanVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const TinyIntVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const SmallIntVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const IntVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const BigIntVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const FloatVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const DoubleVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v.val, v.is_null, i, column);
+  }
+  static void SetColumnVal(const StringVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v, v.is_null, i, column);
+  }
+  static void SetColumnVal(const TimestampVal& v, int i, ColumnVal* column) {
+    SetColumnValue(v, v.is_null, i, column);
+  }
 };
 
 template<>
@@ -94,6 +144,20 @@ bool UdaTestHarnessBase<RESULT, INTERMEDIATE>::CheckResult(
 template<typename RESULT, typename INTERMEDIATE>
 bool UdaTestHarnessBase<RESULT, INTERMEDIATE>::Execute(
     const RESULT& expected, UdaExecutionMode mode) {
+  use_update_batch_ = false;
+  if (!ExecuteModes(expected, mode)) return false;
+  if (update_batch_fn_ == NULL) return true;
+
+  use_update_batch_ = true;
+  bool success = ExecuteModes(expected, mode);
+  use_update_batch_ = false;
+  if (!success) error_msg_ = "(using the batch update function) " + error_msg_;
+  return success;
+}
+
+template<typename RESULT, typename INTERMEDIATE>
+bool UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteModes(
+    const RESULT& expected, UdaExecutionMode mode) {
   error_msg_ = "";
   RESULT result;
 
@@ -147,6 +211,24 @@ bool UdaTestHarnessBase<RESULT, INTERMEDIATE>::Execute(
   return true;
 }
 
+template<typename RESULT, typename INTERMEDIATE>
+void UdaTestHarnessBase<RESULT, INTERMEDIATE>::UpdateValues(int target, int num_targets,
+    FunctionContext* context, INTERMEDIATE* dst) {
+  if (!use_update_batch_) {
+    for (int i = target; i < num_input_values_; i += num_targets) {
+      Update(i, context, dst);
+    }
+    return;
+  }
+  std::vector<int> idxs;
+  for (int i = target; i < num_input_values_; i += num_targets) {
+    idxs.push_back(i);
+  }
+  for (int i = 0; i < idxs.size(); i += batch_size_) {
+    UpdateBatch(&idxs[i], std::min<int>(batch_size_, idxs.size() - i), context, dst);
+  }
+}
+
 template<typename RESULT, typename INTERMEDIATE>
 RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteSingleNode() {
   boost::scoped_ptr<FunctionContext> context(FunctionContext::CreateTestContext());
@@ -157,9 +239,7 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteSingleNode() {
   init_fn_(context.get(), &intermediate);
   if (!CheckContext(context.get())) return RESULT::null();
 
-  for (int i = 0; i < num_input_values_; ++i) {
-    Update(i, context.get(), &intermediate);
-  }
+  UpdateValues(0, 1, context.get(), &intermediate);
   if (!CheckContext(context.get())) return RESULT::null();
 
   // Single node doesn't need merge or serialize
@@ -192,9 +272,8 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteOneLevel(int num_nodes)
   if (!CheckContext(merge_context.get())) return RESULT::null();
 
   // Process all the values in the single level num_nodes contexts
-  for (int i = 0; i < num_input_values_; ++i) {
-    int target = i % num_nodes;
-    Update(i, contexts[target].get(), &intermediates[target]);
+  for (int i = 0; i < num_nodes; ++i) {
+    UpdateValues(i, num_nodes, contexts[i].get(), &intermediates[i]);
   }
 
   // Merge them all into the final
@@ -261,9 +340,8 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteTwoLevel(
   if (!CheckContext(final_context.get())) return RESULT::null();
 
   // Assign all the input values to level 1 updates
-  for (int i = 0; i < num_input_values_; ++i) {
-    int target = i % num1;
-    Update(i, level1_contexts[target].get(), &level1_intermediates[target]);
+  for (int i = 0; i < num1; ++i) {
+    UpdateValues(i, num1, level1_contexts[i].get(), &level1_intermediates[i]);
   }
 
   // Serialize the level 1 intermediates and merge them with a level 2 intermediate
@@ -337,6 +415,16 @@ void UdaTestHarness<RESULT, INTERMEDIATE, INPUT>::Update(
   update_fn_(context, *input_[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT>
+void UdaTestHarness<RESULT, INTERMEDIATE, INPUT>::UpdateBatch(
+    const int* idxs, int num, FunctionContext* context, INTERMEDIATE* dst) {
+  std::vector<const INPUT*> values(num);
+  for (int i = 0; i < num; ++i) values[i] = input_[idxs[i]];
+  std::vector<uint8_t> buffer;
+  ColumnVal column = UdaTestHarnessUtil::CreateColumn(&values[0], num, &buffer);
+  BaseClass::update_batch_fn_(context, num, &column, dst);
+}
+
 // Runs the UDA in all the modes, validating the result is 'expected' each time.
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2>
 bool UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::Execute(
@@ -360,6 +448,22 @@ void UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::Update(
   update_fn_(context, (*input1_)[idx], (*input2_)[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2>
+void UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::UpdateBatch(
+    const int* idxs, int num, FunctionContext* context, INTERMEDIATE* dst) {
+  std::vector<const INPUT1*> values1(num);
+  std::vector<const INPUT2*> values2(num);
+  for (int i = 0; i < num; ++i) {
+    values1[i] = &(*input1_)[idxs[i]];
+    values2[i] = &(*input2_)[idxs[i]];
+  }
+  std::vector<uint8_t> buffers[2];
+  ColumnVal columns[2];
+  columns[0] = UdaTestHarnessUtil::CreateColumn(&values1[0], num, &buffers[0]);
+  columns[1] = UdaTestHarnessUtil::CreateColumn(&values2[0], num, &buffers[1]);
+  BaseClass::update_batch_fn_(context, num, columns, dst);
+}
+
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
     typename INPUT3>
 bool UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::Execute(
@@ -384,6 +488,26 @@ void UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::Update(
   update_fn_(context, (*input1_)[idx], (*input2_)[idx], (*input3_)[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
+    typename INPUT3>
+void UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::UpdateBatch(
+    const int* idxs, int num, FunctionContext* context, INTERMEDIATE* dst) {
+  std::vector<const INPUT1*> values1(num);
+  std::vector<const INPUT2*> values2(num);
+  std::vector<const INPUT3*> values3(num);
+  for (int i = 0; i < num; ++i) {
+    values1[i] = &(*input1_)[idxs[i]];
+    values2[i] = &(*input2_)[idxs[i]];
+    values3[i] = &(*input3_)[idxs[i]];
+  }
+  std::vector<uint8_t> buffers[3];
+  ColumnVal columns[3];
+  columns[0] = UdaTestHarnessUtil::CreateColumn(&values1[0], num, &buffers[0]);
+  columns[1] = UdaTestHarnessUtil::CreateColumn(&values2[0], num, &buffers[1]);
+  columns[2] = UdaTestHarnessUtil::CreateColumn(&values3[0], num, &buffers[2]);
+  BaseClass::update_batch_fn_(context, num, columns, dst);
+}
+
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
     typename INPUT3, typename INPUT4>
 bool UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::Execute(
@@ -412,6 +536,29 @@ void UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::Upda
       dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
+    typename INPUT3, typename INPUT4>
+void UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::UpdateBatch(
+    const int* idxs, int num, FunctionContext* context, INTERMEDIATE* dst) {
+  std::vector<const INPUT1*> values1(num);
+  std::vector<const INPUT2*> values2(num);
+  std::vector<const INPUT3*> values3(num);
+  std::vector<const INPUT4*> values4(num);
+  for (int i = 0; i < num; ++i) {
+    values1[i] = &(*input1_)[idxs[i]];
+    values2[i] = &(*input2_)[idxs[i]];
+    values3[i] = &(*input3_)[idxs[i]];
+    values4[i] = &(*input4_)[idxs[i]];
+  }
+  std::vector<uint8_t> buffers[4];
+  ColumnVal columns[4];
+  columns[0] = UdaTestHarnessUtil::CreateColumn(&values1[0], num, &buffers[0]);
+  columns[1] = UdaTestHarnessUtil::CreateColumn(&values2[0], num, &buffers[1]);
+  columns[2] = UdaTestHarnessUtil::CreateColumn(&values3[0], num, &buffers[2]);
+  columns[3] = UdaTestHarnessUtil::CreateColumn(&values4[0], num, &buffers[3]);
+  BaseClass::update_batch_fn_(context, num, columns, dst);
+}
+
 }
 
 #endif
@@ -48,6 +48,9 @@ class UdaTestHarnessBase {
 
   typedef RESULT (*FinalizeFn)(FunctionContext* context, const INTERMEDIATE& value);
 
+  typedef void (*UpdateBatchFn)(FunctionContext* context, int num_rows,
+      const ColumnVal* inputs, INTERMEDIATE* result);
+
   // UDA test harness allows for custom comparator to validate results. UDAs
   // can specify a custom comparator to, for example, tolerate numerical imprecision.
   // Returns true if x and y should be treated as equal.
@@ -62,6 +65,14 @@ class UdaTestHarnessBase {
     fixed_buffer_byte_size_ = byte_size;
   }
 
+  // Sets the batch version of the update function (see UdaUpdateBatch in udf.h).
+  // If set, Execute() runs the UDA in each mode a second time, passing the input values
+  // to 'fn' in batches of up to 'batch_size' values instead of calling Update.
+  void SetUpdateBatchFn(UpdateBatchFn fn, int batch_size = 1024) {
+    update_batch_fn_ = fn;
+    batch_size_ = batch_size;
+  }
+
   // Returns the failure string if any.
   const std::string& GetErrorMsg() const { return error_msg_; }
 
@@ -72,6 +83,9 @@ class UdaTestHarnessBase {
       merge_fn_(merge_fn),
       serialize_fn_(serialize_fn),
       finalize_fn_(finalize_fn),
+      update_batch_fn_(NULL),
+      batch_size_(0),
+      use_update_batch_(false),
       result_comparator_fn_(NULL),
       num_input_values_(0) {
   }
@@ -79,6 +93,14 @@ class UdaTestHarnessBase {
   // Runs the UDA in all the modes, validating the result is 'expected' each time.
   bool Execute(const RESULT& expected, UdaExecutionMode mode);
 
+  // Implements Execute() using either Update() or UpdateBatch(), depending on
+  // use_update_batch_.
+  bool ExecuteModes(const RESULT& expected, UdaExecutionMode mode);
+
+  // Updates 'dst' with every num_targets-th input value starting at 'target'.
+  void UpdateValues(int target, int num_targets, FunctionContext* context,
+      INTERMEDIATE* dst);
+
   // Returns false if there is an error set in the context.
   bool CheckContext(FunctionContext* context);
 
@@ -100,12 +122,24 @@ class UdaTestHarnessBase {
 
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst) = 0;
 
+  // Calls update_batch_fn_ with the input values idxs[0] to idxs[num - 1].
+  virtual void UpdateBatch(const int* idxs, int num, FunctionContext* context,
+      INTERMEDIATE* dst) = 0;
+
   // UDA functions
   InitFn init_fn_;
   MergeFn merge_fn_;
   SerializeFn serialize_fn_;
   FinalizeFn finalize_fn_;
 
+  // Optional batch version of the update function, and the number of values passed to
+  // it at a time.
+  UpdateBatchFn update_batch_fn_;
+  int batch_size_;
+
+  // True while Execute() runs the UDA with update_batch_fn_.
+  bool use_update_batch_;
+
   // Customer comparator, NULL if default == should be used.
   ResultComparator result_comparator_fn_;
 
@@ -156,6 +190,8 @@ class UdaTestHarness : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const int* idxs, int num, FunctionContext* context,
+      INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -187,6 +223,8 @@ class UdaTestHarness2 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const int* idxs, int num, FunctionContext* context,
+      INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -220,6 +258,8 @@ class UdaTestHarness3 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const int* idxs, int num, FunctionContext* context,
+      INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -255,6 +295,8 @@ class UdaTestHarness4 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const int* idxs, int num, FunctionContext* context,
+      INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -46,6 +46,14 @@ BigIntVal CountFinalize(FunctionContext* context, const BigIntVal& val) {
   return val;
 }
 
+// Batch version of CountUpdate.
+void CountUpdateBatch(FunctionContext* context, int num_rows, const ColumnVal* inputs,
+    BigIntVal* val) {
+  for (int i = 0; i < num_rows; ++i) {
+    val->val += !inputs[0].is_null[i];
+  }
+}
+
 //-------------------------------- Count(...) ------------------------------------
 // Example of implementing Count(...)
 // The input type is: multiple ints
@@ -64,6 +72,58 @@ void Count4Update(FunctionContext* context, const IntVal& input1, const IntVal&
   val->val += (!input1.is_null + !input2.is_null + !input3.is_null + !input4.is_null);
 }
 
+// Batch version of Count2Update, Count3Update, etc. for 'num_inputs' inputs.
+template<int num_inputs>
+void CountNUpdateBatch(FunctionContext* context, int num_rows, const ColumnVal* inputs,
+    BigIntVal* val) {
+  for (int i = 0; i < num_inputs; ++i) {
+    for (int j = 0; j < num_rows; ++j) {
+      val->val += !inputs[i].is_null[j];
+    }
+  }
+}
+
+//-------------------------------- Sum(int) ------------------------------------
+// Example of a UDA with a batch update function that only looks at the values.
+// The input type is: int
+// The intermediate and return types are bigint
+void SumInit(FunctionContext* context, BigIntVal* val) {
+  val->is_null = true;
+  val->val = 0;
+}
+
+void SumUpdate(FunctionContext* context, const IntVal& input, BigIntVal* val) {
+  if (input.is_null) return;
+  val->is_null = false;
+  val->val += input.val;
+}
+
+void SumUpdateBatch(FunctionContext* context, int num_rows, const ColumnVal* inputs,
+    BigIntVal* val) {
+  const int32_t* values = reinterpret_cast<const int32_t*>(inputs[0].values);
+  const bool* is_null = inputs[0].is_null;
+  int64_t sum = 0;
+  bool all_null = true;
+  for (int i = 0; i < num_rows; ++i) {
+    // Branch-free so the loop can be vectorized.
+    sum += is_null[i] ? 0 : values[i];
+    all_null &= is_null[i];
+  }
+  if (all_null) return;
+  val->is_null = false;
+  val->val += sum;
+}
+
+void SumMerge(FunctionContext* context, const BigIntVal& src, BigIntVal* dst) {
+  if (src.is_null) return;
+  dst->is_null = false;
+  dst->val += src.val;
+}
+
+BigIntVal SumFinalize(FunctionContext* context, const BigIntVal& val) {
+  return val;
+}
+
 //-------------------------------- Min(String) ------------------------------------
 // Example of implementing MIN for strings.
 // The input type is: STRING
@@ -214,6 +274,36 @@ TEST(CountTest, Basic) {
   EXPECT_FALSE(test.Execute(no_nulls, BigIntVal(100))) << test.GetErrorMsg();
 }
 
+TEST(CountTest, Batch) {
+  UdaTestHarness<BigIntVal, BigIntVal, IntVal> test(
+      CountInit, CountUpdate, CountMerge, NULL, CountFinalize);
+  test.SetUpdateBatchFn(CountUpdateBatch, 64);
+  vector<IntVal> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(i % 3 == 0 ? IntVal::null() : IntVal(i));
+  }
+
+  EXPECT_TRUE(test.Execute(values, BigIntVal(666))) << test.GetErrorMsg();
+  EXPECT_FALSE(test.Execute(values, BigIntVal(1000))) << test.GetErrorMsg();
+}
+
+TEST(SumTest, Batch) {
+  UdaTestHarness<BigIntVal, BigIntVal, IntVal> test(
+      SumInit, SumUpdate, SumMerge, NULL, SumFinalize);
+  test.SetUpdateBatchFn(SumUpdateBatch, 100);
+  vector<IntVal> values;
+  int64_t expected = 0;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(i % 7 == 0 ? IntVal::null() : IntVal(i));
+    if (i % 7 != 0) expected += i;
+  }
+  EXPECT_TRUE(test.Execute(values, BigIntVal(expected))) << test.GetErrorMsg();
+
+  values.clear();
+  values.push_back(IntVal::null());
+  EXPECT_TRUE(test.Execute(values, BigIntVal::null())) << test.GetErrorMsg();
+}
+
 TEST(CountMultiArgTest, Basic) {
   int num = 1000;
   vector<IntVal> no_nulls;
@@ -231,6 +321,13 @@ TEST(CountMultiArgTest, Basic) {
   UdaTestHarness4<BigIntVal, BigIntVal, IntVal, IntVal, IntVal, IntVal> test4(
       CountInit, Count4Update, CountMerge, NULL, CountFinalize);
   EXPECT_TRUE(test4.Execute(no_nulls, no_nulls, no_nulls, no_nulls, BigIntVal(4 * num)));
+
+  test2.SetUpdateBatchFn(CountNUpdateBatch<2>);
+  EXPECT_TRUE(test2.Execute(no_nulls, no_nulls, BigIntVal(2 * num)));
+  test3.SetUpdateBatchFn(CountNUpdateBatch<3>);
+  EXPECT_TRUE(test3.Execute(no_nulls, no_nulls, no_nulls, BigIntVal(3 * num)));
+  test4.SetUpdateBatchFn(CountNUpdateBatch<4>, 7);
+  EXPECT_TRUE(test4.Execute(no_nulls, no_nulls, no_nulls, no_nulls, BigIntVal(4 * num)));
 }
 
 bool FuzzyCompare(const BigIntVal& r1, const BigIntVal& r2) {
@@ -39,6 +39,7 @@ struct IntVal;
 struct BigIntVal;
 struct StringVal;
 struct TimestampVal;
+struct ColumnVal;
 
 // The FunctionContext is passed to every UDF/UDA and is the interface for the UDF to the
 // rest of the system. It contains APIs to examine the system state, report errors
@@ -187,6 +188,33 @@ class FunctionContext {
 // FunctionContext::AddWarning().
 typedef void (*UdfPrepareFn)(FunctionContext* context);
 
+// A UDF in a shared library can also provide a version of itself that evaluates a
+// batch of rows at a time, e.g. to make use of SIMD instructions. Impala calls it
+// instead of the UDF whenever it evaluates the UDF over a row batch; the UDF itself is
+// still required. The batch version must have the signature below and is named with
+// BATCH_SYMBOL in CREATE FUNCTION. Its symbol is not resolved from the function's
+// argument types, so it must be given exactly as it appears in the library, e.g. by
+// declaring the batch version extern "C". For example, the batch version of
+//    IntVal AddUdf(FunctionContext* context, const IntVal& a, const IntVal& b);
+// could be
+//    extern "C" void AddUdfBatch(FunctionContext* context, int num_rows,
+//        const ColumnVal* args, ColumnVal* result);
+// registered with
+//    CREATE FUNCTION add(int, int) RETURNS int LOCATION '...' SYMBOL='AddUdf'
+//        BATCH_SYMBOL='AddUdfBatch';
+// args[i] holds the values of the ith argument (including variable arguments) for
+// all 'num_rows' rows, laid out as the argument types of that CREATE FUNCTION. The UDF
+// must set result->values[j] and result->is_null[j] for every row j. The same memory
+// management rules as for the UDF apply. Each overload of a UDF that reads its columns
+// as different types needs its own batch version.
+// The batch version may be called for rows whose results are never used, e.g. rows
+// past a LIMIT, so it must not have side effects. It is not called for UDFs whose
+// evaluation is guarded by other exprs (e.g. CASE, IF, AND or earlier conjuncts).
+// IR UDFs don't have a batch version; they are inlined into the query's codegen'd
+// row-at-a-time code instead.
+typedef void (*UdfBatchEvaluate)(FunctionContext* context, int num_rows,
+    const ColumnVal* args, ColumnVal* result);
+
 //----------------------------------------------------------------------------
 //------------------------------- UDAs ---------------------------------------
 //----------------------------------------------------------------------------
@@ -232,6 +260,15 @@ typedef void (*UdaUpdate)(FunctionContext* context, const InputType& input,
 typedef void (*UdaUpdate2)(FunctionContext* context, const InputType& input,
     const InputType2& input2, IntermediateType* result);
 
+// Like UDFs, UDAs in shared libraries can provide a batch version of the update
+// function. It is named with UPDATE_BATCH_FN in CREATE AGGREGATE FUNCTION, like
+// BATCH_SYMBOL for UDFs (see UdfBatchEvaluate), and is called with the input values of
+// 'num_rows' rows that are all aggregated into 'result'. inputs[i] holds the values of
+// the ith input argument.
+// UDAs without input arguments always use the update function.
+typedef void (*UdaUpdateBatch)(FunctionContext* context, int num_rows,
+    const ColumnVal* inputs, IntermediateType* result);
+
 // Merge an intermediate result 'src' into 'dst'.
 typedef void (*UdaMerge)(FunctionContext* context, const IntermediateType& src,
     IntermediateType* dst);
@@ -446,6 +483,19 @@ struct StringVal : public AnyVal {
   bool operator!=(const StringVal& other) const { return !(*this == other); }
 };
 
+// A column of values passed to and returned from the batch versions of UDFs and UDAs.
+// 'values' points to an array of the 'val' field type of the column's *Val struct
+// (bool, int8_t, int16_t, int32_t, int64_t, float or double), or to an array of
+// StringVal or TimestampVal for string and timestamp columns, whose is_null fields are
+// unused. is_null[i] is true if the ith value is NULL; values[i] is then unspecified.
+struct ColumnVal {
+  void* values;
+  bool* is_null;
+
+  ColumnVal(void* values = NULL, bool* is_null = NULL)
+    : values(values), is_null(is_null) {}
+};
+
 typedef uint8_t* BufferVal;
 
 }
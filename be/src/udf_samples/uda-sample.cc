@@ -30,6 +30,14 @@ void CountUpdate(FunctionContext* context, const IntVal& input, BigIntVal* val)
   ++val->val;
 }
 
+// Batch version of CountUpdate() (see UdaUpdateBatch in udf.h).
+extern "C" void CountUpdateBatch(FunctionContext* context, int num_rows,
+    const ColumnVal* inputs, BigIntVal* val) {
+  for (int i = 0; i < num_rows; ++i) {
+    if (!inputs[0].is_null[i]) ++val->val;
+  }
+}
+
 void CountMerge(FunctionContext* context, const BigIntVal& src, BigIntVal* dst) {
   dst->val += src.val;
 }
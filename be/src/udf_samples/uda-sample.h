@@ -23,6 +23,8 @@ using namespace impala_udf;
 // This is an example of the COUNT aggregate function.
 void CountInit(FunctionContext* context, BigIntVal* val);
 void CountUpdate(FunctionContext* context, const IntVal& input, BigIntVal* val);
+extern "C" void CountUpdateBatch(FunctionContext* context, int num_rows,
+    const ColumnVal* inputs, BigIntVal* val);
 void CountMerge(FunctionContext* context, const BigIntVal& src, BigIntVal* dst);
 BigIntVal CountFinalize(FunctionContext* context, const BigIntVal& val);
 
@@ -0,0 +1,113 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "util/block-gzip.h"
+
+#include <string.h>
+#include <sstream>
+#include <zlib.h>
+
+#include "common/logging.h"
+#include "util/codec.h"
+
+using namespace impala;
+using namespace std;
+
+// The header of a member is a gzip header with FLG.FEXTRA set and a single extra
+// subfield 'BC' of 2 bytes, which contains the total member size - 1.
+static const uint8_t BLOCK_HEADER[BlockGzip::HEADER_SIZE] = {
+  0x1f, 0x8b, 8, 4,   // magic, deflate, FLG.FEXTRA
+  0, 0, 0, 0,         // MTIME
+  0, 0xff,            // XFL, OS (unknown)
+  6, 0,               // XLEN
+  'B', 'C', 2, 0,     // subfield id and length
+  0, 0                // BSIZE, set per member
+};
+
+const uint8_t BlockGzip::EOF_BLOCK[BlockGzip::EOF_BLOCK_SIZE] = {
+  0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0,
+  3, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+bool BlockGzip::IsHeader(const uint8_t* data) {
+  // MTIME, XFL and OS can be anything.
+  if (data[0] != 0x1f || data[1] != 0x8b || data[2] != 8 || (data[3] & 4) == 0) {
+    return false;
+  }
+  if (memcmp(data + 10, BLOCK_HEADER + 10, 6) != 0) return false;
+  return BlockSize(data) >= HEADER_SIZE + TRAILER_SIZE;
+}
+
+Status BlockGzip::UncompressedSize(const uint8_t* block, int block_size, int* size) {
+  DCHECK_GE(block_size, HEADER_SIZE + TRAILER_SIZE);
+  const uint8_t* isize = block + block_size - 4;
+  uint32_t value = static_cast<uint32_t>(isize[0]) |
+      (static_cast<uint32_t>(isize[1]) << 8) | (static_cast<uint32_t>(isize[2]) << 16) |
+      (static_cast<uint32_t>(isize[3]) << 24);
+  if (value == 0 || value > MAX_BLOCK_SIZE) {
+    stringstream ss;
+    ss << "Invalid uncompressed size of block gzip member: " << value
+       << ". Data is likely corrupt.";
+    return Status(ss.str());
+  }
+  *size = value;
+  return Status::OK;
+}
+
+int BlockGzip::FindHeader(const uint8_t* buffer, int buffer_len) {
+  if (buffer_len < HEADER_SIZE) return -1;
+  const uint8_t* end = buffer + buffer_len - HEADER_SIZE + 1;
+  const uint8_t* pos = buffer;
+  while (pos < end) {
+    pos = reinterpret_cast<const uint8_t*>(memchr(pos, BLOCK_HEADER[0], end - pos));
+    if (pos == NULL) return -1;
+    if (IsHeader(pos)) return pos - buffer;
+    ++pos;
+  }
+  return -1;
+}
+
+Status BlockGzip::CompressBlock(Codec* deflater, const uint8_t* input, int input_len,
+    string* output) {
+  DCHECK_LE(input_len, MAX_INPUT_SIZE);
+  int max_deflated_len = deflater->MaxOutputLen(input_len, input);
+  int start = output->size();
+  output->resize(start + HEADER_SIZE + max_deflated_len + TRAILER_SIZE);
+  uint8_t* block = reinterpret_cast<uint8_t*>(&(*output)[start]);
+
+  uint8_t* deflated = block + HEADER_SIZE;
+  int deflated_len = max_deflated_len;
+  RETURN_IF_ERROR(deflater->ProcessBlock(true, input_len, const_cast<uint8_t*>(input),
+      &deflated_len, &deflated));
+  int block_size = HEADER_SIZE + deflated_len + TRAILER_SIZE;
+  if (block_size > MAX_BLOCK_SIZE) {
+    stringstream ss;
+    ss << "Block gzip member too large: " << block_size;
+    return Status(ss.str());
+  }
+
+  memcpy(block, BLOCK_HEADER, HEADER_SIZE);
+  block[16] = (block_size - 1) & 0xff;
+  block[17] = (block_size - 1) >> 8;
+
+  uint8_t* trailer = deflated + deflated_len;
+  uint32_t crc = crc32(crc32(0L, Z_NULL, 0), input, input_len);
+  for (int i = 0; i < 4; ++i) {
+    trailer[i] = (crc >> (8 * i)) & 0xff;
+    trailer[4 + i] = (static_cast<uint32_t>(input_len) >> (8 * i)) & 0xff;
+  }
+  output->resize(start + block_size);
+  return Status::OK;
+}
@@ -0,0 +1,83 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IMPALA_UTIL_BLOCK_GZIP_H
+#define IMPALA_UTIL_BLOCK_GZIP_H
+
+#include <string.h>
+#include <string>
+
+#include "common/status.h"
+
+namespace impala {
+
+class Codec;
+
+// Utilities for the block gzip (BGZF) format, as written by bgzip: a series of
+// independent gzip members of at most 64KB each, whose headers carry the compressed size
+// of the member in an extra field. The file is still a valid gzip file, but a reader can
+// find the start of a member without decompressing anything before it, which makes
+// these files splittable.
+class BlockGzip {
+ public:
+  // Size of the gzip header including the extra field with the member size.
+  static const int HEADER_SIZE = 18;
+
+  // Size of the gzip trailer (crc32 and uncompressed size).
+  static const int TRAILER_SIZE = 8;
+
+  // Maximum size of a compressed member.
+  static const int MAX_BLOCK_SIZE = 64 * 1024;
+
+  // Maximum number of uncompressed bytes per member. This is smaller than
+  // MAX_BLOCK_SIZE so that incompressible input still fits into one member.
+  static const int MAX_INPUT_SIZE = 0xff00;
+
+  // Empty member that marks the end of a file.
+  static const int EOF_BLOCK_SIZE = 28;
+  static const uint8_t EOF_BLOCK[EOF_BLOCK_SIZE];
+
+  // Returns true if the HEADER_SIZE bytes at 'data' are a block gzip member header.
+  static bool IsHeader(const uint8_t* data);
+
+  // Returns the total size of the member starting with 'header'.
+  static int BlockSize(const uint8_t* header) {
+    return (header[16] | (header[17] << 8)) + 1;
+  }
+
+  // Returns true if the member 'block' of 'block_size' bytes is EOF_BLOCK.
+  static bool IsEofBlock(const uint8_t* block, int block_size) {
+    return block_size == EOF_BLOCK_SIZE && memcmp(block, EOF_BLOCK, EOF_BLOCK_SIZE) == 0;
+  }
+
+  // Reads the uncompressed size of the member 'block' of 'block_size' bytes from its
+  // trailer into 'size'. The size comes from the file, so it is validated: returns an
+  // error unless it is in (0, MAX_BLOCK_SIZE]. Empty members, i.e. EOF_BLOCK, must be
+  // skipped before calling this.
+  static Status UncompressedSize(const uint8_t* block, int block_size, int* size);
+
+  // Returns the offset of the first member header that is entirely contained in
+  // 'buffer', or -1 if there is none.
+  static int FindHeader(const uint8_t* buffer, int buffer_len);
+
+  // Compresses 'input' into a single member and appends it to 'output'. 'deflater'
+  // must be a DEFLATE compressor and 'input_len' at most MAX_INPUT_SIZE.
+  static Status CompressBlock(Codec* deflater, const uint8_t* input, int input_len,
+      std::string* output);
+};
+
+}
+
+#endif
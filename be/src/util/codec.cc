@@ -38,6 +38,9 @@ const char* const Codec::BZIP2_COMPRESSION =
 const char* const Codec::SNAPPY_COMPRESSION =
     "org.apache.hadoop.io.compress.SnappyCodec";
 
+const char* const Codec::LZ4_COMPRESSION =
+    "org.apache.hadoop.io.compress.Lz4Codec";
+
 const char* const UNKNOWN_CODEC_ERROR =
     "This compression codec is currently unsupported: ";
 
@@ -46,7 +49,8 @@ const Codec::CodecMap Codec::CODEC_MAP = map_list_of
   (Codec::DEFAULT_COMPRESSION, THdfsCompression::DEFAULT)
   (Codec::GZIP_COMPRESSION, THdfsCompression::GZIP)
   (Codec::BZIP2_COMPRESSION, THdfsCompression::BZIP2)
-  (Codec::SNAPPY_COMPRESSION, THdfsCompression::SNAPPY_BLOCKED);
+  (Codec::SNAPPY_COMPRESSION, THdfsCompression::SNAPPY_BLOCKED)
+  (Codec::LZ4_COMPRESSION, THdfsCompression::LZ4_BLOCKED);
 
 string Codec::GetCodecName(THdfsCompression::type type) {
   map<const string, THdfsCompression::type>::const_iterator im;
@@ -110,6 +114,15 @@ Status Codec::CreateCompressor(MemPool* mem_pool, bool reuse,
     case THdfsCompression::SNAPPY:
       *compressor = new SnappyCompressor(mem_pool, reuse);
       break;
+    case THdfsCompression::LZ4:
+      *compressor = new Lz4Compressor(mem_pool, reuse, false);
+      break;
+    case THdfsCompression::LZ4_HC:
+      *compressor = new Lz4Compressor(mem_pool, reuse, true);
+      break;
+    case THdfsCompression::LZ4_BLOCKED:
+      *compressor = new Lz4BlockCompressor(mem_pool, reuse);
+      break;
     default: {
       stringstream ss;
       ss << "Unsupported codec: " << format;
@@ -170,6 +183,13 @@ Status Codec::CreateDecompressor(MemPool* mem_pool, bool reuse,
     case THdfsCompression::SNAPPY:
       *decompressor = new SnappyDecompressor(mem_pool, reuse);
       break;
+    case THdfsCompression::LZ4:
+    case THdfsCompression::LZ4_HC:
+      *decompressor = new Lz4Decompressor(mem_pool, reuse);
+      break;
+    case THdfsCompression::LZ4_BLOCKED:
+      *decompressor = new Lz4BlockDecompressor(mem_pool, reuse);
+      break;
     default: {
       stringstream ss;
       ss << "Unsupported codec: " << format;
@@ -196,3 +216,25 @@ void Codec::Close() {
     memory_pool_->AcquireData(temp_memory_pool_.get(), false);
   }
 }
+
+void impala::DecompressBlock(DecompressionTask* task) {
+  Status status;
+  {
+    SCOPED_TIMER(task->timer);
+    status = task->decompressor->ProcessBlock(false, task->input_length, task->input,
+        &task->output_length, &task->output);
+  }
+  task->done.Set(status);
+}
+
+// Utility method to convert from a thread-pool signature to DecompressBlock()
+static void DecompressionThreadPoolHelper(int thread_id,
+    DecompressionTask* const& task) {
+  DecompressBlock(task);
+}
+
+DecompressionThreadPool* impala::CreateDecompressionThreadPool(const string& name,
+    uint32_t num_threads, uint32_t max_queue_length) {
+  return new DecompressionThreadPool(name, "decompression-worker", num_threads,
+      max_queue_length, &DecompressionThreadPoolHelper);
+}
@@ -18,7 +18,9 @@
 
 #include "common/status.h"
 #include "runtime/mem-pool.h"
+#include "util/promise.h"
 #include "util/runtime-profile.h"
+#include "util/thread-pool.h"
 
 #include <boost/scoped_ptr.hpp>
 #include "gen-cpp/Descriptors_types.h"
@@ -43,6 +45,7 @@ class Codec {
   static const char* const GZIP_COMPRESSION;
   static const char* const BZIP2_COMPRESSION;
   static const char* const SNAPPY_COMPRESSION;
+  static const char* const LZ4_COMPRESSION;
 
   // Map from codec string to compression format
   typedef std::map<const std::string, const THdfsCompression::type> CodecMap;
@@ -161,5 +164,32 @@ class Codec {
   int buffer_length_;
 };
 
+// A block to be decompressed, possibly on another thread. 'done' is set to the status
+// of decompressor->ProcessBlock() once output and output_length are valid.
+// The input must stay valid and the decompressor must not be used by anyone else until
+// 'done' is set.
+struct DecompressionTask {
+  Codec* decompressor;
+  // Updated with the time spent in ProcessBlock(). May be NULL.
+  RuntimeProfile::Counter* timer;
+  int input_length;
+  uint8_t* input;
+  int output_length;
+  uint8_t* output;
+  Promise<Status> done;
+};
+
+// Decompresses 'task' on the calling thread and sets task->done.
+void DecompressBlock(DecompressionTask* task);
+
+// Pool of threads that run DecompressBlock(), so that scanners can decompress the next
+// block of a file while parsing the current one.
+typedef ThreadPool<DecompressionTask*> DecompressionThreadPool;
+
+// Creates a new DecompressionThreadPool with the specified parameters. See ThreadPool's
+// constructor for the meaning of the arguments.
+DecompressionThreadPool* CreateDecompressionThreadPool(const std::string& name,
+    uint32_t num_threads, uint32_t max_queue_length);
+
 }
 #endif
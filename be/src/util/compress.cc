@@ -20,6 +20,8 @@
 #include <zlib.h>
 #include <bzlib.h>
 #include <snappy.h>
+#include <lz4.h>
+#include <lz4hc.h>
 
 using namespace std;
 using namespace boost;
@@ -250,3 +252,85 @@ Status SnappyCompressor::ProcessBlock(bool output_preallocated,
   *output_length = out_len;
   return Status::OK;
 }
+
+Lz4Compressor::Lz4Compressor(MemPool* mem_pool, bool reuse_buffer,
+                             bool high_compression)
+  : Codec(mem_pool, reuse_buffer),
+    high_compression_(high_compression) {
+}
+
+int Lz4Compressor::MaxOutputLen(int input_len, const uint8_t* input) {
+  return LZ4_compressBound(input_len);
+}
+
+Status Lz4Compressor::ProcessBlock(bool output_preallocated,
+                                   int input_length, uint8_t* input,
+                                   int* output_length, uint8_t** output) {
+  if (!output_preallocated) {
+    int max_compressed_len = MaxOutputLen(input_length);
+    if (!reuse_buffer_ || buffer_length_ < max_compressed_len || out_buffer_ == NULL) {
+      DCHECK(memory_pool_ != NULL) << "Can't allocate without passing in a mem pool";
+      buffer_length_ = max_compressed_len;
+      out_buffer_ = memory_pool_->Allocate(buffer_length_);
+    }
+    *output = out_buffer_;
+    *output_length = buffer_length_;
+  }
+
+  const char* in = reinterpret_cast<const char*>(input);
+  char* out = reinterpret_cast<char*>(*output);
+  int ret;
+  if (high_compression_) {
+    // Level 0 is the library's default level.
+    ret = LZ4_compressHC2_limitedOutput(in, out, input_length, *output_length, 0);
+  } else {
+    ret = LZ4_compress_limitedOutput(in, out, input_length, *output_length);
+  }
+  // A result of 0 means the output buffer was too small.
+  if (ret == 0 && input_length > 0) {
+    return Status("Lz4Compressor::ProcessBlock: output length too small");
+  }
+  *output_length = ret;
+  return Status::OK;
+}
+
+Lz4BlockCompressor::Lz4BlockCompressor(MemPool* mem_pool, bool reuse_buffer)
+  : Codec(mem_pool, reuse_buffer) {
+}
+
+int Lz4BlockCompressor::MaxOutputLen(int input_len, const uint8_t* input) {
+  return LZ4_compressBound(input_len) + 2 * sizeof(int32_t);
+}
+
+Status Lz4BlockCompressor::ProcessBlock(bool output_preallocated,
+                                        int input_length, uint8_t* input,
+                                        int* output_length, uint8_t** output) {
+  int max_compressed_len = MaxOutputLen(input_length);
+  if (output_preallocated) {
+    if (*output_length < max_compressed_len) {
+      return Status("Lz4BlockCompressor::ProcessBlock: output length too small");
+    }
+  } else {
+    if (!reuse_buffer_ || buffer_length_ < max_compressed_len || out_buffer_ == NULL) {
+      DCHECK(memory_pool_ != NULL) << "Can't allocate without passing in a mem pool";
+      buffer_length_ = max_compressed_len;
+      out_buffer_ = memory_pool_->Allocate(buffer_length_);
+    }
+    *output = out_buffer_;
+  }
+
+  // Hadoop's BlockCompressorStream writes the uncompressed length of the block, then
+  // the compressed length and data of each chunk. A block is a single chunk here.
+  uint8_t* outp = *output;
+  ReadWriteUtil::PutInt(outp, static_cast<uint32_t>(input_length));
+  outp += sizeof(int32_t);
+  int compressed_len = 0;
+  if (input_length > 0) {
+    compressed_len = LZ4_compress(reinterpret_cast<const char*>(input),
+        reinterpret_cast<char*>(outp + sizeof(int32_t)), input_length);
+    ReadWriteUtil::PutInt(outp, static_cast<uint32_t>(compressed_len));
+    outp += sizeof(int32_t) + compressed_len;
+  }
+  *output_length = outp - *output;
+  return Status::OK;
+}
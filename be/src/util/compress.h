@@ -108,5 +108,42 @@ class SnappyCompressor : public Codec {
   virtual Status Init() { return Status::OK; }
 };
 
+// Compresses into a single raw LZ4 block. The uncompressed length is not part of the
+// output, so it must be stored next to it (e.g. in the parquet page header).
+class Lz4Compressor : public Codec {
+ public:
+  virtual ~Lz4Compressor() { }
+  virtual int MaxOutputLen(int input_len, const uint8_t* input = NULL);
+  virtual Status ProcessBlock(bool output_preallocated,
+                              int input_length, uint8_t* input,
+                              int* output_length, uint8_t** output);
+
+ private:
+  friend class Codec;
+  // If high_compression is true, uses LZ4 HC, which compresses several times slower
+  // for a better ratio. Both are decompressed at the same speed.
+  Lz4Compressor(MemPool* mem_pool = NULL, bool reuse_buffer = false,
+                bool high_compression = false);
+  virtual Status Init() { return Status::OK; }
+
+  bool high_compression_;
+};
+
+// Compresses into the block format of Hadoop's Lz4Codec: the uncompressed length
+// followed by one length-prefixed LZ4 block.
+class Lz4BlockCompressor : public Codec {
+ public:
+  virtual ~Lz4BlockCompressor() { }
+  virtual int MaxOutputLen(int input_len, const uint8_t* input = NULL);
+  virtual Status ProcessBlock(bool output_preallocated,
+                              int input_length, uint8_t* input,
+                              int* output_length, uint8_t** output);
+
+ private:
+  friend class Codec;
+  Lz4BlockCompressor(MemPool* mem_pool, bool reuse_buffer);
+  virtual Status Init() { return Status::OK; }
+};
+
 }
 #endif
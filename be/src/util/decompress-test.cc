@@ -17,6 +17,7 @@
 #include <iostream>
 #include <gtest/gtest.h>
 #include "runtime/mem-tracker.h"
+#include "util/block-gzip.h"
 #include "util/decompress.h"
 #include "util/compress.h"
 #include "gen-cpp/Descriptors_types.h"
@@ -45,7 +46,9 @@ class DecompressorTest : public ::testing::Test {
     mem_pool_.FreeAll();
   }
 
-  void RunTest(THdfsCompression::type format) {
+  // If preallocated_only is true, the decompressor can only decompress into a buffer of
+  // the known uncompressed length.
+  void RunTest(THdfsCompression::type format, bool preallocated_only = false) {
     scoped_ptr<Codec> compressor;
     scoped_ptr<Codec> decompressor;
 
@@ -54,9 +57,11 @@ class DecompressorTest : public ::testing::Test {
     EXPECT_TRUE(
         Codec::CreateDecompressor(&mem_pool_, true, format, &decompressor).ok());
 
-    CompressAndDecompress(compressor.get(), decompressor.get(), sizeof(input_), input_);
+    CompressAndDecompress(compressor.get(), decompressor.get(), sizeof(input_), input_,
+        preallocated_only);
     if (format != THdfsCompression::BZIP2) {
-      CompressAndDecompress(compressor.get(), decompressor.get(), 0, NULL);
+      CompressAndDecompress(compressor.get(), decompressor.get(), 0, NULL,
+          preallocated_only);
     } else {
       // bzip does not allow NULL input
       CompressAndDecompress(compressor.get(), decompressor.get(), 0, input_);
@@ -67,7 +72,8 @@ class DecompressorTest : public ::testing::Test {
   }
 
   void CompressAndDecompress(Codec* compressor, Codec* decompressor,
-                             int input_len, uint8_t* input) {
+                             int input_len, uint8_t* input,
+                             bool preallocated_only = false) {
     // Non-preallocated output buffers
     uint8_t* compressed;
     int compressed_length;
@@ -75,12 +81,14 @@ class DecompressorTest : public ::testing::Test {
           input, &compressed_length, &compressed).ok());
     uint8_t* output;
     int output_len;
-    EXPECT_TRUE(
-        decompressor->ProcessBlock(false, compressed_length,
-            compressed, &output_len, &output).ok());
+    if (!preallocated_only) {
+      EXPECT_TRUE(
+          decompressor->ProcessBlock(false, compressed_length,
+              compressed, &output_len, &output).ok());
 
-    EXPECT_EQ(output_len, input_len);
-    EXPECT_EQ(memcmp(input, output, input_len), 0);
+      EXPECT_EQ(output_len, input_len);
+      EXPECT_EQ(memcmp(input, output, input_len), 0);
+    }
 
     // Preallocated output buffers
     int max_compressed_length = compressor->MaxOutputLen(input_len, input);
@@ -135,6 +143,113 @@ TEST_F(DecompressorTest, SnappyBlocked) {
   RunTest(THdfsCompression::SNAPPY_BLOCKED);
 }
 
+TEST_F(DecompressorTest, Lz4) {
+  RunTest(THdfsCompression::LZ4, true);
+}
+
+TEST_F(DecompressorTest, Lz4Hc) {
+  RunTest(THdfsCompression::LZ4_HC, true);
+}
+
+TEST_F(DecompressorTest, Lz4Blocked) {
+  RunTest(THdfsCompression::LZ4_BLOCKED);
+}
+
+TEST_F(DecompressorTest, Lz4Corrupt) {
+  scoped_ptr<Codec> compressor;
+  scoped_ptr<Codec> decompressor;
+  EXPECT_TRUE(Codec::CreateCompressor(
+      &mem_pool_, false, THdfsCompression::LZ4, &compressor).ok());
+  EXPECT_TRUE(Codec::CreateDecompressor(
+      &mem_pool_, false, THdfsCompression::LZ4, &decompressor).ok());
+
+  uint8_t* compressed;
+  int compressed_length;
+  EXPECT_TRUE(compressor->ProcessBlock(false, sizeof(input_), input_,
+      &compressed_length, &compressed).ok());
+
+  // A buffer shorter than the uncompressed data must not be overrun.
+  int output_len = sizeof(input_) - 1;
+  uint8_t* output = mem_pool_.Allocate(output_len);
+  EXPECT_FALSE(decompressor->ProcessBlock(true, compressed_length, compressed,
+      &output_len, &output).ok());
+
+  // Neither may truncated input.
+  output_len = sizeof(input_);
+  output = mem_pool_.Allocate(output_len);
+  EXPECT_FALSE(decompressor->ProcessBlock(true, compressed_length / 2, compressed,
+      &output_len, &output).ok());
+
+  compressor->Close();
+  decompressor->Close();
+}
+
+TEST_F(DecompressorTest, BlockGzip) {
+  scoped_ptr<Codec> compressor;
+  scoped_ptr<Codec> decompressor;
+  EXPECT_TRUE(Codec::CreateCompressor(
+      NULL, false, THdfsCompression::DEFLATE, &compressor).ok());
+  EXPECT_TRUE(Codec::CreateDecompressor(
+      NULL, false, THdfsCompression::GZIP, &decompressor).ok());
+
+  // Two members followed by the end of file marker.
+  string file;
+  EXPECT_TRUE(BlockGzip::CompressBlock(
+      compressor.get(), input_, sizeof(input_), &file).ok());
+  int first_block_size = file.size();
+  EXPECT_TRUE(BlockGzip::CompressBlock(compressor.get(), input_, 100, &file).ok());
+  file.append(reinterpret_cast<const char*>(BlockGzip::EOF_BLOCK),
+      BlockGzip::EOF_BLOCK_SIZE);
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+
+  // Find the second member when starting in the middle of the first one.
+  EXPECT_EQ(BlockGzip::FindHeader(data, file.size()), 0);
+  EXPECT_EQ(BlockGzip::FindHeader(data + 1, file.size() - 1), first_block_size - 1);
+  EXPECT_EQ(BlockGzip::FindHeader(data + 1, first_block_size), -1);
+
+  int offset = 0;
+  int expected_sizes[] = { sizeof(input_), 100 };
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(BlockGzip::IsHeader(data + offset));
+    int block_size = BlockGzip::BlockSize(data + offset);
+    ASSERT_LE(offset + block_size, file.size());
+    EXPECT_FALSE(BlockGzip::IsEofBlock(data + offset, block_size));
+    int output_len;
+    EXPECT_TRUE(BlockGzip::UncompressedSize(data + offset, block_size, &output_len).ok());
+    EXPECT_EQ(output_len, expected_sizes[i]);
+    uint8_t* output = mem_pool_.Allocate(output_len);
+    EXPECT_TRUE(decompressor->ProcessBlock(true, block_size,
+        const_cast<uint8_t*>(data + offset), &output_len, &output).ok());
+    EXPECT_EQ(output_len, expected_sizes[i]);
+    EXPECT_EQ(memcmp(input_, output, output_len), 0);
+    offset += block_size;
+  }
+  // The end of file marker is empty and has no valid uncompressed size.
+  ASSERT_TRUE(BlockGzip::IsHeader(data + offset));
+  int eof_block_size = BlockGzip::BlockSize(data + offset);
+  EXPECT_TRUE(BlockGzip::IsEofBlock(data + offset, eof_block_size));
+  int output_len;
+  EXPECT_FALSE(
+      BlockGzip::UncompressedSize(data + offset, eof_block_size, &output_len).ok());
+  offset += eof_block_size;
+  EXPECT_EQ(offset, file.size());
+
+  // Corrupt uncompressed sizes, including ones that don't fit into an int, are
+  // rejected.
+  uint8_t* isize = reinterpret_cast<uint8_t*>(&file[first_block_size - 4]);
+  data = reinterpret_cast<const uint8_t*>(file.data());
+  uint8_t corrupt_sizes[][4] = {
+    { 0xff, 0xff, 0xff, 0xff }, { 0, 0, 0, 0x80 }, { 1, 0, 1, 0 }, { 0, 0, 0, 0 }
+  };
+  for (int i = 0; i < 4; ++i) {
+    memcpy(isize, corrupt_sizes[i], 4);
+    EXPECT_FALSE(BlockGzip::UncompressedSize(data, first_block_size, &output_len).ok());
+  }
+
+  compressor->Close();
+  decompressor->Close();
+}
+
 }
 
 int main(int argc, char **argv) {
@@ -22,6 +22,7 @@
 #include <zlib.h>
 #include <bzlib.h>
 #include <snappy.h>
+#include <lz4.h>
 
 using namespace std;
 using namespace boost;
@@ -381,3 +382,131 @@ Status SnappyBlockDecompressor::ProcessBlock(
   RETURN_IF_ERROR(SnappyBlockDecompress(input_len, input, false, output_len, out_ptr));
   return Status::OK;
 }
+
+Lz4Decompressor::Lz4Decompressor(MemPool* mem_pool, bool reuse_buffer)
+  : Codec(mem_pool, reuse_buffer) {
+}
+
+int Lz4Decompressor::MaxOutputLen(int input_len, const uint8_t* input) {
+  // Raw LZ4 blocks don't record the uncompressed length.
+  return -1;
+}
+
+Status Lz4Decompressor::ProcessBlock(bool output_preallocated,
+                                     int input_length, uint8_t* input,
+                                     int* output_length, uint8_t** output) {
+  DCHECK(output_preallocated) << "Lz4Decompressor needs a preallocated output buffer";
+  if (!output_preallocated) {
+    return Status("Lz4Decompressor::ProcessBlock: output must be preallocated");
+  }
+  // LZ4_decompress_safe() never writes past *output_length, even for corrupt input.
+  int ret = LZ4_decompress_safe(reinterpret_cast<const char*>(input),
+      reinterpret_cast<char*>(*output), input_length, *output_length);
+  if (ret < 0) {
+    stringstream ss;
+    ss << "Lz4: LZ4_decompress_safe failed. Data is likely corrupt. Error: " << ret;
+    return Status(ss.str());
+  }
+  if (ret != *output_length) return Status("Lz4: Decompressed size is not correct.");
+  return Status::OK;
+}
+
+Lz4BlockDecompressor::Lz4BlockDecompressor(MemPool* mem_pool, bool reuse_buffer)
+  : Codec(mem_pool, reuse_buffer) {
+}
+
+int Lz4BlockDecompressor::MaxOutputLen(int input_len, const uint8_t* input) {
+  return -1;
+}
+
+// Utility function to decompress lz4 block compressed data, which has the same layout
+// as snappy block compressed data (see SnappyBlockDecompress()). Unlike snappy, the
+// lz4 chunks of an outer block don't record their uncompressed length, so the total
+// output length is only known after decompressing everything.
+// Decompresses into output, which has room for output_capacity bytes, and sets
+// *output_len to the decompressed length. If the output doesn't fit, returns OK with
+// *output_too_small set to true.
+static Status Lz4BlockDecompress(int input_len, uint8_t* input, int output_capacity,
+    char* output, int* output_len, bool* output_too_small) {
+  *output_too_small = false;
+  int uncompressed_total_len = 0;
+  while (input_len > 0) {
+    if (input_len < sizeof(uint32_t)) {
+      return Status("Lz4: truncated block. Data is likely corrupt.");
+    }
+    uint32_t uncompressed_block_len = ReadWriteUtil::GetInt<uint32_t>(input);
+    input += sizeof(uint32_t);
+    input_len -= sizeof(uint32_t);
+
+    if (uncompressed_block_len > Codec::MAX_BLOCK_SIZE - uncompressed_total_len) {
+      stringstream ss;
+      ss << "Decompressor: block size is too big.  Data is likely corrupt. "
+         << "Size: " << uncompressed_block_len;
+      return Status(ss.str());
+    }
+    if (uncompressed_block_len > output_capacity - uncompressed_total_len) {
+      *output_too_small = true;
+      return Status::OK;
+    }
+
+    int remaining_block_len = uncompressed_block_len;
+    while (remaining_block_len > 0) {
+      if (input_len < sizeof(uint32_t)) {
+        return Status("Lz4: truncated block. Data is likely corrupt.");
+      }
+      uint32_t compressed_len = ReadWriteUtil::GetInt<uint32_t>(input);
+      input += sizeof(uint32_t);
+      input_len -= sizeof(uint32_t);
+
+      if (compressed_len == 0 || compressed_len > input_len) {
+        return Status(
+            "Decompressor: invalid compressed length.  Data is likely corrupt.");
+      }
+
+      int ret = LZ4_decompress_safe(reinterpret_cast<const char*>(input), output,
+          compressed_len, remaining_block_len);
+      if (ret <= 0) return Status("Lz4: LZ4_decompress_safe failed");
+      output += ret;
+      remaining_block_len -= ret;
+      input += compressed_len;
+      input_len -= compressed_len;
+    }
+    uncompressed_total_len += uncompressed_block_len;
+  }
+  *output_len = uncompressed_total_len;
+  return Status::OK;
+}
+
+Status Lz4BlockDecompressor::ProcessBlock(
+    bool output_preallocated, int input_len, uint8_t* input,
+    int* output_len, uint8_t** output) {
+  bool output_too_small;
+  if (output_preallocated) {
+    RETURN_IF_ERROR(Lz4BlockDecompress(input_len, input, *output_len,
+        reinterpret_cast<char*>(*output), output_len, &output_too_small));
+    if (output_too_small) {
+      return Status("Lz4BlockDecompressor::ProcessBlock: output length too small");
+    }
+    return Status::OK;
+  }
+
+  // Guess that the data compressed at least 2x, and grow the buffer until it fits.
+  if (!reuse_buffer_ || out_buffer_ == NULL) {
+    buffer_length_ = max(2 * input_len, 1024);
+    out_buffer_ = temp_memory_pool_->Allocate(buffer_length_);
+  }
+  while (true) {
+    RETURN_IF_ERROR(Lz4BlockDecompress(input_len, input, buffer_length_,
+        reinterpret_cast<char*>(out_buffer_), output_len, &output_too_small));
+    if (!output_too_small) break;
+    if (buffer_length_ >= MAX_BLOCK_SIZE / 2) {
+      return Status("Decompressor: block size is too big.  Data is likely corrupt.");
+    }
+    temp_memory_pool_->Clear();
+    buffer_length_ *= 2;
+    out_buffer_ = temp_memory_pool_->Allocate(buffer_length_);
+  }
+  *output = out_buffer_;
+  memory_pool_->AcquireData(temp_memory_pool_.get(), reuse_buffer_);
+  return Status::OK;
+}
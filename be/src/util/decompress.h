@@ -92,5 +92,37 @@ class SnappyBlockDecompressor : public Codec {
   virtual Status Init() { return Status::OK; }
 };
 
+// Decompresses a raw LZ4 block. The output length can't be computed from the input,
+// so the output must always be preallocated to exactly the uncompressed length.
+class Lz4Decompressor : public Codec {
+ public:
+  virtual ~Lz4Decompressor() { }
+  virtual int MaxOutputLen(int input_len, const uint8_t* input = NULL);
+  virtual Status ProcessBlock(bool output_preallocated,
+                              int input_length, uint8_t* input,
+                              int* output_length, uint8_t** output);
+
+ private:
+  friend class Codec;
+  Lz4Decompressor(MemPool* mem_pool = NULL, bool reuse_buffer = false);
+  virtual Status Init() { return Status::OK; }
+};
+
+// Decompresses the block format of Hadoop's Lz4Codec, as used by sequence and rc files.
+// The layout is the same as for SnappyBlockDecompressor.
+class Lz4BlockDecompressor : public Codec {
+ public:
+  virtual ~Lz4BlockDecompressor() { }
+  virtual int MaxOutputLen(int input_len, const uint8_t* input = NULL);
+  virtual Status ProcessBlock(bool output_preallocated,
+                              int input_length, uint8_t* input,
+                              int* output_length, uint8_t** output);
+
+ private:
+  friend class Codec;
+  Lz4BlockDecompressor(MemPool* mem_pool, bool reuse_buffer);
+  virtual Status Init() { return Status::OK; }
+};
+
 }
 #endif
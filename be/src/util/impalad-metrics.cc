@@ -34,6 +34,8 @@ const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_QUERIES =
     "impala-server.num-queries";
 const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS =
     "impala-server.num-fragments";
+const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT =
+    "impala-server.num-fragments-in-flight";
 const char* ImpaladMetricKeys::TOTAL_SCAN_RANGES_PROCESSED =
     "impala-server.scan-ranges.total";
 const char* ImpaladMetricKeys::NUM_SCAN_RANGES_MISSING_VOLUME_ID =
@@ -66,6 +68,20 @@ const char* ImpaladMetricKeys::NUM_SESSIONS_EXPIRED =
     "impala-server.num-sessions-expired";
 const char* ImpaladMetricKeys::NUM_QUERIES_EXPIRED =
     "impala-server.num-queries-expired";
+const char* ImpaladMetricKeys::RESULT_CACHE_NUM_ENTRIES =
+    "impala-server.result-cache.num-entries";
+const char* ImpaladMetricKeys::RESULT_CACHE_TOTAL_BYTES =
+    "impala-server.result-cache.total-bytes";
+const char* ImpaladMetricKeys::RESULT_CACHE_HITS =
+    "impala-server.result-cache.hits";
+const char* ImpaladMetricKeys::RESULT_CACHE_MISSES =
+    "impala-server.result-cache.misses";
+const char* ImpaladMetricKeys::RESULT_CACHE_HIT_RATIO =
+    "impala-server.result-cache.hit-ratio";
+const char* ImpaladMetricKeys::RESULT_CACHE_EVICTIONS =
+    "impala-server.result-cache.evictions";
+const char* ImpaladMetricKeys::RESULT_CACHE_INVALIDATIONS =
+    "impala-server.result-cache.invalidations";
 
 // These are created by impala-server during startup.
 Metrics::StringMetric* ImpaladMetrics::IMPALA_SERVER_START_TIME = NULL;
@@ -74,6 +90,7 @@ Metrics::BooleanMetric* ImpaladMetrics::IMPALA_SERVER_READY = NULL;
 Metrics::StringMetric* ImpaladMetrics::IMPALA_SERVER_LAST_REFRESH_TIME = NULL;
 Metrics::IntMetric* ImpaladMetrics::IMPALA_SERVER_NUM_QUERIES = NULL;
 Metrics::IntMetric* ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS = NULL;
+Metrics::IntMetric* ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT = NULL;
 Metrics::IntMetric* ImpaladMetrics::IMPALA_SERVER_NUM_OPEN_BEESWAX_SESSIONS = NULL;
 Metrics::IntMetric* ImpaladMetrics::IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS = NULL;
 Metrics::IntMetric* ImpaladMetrics::NUM_RANGES_PROCESSED = NULL;
@@ -90,6 +107,13 @@ Metrics::BooleanMetric* ImpaladMetrics::CATALOG_READY = NULL;
 Metrics::IntMetric* ImpaladMetrics::NUM_FILES_OPEN_FOR_INSERT = NULL;
 Metrics::IntMetric* ImpaladMetrics::NUM_SESSIONS_EXPIRED = NULL;
 Metrics::IntMetric* ImpaladMetrics::NUM_QUERIES_EXPIRED = NULL;
+Metrics::IntMetric* ImpaladMetrics::RESULT_CACHE_NUM_ENTRIES = NULL;
+Metrics::BytesMetric* ImpaladMetrics::RESULT_CACHE_TOTAL_BYTES = NULL;
+Metrics::IntMetric* ImpaladMetrics::RESULT_CACHE_HITS = NULL;
+Metrics::IntMetric* ImpaladMetrics::RESULT_CACHE_MISSES = NULL;
+Metrics::DoubleMetric* ImpaladMetrics::RESULT_CACHE_HIT_RATIO = NULL;
+Metrics::IntMetric* ImpaladMetrics::RESULT_CACHE_EVICTIONS = NULL;
+Metrics::IntMetric* ImpaladMetrics::RESULT_CACHE_INVALIDATIONS = NULL;
 
 void ImpaladMetrics::CreateMetrics(Metrics* m) {
   // Initialize impalad metrics
@@ -107,6 +131,8 @@ void ImpaladMetrics::CreateMetrics(Metrics* m) {
       ImpaladMetricKeys::NUM_QUERIES_EXPIRED, 0L);
   IMPALA_SERVER_NUM_FRAGMENTS = m->CreateAndRegisterPrimitiveMetric(
       ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS, 0L);
+  IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT, 0L);
   IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS = m->CreateAndRegisterPrimitiveMetric(
       ImpaladMetricKeys::IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS, 0L);
   IMPALA_SERVER_NUM_OPEN_BEESWAX_SESSIONS = m->CreateAndRegisterPrimitiveMetric(
@@ -147,6 +173,22 @@ void ImpaladMetrics::CreateMetrics(Metrics* m) {
       ImpaladMetricKeys::CATALOG_READY, false);
   NUM_SESSIONS_EXPIRED = m->CreateAndRegisterPrimitiveMetric(
       ImpaladMetricKeys::NUM_SESSIONS_EXPIRED, 0L);
+
+  // Initialize query result cache metrics
+  RESULT_CACHE_NUM_ENTRIES = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_NUM_ENTRIES, 0L);
+  RESULT_CACHE_TOTAL_BYTES = m->RegisterMetric(
+      new Metrics::BytesMetric(ImpaladMetricKeys::RESULT_CACHE_TOTAL_BYTES, 0L));
+  RESULT_CACHE_HITS = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_HITS, 0L);
+  RESULT_CACHE_MISSES = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_MISSES, 0L);
+  RESULT_CACHE_HIT_RATIO = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_HIT_RATIO, 0.0);
+  RESULT_CACHE_EVICTIONS = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_EVICTIONS, 0L);
+  RESULT_CACHE_INVALIDATIONS = m->CreateAndRegisterPrimitiveMetric(
+      ImpaladMetricKeys::RESULT_CACHE_INVALIDATIONS, 0L);
 }
 
 }
@@ -44,6 +44,9 @@ class ImpaladMetricKeys {
   // queries
   static const char* IMPALA_SERVER_NUM_FRAGMENTS;
 
+  // Number of fragments currently executing on this server
+  static const char* IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT;
+
   // Number of open HiveServer2 sessions
   static const char* IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS;
 
@@ -94,6 +97,20 @@ class ImpaladMetricKeys {
 
   // Number of queries expired due to inactivity
   static const char* NUM_QUERIES_EXPIRED;
+  // Number of result sets in the query result cache
+  static const char* RESULT_CACHE_NUM_ENTRIES;
+  // Number of bytes used by the query result cache
+  static const char* RESULT_CACHE_TOTAL_BYTES;
+  // Number of queries answered from the query result cache
+  static const char* RESULT_CACHE_HITS;
+  // Number of cacheable queries that were not found in the query result cache
+  static const char* RESULT_CACHE_MISSES;
+  // Fraction of cacheable queries answered from the query result cache
+  static const char* RESULT_CACHE_HIT_RATIO;
+  // Number of result sets evicted from the query result cache to make room
+  static const char* RESULT_CACHE_EVICTIONS;
+  // Number of result sets removed from the query result cache by catalog updates
+  static const char* RESULT_CACHE_INVALIDATIONS;
 };
 
 // Global impalad-wide metrics.  This is useful for objects that want to update metrics
@@ -108,6 +125,7 @@ class ImpaladMetrics {
   static Metrics::StringMetric* IMPALA_SERVER_LAST_REFRESH_TIME;
   static Metrics::IntMetric* IMPALA_SERVER_NUM_QUERIES;
   static Metrics::IntMetric* IMPALA_SERVER_NUM_FRAGMENTS;
+  static Metrics::IntMetric* IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT;
   static Metrics::IntMetric* IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS;
   static Metrics::IntMetric* IMPALA_SERVER_NUM_OPEN_BEESWAX_SESSIONS;
   static Metrics::IntMetric* NUM_RANGES_PROCESSED;
@@ -124,6 +142,13 @@ class ImpaladMetrics {
   static Metrics::IntMetric* NUM_FILES_OPEN_FOR_INSERT;
   static Metrics::IntMetric* NUM_SESSIONS_EXPIRED;
   static Metrics::IntMetric* NUM_QUERIES_EXPIRED;
+  static Metrics::IntMetric* RESULT_CACHE_NUM_ENTRIES;
+  static Metrics::BytesMetric* RESULT_CACHE_TOTAL_BYTES;
+  static Metrics::IntMetric* RESULT_CACHE_HITS;
+  static Metrics::IntMetric* RESULT_CACHE_MISSES;
+  static Metrics::DoubleMetric* RESULT_CACHE_HIT_RATIO;
+  static Metrics::IntMetric* RESULT_CACHE_EVICTIONS;
+  static Metrics::IntMetric* RESULT_CACHE_INVALIDATIONS;
 
   // Creates and initializes all metrics above in 'm'.
   static void CreateMetrics(Metrics* m);
@@ -281,6 +281,56 @@ TEST(CountersTest, InfoStringTest) {
   EXPECT_EQ(*update_dst_profile.GetInfoString("Foo"), "Bar");
 }
 
+TEST(CountersTest, DeltaUpdate) {
+  ObjectPool pool;
+  RuntimeProfile profile(&pool, "Profile");
+  RuntimeProfile child(&pool, "Child");
+  profile.AddChild(&child);
+  RuntimeProfile::Counter* parent_counter =
+      profile.AddCounter("Parent", TCounterType::UNIT);
+  RuntimeProfile::Counter* child_counter =
+      child.AddCounter("Child", TCounterType::UNIT);
+  parent_counter->Set(1L);
+  child_counter->Set(2L);
+  profile.AddInfoString("Key", "Value");
+
+  // The first delta contains everything.
+  TRuntimeProfileTree tprofile;
+  profile.ToThriftDelta(&tprofile);
+  EXPECT_EQ(tprofile.nodes.size(), 2);
+  EXPECT_EQ(tprofile.nodes[0].counters.size(), 2);
+  RuntimeProfile dst_profile(&pool, "Profile");
+  dst_profile.Update(tprofile);
+  ValidateCounter(&dst_profile, "Parent", 1);
+  EXPECT_EQ(*dst_profile.GetInfoString("Key"), "Value");
+
+  // Only the changed counter and info string are in the next delta, but the tree
+  // structure is still complete.
+  child_counter->Set(5L);
+  profile.AddInfoString("Foo", "Bar");
+  profile.ToThriftDelta(&tprofile);
+  EXPECT_EQ(tprofile.nodes.size(), 2);
+  EXPECT_EQ(tprofile.nodes[0].num_children, 1);
+  EXPECT_EQ(tprofile.nodes[0].counters.size(), 0);
+  EXPECT_EQ(tprofile.nodes[0].info_strings_display_order.size(), 1);
+  EXPECT_EQ(tprofile.nodes[1].counters.size(), 1);
+  dst_profile.Update(tprofile);
+  ValidateCounter(&dst_profile, "Parent", 1);
+  EXPECT_EQ(*dst_profile.GetInfoString("Key"), "Value");
+  EXPECT_EQ(*dst_profile.GetInfoString("Foo"), "Bar");
+
+  vector<RuntimeProfile*> children;
+  dst_profile.GetChildren(&children);
+  ASSERT_EQ(children.size(), 1);
+  ValidateCounter(children[0], "Child", 5);
+
+  // Nothing changed: no counters are sent.
+  profile.ToThriftDelta(&tprofile);
+  EXPECT_EQ(tprofile.nodes[0].counters.size(), 0);
+  EXPECT_EQ(tprofile.nodes[1].counters.size(), 0);
+  EXPECT_EQ(tprofile.nodes[0].info_strings_display_order.size(), 0);
+}
+
 TEST(CountersTest, RateCounters) {
   ObjectPool pool;
   RuntimeProfile profile(&pool, "Profile");
@@ -673,6 +673,108 @@ void RuntimeProfile::ToThrift(vector<TRuntimeProfileNode>* nodes) const {
   }
 }
 
+void RuntimeProfile::ToThriftDelta(TRuntimeProfileTree* tree) {
+  tree->nodes.clear();
+  ToThriftDelta(&tree->nodes);
+}
+
+void RuntimeProfile::ToThriftDelta(vector<TRuntimeProfileNode>* nodes) {
+  int index = nodes->size();
+  nodes->push_back(TRuntimeProfileNode());
+  TRuntimeProfileNode& node = (*nodes)[index];
+  node.name = name_;
+  node.metadata = metadata_;
+  node.indent = true;
+
+  CounterMap counter_map;
+  ChildCounterMap child_counter_map;
+  {
+    lock_guard<mutex> l(counter_map_lock_);
+    counter_map = counter_map_;
+    child_counter_map = child_counter_map_;
+  }
+  InfoStrings info_strings;
+  InfoStringsDisplayOrder info_strings_display_order;
+  {
+    lock_guard<mutex> l(info_strings_lock_);
+    info_strings = info_strings_;
+    info_strings_display_order = info_strings_display_order_;
+  }
+
+  // Read the counter values before taking reported_state_lock_: value() may call into
+  // derived counter functions.
+  vector<TCounter> counters;
+  counters.reserve(counter_map.size());
+  for (CounterMap::const_iterator iter = counter_map.begin();
+       iter != counter_map.end(); ++iter) {
+    TCounter counter;
+    counter.name = iter->first;
+    counter.value = iter->second->value();
+    counter.type = iter->second->type();
+    counters.push_back(counter);
+  }
+
+  {
+    lock_guard<mutex> l(reported_state_lock_);
+    bool new_counters = false;
+    BOOST_FOREACH(const TCounter& counter, counters) {
+      map<string, int64_t>::iterator reported =
+          reported_counter_values_.find(counter.name);
+      if (reported == reported_counter_values_.end()) {
+        new_counters = true;
+        reported_counter_values_[counter.name] = counter.value;
+      } else if (reported->second != counter.value) {
+        reported->second = counter.value;
+      } else {
+        continue;
+      }
+      node.counters.push_back(counter);
+    }
+    // Child counters are only ever added together with their counters.
+    if (new_counters) node.child_counters_map.swap(child_counter_map);
+
+    // Preserve the display order of new info strings; Update() appends them in the
+    // order they are serialized.
+    BOOST_FOREACH(const string& key, info_strings_display_order) {
+      const string& value = info_strings[key];
+      InfoStrings::iterator reported = reported_info_strings_.find(key);
+      if (reported != reported_info_strings_.end() && reported->second == value) {
+        continue;
+      }
+      reported_info_strings_[key] = value;
+      node.info_strings[key] = value;
+      node.info_strings_display_order.push_back(key);
+    }
+  }
+
+  TimeSeriesCounterMap time_series_counter_map;
+  {
+    lock_guard<mutex> l(time_series_counter_map_lock_);
+    time_series_counter_map = time_series_counter_map_;
+  }
+  if (time_series_counter_map.size() != 0) {
+    node.__set_time_series_counters(vector<TTimeSeriesCounter>());
+    node.time_series_counters.resize(time_series_counter_map.size());
+    int idx = 0;
+    BOOST_FOREACH(const TimeSeriesCounterMap::value_type& val, time_series_counter_map) {
+      val.second->ToThrift(&node.time_series_counters[idx++]);
+    }
+  }
+
+  ChildVector children;
+  {
+    lock_guard<mutex> l(children_lock_);
+    children = children_;
+  }
+  node.num_children = children.size();
+  for (int i = 0; i < children.size(); ++i) {
+    int child_idx = nodes->size();
+    children[i].first->ToThriftDelta(nodes);
+    // fix up indentation flag
+    (*nodes)[child_idx].indent = children[i].second;
+  }
+}
+
 int64_t RuntimeProfile::UnitsPerSecond(
     const RuntimeProfile::Counter* total_counter,
     const RuntimeProfile::Counter* timer) {
@@ -381,6 +381,15 @@ class RuntimeProfile {
   void ToThrift(TRuntimeProfileTree* tree) const;
   void ToThrift(std::vector<TRuntimeProfileNode>* nodes) const;
 
+  // Serializes only what changed since the last call to ToThriftDelta(): counters whose
+  // value differs from the last one serialized, new or changed info strings, and the
+  // child counter map of profiles that gained counters. The profile tree itself and
+  // time series counters are always serialized; event sequences are not (Update()
+  // ignores them). Applying every delta in order to a profile with Update() has the
+  // same effect as applying the output of ToThrift().
+  // Does not hold locks when it makes any function calls.
+  void ToThriftDelta(TRuntimeProfileTree* tree);
+
   // Serializes the runtime profile to a string.  This first serializes the
   // object using thrift compact binary format, then gzip compresses it and
   // finally encodes it as base64.  This is not a lightweight operation and
@@ -518,6 +527,12 @@ class RuntimeProfile {
   TimeSeriesCounterMap time_series_counter_map_;
   mutable boost::mutex time_series_counter_map_lock_;
 
+  // Counter values and info strings as of the last ToThriftDelta() call.
+  std::map<std::string, int64_t> reported_counter_values_;
+  InfoStrings reported_info_strings_;
+  // Protects reported_counter_values_ and reported_info_strings_
+  boost::mutex reported_state_lock_;
+
   Counter counter_total_time_;
   // Time spent in just in this profile (i.e. not the children) as a fraction
   // of the total time in the entire profile tree.
@@ -527,6 +542,10 @@ class RuntimeProfile {
   // On return, *idx points to the node immediately following this subtree.
   void Update(const std::vector<TRuntimeProfileNode>& nodes, int* idx);
 
+  // Serializes the delta of this profile and its children to nodes, in the same
+  // order as ToThrift().
+  void ToThriftDelta(std::vector<TRuntimeProfileNode>* nodes);
+
   // Helper function to compute compute the fraction of the total time spent in
   // this profile and its children.
   // Called recusively.
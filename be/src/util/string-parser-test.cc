@@ -131,6 +131,17 @@ TEST(StringToInt, Basic) {
   TestIntValue<int16_t>("-0", 0, StringParser::PARSE_SUCCESS);
   TestIntValue<int32_t>("+0", 0, StringParser::PARSE_SUCCESS);
   TestIntValue<int64_t>("-0", 0, StringParser::PARSE_SUCCESS);
+
+  // Long enough to be converted 8 digits at a time.
+  TestIntValue<int32_t>("123456789", 123456789, StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("-987654321", -987654321, StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("123456789012345678", 123456789012345678,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("100000000000000009", 100000000000000009,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("12345678x", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int32_t>("1234:6789", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int64_t>("12345678/12345678", 0, StringParser::PARSE_FAILURE);
 }
 
 TEST(StringToInt, InvalidLeadingTrailing) {
@@ -201,6 +212,8 @@ TEST(StringToFloat, Basic) {
   TestAllFloatVariants(".456", StringParser::PARSE_SUCCESS);
   TestAllFloatVariants("456.0", StringParser::PARSE_SUCCESS);
   TestAllFloatVariants("456.789", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("123456789.987654321", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("0.0000000012345678", StringParser::PARSE_SUCCESS);
 
   // Scientific notation.
   TestAllFloatVariants("1e10", StringParser::PARSE_SUCCESS);
@@ -38,6 +38,7 @@ BUILD_RE2=0
 BUILD_SASL=0
 BUILD_LDAP=0
 BUILD_SNAPPY=0
+BUILD_LZ4=0
 BUILD_PPROF=0
 
 for ARG in $*
@@ -82,13 +83,17 @@ do
       BUILD_ALL=0
       BUILD_SNAPPY=1
       ;;
+    -lz4)
+      BUILD_ALL=0
+      BUILD_LZ4=1
+      ;;
     -pprof)
       BUILD_ALL=0
       BUILD_PPROF=1
       ;;
     -*)
       echo "Usage: build_thirdparty.sh [-noclean] \
-[-avro -glog -thrift -gflags -gtest -re2 -sasl -ldap -snappy -pprof]"
+[-avro -glog -thrift -gflags -gtest -re2 -sasl -ldap -snappy -lz4 -pprof]"
       exit 1
   esac
 done
@@ -186,6 +191,13 @@ if [ $BUILD_ALL -eq 1 ] || [ $BUILD_SNAPPY -eq 1 ]; then
   make install
 fi
 
+# Build Lz4
+if [ $BUILD_ALL -eq 1 ] || [ $BUILD_LZ4 -eq 1 ]; then
+  build_preamble $IMPALA_HOME/thirdparty/lz4-${IMPALA_LZ4_VERSION} Lz4
+  CFLAGS=-fPIC make -j4 -C lib
+  make -C lib install PREFIX=$IMPALA_HOME/thirdparty/lz4-${IMPALA_LZ4_VERSION}/build
+fi
+
 # Build re2
 if [ $BUILD_ALL -eq 1 ] || [ $BUILD_RE2 -eq 1 ]; then
   build_preamble $IMPALA_HOME/thirdparty/re2 RE2
@@ -66,6 +66,7 @@ export IMPALA_GPERFTOOLS_VERSION=2.0
 export IMPALA_GLOG_VERSION=0.3.2
 export IMPALA_GTEST_VERSION=1.6.0
 export IMPALA_SNAPPY_VERSION=1.0.5
+export IMPALA_LZ4_VERSION=r122
 export IMPALA_CYRUS_SASL_VERSION=2.1.23
 export IMPALA_OPENLDAP_VERSION=2.4.25
 export IMPALA_SQUEASEL_VERSION=3.3
@@ -61,7 +61,10 @@ enum THdfsCompression {
   BZIP2,
   SNAPPY,
   SNAPPY_BLOCKED, // Used by sequence and rc files but not stored in the metadata.
-  LZO
+  LZO,
+  LZ4,
+  LZ4_HC, // LZ4 with a higher compression ratio; decompressed as LZ4.
+  LZ4_BLOCKED // Used by sequence and rc files but not stored in the metadata.
 }
 
 // The table property type.
@@ -162,6 +165,10 @@ struct THdfsFileBlock {
 
   // The list of disk ids for the file block. May not be set if disk ids are not supported
   6: optional list<i32> disk_ids
+
+  // is_replica_cached[i] is true if the replica at network_addresses[i] is cached in
+  // memory by its datanode. Not set if the HDFS client does not report cached replicas.
+  7: optional list<bool> is_replica_cached
 }
 
 // Represents an HDFS file
@@ -35,8 +35,14 @@ struct TRowBatch {
   // TODO: figure out how we can avoid copying the data during TRowBatch construction
   4: string tuple_data
 
-  // Indicates whether tuple_data is snappy-compressed
+  // Indicates whether tuple_data is compressed
   5: bool is_compressed
+
+  // Codec tuple_data is compressed with, if is_compressed. Snappy if not set.
+  6: optional CatalogObjects.THdfsCompression compression_type
+
+  // Size of tuple_data before compression, set if is_compressed.
+  7: optional i32 uncompressed_size
 }
 
 // this is a union over all possible return types
@@ -59,6 +59,17 @@ struct THiveUdfExecutorCtorParams {
   // NULL.
   6: required i64 output_null_ptr
   7: required i64 output_buffer_ptr
+
+  // Native buffers for evaluateBatch(), which evaluates up to batch_capacity rows
+  // with one call. input_batch_ptrs[i] holds the values of the i-th input, one slot
+  // per row. input_batch_nulls_ptr[i * batch_capacity + row] is true if the i-th input
+  // of that row is null. The results are written to output_batch_ptr, one slot per
+  // row, and output_batch_nulls_ptr[row] is set to true if the result is null.
+  8: optional i32 batch_capacity
+  9: optional list<i64> input_batch_ptrs
+  10: optional i64 input_batch_nulls_ptr
+  11: optional i64 output_batch_ptr
+  12: optional i64 output_batch_nulls_ptr
 }
 
 // Arguments to getTableNames, which returns a list of tables that match an
@@ -78,6 +78,9 @@ struct TQueryOptions {
   22: optional i64 reservation_request_timeout
 //TEST change for 'MAGIC' command
   23: optional i64 magic_num
+
+  24: optional CatalogObjects.THdfsCompression text_compression_codec =
+      CatalogObjects.THdfsCompression.NONE
 }
 
 // Impala currently has two types of sessions: Beeswax and HiveServer2
@@ -176,6 +179,20 @@ struct TPlanFragmentExecParams {
   8: optional PlanNodes.TDebugAction debug_action
 }
 
+// Admission control statistics for a single request pool on a single impalad. Each
+// impalad publishes one entry per pool to the request queue topic so that all
+// coordinators can make admission decisions based on cluster-wide pool usage.
+struct TPoolStats {
+  // Number of queries admitted by this impalad that are currently running.
+  1: required i64 num_running
+
+  // Number of queries queued on this impalad waiting for admission.
+  2: required i64 num_queued
+
+  // Sum of the estimated memory requirements of num_running queries, in bytes.
+  3: required i64 mem_reserved
+}
+
 // Service Protocol Details
 
 enum ImpalaInternalServiceVersion {
@@ -220,6 +237,24 @@ struct TExecPlanFragmentResult {
   1: optional Status.TStatus status
 }
 
+// ExecPlanFragments
+
+// All fragment instances a coordinator starts on one backend in one round.
+struct TExecPlanFragmentsParams {
+  1: required ImpalaInternalServiceVersion protocol_version
+
+  // required in V1
+  2: optional list<TExecPlanFragmentParams> fragment_params
+}
+
+struct TExecPlanFragmentsResult {
+  // One status per element of TExecPlanFragmentsParams.fragment_params, in the same
+  // order. Instances after the first one that failed to start are not started, and
+  // have no status.
+  // required in V1
+  1: optional list<Status.TStatus> statuses
+}
+
 // ReportExecStatus
 struct TParquetInsertStats {
   // For each column, the on disk byte size
@@ -272,7 +307,9 @@ struct TReportExecStatusParams {
   // required in V1
   6: optional bool done
 
-  // cumulative profile
+  // Profile of the fragment instance. Intermediate reports only contain counters and
+  // info strings that changed since the previous report (see
+  // RuntimeProfile::ToThriftDelta()); the final report (done == true) is cumulative.
   // required in V1
   7: optional RuntimeProfile.TRuntimeProfileTree profile
 
@@ -339,6 +376,10 @@ service ImpalaInternalService {
   // Returns as soon as all incoming data streams have been set up.
   TExecPlanFragmentResult ExecPlanFragment(1:TExecPlanFragmentParams params);
 
+  // Same as ExecPlanFragment(), for several plan fragment instances at once. The
+  // instances are started in order.
+  TExecPlanFragmentsResult ExecPlanFragments(1:TExecPlanFragmentsParams params);
+
   // Periodically called by backend to report status of plan fragment execution
   // back to coord; also called when execution is finished, for whatever reason.
   TReportExecStatusResult ReportExecStatus(1:TReportExecStatusParams params);
@@ -132,6 +132,11 @@ enum TImpalaQueryOptions {
   // Max time in milliseconds the resource broker should wait for
   // a resource request to be granted by Llama/Yarn (only relevant with RM).
   RESERVATION_REQUEST_TIMEOUT,
+
+  // Compression codec when inserting into text tables.
+  // Valid values are "gzip" (block gzip, which can be split when scanned) and "none".
+  // Leave blank to use default.
+  TEXT_COMPRESSION_CODEC,
 }
 
 // The summary of an insert.
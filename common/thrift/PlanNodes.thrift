@@ -77,6 +77,9 @@ struct THdfsFileSplit {
 
   // total size of the hdfs file
   5: required i64 file_length
+
+  // compression of the hdfs file, as determined from its suffix
+  6: optional CatalogObjects.THdfsCompression file_compression
 }
 
 // key range for single THBaseScanNode
@@ -61,6 +61,10 @@ struct TScanRangeLocation {
   // -1 indicates an unknown volume id;
   // only set for TScanRange.hdfs_file_split
   2: optional i32 volume_id = -1
+
+  // If true, the replica at 'server' is cached in memory by the datanode. The
+  // scheduler prefers cached replicas.
+  3: optional bool is_cached = false
 }
 
 // A single scan range plus the hosts that serve it
@@ -39,6 +39,10 @@ struct TBackendDescriptor {
 
   // True if the debug webserver is secured (for correctly generating links)
   4: optional bool secure_webserver;
+
+  // Number of plan fragments executing on this backend when the descriptor was last
+  // published. Used by the scheduler to steer scan ranges away from busy backends.
+  5: optional i32 num_fragments_in_flight;
 }
 
 // Description of a single entry in a topic
@@ -49,6 +53,11 @@ struct TTopicItem {
   // Byte-string value for this topic entry. May not be null-terminated (in that it may
   // contain null bytes)
   2: required string value;
+
+  // If true, value is Snappy-compressed. Only set by the statestore, which compresses
+  // large values once when they are published; subscribers decompress them before
+  // passing them to their update callbacks.
+  3: optional bool is_compressed = false;
 }
 
 // Set of changes to a single topic, sent from the statestore to a subscriber as well as
@@ -143,8 +152,19 @@ struct TUpdateStateResponse {
   2: required list<TTopicDelta> topic_updates;
 }
 
+struct THeartbeatRequest {
+  // Registration ID for the last known registration from this subscriber.
+  1: optional Types.TUniqueId registration_id;
+}
+
+struct THeartbeatResponse {
+  // Set to an error if the heartbeat was for a registration other than the subscriber's
+  // current one.
+  1: optional Status.TStatus status;
+}
+
 service StatestoreSubscriber {
-  // Called when the statestore sends a heartbeat. The request contains a map of
+  // Called when the statestore sends a topic update. The request contains a map of
   // topic names to TTopicDelta updates, sent from the statestore to the subscriber. Each
   // of these delta updates will contain a list of additions to the topic and a list of
   // deletions from the topic.
@@ -155,4 +175,9 @@ service StatestoreSubscriber {
   // update based off a specific version from the statestore. The next statestore
   // delta update will be based off of the version the subscriber requested.
   TUpdateStateResponse UpdateState(1: TUpdateStateRequest params);
+
+  // Called when the statestore sends a heartbeat. Heartbeats carry no topic data and
+  // are sent more frequently than topic updates, so that failure detection is not
+  // delayed by large topic updates.
+  THeartbeatResponse Heartbeat(1: THeartbeatRequest params);
 }
@@ -112,6 +112,10 @@ struct TFunctionName {
 struct TScalarFunction {
   // Symbol for the function
   1: optional string symbol;
+
+  // Symbol of the optional batch version of the function (see UdfBatchEvaluate in
+  // udf.h). Only set for native functions.
+  2: optional string batch_symbol;
 }
 
 struct TAggregateFunction {
@@ -121,6 +125,10 @@ struct TAggregateFunction {
   4: optional string serialize_fn_symbol
   5: optional string merge_fn_symbol
   6: optional string finalize_fn_symbol
+
+  // Symbol of the optional batch version of the update function (see UdaUpdateBatch in
+  // udf.h). Only set for native functions.
+  7: optional string update_batch_fn_symbol
 }
 
 // Represents a function in the Catalog.
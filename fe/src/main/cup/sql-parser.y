@@ -200,7 +200,7 @@ parser code {:
 // List of keywords. Please keep them sorted alphabetically.
 terminal
   KW_ADD, KW_AGGREGATE, KW_ALL, KW_ALTER, KW_AND, KW_AS, KW_ASC, KW_AVG,
-  KW_AVRO, KW_BETWEEN, KW_BIGINT, KW_BOOLEAN, KW_BY, KW_CASE, KW_CAST,
+  KW_AVRO, KW_BATCH_SYMBOL, KW_BETWEEN, KW_BIGINT, KW_BOOLEAN, KW_BY, KW_CASE, KW_CAST,
   KW_CHANGE, KW_CHAR, KW_COLUMN, KW_COLUMNS, KW_COMMENT, KW_COMPUTE, KW_COUNT, KW_CREATE,
   KW_CROSS, KW_DATA, KW_DATABASE, KW_DATABASES, KW_DATE, KW_DATETIME, KW_DECIMAL,
   KW_DELIMITED, KW_DESC, KW_DESCRIBE, KW_DISTINCT, KW_DISTINCTPC, KW_DISTINCTPCSA, KW_DIV,
@@ -218,7 +218,8 @@ terminal
   KW_SERIALIZE_FN, KW_SET, KW_SHOW, KW_SMALLINT, KW_STORED, KW_STRAIGHT_JOIN,
   KW_STRING, KW_SUM, KW_SYMBOL, KW_TABLE, KW_TABLES, KW_TBLPROPERTIES, KW_TERMINATED,
   KW_TEXTFILE, KW_THEN, KW_TIMESTAMP, KW_TINYINT, KW_STATS, KW_TO, KW_TRUE, KW_UNION,
-  KW_UPDATE_FN, KW_USE, KW_USING, KW_VALUES, KW_VIEW, KW_WHEN, KW_WHERE, KW_WITH;
+  KW_UPDATE_BATCH_FN, KW_UPDATE_FN, KW_USE, KW_USING, KW_VALUES, KW_VIEW, KW_WHEN,
+  KW_WHERE, KW_WITH;
 
 terminal COMMA, DOT, DOTDOTDOT, STAR, LPAREN, RPAREN, LBRACKET, RBRACKET,
   DIVIDE, MOD, ADD, SUBTRACT;
@@ -392,6 +393,8 @@ precedence left KW_FINALIZE_FN;
 precedence left KW_INIT_FN;
 precedence left KW_MERGE_FN;
 precedence left KW_SERIALIZE_FN;
+precedence left KW_BATCH_SYMBOL;
+precedence left KW_UPDATE_BATCH_FN;
 
 start with stmt;
 
@@ -1008,6 +1011,10 @@ create_function_arg_key ::=
   {: RESULT = CreateFunctionStmtBase.OptArg.MERGE_FN; :}
   | KW_FINALIZE_FN
   {: RESULT = CreateFunctionStmtBase.OptArg.FINALIZE_FN; :}
+  | KW_BATCH_SYMBOL
+  {: RESULT = CreateFunctionStmtBase.OptArg.BATCH_SYMBOL; :}
+  | KW_UPDATE_BATCH_FN
+  {: RESULT = CreateFunctionStmtBase.OptArg.UPDATE_BATCH_FN; :}
   ;
 
 // Our parsing of UNION is slightly different from MySQL's:
@@ -40,7 +40,9 @@ public class CreateFunctionStmtBase extends StatementBase {
     INIT_FN,          // Only used for Udas
     SERIALIZE_FN,     // Only used for Udas
     MERGE_FN,         // Only used for Udas
-    FINALIZE_FN       // Only used for Udas
+    FINALIZE_FN,      // Only used for Udas
+    BATCH_SYMBOL,     // Only used for native Udfs
+    UPDATE_BATCH_FN   // Only used for native Udas
   };
 
   protected final Function fn_;
@@ -114,6 +116,32 @@ public class CreateFunctionStmtBase extends StatementBase {
     }
   }
 
+  // Returns the symbol of the batch version of this function set in optArg[key], or
+  // null if it is not set. The batch version takes untyped columns and can't be told
+  // apart by its arguments, so unlike the other symbols, it is not resolved from the
+  // function's argument types: 'symbol' must exist in the binary exactly as given.
+  protected String lookupBatchSymbol(OptArg key) throws AnalysisException {
+    String symbol = optArgs_.get(key);
+    if (symbol == null) return null;
+    if (fn_.getBinaryType() != TFunctionBinaryType.NATIVE) {
+      throw new AnalysisException(
+          "Argument '" + key + "' is only supported for native functions.");
+    }
+    // The binary was already loaded to look up the other symbols, so any failure means
+    // that the symbol itself is missing.
+    String found = null;
+    try {
+      found = lookupSymbol(symbol, null, false);
+    } catch (AnalysisException e) {
+      // Reported below.
+    }
+    if (!symbol.equals(found)) {
+      throw new AnalysisException("Could not find symbol '" + symbol + "' in: " +
+          fn_.getLocation().getLocation());
+    }
+    return symbol;
+  }
+
   // Returns optArg[key], first validating that it is set.
   protected String checkAndGetOptArg(OptArg key)
       throws AnalysisException {
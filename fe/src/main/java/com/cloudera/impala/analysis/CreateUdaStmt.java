@@ -61,6 +61,7 @@ public class CreateUdaStmt extends CreateFunctionStmtBase {
     udaFn.setSerialize_fn_symbol(uda_.getSerializeFnSymbol());
     udaFn.setMerge_fn_symbol(uda_.getMergeFnSymbol());
     udaFn.setFinalize_fn_symbol(uda_.getFinalizeFnSymbol());
+    udaFn.setUpdate_batch_fn_symbol(uda_.getUpdateBatchFnSymbol());
     udaFn.setIntermediate_type(uda_.getIntermediateType().toThrift());
     params.getFn().setAggregate_fn(udaFn);
     return params;
@@ -111,9 +112,6 @@ public class CreateUdaStmt extends CreateFunctionStmtBase {
 
     // TODO: these are temporarily restrictions since the BE cannot yet
     // execute them.
-    if (uda_.getBinaryType() == TFunctionBinaryType.IR) {
-      throw new AnalysisException("IR UDAs are not yet supported.");
-    }
     if (fn_.hasVarArgs()) {
       throw new AnalysisException("UDAs with varargs are not yet supported.");
     }
@@ -143,11 +141,13 @@ public class CreateUdaStmt extends CreateFunctionStmtBase {
 
     // Check arguments that are only valid in UDFs are not set.
     checkOptArgNotSet(OptArg.SYMBOL);
+    checkOptArgNotSet(OptArg.BATCH_SYMBOL);
 
     // The user must provide the symbol for Update.
     uda_.setUpdateFnSymbol(lookupSymbol(
         checkAndGetOptArg(OptArg.UPDATE_FN), intermediateType_, fn_.hasVarArgs(),
         fn_.getArgs()));
+    uda_.setUpdateBatchFnSymbol(lookupBatchSymbol(OptArg.UPDATE_BATCH_FN));
 
     // If the ddl did not specify the init/serialize/merge/finalize function
     // Symbols, guess them based on the update fn Symbol.
@@ -214,6 +214,9 @@ public class CreateUdaStmt extends CreateFunctionStmtBase {
     if (uda_.getFinalizeFnSymbol() != null) {
       sb.append(" FINALIZE_FN=").append(uda_.getFinalizeFnSymbol());
     }
+    if (uda_.getUpdateBatchFnSymbol() != null) {
+      sb.append(" UPDATE_BATCH_FN=").append(uda_.getUpdateBatchFnSymbol());
+    }
     if (getComment() != null) sb.append(" COMMENT = '" + getComment() + "'");
     sqlString_ = sb.toString();
   }
@@ -53,6 +53,7 @@ public class CreateUdfStmt extends CreateFunctionStmtBase {
     TCreateFunctionParams params = super.toThrift();
     TScalarFunction udf = new TScalarFunction();
     udf.setSymbol(udf_.getSymbolName());
+    udf.setBatch_symbol(udf_.getBatchSymbolName());
     params.getFn().setScalar_fn(udf);
     return params;
   }
@@ -79,6 +80,7 @@ public class CreateUdfStmt extends CreateFunctionStmtBase {
     udf_.setSymbolName(lookupSymbol(
         checkAndGetOptArg(OptArg.SYMBOL), null, fn_.hasVarArgs(),
         fn_.getArgs()));
+    udf_.setBatchSymbolName(lookupBatchSymbol(OptArg.BATCH_SYMBOL));
 
     // Udfs should not set any of these
     checkOptArgNotSet(OptArg.UPDATE_FN);
@@ -86,6 +88,7 @@ public class CreateUdfStmt extends CreateFunctionStmtBase {
     checkOptArgNotSet(OptArg.SERIALIZE_FN);
     checkOptArgNotSet(OptArg.MERGE_FN);
     checkOptArgNotSet(OptArg.FINALIZE_FN);
+    checkOptArgNotSet(OptArg.UPDATE_BATCH_FN);
 
     StringBuilder sb = new StringBuilder("CREATE ");
     sb.append("FUNCTION ");
@@ -94,6 +97,9 @@ public class CreateUdfStmt extends CreateFunctionStmtBase {
       .append(" RETURNS ").append(udf_.getReturnType())
       .append(" LOCATION ").append(udf_.getLocation())
       .append(" SYMBOL=").append(udf_.getSymbolName());
+    if (udf_.getBatchSymbolName() != null) {
+      sb.append(" BATCH_SYMBOL=").append(udf_.getBatchSymbolName());
+    }
     if (getComment() != null) sb.append(" COMMENT = '" + getComment() + "'");
     sqlString_ = sb.toString();
   }
@@ -64,6 +64,13 @@ public class CatalogDeltaLog {
     removedCatalogObjects_ = removedCatalogObjects_.tailMap(currentCatalogVersion);
   }
 
+  /**
+   * Removes all items from the log.
+   */
+  public synchronized void clear() {
+    removedCatalogObjects_.clear();
+  }
+
   /**
    * Checks if a matching catalog object was removed in a catalog version after this
    * object's catalog version. Returns true if there was a matching object that was
@@ -238,6 +238,16 @@ public class CatalogObjectCache<T extends CatalogObject> {
     return cacheEntry.reload();
   }
 
+  /**
+   * Returns the currently cached catalog object for the given name without triggering
+   * a metadata load. Returns null if there is no CacheEntry associated with this key
+   * or if its metadata is not loaded.
+   */
+  public T get(String name) {
+    CacheEntry<T> cacheEntry = metadataCache_.get(name.toLowerCase());
+    return cacheEntry != null ? cacheEntry.value() : null;
+  }
+
   /**
    * Returns all known object names.
    */
@@ -78,6 +78,8 @@ public class CatalogServiceCatalog extends Catalog {
    * Returns all known objects in the Catalog (Tables, Views, Databases, and
    * Functions). Some metadata may be skipped for objects that have a catalog
    * version < the specified "fromVersion".
+   * Tables are only returned as headers (their name and catalog version); impalads
+   * fetch the full table metadata from the catalog server on first access.
    */
   public TGetAllCatalogObjectsResponse getCatalogObjects(long fromVersion) {
     TGetAllCatalogObjectsResponse resp = new TGetAllCatalogObjectsResponse();
@@ -110,15 +112,22 @@ public class CatalogServiceCatalog extends Catalog {
             continue;
           }
 
-          // Only add the extended metadata if this table's version is >=
-          // the fromVersion.
+          // Only add the version if this table's version is >= the fromVersion.
           if (tbl.getCatalogVersion() >= fromVersion) {
-            try {
-              catalogTbl.setTable(tbl.toThrift());
-            } catch (Exception e) {
-              LOG.debug(String.format("Error calling toThrift() on table %s.%s: %s",
-                  dbName, tblName, e.getMessage()), e);
-              continue;
+            // Incomplete tables are small and carry the cause of any load failure, so
+            // they are sent in full. Loaded tables are sent as a header; broadcasting
+            // their partitions, file descriptors and block locations to every impalad
+            // would dominate the size of the topic.
+            if (tbl instanceof IncompleteTable) {
+              try {
+                catalogTbl.setTable(tbl.toThrift());
+              } catch (Exception e) {
+                LOG.debug(String.format("Error calling toThrift() on table %s.%s: %s",
+                    dbName, tblName, e.getMessage()), e);
+                continue;
+              }
+            } else {
+              catalogTbl.setTable(new TTable(dbName, tblName));
             }
             catalogTbl.setCatalog_version(tbl.getCatalogVersion());
           } else {
@@ -91,6 +91,14 @@ public class Db implements CatalogObject {
     return tableCache_.getOrLoad(tblName);
   }
 
+  /**
+   * Returns the Table with the given name if its metadata is present in the table
+   * cache. Unlike getTable(), never triggers a metadata load.
+   */
+  public Table getCachedTable(String tblName) {
+    return tableCache_.get(tblName);
+  }
+
   /**
    * Adds a table to the table cache.
    */
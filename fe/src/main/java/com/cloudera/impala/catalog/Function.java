@@ -249,9 +249,11 @@ public class Function implements CatalogObject {
 
     Function function = null;
     if (fn.isSetScalar_fn()) {
-      function = new Udf(FunctionName.fromThrift(fn.getName()), argTypes,
+      Udf udf = new Udf(FunctionName.fromThrift(fn.getName()), argTypes,
           ColumnType.fromThrift(fn.getRet_type()), new HdfsUri(fn.getHdfs_location()),
           fn.getScalar_fn().getSymbol());
+      udf.setBatchSymbolName(fn.getScalar_fn().getBatch_symbol());
+      function = udf;
     } else if (fn.isSetAggregate_fn()) {
       TAggregateFunction aggFn = fn.getAggregate_fn();
       function = new Uda(FunctionName.fromThrift(fn.getName()), argTypes,
@@ -260,6 +262,7 @@ public class Function implements CatalogObject {
           new HdfsUri(fn.getHdfs_location()), aggFn.getUpdate_fn_symbol(),
           aggFn.getInit_fn_symbol(), aggFn.getSerialize_fn_symbol(),
           aggFn.getMerge_fn_symbol(), aggFn.getFinalize_fn_symbol());
+      ((Uda) function).setUpdateBatchFnSymbol(aggFn.getUpdate_batch_fn_symbol());
     } else {
       throw new IllegalStateException("Expected function type to be either UDA or UDF.");
     }
@@ -15,8 +15,10 @@
 package com.cloudera.impala.catalog;
 
 import java.io.IOException;
+import java.lang.reflect.Method;
 import java.util.Arrays;
 import java.util.List;
+import java.util.Set;
 import java.util.concurrent.atomic.AtomicLong;
 
 import org.apache.commons.lang.ArrayUtils;
@@ -32,6 +34,7 @@ import com.cloudera.impala.analysis.PartitionKeyValue;
 import com.cloudera.impala.thrift.ImpalaInternalServiceConstants;
 import com.cloudera.impala.thrift.TAccessLevel;
 import com.cloudera.impala.thrift.TExpr;
+import com.cloudera.impala.thrift.THdfsCompression;
 import com.cloudera.impala.thrift.THdfsFileBlock;
 import com.cloudera.impala.thrift.THdfsFileDesc;
 import com.cloudera.impala.thrift.THdfsPartition;
@@ -41,6 +44,7 @@ import com.google.common.base.Objects;
 import com.google.common.base.Preconditions;
 import com.google.common.collect.ImmutableList;
 import com.google.common.collect.Lists;
+import com.google.common.collect.Sets;
 
 /**
  * Query-relevant information for one table partition. Partitions are comparable
@@ -60,6 +64,9 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
 
     public String getFilePath() { return fileDescriptor_.getPath(); }
     public long getFileLength() { return fileDescriptor_.getLength(); }
+    public THdfsCompression getFileCompression() {
+      return fileDescriptor_.getCompression();
+    }
     public long getModificationTime() {
       return fileDescriptor_.getLast_modification_time();
     }
@@ -108,6 +115,10 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
    * File Block metadata
    */
   public static class FileBlock {
+    // BlockLocation.getCachedHosts(), or null if the HDFS client predates HDFS caching.
+    // Looked up by reflection so that Impala still builds against such clients.
+    private static final Method GET_CACHED_HOSTS = getCachedHostsMethod();
+
     private final THdfsFileBlock fileBlock_;
 
     private FileBlock(THdfsFileBlock fileBlock) {
@@ -116,7 +127,8 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
 
     /**
      * Construct a FileBlock from blockLocation and populate the network address
-     * locations of this block from BlockLocation.getNames(). Does not fill diskIds.
+     * locations of this block from BlockLocation.getNames(), and which of them are
+     * cached from BlockLocation.getCachedHosts(). Does not fill diskIds.
      */
     public FileBlock(String fileName, long fileSize, BlockLocation blockLocation) {
       Preconditions.checkNotNull(blockLocation);
@@ -128,8 +140,10 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
 
       // result of BlockLocation.getNames(): list of (IP:port) hosting this block
       String[] blockHostPorts;
+      String[] blockHosts;
       try {
         blockHostPorts = blockLocation.getNames();
+        blockHosts = blockLocation.getHosts();
       } catch (IOException e) {
         // this shouldn't happen, getNames() doesn't throw anything
         String errorMsg = "BlockLocation.getNames() failed:\n" + e.getMessage();
@@ -146,6 +160,39 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
         fileBlock_.network_addresses.add(new TNetworkAddress(ip_port[0],
             Integer.parseInt(ip_port[1])));
       }
+
+      // getCachedHosts() returns host names, which are ordered like getNames() in
+      // getHosts().
+      Set<String> cachedHosts = getCachedHosts(blockLocation);
+      if (cachedHosts != null && blockHosts.length == blockHostPorts.length) {
+        List<Boolean> isReplicaCached = Lists.newArrayList();
+        for (int i = 0; i < blockHosts.length; ++i) {
+          isReplicaCached.add(cachedHosts.contains(blockHosts[i]));
+        }
+        fileBlock_.setIs_replica_cached(isReplicaCached);
+      }
+    }
+
+    private static Method getCachedHostsMethod() {
+      try {
+        return BlockLocation.class.getMethod("getCachedHosts");
+      } catch (NoSuchMethodException e) {
+        return null;
+      }
+    }
+
+    /**
+     * Returns the hosts that cache the block in memory, or null if the HDFS client does
+     * not report cached replicas.
+     */
+    private static Set<String> getCachedHosts(BlockLocation blockLocation) {
+      if (GET_CACHED_HOSTS == null) return null;
+      try {
+        return Sets.newHashSet((String[]) GET_CACHED_HOSTS.invoke(blockLocation));
+      } catch (Exception e) {
+        LOG.warn("BlockLocation.getCachedHosts() failed: " + e.getMessage());
+        return null;
+      }
     }
 
     public String getFileName() { return fileBlock_.getFile_name(); }
@@ -178,6 +225,17 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
       return fileBlock_.getDisk_ids().get(hostIndex);
     }
 
+    /**
+     * Returns true if the replica at BlockLocation.getNames()[hostIndex] is cached in
+     * memory by its datanode; false if it is not or caching is not reported.
+     */
+    public boolean isCached(int hostIndex) {
+      if (fileBlock_.is_replica_cached == null) return false;
+      Preconditions.checkArgument(hostIndex >= 0);
+      Preconditions.checkArgument(hostIndex < fileBlock_.getIs_replica_cachedSize());
+      return fileBlock_.getIs_replica_cached().get(hostIndex);
+    }
+
     public THdfsFileBlock toThrift() { return fileBlock_; }
 
     public static FileBlock fromThrift(THdfsFileBlock thriftFileBlock) {
@@ -335,7 +393,8 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
    * Returns an empty string if the file format is supported, otherwise a string with
    * details on the incompatibility is returned.
    * Impala only supports .lzo on text files for partitions that have been declared in
-   * the metastore as TEXT_LZO. For now, raise an error on any other type.
+   * the metastore as TEXT_LZO, and .gz on text files (which must be block gzip
+   * compressed). For now, raise an error on any other type.
    */
   public String checkFileCompressionTypeSupported(String fileName) {
     // Check to see if the file has a compression suffix.
@@ -356,7 +415,9 @@ public class HdfsPartition implements Comparable<HdfsPartition> {
     } else if (sd.getFileFormat() == HdfsFileFormat.LZO_TEXT) {
       return "Expected file with .lzo suffix: " + fileName;
     } else if (sd.getFileFormat() == HdfsFileFormat.TEXT
-               && compressionType != HdfsCompression.NONE) {
+               && compressionType != HdfsCompression.NONE
+               && compressionType != HdfsCompression.GZIP) {
+      // Gzip text files are read in the block gzip (BGZF) format, which is splittable.
       return "Compressed text files are not supported: " + fileName;
     }
     return "";
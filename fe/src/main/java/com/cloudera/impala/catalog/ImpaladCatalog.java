@@ -16,9 +16,13 @@ package com.cloudera.impala.catalog;
 
 import java.util.EnumSet;
 import java.util.Iterator;
+import java.util.LinkedHashMap;
 import java.util.List;
+import java.util.Map;
 import java.util.Random;
+import java.util.Set;
 import java.util.UUID;
+import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
 import java.util.concurrent.ScheduledExecutorService;
 import java.util.concurrent.TimeUnit;
@@ -48,6 +52,8 @@ import com.cloudera.impala.thrift.TUniqueId;
 import com.cloudera.impala.thrift.TUpdateCatalogCacheRequest;
 import com.cloudera.impala.thrift.TUpdateCatalogCacheResponse;
 import com.google.common.base.Preconditions;
+import com.google.common.collect.Lists;
+import com.google.common.collect.Sets;
 
 /**
  * Thread safe Catalog for an Impalad. The Impalad Catalog provides an interface to
@@ -60,10 +66,16 @@ import com.google.common.base.Preconditions;
  * applying the result of a catalog operation to the CatalogCache. Updates applied using
  * the updateCatalog() function which takes the catalogLock_.writeLock() for the duration
  * of its execution to ensure all updates are applied atomically.
- * Table metadata is loaded lazily. The CatalogServer initially broadcasts (via the
- * statestore) the known table names (as IncompleteTables). These table names are added
- * to the Impalad catalog cache and when one of the tables is accessed, the impalad will
- * make an RPC to the CatalogServer to load the complete table metadata.
+ * Table metadata is loaded lazily. The CatalogServer only broadcasts (via the
+ * statestore) table headers: the table name and its catalog version. These table names
+ * are added to the Impalad catalog cache and when one of the tables is accessed, the
+ * impalad will make an RPC to the CatalogServer to load the complete table metadata.
+ * A header with a newer version than the cached table invalidates the cached metadata.
+ * The number of tables with loaded metadata can be bounded, in which case the least
+ * recently used tables have their metadata dropped (but stay known by name). Tables
+ * that are loaded when a newer version is published may be refreshed in the
+ * background, so the next query against a frequently used table does not wait for
+ * the load.
  * In both cases, we need to ensure that work from one update is not "undone" by another
  * update. To handle this the ImpaladCatalog does the following:
  * - Tracks the overall catalog version last received in a state store heartbeat, this
@@ -83,6 +95,9 @@ import com.google.common.base.Preconditions;
  * privilege checks should go through this class.
  * The CatalogServiceId is also tracked to detect if a different instance of the catalog
  * service has been started, in which case a full topic update is required.
+ * A full (non-delta) topic update from the same catalog service is applied to the
+ * existing cache: objects missing from the update are removed and tables whose
+ * version did not change keep their loaded metadata.
  */
 public class ImpaladCatalog extends Catalog {
   private static final Logger LOG = Logger.getLogger(ImpaladCatalog.class);
@@ -109,18 +124,57 @@ public class ImpaladCatalog extends Catalog {
   // Tracks modifications to this Impalad's catalog from direct updates to the cache.
   private final CatalogDeltaLog catalogDeltaLog_ = new CatalogDeltaLog();
 
+  // Number of threads used to refresh table metadata in the background.
+  private static final int NUM_TABLE_REFRESH_THREADS = 4;
+
+  // The maximum number of tables with loaded metadata. If <= 0, there is no limit.
+  private final int maxLoadedTables_;
+
+  // If set, refreshes the metadata of loaded tables in the background when a newer
+  // version of the table is published. Null if background refresh is disabled.
+  private final ExecutorService tableRefreshExecutor_;
+
+  // Tables with loaded metadata, keyed by lower-case fully qualified table name, in
+  // least recently accessed order. Only maintained if maxLoadedTables_ > 0 or
+  // background refresh is enabled. Tables whose metadata was invalidated are removed,
+  // so the map never holds on to stale metadata. Protected by synchronizing on the map.
+  private final LinkedHashMap<String, Table> loadedTables_ =
+      new LinkedHashMap<String, Table>(16, 0.75f, true);
+
   public ImpaladCatalog(AuthorizationConfig authzConfig) {
     this(CatalogInitStrategy.EMPTY, authzConfig);
   }
 
+  /**
+   * Creates an empty catalog that keeps the metadata of at most maxLoadedTables
+   * tables loaded (no limit if <= 0) and, if refreshHotTables is true, refreshes loaded
+   * tables in the background when a newer version is published.
+   */
+  public ImpaladCatalog(AuthorizationConfig authzConfig, int maxLoadedTables,
+      boolean refreshHotTables) {
+    this(CatalogInitStrategy.EMPTY, authzConfig, maxLoadedTables, refreshHotTables);
+  }
+
   /**
    * C'tor used by tests that need to validate the ImpaladCatalog outside of the
    * CatalogServer.
    */
   public ImpaladCatalog(CatalogInitStrategy loadStrategy,
       AuthorizationConfig authzConfig) {
+    this(loadStrategy, authzConfig, 0, false);
+  }
+
+  /**
+   * C'tor used by tests that need to validate the eviction and refresh of loaded
+   * tables outside of the CatalogServer.
+   */
+  public ImpaladCatalog(CatalogInitStrategy loadStrategy,
+      AuthorizationConfig authzConfig, int maxLoadedTables, boolean refreshHotTables) {
     super(loadStrategy);
     authzConfig_ = authzConfig;
+    maxLoadedTables_ = maxLoadedTables;
+    tableRefreshExecutor_ = refreshHotTables ?
+        Executors.newFixedThreadPool(NUM_TABLE_REFRESH_THREADS) : null;
     authzChecker_ = new AuthorizationChecker(authzConfig);
     // If authorization is enabled, reload the policy on a regular basis.
     if (authzConfig.isEnabled()) {
@@ -208,9 +262,10 @@ public class ImpaladCatalog extends Catalog {
    * 3) Removes all dropped tables, views, and functions
    * 4) Removes all dropped databases
    *
-   * This method is called once per statestore heartbeat and is guaranteed the same
+   * This method is called once per statestore topic update and is guaranteed the same
    * object will not be in both the "updated" list and the "removed" list (it is
-   * a detail handled by the statestore). This method takes the catalogLock_ writeLock
+   * a detail handled by the statestore). If the update is not a delta, any object not
+   * in the update is removed first. This method takes the catalogLock_ writeLock
    * for the duration of the method to ensure all updates are applied atomically. Since
    * updates are sent from the statestore as deltas, this should generally not block
    * execution for a significant amount of time.
@@ -224,20 +279,30 @@ public class ImpaladCatalog extends Catalog {
       // Check for changes in the catalog service ID.
       if (!catalogServiceId_.equals(req.getCatalog_service_id())) {
         boolean firstRun = catalogServiceId_.equals(INITIAL_CATALOG_SERVICE_ID);
-        catalogServiceId_ = req.getCatalog_service_id();
         if (!firstRun) {
           // Throw an exception which will trigger a full topic update request.
-          throw new CatalogException("Detected catalog service ID change. Aborting " +
-              "updateCatalog()");
+          if (req.is_delta) {
+            throw new CatalogException("Detected catalog service ID change. Aborting " +
+                "updateCatalog()");
+          }
+          // The cached objects are versioned by a different catalog service, so their
+          // versions can't be compared to the ones in this update.
+          clearCachedObjects();
         }
+        catalogServiceId_ = req.getCatalog_service_id();
       }
 
-      // First process all updates
       long newCatalogVersion = lastSyncedCatalogVersion_;
       for (TCatalogObject catalogObject: req.getUpdated_objects()) {
         if (catalogObject.getType() == TCatalogObjectType.CATALOG) {
           newCatalogVersion = catalogObject.getCatalog_version();
-        } else {
+        }
+      }
+      if (!req.is_delta) removeObjectsNotInUpdate(req, newCatalogVersion);
+
+      // First process all updates
+      for (TCatalogObject catalogObject: req.getUpdated_objects()) {
+        if (catalogObject.getType() != TCatalogObjectType.CATALOG) {
           try {
             addCatalogObject(catalogObject);
           } catch (Exception e) {
@@ -352,6 +417,7 @@ public class ImpaladCatalog extends Catalog {
       if (cause instanceof TableLoadingException) throw (TableLoadingException) cause;
       throw new TableLoadingException("Missing metadata for table: " + tableName, cause);
     }
+    if (table != null) markTableAccessed(table);
     return table;
   }
 
@@ -535,11 +601,17 @@ public class ImpaladCatalog extends Catalog {
     Table newTable = Table.fromThrift(db, thriftTable);
     newTable.setCatalogVersion(catalogVersion);
 
-    // If this is an uninitialized table, don't just add the table name to
-    // the metadata cache. The next access will trigger a metadata load.
+    // If this is an uninitialized table (a table header), just add the table name to
+    // the metadata cache. The next access will trigger a metadata load. Metadata that
+    // is at least as new as the header is kept.
     if (newTable instanceof IncompleteTable
         && ((IncompleteTable) newTable).isUninitialized()) {
+      Table cachedTable = db.getCachedTable(newTable.getName());
+      if (cachedTable != null && cachedTable.getCatalogVersion() >= catalogVersion) {
+        return;
+      }
       db.addTableName(newTable.getName());
+      if (cachedTable != null) onTableInvalidated(db, newTable.getName());
     } else {
       db.addTable(newTable);
     }
@@ -575,6 +647,7 @@ public class ImpaladCatalog extends Catalog {
     Table table = db.getTable(thriftTable.getTbl_name());
     if (table != null && table.getCatalogVersion() < dropCatalogVersion) {
       db.removeTable(thriftTable.tbl_name);
+      forgetLoadedTable(db.getName(), thriftTable.tbl_name);
     }
   }
 
@@ -591,10 +664,156 @@ public class ImpaladCatalog extends Catalog {
     }
   }
 
+  /**
+   * Removes all databases, tables and functions and resets the synced catalog version.
+   * Must be called with the catalogLock_ writeLock held.
+   */
+  private void clearCachedObjects() {
+    dbCache_.clear();
+    lastSyncedCatalogVersion_ = Catalog.INITIAL_CATALOG_VERSION;
+    catalogDeltaLog_.clear();
+    synchronized (loadedTables_) {
+      loadedTables_.clear();
+    }
+  }
+
+  /**
+   * Removes all databases, tables and functions that are not part of the full catalog
+   * update req, unless they were added by a direct update that is newer than the
+   * update (has a version > catalogVersion). Must be called with the catalogLock_
+   * writeLock held.
+   */
+  private void removeObjectsNotInUpdate(TUpdateCatalogCacheRequest req,
+      long catalogVersion) {
+    Set<String> dbNames = Sets.newHashSet();
+    Set<String> tableNames = Sets.newHashSet();
+    Set<String> fnNames = Sets.newHashSet();
+    for (TCatalogObject catalogObject: req.getUpdated_objects()) {
+      switch (catalogObject.getType()) {
+        case DATABASE:
+          dbNames.add(catalogObject.getDb().getDb_name().toLowerCase());
+          break;
+        case TABLE:
+        case VIEW:
+          tableNames.add(getLoadedTableKey(catalogObject.getTable().getDb_name(),
+              catalogObject.getTable().getTbl_name()));
+          break;
+        case FUNCTION:
+          fnNames.add(catalogObject.getFn().getName().getDb_name().toLowerCase() + "." +
+              catalogObject.getFn().getSignature());
+          break;
+        default:
+          break;
+      }
+    }
+
+    for (String dbName: Lists.newArrayList(dbCache_.keySet())) {
+      Db db = dbCache_.get(dbName);
+      if (!dbNames.contains(dbName)) {
+        if (db.getCatalogVersion() <= catalogVersion) dbCache_.remove(dbName);
+        continue;
+      }
+      for (String tblName: db.getAllTableNames()) {
+        if (tableNames.contains(getLoadedTableKey(dbName, tblName))) continue;
+        Table table = db.getCachedTable(tblName);
+        if (table == null || table.getCatalogVersion() <= catalogVersion) {
+          db.removeTable(tblName);
+          forgetLoadedTable(dbName, tblName);
+        }
+      }
+      for (String signature: db.getAllFunctionSignatures(null)) {
+        if (fnNames.contains(dbName + "." + signature)) continue;
+        Function fn = db.getFunction(signature);
+        if (fn != null && fn.getCatalogVersion() <= catalogVersion) {
+          db.removeFunction(signature);
+        }
+      }
+    }
+  }
+
+  private static String getLoadedTableKey(String dbName, String tblName) {
+    return (dbName + "." + tblName).toLowerCase();
+  }
+
+  /**
+   * Records an access to a table with loaded metadata. If there are more than
+   * maxLoadedTables_ loaded tables, the metadata of the least recently accessed tables
+   * is invalidated; it is loaded again from the catalog server on next access.
+   */
+  private void markTableAccessed(Table table) {
+    if (maxLoadedTables_ <= 0 && tableRefreshExecutor_ == null) return;
+    List<Table> evictedTables = Lists.newArrayList();
+    synchronized (loadedTables_) {
+      loadedTables_.put(getLoadedTableKey(table.getDb().getName(), table.getName()),
+          table);
+      Iterator<Map.Entry<String, Table>> it = loadedTables_.entrySet().iterator();
+      while (maxLoadedTables_ > 0 && loadedTables_.size() > maxLoadedTables_) {
+        evictedTables.add(it.next().getValue());
+        it.remove();
+      }
+    }
+    // Invalidate outside of the loadedTables_ lock, since it may need to wait for an
+    // in-progress load of the same table.
+    for (Table evictedTable: evictedTables) {
+      LOG.debug("Evicting metadata of table: " + evictedTable.getFullName());
+      evictedTable.getDb().invalidateTable(evictedTable.getName());
+    }
+  }
+
+  private void forgetLoadedTable(String dbName, String tblName) {
+    synchronized (loadedTables_) {
+      loadedTables_.remove(getLoadedTableKey(dbName, tblName));
+    }
+  }
+
+  /**
+   * Called when the loaded metadata of a table was invalidated because a newer version
+   * was published. The stale metadata no longer counts as loaded. If background
+   * refresh is enabled and the table was loaded, starts loading the new version, which
+   * counts as loaded again once the load finishes.
+   */
+  private void onTableInvalidated(final Db db, final String tblName) {
+    synchronized (loadedTables_) {
+      if (loadedTables_.remove(getLoadedTableKey(db.getName(), tblName)) == null) return;
+    }
+    if (tableRefreshExecutor_ == null) return;
+    tableRefreshExecutor_.submit(new Runnable() {
+      public void run() {
+        try {
+          // Loads the table, or waits for a concurrent load by a query to finish.
+          Table table = db.getTable(tblName);
+          // Skip tables that were invalidated or dropped again during the load.
+          if (table != null && !(table instanceof IncompleteTable)
+              && db.getCachedTable(tblName) == table) {
+            markTableAccessed(table);
+          }
+        } catch (Exception e) {
+          LOG.error("Error refreshing metadata for table: " + db.getName() + "." +
+              tblName, e);
+        }
+      }
+    });
+  }
+
   /**
    * Returns true if the ImpaladCatalog is ready to accept requests (has
    * received and processed a valid catalog topic update from the StateStore),
    * false otherwise.
    */
   public boolean isReady() { return isReady_.get(); }
+
+  /**
+   * Returns the number of tables that count as loaded. Package visible for testing.
+   */
+  int getNumLoadedTables() {
+    synchronized (loadedTables_) {
+      return loadedTables_.size();
+    }
+  }
+
+  @Override
+  public void close() {
+    if (tableRefreshExecutor_ != null) tableRefreshExecutor_.shutdownNow();
+    super.close();
+  }
 }
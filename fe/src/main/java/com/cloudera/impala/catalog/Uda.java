@@ -36,6 +36,7 @@ public class Uda extends Function {
   private String serializeFnSymbol_;
   private String mergeFnSymbol_;
   private String finalizeFnSymbol_;
+  private String updateBatchFnSymbol_;
 
   public Uda(FunctionName fnName, FunctionArgs args, ColumnType retType) {
     super(fnName, args.argTypes, retType, args.hasVarArgs);
@@ -60,6 +61,7 @@ public class Uda extends Function {
   public String getSerializeFnSymbol() { return serializeFnSymbol_; }
   public String getMergeFnSymbol() { return mergeFnSymbol_; }
   public String getFinalizeFnSymbol() { return finalizeFnSymbol_; }
+  public String getUpdateBatchFnSymbol() { return updateBatchFnSymbol_; }
   public ColumnType getIntermediateType() { return intermediateType_; }
 
   public void setUpdateFnSymbol(String fn) { updateFnSymbol_ = fn; }
@@ -67,6 +69,7 @@ public class Uda extends Function {
   public void setSerializeFnSymbol(String fn) { serializeFnSymbol_ = fn; }
   public void setMergeFnSymbol(String fn) { mergeFnSymbol_ = fn; }
   public void setFinalizeFnSymbol(String fn) { finalizeFnSymbol_ = fn; }
+  public void setUpdateBatchFnSymbol(String fn) { updateBatchFnSymbol_ = fn; }
   public void setIntermediateType(ColumnType t) { intermediateType_ = t; }
 
   @Override
@@ -78,6 +81,7 @@ public class Uda extends Function {
     if (serializeFnSymbol_ == null) uda.setSerialize_fn_symbol(serializeFnSymbol_);
     uda.setMerge_fn_symbol(mergeFnSymbol_);
     uda.setFinalize_fn_symbol(finalizeFnSymbol_);
+    uda.setUpdate_batch_fn_symbol(updateBatchFnSymbol_);
     uda.setIntermediate_type(intermediateType_.toThrift());
     fn.setAggregate_fn(uda);
     return fn;
@@ -34,6 +34,9 @@ public class Udf extends Function {
   // UDF. e.g. org.example.MyUdf.class.
   private String symbolName_;
 
+  // The symbol of the optional batch version of the UDF. Null if it has none.
+  private String batchSymbolName_;
+
   public Udf(FunctionName fnName, FunctionArgs args, ColumnType retType) {
     super(fnName, args.argTypes, retType, args.hasVarArgs);
   }
@@ -47,12 +50,15 @@ public class Udf extends Function {
 
   public void setSymbolName(String s) { symbolName_ = s; }
   public String getSymbolName() { return symbolName_; }
+  public void setBatchSymbolName(String s) { batchSymbolName_ = s; }
+  public String getBatchSymbolName() { return batchSymbolName_; }
 
   @Override
   public TFunction toThrift() {
     TFunction fn = super.toThrift();
     fn.setScalar_fn(new TScalarFunction());
     fn.getScalar_fn().setSymbol(symbolName_);
+    fn.getScalar_fn().setBatch_symbol(batchSymbolName_);
     return fn;
   }
 }
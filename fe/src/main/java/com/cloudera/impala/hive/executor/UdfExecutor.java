@@ -24,6 +24,7 @@ import java.net.URLClassLoader;
 import java.util.ArrayList;
 
 import org.apache.hadoop.hive.ql.exec.UDF;
+import org.apache.hadoop.hive.ql.udf.UDFType;
 import org.apache.hadoop.hive.serde2.io.ByteWritable;
 import org.apache.hadoop.hive.serde2.io.DoubleWritable;
 import org.apache.hadoop.hive.serde2.io.ShortWritable;
@@ -59,6 +60,9 @@ public class UdfExecutor {
   // By convention, the function in the class must be called evaluate()
   private static final String UDF_FUNCTION_NAME = "evaluate";
 
+  // Number of rows evaluateBatch() can be called with when testing.
+  static final int TEST_BATCH_CAPACITY = 16;
+
   // Object to deserialize ctor params from BE.
   private final static TBinaryProtocol.Factory protocolFactory =
     new TBinaryProtocol.Factory();
@@ -90,6 +94,25 @@ public class UdfExecutor {
   // Size of outBufferStringPtr_.
   private int outBufferCapacity_;
 
+  // Buffers for evaluateBatch(), allocated in the BE. See THiveUdfExecutorCtorParams
+  // for their layout. batchCapacity_ is 0 if the BE didn't pass them.
+  private final int batchCapacity_;
+  private final long[] inputBatchPtrs_;
+  private final long inputBatchNullsPtr_;
+  private final long outputBatchPtr_;
+  private final long outputBatchNullsPtr_;
+
+  // The string results of evaluateBatch() are copied here; the StringValues in
+  // outputBatchPtr_ point into it until the next call. This is allocated from the FE
+  // and grows as necessary.
+  private long batchStringArenaPtr_;
+  private int batchStringArenaCapacity_;
+
+  // False if the UDF is marked as not deterministic or as stateful. Its results may
+  // then depend on which rows it is called for, and in which order, so it must not
+  // be called for rows before they are needed.
+  private boolean isBatchSafe_;
+
   // Preconstructed input objects for the UDF. This minimizes object creation overhead
   // as these objects are reused across calls to evaluate().
   private Object[] inputObjects_;
@@ -124,6 +147,22 @@ public class UdfExecutor {
     for (int i = 0; i < request.input_byte_offsets.size(); ++i) {
       inputBufferOffsets_[i] = request.input_byte_offsets.get(i).intValue();
     }
+    if (request.isSetBatch_capacity()) {
+      batchCapacity_ = request.batch_capacity;
+      inputBatchPtrs_ = new long[request.input_batch_ptrs.size()];
+      for (int i = 0; i < request.input_batch_ptrs.size(); ++i) {
+        inputBatchPtrs_[i] = request.input_batch_ptrs.get(i).longValue();
+      }
+      inputBatchNullsPtr_ = request.input_batch_nulls_ptr;
+      outputBatchPtr_ = request.output_batch_ptr;
+      outputBatchNullsPtr_ = request.output_batch_nulls_ptr;
+    } else {
+      batchCapacity_ = 0;
+      inputBatchPtrs_ = new long[0];
+      inputBatchNullsPtr_ = 0;
+      outputBatchPtr_ = 0;
+      outputBatchNullsPtr_ = 0;
+    }
 
     init(jarFile, className, retType, parameterTypes);
   }
@@ -159,6 +198,22 @@ public class UdfExecutor {
     outBufferStringPtr_ = 0;
     outBufferCapacity_ = 0;
 
+    batchCapacity_ = TEST_BATCH_CAPACITY;
+    inputBatchPtrs_ = new long[parameterTypes.length];
+    for (int i = 0; i < parameterTypes.length; ++i) {
+      inputBatchPtrs_[i] = UnsafeUtil.UNSAFE.allocateMemory(
+          batchCapacity_ * parameterTypes[i].getSlotSize());
+      allocations_.add(inputBatchPtrs_[i]);
+    }
+    inputBatchNullsPtr_ =
+        UnsafeUtil.UNSAFE.allocateMemory(batchCapacity_ * parameterTypes.length);
+    outputBatchPtr_ = UnsafeUtil.UNSAFE.allocateMemory(
+        batchCapacity_ * retType.getSlotSize());
+    outputBatchNullsPtr_ = UnsafeUtil.UNSAFE.allocateMemory(batchCapacity_);
+    allocations_.add(inputBatchNullsPtr_);
+    allocations_.add(outputBatchPtr_);
+    allocations_.add(outputBatchNullsPtr_);
+
     init(jarFile, udfPath, retType, parameterTypes);
   }
 
@@ -176,6 +231,9 @@ public class UdfExecutor {
     UnsafeUtil.UNSAFE.freeMemory(outBufferStringPtr_);
     outBufferStringPtr_ = 0;
     outBufferCapacity_ = 0;
+    UnsafeUtil.UNSAFE.freeMemory(batchStringArenaPtr_);
+    batchStringArenaPtr_ = 0;
+    batchStringArenaCapacity_ = 0;
 
     for (long ptr: allocations_) {
       UnsafeUtil.UNSAFE.freeMemory(ptr);
@@ -203,6 +261,80 @@ public class UdfExecutor {
     }
   }
 
+  /**
+   * Returns true if the backend may call evaluateBatch().
+   */
+  public boolean canEvaluateBatch() {
+    return batchCapacity_ > 0 && isBatchSafe_;
+  }
+
+  /**
+   * Evaluates the UDF over the first numRows rows of the batch input buffers and
+   * writes the results to the batch output buffers. Called by the backend to evaluate
+   * a row batch with a single JNI call.
+   */
+  public void evaluateBatch(int numRows) throws ImpalaRuntimeException {
+    Preconditions.checkState(canEvaluateBatch());
+    Preconditions.checkState(numRows <= batchCapacity_);
+    int retSlotSize = retType_.getSlotSize();
+    boolean isStringRet = retType_.getPrimitiveType() == PrimitiveType.STRING;
+    int arenaLen = 0;
+    try {
+      for (int row = 0; row < numRows; ++row) {
+        // Copy this row's inputs to the buffer the input objects read from.
+        for (int i = 0; i < argTypes_.length; ++i) {
+          if (UnsafeUtil.UNSAFE.getByte(inputBatchNullsPtr_ + i * batchCapacity_ + row)
+              == 0) {
+            int slotSize = argTypes_[i].getSlotSize();
+            UnsafeUtil.UNSAFE.copyMemory(inputBatchPtrs_[i] + row * slotSize,
+                inputBufferPtr_ + inputBufferOffsets_[i], slotSize);
+            inputArgs_[i] = inputObjects_[i];
+          } else {
+            inputArgs_[i] = null;
+          }
+        }
+
+        Object result = method_.invoke(udf_, inputArgs_);
+        long outputPtr = outputBatchPtr_ + row * retSlotSize;
+        if (result == null) {
+          UnsafeUtil.UNSAFE.putByte(outputBatchNullsPtr_ + row, (byte)1);
+          continue;
+        }
+        UnsafeUtil.UNSAFE.putByte(outputBatchNullsPtr_ + row, (byte)0);
+        if (!isStringRet) {
+          storeFixedLengthResult(result, outputPtr);
+          continue;
+        }
+
+        byte[] bytes = getStringBytes(result);
+        int len = getStringLength(result, bytes);
+        if (arenaLen + len > batchStringArenaCapacity_) {
+          batchStringArenaCapacity_ =
+              Math.max(arenaLen + len, 2 * batchStringArenaCapacity_);
+          batchStringArenaPtr_ = UnsafeUtil.UNSAFE.reallocateMemory(
+              batchStringArenaPtr_, batchStringArenaCapacity_);
+        }
+        UnsafeUtil.Copy(batchStringArenaPtr_ + arenaLen, bytes, 0, len);
+        // The arena may still move, so store the offset and fix up the ptrs below.
+        UnsafeUtil.UNSAFE.putLong(outputPtr, arenaLen);
+        UnsafeUtil.UNSAFE.putInt(
+            outputPtr + ImpalaStringWritable.STRING_VALUE_LEN_OFFSET, len);
+        arenaLen += len;
+      }
+    } catch (Exception e) {
+      // The backend retries the rows one at a time and reports the failing ones.
+      throw new ImpalaRuntimeException("UDF::evaluateBatch() ran into a problem.", e);
+    }
+
+    if (!isStringRet) return;
+    for (int row = 0; row < numRows; ++row) {
+      if (UnsafeUtil.UNSAFE.getByte(outputBatchNullsPtr_ + row) != 0) continue;
+      long outputPtr = outputBatchPtr_ + row * retSlotSize;
+      UnsafeUtil.UNSAFE.putLong(
+          outputPtr, batchStringArenaPtr_ + UnsafeUtil.UNSAFE.getLong(outputPtr));
+    }
+  }
+
   /**
    * Evalutes the UDF with 'args' as the input to the UDF. This is exposed
    * for testing and not the version of evaluate() the backend uses.
@@ -224,6 +356,12 @@ public class UdfExecutor {
 
   public Method getMethod() { return method_; }
 
+  // Batch buffers, exposed for testing.
+  long getInputBatchPtr(int i) { return inputBatchPtrs_[i]; }
+  long getInputBatchNullsPtr() { return inputBatchNullsPtr_; }
+  long getOutputBatchPtr() { return outputBatchPtr_; }
+  long getOutputBatchNullsPtr() { return outputBatchNullsPtr_; }
+
   // Returns the primitive type that c is for. 'c' is expected to be
   // a subclass of Writable. This is a many to one mapping: e.g. many
   // writables map to the same type.
@@ -261,76 +399,96 @@ public class UdfExecutor {
 
     UnsafeUtil.UNSAFE.putByte(outputNullPtr_, (byte)0);
 
+    if (retType_.getPrimitiveType() != PrimitiveType.STRING) {
+      storeFixedLengthResult(obj, outputBufferPtr_);
+      return;
+    }
+
+    byte[] bytes = getStringBytes(obj);
+    if (bytes.length > outBufferCapacity_) {
+      outBufferStringPtr_ =
+          UnsafeUtil.UNSAFE.reallocateMemory(outBufferStringPtr_, bytes.length);
+      outBufferCapacity_ = bytes.length;
+      UnsafeUtil.UNSAFE.putLong(outputBufferPtr_, outBufferStringPtr_);
+    }
+    UnsafeUtil.Copy(outBufferStringPtr_, bytes, 0, bytes.length);
+    UnsafeUtil.UNSAFE.putInt(
+        outputBufferPtr_ + ImpalaStringWritable.STRING_VALUE_LEN_OFFSET,
+        bytes.length);
+  }
+
+  // Writes the non-null, non-string result 'obj' to 'ptr'.
+  private void storeFixedLengthResult(Object obj, long ptr) {
     switch (retType_.getPrimitiveType()) {
       case BOOLEAN: {
         BooleanWritable val = (BooleanWritable)obj;
-        UnsafeUtil.UNSAFE.putByte(outputBufferPtr_, val.get() ? (byte)1 : 0);
+        UnsafeUtil.UNSAFE.putByte(ptr, val.get() ? (byte)1 : 0);
         return;
       }
       case TINYINT: {
         ByteWritable val = (ByteWritable)obj;
-        UnsafeUtil.UNSAFE.putByte(outputBufferPtr_, val.get());
+        UnsafeUtil.UNSAFE.putByte(ptr, val.get());
         return;
       }
       case SMALLINT: {
         ShortWritable val = (ShortWritable)obj;
-        UnsafeUtil.UNSAFE.putShort(outputBufferPtr_, val.get());
+        UnsafeUtil.UNSAFE.putShort(ptr, val.get());
         return;
       }
       case INT: {
         IntWritable val = (IntWritable)obj;
-        UnsafeUtil.UNSAFE.putInt(outputBufferPtr_, val.get());
+        UnsafeUtil.UNSAFE.putInt(ptr, val.get());
         return;
       }
       case BIGINT: {
         LongWritable val = (LongWritable)obj;
-        UnsafeUtil.UNSAFE.putLong(outputBufferPtr_, val.get());
+        UnsafeUtil.UNSAFE.putLong(ptr, val.get());
         return;
       }
       case FLOAT: {
         FloatWritable val = (FloatWritable)obj;
-        UnsafeUtil.UNSAFE.putFloat(outputBufferPtr_, val.get());
+        UnsafeUtil.UNSAFE.putFloat(ptr, val.get());
         return;
       }
       case DOUBLE: {
         DoubleWritable val = (DoubleWritable)obj;
-        UnsafeUtil.UNSAFE.putDouble(outputBufferPtr_, val.get());
-        return;
-      }
-      case STRING: {
-        byte[] bytes = null;
-        if (obj instanceof byte[]) {
-          bytes = (byte[]) obj;
-        } else if (obj instanceof BytesWritable) {
-          bytes = ((BytesWritable)obj).getBytes();
-        } else if (obj instanceof Text) {
-          bytes = ((Text)obj).getBytes();
-        }
-
-        if (bytes == null) {
-          // TODO: the returned string type is not one we expect
-          System.err.println("Unexpected return type: " + obj.getClass());
-          Preconditions.checkArgument(false);
-        }
-
-        if (bytes.length > outBufferCapacity_) {
-          outBufferStringPtr_ =
-              UnsafeUtil.UNSAFE.reallocateMemory(outBufferStringPtr_, bytes.length);
-          outBufferCapacity_ = bytes.length;
-          UnsafeUtil.UNSAFE.putLong(outputBufferPtr_, outBufferStringPtr_);
-        }
-        UnsafeUtil.Copy(outBufferStringPtr_, bytes, 0, bytes.length);
-        UnsafeUtil.UNSAFE.putInt(
-            outputBufferPtr_ + ImpalaStringWritable.STRING_VALUE_LEN_OFFSET,
-            bytes.length);
+        UnsafeUtil.UNSAFE.putDouble(ptr, val.get());
         return;
       }
+      case STRING:
       case TIMESTAMP:
       default:
         Preconditions.checkArgument(false);
     }
   }
 
+  // Returns the bytes of the string result 'obj'.
+  private byte[] getStringBytes(Object obj) {
+    byte[] bytes = null;
+    if (obj instanceof byte[]) {
+      bytes = (byte[]) obj;
+    } else if (obj instanceof BytesWritable) {
+      bytes = ((BytesWritable)obj).getBytes();
+    } else if (obj instanceof Text) {
+      bytes = ((Text)obj).getBytes();
+    }
+
+    if (bytes == null) {
+      // TODO: the returned string type is not one we expect
+      System.err.println("Unexpected return type: " + obj.getClass());
+      Preconditions.checkArgument(false);
+    }
+    return bytes;
+  }
+
+  // Returns the length of the string result 'obj', whose bytes are 'bytes'. The byte
+  // arrays of writables may be longer than their contents.
+  private int getStringLength(Object obj, byte[] bytes) {
+    if (obj instanceof BytesWritable) return ((BytesWritable)obj).getLength();
+    if (obj instanceof Text) return ((Text)obj).getLength();
+    return bytes.length;
+  }
+
   // Preallocate the input objects that will be passed to the underlying UDF.
   // These objects are allocated once and reused across calls to evaluate()
   private void allocateInputObjects() {
@@ -403,6 +561,9 @@ public class UdfExecutor {
       Class<? extends UDF> udfClass = c.asSubclass(UDF.class);
       Constructor<? extends UDF> ctor = udfClass.getConstructor();
       udf_ = ctor.newInstance();
+      // UDFs without the annotation are deterministic and not stateful.
+      UDFType udfType = udfClass.getAnnotation(UDFType.class);
+      isBatchSafe_ = udfType == null || (udfType.deterministic() && !udfType.stateful());
       retType_ = retType;
       argTypes_ = parameterTypes;
       Method[] methods = udfClass.getMethods();
@@ -254,6 +254,7 @@ public class HdfsScanNode extends ScanNode {
             TScanRangeLocation location = new TScanRangeLocation();
             location.setServer(blockNetworkAddresses.get(i));
             location.setVolume_id(block.getDiskId(i));
+            location.setIs_cached(block.isCached(i));
             locations.add(location);
           }
 
@@ -266,9 +267,10 @@ public class HdfsScanNode extends ScanNode {
               currentLength = maxScanRangeLength;
             }
             TScanRange scanRange = new TScanRange();
-            scanRange.setHdfs_file_split(
-                new THdfsFileSplit(block.getFileName(), currentOffset,
-                  currentLength, partition.getId(), block.getFileSize()));
+            THdfsFileSplit split = new THdfsFileSplit(block.getFileName(),
+                currentOffset, currentLength, partition.getId(), block.getFileSize());
+            split.setFile_compression(fileDesc.getFileCompression());
+            scanRange.setHdfs_file_split(split);
             TScanRangeLocations scanRangeLocations = new TScanRangeLocations();
             scanRangeLocations.scan_range = scanRange;
             scanRangeLocations.locations = locations;
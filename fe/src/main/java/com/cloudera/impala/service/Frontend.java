@@ -101,13 +101,23 @@ import com.google.common.collect.Maps;
  */
 public class Frontend {
   private final static Logger LOG = LoggerFactory.getLogger(Frontend.class);
-  private ImpaladCatalog impaladCatalog_;
+  private final ImpaladCatalog impaladCatalog_;
   private final AuthorizationConfig authzConfig_;
 
   public Frontend(AuthorizationConfig authorizationConfig) {
     this(Catalog.CatalogInitStrategy.EMPTY, authorizationConfig);
   }
 
+  /**
+   * See ImpaladCatalog for the meaning of maxLoadedTables and refreshHotTables.
+   */
+  public Frontend(AuthorizationConfig authorizationConfig, int maxLoadedTables,
+      boolean refreshHotTables) {
+    authzConfig_ = authorizationConfig;
+    impaladCatalog_ = new ImpaladCatalog(authzConfig_, maxLoadedTables,
+        refreshHotTables);
+  }
+
   // C'tor used by some tests.
   public Frontend(Catalog.CatalogInitStrategy initStrategy,
       AuthorizationConfig authorizationConfig) {
@@ -119,17 +129,9 @@ public class Frontend {
 
   public TUpdateCatalogCacheResponse updateCatalogCache(
       TUpdateCatalogCacheRequest req) throws CatalogException {
-    ImpaladCatalog catalog = impaladCatalog_;
-
-    // If this is not a delta, this update should replace the current
-    // Catalog contents so create a new catalog and populate it.
-    if (!req.is_delta) {
-      catalog = new ImpaladCatalog(Catalog.CatalogInitStrategy.EMPTY,
-          authzConfig_);
-    }
-    TUpdateCatalogCacheResponse response = catalog.updateCatalog(req);
-    if (!req.is_delta) impaladCatalog_ = catalog;
-    return response;
+    // Non-delta updates are applied to the existing catalog, which replaces its
+    // contents but keeps the metadata of tables that did not change.
+    return impaladCatalog_.updateCatalog(req);
   }
 
   /**
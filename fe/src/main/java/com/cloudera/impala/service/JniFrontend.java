@@ -89,8 +89,8 @@ public class JniFrontend {
    * Create a new instance of the Jni Frontend.
    */
   public JniFrontend(boolean lazy, String serverName, String authorizationPolicyFile,
-      String policyProviderClassName, int impalaLogLevel, int otherLogLevel)
-      throws InternalException {
+      String policyProviderClassName, int impalaLogLevel, int otherLogLevel,
+      int maxLoadedTables, boolean refreshHotTables) throws InternalException {
     GlogAppender.Install(TLogLevel.values()[impalaLogLevel],
         TLogLevel.values()[otherLogLevel]);
 
@@ -99,7 +99,7 @@ public class JniFrontend {
     AuthorizationConfig authorizationConfig = new AuthorizationConfig(serverName,
         authorizationPolicyFile, policyProviderClassName);
     authorizationConfig.validateConfig();
-    frontend_ = new Frontend(authorizationConfig);
+    frontend_ = new Frontend(authorizationConfig, maxLoadedTables, refreshHotTables);
   }
 
   /**
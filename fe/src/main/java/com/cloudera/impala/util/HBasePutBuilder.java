@@ -0,0 +1,62 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.cloudera.impala.util;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.List;
+
+import org.apache.hadoop.hbase.client.Put;
+
+/**
+ * Called by the backend's HBaseTableWriter to turn a serialized row batch into Puts with
+ * a single JNI call, rather than calling into Java for every row and every value.
+ *
+ * Layout of a batch, with all lengths, counts and indexes as little-endian ints:
+ *   num_rows
+ *   for each row: row_key_length, row_key, num_values,
+ *     for each value: column, value_length, value
+ * Columns index into the families and qualifiers passed to createPuts(). NULL values
+ * are left out.
+ */
+public class HBasePutBuilder {
+  /**
+   * Returns a Put for every row of batch, which is serialized as described above.
+   */
+  public static List<Put> createPuts(byte[] batch, byte[][] families,
+      byte[][] qualifiers) {
+    ByteBuffer buffer = ByteBuffer.wrap(batch).order(ByteOrder.LITTLE_ENDIAN);
+    int numRows = buffer.getInt();
+    List<Put> puts = new ArrayList<Put>(numRows);
+    for (int i = 0; i < numRows; ++i) {
+      Put put = new Put(getBytes(buffer));
+      int numValues = buffer.getInt();
+      for (int j = 0; j < numValues; ++j) {
+        int column = buffer.getInt();
+        put.add(families[column], qualifiers[column], getBytes(buffer));
+      }
+      puts.add(put);
+    }
+    return puts;
+  }
+
+  // Reads a length followed by that many bytes from buffer.
+  private static byte[] getBytes(ByteBuffer buffer) {
+    byte[] result = new byte[buffer.getInt()];
+    buffer.get(result);
+    return result;
+  }
+}
@@ -0,0 +1,94 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.cloudera.impala.util;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import org.apache.hadoop.hbase.KeyValue;
+import org.apache.hadoop.hbase.client.Result;
+import org.apache.hadoop.hbase.client.ResultScanner;
+
+/**
+ * Called by the backend's HBaseTableScanner to fetch a batch of rows from a
+ * ResultScanner with a single JNI call. The rows are serialized into one byte array,
+ * which the backend decodes directly into tuples, rather than calling back into Java
+ * for every row and every part of every cell.
+ *
+ * Layout of a batch, with all lengths and counts as little-endian ints:
+ *   num_rows
+ *   for each row: row_key_length, row_key, num_cells,
+ *     for each cell: family_length, family, qualifier_length, qualifier,
+ *                    value_length, value
+ * The cells of a row are in the order HBase returns them, i.e. sorted by family and
+ * qualifier.
+ *
+ * Only KeyValue methods that exist in all supported HBase versions are used, which is
+ * why this uses the deprecated Result.raw() rather than Result.rawCells().
+ */
+@SuppressWarnings("deprecation")
+public class HBaseResultSerializer {
+  private static final int INT_SIZE = 4;
+
+  /**
+   * Returns the next maxRows rows (or fewer) of scanner, serialized as described above.
+   * Returns null if the scanner has no more rows.
+   */
+  public static byte[] nextBatch(ResultScanner scanner, int maxRows)
+      throws IOException {
+    Result[] results = scanner.next(maxRows);
+    if (results == null || results.length == 0) return null;
+    return serialize(results);
+  }
+
+  /**
+   * Serializes results, none of which may be empty, as described above.
+   */
+  public static byte[] serialize(Result[] results) {
+    int size = INT_SIZE;
+    for (Result result: results) {
+      KeyValue[] cells = result.raw();
+      size += 2 * INT_SIZE + cells[0].getRowLength();
+      for (KeyValue cell: cells) {
+        size += 3 * INT_SIZE + cell.getFamilyLength() + cell.getQualifierLength()
+            + cell.getValueLength();
+      }
+    }
+
+    ByteBuffer buffer = ByteBuffer.allocate(size).order(ByteOrder.LITTLE_ENDIAN);
+    buffer.putInt(results.length);
+    for (Result result: results) {
+      KeyValue[] cells = result.raw();
+      // All cells of a row have the same row key.
+      put(buffer, cells[0].getBuffer(), cells[0].getRowOffset(),
+          cells[0].getRowLength());
+      buffer.putInt(cells.length);
+      for (KeyValue cell: cells) {
+        byte[] data = cell.getBuffer();
+        put(buffer, data, cell.getFamilyOffset(), cell.getFamilyLength());
+        put(buffer, data, cell.getQualifierOffset(), cell.getQualifierLength());
+        put(buffer, data, cell.getValueOffset(), cell.getValueLength());
+      }
+    }
+    return buffer.array();
+  }
+
+  // Writes length followed by data[offset, offset + length) to buffer.
+  private static void put(ByteBuffer buffer, byte[] data, int offset, int length) {
+    buffer.putInt(length);
+    buffer.put(data, offset, length);
+  }
+}
@@ -872,6 +872,27 @@ public class AnalyzeDDLTest extends AnalyzerTest {
         "smallint, int, bigint, float, double) returns int " +
         "location '/test-warehouse/libTestUdfs.so' symbol='AllTypes'");
 
+    // Batch versions are looked up by their exact symbol.
+    AnalyzesOk("create function foo(int, int) RETURNS int " +
+        "LOCATION '/test-warehouse/libTestUdfs.so' " +
+        "SYMBOL='AddInts' BATCH_SYMBOL='AddIntsBatch'");
+    AnalysisError("create function foo(int, int) RETURNS int " +
+        "LOCATION '/test-warehouse/libTestUdfs.so' " +
+        "SYMBOL='AddInts' BATCH_SYMBOL='AddInts'",
+        "Could not find symbol 'AddInts' in: " + hdfsPath);
+    AnalysisError("create function foo(int, int) RETURNS int " +
+        "LOCATION '/test-warehouse/libTestUdfs.so' " +
+        "SYMBOL='AddInts' BATCH_SYMBOL='addIntsBatch'",
+        "Could not find symbol 'addIntsBatch' in: " + hdfsPath);
+    AnalysisError("create function foo(int, int) RETURNS int " +
+        "LOCATION '/test-warehouse/test-udfs.ll' " +
+        "SYMBOL='AddInts' BATCH_SYMBOL='AddIntsBatch'",
+        "Argument 'BATCH_SYMBOL' is only supported for native functions.");
+    AnalysisError("create function foo(int, int) RETURNS int " +
+        "LOCATION '/test-warehouse/libTestUdfs.so' " +
+        "SYMBOL='AddInts' UPDATE_BATCH_FN='AddIntsBatch'",
+        "Optional argument 'UPDATE_BATCH_FN' should not be set.");
+
     // Try creating functions with illegal function names.
     AnalysisError("create function 123A() RETURNS int" + udfSuffix,
         "Function cannot start with a digit: 123a");
@@ -1020,6 +1041,16 @@ public class AnalyzeDDLTest extends AnalyzerTest {
     // Udf only arguments must not be set.
     AnalysisError("create aggregate function foo(int) RETURNS int" + loc + "SYMBOL='Bad'",
         "Optional argument 'SYMBOL' should not be set.");
+    AnalysisError("create aggregate function foo(int) RETURNS int" + loc +
+        "UPDATE_FN='AggUpdate' BATCH_SYMBOL='AggUpdateBatch'",
+        "Optional argument 'BATCH_SYMBOL' should not be set.");
+
+    // Batch update functions are looked up by their exact symbol.
+    AnalyzesOk("create aggregate function foo(int) RETURNS int" + loc +
+        "UPDATE_FN='AggUpdate' UPDATE_BATCH_FN='AggUpdateBatch'");
+    AnalysisError("create aggregate function foo(int) RETURNS int" + loc +
+        "UPDATE_FN='AggUpdate' UPDATE_BATCH_FN='AggUpdate'",
+        "Could not find symbol 'AggUpdate' in: " + hdfsLoc);
 
     // Invalid char(0) type.
     AnalysisError("create aggregate function foo(int) RETURNS int " +
@@ -1030,13 +1061,11 @@ public class AnalyzeDDLTest extends AnalyzerTest {
     AnalysisError("create aggregate function foo(int) RETURNS int LOCATION " +
         "'/foo.jar' UPDATE_FN='b'", "Java UDAs are not supported.");
 
-    // Test missing .ll file. TODO: reenable when we can run IR UDAs
+    // Test missing .ll file.
+    AnalysisError("create aggregate function foo(int) RETURNS int LOCATION " +
+        "'/foo.ll' UPDATE_FN='Fn'", "Could not load binary: /foo.ll");
     AnalysisError("create aggregate function foo(int) RETURNS int LOCATION " +
-            "'/foo.ll' UPDATE_FN='Fn'", "IR UDAs are not yet supported.");
-    //AnalysisError("create aggregate function foo(int) RETURNS int LOCATION " +
-    //    "'/foo.ll' UPDATE_FN='Fn'", "Could not load binary: /foo.ll");
-    //AnalysisError("create aggregate function foo(int) RETURNS int LOCATION " +
-    //    "'/foo.ll' UPDATE_FN='_ZABCD'", "Could not load binary: /foo.ll");
+        "'/foo.ll' UPDATE_FN='_ZABCD'", "Could not load binary: /foo.ll");
 
     // Test cases where the UPDATE_FN doesn't contain "Update" in which case the user has
     // to explicitly specify the other functions.
@@ -1304,6 +1304,8 @@ public class ParserTest {
         "'f.jar' SYMBOL='class.Udf' COMMENT='hi'");
     ParsesOk("CREATE FUNCTION IF NOT EXISTS Foo() RETURNS INT LOCATION 'foo.jar' " +
         "SYMBOL='class.Udf'");
+    ParsesOk("CREATE FUNCTION Foo(INT) RETURNS INT LOCATION 'f.so' SYMBOL='Udf' " +
+        "BATCH_SYMBOL='UdfBatch'");
 
     // Try more interesting function names
     ParsesOk("CREATE FUNCTION User.Foo() RETURNS INT LOCATION 'a'");
@@ -1327,6 +1329,7 @@ public class ParserTest {
     ParserError("CREATE FUNCTION Foo() RETURNS INT SYMBOL='1' LOCATION 'a'");
     ParserError("CREATE FUNCTION Foo() RETURNS INT LOCATION 'a' SYMBOL");
     ParserError("CREATE FUNCTION Foo() RETURNS INT LOCATION 'a' SYMBOL='1' SYMBOL='2'");
+    ParserError("CREATE FUNCTION Foo() RETURNS INT LOCATION 'a' BATCH_SYMBOL");
 
     // Missing arguments
     ParserError("CREATE FUNCTION Foo RETURNS INT LOCATION 'f.jar'");
@@ -1370,10 +1373,12 @@ public class ParserTest {
     ParsesOk(c + loc + "merge_fn='M' Init_fn='I' serialize_fn='S' Finalize_fn='F'");
     ParsesOk(c + loc + "Init_fn='M' Finalize_fn='I' merge_fn='S' serialize_fn='F'");
     ParsesOk(c + loc + "merge_fn='M'");
+    ParsesOk(c + loc + "update_batch_fn='UB' merge_fn='M'");
     ParsesOk(c + "INTERMEDIATE CHAR(10)" + loc);
 
     ParserError("CREATE UNKNOWN FUNCTION " + "Foo() RETURNS INT" + loc);
     ParserError(c + loc + "init_fn='1' init_fn='1'");
+    ParserError(c + loc + "update_batch_fn='1' update_batch_fn='1'");
     ParserError(c + loc + "unknown='1'");
 
     // CHAR must specify size
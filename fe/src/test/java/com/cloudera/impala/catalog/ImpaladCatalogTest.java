@@ -0,0 +1,150 @@
+// Copyright 2014 Cloudera Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package com.cloudera.impala.catalog;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNotSame;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+
+import org.junit.Test;
+
+import com.cloudera.impala.authorization.AuthorizationConfig;
+import com.cloudera.impala.authorization.Privilege;
+import com.cloudera.impala.authorization.User;
+import com.cloudera.impala.catalog.Catalog.CatalogInitStrategy;
+import com.cloudera.impala.thrift.TCatalogObject;
+import com.cloudera.impala.thrift.TCatalogObjectType;
+import com.cloudera.impala.thrift.TTable;
+import com.cloudera.impala.thrift.TUniqueId;
+import com.cloudera.impala.thrift.TUpdateCatalogCacheRequest;
+import com.google.common.collect.Lists;
+
+/**
+ * Tests the eviction and invalidation of loaded table metadata in the ImpaladCatalog.
+ */
+public class ImpaladCatalogTest {
+  private static final User USER = new User("test_user");
+
+  private static ImpaladCatalog createCatalog(int maxLoadedTables,
+      boolean refreshHotTables) {
+    return new ImpaladCatalog(CatalogInitStrategy.LAZY,
+        AuthorizationConfig.createAuthDisabledConfig(), maxLoadedTables,
+        refreshHotTables);
+  }
+
+  private static Table getTable(ImpaladCatalog catalog, String tblName)
+      throws Exception {
+    return catalog.getTable("functional", tblName, USER, Privilege.SELECT);
+  }
+
+  /**
+   * Applies a catalog update that publishes a header of the given table with the given
+   * catalog version.
+   */
+  private static void publishHeader(ImpaladCatalog catalog, Table table, long version)
+      throws CatalogException {
+    TCatalogObject header = new TCatalogObject(TCatalogObjectType.TABLE, version);
+    header.setTable(new TTable(table.getDb().getName(), table.getName()));
+    TUpdateCatalogCacheRequest req = new TUpdateCatalogCacheRequest(true,
+        new TUniqueId(1L, 1L), Lists.newArrayList(header),
+        Lists.<TCatalogObject>newArrayList());
+    catalog.updateCatalog(req);
+  }
+
+  @Test
+  public void TestEviction() throws Exception {
+    ImpaladCatalog catalog = createCatalog(2, false);
+    try {
+      Db db = catalog.getDb("functional");
+      getTable(catalog, "alltypes");
+      getTable(catalog, "alltypestiny");
+      assertEquals(2, catalog.getNumLoadedTables());
+      // Accessing alltypes makes alltypestiny the least recently used table.
+      getTable(catalog, "alltypes");
+      getTable(catalog, "alltypessmall");
+      assertEquals(2, catalog.getNumLoadedTables());
+      assertNull(db.getCachedTable("alltypestiny"));
+      assertNotNull(db.getCachedTable("alltypes"));
+      assertNotNull(db.getCachedTable("alltypessmall"));
+
+      // Evicted tables stay known by name and are loaded again on the next access.
+      assertTrue(catalog.containsTable("functional", "alltypestiny"));
+      assertNotNull(getTable(catalog, "alltypestiny"));
+      assertEquals(2, catalog.getNumLoadedTables());
+      assertNull(db.getCachedTable("alltypes"));
+    } finally {
+      catalog.close();
+    }
+  }
+
+  @Test
+  public void TestInvalidation() throws Exception {
+    ImpaladCatalog catalog = createCatalog(10, false);
+    try {
+      Db db = catalog.getDb("functional");
+      Table table = getTable(catalog, "alltypes");
+      assertEquals(1, catalog.getNumLoadedTables());
+
+      // A header at the cached version keeps the loaded metadata.
+      publishHeader(catalog, table, table.getCatalogVersion());
+      assertSame(table, db.getCachedTable("alltypes"));
+
+      // A newer header drops the stale metadata, which no longer counts as loaded.
+      publishHeader(catalog, table, table.getCatalogVersion() + 1);
+      assertNull(db.getCachedTable("alltypes"));
+      assertEquals(0, catalog.getNumLoadedTables());
+      Table newTable = getTable(catalog, "alltypes");
+      assertNotSame(table, newTable);
+      assertEquals(1, catalog.getNumLoadedTables());
+    } finally {
+      catalog.close();
+    }
+  }
+
+  @Test
+  public void TestBackgroundRefresh() throws Exception {
+    ImpaladCatalog catalog = createCatalog(10, true);
+    try {
+      Db db = catalog.getDb("functional");
+      Table table = getTable(catalog, "alltypes");
+      // Never loaded, so it is not refreshed.
+      Table header = IncompleteTable.createUninitializedTable(
+          TableId.createInvalidId(), db, "alltypestiny");
+
+      publishHeader(catalog, table, table.getCatalogVersion() + 1);
+      publishHeader(catalog, header, header.getCatalogVersion() + 1);
+      // The stale metadata is dropped right away, not when the refresh finishes.
+      assertNotSame(table, db.getCachedTable("alltypes"));
+
+      // The new version is loaded in the background and counts as loaded again.
+      for (int i = 0; i < 100 && db.getCachedTable("alltypes") == null; ++i) {
+        Thread.sleep(100);
+      }
+      Table refreshedTable = db.getCachedTable("alltypes");
+      assertNotNull(refreshedTable);
+      assertNotSame(table, refreshedTable);
+      for (int i = 0; i < 100 && catalog.getNumLoadedTables() == 0; ++i) {
+        Thread.sleep(100);
+      }
+      assertEquals(1, catalog.getNumLoadedTables());
+      assertNull(db.getCachedTable("alltypestiny"));
+    } finally {
+      catalog.close();
+    }
+  }
+}
@@ -16,6 +16,7 @@ package com.cloudera.impala.hive.executor;
 
 import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertTrue;
 
 import java.lang.reflect.Method;
@@ -295,6 +296,55 @@ public class UdfExecutorTest {
     TestUdf(HIVE_BUILTIN_JAR, c, expectedValue, getType(expectedValue), false, args);
   }
 
+  @Test
+  // Tests evaluating several rows with one call, including NULL inputs and results.
+  public void BatchTest() throws ImpalaRuntimeException, MalformedURLException {
+    UdfExecutor e = new UdfExecutor(HIVE_BUILTIN_JAR, UDFAbs.class.getName(),
+        ColumnType.INT, ColumnType.INT);
+    int[] inputs = new int[] { -1, 2, 0, -30 };
+    for (int row = 0; row < inputs.length; ++row) {
+      UnsafeUtil.UNSAFE.putInt(e.getInputBatchPtr(0) + row * 4, inputs[row]);
+      UnsafeUtil.UNSAFE.putByte(
+          e.getInputBatchNullsPtr() + row, (byte)(row == 2 ? 1 : 0));
+    }
+    assertTrue(e.canEvaluateBatch());
+    e.evaluateBatch(inputs.length);
+    for (int row = 0; row < inputs.length; ++row) {
+      boolean isNull = UnsafeUtil.UNSAFE.getByte(e.getOutputBatchNullsPtr() + row) != 0;
+      assertEquals(row == 2, isNull);
+      if (isNull) continue;
+      assertEquals(Math.abs(inputs[row]),
+          UnsafeUtil.UNSAFE.getInt(e.getOutputBatchPtr() + row * 4));
+    }
+    e.close();
+
+    e = new UdfExecutor(HIVE_BUILTIN_JAR, UDFUpper.class.getName(),
+        ColumnType.STRING, ColumnType.STRING);
+    String[] strings = new String[] { "abc", "", "Hello World" };
+    for (int row = 0; row < strings.length; ++row) {
+      UnsafeUtil.UNSAFE.copyMemory(createStringValue(strings[row]),
+          e.getInputBatchPtr(0) + row * 16, 16);
+      UnsafeUtil.UNSAFE.putByte(e.getInputBatchNullsPtr() + row, (byte)0);
+    }
+    // Twice, so that the second call reuses the string arena.
+    for (int i = 0; i < 2; ++i) {
+      e.evaluateBatch(strings.length);
+      for (int row = 0; row < strings.length; ++row) {
+        assertEquals(0, UnsafeUtil.UNSAFE.getByte(e.getOutputBatchNullsPtr() + row));
+        ImpalaStringWritable sw =
+            new ImpalaStringWritable(e.getOutputBatchPtr() + row * 16);
+        assertArrayEquals(strings[row].toUpperCase().getBytes(), sw.getBytes());
+      }
+    }
+    e.close();
+
+    // Nondeterministic UDFs must be evaluated one row at a time.
+    e = new UdfExecutor(HIVE_BUILTIN_JAR, UDFRand.class.getName(), ColumnType.DOUBLE);
+    assertFalse(e.canEvaluateBatch());
+    e.close();
+    freeAllocations();
+  }
+
   @Test
   // Tests all the hive math UDFs. We are not trying to thoroughly test that the Hive
   // UDFs are correct (i.e. replicate expr-test). The most interesting thing to test for
@@ -210,6 +210,9 @@ public class ImpaladClientExecutor {
         case EXPLAIN_LEVEL:
           optionValue = String.valueOf(queryOptions.getExplain_level());
           break;
+        case TEXT_COMPRESSION_CODEC:
+          optionValue = String.valueOf(queryOptions.getText_compression_codec());
+          break;
         default:
           Preconditions.checkState(false, "Unhandled option:" + option.toString());
       }
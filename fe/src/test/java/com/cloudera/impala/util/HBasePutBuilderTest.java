@@ -0,0 +1,65 @@
+// Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+
+package com.cloudera.impala.util;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.List;
+
+import org.apache.hadoop.hbase.KeyValue;
+import org.apache.hadoop.hbase.client.Put;
+import org.apache.hadoop.hbase.util.Bytes;
+import org.junit.Test;
+
+/**
+ * Checks that the batches serialized by the backend's HBaseTableWriter are turned into
+ * the expected Puts.
+ */
+public class HBasePutBuilderTest {
+  private static void putBytes(ByteBuffer buffer, String s) {
+    byte[] bytes = Bytes.toBytes(s);
+    buffer.putInt(bytes.length);
+    buffer.put(bytes);
+  }
+
+  private static void assertValue(Put put, String family, String qualifier,
+      String value) {
+    List<KeyValue> cells = put.get(Bytes.toBytes(family), Bytes.toBytes(qualifier));
+    assertEquals(1, cells.size());
+    assertArrayEquals(Bytes.toBytes(value), cells.get(0).getValue());
+  }
+
+  @Test
+  public void testCreatePuts() {
+    byte[][] families = { Bytes.toBytes("d"), Bytes.toBytes("d"), Bytes.toBytes("f") };
+    byte[][] qualifiers = { Bytes.toBytes("a"), Bytes.toBytes("b"), Bytes.toBytes("c") };
+
+    ByteBuffer buffer = ByteBuffer.allocate(1024).order(ByteOrder.LITTLE_ENDIAN);
+    buffer.putInt(2);
+    putBytes(buffer, "row1");
+    buffer.putInt(2);
+    buffer.putInt(0);
+    putBytes(buffer, "1");
+    buffer.putInt(2);
+    putBytes(buffer, "");
+    putBytes(buffer, "row2");
+    buffer.putInt(1);
+    buffer.putInt(1);
+    putBytes(buffer, "value");
+
+    List<Put> puts = HBasePutBuilder.createPuts(buffer.array(), families, qualifiers);
+    assertEquals(2, puts.size());
+    assertArrayEquals(Bytes.toBytes("row1"), puts.get(0).getRow());
+    assertEquals(2, puts.get(0).size());
+    assertValue(puts.get(0), "d", "a", "1");
+    assertValue(puts.get(0), "f", "c", "");
+    assertFalse(puts.get(0).has(Bytes.toBytes("d"), Bytes.toBytes("b")));
+    assertArrayEquals(Bytes.toBytes("row2"), puts.get(1).getRow());
+    assertEquals(1, puts.get(1).size());
+    assertValue(puts.get(1), "d", "b", "value");
+  }
+}
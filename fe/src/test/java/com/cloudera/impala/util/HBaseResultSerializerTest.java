@@ -0,0 +1,104 @@
+// Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+
+package com.cloudera.impala.util;
+
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Arrays;
+import java.util.Iterator;
+
+import org.apache.hadoop.hbase.KeyValue;
+import org.apache.hadoop.hbase.client.Result;
+import org.apache.hadoop.hbase.client.ResultScanner;
+import org.apache.hadoop.hbase.util.Bytes;
+import org.junit.Test;
+
+/**
+ * Checks the layout of the batches that the backend's HBaseTableScanner decodes,
+ * using an in-memory ResultScanner in place of a region server.
+ */
+@SuppressWarnings("deprecation")
+public class HBaseResultSerializerTest {
+  // Returns a fixed list of results, at most the requested number at a time.
+  private static class ListResultScanner implements ResultScanner {
+    private final Result[] results_;
+    private int pos_ = 0;
+
+    public ListResultScanner(Result... results) { results_ = results; }
+
+    @Override
+    public Result next() throws IOException {
+      return pos_ < results_.length ? results_[pos_++] : null;
+    }
+
+    @Override
+    public Result[] next(int nbRows) throws IOException {
+      int end = Math.min(pos_ + nbRows, results_.length);
+      Result[] batch = Arrays.copyOfRange(results_, pos_, end);
+      pos_ = end;
+      return batch;
+    }
+
+    @Override
+    public void close() { }
+
+    @Override
+    public Iterator<Result> iterator() { return Arrays.asList(results_).iterator(); }
+  }
+
+  private static KeyValue cell(String row, String family, String qualifier,
+      String value) {
+    return new KeyValue(Bytes.toBytes(row), Bytes.toBytes(family),
+        Bytes.toBytes(qualifier), Bytes.toBytes(value));
+  }
+
+  private static void assertBytes(ByteBuffer buffer, String expected) {
+    byte[] actual = new byte[buffer.getInt()];
+    buffer.get(actual);
+    assertArrayEquals(Bytes.toBytes(expected), actual);
+  }
+
+  @Test
+  public void testBatches() throws IOException {
+    ResultScanner scanner = new ListResultScanner(
+        new Result(new KeyValue[] {
+            cell("row1", "d", "a", "1"), cell("row1", "d", "bb", "")}),
+        new Result(new KeyValue[] {cell("row2", "f", "c", "value")}),
+        new Result(new KeyValue[] {cell("row3", "d", "a", "3")}));
+
+    ByteBuffer batch = ByteBuffer.wrap(HBaseResultSerializer.nextBatch(scanner, 2))
+        .order(ByteOrder.LITTLE_ENDIAN);
+    assertEquals(2, batch.getInt());
+    assertBytes(batch, "row1");
+    assertEquals(2, batch.getInt());
+    assertBytes(batch, "d");
+    assertBytes(batch, "a");
+    assertBytes(batch, "1");
+    assertBytes(batch, "d");
+    assertBytes(batch, "bb");
+    assertBytes(batch, "");
+    assertBytes(batch, "row2");
+    assertEquals(1, batch.getInt());
+    assertBytes(batch, "f");
+    assertBytes(batch, "c");
+    assertBytes(batch, "value");
+    assertEquals(0, batch.remaining());
+
+    batch = ByteBuffer.wrap(HBaseResultSerializer.nextBatch(scanner, 2))
+        .order(ByteOrder.LITTLE_ENDIAN);
+    assertEquals(1, batch.getInt());
+    assertBytes(batch, "row3");
+    assertEquals(1, batch.getInt());
+    assertBytes(batch, "d");
+    assertBytes(batch, "a");
+    assertBytes(batch, "3");
+    assertEquals(0, batch.remaining());
+
+    assertNull(HBaseResultSerializer.nextBatch(scanner, 2));
+  }
+}
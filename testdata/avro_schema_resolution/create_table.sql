@@ -27,3 +27,81 @@ LOCATION '${hiveconf:hive.metastore.warehouse.dir}/avro_schema_resolution_test/'
 
 LOAD DATA LOCAL INPATH 'records1.avro' OVERWRITE INTO TABLE schema_resolution_test;
 LOAD DATA LOCAL INPATH 'records2.avro' INTO TABLE schema_resolution_test;
+
+-- Tables with a single file each, whose schema differs from the table schema in ways
+-- that do and don't allow the scanner to use the codegen'd decoding function.
+
+-- Same field layout as the table schema, only docs and defaults differ.
+DROP TABLE IF EXISTS schema_resolution_codegen_test;
+
+CREATE EXTERNAL TABLE schema_resolution_codegen_test (col1 string, col2 string)
+ROW FORMAT SERDE 'org.apache.hadoop.hive.serde2.avro.AvroSerDe'
+WITH SERDEPROPERTIES ('avro.schema.literal'='{
+"name": "a",
+"type": "record",
+"fields": [
+  {"name":"boolean1", "type":"boolean", "default": true},
+  {"name":"int1",     "type":"int",     "default": 1},
+  {"name":"long1",    "type":"long",    "default": 1},
+  {"name":"float1",   "type":"float",   "default": 1.0},
+  {"name":"double1",  "type":"double",  "default": 1.0},
+  {"name":"string1",  "type":"string",  "default": "default string"},
+  {"name":"string2",  "type": ["string", "null"],  "default": ""},
+  {"name":"string3",  "type": ["null", "string"],  "default": null}
+]}')
+STORED AS
+INPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerInputFormat'
+OUTPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerOutputFormat'
+LOCATION '${hiveconf:hive.metastore.warehouse.dir}/avro_schema_resolution_codegen_test/';
+
+LOAD DATA LOCAL INPATH 'records3.avro' OVERWRITE INTO TABLE schema_resolution_codegen_test;
+
+-- Same fields and types as the table schema, in reverse order.
+DROP TABLE IF EXISTS schema_resolution_reordered_test;
+
+CREATE EXTERNAL TABLE schema_resolution_reordered_test (col1 string, col2 string)
+ROW FORMAT SERDE 'org.apache.hadoop.hive.serde2.avro.AvroSerDe'
+WITH SERDEPROPERTIES ('avro.schema.literal'='{
+"name": "a",
+"type": "record",
+"fields": [
+  {"name":"boolean1", "type":"boolean", "default": true},
+  {"name":"int1",     "type":"int",     "default": 1},
+  {"name":"long1",    "type":"long",    "default": 1},
+  {"name":"float1",   "type":"float",   "default": 1.0},
+  {"name":"double1",  "type":"double",  "default": 1.0},
+  {"name":"string1",  "type":"string",  "default": "default string"},
+  {"name":"string2",  "type": ["string", "null"],  "default": ""},
+  {"name":"string3",  "type": ["null", "string"],  "default": null}
+]}')
+STORED AS
+INPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerInputFormat'
+OUTPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerOutputFormat'
+LOCATION '${hiveconf:hive.metastore.warehouse.dir}/avro_schema_resolution_reordered_test/';
+
+LOAD DATA LOCAL INPATH 'records4.avro' OVERWRITE INTO TABLE schema_resolution_reordered_test;
+
+-- Same fields in the same order as the table schema, with promoted types.
+DROP TABLE IF EXISTS schema_resolution_promoted_test;
+
+CREATE EXTERNAL TABLE schema_resolution_promoted_test (col1 string, col2 string)
+ROW FORMAT SERDE 'org.apache.hadoop.hive.serde2.avro.AvroSerDe'
+WITH SERDEPROPERTIES ('avro.schema.literal'='{
+"name": "a",
+"type": "record",
+"fields": [
+  {"name":"boolean1", "type":"boolean", "default": true},
+  {"name":"int1",     "type":"int",     "default": 1},
+  {"name":"long1",    "type":"long",    "default": 1},
+  {"name":"float1",   "type":"float",   "default": 1.0},
+  {"name":"double1",  "type":"double",  "default": 1.0},
+  {"name":"string1",  "type":"string",  "default": "default string"},
+  {"name":"string2",  "type": ["string", "null"],  "default": ""},
+  {"name":"string3",  "type": ["null", "string"],  "default": null}
+]}')
+STORED AS
+INPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerInputFormat'
+OUTPUTFORMAT 'org.apache.hadoop.hive.ql.io.avro.AvroContainerOutputFormat'
+LOCATION '${hiveconf:hive.metastore.warehouse.dir}/avro_schema_resolution_promoted_test/';
+
+LOAD DATA LOCAL INPATH 'records5.avro' OVERWRITE INTO TABLE schema_resolution_promoted_test;
@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Tests for compiling codegen'd functions in the background and skipping codegen for
+# small inputs.
+
+import pytest
+import re
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+# Queries that switch from the interpreted to the jitted scan, aggregation and join
+# code while they run, with their expected results.
+QUERIES = [
+  ("select count(*) from functional.alltypes", ["7300"]),
+  ("select count(*) from functional.alltypes where id % 2 = 0", ["3650"]),
+  ("select count(distinct string_col) from functional.alltypes", ["10"]),
+  ("select count(*) from functional.alltypes a join functional.alltypestiny b "
+   "on a.id = b.id", ["8"]),
+  ("select count(*) from functional_seq_snap.alltypes where bool_col", ["3650"]),
+]
+
+# Queries that run long enough for the background codegen to finish before they are
+# done, with the exec nodes that must have run jitted code.
+LONG_QUERIES = [
+  ("select count(*), sum(l_linenumber), max(l_orderkey) from tpch.lineitem "
+   "where l_discount > 0.05", ["HDFS_SCAN_NODE", "AGGREGATION_NODE"]),
+  ("select count(*), sum(l_linenumber) from tpch.lineitem l join tpch.orders o "
+   "on l.l_orderkey = o.o_orderkey where o.o_orderpriority = '1-URGENT'",
+   ["HDFS_SCAN_NODE", "AGGREGATION_NODE", "HASH_JOIN_NODE"]),
+]
+
+# Many small scan ranges, scanned one at a time, so that the scanners started after the
+# codegen finished use the jitted functions.
+LONG_QUERY_OPTIONS = {"num_scanner_threads": 1, "max_scan_range_length": 1000000}
+
+EXEC_NODE_RE = re.compile(r"^\s*([A-Z_]+_NODE) \(id=\d+\)")
+SCAN_CODEGEN_RE = re.compile(r"Codegen enabled: (\d+) out of \d+")
+CODEGEN_ROW_BATCHES_RE = re.compile(r"CodegenRowBatches: (\d+)")
+
+def get_jitted_nodes(profile):
+  """Returns the types of the exec nodes in 'profile' that ran jitted code"""
+  nodes = set()
+  node = None
+  for line in profile.splitlines():
+    match = EXEC_NODE_RE.match(line)
+    if match:
+      node = match.group(1)
+      continue
+    if node is None: continue
+    match = SCAN_CODEGEN_RE.search(line) or CODEGEN_ROW_BATCHES_RE.search(line)
+    if match and int(match.group(1)) > 0: nodes.add(node)
+  return nodes
+
+class TestAsyncCodegen(CustomClusterTestSuite):
+  """Tests that queries return the same results with --async_codegen and
+  --codegen_min_scan_bytes"""
+
+  def __create_client(self):
+    return self.cluster.get_any_impalad().service.create_beeswax_client()
+
+  def __run_queries(self, client):
+    results = []
+    for query, expected in QUERIES:
+      result = self.execute_query_expect_success(client, query)
+      assert result.data == expected, query
+      results.append(result)
+    return results
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--async_codegen=true")
+  def test_async_codegen(self, vector):
+    client = self.__create_client()
+    self.__run_queries(client)
+    for query, jitted_nodes in LONG_QUERIES:
+      options = dict(LONG_QUERY_OPTIONS)
+      options["disable_codegen"] = "true"
+      expected = self.execute_query_expect_success(client, query, options)
+      options["disable_codegen"] = "false"
+      result = self.execute_query_expect_success(client, query, options)
+      assert result.data == expected.data, query
+      nodes = get_jitted_nodes(result.runtime_profile)
+      for node in jitted_nodes:
+        assert node in nodes, "%s did not run jitted code:\n%s" % (node,
+            result.runtime_profile)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--codegen_min_scan_bytes=1000000000")
+  def test_skip_codegen_small_scans(self, vector):
+    for result in self.__run_queries(self.__create_client()):
+      assert "Codegen: Disabled for small input" in result.runtime_profile, \
+          result.runtime_profile
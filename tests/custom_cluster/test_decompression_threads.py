@@ -0,0 +1,73 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Tests for decompressing blocks of sequence files ahead of the scanner in a pool of
+# decompression threads (--num_decompression_threads).
+
+import pytest
+from tests.beeswax.impala_beeswax import ImpalaBeeswaxClient, ImpalaBeeswaxException
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+DECOMPRESSION_ARGS = "--num_decompression_threads=4"
+
+# Block compressed sequence files, with their expected results.
+QUERIES = [
+  ("select count(*) from functional_seq_snap.alltypes", ["7300"]),
+  ("select count(*), sum(id) from functional_seq_snap.alltypes", ["7300\t26641350"]),
+  ("select count(*) from functional_seq_snap.alltypes where string_col = '1'", ["730"]),
+]
+
+# A file with a corrupt sync marker and corrupt blocks, see DataErrorsTest.
+BAD_FILE_QUERY = "select count(*) from functional_seq_snap.bad_seq_snap"
+
+class TestDecompressionThreads(CustomClusterTestSuite):
+  """Tests that scanning block compressed sequence files with a decompression thread
+  pool returns the same results as decompressing in the scanner"""
+
+  def __create_client(self):
+    service = self.cluster.get_any_impalad().service
+    client = ImpalaBeeswaxClient('%s:%d' % (service.hostname, service.beeswax_port))
+    client.connect()
+    return client
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(DECOMPRESSION_ARGS)
+  def test_decompression_threads(self, vector):
+    client = self.__create_client()
+    for query, expected in QUERIES:
+      result = self.execute_query_expect_success(client, query)
+      assert result.data == expected, query
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(DECOMPRESSION_ARGS)
+  def test_corrupt_blocks(self, vector):
+    client = self.__create_client()
+    handle = client.execute_query_async(BAD_FILE_QUERY)
+    client.wait_for_completion(handle)
+    result = client.fetch_results(BAD_FILE_QUERY, handle)
+    # The block that was read ahead of a corrupt block is not skipped, so the rows are
+    # the same as without decompression threads.
+    assert result.data == ["9434"]
+    log = client.get_log(handle.log_context)
+    client.imp_service.close(handle)
+    assert "Bad synchronization marker" in log
+    assert log.count("Decompressor: invalid compressed length") == 3
+
+    client.set_query_option("abort_on_error", 1)
+    try:
+      client.execute(BAD_FILE_QUERY)
+      assert False, "Query was expected to fail"
+    except ImpalaBeeswaxException, e:
+      assert "Bad synchronization marker" in str(e)
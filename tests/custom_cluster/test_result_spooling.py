@@ -0,0 +1,100 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Tests for spooling query results in the background (--spool_query_results).
+
+import pytest
+from time import sleep, time
+from tests.beeswax.impala_beeswax import ImpalaBeeswaxClient
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+# A tiny spool limit, so that the spool is full after every batch.
+SPOOL_ARGS = "--spool_query_results=true --max_spooled_result_bytes=1"
+
+# Returns 7300 rows, in more batches than fit into the spool.
+ORDERED_QUERY = "select id from functional.alltypes order by id"
+
+# Returns 58400 rows, enough to keep the spool thread blocked on a full spool.
+LARGE_QUERY = ("select a.id from functional.alltypes a "
+               "cross join functional.alltypestiny b")
+
+class TestResultSpooling(CustomClusterTestSuite):
+  """Tests fetching, cancelling and limiting spooled query results"""
+
+  def __create_client(self):
+    self.impalad = self.cluster.get_any_impalad()
+    service = self.impalad.service
+    client = ImpalaBeeswaxClient('%s:%d' % (service.hostname, service.beeswax_port))
+    client.connect()
+    return client
+
+  def __fetch(self, client, handle, num_rows):
+    return client.imp_service.fetch(handle, False, num_rows)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(SPOOL_ARGS)
+  def test_fetch_across_spool_boundaries(self, vector):
+    client = self.__create_client()
+    # Fetch sizes that don't line up with the batches in the spool.
+    for fetch_size in [1, 7, 1000, 5000, -1]:
+      handle = client.execute_query_async(ORDERED_QUERY)
+      client.wait_for_completion(handle)
+      rows = []
+      while True:
+        result = self.__fetch(client, handle, fetch_size)
+        if fetch_size > 0: assert len(result.data) <= fetch_size
+        rows.extend(result.data)
+        if not result.has_more: break
+      client.imp_service.close(handle)
+      assert rows == [str(i) for i in xrange(7300)], "fetch size %d" % fetch_size
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(SPOOL_ARGS)
+  def test_cancel_while_spooling(self, vector):
+    client = self.__create_client()
+    handle = client.execute_query_async(LARGE_QUERY)
+    client.wait_for_completion(handle)
+    result = self.__fetch(client, handle, 10)
+    assert len(result.data) == 10 and result.has_more
+    # The spool thread is blocked on the full spool; cancelling must unblock it.
+    start = time()
+    client.cancel_query(handle)
+    assert time() - start < 10
+    assert client.get_state(handle) == client.query_states['EXCEPTION']
+    client.imp_service.close(handle)
+    self.impalad.service.wait_for_metric_value(
+        'impala-server.num-fragments-in-flight', 0)
+    # The server is still able to run queries.
+    result = client.execute("select count(*) from functional.alltypes")
+    assert result.data == ['7300']
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(SPOOL_ARGS)
+  def test_spool_memory_limit(self, vector):
+    client = self.__create_client()
+    handle = client.execute_query_async(LARGE_QUERY)
+    client.wait_for_completion(handle)
+    num_rows = len(self.__fetch(client, handle, 10).data)
+    # The spool is full, so the spool thread waits until the client fetches more.
+    sleep(1)
+    profile = client.get_runtime_profile(handle)
+    assert 'ResultSpoolFullTimer' in profile
+    assert 'ResultSpoolFullTimer: 0ns' not in profile
+    while True:
+      result = self.__fetch(client, handle, 10000)
+      num_rows += len(result.data)
+      if not result.has_more: break
+    client.imp_service.close(handle)
+    assert num_rows == 58400
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Tests for writing the partitions of dynamic partition INSERTs in a pool of table
+# writer threads (--num_table_writer_threads), with a limit on the number of open
+# partition files (--max_open_insert_partition_files).
+
+import pytest
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+# Every row batch of functional.alltypes has rows for all 10 partitions of tinyint_col,
+# so the sinks keep closing the least recently used files and start new ones.
+TABLE_WRITER_ARGS = ("--num_table_writer_threads=4 "
+                     "--max_open_insert_partition_files=3")
+
+FILE_FORMATS = ["textfile", "parquetfile"]
+
+COLUMNS = "id, bool_col, smallint_col, int_col, bigint_col, double_col, string_col"
+
+# Per-partition checksums over all columns, so that any row that is lost, duplicated,
+# corrupted or written to the wrong partition changes the result. Doubles are not summed,
+# since the result would depend on the order of the rows.
+PARTITION_CHECK_QUERY = ("select %s, count(*), sum(id), sum(cast(bool_col as int)), "
+                         "sum(smallint_col), sum(int_col), sum(bigint_col), "
+                         "min(double_col), max(double_col), count(distinct string_col), "
+                         "min(id), max(id) from %s group by 1 order by 1")
+
+class TestTableWriterThreads(CustomClusterTestSuite):
+  """Tests that dynamic partition INSERTs write the same rows to every partition when
+  the partitions are written by a pool of threads"""
+
+  def __create_client(self):
+    return self.cluster.get_any_impalad().service.create_beeswax_client()
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(TABLE_WRITER_ARGS)
+  def test_table_writer_threads(self, vector):
+    client = self.__create_client()
+    for file_format in FILE_FORMATS:
+      table = "default.table_writer_threads_" + file_format
+      self.execute_query_expect_success(client, "drop table if exists " + table)
+      self.execute_query_expect_success(client,
+          "create table %s (id int, bool_col boolean, smallint_col smallint, "
+          "int_col int, bigint_col bigint, double_col double, string_col string) "
+          "partitioned by (p tinyint) stored as %s" % (table, file_format))
+      try:
+        insert = ("insert %s table %s partition(p) select %s, tinyint_col "
+                  "from functional.alltypes")
+        self.execute_query_expect_success(client,
+            insert % ("overwrite", table, COLUMNS))
+        # Appending to the existing partitions must work as well.
+        self.execute_query_expect_success(client, insert % ("into", table, COLUMNS))
+
+        result = self.execute_query_expect_success(client,
+            "select count(*) from " + table)
+        assert result.data == ["14600"], file_format
+
+        expected = self.execute_query_expect_success(client,
+            PARTITION_CHECK_QUERY % ("tinyint_col",
+                "(select * from functional.alltypes union all "
+                "select * from functional.alltypes) t"))
+        result = self.execute_query_expect_success(client,
+            PARTITION_CHECK_QUERY % ("p", table))
+        assert len(result.data) == 10, file_format
+        assert result.data == expected.data, file_format
+      finally:
+        self.execute_query_expect_success(client, "drop table if exists " + table)
@@ -2,9 +2,25 @@
 # Copyright (c) 2012 Cloudera, Inc. All rights reserved.
 
 import pytest
+import re
 from tests.common.test_vector import *
 from tests.common.impala_test_suite import *
 
+# Tables with a single file whose schema differs from the table schema (see
+# testdata/avro_schema_resolution), whether the file can be decoded with the codegen'd
+# function, and the expected rows.
+CODEGEN_TABLES = [
+  ("schema_resolution_codegen_test", True,
+   ["true\t3\t30\t3.5\t30.5\trecord3 a\ts2\tNULL",
+    "false\t4\t40\t4.5\t40.5\trecord3 b\tNULL\ts3"]),
+  ("schema_resolution_reordered_test", False,
+   ["true\t5\t50\t5.5\t50.5\trecord4 a\ts2\ts3",
+    "false\t6\t60\t6.5\t60.5\trecord4 b\tNULL\tNULL"]),
+  ("schema_resolution_promoted_test", False,
+   ["true\t7\t70\t7\t70.5\trecord5 a\ts2\tNULL",
+    "false\t8\t80\t8\t80.5\trecord5 b\tNULL\ts3"]),
+]
+
 # This test requires that testdata/avro_schema_resolution/create_table.sql has been run
 class TestAvroSchemaResolution(ImpalaTestSuite):
   @classmethod
@@ -21,3 +37,20 @@ class TestAvroSchemaResolution(ImpalaTestSuite):
 
   def test_avro_schema_resolution(self, vector):
     self.run_test_case('QueryTest/avro-schema-resolution', vector)
+
+  def test_avro_codegen_schema_layouts(self, vector):
+    """Files whose schema only differs from the table schema in docs or defaults are
+    decoded with the codegen'd function, files with reordered or promoted fields with
+    the interpreted one"""
+    if vector.get_value('exec_option')['disable_codegen']:
+      pytest.skip()
+    for table, use_codegen, expected in CODEGEN_TABLES:
+      result = self.execute_query("select * from functional_avro_snap.%s order by int1"
+          % table, vector.get_value('exec_option'))
+      assert result.data == expected, table
+      # Each scan node reports "Codegen enabled: <num scanners> out of <num scanners>".
+      counts = re.findall(r'Codegen enabled: (\d+) out of (\d+)', result.runtime_profile)
+      num_enabled = sum(int(enabled) for enabled, total in counts)
+      num_scanners = sum(int(total) for enabled, total in counts)
+      assert num_scanners > 0, table
+      assert num_enabled == (num_scanners if use_codegen else 0), table
@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+# Copyright (c) 2014 Cloudera, Inc. All rights reserved.
+# Tests writing gzip compressed text tables with inserts and scanning them back
+#
+import pytest
+from tests.common.test_vector import *
+from tests.common.impala_test_suite import *
+from tests.common.test_dimensions import create_exec_option_dimension
+
+TEST_DB = 'block_gzip_test_db'
+
+# Columns of functional.alltypes that are in alltypesnopart.
+COLUMNS = ("id, bool_col, tinyint_col, smallint_col, int_col, bigint_col, float_col, "
+           "double_col, date_string_col, string_col, timestamp_col")
+
+# Aggregates over all columns, so that any row that is lost, duplicated or corrupted
+# changes the result.
+CHECK_QUERY = ("select count(*), sum(id), sum(tinyint_col), sum(bigint_col), "
+               "sum(double_col), count(distinct date_string_col), "
+               "count(distinct string_col), max(timestamp_col) from %s")
+
+# Small enough to split the files into several scan ranges, so that scan ranges start
+# in the middle of gzip members.
+MAX_SCAN_RANGE_LENGTHS = [0, 10000]
+
+class TestBlockGzip(ImpalaTestSuite):
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestBlockGzip, cls).add_test_dimensions()
+    cls.TestMatrix.add_dimension(create_exec_option_dimension(
+        cluster_sizes=[0], disable_codegen_options=[False], batch_sizes=[0],
+        sync_ddl=[1]))
+    cls.TestMatrix.add_constraint(lambda v:\
+        v.get_value('table_format').file_format == 'text' and\
+        v.get_value('table_format').compression_codec == 'none')
+
+  def setup_method(self, method):
+    self.cleanup_db(TEST_DB)
+    self.client.execute("create database " + TEST_DB)
+
+  def teardown_method(self, method):
+    self.cleanup_db(TEST_DB)
+
+  @pytest.mark.execute_serially
+  def test_insert_and_scan(self, vector):
+    table = TEST_DB + '.alltypes_gzip'
+    self.client.execute("create table %s like functional.alltypesnopart "
+                        "stored as textfile" % table)
+    self.execute_query("insert overwrite table %s select %s from functional.alltypes"
+                       % (table, COLUMNS), {'text_compression_codec': 'gzip'})
+    # Appending another file with a second insert must work as well.
+    self.execute_query("insert into table %s select %s from functional.alltypes"
+                       % (table, COLUMNS), {'text_compression_codec': 'gzip'})
+
+    expected = self.execute_query(CHECK_QUERY %
+        ("(select * from functional.alltypes union all "
+         "select * from functional.alltypes) t"))
+    for max_scan_range_length in MAX_SCAN_RANGE_LENGTHS:
+      result = self.execute_query(CHECK_QUERY % table,
+          {'max_scan_range_length': max_scan_range_length})
+      assert result.data == expected.data, max_scan_range_length
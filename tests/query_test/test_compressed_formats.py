@@ -50,11 +50,13 @@ class TestCompressedFormats(ImpalaTestSuite):
 
     elif file_format is 'text':
       # Test that that compressed text files (or at least text files with a
-      # compressed extension) fail.
+      # compressed extension) fail. Gzip text files are supported if they are block
+      # gzip compressed, which the renamed uncompressed file is not.
       db_suffix = ""
+      expected_error = 'Compressed text files are not supported'
+      if extension == '.gz': expected_error = 'not in the block gzip (BGZF) format'
       self.__copy_and_query_compressed_file(
-        'tinytable', db_suffix, suffix, 'data.csv', extension,
-        'Compressed text files are not supported')
+        'tinytable', db_suffix, suffix, 'data.csv', extension, expected_error)
 
     else:
       assert False, "Unknown file_format: %s" % file_format
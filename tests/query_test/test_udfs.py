@@ -28,14 +28,39 @@ class TestUdfs(ImpalaTestSuite):
     self.__load_functions(
       self.create_udas_template, vector, database, '/test-warehouse/libudasample.so')
 
+    self.__load_functions(
+      self.create_batch_udfs_template, vector, database,
+      '/test-warehouse/libTestUdfs.so')
+
     self.run_test_case('QueryTest/udf', vector, use_db=database)
+    self.run_test_case('QueryTest/udf-batch', vector, use_db=database)
     self.run_test_case('QueryTest/uda', vector, use_db=database)
 
+  def test_native_uda_batch_update(self, vector):
+    """Tests that aggregations with a batch update UDA call it even though the
+    aggregation could otherwise be codegen'd"""
+    database = 'native_function_test'
+    self.__load_functions(
+      self.create_udas_template, vector, database, '/test-warehouse/libudasample.so')
+    result = self.execute_query_expect_success(self.client,
+        'select %s.test_count_batch(int_col) from functional.alltypesagg' % database,
+        vector.get_value('exec_option'))
+    assert result.data == ['9990']
+    # The codegen'd ProcessRowBatch() would bypass the batch update function.
+    exec_options = [line for line in result.runtime_profile.splitlines()
+                    if 'Batch Update Enabled' in line]
+    assert len(exec_options) > 0, result.runtime_profile
+    for line in exec_options:
+      assert 'Codegen Enabled' not in line, result.runtime_profile
+
   def test_ir_functions(self, vector):
     database = 'ir_function_test'
     self.__load_functions(
       self.create_udfs_template, vector, database, '/test-warehouse/test-udfs.ll')
+    self.__load_functions(
+      self.create_ir_udas_template, vector, database, '/test-warehouse/uda-sample.ll')
     self.run_test_case('QueryTest/udf', vector, use_db=database)
+    self.run_test_case('QueryTest/ir-uda', vector, use_db=database)
 
   def test_hive_udfs(self, vector):
     self.client.execute('create database if not exists udf_test')
@@ -61,14 +86,39 @@ class TestUdfs(ImpalaTestSuite):
   create_udas_template = """
 drop function if exists {database}.test_count(int);
 drop function if exists {database}.hll(int);
+drop function if exists {database}.test_count_batch(int);
 
 create database if not exists {database};
 
 create aggregate function {database}.test_count(int) returns bigint
 location '{location}' update_fn='CountUpdate';
 
+create aggregate function {database}.test_count_batch(int) returns bigint
+location '{location}' update_fn='CountUpdate' update_batch_fn='CountUpdateBatch';
+
 create aggregate function {database}.hll(int) returns string
 location '{location}' update_fn='HllUpdate';
+"""
+
+  # Create test UDA functions in {database} from IR module {location}
+  create_ir_udas_template = """
+drop function if exists {database}.test_count(int);
+
+create database if not exists {database};
+
+create aggregate function {database}.test_count(int) returns bigint
+location '{location}' update_fn='CountUpdate';
+"""
+
+  # Create test UDF functions with batch versions in {database} from library {location}.
+  # IR modules don't support batch versions.
+  create_batch_udfs_template = """
+drop function if exists {database}.add_ints_batch(int, int);
+
+create database if not exists {database};
+
+create function {database}.add_ints_batch(int, int) returns int
+location '{location}' symbol='AddInts' batch_symbol='AddIntsBatch';
 """
 
   # Create test UDF functions in {database} from library {location}
@@ -91,6 +141,7 @@ drop function if exists {database}.var_sum(double...);
 drop function if exists {database}.var_sum(string...);
 drop function if exists {database}.var_sum_multiply(double, int...);
 drop function if exists {database}.constant_timestamp();
+drop function if exists {database}.add_ints(int, int);
 
 create database if not exists {database};
 
@@ -150,4 +201,7 @@ symbol='_Z14VarSumMultiplyPN10impala_udf15FunctionContextERKNS_9DoubleValEiPKNS_
 
 create function {database}.constant_timestamp() returns timestamp
 location '{location}' symbol='ConstantTimestamp';
+
+create function {database}.add_ints(int, int) returns int
+location '{location}' symbol='AddInts';
 """